@@ -43,6 +43,11 @@ struct bgp_advertise {
 
 	/* BGP info.  */
 	struct bgp_path_info *pathi;
+
+	/* Encoded into a packet that hasn't been queued yet, see
+	 * subgroup_build_apply().
+	 */
+	bool encoded;
 };
 
 DECLARE_DLIST(bgp_adv_fifo, struct bgp_advertise, fifo);
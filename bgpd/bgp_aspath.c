@@ -70,8 +70,11 @@ struct assegment_header {
 	uint8_t length;
 };
 
-/* Hash for aspath.  This is the top level structure of AS path. */
-static struct hash *ashash;
+/* Hash for aspath.  This is the top level structure of AS path.  AS paths
+ * are interned in a table that is safe to use from any pthread, so UPDATEs
+ * can be parsed on worker pthreads, cf. lib/intern.h and bgp_update_parse.c
+ */
+static struct intern_table aspath_table;
 
 /* Stream for SNMP. See aspath_snmp_pathseg */
 static struct stream *snmp_stream;
@@ -316,24 +319,24 @@ void aspath_free(struct aspath *aspath)
 /* Unintern aspath from AS path bucket. */
 void aspath_unintern(struct aspath **aspath)
 {
-	struct aspath *ret;
-	struct aspath *asp;
-
 	if (!*aspath)
 		return;
 
-	asp = *aspath;
+	/* The last reference frees it after an RCU grace period, since parse
+	 * workers may be looking at it.
+	 */
+	if (intern_put(&aspath_table, *aspath))
+		*aspath = NULL;
+}
 
-	if (asp->refcnt)
-		asp->refcnt--;
+void aspath_ref(struct aspath *aspath)
+{
+	intern_ref(&aspath_table, aspath);
+}
 
-	if (asp->refcnt == 0) {
-		/* This aspath must exist in aspath hash table. */
-		ret = hash_release(ashash, asp);
-		assert(ret != NULL);
-		aspath_free(asp);
-		*aspath = NULL;
-	}
+unsigned long aspath_refcnt(const struct aspath *aspath)
+{
+	return intern_refcnt(&aspath_table, aspath);
 }
 
 /* Return the start or end delimiters for a particular Segment type */
@@ -665,16 +668,18 @@ struct aspath *aspath_intern(struct aspath *aspath)
 
 	/* Assert this AS path structure is not interned and has the string
 	   representation built. */
-	assert(aspath->refcnt == 0);
+	assert(aspath_refcnt(aspath) == 0);
 	assert(aspath->str);
 
-	/* Check AS path hash. */
-	find = hash_get(ashash, aspath, hash_alloc_intern);
-	if (find != aspath)
+	/* Check AS path hash.  A new entry takes over the segments and
+	 * string, leaving only the structure itself to free.
+	 */
+	find = intern_get(&aspath_table, aspath);
+	if (find->str == aspath->str)
+		XFREE(MTYPE_AS_PATH, aspath);
+	else
 		aspath_free(aspath);
 
-	find->refcnt++;
-
 	return find;
 }
 
@@ -707,7 +712,7 @@ struct aspath *aspath_dup(struct aspath *aspath)
 	return new;
 }
 
-static void *aspath_hash_alloc(void *arg)
+static void *aspath_hash_alloc(const void *arg)
 {
 	const struct aspath *aspath = arg;
 	struct aspath *new;
@@ -716,10 +721,9 @@ static void *aspath_hash_alloc(void *arg)
 	assert(aspath->str);
 
 	/* New aspath structure is needed. */
-	new = XMALLOC(MTYPE_AS_PATH, sizeof(struct aspath));
+	new = XCALLOC(MTYPE_AS_PATH, sizeof(struct aspath));
 
 	/* Reuse segments and string representation */
-	new->refcnt = 0;
 	new->segments = aspath->segments;
 	new->str = aspath->str;
 	new->str_len = aspath->str_len;
@@ -853,10 +857,10 @@ struct aspath *aspath_parse(struct stream *s, size_t length, int use32bit,
 		return NULL;
 
 	/* If already same aspath exist then return it. */
-	find = hash_get(ashash, &as, aspath_hash_alloc);
+	find = intern_get(&aspath_table, &as);
 
 	/* if the aspath was already hashed free temporary memory. */
-	if (find->refcnt) {
+	if (find->str != as.str) {
 		assegment_free_all(as.segments);
 		/* aspath_key_make() always updates the string */
 		XFREE(MTYPE_AS_STR, as.str);
@@ -866,8 +870,6 @@ struct aspath *aspath_parse(struct stream *s, size_t length, int use32bit,
 		}
 	}
 
-	find->refcnt++;
-
 	return find;
 }
 
@@ -1905,7 +1907,7 @@ struct aspath *aspath_empty_get(void)
 
 unsigned long aspath_count(void)
 {
-	return ashash->count;
+	return intern_count(&aspath_table);
 }
 
 /*
@@ -2051,6 +2053,10 @@ unsigned int aspath_key_make(const void *p)
 	const struct aspath *aspath = p;
 	unsigned int key = 0;
 
+	/* interned paths carry their hash value */
+	if (aspath_refcnt(aspath))
+		return intern_hashval(&aspath_table, aspath);
+
 	if (!aspath->str)
 		aspath_str_update((struct aspath *)aspath, false);
 
@@ -2086,18 +2092,28 @@ bool aspath_cmp(const void *arg1, const void *arg2)
 	return true;
 }
 
+static void aspath_hash_free(void *arg)
+{
+	aspath_free(arg);
+}
+
+static const struct intern_ops aspath_intern_ops = {
+	.offset = offsetof(struct aspath, item),
+	.hash_key = aspath_key_make,
+	.hash_cmp = aspath_cmp,
+	.alloc = aspath_hash_alloc,
+	.free = aspath_hash_free,
+};
+
 /* AS path hash initialize. */
 void aspath_init(void)
 {
-	ashash = hash_create_size(32768, aspath_key_make, aspath_cmp,
-				  "BGP AS Path");
+	intern_table_init(&aspath_table, "BGP AS Path", &aspath_intern_ops);
 }
 
 void aspath_finish(void)
 {
-	hash_clean(ashash, (void (*)(void *))aspath_free);
-	hash_free(ashash);
-	ashash = NULL;
+	intern_table_fini(&aspath_table);
 
 	if (snmp_stream)
 		stream_free(snmp_stream);
@@ -2118,14 +2134,13 @@ void aspath_print_vty(struct vty *vty, struct aspath *as)
 	vty_out(vty, "%s%s", as->str, as->str_len ? " " : "");
 }
 
-static void aspath_show_all_iterator(struct hash_bucket *bucket,
-				     struct vty *vty)
+static void aspath_show_all_iterator(void *data, void *arg)
 {
-	struct aspath *as;
-
-	as = (struct aspath *)bucket->data;
+	struct aspath *as = data;
+	struct vty *vty = arg;
 
-	vty_out(vty, "[%p:%u] (%ld) ", (void *)bucket, bucket->key, as->refcnt);
+	vty_out(vty, "[%p:%u] (%lu) ", data,
+		intern_hashval(&aspath_table, as), aspath_refcnt(as));
 	vty_out(vty, "%s\n", as->str);
 }
 
@@ -2133,9 +2148,7 @@ static void aspath_show_all_iterator(struct hash_bucket *bucket,
    `show [ip] bgp paths' command. */
 void aspath_print_all_vty(struct vty *vty)
 {
-	hash_iterate(ashash, (void (*)(struct hash_bucket *,
-				       void *))aspath_show_all_iterator,
-		     vty);
+	intern_walk(&aspath_table, aspath_show_all_iterator, vty);
 }
 
 static struct aspath *bgp_aggr_aspath_lookup(struct bgp_aggregate *aggregate,
@@ -2205,7 +2218,7 @@ void bgp_compute_aggregate_aspath_hash(struct bgp_aggregate *aggregate,
 
 	/* Increment reference counter.
 	 */
-	aggr_aspath->refcnt++;
+	aggr_aspath->aggr_refcnt++;
 }
 
 void bgp_compute_aggregate_aspath_val(struct bgp_aggregate *aggregate)
@@ -2241,9 +2254,9 @@ void bgp_remove_aspath_from_aggregate(struct bgp_aggregate *aggregate,
 	 */
 	aggr_aspath = bgp_aggr_aspath_lookup(aggregate, aspath);
 	if (aggr_aspath) {
-		aggr_aspath->refcnt--;
+		aggr_aspath->aggr_refcnt--;
 
-		if (aggr_aspath->refcnt == 0) {
+		if (aggr_aspath->aggr_refcnt == 0) {
 			ret_aspath = hash_release(aggregate->aspath_hash,
 						  aggr_aspath);
 			aspath_free(ret_aspath);
@@ -2274,9 +2287,9 @@ void bgp_remove_aspath_from_aggregate_hash(struct bgp_aggregate *aggregate,
 	 */
 	aggr_aspath = bgp_aggr_aspath_lookup(aggregate, aspath);
 	if (aggr_aspath) {
-		aggr_aspath->refcnt--;
+		aggr_aspath->aggr_refcnt--;
 
-		if (aggr_aspath->refcnt == 0) {
+		if (aggr_aspath->aggr_refcnt == 0) {
 			ret_aspath = hash_release(aggregate->aspath_hash,
 						  aggr_aspath);
 			aspath_free(ret_aspath);
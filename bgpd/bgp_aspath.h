@@ -7,6 +7,7 @@
 #define _QUAGGA_BGP_ASPATH_H
 
 #include "lib/json.h"
+#include "lib/intern.h"
 #include "bgpd/bgp_route.h"
 
 /* AS path segment type.  */
@@ -44,8 +45,13 @@ struct assegment {
 
 /* AS path may be include some AsSegments.  */
 struct aspath {
-	/* Reference count to this aspath.  */
-	unsigned long refcnt;
+	/* refcount & linkage in the concurrent intern table */
+	struct intern_item item;
+
+	/* Number of aggregated routes with this AS path, only used by the
+	 * copies kept in an aggregate's aspath_hash.
+	 */
+	unsigned long aggr_refcnt;
 
 	/* segment data */
 	struct assegment *segments;
@@ -72,6 +78,8 @@ extern struct aspath *aspath_parse(struct stream *s, size_t length,
 				   enum asnotation_mode asnotation);
 
 extern struct aspath *aspath_dup(struct aspath *aspath);
+/* number of references to an interned AS path, 0 if it isn't interned */
+extern unsigned long aspath_refcnt(const struct aspath *aspath);
 extern struct aspath *aspath_aggregate(struct aspath *as1, struct aspath *as2);
 extern struct aspath *aspath_prepend(struct aspath *as1, struct aspath *as2);
 extern struct aspath *aspath_filter_exclude(struct aspath *source,
@@ -94,6 +102,8 @@ extern void aspath_str_update(struct aspath *as, bool make_json);
 extern void aspath_free(struct aspath *aspath);
 extern struct aspath *aspath_intern(struct aspath *aspath);
 extern void aspath_unintern(struct aspath **aspath);
+/* takes another reference on an interned AS path */
+extern void aspath_ref(struct aspath *aspath);
 extern const char *aspath_print(struct aspath *aspath);
 extern void aspath_print_vty(struct vty *vty, struct aspath *aspath);
 extern void aspath_print_all_vty(struct vty *vty);
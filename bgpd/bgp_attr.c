@@ -33,6 +33,7 @@
 #include "bgpd/bgp_lcommunity.h"
 #include "bgpd/bgp_updgrp.h"
 #include "bgpd/bgp_encap_types.h"
+#include "bgpd/bgp_update_parse.h"
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/bgp_rfapi_cfg.h"
 #include "bgp_encap_types.h"
@@ -80,14 +81,17 @@ static const struct message attr_flag_str[] = {
 	{BGP_ATTR_FLAG_EXTLEN, "Extended Length"},
 	{0}};
 
-static struct hash *cluster_hash;
+/* cluster lists are interned in a table that is safe to use from any
+ * pthread, cf. lib/intern.h
+ */
+static struct intern_table cluster_table;
 
-static void *cluster_hash_alloc(void *p)
+static void *cluster_hash_alloc(const void *p)
 {
 	const struct cluster_list *val = (const struct cluster_list *)p;
 	struct cluster_list *cluster;
 
-	cluster = XMALLOC(MTYPE_CLUSTER, sizeof(struct cluster_list));
+	cluster = XCALLOC(MTYPE_CLUSTER, sizeof(struct cluster_list));
 	cluster->length = val->length;
 
 	if (cluster->length) {
@@ -96,8 +100,6 @@ static void *cluster_hash_alloc(void *p)
 	} else
 		cluster->list = NULL;
 
-	cluster->refcnt = 0;
-
 	return cluster;
 }
 
@@ -105,14 +107,11 @@ static void *cluster_hash_alloc(void *p)
 static struct cluster_list *cluster_parse(struct in_addr *pnt, int length)
 {
 	struct cluster_list tmp = {};
-	struct cluster_list *cluster;
 
 	tmp.length = length;
 	tmp.list = length == 0 ? NULL : pnt;
 
-	cluster = hash_get(cluster_hash, &tmp, cluster_hash_alloc);
-	cluster->refcnt++;
-	return cluster;
+	return intern_get(&cluster_table, &tmp);
 }
 
 bool cluster_loop_check(struct cluster_list *cluster, struct in_addr originator)
@@ -132,6 +131,14 @@ static unsigned int cluster_hash_key_make(const void *p)
 	return jhash(cluster->list, cluster->length, 0);
 }
 
+/* interned lists carry their hash value, no need to run jhash again */
+static unsigned int cluster_hash_key(const struct cluster_list *cluster)
+{
+	if (intern_refcnt(&cluster_table, cluster))
+		return intern_hashval(&cluster_table, cluster);
+	return cluster_hash_key_make(cluster);
+}
+
 static bool cluster_hash_cmp(const void *p1, const void *p2)
 {
 	const struct cluster_list *cluster1 = p1;
@@ -149,46 +156,46 @@ static bool cluster_hash_cmp(const void *p1, const void *p2)
 	return (memcmp(cluster1->list, cluster2->list, cluster1->length) == 0);
 }
 
-static void cluster_free(struct cluster_list *cluster)
+static void cluster_free(void *p)
 {
+	struct cluster_list *cluster = p;
+
 	XFREE(MTYPE_CLUSTER_VAL, cluster->list);
 	XFREE(MTYPE_CLUSTER, cluster);
 }
 
 static struct cluster_list *cluster_intern(struct cluster_list *cluster)
 {
-	struct cluster_list *find;
-
-	find = hash_get(cluster_hash, cluster, cluster_hash_alloc);
-	find->refcnt++;
-
-	return find;
+	return intern_get(&cluster_table, cluster);
 }
 
 static void cluster_unintern(struct cluster_list **cluster)
 {
-	if ((*cluster)->refcnt)
-		(*cluster)->refcnt--;
-
-	if ((*cluster)->refcnt == 0) {
-		void *p = hash_release(cluster_hash, *cluster);
-		assert(p == *cluster);
-		cluster_free(*cluster);
+	if (intern_put(&cluster_table, *cluster))
 		*cluster = NULL;
-	}
 }
 
+unsigned long cluster_refcnt(const struct cluster_list *cluster)
+{
+	return intern_refcnt(&cluster_table, cluster);
+}
+
+static const struct intern_ops cluster_intern_ops = {
+	.offset = offsetof(struct cluster_list, item),
+	.hash_key = cluster_hash_key_make,
+	.hash_cmp = cluster_hash_cmp,
+	.alloc = cluster_hash_alloc,
+	.free = cluster_free,
+};
+
 static void cluster_init(void)
 {
-	cluster_hash = hash_create(cluster_hash_key_make, cluster_hash_cmp,
-				   "BGP Cluster");
+	intern_table_init(&cluster_table, "BGP Cluster", &cluster_intern_ops);
 }
 
 static void cluster_finish(void)
 {
-	hash_clean(cluster_hash, (void (*)(void *))cluster_free);
-	hash_free(cluster_hash);
-	cluster_hash = NULL;
+	intern_table_fini(&cluster_table);
 }
 
 static struct hash *encap_hash = NULL;
@@ -769,7 +776,7 @@ unsigned int attrhash_key_make(const void *p)
 	if (bgp_attr_get_ipv6_ecommunity(attr))
 		MIX(ecommunity_hash_make(bgp_attr_get_ipv6_ecommunity(attr)));
 	if (bgp_attr_get_cluster(attr))
-		MIX(cluster_hash_key_make(bgp_attr_get_cluster(attr)));
+		MIX(cluster_hash_key(bgp_attr_get_cluster(attr)));
 	if (bgp_attr_get_transit(attr))
 		MIX(transit_hash_key_make(bgp_attr_get_transit(attr)));
 	if (attr->encap_subtlvs)
@@ -945,10 +952,10 @@ struct attr *bgp_attr_intern(struct attr *attr)
 
 	/* Intern referenced structure. */
 	if (attr->aspath) {
-		if (!attr->aspath->refcnt)
+		if (!aspath_refcnt(attr->aspath))
 			attr->aspath = aspath_intern(attr->aspath);
 		else
-			attr->aspath->refcnt++;
+			aspath_ref(attr->aspath);
 	}
 
 	comm = bgp_attr_get_community(attr);
@@ -987,10 +994,10 @@ struct attr *bgp_attr_intern(struct attr *attr)
 	struct cluster_list *cluster = bgp_attr_get_cluster(attr);
 
 	if (cluster) {
-		if (!cluster->refcnt)
+		if (!intern_refcnt(&cluster_table, cluster))
 			bgp_attr_set_cluster(attr, cluster_intern(cluster));
 		else
-			cluster->refcnt++;
+			intern_ref(&cluster_table, cluster);
 	}
 
 	struct transit *transit = bgp_attr_get_transit(attr);
@@ -1270,7 +1277,7 @@ void bgp_attr_flush(struct attr *attr)
 	struct lcommunity *lcomm;
 	struct community *comm;
 
-	if (attr->aspath && !attr->aspath->refcnt) {
+	if (attr->aspath && !aspath_refcnt(attr->aspath)) {
 		aspath_free(attr->aspath);
 		attr->aspath = NULL;
 	}
@@ -1295,7 +1302,7 @@ void bgp_attr_flush(struct attr *attr)
 	bgp_attr_set_lcommunity(attr, NULL);
 
 	cluster = bgp_attr_get_cluster(attr);
-	if (cluster && !cluster->refcnt) {
+	if (cluster && !intern_refcnt(&cluster_table, cluster)) {
 		cluster_free(cluster);
 		bgp_attr_set_cluster(attr, NULL);
 	}
@@ -1591,6 +1598,7 @@ static int bgp_attr_aspath(struct bgp_attr_parser_args *args)
 	struct peer *const peer = args->peer;
 	const bgp_size_t length = args->length;
 	enum asnotation_mode asnotation;
+	int use32bit;
 
 	asnotation = bgp_get_asnotation(
 		args->peer && args->peer->bgp ? args->peer->bgp : NULL);
@@ -1598,11 +1606,15 @@ static int bgp_attr_aspath(struct bgp_attr_parser_args *args)
 	 * peer with AS4 => will get 4Byte ASnums
 	 * otherwise, will get 16 Bit
 	 */
-	attr->aspath =
-		aspath_parse(peer->curr, length,
-			     CHECK_FLAG(peer->cap, PEER_CAP_AS4_RCV) &&
-				     CHECK_FLAG(peer->cap, PEER_CAP_AS4_ADV),
-			     asnotation);
+	use32bit = CHECK_FLAG(peer->cap, PEER_CAP_AS4_RCV) &&
+		   CHECK_FLAG(peer->cap, PEER_CAP_AS4_ADV);
+
+	/* a parse worker may have got to it already */
+	attr->aspath = bgp_update_parsed_aspath(peer, BGP_ATTR_AS_PATH, length,
+						use32bit, asnotation);
+	if (!attr->aspath)
+		attr->aspath = aspath_parse(peer->curr, length, use32bit,
+					    asnotation);
 
 	/* In case of IBGP, length will be zero. */
 	if (!attr->aspath) {
@@ -1707,7 +1719,10 @@ static int bgp_attr_as4_path(struct bgp_attr_parser_args *args,
 
 	asnotation = bgp_get_asnotation(peer->bgp);
 
-	*as4_path = aspath_parse(peer->curr, length, 1, asnotation);
+	*as4_path = bgp_update_parsed_aspath(peer, BGP_ATTR_AS4_PATH, length, 1,
+					     asnotation);
+	if (!*as4_path)
+		*as4_path = aspath_parse(peer->curr, length, 1, asnotation);
 
 	/* In case of IBGP, length will be zero. */
 	if (!*as4_path) {
@@ -10,6 +10,7 @@
 #include "bgp_attr_evpn.h"
 #include "bgpd/bgp_encap_types.h"
 #include "srte.h"
+#include "intern.h"
 
 /* Simple bit mapping. */
 #define BITMAP_NBBY 8
@@ -334,7 +335,9 @@ struct attr {
 
 /* Router Reflector related structure. */
 struct cluster_list {
-	unsigned long refcnt;
+	/* refcount & linkage in the concurrent intern table */
+	struct intern_item item;
+
 	int length;
 	struct in_addr *list;
 };
@@ -409,6 +412,8 @@ extern enum bgp_attr_parse_ret bgp_attr_ignore(struct peer *peer, uint8_t type);
 /* Cluster list prototypes. */
 extern bool cluster_loop_check(struct cluster_list *cluster,
 			       struct in_addr originator);
+/* 0 if the cluster list isn't interned */
+extern unsigned long cluster_refcnt(const struct cluster_list *cluster);
 
 /* Below exported for unit-test purposes only */
 struct bgp_attr_parser_args {
@@ -40,6 +40,7 @@
 #include "bgpd/bgp_memory.h"
 #include "bgpd/bgp_keepalives.h"
 #include "bgpd/bgp_io.h"
+#include "bgpd/bgp_update_parse.h"
 #include "bgpd/bgp_zebra.h"
 #include "bgpd/bgp_vty.h"
 
@@ -192,7 +193,11 @@ static struct peer *peer_xfer_conn(struct peer *from_peer)
 		from_peer->fd = fd;
 
 		stream_fifo_clean(peer->ibuf);
-		stream_fifo_clean(peer->obuf);
+		bgp_obuf_clean(peer->obuf);
+
+		/* packets moved over from from_peer are parsed again */
+		bgp_update_parse_flush(peer);
+		bgp_update_parse_flush(from_peer);
 
 		/*
 		 * this should never happen, since bgp_process_packet() is the
@@ -1510,10 +1515,11 @@ enum bgp_fsm_state_progress bgp_stop(struct peer *peer)
 
 	/* Clear input and output buffer.  */
 	frr_with_mutex (&peer->io_mtx) {
+		bgp_update_parse_flush(peer);
 		if (peer->ibuf)
 			stream_fifo_clean(peer->ibuf);
 		if (peer->obuf)
-			stream_fifo_clean(peer->obuf);
+			bgp_obuf_clean(peer->obuf);
 
 		if (peer->ibuf_work)
 			ringbuf_wipe(peer->ibuf_work);
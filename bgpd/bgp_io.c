@@ -25,6 +25,7 @@
 #include "bgpd/bgp_fsm.h"	// for BGP_EVENT_ADD, bgp_event
 #include "bgpd/bgp_packet.h"	// for bgp_notify_io_invalid...
 #include "bgpd/bgp_trace.h"	// for frrtraces
+#include "bgpd/bgp_updgrp.h"	// for bpacket_ref_is, bpacket_ref_iov, ...
 #include "bgpd/bgpd.h"		// for peer, BGP_MARKER_SIZE, bgp_master, bm
 /* clang-format on */
 
@@ -299,6 +300,47 @@ done:
 				 &peer->t_process_packet);
 }
 
+/*
+ * Entries on peer->obuf are either complete BGP messages, or references to
+ * a subgroup's packet that take up to BGP_OBUF_IOV_MAX iovecs to write, see
+ * bpacket_reformat_for_peer().
+ */
+#define BGP_OBUF_IOV_MAX 3
+
+static unsigned int bgp_obuf_iov(struct stream *s, struct iovec *iov)
+{
+	if (bpacket_ref_is(s))
+		return bpacket_ref_iov(s, iov);
+
+	iov[0].iov_base = stream_pnt(s);
+	iov[0].iov_len = STREAM_READABLE(s);
+	return 1;
+}
+
+static size_t bgp_obuf_remain(struct stream *s)
+{
+	if (bpacket_ref_is(s))
+		return bpacket_ref_remain(s);
+	return STREAM_READABLE(s);
+}
+
+static void bgp_obuf_forward(struct stream *s, size_t size)
+{
+	if (bpacket_ref_is(s))
+		bpacket_ref_forward(s, size);
+	else
+		stream_forward_getp(s, size);
+}
+
+static uint8_t bgp_obuf_type(struct stream *s)
+{
+	if (bpacket_ref_is(s))
+		return bpacket_ref_type(s);
+
+	stream_set_getp(s, BGP_MARKER_SIZE + 2);
+	return stream_getc(s);
+}
+
 /*
  * Flush peer output buffer.
  *
@@ -321,39 +363,38 @@ static uint16_t bgp_write(struct peer *peer)
 	uint16_t status = 0;
 	uint32_t wpkt_quanta_old;
 
-	int writenum = 0;
-	int num;
+	ssize_t num;
+	size_t len;
+	unsigned int i;
 	unsigned int iovsz;
-	unsigned int strmsz;
 	unsigned int total_written;
 	time_t now;
 
 	wpkt_quanta_old = atomic_load_explicit(&peer->bgp->wpkt_quanta,
 					       memory_order_relaxed);
 	struct stream *ostreams[wpkt_quanta_old];
-	struct stream **streams = ostreams;
-	struct iovec iov[wpkt_quanta_old];
+	struct iovec iov[wpkt_quanta_old * BGP_OBUF_IOV_MAX];
 
 	s = stream_fifo_head(peer->obuf);
 
 	if (!s)
 		goto done;
 
-	count = iovsz = 0;
-	while (count < wpkt_quanta_old && iovsz < array_size(iov) && s) {
-		ostreams[iovsz] = s;
-		iov[iovsz].iov_base = stream_pnt(s);
-		iov[iovsz].iov_len = STREAM_READABLE(s);
-		writenum += STREAM_READABLE(s);
+	count = 0;
+	while (count < wpkt_quanta_old && s) {
+		ostreams[count] = s;
 		s = s->next;
-		++iovsz;
 		++count;
 	}
 
-	strmsz = iovsz;
 	total_written = 0;
 
-	do {
+	/* ostreams[0, total_written) have been written completely */
+	while (total_written < count) {
+		iovsz = 0;
+		for (i = total_written; i < count; i++)
+			iovsz += bgp_obuf_iov(ostreams[i], &iov[iovsz]);
+
 		num = writev(peer->fd, iov, iovsz);
 
 		if (num < 0) {
@@ -365,41 +406,19 @@ static uint16_t bgp_write(struct peer *peer)
 			}
 
 			break;
-		} else if (num != writenum) {
-			unsigned int msg_written = 0;
-			unsigned int ic = iovsz;
-
-			for (unsigned int i = 0; i < ic; i++) {
-				size_t ss = iov[i].iov_len;
-
-				if (ss > (unsigned int) num)
-					break;
+		}
 
-				msg_written++;
-				iovsz--;
-				writenum -= ss;
-				num -= ss;
+		for (; total_written < count; total_written++) {
+			len = bgp_obuf_remain(ostreams[total_written]);
+			if ((size_t)num < len) {
+				bgp_obuf_forward(ostreams[total_written], num);
+				break;
 			}
 
-			total_written += msg_written;
-
-			assert(total_written < count);
-
-			memmove(&iov, &iov[msg_written],
-				sizeof(iov[0]) * iovsz);
-			streams = &streams[msg_written];
-			stream_forward_getp(streams[0], num);
-			iov[0].iov_base = stream_pnt(streams[0]);
-			iov[0].iov_len = STREAM_READABLE(streams[0]);
-
-			writenum -= num;
-			num = 0;
-			assert(writenum > 0);
-		} else {
-			total_written = strmsz;
+			bgp_obuf_forward(ostreams[total_written], len);
+			num -= len;
 		}
-
-	} while (num != writenum);
+	}
 
 	/* Handle statistics */
 	for (unsigned int i = 0; i < total_written; i++) {
@@ -408,8 +427,7 @@ static uint16_t bgp_write(struct peer *peer)
 		assert(s == ostreams[i]);
 
 		/* Retrieve BGP packet type. */
-		stream_set_getp(s, BGP_MARKER_SIZE + 2);
-		type = stream_getc(s);
+		type = bgp_obuf_type(s);
 
 		switch (type) {
 		case BGP_MSG_OPEN:
@@ -453,7 +471,7 @@ static uint16_t bgp_write(struct peer *peer)
 			break;
 		}
 
-		stream_free(s);
+		bgp_obuf_free(s);
 		ostreams[i] = NULL;
 		update_last_write = 1;
 	}
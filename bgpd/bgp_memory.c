@@ -70,6 +70,8 @@ DEFINE_MTYPE(BGPD, CLUSTER, "Cluster list");
 DEFINE_MTYPE(BGPD, CLUSTER_VAL, "Cluster list val");
 
 DEFINE_MTYPE(BGPD, BGP_PROCESS_QUEUE, "BGP Process queue");
+DEFINE_MTYPE(BGPD, BGP_BESTPATH_CALC, "BGP best path calculation");
+DEFINE_MTYPE(BGPD, BGP_UPDATE_PARSE, "BGP UPDATE parsed ahead");
 DEFINE_MTYPE(BGPD, BGP_CLEAR_NODE_QUEUE, "BGP node clear queue");
 
 DEFINE_MTYPE(BGPD, TRANSIT, "BGP transit attr");
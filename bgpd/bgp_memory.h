@@ -66,6 +66,8 @@ DECLARE_MTYPE(CLUSTER);
 DECLARE_MTYPE(CLUSTER_VAL);
 
 DECLARE_MTYPE(BGP_PROCESS_QUEUE);
+DECLARE_MTYPE(BGP_BESTPATH_CALC);
+DECLARE_MTYPE(BGP_UPDATE_PARSE);
 DECLARE_MTYPE(BGP_CLEAR_NODE_QUEUE);
 
 DECLARE_MTYPE(TRANSIT);
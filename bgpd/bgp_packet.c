@@ -49,6 +49,7 @@
 #include "bgpd/bgp_keepalives.h"
 #include "bgpd/bgp_flowspec.h"
 #include "bgpd/bgp_trace.h"
+#include "bgpd/bgp_update_parse.h"
 
 DEFINE_HOOK(bgp_packet_dump,
 		(struct peer *peer, uint8_t type, bgp_size_t size,
@@ -101,6 +102,27 @@ void bgp_packet_set_size(struct stream *s)
 	stream_putw_at(s, BGP_MARKER_SIZE, cp);
 }
 
+/*
+ * Frees a packet taken off a peer's output queue, which may be a reference
+ * to a subgroup's packet, see bpacket_reformat_for_peer().
+ */
+void bgp_obuf_free(struct stream *s)
+{
+	if (bpacket_ref_is(s))
+		bpacket_ref_free(s);
+	else
+		stream_free(s);
+}
+
+/* Empties a peer's output queue. */
+void bgp_obuf_clean(struct stream_fifo *obuf)
+{
+	struct stream *s;
+
+	while ((s = stream_fifo_pop(obuf)))
+		bgp_obuf_free(s);
+}
+
 /*
  * Push a packet onto the beginning of the peer's output queue.
  * This function acquires the peer's write mutex before proceeding.
@@ -482,6 +504,12 @@ void bgp_generate_updgrp_packets(struct thread *thread)
 		return;
 	}
 
+	/*
+	 * With worker pthreads, build packets for every subgroup that has
+	 * advertisements waiting at once, this peer's included.
+	 */
+	subgroup_build_pending();
+
 	do {
 		enum bgp_af_index index;
 
@@ -943,7 +971,7 @@ static void bgp_notify_send_internal(struct peer *peer, uint8_t code,
 	bgp_packet_set_size(s);
 
 	/* wipe output buffer */
-	stream_fifo_clean(peer->obuf);
+	bgp_obuf_clean(peer->obuf);
 
 	/*
 	 * If possible, store last packet for debugging purposes. This check is
@@ -2891,6 +2919,8 @@ void bgp_process_packet(struct thread *thread)
 		bgp_size_t size;
 		char notify_data_length[2];
 
+		bgp_update_parse_queued(peer);
+
 		frr_with_mutex (&peer->io_mtx) {
 			peer->curr = stream_fifo_pop(peer->ibuf);
 		}
@@ -2898,6 +2928,8 @@ void bgp_process_packet(struct thread *thread)
 		if (peer->curr == NULL) // no packets to process, hmm...
 			return;
 
+		bgp_update_parse_start(peer);
+
 		/* skip the marker and copy the packet length */
 		stream_forward_getp(peer->curr, BGP_MARKER_SIZE);
 		memcpy(notify_data_length, stream_pnt(peer->curr), 2);
@@ -2997,6 +3029,7 @@ void bgp_process_packet(struct thread *thread)
 		}
 
 		/* delete processed packet */
+		bgp_update_parse_end(peer);
 		stream_free(peer->curr);
 		peer->curr = NULL;
 		processed++;
@@ -25,6 +25,7 @@
 #include "queue.h"
 #include "memory.h"
 #include "srv6.h"
+#include "slab.h"
 #include "lib/json.h"
 #include "lib_errors.h"
 #include "zclient.h"
@@ -59,6 +60,7 @@
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_trace.h"
 #include "bgpd/bgp_rpki.h"
+#include "bgpd/bgp_select.h"
 
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/rfapi_backend.h"
@@ -276,7 +278,7 @@ void bgp_path_info_free_with_caller(const char *name,
 
 	peer_unlock(path->peer); /* bgp_path_info peer reference */
 
-	XFREE(MTYPE_BGP_ROUTE, path);
+	slab_free(path);
 }
 
 struct bgp_path_info *bgp_path_info_lock(struct bgp_path_info *path)
@@ -1867,7 +1869,7 @@ static void bgp_peer_as_override(struct bgp *bgp, afi_t afi, safi_t safi,
 
 	if (peer->sort == BGP_PEER_EBGP &&
 	    peer_af_flag_check(peer, afi, safi, PEER_FLAG_AS_OVERRIDE)) {
-		if (attr->aspath->refcnt)
+		if (aspath_refcnt(attr->aspath))
 			aspath = aspath_dup(attr->aspath);
 		else
 			aspath = attr->aspath;
@@ -2632,23 +2634,121 @@ static void bgp_route_select_timer_expire(struct thread *thread)
 	bgp_best_path_select_defer(bgp, afi, safi);
 }
 
-void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
-			struct bgp_maxpaths_cfg *mpath_cfg,
-			struct bgp_path_info_pair *result, afi_t afi,
-			safi_t safi)
+/*
+ * Best path selection is split in two steps:
+ *
+ * - bgp_best_selection_calc() makes the decision. It only reads the
+ *   destination and its paths; flag changes are made on a copy of each
+ *   path's flags. It can therefore run for several destinations in
+ *   parallel, see bgp_process_wq().
+ * - bgp_best_selection_apply() writes the decision back: path flags,
+ *   reaping removed paths, multipath and addpath state.
+ *
+ * bgp_best_selection() runs both back to back.
+ */
+#define BGP_BESTPATH_CALC_INLINE 8
+
+struct bgp_bestpath_calc_path {
+	struct bgp_path_info *pi;
+	/* attr and flags as seen by the calculation */
+	struct attr *attr;
+	uint32_t flags_in;
+	/* flags after the calculation */
+	uint32_t flags;
+	bool reap;
+	bool mpath;
+};
+
+struct bgp_bestpath_calc {
+	struct bgp_dest *dest;
+
+	struct bgp_path_info *old_select;
+	struct bgp_path_info *new_select;
+	enum bgp_path_selection_reason reason;
+
+	uint32_t npaths;
+	struct bgp_bestpath_calc_path *paths;
+	struct bgp_bestpath_calc_path paths_inline[BGP_BESTPATH_CALC_INLINE];
+};
+
+static void bgp_bestpath_calc_fini(struct bgp_bestpath_calc *calc)
+{
+	if (calc->paths != calc->paths_inline)
+		XFREE(MTYPE_BGP_BESTPATH_CALC, calc->paths);
+	calc->paths = NULL;
+	calc->npaths = 0;
+}
+
+/* Is the path list still exactly what the calculation was made on? */
+static bool bgp_bestpath_calc_current(const struct bgp_bestpath_calc *calc,
+				      struct bgp_dest *dest)
+{
+	struct bgp_path_info *pi;
+	uint32_t i = 0;
+
+	if (calc->dest != dest)
+		return false;
+
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next, i++) {
+		if (i >= calc->npaths)
+			return false;
+		if (calc->paths[i].pi != pi || calc->paths[i].attr != pi->attr
+		    || calc->paths[i].flags_in != pi->flags)
+			return false;
+	}
+
+	return i == calc->npaths;
+}
+
+static bool bgp_bestpath_calc_peer_ok(struct bgp *bgp,
+				      const struct bgp_path_info *pi)
 {
+	if (pi->peer && pi->peer != bgp->peer_self
+	    && !CHECK_FLAG(pi->peer->sflags, PEER_STATUS_NSF_WAIT))
+		return peer_established(pi->peer);
+
+	return true;
+}
+
+static void bgp_best_selection_calc(struct bgp *bgp, struct bgp_dest *dest,
+				    struct bgp_maxpaths_cfg *mpath_cfg,
+				    struct bgp_bestpath_calc *calc, afi_t afi,
+				    safi_t safi)
+{
+	struct bgp_bestpath_calc_path *paths, *p1, *p2, *new_p = NULL;
 	struct bgp_path_info *new_select;
 	struct bgp_path_info *old_select;
 	struct bgp_path_info *pi;
-	struct bgp_path_info *pi1;
-	struct bgp_path_info *pi2;
-	struct bgp_path_info *nextpi = NULL;
+	uint32_t i, j, npaths = 0;
 	int paths_eq, do_mpath, debug;
-	struct list mp_list;
+	enum bgp_path_selection_reason reason;
 	char pfx_buf[PREFIX2STR_BUFFER];
 	char path_buf[PATH_ADDPATH_STR_BUFFER];
 
-	bgp_mp_list_init(&mp_list);
+	calc->dest = dest;
+
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next)
+		npaths++;
+
+	if (npaths > BGP_BESTPATH_CALC_INLINE)
+		paths = XMALLOC(MTYPE_BGP_BESTPATH_CALC,
+				npaths * sizeof(*paths));
+	else
+		paths = calc->paths_inline;
+
+	calc->paths = paths;
+	calc->npaths = npaths;
+
+	for (i = 0, pi = bgp_dest_get_bgp_path_info(dest); pi;
+	     pi = pi->next, i++) {
+		paths[i].pi = pi;
+		paths[i].attr = pi->attr;
+		paths[i].flags_in = pi->flags;
+		paths[i].flags = pi->flags;
+		paths[i].reap = false;
+		paths[i].mpath = false;
+	}
+
 	do_mpath =
 		(mpath_cfg->maxpaths_ebgp > 1 || mpath_cfg->maxpaths_ibgp > 1);
 
@@ -2657,72 +2757,65 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 	if (debug)
 		prefix2str(bgp_dest_get_prefix(dest), pfx_buf, sizeof(pfx_buf));
 
-	dest->reason = bgp_path_selection_none;
+	reason = bgp_path_selection_none;
 	/* bgp deterministic-med */
 	new_select = NULL;
 	if (CHECK_FLAG(bgp->flags, BGP_FLAG_DETERMINISTIC_MED)) {
 
 		/* Clear BGP_PATH_DMED_SELECTED for all paths */
-		for (pi1 = bgp_dest_get_bgp_path_info(dest); pi1;
-		     pi1 = pi1->next)
-			bgp_path_info_unset_flag(dest, pi1,
-						 BGP_PATH_DMED_SELECTED);
-
-		for (pi1 = bgp_dest_get_bgp_path_info(dest); pi1;
-		     pi1 = pi1->next) {
-			if (CHECK_FLAG(pi1->flags, BGP_PATH_DMED_CHECK))
+		for (i = 0; i < npaths; i++)
+			UNSET_FLAG(paths[i].flags, BGP_PATH_DMED_SELECTED);
+
+		for (i = 0; i < npaths; i++) {
+			p1 = &paths[i];
+
+			if (CHECK_FLAG(p1->flags, BGP_PATH_DMED_CHECK))
 				continue;
-			if (BGP_PATH_HOLDDOWN(pi1))
+			if (BGP_PATH_HOLDDOWN(p1->pi))
 				continue;
-			if (pi1->peer != bgp->peer_self &&
-			    !CHECK_FLAG(pi1->peer->sflags,
+			if (p1->pi->peer != bgp->peer_self &&
+			    !CHECK_FLAG(p1->pi->peer->sflags,
 					PEER_STATUS_NSF_WAIT)) {
-				if (!peer_established(pi1->peer))
+				if (!peer_established(p1->pi->peer))
 					continue;
 			}
 
-			new_select = pi1;
-			if (pi1->next) {
-				for (pi2 = pi1->next; pi2; pi2 = pi2->next) {
-					if (CHECK_FLAG(pi2->flags,
-						       BGP_PATH_DMED_CHECK))
-						continue;
-					if (BGP_PATH_HOLDDOWN(pi2))
-						continue;
-					if (pi2->peer != bgp->peer_self
-					    && !CHECK_FLAG(
-						    pi2->peer->sflags,
-						    PEER_STATUS_NSF_WAIT))
-						if (pi2->peer->status
-						    != Established)
-							continue;
-
-					if (!aspath_cmp_left(pi1->attr->aspath,
-							     pi2->attr->aspath)
-					    && !aspath_cmp_left_confed(
-						       pi1->attr->aspath,
-						       pi2->attr->aspath))
+			new_select = p1->pi;
+			new_p = p1;
+			for (j = i + 1; j < npaths; j++) {
+				p2 = &paths[j];
+
+				if (CHECK_FLAG(p2->flags, BGP_PATH_DMED_CHECK))
+					continue;
+				if (BGP_PATH_HOLDDOWN(p2->pi))
+					continue;
+				if (p2->pi->peer != bgp->peer_self
+				    && !CHECK_FLAG(p2->pi->peer->sflags,
+						   PEER_STATUS_NSF_WAIT))
+					if (p2->pi->peer->status != Established)
 						continue;
 
-					if (bgp_path_info_cmp(
-						    bgp, pi2, new_select,
-						    &paths_eq, mpath_cfg, debug,
-						    pfx_buf, afi, safi,
-						    &dest->reason)) {
-						bgp_path_info_unset_flag(
-							dest, new_select,
-							BGP_PATH_DMED_SELECTED);
-						new_select = pi2;
-					}
+				if (!aspath_cmp_left(p1->pi->attr->aspath,
+						     p2->pi->attr->aspath)
+				    && !aspath_cmp_left_confed(
+					    p1->pi->attr->aspath,
+					    p2->pi->attr->aspath))
+					continue;
 
-					bgp_path_info_set_flag(
-						dest, pi2, BGP_PATH_DMED_CHECK);
+				if (bgp_path_info_cmp(bgp, p2->pi, new_select,
+						      &paths_eq, mpath_cfg,
+						      debug, pfx_buf, afi,
+						      safi, &reason)) {
+					UNSET_FLAG(new_p->flags,
+						   BGP_PATH_DMED_SELECTED);
+					new_select = p2->pi;
+					new_p = p2;
 				}
+
+				SET_FLAG(p2->flags, BGP_PATH_DMED_CHECK);
 			}
-			bgp_path_info_set_flag(dest, new_select,
-					       BGP_PATH_DMED_CHECK);
-			bgp_path_info_set_flag(dest, new_select,
-					       BGP_PATH_DMED_SELECTED);
+			SET_FLAG(new_p->flags, BGP_PATH_DMED_CHECK);
+			SET_FLAG(new_p->flags, BGP_PATH_DMED_SELECTED);
 
 			if (debug) {
 				bgp_path_info_path_with_addpath_rx_str(
@@ -2739,20 +2832,22 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 	/* Check old selected route and new selected route. */
 	old_select = NULL;
 	new_select = NULL;
-	for (pi = bgp_dest_get_bgp_path_info(dest);
-	     (pi != NULL) && (nextpi = pi->next, 1); pi = nextpi) {
-		enum bgp_path_selection_reason reason;
+	for (i = 0; i < npaths; i++) {
+		enum bgp_path_selection_reason prev_reason;
 
-		if (CHECK_FLAG(pi->flags, BGP_PATH_SELECTED))
+		p1 = &paths[i];
+		pi = p1->pi;
+
+		if (CHECK_FLAG(p1->flags, BGP_PATH_SELECTED))
 			old_select = pi;
 
 		if (BGP_PATH_HOLDDOWN(pi)) {
 			/* reap REMOVED routes, if needs be
 			 * selected route must stay for a while longer though
 			 */
-			if (CHECK_FLAG(pi->flags, BGP_PATH_REMOVED)
+			if (CHECK_FLAG(p1->flags, BGP_PATH_REMOVED)
 			    && (pi != old_select))
-				bgp_path_info_reap(dest, pi);
+				p1->reap = true;
 
 			if (debug)
 				zlog_debug("%s: pi %p in holddown", __func__,
@@ -2761,35 +2856,31 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 			continue;
 		}
 
-		if (pi->peer && pi->peer != bgp->peer_self
-		    && !CHECK_FLAG(pi->peer->sflags, PEER_STATUS_NSF_WAIT))
-			if (!peer_established(pi->peer)) {
-
-				if (debug)
-					zlog_debug(
-						"%s: pi %p non self peer %s not estab state",
-						__func__, pi, pi->peer->host);
+		if (!bgp_bestpath_calc_peer_ok(bgp, pi)) {
+			if (debug)
+				zlog_debug(
+					"%s: pi %p non self peer %s not estab state",
+					__func__, pi, pi->peer->host);
 
-				continue;
-			}
+			continue;
+		}
 
 		if (CHECK_FLAG(bgp->flags, BGP_FLAG_DETERMINISTIC_MED)
-		    && (!CHECK_FLAG(pi->flags, BGP_PATH_DMED_SELECTED))) {
-			bgp_path_info_unset_flag(dest, pi, BGP_PATH_DMED_CHECK);
+		    && (!CHECK_FLAG(p1->flags, BGP_PATH_DMED_SELECTED))) {
+			UNSET_FLAG(p1->flags, BGP_PATH_DMED_CHECK);
 			if (debug)
 				zlog_debug("%s: pi %p dmed", __func__, pi);
 			continue;
 		}
 
-		bgp_path_info_unset_flag(dest, pi, BGP_PATH_DMED_CHECK);
+		UNSET_FLAG(p1->flags, BGP_PATH_DMED_CHECK);
 
-		reason = dest->reason;
+		prev_reason = reason;
 		if (bgp_path_info_cmp(bgp, pi, new_select, &paths_eq, mpath_cfg,
-				      debug, pfx_buf, afi, safi,
-				      &dest->reason)) {
+				      debug, pfx_buf, afi, safi, &reason)) {
 			if (new_select == NULL &&
-			    reason != bgp_path_selection_none)
-				dest->reason = reason;
+			    prev_reason != bgp_path_selection_none)
+				reason = prev_reason;
 			new_select = pi;
 		}
 	}
@@ -2811,8 +2902,13 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 	}
 
 	if (do_mpath && new_select) {
-		for (pi = bgp_dest_get_bgp_path_info(dest);
-		     (pi != NULL) && (nextpi = pi->next, 1); pi = nextpi) {
+		for (i = 0; i < npaths; i++) {
+			p1 = &paths[i];
+			pi = p1->pi;
+
+			/* already reaped in the serial order of things */
+			if (p1->reap)
+				continue;
 
 			if (debug)
 				bgp_path_info_path_with_addpath_rx_str(
@@ -2824,18 +2920,15 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 						"%pBD(%s): %s is the bestpath, add to the multipath list",
 						dest, bgp->name_pretty,
 						path_buf);
-				bgp_mp_list_add(&mp_list, pi);
+				p1->mpath = true;
 				continue;
 			}
 
 			if (BGP_PATH_HOLDDOWN(pi))
 				continue;
 
-			if (pi->peer && pi->peer != bgp->peer_self
-			    && !CHECK_FLAG(pi->peer->sflags,
-					   PEER_STATUS_NSF_WAIT))
-				if (!peer_established(pi->peer))
-					continue;
+			if (!bgp_bestpath_calc_peer_ok(bgp, pi))
+				continue;
 
 			if (!bgp_path_info_nexthop_cmp(pi, new_select)) {
 				if (debug)
@@ -2847,29 +2940,94 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 
 			bgp_path_info_cmp(bgp, pi, new_select, &paths_eq,
 					  mpath_cfg, debug, pfx_buf, afi, safi,
-					  &dest->reason);
+					  &reason);
 
 			if (paths_eq) {
 				if (debug)
 					zlog_debug(
 						"%pBD: %s is equivalent to the bestpath, add to the multipath list",
 						dest, path_buf);
-				bgp_mp_list_add(&mp_list, pi);
+				p1->mpath = true;
 			}
 		}
 	}
 
-	bgp_path_info_mpath_update(bgp, dest, new_select, old_select, &mp_list,
-				   mpath_cfg);
-	bgp_path_info_mpath_aggregate_update(new_select, old_select);
+	calc->old_select = old_select;
+	calc->new_select = new_select;
+	calc->reason = reason;
+}
+
+static void bgp_best_selection_apply(struct bgp *bgp, struct bgp_dest *dest,
+				     struct bgp_maxpaths_cfg *mpath_cfg,
+				     struct bgp_bestpath_calc *calc,
+				     struct bgp_path_info_pair *result,
+				     afi_t afi, safi_t safi)
+{
+	struct bgp_bestpath_calc_path *p;
+	struct list mp_list;
+	uint32_t i, changed;
+
+	bgp_mp_list_init(&mp_list);
+
+	dest->reason = calc->reason;
+
+	for (i = 0; i < calc->npaths; i++) {
+		p = &calc->paths[i];
+
+		changed = (p->flags ^ p->pi->flags)
+			  & (BGP_PATH_DMED_CHECK | BGP_PATH_DMED_SELECTED);
+		if (changed & p->flags)
+			bgp_path_info_set_flag(dest, p->pi, changed & p->flags);
+		if (changed & ~p->flags)
+			bgp_path_info_unset_flag(dest, p->pi,
+						 changed & ~p->flags);
+
+		if (p->mpath)
+			bgp_mp_list_add(&mp_list, p->pi);
+	}
+
+	for (i = 0; i < calc->npaths; i++)
+		if (calc->paths[i].reap)
+			bgp_path_info_reap(dest, calc->paths[i].pi);
+
+	bgp_path_info_mpath_update(bgp, dest, calc->new_select,
+				   calc->old_select, &mp_list, mpath_cfg);
+	bgp_path_info_mpath_aggregate_update(calc->new_select,
+					     calc->old_select);
 	bgp_mp_list_clear(&mp_list);
 
 	bgp_addpath_update_ids(bgp, dest, afi, safi);
 
-	result->old = old_select;
-	result->new = new_select;
+	result->old = calc->old_select;
+	result->new = calc->new_select;
+}
 
-	return;
+void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
+			struct bgp_maxpaths_cfg *mpath_cfg,
+			struct bgp_path_info_pair *result, afi_t afi,
+			safi_t safi)
+{
+	struct bgp_bestpath_calc calc;
+
+	bgp_best_selection_calc(bgp, dest, mpath_cfg, &calc, afi, safi);
+	bgp_best_selection_apply(bgp, dest, mpath_cfg, &calc, result, afi,
+				 safi);
+	bgp_bestpath_calc_fini(&calc);
+}
+
+/* Use a calculation made up front if it's still valid, else start over */
+static void bgp_best_selection_with_calc(struct bgp *bgp,
+					 struct bgp_dest *dest,
+					 struct bgp_bestpath_calc *calc,
+					 struct bgp_path_info_pair *result,
+					 afi_t afi, safi_t safi)
+{
+	if (calc && bgp_bestpath_calc_current(calc, dest))
+		bgp_best_selection_apply(bgp, dest, &bgp->maxpaths[afi][safi],
+					 calc, result, afi, safi);
+	else
+		bgp_best_selection(bgp, dest, &bgp->maxpaths[afi][safi],
+				   result, afi, safi);
 }
 
 /*
@@ -3091,7 +3249,8 @@ static bool bgp_lu_need_imp_null(const struct bgp_path_info *new_select)
  *     is being removed.
  */
 static void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest,
-				 afi_t afi, safi_t safi)
+				 afi_t afi, safi_t safi,
+				 struct bgp_bestpath_calc *calc)
 {
 	struct bgp_path_info *new_select;
 	struct bgp_path_info *old_select;
@@ -3141,8 +3300,7 @@ static void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest,
 	}
 
 	/* Best path selection. */
-	bgp_best_selection(bgp, dest, &bgp->maxpaths[afi][safi], &old_and_new,
-			   afi, safi);
+	bgp_best_selection_with_calc(bgp, dest, calc, &old_and_new, afi, safi);
 	old_select = old_and_new.old;
 	new_select = old_and_new.new;
 
@@ -3390,7 +3548,7 @@ void bgp_best_path_select_defer(struct bgp *bgp, afi_t afi, safi_t safi)
 
 		UNSET_FLAG(dest->flags, BGP_NODE_SELECT_DEFER);
 		bgp->gr_info[afi][safi].gr_deferred--;
-		bgp_process_main_one(bgp, dest, afi, safi);
+		bgp_process_main_one(bgp, dest, afi, safi, NULL);
 		cnt++;
 	}
 	/* If iteration stopped before the entire table was traversed then the
@@ -3424,33 +3582,153 @@ void bgp_best_path_select_defer(struct bgp *bgp, afi_t afi, safi_t safi)
 			&bgp->gr_info[afi][safi].t_route_select);
 }
 
+/*
+ * Best path calculations for a process queue item, done up front on the
+ * selection worker pthreads.
+ */
+struct bgp_process_batch {
+	struct bgp *bgp;
+	size_t count;
+	struct bgp_dest **dests;
+	struct bgp_bestpath_calc *calcs;
+};
+
+/* Not worth waking up the workers for less than this */
+#define BGP_PROCESS_PARALLEL_MIN 64
+
+static void bgp_process_batch_calc(void *arg, size_t idx)
+{
+	struct bgp_process_batch *batch = arg;
+	struct bgp_dest *dest = batch->dests[idx];
+	struct bgp_bestpath_calc *calc = &batch->calcs[idx];
+	struct bgp_table *table = bgp_dest_table(dest);
+	struct bgp *bgp = batch->bgp;
+
+	if (CHECK_FLAG(dest->flags, BGP_NODE_SELECT_DEFER)) {
+		calc->dest = NULL;
+		calc->npaths = 0;
+		calc->paths = NULL;
+		return;
+	}
+
+	bgp_best_selection_calc(bgp, dest,
+				&bgp->maxpaths[table->afi][table->safi], calc,
+				table->afi, table->safi);
+}
+
+static void bgp_process_batch_run(struct bgp_process_batch *batch)
+{
+	batch->calcs = XMALLOC(MTYPE_BGP_BESTPATH_CALC,
+			       batch->count * sizeof(*batch->calcs));
+
+	bgp_select_run(bgp_process_batch_calc, batch, batch->count);
+}
+
+static void bgp_process_batch_finish(struct bgp_process_batch *batch)
+{
+	size_t i;
+
+	for (i = 0; i < batch->count; i++)
+		bgp_bestpath_calc_fini(&batch->calcs[i]);
+
+	XFREE(MTYPE_BGP_BESTPATH_CALC, batch->calcs);
+}
+
+static void bgp_process_batch_start(struct bgp_process_batch *batch,
+				    struct bgp_process_queue *pqnode)
+{
+	struct bgp_dest *dest;
+	size_t i = 0;
+
+	memset(batch, 0, sizeof(*batch));
+
+	if (bgp_select_get_workers() <= 1
+	    || pqnode->queued < BGP_PROCESS_PARALLEL_MIN
+	    || CHECK_FLAG(pqnode->bgp->flags, BGP_FLAG_DELETE_IN_PROGRESS))
+		return;
+
+	batch->bgp = pqnode->bgp;
+	batch->dests = XMALLOC(MTYPE_BGP_BESTPATH_CALC,
+			       pqnode->queued * sizeof(*batch->dests));
+
+	STAILQ_FOREACH (dest, &pqnode->pqueue, pq) {
+		if (i == pqnode->queued)
+			break;
+		batch->dests[i++] = dest;
+	}
+	batch->count = i;
+
+	bgp_process_batch_run(batch);
+}
+
+void bgp_best_selection_multi(struct bgp *bgp, struct bgp_dest **dests,
+			      size_t count, struct bgp_path_info_pair *results)
+{
+	struct bgp_process_batch batch = {
+		.bgp = bgp,
+		.count = count,
+		.dests = dests,
+	};
+	struct bgp_table *table;
+	size_t i;
+
+	bgp_process_batch_run(&batch);
+
+	for (i = 0; i < count; i++) {
+		table = bgp_dest_table(dests[i]);
+		bgp_best_selection_with_calc(bgp, dests[i], &batch.calcs[i],
+					     &results[i], table->afi,
+					     table->safi);
+	}
+
+	bgp_process_batch_finish(&batch);
+}
+
 static wq_item_status bgp_process_wq(struct work_queue *wq, void *data)
 {
 	struct bgp_process_queue *pqnode = data;
 	struct bgp *bgp = pqnode->bgp;
+	struct bgp_process_batch batch;
+	struct bgp_bestpath_calc *calc;
 	struct bgp_table *table;
 	struct bgp_dest *dest;
+	size_t i = 0;
 
 	/* eoiu marker */
 	if (CHECK_FLAG(pqnode->flags, BGP_PROCESS_QUEUE_EOIU_MARKER)) {
-		bgp_process_main_one(bgp, NULL, 0, 0);
+		bgp_process_main_one(bgp, NULL, 0, 0, NULL);
 		/* should always have dedicated wq call */
 		assert(STAILQ_FIRST(&pqnode->pqueue) == NULL);
 		return WQ_SUCCESS;
 	}
 
+	/* Decide best paths for the queued DESTs in parallel; the results
+	 * are applied below, in queue order. A result is only used if the
+	 * DEST's paths haven't changed by the time it's applied.
+	 */
+	bgp_process_batch_start(&batch, pqnode);
+
 	while (!STAILQ_EMPTY(&pqnode->pqueue)) {
 		dest = STAILQ_FIRST(&pqnode->pqueue);
 		STAILQ_REMOVE_HEAD(&pqnode->pqueue, pq);
 		STAILQ_NEXT(dest, pq) = NULL; /* complete unlink */
 		table = bgp_dest_table(dest);
+
+		calc = NULL;
+		if (i < batch.count && batch.dests[i] == dest)
+			calc = &batch.calcs[i];
+		i++;
+
 		/* note, new DESTs may be added as part of processing */
-		bgp_process_main_one(bgp, dest, table->afi, table->safi);
+		bgp_process_main_one(bgp, dest, table->afi, table->safi, calc);
 
 		bgp_dest_unlock_node(dest);
 		bgp_table_unlock(table);
 	}
 
+	bgp_process_batch_finish(&batch);
+	XFREE(MTYPE_BGP_BESTPATH_CALC, batch.dests);
+
 	return WQ_SUCCESS;
 }
 
@@ -3802,6 +4080,47 @@ static void bgp_rib_withdraw(struct bgp_dest *dest, struct bgp_path_info *pi,
 	bgp_rib_remove(dest, pi, peer, afi, safi);
 }
 
+/* Paths are allocated from one slab per instance and afi/safi, so that the
+ * paths of a table end up packed together rather than interleaved with
+ * everything else bgpd allocates.  Paths without a dest (VNC) share a
+ * global slab.
+ */
+static struct slab_stats bgp_path_slab_stats;
+static struct slab *bgp_path_slab_default;
+
+static struct slab *bgp_path_slab_get(struct bgp_dest *dest)
+{
+	struct bgp_table *table = dest ? bgp_dest_table(dest) : NULL;
+	struct slab **slabp;
+
+	if (table && table->bgp)
+		slabp = &table->bgp->path_slab[table->afi][table->safi];
+	else
+		slabp = &bgp_path_slab_default;
+
+	if (!*slabp)
+		*slabp = slab_new(MTYPE_BGP_ROUTE, "BGP paths",
+				  sizeof(struct bgp_path_info),
+				  &bgp_path_slab_stats);
+	return *slabp;
+}
+
+/* Paths still allocated keep their slab alive until they are freed */
+void bgp_path_slabs_free(struct bgp *bgp)
+{
+	afi_t afi;
+	safi_t safi;
+
+	FOREACH_AFI_SAFI (afi, safi)
+		slab_delete(&bgp->path_slab[afi][safi]);
+}
+
+void bgp_path_slab_stats_get(size_t *paths, size_t *bytes)
+{
+	*paths = bgp_path_slab_stats.objects;
+	*bytes = bgp_path_slab_stats.pages * SLAB_PAGE_SIZE;
+}
+
 struct bgp_path_info *info_make(int type, int sub_type, unsigned short instance,
 				struct peer *peer, struct attr *attr,
 				struct bgp_dest *dest)
@@ -3809,7 +4128,7 @@ struct bgp_path_info *info_make(int type, int sub_type, unsigned short instance,
 	struct bgp_path_info *new;
 
 	/* Make new BGP info. */
-	new = XCALLOC(MTYPE_BGP_ROUTE, sizeof(struct bgp_path_info));
+	new = slab_alloc(bgp_path_slab_get(dest));
 	new->type = type;
 	new->instance = instance;
 	new->sub_type = sub_type;
@@ -4865,7 +5184,7 @@ filtered:
 		bgp_unlink_nexthop(new);
 		bgp_path_info_delete(dest, new);
 		bgp_path_info_extra_free(&new->extra);
-		XFREE(MTYPE_BGP_ROUTE, new);
+		slab_free(new);
 	}
 
 	hook_call(bgp_process, bgp, afi, safi, dest, peer, true);
@@ -16035,4 +16354,6 @@ void bgp_route_finish(void)
 		bgp_table_unlock(bgp_distance_table[afi][safi]);
 		bgp_distance_table[afi][safi] = NULL;
 	}
+
+	slab_delete(&bgp_path_slab_default);
 }
@@ -246,39 +246,31 @@ struct bgp_path_info_extra {
 	struct bgp_path_mh_info *mh_info;
 };
 
+/* Fields are ordered by use: path selection and the per-dest list walks
+ * only touch the first cache line, the rest is bookkeeping that is read on
+ * (much rarer) nexthop, multipath and addpath changes.  Keep it that way,
+ * and keep the struct free of padding: paths are slab allocated (see
+ * info_make()), so there is no malloc size class rounding to hide it.
+ */
 struct bgp_path_info {
 	/* For linked list. */
 	struct bgp_path_info *next;
-	struct bgp_path_info *prev;
-
-	/* For nexthop linked list */
-	LIST_ENTRY(bgp_path_info) nh_thread;
 
-	/* Back pointer to the prefix node */
-	struct bgp_dest *net;
-
-	/* Back pointer to the nexthop structure */
-	struct bgp_nexthop_cache *nexthop;
+	/* Attribute structure.  */
+	struct attr *attr;
 
 	/* Peer structure.  */
 	struct peer *peer;
 
-	/* Attribute structure.  */
-	struct attr *attr;
-
 	/* Extra information */
 	struct bgp_path_info_extra *extra;
 
-
-	/* Multipath information */
-	struct bgp_path_info_mpath *mpath;
+	/* Back pointer to the prefix node */
+	struct bgp_dest *net;
 
 	/* Uptime.  */
 	time_t uptime;
 
-	/* reference count */
-	int lock;
-
 	/* BGP information status.  */
 	uint32_t flags;
 #define BGP_PATH_IGP_CHANGED (1 << 0)
@@ -318,6 +310,23 @@ struct bgp_path_info {
 
 	/* Addpath identifiers */
 	uint32_t addpath_rx_id;
+
+	/* reference count */
+	int lock;
+
+	/* -- cold fields from here on -- */
+
+	struct bgp_path_info *prev;
+
+	/* Multipath information */
+	struct bgp_path_info_mpath *mpath;
+
+	/* Back pointer to the nexthop structure */
+	struct bgp_nexthop_cache *nexthop;
+
+	/* For nexthop linked list */
+	LIST_ENTRY(bgp_path_info) nh_thread;
+
 	struct bgp_addpath_info_data tx_addpath;
 };
 
@@ -783,6 +792,8 @@ extern uint8_t bgp_distance_apply(const struct prefix *p,
 extern afi_t bgp_node_afi(struct vty *);
 extern safi_t bgp_node_safi(struct vty *);
 
+extern void bgp_path_slabs_free(struct bgp *bgp);
+extern void bgp_path_slab_stats_get(size_t *paths, size_t *bytes);
 extern struct bgp_path_info *info_make(int type, int sub_type,
 				       unsigned short instance,
 				       struct peer *peer, struct attr *attr,
@@ -837,6 +848,13 @@ extern void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 			       struct bgp_maxpaths_cfg *mpath_cfg,
 			       struct bgp_path_info_pair *result, afi_t afi,
 			       safi_t safi);
+/* Best path selection for several destinations of one instance, with the
+ * decisions made in parallel on the bgp_select worker pthreads. Same results
+ * as calling bgp_best_selection() for each destination in turn.
+ */
+extern void bgp_best_selection_multi(struct bgp *bgp, struct bgp_dest **dests,
+				     size_t count,
+				     struct bgp_path_info_pair *results);
 extern void bgp_zebra_clear_route_change_flags(struct bgp_dest *dest);
 extern bool bgp_zebra_has_route_changed(struct bgp_path_info *selected);
 
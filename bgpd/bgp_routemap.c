@@ -2209,7 +2209,7 @@ route_set_aspath_prepend(void *rule, const struct prefix *prefix, void *object)
 
 	path = object;
 
-	if (path->attr->aspath->refcnt)
+	if (aspath_refcnt(path->attr->aspath))
 		new = aspath_dup(path->attr->aspath);
 	else
 		new = path->attr->aspath;
@@ -2268,7 +2268,7 @@ route_set_aspath_exclude(void *rule, const struct prefix *dummy, void *object)
 
 	exclude_path = rule;
 	path = object;
-	if (path->attr->aspath->refcnt)
+	if (aspath_refcnt(path->attr->aspath))
 		new_path = aspath_dup(path->attr->aspath);
 	else
 		new_path = path->attr->aspath;
@@ -2311,7 +2311,7 @@ route_set_aspath_replace(void *rule, const struct prefix *dummy, void *object)
 		return RMAP_NOOP;
 	}
 
-	if (path->attr->aspath->refcnt)
+	if (aspath_refcnt(path->attr->aspath))
 		aspath_new = aspath_dup(path->attr->aspath);
 	else
 		aspath_new = path->attr->aspath;
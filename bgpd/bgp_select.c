@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/* BGP best path selection worker pool.
+ * Runs the read-only part of best path selection for many destinations
+ * in parallel.
+ */
+
+#include <zebra.h>
+
+#include "workpool.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_select.h"
+
+static struct workpool *select_pool;
+
+static struct workpool *bgp_select_pool(void)
+{
+	if (!select_pool)
+		select_pool = workpool_new("BGP selection worker", "bgpd_sel");
+	return select_pool;
+}
+
+void bgp_select_set_workers(unsigned int workers)
+{
+	workpool_set_workers(bgp_select_pool(), workers);
+}
+
+unsigned int bgp_select_get_workers(void)
+{
+	return workpool_get_workers(bgp_select_pool());
+}
+
+void bgp_select_run(void (*func)(void *arg, size_t idx), void *arg,
+		    size_t count)
+{
+	workpool_run(bgp_select_pool(), func, arg, count);
+}
+
+void bgp_select_finish(void)
+{
+	workpool_free(&select_pool);
+}
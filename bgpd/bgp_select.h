@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/* BGP best path selection worker pool.
+ * Runs the read-only part of best path selection for many destinations
+ * in parallel.
+ */
+
+#ifndef _FRR_BGP_SELECT_H
+#define _FRR_BGP_SELECT_H
+
+#include "workpool.h"
+
+#define BGP_SELECT_WORKERS_DEFAULT 1
+#define BGP_SELECT_WORKERS_MAX WORKPOOL_WORKERS_MAX
+
+/**
+ * Sets the number of pthreads taking part in best path selection, including
+ * the main pthread. With one worker everything runs in the main pthread.
+ *
+ * Worker pthreads are started and stopped as needed; this may be called at
+ * any time from the main pthread, but not while bgp_select_run() is running.
+ */
+extern void bgp_select_set_workers(unsigned int workers);
+
+/**
+ * Returns the configured number of workers, including the main pthread.
+ */
+extern unsigned int bgp_select_get_workers(void);
+
+/**
+ * Calls func(arg, idx) for every idx in [0, count), spread over the worker
+ * pthreads and the calling (main) pthread. Returns once all calls have
+ * completed.
+ *
+ * func must not modify any state shared with other calls or with the rest
+ * of bgpd; the main pthread is blocked in here while the workers run, so
+ * func may read the RIB without locking.
+ */
+extern void bgp_select_run(void (*func)(void *arg, size_t idx), void *arg,
+			   size_t count);
+
+/**
+ * Stops all worker pthreads; used at shutdown.
+ */
+extern void bgp_select_finish(void);
+
+#endif /* _FRR_BGP_SELECT_H */
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/* BGP UPDATE parse worker pool.
+ * Parses the AS paths of a peer's queued UPDATE messages in parallel,
+ * ahead of bgp_update_receive().
+ */
+
+#include <zebra.h>
+
+#include "stream.h"
+#include "workpool.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_memory.h"
+#include "bgpd/bgp_update_parse.h"
+
+/* Number of queued UPDATEs worth waking up the workers for, and the most
+ * parsed ahead at once.  The rest of a batch is kept until the main pthread
+ * gets to it, rpkt_quanta packets at a time.
+ */
+#define BGP_UPDATE_PARSE_MIN 16
+#define BGP_UPDATE_PARSE_BATCH 256
+
+/* The AS_PATH and the AS4_PATH attribute of an UPDATE */
+#define BGP_UPDATE_PARSE_ASPATHS 2
+
+struct bgp_update_parsed {
+	struct stream *s;
+
+	struct {
+		/* start and length of the attribute value in 's' */
+		size_t pos;
+		size_t length;
+		struct aspath *aspath;
+	} aspath[BGP_UPDATE_PARSE_ASPATHS];
+};
+
+struct bgp_update_batch {
+	/* how the AS paths were parsed, cf. bgp_attr_aspath() */
+	int use32bit;
+	enum asnotation_mode asnotation;
+
+	/* next entry to be taken by bgp_update_parse_start() */
+	unsigned int next;
+	unsigned int count;
+	struct bgp_update_parsed parsed[];
+};
+
+static struct workpool *parse_pool;
+
+static struct workpool *bgp_update_parse_pool(void)
+{
+	if (!parse_pool)
+		parse_pool = workpool_new("BGP UPDATE parser", "bgpd_upd");
+	return parse_pool;
+}
+
+void bgp_update_parse_set_workers(unsigned int workers)
+{
+	workpool_set_workers(bgp_update_parse_pool(), workers);
+}
+
+unsigned int bgp_update_parse_get_workers(void)
+{
+	return workpool_get_workers(bgp_update_parse_pool());
+}
+
+static int bgp_update_parse_slot(uint8_t type)
+{
+	switch (type) {
+	case BGP_ATTR_AS_PATH:
+		return 0;
+	case BGP_ATTR_AS4_PATH:
+		return 1;
+	}
+	return -1;
+}
+
+/*
+ * Runs on a worker pthread.  Walks the attributes the way bgp_attr_parse()
+ * does, but stops quietly at anything that doesn't add up;  the main pthread
+ * then finds and reports it.  Nothing but the packet and the intern table is
+ * written, and the read position is restored at the end.
+ */
+static void bgp_update_parse_one(void *arg, size_t idx)
+{
+	struct bgp_update_batch *batch = arg;
+	struct bgp_update_parsed *parsed = &batch->parsed[idx];
+	struct stream *s = parsed->s;
+	size_t end, attr_end, pos, length;
+	uint8_t flag, type;
+	int slot;
+
+	end = MIN((size_t)stream_getw_from(s, BGP_MARKER_SIZE),
+		  stream_get_endp(s));
+	pos = BGP_HEADER_SIZE;
+
+	/* withdrawn routes */
+	if (pos + 2 > end)
+		return;
+	pos += 2 + stream_getw_from(s, pos);
+
+	/* attributes */
+	if (pos + 2 > end)
+		return;
+	attr_end = pos + 2 + stream_getw_from(s, pos);
+	pos += 2;
+	if (attr_end > end)
+		return;
+
+	while (pos + 3 <= attr_end) {
+		flag = stream_getc_from(s, pos);
+		type = stream_getc_from(s, pos + 1);
+
+		if (CHECK_FLAG(flag, BGP_ATTR_FLAG_EXTLEN)) {
+			if (pos + 4 > attr_end)
+				break;
+			length = stream_getw_from(s, pos + 2);
+			pos += 4;
+		} else {
+			length = stream_getc_from(s, pos + 2);
+			pos += 3;
+		}
+		if (pos + length > attr_end)
+			break;
+
+		/* a repeated attribute is left to bgp_attr_parse() */
+		slot = bgp_update_parse_slot(type);
+		if (slot >= 0 && !parsed->aspath[slot].pos) {
+			stream_set_getp(s, pos);
+			parsed->aspath[slot].aspath = aspath_parse(
+				s, length, slot == 0 ? batch->use32bit : 1,
+				batch->asnotation);
+			parsed->aspath[slot].pos = pos;
+			parsed->aspath[slot].length = length;
+		}
+
+		pos += length;
+	}
+
+	stream_set_getp(s, 0);
+}
+
+void bgp_update_parse_queued(struct peer *peer)
+{
+	static struct stream *queued[BGP_UPDATE_PARSE_BATCH];
+	struct bgp_update_batch *batch;
+	struct stream *s;
+	unsigned int i, count = 0;
+
+	if (peer->parse_batch || bgp_update_parse_get_workers() < 2
+	    || !peer_established(peer))
+		return;
+
+	if (atomic_load_explicit(&peer->ibuf->count, memory_order_relaxed)
+	    < BGP_UPDATE_PARSE_MIN)
+		return;
+
+	/* The I/O pthread only appends to ibuf, and only this pthread takes
+	 * packets off it, so they stay put once the lock is dropped.
+	 */
+	frr_with_mutex (&peer->io_mtx) {
+		for (s = peer->ibuf->head; s && count < BGP_UPDATE_PARSE_BATCH;
+		     s = s->next)
+			if (stream_getc_from(s, BGP_MARKER_SIZE + 2)
+			    == BGP_MSG_UPDATE)
+				queued[count++] = s;
+	}
+
+	if (count < BGP_UPDATE_PARSE_MIN)
+		return;
+
+	batch = XCALLOC(MTYPE_BGP_UPDATE_PARSE,
+			sizeof(*batch) + count * sizeof(batch->parsed[0]));
+	for (i = 0; i < count; i++)
+		batch->parsed[i].s = queued[i];
+	batch->count = count;
+	batch->use32bit = CHECK_FLAG(peer->cap, PEER_CAP_AS4_RCV)
+			  && CHECK_FLAG(peer->cap, PEER_CAP_AS4_ADV);
+	batch->asnotation = bgp_get_asnotation(peer->bgp);
+
+	workpool_run(bgp_update_parse_pool(), bgp_update_parse_one, batch,
+		     count);
+
+	peer->parse_batch = batch;
+}
+
+static void bgp_update_parsed_release(struct bgp_update_parsed *parsed)
+{
+	int slot;
+
+	for (slot = 0; slot < BGP_UPDATE_PARSE_ASPATHS; slot++)
+		if (parsed->aspath[slot].aspath)
+			aspath_unintern(&parsed->aspath[slot].aspath);
+}
+
+void bgp_update_parse_flush(struct peer *peer)
+{
+	struct bgp_update_batch *batch = peer->parse_batch;
+	unsigned int i;
+
+	if (!batch)
+		return;
+
+	/* the current packet's entry is before 'next' */
+	if (peer->curr_parsed)
+		bgp_update_parsed_release(peer->curr_parsed);
+	for (i = batch->next; i < batch->count; i++)
+		bgp_update_parsed_release(&batch->parsed[i]);
+
+	peer->curr_parsed = NULL;
+	peer->parse_batch = NULL;
+	XFREE(MTYPE_BGP_UPDATE_PARSE, batch);
+}
+
+void bgp_update_parse_start(struct peer *peer)
+{
+	struct bgp_update_batch *batch = peer->parse_batch;
+
+	if (!batch)
+		return;
+
+	if (batch->parsed[batch->next].s == peer->curr) {
+		peer->curr_parsed = &batch->parsed[batch->next++];
+		return;
+	}
+
+	/* Other packet types aren't parsed ahead; an UPDATE that is not the
+	 * next one means ibuf was changed behind our back.
+	 */
+	if (stream_getc_from(peer->curr, BGP_MARKER_SIZE + 2)
+	    == BGP_MSG_UPDATE)
+		bgp_update_parse_flush(peer);
+}
+
+void bgp_update_parse_end(struct peer *peer)
+{
+	struct bgp_update_batch *batch = peer->parse_batch;
+
+	if (!peer->curr_parsed)
+		return;
+
+	bgp_update_parsed_release(peer->curr_parsed);
+	peer->curr_parsed = NULL;
+
+	if (batch->next == batch->count) {
+		peer->parse_batch = NULL;
+		XFREE(MTYPE_BGP_UPDATE_PARSE, batch);
+	}
+}
+
+struct aspath *bgp_update_parsed_aspath(struct peer *peer, uint8_t type,
+					size_t length, int use32bit,
+					enum asnotation_mode asnotation)
+{
+	struct bgp_update_parsed *parsed = peer->curr_parsed;
+	struct bgp_update_batch *batch = peer->parse_batch;
+	struct aspath *aspath;
+	int slot = bgp_update_parse_slot(type);
+
+	if (!parsed || slot < 0 || parsed->s != peer->curr)
+		return NULL;
+	if (parsed->aspath[slot].pos != stream_get_getp(peer->curr)
+	    || parsed->aspath[slot].length != length
+	    || !parsed->aspath[slot].aspath)
+		return NULL;
+	/* the capabilities can't change within a session, but anyway */
+	if ((slot == 0 && batch->use32bit != use32bit)
+	    || batch->asnotation != asnotation)
+		return NULL;
+
+	aspath = parsed->aspath[slot].aspath;
+	parsed->aspath[slot].aspath = NULL;
+	stream_forward_getp(peer->curr, length);
+
+	return aspath;
+}
+
+void bgp_update_parse_finish(void)
+{
+	workpool_free(&parse_pool);
+}
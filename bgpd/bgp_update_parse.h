@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/* BGP UPDATE parse worker pool.
+ * Parses the AS paths of a peer's queued UPDATE messages in parallel,
+ * ahead of bgp_update_receive().
+ */
+
+#ifndef _FRR_BGP_UPDATE_PARSE_H
+#define _FRR_BGP_UPDATE_PARSE_H
+
+#include "asn.h"
+#include "workpool.h"
+
+#define BGP_UPDATE_PARSE_WORKERS_DEFAULT 1
+#define BGP_UPDATE_PARSE_WORKERS_MAX WORKPOOL_WORKERS_MAX
+
+struct peer;
+struct aspath;
+
+/**
+ * Sets the number of pthreads parsing UPDATE messages, including the main
+ * pthread. With one worker everything is parsed in bgp_update_receive().
+ *
+ * May be called at any time from the main pthread.
+ */
+extern void bgp_update_parse_set_workers(unsigned int workers);
+
+/**
+ * Returns the configured number of workers, including the main pthread.
+ */
+extern unsigned int bgp_update_parse_get_workers(void);
+
+/**
+ * Parses the AS_PATH and AS4_PATH attributes of the UPDATEs queued on
+ * peer->ibuf on the worker pthreads, unless the last batch of the peer
+ * hasn't been processed yet. The AS paths are interned right away, which is
+ * safe on any pthread, cf. lib/intern.h; everything else is left for
+ * bgp_update_receive(). Only does anything with more than one worker and a
+ * long enough queue.
+ *
+ * Main pthread only, before taking the next packet off peer->ibuf.
+ */
+extern void bgp_update_parse_queued(struct peer *peer);
+
+/**
+ * Looks up what was parsed ahead for peer->curr, which was just taken off
+ * peer->ibuf, for bgp_update_parsed_aspath().
+ */
+extern void bgp_update_parse_start(struct peer *peer);
+
+/**
+ * Releases what was parsed ahead for peer->curr and not used.
+ */
+extern void bgp_update_parse_end(struct peer *peer);
+
+/**
+ * Returns the AS path attribute (BGP_ATTR_AS_PATH or BGP_ATTR_AS4_PATH) at
+ * the read position of peer->curr, if it was parsed ahead the same way, and
+ * forwards the stream past it. The result is the same as that of
+ * aspath_parse(peer->curr, length, use32bit, asnotation), including the
+ * reference held for the caller. Returns NULL if the attribute wasn't
+ * parsed ahead, or if it was malformed.
+ */
+extern struct aspath *bgp_update_parsed_aspath(struct peer *peer, uint8_t type,
+					       size_t length, int use32bit,
+					       enum asnotation_mode asnotation);
+
+/**
+ * Drops everything that was parsed ahead for a peer; needed whenever
+ * packets are removed from peer->ibuf other than by bgp_process_packet().
+ */
+extern void bgp_update_parse_flush(struct peer *peer);
+
+/**
+ * Stops all worker pthreads; used at shutdown.
+ */
+extern void bgp_update_parse_finish(void);
+
+#endif /* _FRR_BGP_UPDATE_PARSE_H */
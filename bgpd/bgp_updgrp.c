@@ -1087,6 +1087,7 @@ static void update_subgroup_delete(struct update_subgroup *subgrp)
 
 	THREAD_OFF(subgrp->t_merge_check);
 	THREAD_OFF(subgrp->t_coalesce);
+	subgroup_build_forget(subgrp);
 
 	bpacket_queue_cleanup(SUBGRP_PKTQ(subgrp));
 	subgroup_clear_table(subgrp);
@@ -90,6 +90,9 @@ struct bpacket {
 	struct stream *buffer;
 	bpacket_attr_vec_arr arr;
 
+	/* holds buffer once it is referenced from a peer's output queue */
+	struct bpacket_buf *shared;
+
 	unsigned int ver;
 };
 
@@ -156,6 +159,8 @@ struct update_group {
  */
 #define UPDGRP_INCR_STAT(subgrp, stat) UPDGRP_INCR_STAT_BY(subgrp, stat, 1)
 
+PREDECL_DLIST(subgrp_build);
+
 struct update_subgroup {
 	/* back pointer to the parent update group */
 	struct update_group *update_group;
@@ -202,6 +207,11 @@ struct update_subgroup {
 
 	struct thread *t_merge_check;
 
+	/* for being on the list of subgroups to build packets for on the
+	 * worker pthreads, see subgroup_build_pending()
+	 */
+	struct subgrp_build_item build_item;
+
 	/* table version that the subgroup has caught up to. */
 	uint64_t version;
 
@@ -251,6 +261,8 @@ struct update_subgroup {
 #define SUBGRP_FLAG_NEEDS_REFRESH (1 << 0)
 };
 
+DECLARE_DLIST(subgrp_build, struct update_subgroup, build_item);
+
 /*
  * Add the given value to the specified counter on a subgroup and its
  * parent structures.
@@ -402,8 +414,27 @@ extern void bpacket_queue_show_vty(struct bpacket_queue *q, struct vty *vty);
 bool subgroup_packets_to_build(struct update_subgroup *subgrp);
 extern struct bpacket *subgroup_update_packet(struct update_subgroup *s);
 extern struct bpacket *subgroup_withdraw_packet(struct update_subgroup *s);
+extern void subgroup_build_queue(struct update_subgroup *subgrp);
+extern void subgroup_build_forget(struct update_subgroup *subgrp);
+extern void subgroup_build_pending(void);
+
+#define BGP_UPDATE_ENCODE_WORKERS_DEFAULT 1
+
+/* Number of pthreads, including the main one, that subgroup_build_pending()
+ * encodes packets on.  With one worker packets are built by the peers as
+ * they pull them.
+ */
+extern void bgp_update_encode_set_workers(unsigned int workers);
+extern unsigned int bgp_update_encode_get_workers(void);
+extern void bgp_update_encode_finish(void);
 extern struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 						struct peer_af *paf);
+extern bool bpacket_ref_is(struct stream *s);
+extern size_t bpacket_ref_remain(struct stream *s);
+extern unsigned int bpacket_ref_iov(struct stream *s, struct iovec *iov);
+extern void bpacket_ref_forward(struct stream *s, size_t size);
+extern uint8_t bpacket_ref_type(struct stream *s);
+extern void bpacket_ref_free(struct stream *s);
 extern void bpacket_attr_vec_arr_reset(struct bpacket_attr_vec_arr *vecarr);
 extern void bpacket_attr_vec_arr_set_vec(struct bpacket_attr_vec_arr *vecarr,
 					 enum bpacket_attr_vec_type type,
@@ -542,6 +542,7 @@ void bgp_adj_out_set_subgroup(struct bgp_dest *dest,
 	}
 
 	bgp_adv_fifo_add_tail(&subgrp->sync->update, adv);
+	subgroup_build_queue(subgrp);
 
 	subgrp->version = MAX(subgrp->version, dest->version);
 }
@@ -590,6 +591,7 @@ void bgp_adj_out_unset_subgroup(struct bgp_dest *dest,
 			/* Add to synchronization entry for withdraw
 			 * announcement.  */
 			bgp_adv_fifo_add_tail(&subgrp->sync->withdraw, adv);
+			subgroup_build_queue(subgrp);
 
 			if (trigger_write)
 				subgroup_trigger_write(subgrp);
@@ -28,6 +28,8 @@
 #include "hash.h"
 #include "queue.h"
 #include "mpls.h"
+#include "frratomic.h"
+#include "workpool.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_debug.h"
@@ -43,6 +45,9 @@
 #include "bgpd/bgp_label.h"
 #include "bgpd/bgp_addpath.h"
 
+DEFINE_MTYPE_STATIC(BGPD, BGP_SUBGRP_BUILD, "BGP subgroup packet build");
+DEFINE_MTYPE_STATIC(BGPD, BGP_PACKET_BUF, "BGP shared packet buffer");
+
 /********************
  * PRIVATE FUNCTIONS
  ********************/
@@ -59,10 +64,15 @@ struct bpacket *bpacket_alloc(void)
 	return pkt;
 }
 
+static void bpacket_buf_unref(struct bpacket_buf *buf);
+
 void bpacket_free(struct bpacket *pkt)
 {
-	if (pkt->buffer)
+	if (pkt->shared)
+		bpacket_buf_unref(pkt->shared);
+	else if (pkt->buffer)
 		stream_free(pkt->buffer);
+	pkt->shared = NULL;
 	pkt->buffer = NULL;
 	XFREE(MTYPE_BGP_PACKET, pkt);
 }
@@ -329,27 +339,169 @@ void bpacket_queue_show_vty(struct bpacket_queue *q, struct vty *vty)
 	return;
 }
 
+/*
+ * A bpacket's buffer is shared by the peers it goes out to. bpacket_free()
+ * and every peer's reference each hold a count on it; whoever drops the
+ * last one frees it, which may be the I/O pthread.
+ */
+struct bpacket_buf {
+	atomic_uint refcnt;
+	struct stream *s;
+};
+
+/*
+ * What a peer's output queue holds for a shared packet, as the data of a
+ * small stream. The first byte tells it apart from a regular BGP message,
+ * which starts with an all-ones marker. Bytes [patch_off, patch_off +
+ * patch_len) of the packet are taken from patch[], which is where the
+ * peer's nexthop goes.
+ */
+#define BPACKET_REF_TAG 0x00
+#define BPACKET_REF_PATCH_MAX 48
+
+struct bpacket_ref {
+	uint8_t tag;
+	uint8_t patch_len;
+	uint16_t patch_off;
+	/* bytes written to the peer so far */
+	size_t sent;
+	struct bpacket_buf *buf;
+	uint8_t patch[BPACKET_REF_PATCH_MAX];
+};
+
+static void bpacket_buf_unref(struct bpacket_buf *buf)
+{
+	if (atomic_fetch_sub_explicit(&buf->refcnt, 1, memory_order_acq_rel)
+	    > 1)
+		return;
+
+	stream_free(buf->s);
+	XFREE(MTYPE_BGP_PACKET_BUF, buf);
+}
+
+static inline struct bpacket_ref *bpacket_ref_get(struct stream *s)
+{
+	return (struct bpacket_ref *)STREAM_DATA(s);
+}
+
+bool bpacket_ref_is(struct stream *s)
+{
+	return stream_get_endp(s) == sizeof(struct bpacket_ref)
+	       && bpacket_ref_get(s)->tag == BPACKET_REF_TAG;
+}
+
+static struct stream *bpacket_ref_new(struct bpacket *pkt, size_t patch_off,
+				      size_t patch_len, const uint8_t *patch)
+{
+	struct bpacket_ref ref = {
+		.tag = BPACKET_REF_TAG,
+		.patch_len = patch_len,
+		.patch_off = patch_off,
+	};
+	struct stream *s;
+
+	assert(patch_len <= sizeof(ref.patch));
+	assert(patch_off + patch_len <= stream_get_endp(pkt->buffer));
+
+	if (!pkt->shared) {
+		pkt->shared = XCALLOC(MTYPE_BGP_PACKET_BUF,
+				      sizeof(*pkt->shared));
+		pkt->shared->s = pkt->buffer;
+		atomic_store_explicit(&pkt->shared->refcnt, 1,
+				      memory_order_relaxed);
+	}
+	atomic_fetch_add_explicit(&pkt->shared->refcnt, 1,
+				  memory_order_relaxed);
+
+	ref.buf = pkt->shared;
+	if (patch_len)
+		memcpy(ref.patch, patch, patch_len);
+
+	s = stream_new(sizeof(ref));
+	stream_put(s, &ref, sizeof(ref));
+	return s;
+}
+
+size_t bpacket_ref_remain(struct stream *s)
+{
+	struct bpacket_ref *ref = bpacket_ref_get(s);
+
+	return stream_get_endp(ref->buf->s) - ref->sent;
+}
+
+unsigned int bpacket_ref_iov(struct stream *s, struct iovec *iov)
+{
+	struct bpacket_ref *ref = bpacket_ref_get(s);
+	uint8_t *data = STREAM_DATA(ref->buf->s);
+	size_t end = stream_get_endp(ref->buf->s);
+	size_t pos = ref->sent;
+	size_t patch_end = ref->patch_off + ref->patch_len;
+	unsigned int n = 0;
+
+	if (pos < ref->patch_off) {
+		iov[n].iov_base = data + pos;
+		iov[n++].iov_len = ref->patch_off - pos;
+		pos = ref->patch_off;
+	}
+	if (pos < patch_end) {
+		iov[n].iov_base = ref->patch + (pos - ref->patch_off);
+		iov[n++].iov_len = patch_end - pos;
+		pos = patch_end;
+	}
+	if (pos < end) {
+		iov[n].iov_base = data + pos;
+		iov[n++].iov_len = end - pos;
+	}
+	return n;
+}
+
+void bpacket_ref_forward(struct stream *s, size_t size)
+{
+	struct bpacket_ref *ref = bpacket_ref_get(s);
+
+	assert(ref->sent + size <= stream_get_endp(ref->buf->s));
+	ref->sent += size;
+}
+
+uint8_t bpacket_ref_type(struct stream *s)
+{
+	return stream_getc_from(bpacket_ref_get(s)->buf->s,
+				BGP_MARKER_SIZE + 2);
+}
+
+void bpacket_ref_free(struct stream *s)
+{
+	bpacket_buf_unref(bpacket_ref_get(s)->buf);
+	stream_free(s);
+}
+
+/*
+ * Returns what goes into the peer's output queue for pkt: a reference to the
+ * packet's buffer, with the nexthop patched in for this peer if needed.
+ */
 struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 					 struct peer_af *paf)
 {
-	struct stream *s = NULL;
 	bpacket_attr_vec *vec;
 	struct peer *peer;
 	struct bgp_filter *filter;
+	uint8_t nh[BPACKET_REF_PATCH_MAX];
+	size_t nh_pos;
 
-	s = stream_dup(pkt->buffer);
 	peer = PAF_PEER(paf);
 
 	vec = &pkt->arr.entries[BGP_ATTR_VEC_NH];
 
 	if (!CHECK_FLAG(vec->flags, BPKT_ATTRVEC_FLAGS_UPDATED))
-		return s;
+		return bpacket_ref_new(pkt, 0, 0, NULL);
 
 	uint8_t nhlen;
 	afi_t nhafi;
 	int route_map_sets_nh;
 
-	nhlen = stream_getc_from(s, vec->offset);
+	/* the nexthop field follows its length */
+	nhlen = stream_getc_from(pkt->buffer, vec->offset);
+	nh_pos = vec->offset + 1;
 	filter = &peer->filter[paf->afi][paf->safi];
 
 	if (peer_cap_enhe(peer, paf->afi, paf->safi))
@@ -360,7 +512,7 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 	if (nhafi == AFI_IP) {
 		struct in_addr v4nh, *mod_v4nh;
 		int nh_modified = 0;
-		size_t offset_nh = vec->offset + 1;
+		size_t offset_nh = 0;
 
 		route_map_sets_nh =
 			(CHECK_FLAG(vec->flags,
@@ -382,11 +534,11 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 				EC_BGP_INVALID_NEXTHOP_LENGTH,
 				"%s: %s: invalid MP nexthop length (AFI IP): %u",
 				__func__, peer->host, nhlen);
-			stream_free(s);
 			return NULL;
 		}
 
-		stream_get_from(&v4nh, s, offset_nh, IPV4_MAX_BYTELEN);
+		stream_get_from(nh, pkt->buffer, nh_pos, nhlen);
+		memcpy(&v4nh, nh + offset_nh, IPV4_MAX_BYTELEN);
 		mod_v4nh = &v4nh;
 
 		/*
@@ -431,9 +583,6 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 			nh_modified = 1;
 		}
 
-		if (nh_modified) /* allow for VPN RD */
-			stream_put_in_addr_at(s, offset_nh, mod_v4nh);
-
 		if (bgp_debug_update(peer, NULL, NULL, 0))
 			zlog_debug("u%" PRIu64 ":s%" PRIu64
 				   " %s send UPDATE w/ nexthop %pI4%s",
@@ -441,12 +590,19 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 				   PAF_SUBGRP(paf)->id, peer->host, mod_v4nh,
 				   (nhlen == BGP_ATTR_NHLEN_VPNV4 ? " and RD"
 								  : ""));
+
+		if (!nh_modified)
+			return bpacket_ref_new(pkt, 0, 0, NULL);
+
+		/* allow for VPN RD */
+		memcpy(nh + offset_nh, mod_v4nh, IPV4_MAX_BYTELEN);
+		return bpacket_ref_new(pkt, nh_pos, nhlen, nh);
 	} else if (nhafi == AFI_IP6) {
 		struct in6_addr v6nhglobal, *mod_v6nhg;
 		struct in6_addr v6nhlocal, *mod_v6nhl;
 		int gnh_modified, lnh_modified;
-		size_t offset_nhglobal = vec->offset + 1;
-		size_t offset_nhlocal = vec->offset + 1;
+		size_t offset_nhglobal = 0;
+		size_t offset_nhlocal = 0;
 
 		gnh_modified = lnh_modified = 0;
 		mod_v6nhg = &v6nhglobal;
@@ -486,12 +642,11 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 				EC_BGP_INVALID_NEXTHOP_LENGTH,
 				"%s: %s: invalid MP nexthop length (AFI IP6): %u",
 				__func__, peer->host, nhlen);
-			stream_free(s);
 			return NULL;
 		}
 
-		stream_get_from(&v6nhglobal, s, offset_nhglobal,
-				IPV6_MAX_BYTELEN);
+		stream_get_from(nh, pkt->buffer, nh_pos, nhlen);
+		memcpy(&v6nhglobal, nh + offset_nhglobal, IPV6_MAX_BYTELEN);
 
 		/*
 		 * Updates to an EBGP peer should only modify the
@@ -537,8 +692,8 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 
 		if (nhlen == BGP_ATTR_NHLEN_IPV6_GLOBAL_AND_LL
 		    || nhlen == BGP_ATTR_NHLEN_VPNV6_GLOBAL_AND_LL) {
-			stream_get_from(&v6nhlocal, s, offset_nhlocal,
-					IPV6_MAX_BYTELEN);
+			memcpy(&v6nhlocal, nh + offset_nhlocal,
+			       IPV6_MAX_BYTELEN);
 			if (IN6_IS_ADDR_UNSPECIFIED(&v6nhlocal)) {
 				mod_v6nhl = &peer->nexthop.v6_local;
 				lnh_modified = 1;
@@ -546,9 +701,11 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 		}
 
 		if (gnh_modified)
-			stream_put_in6_addr_at(s, offset_nhglobal, mod_v6nhg);
+			memcpy(nh + offset_nhglobal, mod_v6nhg,
+			       IPV6_MAX_BYTELEN);
 		if (lnh_modified)
-			stream_put_in6_addr_at(s, offset_nhlocal, mod_v6nhl);
+			memcpy(nh + offset_nhlocal, mod_v6nhl,
+			       IPV6_MAX_BYTELEN);
 
 		if (bgp_debug_update(peer, NULL, NULL, 0)) {
 			if (nhlen == BGP_ATTR_NHLEN_IPV6_GLOBAL_AND_LL
@@ -573,11 +730,15 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 						 ? " and RD"
 						 : ""));
 		}
+
+		if (!gnh_modified && !lnh_modified)
+			return bpacket_ref_new(pkt, 0, 0, NULL);
+		return bpacket_ref_new(pkt, nh_pos, nhlen, nh);
 	} else if (paf->afi == AFI_L2VPN) {
 		struct in_addr v4nh, *mod_v4nh;
 		int nh_modified = 0;
 
-		stream_get_from(&v4nh, s, vec->offset + 1, 4);
+		stream_get_from(&v4nh, pkt->buffer, nh_pos, IPV4_MAX_BYTELEN);
 		mod_v4nh = &v4nh;
 
 		/* No route-map changes allowed for EVPN nexthops. */
@@ -586,17 +747,18 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 			nh_modified = 1;
 		}
 
-		if (nh_modified)
-			stream_put_in_addr_at(s, vec->offset + 1, mod_v4nh);
-
 		if (bgp_debug_update(peer, NULL, NULL, 0))
 			zlog_debug("u%" PRIu64 ":s%" PRIu64
 				   " %s send UPDATE w/ nexthop %pI4",
 				   PAF_SUBGRP(paf)->update_group->id,
 				   PAF_SUBGRP(paf)->id, peer->host, mod_v4nh);
+
+		if (nh_modified)
+			return bpacket_ref_new(pkt, nh_pos, IPV4_MAX_BYTELEN,
+					       (uint8_t *)mod_v4nh);
 	}
 
-	return s;
+	return bpacket_ref_new(pkt, 0, 0, NULL);
 }
 
 /*
@@ -636,11 +798,154 @@ bool subgroup_packets_to_build(struct update_subgroup *subgrp)
 	return false;
 }
 
-/* Make BGP update packet.  */
-struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
+/*
+ * Packets are built in two steps. subgroup_withdraw_encode() and
+ * subgroup_update_encode() walk the subgroup's advertisement FIFOs and encode
+ * packets; they change nothing but the subgroup's work streams and the
+ * advertisements' 'encoded' mark, and keep track of what they took in a
+ * struct subgroup_build. subgroup_build_apply() then brings the adj-out
+ * entries in line with what was encoded and queues the packets.
+ *
+ * The encode step for different subgroups can thus run on the worker
+ * pthreads, see subgroup_build_pending().
+ */
+static struct workpool *encode_pool;
+
+static struct workpool *bgp_update_encode_pool(void)
+{
+	if (!encode_pool)
+		encode_pool = workpool_new("BGP UPDATE encoder", "bgpd_enc");
+	return encode_pool;
+}
+
+void bgp_update_encode_set_workers(unsigned int workers)
 {
+	workpool_set_workers(bgp_update_encode_pool(), workers);
+}
+
+unsigned int bgp_update_encode_get_workers(void)
+{
+	return workpool_get_workers(bgp_update_encode_pool());
+}
+
+void bgp_update_encode_finish(void)
+{
+	workpool_free(&encode_pool);
+}
+
+struct subgroup_build_pkt {
+	struct stream *s;
+	struct bpacket_attr_vec_arr vecarr;
+	bool withdraw;
+};
+
+struct subgroup_build {
+	struct update_subgroup *subgrp;
+
+	/* encoded packets, at most 'room' */
+	struct subgroup_build_pkt *pkts;
+	unsigned int npkts;
+	unsigned int room;
+
+	/* advertisements that went into the packets */
+	struct bgp_advertise **advs;
+	size_t nadvs;
+	size_t advs_size;
+
+	/* update advertisements whose attributes are too long to send */
+	struct bgp_advertise *dropped;
+
+	/* first advertisement not encoded yet, for each FIFO */
+	struct bgp_advertise *wcursor;
+	struct bgp_advertise *ucursor;
+
+	/* where the last update packet stopped in its attribute's list */
+	struct bgp_advertise_attr *sib_baa;
+	struct bgp_advertise *sib_next;
+};
+
+static void subgroup_build_init(struct subgroup_build *b,
+				struct update_subgroup *subgrp,
+				unsigned int room)
+{
+	memset(b, 0, sizeof(*b));
+	b->subgrp = subgrp;
+	b->room = room;
+	b->wcursor = bgp_adv_fifo_first(&subgrp->sync->withdraw);
+	b->ucursor = bgp_adv_fifo_first(&subgrp->sync->update);
+}
+
+static void subgroup_build_take(struct subgroup_build *b,
+				struct bgp_advertise *adv)
+{
+	if (b->nadvs == b->advs_size) {
+		b->advs_size = MAX(b->advs_size * 2, 64);
+		b->advs = XREALLOC(MTYPE_BGP_SUBGRP_BUILD, b->advs,
+				   b->advs_size * sizeof(*b->advs));
+	}
+	b->advs[b->nadvs++] = adv;
+	adv->encoded = true;
+}
+
+static void subgroup_build_add_pkt(struct subgroup_build *b, struct stream *s,
+				   struct bpacket_attr_vec_arr *vecarr)
+{
+	struct subgroup_build_pkt *bpkt;
+
+	b->pkts = XREALLOC(MTYPE_BGP_SUBGRP_BUILD, b->pkts,
+			   (b->npkts + 1) * sizeof(*b->pkts));
+	bpkt = &b->pkts[b->npkts++];
+	bpkt->s = s;
+	bpkt->withdraw = !vecarr;
+	if (vecarr)
+		bpkt->vecarr = *vecarr;
+}
+
+/*
+ * First update advertisement of a packet: the oldest one that hasn't been
+ * encoded.
+ */
+static struct bgp_advertise *subgroup_update_first(struct subgroup_build *b)
+{
+	while (b->ucursor && b->ucursor->encoded)
+		b->ucursor = bgp_adv_fifo_next(&b->subgrp->sync->update,
+					       b->ucursor);
+	return b->ucursor;
+}
+
+/*
+ * Next update advertisement to put into the packet after adv, one with the
+ * same attributes. This is the order bgp_advertise_clean_subgroup() would
+ * hand them out in if adv had been cleaned up: the head of the attribute's
+ * list once adv is out of it.
+ */
+static struct bgp_advertise *subgroup_update_next(struct subgroup_build *b,
+						  struct bgp_advertise *adv,
+						  bool first)
+{
+	struct bgp_advertise *next;
+
+	if (!first)
+		next = adv->next;
+	else if (adv->baa == b->sib_baa)
+		/* everything before sib_next has been encoded */
+		next = b->sib_next;
+	else
+		next = adv->baa->adv;
+
+	while (next && next->encoded)
+		next = next->next;
+
+	b->sib_baa = adv->baa;
+	b->sib_next = next;
+	return next;
+}
+
+/* Encode a BGP update packet.  */
+static bool subgroup_update_encode(struct subgroup_build *b)
+{
+	struct update_subgroup *subgrp = b->subgrp;
 	struct bpacket_attr_vec_arr vecarr;
-	struct bpacket *pkt;
 	struct peer *peer;
 	struct stream *s;
 	struct stream *snlri;
@@ -666,12 +971,7 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 	struct prefix_rd *prd = NULL;
 	mpls_label_t label = MPLS_INVALID_LABEL, *label_pnt = NULL;
 	uint32_t num_labels = 0;
-
-	if (!subgrp)
-		return NULL;
-
-	if (bpacket_queue_is_full(SUBGRP_INST(subgrp), SUBGRP_PKTQ(subgrp)))
-		return NULL;
+	bool first = true;
 
 	peer = SUBGRP_PEER(subgrp);
 	afi = SUBGRP_AFI(subgrp);
@@ -686,7 +986,7 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 	addpath_capable = bgp_addpath_encode_tx(peer, afi, safi);
 	addpath_overhead = addpath_capable ? BGP_ADDPATH_ID_LEN : 0;
 
-	adv = bgp_adv_fifo_first(&subgrp->sync->update);
+	adv = subgroup_update_first(b);
 	while (adv) {
 		const struct prefix *dest_p;
 
@@ -758,11 +1058,12 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 					"u%" PRIu64 ":s%" PRIu64" attributes too long, cannot send UPDATE",
 					subgrp->update_group->id, subgrp->id);
 
-				/* Flush the FIFO update queue */
-				while (adv)
-					adv = bgp_advertise_clean_subgroup(
-						subgrp, adj);
-				return NULL;
+				/* Flushed from the FIFO update queue when
+				 * applied
+				 */
+				b->dropped = adv;
+				stream_reset(s);
+				return false;
 			}
 
 			if (BGP_DEBUG(update, UPDATE_OUT)
@@ -842,14 +1143,10 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 				   pfx_buf);
 		}
 
-		/* Synchnorize attribute.  */
-		if (adj->attr)
-			bgp_attr_unintern(&adj->attr);
-		else
-			subgrp->scount++;
-
-		adj->attr = bgp_attr_intern(adv->baa->attr);
-		adv = bgp_advertise_clean_subgroup(subgrp, adj);
+		/* Attribute is synchronized when applied */
+		subgroup_build_take(b, adv);
+		adv = subgroup_update_next(b, adv, first);
+		first = false;
 	}
 
 	if (!stream_empty(s)) {
@@ -875,15 +1172,15 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 				(stream_get_endp(packet)
 				 - stream_get_getp(packet)),
 				peer->max_packet_size, num_pfx);
-		pkt = bpacket_queue_add(SUBGRP_PKTQ(subgrp), packet, &vecarr);
+		subgroup_build_add_pkt(b, packet, &vecarr);
 		stream_reset(s);
 		stream_reset(snlri);
-		return pkt;
+		return true;
 	}
-	return NULL;
+	return false;
 }
 
-/* Make BGP withdraw packet.  */
+/* Encode a BGP withdraw packet.  */
 /* For ipv4 unicast:
    16-octet marker | 2-octet length | 1-octet type |
     2-octet withdrawn route length | withdrawn prefixes | 2-octet attrlen (=0)
@@ -893,9 +1190,9 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
     2-octet withdrawn route length (=0) | 2-octet attrlen |
      mp_unreach attr type | attr len | afi | safi | withdrawn prefixes
 */
-struct bpacket *subgroup_withdraw_packet(struct update_subgroup *subgrp)
+static bool subgroup_withdraw_encode(struct subgroup_build *b)
 {
-	struct bpacket *pkt;
+	struct update_subgroup *subgrp = b->subgrp;
 	struct stream *s;
 	struct bgp_adj_out *adj;
 	struct bgp_advertise *adv;
@@ -917,13 +1214,6 @@ struct bpacket *subgroup_withdraw_packet(struct update_subgroup *subgrp)
 	uint32_t addpath_tx_id = 0;
 	const struct prefix_rd *prd = NULL;
 
-
-	if (!subgrp)
-		return NULL;
-
-	if (bpacket_queue_is_full(SUBGRP_INST(subgrp), SUBGRP_PKTQ(subgrp)))
-		return NULL;
-
 	peer = SUBGRP_PEER(subgrp);
 	afi = SUBGRP_AFI(subgrp);
 	safi = SUBGRP_SAFI(subgrp);
@@ -932,7 +1222,7 @@ struct bpacket *subgroup_withdraw_packet(struct update_subgroup *subgrp)
 	addpath_capable = bgp_addpath_encode_tx(peer, afi, safi);
 	addpath_overhead = addpath_capable ? BGP_ADDPATH_ID_LEN : 0;
 
-	while ((adv = bgp_adv_fifo_first(&subgrp->sync->withdraw)) != NULL) {
+	while ((adv = b->wcursor) != NULL) {
 		const struct prefix *dest_p;
 
 		assert(adv->dest);
@@ -1010,9 +1300,9 @@ struct bpacket *subgroup_withdraw_packet(struct update_subgroup *subgrp)
 				   pfx_buf);
 		}
 
-		subgrp->scount--;
-
-		bgp_adj_out_remove_subgroup(dest, adj, subgrp);
+		/* adj-out is removed when applied */
+		subgroup_build_take(b, adv);
+		b->wcursor = bgp_adv_fifo_next(&subgrp->sync->withdraw, adv);
 	}
 
 	if (!stream_empty(s)) {
@@ -1036,13 +1326,216 @@ struct bpacket *subgroup_withdraw_packet(struct update_subgroup *subgrp)
 				   subgrp->update_group->id, subgrp->id,
 				   (stream_get_endp(s) - stream_get_getp(s)),
 				   num_pfx);
-		pkt = bpacket_queue_add(SUBGRP_PKTQ(subgrp), stream_dup(s),
-					NULL);
+		subgroup_build_add_pkt(b, stream_dup(s), NULL);
 		stream_reset(s);
-		return pkt;
+		return true;
+	}
+
+	return false;
+}
+
+/*
+ * Bring the adj-out entries in line with the encoded packets and queue them.
+ * Returns the first packet queued, if any.
+ */
+static struct bpacket *subgroup_build_apply(struct subgroup_build *b)
+{
+	struct update_subgroup *subgrp = b->subgrp;
+	struct bgp_advertise *adv;
+	struct bgp_adj_out *adj;
+	struct bpacket *pkt, *first = NULL;
+	struct subgroup_build_pkt *bpkt;
+	size_t i;
+
+	for (i = 0; i < b->nadvs; i++) {
+		adv = b->advs[i];
+		adj = adv->adj;
+
+		if (!adv->baa) {
+			subgrp->scount--;
+			bgp_adj_out_remove_subgroup(adv->dest, adj, subgrp);
+			continue;
+		}
+
+		/* Synchnorize attribute.  */
+		if (adj->attr)
+			bgp_attr_unintern(&adj->attr);
+		else
+			subgrp->scount++;
+
+		adj->attr = bgp_attr_intern(adv->baa->attr);
+		bgp_advertise_clean_subgroup(subgrp, adj);
+	}
+
+	/* Flush the FIFO update queue */
+	adv = b->dropped;
+	while (adv)
+		adv = bgp_advertise_clean_subgroup(subgrp, adv->adj);
+
+	for (i = 0; i < b->npkts; i++) {
+		bpkt = &b->pkts[i];
+		pkt = bpacket_queue_add(SUBGRP_PKTQ(subgrp), bpkt->s,
+					bpkt->withdraw ? NULL : &bpkt->vecarr);
+		if (!first)
+			first = pkt;
+	}
+
+	XFREE(MTYPE_BGP_SUBGRP_BUILD, b->advs);
+	XFREE(MTYPE_BGP_SUBGRP_BUILD, b->pkts);
+	return first;
+}
+
+/* Make BGP update packet.  */
+struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
+{
+	struct subgroup_build b;
+
+	if (!subgrp)
+		return NULL;
+
+	if (bpacket_queue_is_full(SUBGRP_INST(subgrp), SUBGRP_PKTQ(subgrp)))
+		return NULL;
+
+	subgroup_build_init(&b, subgrp, 1);
+	subgroup_update_encode(&b);
+	return subgroup_build_apply(&b);
+}
+
+/* Make BGP withdraw packet.  */
+struct bpacket *subgroup_withdraw_packet(struct update_subgroup *subgrp)
+{
+	struct subgroup_build b;
+
+	if (!subgrp)
+		return NULL;
+
+	if (bpacket_queue_is_full(SUBGRP_INST(subgrp), SUBGRP_PKTQ(subgrp)))
+		return NULL;
+
+	subgroup_build_init(&b, subgrp, 1);
+	subgroup_withdraw_encode(&b);
+	return subgroup_build_apply(&b);
+}
+
+/* Encode as many packets as the subgroup's queue has room for */
+static void subgroup_build_encode(struct subgroup_build *b)
+{
+	/* Withdraws go out first, see bgp_generate_updgrp_packets() */
+	while (b->npkts < b->room && subgroup_withdraw_encode(b))
+		;
+	while (b->npkts < b->room && subgroup_update_encode(b))
+		;
+}
+
+static void subgroup_build_job(void *arg, size_t idx)
+{
+	struct subgroup_build *builds = arg;
+
+	subgroup_build_encode(&builds[idx]);
+}
+
+/* Subgroups that had advertisements queued since their packets were last
+ * built, see subgroup_build_queue()
+ */
+static struct subgrp_build_head subgrp_build_pending =
+	INIT_DLIST(subgrp_build_pending);
+
+void subgroup_build_queue(struct update_subgroup *subgrp)
+{
+	if (bgp_update_encode_get_workers() <= 1
+	    || subgrp_build_anywhere(subgrp))
+		return;
+
+	subgrp_build_add_tail(&subgrp_build_pending, subgrp);
+}
+
+void subgroup_build_forget(struct update_subgroup *subgrp)
+{
+	if (subgrp_build_anywhere(subgrp))
+		subgrp_build_del(&subgrp_build_pending, subgrp);
+}
+
+/*
+ * Packets are only built ahead for a subgroup if one of its peers is going to
+ * take them right away. While MRAI or update-delay hold the peers back,
+ * advertisements keep coalescing in the FIFOs, and the subgroup stays
+ * pending; without any established peer it's left to the regular path.
+ */
+static bool subgroup_build_ready(struct update_subgroup *subgrp, bool *wait)
+{
+	struct bgp *bgp = SUBGRP_INST(subgrp);
+	struct peer_af *paf;
+	struct peer *peer;
+
+	*wait = false;
+
+	SUBGRP_FOREACH_PEER (subgrp, paf) {
+		peer = PAF_PEER(paf);
+		if (!peer_established(peer))
+			continue;
+
+		*wait = true;
+		if (bgp->main_peers_update_hold || bgp_update_delay_active(bgp))
+			return false;
+		if (!peer->t_routeadv && peer->obuf->count < bm->outq_limit)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Build packets for all pending subgroups whose peers are ready for them.
+ * The packets are encoded on the UPDATE encode worker pthreads, the
+ * main pthread then updates the adj-outs and queues the packets in subgroup
+ * order. The peers pull them from their subgroups' queues as usual.
+ */
+void subgroup_build_pending(void)
+{
+	struct update_subgroup *subgrp;
+	struct subgroup_build *builds;
+	struct bpacket_queue *q;
+	unsigned int queue_max;
+	size_t n = 0, i;
+	bool wait;
+
+	if (!subgrp_build_count(&subgrp_build_pending))
+		return;
+
+	builds = XCALLOC(MTYPE_BGP_SUBGRP_BUILD,
+			 subgrp_build_count(&subgrp_build_pending)
+				 * sizeof(*builds));
+
+	frr_each_safe (subgrp_build, &subgrp_build_pending, subgrp) {
+		if (!subgroup_build_ready(subgrp, &wait) && wait)
+			continue;
+
+		subgrp_build_del(&subgrp_build_pending, subgrp);
+		if (!wait || !subgroup_packets_to_build(subgrp))
+			continue;
+
+		q = SUBGRP_PKTQ(subgrp);
+		queue_max = SUBGRP_INST(subgrp)->default_subgroup_pkt_queue_max;
+		if (q->curr_count >= queue_max)
+			continue;
+
+		subgroup_build_init(&builds[n++], subgrp,
+				    queue_max - q->curr_count);
+	}
+
+	if (n) {
+		workpool_run(bgp_update_encode_pool(), subgroup_build_job, builds,
+			     n);
+
+		for (i = 0; i < n; i++)
+			subgroup_build_apply(&builds[i]);
+
+		if (BGP_DEBUG(update, UPDATE_OUT))
+			zlog_debug("%s: built packets for %zu subgroups",
+				   __func__, n);
 	}
 
-	return NULL;
+	XFREE(MTYPE_BGP_SUBGRP_BUILD, builds);
 }
 
 void subgroup_default_update_packet(struct update_subgroup *subgrp,
@@ -61,6 +61,8 @@
 #include "bgpd/bgp_mac.h"
 #include "bgpd/bgp_flowspec.h"
 #include "bgpd/bgp_conditional_adv.h"
+#include "bgpd/bgp_select.h"
+#include "bgpd/bgp_update_parse.h"
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/bgp_rfapi_cfg.h"
 #endif
@@ -10733,6 +10735,7 @@ DEFUN (show_bgp_memory,
 {
 	char memstrbuf[MTYPE_MEMSTR_LEN];
 	unsigned long count;
+	size_t paths, bytes;
 
 	/* RIB related usage stats */
 	count = mtype_stats_alloc(MTYPE_BGP_NODE);
@@ -10740,10 +10743,14 @@ DEFUN (show_bgp_memory,
 		mtype_memstr(memstrbuf, sizeof(memstrbuf),
 			     count * sizeof(struct bgp_dest)));
 
-	count = mtype_stats_alloc(MTYPE_BGP_ROUTE);
-	vty_out(vty, "%ld BGP routes, using %s of memory\n", count,
-		mtype_memstr(memstrbuf, sizeof(memstrbuf),
-			     count * sizeof(struct bgp_path_info)));
+	/* paths are slab allocated, report what the slabs take up */
+	bgp_path_slab_stats_get(&paths, &bytes);
+	vty_out(vty, "%zu BGP routes, using %s of memory\n", paths,
+		mtype_memstr(memstrbuf, sizeof(memstrbuf), bytes));
+	if (paths)
+		vty_out(vty,
+			"  %zu bytes per route, for a %zu byte route structure\n",
+			bytes / paths, sizeof(struct bgp_path_info));
 	if ((count = mtype_stats_alloc(MTYPE_BGP_ROUTE_EXTRA)))
 		vty_out(vty, "%ld BGP route ancillaries, using %s of memory\n",
 			count,
@@ -18165,6 +18172,21 @@ int bgp_config_write(struct vty *vty)
 	if (bm->outq_limit != BM_DEFAULT_Q_LIMIT)
 		vty_out(vty, "bgp output-queue-limit %u\n", bm->outq_limit);
 
+	/* BGP best path selection workers */
+	if (bgp_select_get_workers() != BGP_SELECT_WORKERS_DEFAULT)
+		vty_out(vty, "bgp bestpath-workers %u\n",
+			bgp_select_get_workers());
+
+	/* BGP UPDATE encode workers */
+	if (bgp_update_encode_get_workers() != BGP_UPDATE_ENCODE_WORKERS_DEFAULT)
+		vty_out(vty, "bgp update-encode-workers %u\n",
+			bgp_update_encode_get_workers());
+
+	/* BGP UPDATE parse workers */
+	if (bgp_update_parse_get_workers() != BGP_UPDATE_PARSE_WORKERS_DEFAULT)
+		vty_out(vty, "bgp update-parse-workers %u\n",
+			bgp_update_parse_get_workers());
+
 	/* BGP configuration. */
 	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
 
@@ -18909,6 +18931,81 @@ DEFPY (no_bgp_inq_limit,
 	return CMD_SUCCESS;
 }
 
+DEFPY (bgp_bestpath_workers,
+       bgp_bestpath_workers_cmd,
+       "bgp bestpath-workers (1-64)$workers",
+       BGP_STR
+       "Set the number of pthreads used for best path selection\n"
+       "Number of pthreads, including the main one\n")
+{
+	bgp_select_set_workers(workers);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_bestpath_workers,
+       no_bgp_bestpath_workers_cmd,
+       "no bgp bestpath-workers [(1-64)$workers]",
+       NO_STR
+       BGP_STR
+       "Set the number of pthreads used for best path selection\n"
+       "Number of pthreads, including the main one\n")
+{
+	bgp_select_set_workers(BGP_SELECT_WORKERS_DEFAULT);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (bgp_update_encode_workers,
+       bgp_update_encode_workers_cmd,
+       "bgp update-encode-workers (1-64)$workers",
+       BGP_STR
+       "Set the number of pthreads used for encoding UPDATEs to send\n"
+       "Number of pthreads, including the main one\n")
+{
+	bgp_update_encode_set_workers(workers);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_update_encode_workers,
+       no_bgp_update_encode_workers_cmd,
+       "no bgp update-encode-workers [(1-64)$workers]",
+       NO_STR
+       BGP_STR
+       "Set the number of pthreads used for encoding UPDATEs to send\n"
+       "Number of pthreads, including the main one\n")
+{
+	bgp_update_encode_set_workers(BGP_UPDATE_ENCODE_WORKERS_DEFAULT);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (bgp_update_parse_workers,
+       bgp_update_parse_workers_cmd,
+       "bgp update-parse-workers (1-64)$workers",
+       BGP_STR
+       "Set the number of pthreads used for parsing received UPDATEs\n"
+       "Number of pthreads, including the main one\n")
+{
+	bgp_update_parse_set_workers(workers);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_update_parse_workers,
+       no_bgp_update_parse_workers_cmd,
+       "no bgp update-parse-workers [(1-64)$workers]",
+       NO_STR
+       BGP_STR
+       "Set the number of pthreads used for parsing received UPDATEs\n"
+       "Number of pthreads, including the main one\n")
+{
+	bgp_update_parse_set_workers(BGP_UPDATE_PARSE_WORKERS_DEFAULT);
+
+	return CMD_SUCCESS;
+}
+
 DEFPY (bgp_outq_limit,
        bgp_outq_limit_cmd,
        "bgp output-queue-limit (1-4294967295)$limit",
@@ -18989,6 +19086,12 @@ void bgp_vty_init(void)
 	install_element(CONFIG_NODE, &no_bgp_inq_limit_cmd);
 	install_element(CONFIG_NODE, &bgp_outq_limit_cmd);
 	install_element(CONFIG_NODE, &no_bgp_outq_limit_cmd);
+	install_element(CONFIG_NODE, &bgp_bestpath_workers_cmd);
+	install_element(CONFIG_NODE, &no_bgp_bestpath_workers_cmd);
+	install_element(CONFIG_NODE, &bgp_update_encode_workers_cmd);
+	install_element(CONFIG_NODE, &no_bgp_update_encode_workers_cmd);
+	install_element(CONFIG_NODE, &bgp_update_parse_workers_cmd);
+	install_element(CONFIG_NODE, &no_bgp_update_parse_workers_cmd);
 
 	/* "bgp local-mac" hidden commands. */
 	install_element(CONFIG_NODE, &bgp_local_mac_cmd);
@@ -1696,8 +1696,8 @@ void bgp_zebra_announce(struct bgp_dest *dest, const struct prefix *p,
 		zlog_debug("%s: %pFX: announcing to zebra (recursion %sset)",
 			   __func__, p, (recursion_flag ? "" : "NOT "));
 	}
-	zclient_route_send(is_add ? ZEBRA_ROUTE_ADD : ZEBRA_ROUTE_DELETE,
-			   zclient, &api);
+	zclient_route_send_bulk(is_add ? ZEBRA_ROUTE_ADD : ZEBRA_ROUTE_DELETE,
+				zclient, &api);
 }
 
 /* Announce all routes of a table to zebra */
@@ -1787,7 +1787,7 @@ void bgp_zebra_withdraw(const struct prefix *p, struct bgp_path_info *info,
 		zlog_debug("Tx route delete VRF %u %pFX", bgp->vrf_id,
 			   &api.prefix);
 
-	zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
+	zclient_route_send_bulk(ZEBRA_ROUTE_DELETE, zclient, &api);
 }
 
 /* Withdraw all entries in a BGP instances RIB table from Zebra */
@@ -68,6 +68,8 @@
 #include "bgpd/bgp_memory.h"
 #include "bgpd/bgp_evpn_vty.h"
 #include "bgpd/bgp_keepalives.h"
+#include "bgpd/bgp_select.h"
+#include "bgpd/bgp_update_parse.h"
 #include "bgpd/bgp_io.h"
 #include "bgpd/bgp_ecommunity.h"
 #include "bgpd/bgp_flowspec.h"
@@ -2593,12 +2595,14 @@ int peer_delete(struct peer *peer)
 	}
 
 	/* Buffers.  */
+	bgp_update_parse_flush(peer);
 	if (peer->ibuf) {
 		stream_fifo_free(peer->ibuf);
 		peer->ibuf = NULL;
 	}
 
 	if (peer->obuf) {
+		bgp_obuf_clean(peer->obuf);
 		stream_fifo_free(peer->obuf);
 		peer->obuf = NULL;
 	}
@@ -3940,6 +3944,7 @@ void bgp_free(struct bgp *bgp)
 		rmap = &bgp->table_map[afi][safi];
 		XFREE(MTYPE_ROUTE_MAP_NAME, rmap->name);
 	}
+	bgp_path_slabs_free(bgp);
 
 	bgp_scan_finish(bgp);
 	bgp_address_destroy(bgp);
@@ -8151,6 +8156,9 @@ void bgp_pthreads_run(void)
 
 void bgp_pthreads_finish(void)
 {
+	bgp_select_finish();
+	bgp_update_parse_finish();
+	bgp_update_encode_finish();
 	frr_pthread_stop_all();
 }
 
@@ -43,6 +43,9 @@
 struct update_subgroup;
 struct bpacket;
 struct bgp_pbr_config;
+struct slab;
+struct bgp_update_batch;
+struct bgp_update_parsed;
 
 /*
  * Allow the neighbor XXXX remote-as to take internal or external
@@ -559,6 +562,9 @@ struct bgp {
 	/* BGP routing information base.  */
 	struct bgp_table *rib[AFI_MAX][SAFI_MAX];
 
+	/* bgp_path_info allocations for all tables of an afi/safi */
+	struct slab *path_slab[AFI_MAX][SAFI_MAX];
+
 	/* BGP table route-map.  */
 	struct bgp_rmap table_map[AFI_MAX][SAFI_MAX];
 
@@ -1149,6 +1155,12 @@ struct peer {
 
 	struct stream *curr; // the current packet being parsed
 
+	/* UPDATEs on ibuf whose AS paths were parsed by the parse workers,
+	 * and the entry of curr; cf. bgp_update_parse.c
+	 */
+	struct bgp_update_batch *parse_batch;
+	struct bgp_update_parsed *curr_parsed;
+
 	/* We use a separate stream to encode MP_REACH_NLRI for efficient
 	 * NLRI packing. peer->obuf_work stores all the other attributes. The
 	 * actual packet is then constructed by concatenating the two.
@@ -464,8 +464,8 @@ void rfapiPrintAttrPtrs(void *stream, struct attr *attr)
 	/* IPv4 Nexthop */
 	fp(out, "  nexthop=%pI4%s", &attr->nexthop, HVTYNL);
 
-	fp(out, "  aspath=%p, refcnt=%d%s", attr->aspath,
-	   (attr->aspath ? attr->aspath->refcnt : 0), HVTYNL);
+	fp(out, "  aspath=%p, refcnt=%lu%s", attr->aspath,
+	   (attr->aspath ? aspath_refcnt(attr->aspath) : 0), HVTYNL);
 
 	comm = bgp_attr_get_community(attr);
 	fp(out, "  community=%p, refcnt=%d%s", comm, (comm ? comm->refcnt : 0),
@@ -476,8 +476,8 @@ void rfapiPrintAttrPtrs(void *stream, struct attr *attr)
 	   (ecomm ? ecomm->refcnt : 0), HVTYNL);
 
 	cluster = bgp_attr_get_cluster(attr);
-	fp(out, "  cluster=%p, refcnt=%d%s", cluster,
-	   (cluster ? cluster->refcnt : 0), HVTYNL);
+	fp(out, "  cluster=%p, refcnt=%lu%s", cluster,
+	   (cluster ? cluster_refcnt(cluster) : 0), HVTYNL);
 
 	transit = bgp_attr_get_transit(attr);
 	fp(out, "  transit=%p, refcnt=%d%s", transit,
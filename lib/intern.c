@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Concurrent intern (deduplication) table
+ */
+
+#include <zebra.h>
+
+#include "intern.h"
+#include "frr_pthread.h"
+#include "memory.h"
+
+DEFINE_MTYPE_STATIC(LIB, INTERN_BUCKETS, "Intern table buckets");
+
+#define INTERN_MIN_BUCKETS 64
+
+struct intern_buckets {
+	struct rcu_head rcu_head;
+	size_t mask;
+	atomic_uintptr_t b[];
+};
+
+static struct intern_buckets *intern_buckets_new(size_t size)
+{
+	struct intern_buckets *bk;
+	size_t i;
+
+	bk = XCALLOC(MTYPE_INTERN_BUCKETS,
+		     sizeof(*bk) + size * sizeof(bk->b[0]));
+	bk->mask = size - 1;
+	for (i = 0; i < size; i++)
+		atomic_store_explicit(&bk->b[i], (uintptr_t)NULL,
+				      memory_order_relaxed);
+	return bk;
+}
+
+static inline struct intern_buckets *
+intern_buckets_get(struct intern_table *table)
+{
+	return (struct intern_buckets *)atomic_load_explicit(
+		&table->buckets, memory_order_acquire);
+}
+
+static inline struct intern_item *intern_next(atomic_uintptr_t *ptr)
+{
+	return (struct intern_item *)atomic_load_explicit(
+		ptr, memory_order_acquire);
+}
+
+static inline void *intern_data(struct intern_item *item)
+{
+	return (char *)item - item->ops->offset;
+}
+
+/* a reference can only be taken while at least one other is held;  once the
+ * count has hit zero the item is on its way out and must not be revived.
+ */
+static bool intern_tryref(struct intern_item *item)
+{
+	uint_fast32_t cnt;
+
+	cnt = atomic_load_explicit(&item->refcnt, memory_order_relaxed);
+	do {
+		if (cnt == 0)
+			return false;
+	} while (!atomic_compare_exchange_weak_explicit(
+		&item->refcnt, &cnt, cnt + 1, memory_order_acquire,
+		memory_order_relaxed));
+	return true;
+}
+
+static struct intern_item *intern_find(struct intern_buckets *bk,
+				       const struct intern_ops *ops,
+				       uint32_t hashval, const void *key)
+{
+	struct intern_item *item;
+
+	for (item = intern_next(&bk->b[hashval & bk->mask]); item;
+	     item = intern_next(&item->next)) {
+		if (item->hashval != hashval)
+			continue;
+		if (!ops->hash_cmp(intern_data(item), key))
+			continue;
+		if (intern_tryref(item))
+			return item;
+	}
+	return NULL;
+}
+
+/* mutex held.  Items are relinked into the new array one by one while the
+ * old array is still published;  a lock-free reader racing with this can
+ * miss an item, which is fine since it then retries under the mutex.
+ */
+static void intern_grow(struct intern_table *table, struct intern_buckets *old)
+{
+	struct intern_buckets *bk;
+	struct intern_item *item, *next;
+	size_t i;
+
+	bk = intern_buckets_new((old->mask + 1) * 2);
+
+	for (i = 0; i <= old->mask; i++) {
+		for (item = intern_next(&old->b[i]); item; item = next) {
+			atomic_uintptr_t *head = &bk->b[item->hashval & bk->mask];
+
+			next = intern_next(&item->next);
+			atomic_store_explicit(&item->next,
+					      atomic_load_explicit(
+						      head, memory_order_relaxed),
+					      memory_order_relaxed);
+			atomic_store_explicit(head, (uintptr_t)item,
+					      memory_order_release);
+		}
+	}
+
+	atomic_store_explicit(&table->buckets, (uintptr_t)bk,
+			      memory_order_release);
+	rcu_free(MTYPE_INTERN_BUCKETS, old, rcu_head);
+}
+
+/* mutex held */
+static void *intern_insert(struct intern_table *table, uint32_t hashval,
+			   const void *key)
+{
+	const struct intern_ops *ops = table->ops;
+	struct intern_buckets *bk = intern_buckets_get(table);
+	atomic_uintptr_t *head = &bk->b[hashval & bk->mask];
+	struct intern_item *item;
+	void *data;
+
+	item = intern_find(bk, ops, hashval, key);
+	if (item)
+		return intern_data(item);
+
+	data = ops->alloc(key);
+	item = intern_item_of(table, data);
+	item->ops = ops;
+	item->hashval = hashval;
+	atomic_store_explicit(&item->refcnt, 1, memory_order_relaxed);
+	atomic_store_explicit(&item->next,
+			      atomic_load_explicit(head, memory_order_relaxed),
+			      memory_order_relaxed);
+	/* publishes the item's contents together with the pointer */
+	atomic_store_explicit(head, (uintptr_t)item, memory_order_release);
+
+	if (atomic_fetch_add_explicit(&table->count, 1, memory_order_relaxed) >
+	    bk->mask)
+		intern_grow(table, bk);
+	return data;
+}
+
+void *intern_get(struct intern_table *table, const void *key)
+{
+	const struct intern_ops *ops = table->ops;
+	struct intern_item *item;
+	uint32_t hashval = ops->hash_key(key);
+	void *data;
+
+	rcu_read_lock();
+	item = intern_find(intern_buckets_get(table), ops, hashval, key);
+	if (item)
+		data = intern_data(item);
+	else
+		frr_with_mutex (&table->mtx)
+			data = intern_insert(table, hashval, key);
+	rcu_read_unlock();
+
+	return data;
+}
+
+void intern_ref(struct intern_table *table, void *data)
+{
+	struct intern_item *item = intern_item_of(table, data);
+	uint_fast32_t prev;
+
+	prev = atomic_fetch_add_explicit(&item->refcnt, 1,
+					 memory_order_relaxed);
+	assert(prev != 0);
+}
+
+static void intern_item_free(struct intern_item *item)
+{
+	item->ops->free(intern_data(item));
+}
+
+bool intern_put(struct intern_table *table, void *data)
+{
+	struct intern_item *item = intern_item_of(table, data);
+	struct intern_buckets *bk;
+	atomic_uintptr_t *prev;
+	struct intern_item *cur;
+	uint_fast32_t cnt;
+
+	cnt = atomic_fetch_sub_explicit(&item->refcnt, 1, memory_order_release);
+	assert(cnt != 0);
+	if (cnt > 1)
+		return false;
+
+	/* nobody can take a new reference now;  unlink it.  Concurrent
+	 * readers still walking through this item keep working since its
+	 * next pointer is left intact until the RCU grace period is over.
+	 */
+	rcu_read_lock();
+	frr_with_mutex (&table->mtx) {
+		bk = intern_buckets_get(table);
+		prev = &bk->b[item->hashval & bk->mask];
+
+		while ((cur = intern_next(prev)) && cur != item)
+			prev = &cur->next;
+		assert(cur == item);
+
+		atomic_store_explicit(prev,
+				      atomic_load_explicit(&item->next,
+							   memory_order_relaxed),
+				      memory_order_release);
+		atomic_fetch_sub_explicit(&table->count, 1,
+					  memory_order_relaxed);
+	}
+
+	rcu_call(intern_item_free, item, rcu_head);
+	rcu_read_unlock();
+	return true;
+}
+
+void intern_walk(struct intern_table *table,
+		 void (*func)(void *data, void *arg), void *arg)
+{
+	struct intern_buckets *bk;
+	struct intern_item *item;
+	size_t i;
+
+	frr_with_mutex (&table->mtx) {
+		bk = intern_buckets_get(table);
+		for (i = 0; i <= bk->mask; i++)
+			for (item = intern_next(&bk->b[i]); item;
+			     item = intern_next(&item->next))
+				func(intern_data(item), arg);
+	}
+}
+
+void intern_table_init(struct intern_table *table, const char *name,
+		       const struct intern_ops *ops)
+{
+	memset(table, 0, sizeof(*table));
+	table->name = name;
+	table->ops = ops;
+	pthread_mutex_init(&table->mtx, NULL);
+	atomic_store_explicit(&table->count, 0, memory_order_relaxed);
+	atomic_store_explicit(&table->buckets,
+			      (uintptr_t)intern_buckets_new(INTERN_MIN_BUCKETS),
+			      memory_order_release);
+}
+
+void intern_table_fini(struct intern_table *table)
+{
+	struct intern_buckets *bk = intern_buckets_get(table);
+	struct intern_item *item, *next;
+	size_t i;
+
+	for (i = 0; i <= bk->mask; i++)
+		for (item = intern_next(&bk->b[i]); item; item = next) {
+			next = intern_next(&item->next);
+			table->ops->free(intern_data(item));
+		}
+
+	XFREE(MTYPE_INTERN_BUCKETS, bk);
+	atomic_store_explicit(&table->buckets, (uintptr_t)NULL,
+			      memory_order_relaxed);
+	pthread_mutex_destroy(&table->mtx);
+}
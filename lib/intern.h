@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Concurrent intern (deduplication) table
+ */
+
+#ifndef _FRR_INTERN_H
+#define _FRR_INTERN_H
+
+#include <pthread.h>
+
+#include "frratomic.h"
+#include "frrcu.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An intern table keeps exactly one shared, reference counted copy of each
+ * distinct value, like the hash_get()/refcnt++ pattern used for the various
+ * protocol attribute tables, but usable from several pthreads at once:
+ *
+ * - lookups of an already interned value are lock-free; they run under
+ *   rcu_read_lock() and take their reference with a compare-and-swap that
+ *   refuses to resurrect an item whose count already dropped to zero.
+ * - insertion, removal and bucket array growth are serialized on a mutex.
+ * - removed items and replaced bucket arrays are released through RCU, so
+ *   a concurrent reader never touches freed memory.
+ *
+ * Items embed a struct intern_item.  An item whose refcount is zero has not
+ * been interned (e.g. a temporary on the stack used as lookup key.)
+ */
+
+struct intern_ops;
+
+struct intern_item {
+	atomic_uintptr_t next;
+	const struct intern_ops *ops;
+	uint32_t hashval;
+	atomic_uint_fast32_t refcnt;
+
+	struct rcu_head rcu_head;
+};
+
+struct intern_ops {
+	/* offsetof(container, struct intern_item member) */
+	size_t offset;
+
+	unsigned int (*hash_key)(const void *data);
+	bool (*hash_cmp)(const void *a, const void *b);
+	/* create an independent copy of the lookup key */
+	void *(*alloc)(const void *key);
+	/* may run on any pthread, after an RCU grace period */
+	void (*free)(void *data);
+};
+
+struct intern_buckets;
+
+struct intern_table {
+	const char *name;
+	const struct intern_ops *ops;
+
+	pthread_mutex_t mtx;
+	atomic_uintptr_t buckets;
+	atomic_size_t count;
+};
+
+extern void intern_table_init(struct intern_table *table, const char *name,
+			      const struct intern_ops *ops);
+/* frees all remaining items directly, no other thread may use the table */
+extern void intern_table_fini(struct intern_table *table);
+
+/* returns the shared copy of key (allocating it if needed) with a reference
+ * held for the caller.
+ */
+extern void *intern_get(struct intern_table *table, const void *key);
+/* takes an additional reference on an item obtained from intern_get() */
+extern void intern_ref(struct intern_table *table, void *data);
+/* drops a reference; returns true if this was the last one and the item is
+ * now scheduled for freeing.
+ */
+extern bool intern_put(struct intern_table *table, void *data);
+
+/* calls func for each item while holding the table's mutex */
+extern void intern_walk(struct intern_table *table,
+			void (*func)(void *data, void *arg), void *arg);
+
+static inline struct intern_item *
+intern_item_of(const struct intern_table *table, const void *data)
+{
+	return (struct intern_item *)((char *)data + table->ops->offset);
+}
+
+static inline uint32_t intern_refcnt(const struct intern_table *table,
+				     const void *data)
+{
+	return atomic_load_explicit(&intern_item_of(table, data)->refcnt,
+				    memory_order_relaxed);
+}
+
+/* hash value cached at insertion time, only valid if intern_refcnt() != 0 */
+static inline uint32_t intern_hashval(const struct intern_table *table,
+				      const void *data)
+{
+	return intern_item_of(table, data)->hashval;
+}
+
+static inline size_t intern_count(const struct intern_table *table)
+{
+	return atomic_load_explicit(&table->count, memory_order_relaxed);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_INTERN_H */
@@ -96,6 +96,8 @@ static void opt_extend(const struct optspec *os)
 #define OPTION_LOGGING   1007
 #define OPTION_LIMIT_FDS 1008
 #define OPTION_SCRIPTDIR 1009
+#define OPTION_IO_BACKEND 1010
+#define OPTION_ZAPI_RING 1011
 
 static const struct option lo_always[] = {
 	{"help", no_argument, NULL, 'h'},
@@ -112,6 +114,7 @@ static const struct option lo_always[] = {
 	{"log-level", required_argument, NULL, OPTION_LOGLEVEL},
 	{"command-log-always", no_argument, NULL, OPTION_LOGGING},
 	{"limit-fds", required_argument, NULL, OPTION_LIMIT_FDS},
+	{"io-backend", required_argument, NULL, OPTION_IO_BACKEND},
 	{NULL}};
 static const struct optspec os_always = {
 	"hvdM:F:N:o:",
@@ -127,7 +130,8 @@ static const struct optspec os_always = {
 	"      --scriptdir    Override scripts directory\n"
 	"      --log          Set Logging to stdout, syslog, or file:<name>\n"
 	"      --log-level    Set Logging Level to use, debug, info, warn, etc\n"
-	"      --limit-fds    Limit number of fds supported\n",
+	"      --limit-fds    Limit number of fds supported\n"
+	"      --io-backend   Event loop I/O backend: poll, epoll or epoll-et\n",
 	lo_always};
 
 
@@ -168,9 +172,13 @@ static const struct optspec os_pid = {
 
 static const struct option lo_zclient[] = {
 	{"socket", required_argument, NULL, 'z'},
+	{"zapi-ring", required_argument, NULL, OPTION_ZAPI_RING},
 	{NULL}};
 static const struct optspec os_zclient = {
-	"z:", "  -z, --socket       Set path of zebra socket\n", lo_zclient};
+	"z:",
+	"  -z, --socket       Set path of zebra socket\n"
+	"      --zapi-ring    Size of shared memory ring to send to zebra through\n",
+	lo_zclient};
 
 
 static const struct option lo_vty[] = {
@@ -533,6 +541,16 @@ static int frr_opt(int opt)
 			return 1;
 		strlcpy(frr_zclientpath, optarg, sizeof(frr_zclientpath));
 		break;
+	case OPTION_ZAPI_RING:
+		if (di->flags & FRR_NO_ZCLIENT)
+			return 1;
+		zclient_ring_set_default(strtoul(optarg, &err, 0));
+		if (*err) {
+			fprintf(stderr, "invalid --zapi-ring size \"%s\"\n",
+				optarg);
+			errors++;
+		}
+		break;
 	case 'A':
 		if (di->flags & FRR_NO_TCPVTY)
 			return 1;
@@ -618,6 +636,14 @@ static int frr_opt(int opt)
 	case OPTION_LIMIT_FDS:
 		di->limit_fds = strtoul(optarg, &err, 0);
 		break;
+	case OPTION_IO_BACKEND:
+		if (!thread_io_backend_set_default(optarg)) {
+			fprintf(stderr,
+				"I/O backend \"%s\" is not valid or not supported on this system.\n",
+				optarg);
+			errors++;
+		}
+		break;
 	default:
 		return 1;
 	}
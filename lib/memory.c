@@ -105,6 +105,15 @@ void *qcalloc(struct memtype *mt, size_t size)
 	return mt_checkalloc(mt, calloc(size, 1), size);
 }
 
+void *qmalloc_aligned(struct memtype *mt, size_t align, size_t size)
+{
+	void *ptr;
+
+	if (posix_memalign(&ptr, align, size))
+		ptr = NULL;
+	return mt_checkalloc(mt, ptr, size);
+}
+
 void *qrealloc(struct memtype *mt, void *ptr, size_t size)
 {
 	if (ptr)
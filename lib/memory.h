@@ -147,6 +147,8 @@ extern void *qmalloc(struct memtype *mt, size_t size)
 	__attribute__((malloc, _ALLOC_SIZE(2), nonnull(1) _RET_NONNULL));
 extern void *qcalloc(struct memtype *mt, size_t size)
 	__attribute__((malloc, _ALLOC_SIZE(2), nonnull(1) _RET_NONNULL));
+extern void *qmalloc_aligned(struct memtype *mt, size_t align, size_t size)
+	__attribute__((malloc, _ALLOC_SIZE(3), nonnull(1) _RET_NONNULL));
 extern void *qrealloc(struct memtype *mt, void *ptr, size_t size)
 	__attribute__((_ALLOC_SIZE(3), nonnull(1) _RET_NONNULL));
 extern void *qstrdup(struct memtype *mt, const char *str)
@@ -157,6 +159,8 @@ extern void qfree(struct memtype *mt, void *ptr) __attribute__((nonnull(1)));
 
 #define XMALLOC(mtype, size)		qmalloc(mtype, size)
 #define XCALLOC(mtype, size)		qcalloc(mtype, size)
+/* align must be a power of two multiple of sizeof(void *); free with XFREE */
+#define XMALLOC_ALIGNED(mtype, align, size) qmalloc_aligned(mtype, align, size)
 #define XREALLOC(mtype, ptr, size)	qrealloc(mtype, ptr, size)
 #define XSTRDUP(mtype, str)		qstrdup(mtype, str)
 #define XCOUNTFREE(mtype, ptr)		qcountfree(mtype, ptr)
@@ -0,0 +1,233 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Single producer, single consumer byte ring in shared memory.
+ */
+#include <zebra.h>
+
+#include <sys/mman.h>
+
+#include "shmring.h"
+#include "memory.h"
+#include "lib_errors.h"
+
+DEFINE_MTYPE_STATIC(LIB, SHMRING, "Shared memory ring");
+
+#define SHMRING_MAGIC 0x5a52494e
+
+static struct shmring *shmring_map(int fd, const char *name, size_t size)
+{
+	struct shmring *ring;
+	void *map;
+	size_t maplen = sizeof(struct shmring_hdr) + size;
+
+	map = mmap(NULL, maplen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: mmap(%s): %s", __func__,
+			     name, safe_strerror(errno));
+		return NULL;
+	}
+
+	ring = XCALLOC(MTYPE_SHMRING, sizeof(*ring));
+	ring->hdr = map;
+	ring->data = (uint8_t *)map + sizeof(struct shmring_hdr);
+	ring->size = size;
+	ring->maplen = maplen;
+	strlcpy(ring->name, name, sizeof(ring->name));
+	return ring;
+}
+
+struct shmring *shmring_create(size_t size)
+{
+	static unsigned int seq;
+	struct shmring *ring;
+	char name[SHMRING_NAMSIZ];
+	size_t rsize = SHMRING_MIN_SIZE;
+	int fd;
+
+	if (size > SHMRING_MAX_SIZE)
+		size = SHMRING_MAX_SIZE;
+	while (rsize < size)
+		rsize <<= 1;
+
+	do {
+		snprintf(name, sizeof(name), "/frr-shmring-%ld-%u",
+			 (long)getpid(), seq++);
+		fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	} while (fd < 0 && errno == EEXIST);
+
+	if (fd < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: shm_open(%s): %s",
+			     __func__, name, safe_strerror(errno));
+		return NULL;
+	}
+
+	if (ftruncate(fd, sizeof(struct shmring_hdr) + rsize) < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: ftruncate(%s): %s",
+			     __func__, name, safe_strerror(errno));
+		close(fd);
+		shm_unlink(name);
+		return NULL;
+	}
+
+	ring = shmring_map(fd, name, rsize);
+	close(fd);
+	if (!ring) {
+		shm_unlink(name);
+		return NULL;
+	}
+	ring->linked = true;
+
+	/* fresh from ftruncate, so all zero */
+	ring->hdr->magic = SHMRING_MAGIC;
+	ring->hdr->size = rsize;
+	atomic_store_explicit(&ring->hdr->idle, 1, memory_order_relaxed);
+	return ring;
+}
+
+struct shmring *shmring_attach(const char *name, size_t size)
+{
+	struct shmring *ring;
+	struct stat st;
+	int fd;
+
+	if (size < SHMRING_MIN_SIZE || size > SHMRING_MAX_SIZE
+	    || (size & (size - 1)))
+		return NULL;
+	if (name[0] != '/' || strchr(name + 1, '/')
+	    || strlen(name) >= SHMRING_NAMSIZ)
+		return NULL;
+
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0) {
+		zlog_warn("%s: shm_open(%s): %s", __func__, name,
+			  safe_strerror(errno));
+		return NULL;
+	}
+	shm_unlink(name);
+
+	if (fstat(fd, &st) < 0
+	    || (size_t)st.st_size != sizeof(struct shmring_hdr) + size) {
+		zlog_warn("%s: %s has the wrong size", __func__, name);
+		close(fd);
+		return NULL;
+	}
+
+	ring = shmring_map(fd, name, size);
+	close(fd);
+	if (!ring)
+		return NULL;
+
+	if (ring->hdr->magic != SHMRING_MAGIC || ring->hdr->size != size) {
+		zlog_warn("%s: %s is not a ring", __func__, name);
+		shmring_del(ring);
+		return NULL;
+	}
+	return ring;
+}
+
+void shmring_unlink(struct shmring *ring)
+{
+	if (!ring->linked)
+		return;
+
+	shm_unlink(ring->name);
+	ring->linked = false;
+}
+
+void shmring_del(struct shmring *ring)
+{
+	shmring_unlink(ring);
+	munmap(ring->hdr, ring->maplen);
+	XFREE(MTYPE_SHMRING, ring);
+}
+
+size_t shmring_space(struct shmring *ring)
+{
+	uint64_t head, tail;
+
+	head = atomic_load_explicit(&ring->hdr->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_acquire);
+	return ring->size - (size_t)(head - tail);
+}
+
+bool shmring_put(struct shmring *ring, const void *data, size_t size)
+{
+	uint64_t head;
+	size_t pos, part;
+
+	if (size > shmring_space(ring))
+		return false;
+
+	head = atomic_load_explicit(&ring->hdr->head, memory_order_relaxed);
+	pos = head & (ring->size - 1);
+	part = MIN(size, ring->size - pos);
+
+	memcpy(ring->data + pos, data, part);
+	if (part < size)
+		memcpy(ring->data, (const uint8_t *)data + part, size - part);
+
+	/* seq_cst pairs with shmring_idle() */
+	atomic_store_explicit(&ring->hdr->head, head + size,
+			      memory_order_seq_cst);
+	return true;
+}
+
+bool shmring_wakeup(struct shmring *ring)
+{
+	if (!atomic_load_explicit(&ring->hdr->idle, memory_order_seq_cst))
+		return false;
+
+	return atomic_exchange_explicit(&ring->hdr->idle, 0,
+					memory_order_seq_cst);
+}
+
+size_t shmring_remain(struct shmring *ring)
+{
+	uint64_t head, tail;
+
+	head = atomic_load_explicit(&ring->hdr->head, memory_order_acquire);
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_relaxed);
+	return (size_t)(head - tail);
+}
+
+void shmring_peek(struct shmring *ring, size_t offset, void *data,
+		  size_t size)
+{
+	uint64_t tail;
+	size_t pos, part;
+
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_relaxed);
+	pos = (tail + offset) & (ring->size - 1);
+	part = MIN(size, ring->size - pos);
+
+	memcpy(data, ring->data + pos, part);
+	if (part < size)
+		memcpy((uint8_t *)data + part, ring->data, size - part);
+}
+
+void shmring_consume(struct shmring *ring, size_t size)
+{
+	uint64_t tail;
+
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_relaxed);
+	atomic_store_explicit(&ring->hdr->tail, tail + size,
+			      memory_order_release);
+}
+
+bool shmring_idle(struct shmring *ring)
+{
+	uint64_t head, tail;
+
+	/* seq_cst pairs with shmring_put() */
+	atomic_store_explicit(&ring->hdr->idle, 1, memory_order_seq_cst);
+	head = atomic_load_explicit(&ring->hdr->head, memory_order_seq_cst);
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_relaxed);
+	if (head == tail)
+		return true;
+
+	/* The producer may or may not have seen the flag; either way there
+	 * is more to read now.
+	 */
+	atomic_store_explicit(&ring->hdr->idle, 0, memory_order_relaxed);
+	return false;
+}
@@ -0,0 +1,146 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Single producer, single consumer byte ring in shared memory.
+ *
+ * The ring lives in a POSIX shared memory object, so the producer and the
+ * consumer can be different processes.  Head and tail are free running byte
+ * counters; the producer only ever moves the head and the consumer only the
+ * tail.  Data is published with release semantics when the head moves, so
+ * once shmring_remain() reports some bytes, they can be read.
+ *
+ * Writes are all or nothing, so a consumer never sees a partial message if
+ * the producer writes whole messages.
+ */
+#ifndef _FRR_SHMRING_H_
+#define _FRR_SHMRING_H_
+
+#include <zebra.h>
+
+#include "frratomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* smallest and largest ring, in bytes */
+#define SHMRING_MIN_SIZE (1U << 16)
+#define SHMRING_MAX_SIZE (1U << 30)
+
+#define SHMRING_NAMSIZ 64
+
+/* Shared part, at the start of the mapping.  Producer and consumer fields
+ * are kept on separate cache lines.
+ */
+struct shmring_hdr {
+	uint32_t magic;
+	uint32_t size;
+	uint8_t pad0[56];
+
+	/* producer */
+	_Atomic uint64_t head;
+	uint8_t pad1[56];
+
+	/* consumer */
+	_Atomic uint64_t tail;
+	/* consumer ran out of data and wants to be woken up */
+	_Atomic uint32_t idle;
+	uint8_t pad2[52];
+};
+
+struct shmring {
+	struct shmring_hdr *hdr;
+	uint8_t *data;
+
+	/* size of data, a power of 2 */
+	size_t size;
+	size_t maplen;
+
+	char name[SHMRING_NAMSIZ];
+	/* name still exists and needs to be unlinked */
+	bool linked;
+};
+
+/*
+ * Creates a new shared memory object holding a ring and maps it.
+ *
+ * @param size	data size in bytes, rounded up to a power of 2
+ * @return the new ring, or NULL if the object can't be created
+ */
+struct shmring *shmring_create(size_t size);
+
+/*
+ * Maps a ring created by another process with shmring_create() and removes
+ * its name, so nobody else can map it anymore.
+ *
+ * @param name	ring->name of the ring
+ * @param size	ring->size of the ring
+ * @return the ring, or NULL if it doesn't exist or doesn't look like a ring
+ */
+struct shmring *shmring_attach(const char *name, size_t size);
+
+/*
+ * Removes the name of a ring; existing mappings stay valid.
+ */
+void shmring_unlink(struct shmring *ring);
+
+/*
+ * Unmaps a ring, removing its name if that hasn't happened yet.
+ */
+void shmring_del(struct shmring *ring);
+
+/*
+ * Producer: puts data into the ring.
+ *
+ * @return true if all of data was put in, false if there isn't enough space,
+ * in which case nothing was put in
+ */
+bool shmring_put(struct shmring *ring, const void *data, size_t size);
+
+/*
+ * Producer: number of bytes that can be put into the ring.
+ */
+size_t shmring_space(struct shmring *ring);
+
+/*
+ * Producer: checks whether the consumer has to be woken up after putting
+ * data into the ring.  Returns true only once for each time the consumer
+ * went idle.
+ */
+bool shmring_wakeup(struct shmring *ring);
+
+/*
+ * Consumer: number of bytes available to read.  More than ring->size means
+ * the producer corrupted the ring.
+ */
+size_t shmring_remain(struct shmring *ring);
+
+/*
+ * Consumer: copies data from the ring without removing it.
+ *
+ * @param offset	bytes to skip, from the oldest data in the ring
+ * @param data		where to put the data
+ * @param size		how much to copy; offset + size must not exceed
+ *			shmring_remain()
+ */
+void shmring_peek(struct shmring *ring, size_t offset, void *data,
+		  size_t size);
+
+/*
+ * Consumer: removes data from the ring.
+ */
+void shmring_consume(struct shmring *ring, size_t size);
+
+/*
+ * Consumer: marks the consumer idle if the ring is empty, so the producer
+ * knows to wake it up.
+ *
+ * @return true if the ring is empty, false if data arrived in the meantime
+ * and the consumer has to keep reading
+ */
+bool shmring_idle(struct shmring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_SHMRING_H_ */
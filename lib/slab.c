@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Fixed-size object slab allocator
+ */
+
+#include <zebra.h>
+
+#include "slab.h"
+#include "memory.h"
+
+DEFINE_MTYPE_STATIC(LIB, SLAB, "Slab allocator");
+
+struct slab_page {
+	struct slab *slab;
+	struct slab_pages_item item;
+
+	/* freed objects, linked through their first word */
+	void *freelist;
+	/* objects currently handed out from this page */
+	unsigned int used;
+	/* objects from this index on have never been handed out */
+	unsigned int fresh;
+};
+
+DECLARE_DLIST(slab_pages, struct slab_page, item);
+
+#define SLAB_PAGE_HDR                                                          \
+	((sizeof(struct slab_page) + sizeof(max_align_t) - 1) &                \
+	 ~(sizeof(max_align_t) - 1))
+
+static inline struct slab_page *slab_page_of(void *obj)
+{
+	return (struct slab_page *)((uintptr_t)obj &
+				    ~(uintptr_t)(SLAB_PAGE_SIZE - 1));
+}
+
+static inline void *slab_page_obj(struct slab_page *page, unsigned int idx)
+{
+	return (char *)page + SLAB_PAGE_HDR + idx * page->slab->objsize;
+}
+
+static void slab_stats_add(struct slab *slab, ssize_t objects, ssize_t pages)
+{
+	slab->own.objects += objects;
+	slab->own.pages += pages;
+	if (slab->stats) {
+		slab->stats->objects += objects;
+		slab->stats->pages += pages;
+	}
+}
+
+struct slab *slab_new(struct memtype *mt, const char *name, size_t objsize,
+		      struct slab_stats *stats)
+{
+	struct slab *slab;
+
+	/* room for the freelist link, and keep objects pointer aligned */
+	objsize = MAX(objsize, sizeof(void *));
+	objsize = (objsize + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+	assert(objsize <= SLAB_PAGE_SIZE / 4);
+
+	slab = XCALLOC(MTYPE_SLAB, sizeof(*slab));
+	slab->name = name;
+	slab->mt = mt;
+	slab->objsize = objsize;
+	slab->per_page = (SLAB_PAGE_SIZE - SLAB_PAGE_HDR) / objsize;
+	slab->stats = stats;
+	slab_pages_init(&slab->partial);
+	return slab;
+}
+
+static void slab_destroy(struct slab *slab)
+{
+	slab_pages_fini(&slab->partial);
+	XFREE(MTYPE_SLAB, slab);
+}
+
+static void slab_page_free(struct slab *slab, struct slab_page *page)
+{
+	slab_pages_del(&slab->partial, page);
+	XFREE(slab->mt, page);
+	slab_stats_add(slab, 0, -1);
+}
+
+void slab_delete(struct slab **slabp)
+{
+	struct slab *slab = *slabp;
+	struct slab_page *page;
+
+	if (!slab)
+		return;
+	*slabp = NULL;
+
+	frr_each_safe (slab_pages, &slab->partial, page)
+		if (!page->used)
+			slab_page_free(slab, page);
+
+	if (slab->own.objects) {
+		slab->orphaned = true;
+		return;
+	}
+	assert(!slab->own.pages);
+	slab_destroy(slab);
+}
+
+static struct slab_page *slab_page_new(struct slab *slab)
+{
+	struct slab_page *page;
+
+	page = XMALLOC_ALIGNED(slab->mt, SLAB_PAGE_SIZE, SLAB_PAGE_SIZE);
+	page->slab = slab;
+	page->freelist = NULL;
+	page->used = 0;
+	page->fresh = 0;
+	slab_pages_add_head(&slab->partial, page);
+	slab_stats_add(slab, 0, 1);
+	return page;
+}
+
+void *slab_alloc(struct slab *slab)
+{
+	struct slab_page *page;
+	void *obj;
+
+	assert(!slab->orphaned);
+
+	page = slab_pages_first(&slab->partial);
+	if (!page)
+		page = slab_page_new(slab);
+
+	if (page->freelist) {
+		obj = page->freelist;
+		page->freelist = *(void **)obj;
+	} else
+		obj = slab_page_obj(page, page->fresh++);
+
+	if (++page->used == slab->per_page)
+		slab_pages_del(&slab->partial, page);
+
+	slab_stats_add(slab, 1, 0);
+	memset(obj, 0, slab->objsize);
+	return obj;
+}
+
+void slab_free(void *obj)
+{
+	struct slab_page *page;
+	struct slab *slab;
+
+	if (!obj)
+		return;
+
+	page = slab_page_of(obj);
+	slab = page->slab;
+
+	assert(page->used > 0);
+	if (page->used == slab->per_page)
+		slab_pages_add_tail(&slab->partial, page);
+
+	*(void **)obj = page->freelist;
+	page->freelist = obj;
+	page->used--;
+	slab_stats_add(slab, -1, 0);
+
+	/* keep one empty page around so a single alloc/free doesn't churn
+	 * through malloc;  an orphaned slab has no use for it.
+	 */
+	if (!page->used
+	    && (slab->orphaned || slab_pages_count(&slab->partial) > 1))
+		slab_page_free(slab, page);
+
+	if (slab->orphaned && !slab->own.objects) {
+		assert(!slab->own.pages);
+		slab_destroy(slab);
+	}
+}
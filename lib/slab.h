@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Fixed-size object slab allocator
+ */
+
+#ifndef _FRR_SLAB_H
+#define _FRR_SLAB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "memory.h"
+#include "typesafe.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* A slab hands out objects of one size, carved from SLAB_PAGE_SIZE pages
+ * that are aligned to their own size.  Compared to one malloc() per object
+ * this drops the per-allocation header and size class rounding, and keeps
+ * objects allocated together close together in memory.
+ *
+ * - objects are returned to their page by address alone (slab_free() does
+ *   not need to know which slab an object came from.)
+ * - a page is released once all its objects have been freed, unless it is
+ *   the last page with free space left.
+ * - a slab deleted while objects are still allocated from it lingers until
+ *   the last of them is freed.
+ * - objects are aligned to pointer size.
+ *
+ * There is no locking;  a slab and its objects must only be used from one
+ * pthread at a time.
+ */
+
+#define SLAB_PAGE_SIZE 16384
+
+/* optional, may be shared by several slabs to get combined figures */
+struct slab_stats {
+	/* objects currently allocated */
+	size_t objects;
+	/* pages currently allocated, at SLAB_PAGE_SIZE bytes each */
+	size_t pages;
+};
+
+PREDECL_DLIST(slab_pages);
+
+struct slab {
+	const char *name;
+	struct memtype *mt;
+
+	size_t objsize;
+	unsigned int per_page;
+
+	/* pages with at least one free object */
+	struct slab_pages_head partial;
+
+	struct slab_stats own;
+	struct slab_stats *stats;
+
+	/* slab_delete() called with objects still allocated */
+	bool orphaned;
+};
+
+/* pages are allocated with the given memtype.  objsize must be at most
+ * SLAB_PAGE_SIZE / 4.
+ */
+extern struct slab *slab_new(struct memtype *mt, const char *name,
+			     size_t objsize, struct slab_stats *stats);
+extern void slab_delete(struct slab **slabp);
+
+/* returns a zeroed object */
+extern void *slab_alloc(struct slab *slab);
+extern void slab_free(void *obj);
+
+static inline size_t slab_count(const struct slab *slab)
+{
+	return slab->own.objects;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_SLAB_H */
@@ -10,6 +10,7 @@
 
 #include "prefix.h"
 #include "table.h"
+#include "table_lpm.h"
 #include "memory.h"
 #include "sockunion.h"
 #include "libfrr_trace.h"
@@ -85,6 +86,9 @@ static void route_table_free(struct route_table *rt)
 	if (rt == NULL)
 		return;
 
+	route_lpm_free(rt->lpm);
+	rt->lpm = NULL;
+
 	node = rt->top;
 
 	/* Bulk deletion of nodes remaining in this table.  This function is not
@@ -127,6 +131,28 @@ static void route_table_free(struct route_table *rt)
 	return;
 }
 
+static void route_table_lpm_add_subtree(struct route_lpm *lpm,
+					struct route_node *node)
+{
+	for (; node; node = node->l_right) {
+		/* leave out glue nodes; anything that might get info set
+		 * later on is held by someone
+		 */
+		if (node->info || node->lock)
+			route_lpm_add(lpm, node);
+		route_table_lpm_add_subtree(lpm, node->l_left);
+	}
+}
+
+void route_table_lpm_enable(struct route_table *table, int family)
+{
+	if (table->lpm)
+		return;
+
+	table->lpm = route_lpm_new(family);
+	route_table_lpm_add_subtree(table->lpm, table->top);
+}
+
 /* Utility mask array. */
 static const uint8_t maskbit[] = {0x00, 0x80, 0xc0, 0xe0, 0xf0,
 				  0xf8, 0xfc, 0xfe, 0xff};
@@ -188,6 +214,15 @@ struct route_node *route_node_match(struct route_table *table,
 	matched = NULL;
 	node = table->top;
 
+	/* The index finds the most specific node covering the address, the
+	 * match is that or one of its parents.
+	 */
+	if (table->lpm && route_lpm_match(table->lpm, p, &node)) {
+		while (node && (!node->info || node->p.prefixlen > p->prefixlen))
+			node = node->parent;
+		return node ? route_lock_node(node) : NULL;
+	}
+
 	/* Walk down tree.  If there is matched route then store it to
 	   matched. */
 	while (node && node->p.prefixlen <= p->prefixlen
@@ -288,8 +323,12 @@ struct route_node *route_node_get(struct route_table *table,
 	node = table->top;
 	while (node && node->p.prefixlen <= prefixlen
 	       && prefix_match(&node->p, p)) {
-		if (node->p.prefixlen == prefixlen)
+		if (node->p.prefixlen == prefixlen) {
+			/* might be a glue node, which aren't indexed */
+			if (table->lpm)
+				route_lpm_add(table->lpm, node);
 			return route_lock_node(node);
+		}
 
 		match = node;
 		node = node->link[prefix_bit(prefix, node->p.prefixlen)];
@@ -322,6 +361,8 @@ struct route_node *route_node_get(struct route_table *table,
 		}
 	}
 	table->count++;
+	if (table->lpm)
+		route_lpm_add(table->lpm, new);
 	route_lock_node(new);
 
 	return new;
@@ -360,6 +401,8 @@ void route_node_delete(struct route_node *node)
 	node->table->count--;
 
 	rn_hash_node_del(&node->table->hash, node);
+	if (node->table->lpm)
+		route_lpm_del(node->table->lpm, node, parent);
 
 	/* WARNING: FRAGILE CODE!
 	 * route_node_free may have the side effect of free'ing the entire
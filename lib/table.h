@@ -23,6 +23,7 @@ DECLARE_MTYPE(ROUTE_NODE);
  */
 struct route_node;
 struct route_table;
+struct route_lpm;
 
 /*
  * route_table_delegate_t
@@ -59,6 +60,9 @@ struct route_table {
 
 	unsigned long count;
 
+	/* optional longest-prefix match index, see route_table_lpm_enable() */
+	struct route_lpm *lpm;
+
 	/*
 	 * User data.
 	 */
@@ -115,6 +119,8 @@ struct route_table {
                                                                                \
 	/* Lock of this radix */                                               \
 	unsigned int table_rdonly(lock);                                       \
+	/* Node is in the table's LPM index */                                \
+	bool table_rdonly(lpm_indexed);                                        \
                                                                                \
 	struct rn_hash_node_item nodehash;                                     \
 	/* Each node of route. */                                              \
@@ -183,6 +189,18 @@ static inline void route_table_set_info(struct route_table *table, void *d)
 }
 
 extern void route_table_finish(struct route_table *table);
+
+/*
+ * Builds a longest-prefix match index for the AF_INET or AF_INET6 nodes of
+ * the table, which is then kept up to date as nodes are added and removed.
+ * route_node_match() and friends use it for lookups of that family instead
+ * of walking down the tree bit by bit.
+ *
+ * This costs some memory (32KiB plus some for each populated address
+ * block) and makes adding and removing nodes slower, so it's only worth it
+ * on tables that see a lot more matches than updates.
+ */
+extern void route_table_lpm_enable(struct route_table *table, int family);
 extern struct route_node *route_top(struct route_table *table);
 extern struct route_node *route_next(struct route_node *node);
 extern struct route_node *route_next_until(struct route_node *node,
@@ -0,0 +1,381 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Longest-prefix match index for route tables
+ *
+ * This is a poptrie (Asai & Ohara, SIGCOMM '15) flavoured multibit trie:
+ * the first LPM_DP_BITS of the address index a flat array, after that
+ * every level consumes LPM_STRIDE bits through a chunk of 64 entries.
+ * Chunks are stored compressed, as two 64-bit vectors and an array:
+ *
+ * - childvec has a bit set for each entry that is a pointer to another chunk.
+ *   The pointers are at the start of ptrs[], in entry order.
+ * - the remaining entries are leaves.  Runs of equal leaves are stored once,
+ *   leafvec has a bit set for each entry that starts a new run.  The leaves
+ *   follow the child pointers in ptrs[].
+ *
+ * so finding an entry takes a popcount on one of the vectors.  A leaf is
+ * the most specific indexed route_node covering the entry's address range.
+ * Nodes are indexed once handed out by route_node_get(), glue nodes the
+ * tree creates for itself are not;  route_node_match() walks up ->parent
+ * from the leaf to the first node with info, which is usually the leaf
+ * itself.
+ *
+ * Updates expand the chunks they touch, modify them and compress them
+ * again.  Chunks that end up with a single leaf are folded into their
+ * parent entry.
+ */
+
+#define FRR_COMPILING_TABLE_C
+
+#include <zebra.h>
+
+#include "table.h"
+#include "table_lpm.h"
+#include "memory.h"
+
+DEFINE_MTYPE_STATIC(LIB, ROUTE_LPM, "Route table LPM index");
+DEFINE_MTYPE_STATIC(LIB, ROUTE_LPM_CHUNK, "Route table LPM chunk");
+
+#define LPM_DP_BITS 12
+#define LPM_STRIDE 6
+#define LPM_CHUNK_SIZE (1 << LPM_STRIDE)
+
+/* entries are either a struct route_node * or a chunk pointer with the low
+ * bit set
+ */
+#define LPM_IS_CHUNK(e) ((e) & 1)
+#define LPM_CHUNK(e) ((struct route_lpm_chunk *)((e) & ~(uintptr_t)1))
+#define LPM_NODE(e) ((struct route_node *)(e))
+
+struct route_lpm_chunk {
+	uint64_t leafvec;
+	uint64_t childvec;
+	uintptr_t ptrs[];
+};
+
+struct route_lpm {
+	int family;
+	size_t chunks;
+	uintptr_t dp[1 << LPM_DP_BITS];
+};
+
+/* address, left aligned */
+struct lpm_key {
+	uint64_t hi, lo;
+};
+
+struct lpm_update {
+	struct lpm_key key;
+	uint16_t prefixlen;
+
+	struct route_node *node;
+	/* deletion: entries pointing to node are changed to repl */
+	bool del;
+	struct route_node *repl;
+};
+
+static inline void lpm_key_get(struct lpm_key *key, const struct prefix *p)
+{
+	uint32_t w[4];
+
+	if (p->family == AF_INET) {
+		key->hi = (uint64_t)ntohl(p->u.prefix4.s_addr) << 32;
+		key->lo = 0;
+		return;
+	}
+
+	memcpy(w, &p->u.prefix6, sizeof(w));
+	key->hi = ((uint64_t)ntohl(w[0]) << 32) | ntohl(w[1]);
+	key->lo = ((uint64_t)ntohl(w[2]) << 32) | ntohl(w[3]);
+}
+
+/* n bits starting at bit off;  bits past the end of the address are 0 */
+static inline unsigned int lpm_bits(const struct lpm_key *key,
+				    unsigned int off, unsigned int n)
+{
+	uint64_t v;
+
+	if (off + n <= 64)
+		v = key->hi << off;
+	else if (off >= 128)
+		return 0;
+	else if (off >= 64)
+		v = key->lo << (off - 64);
+	else
+		v = (key->hi << off) | (key->lo >> (64 - off));
+
+	return v >> (64 - n);
+}
+
+static inline unsigned int lpm_level_off(unsigned int level)
+{
+	return level ? LPM_DP_BITS + (level - 1) * LPM_STRIDE : 0;
+}
+
+static inline unsigned int lpm_level_bits(unsigned int level)
+{
+	return level ? LPM_STRIDE : LPM_DP_BITS;
+}
+
+static inline uintptr_t lpm_chunk_get(const struct route_lpm_chunk *chunk,
+				      unsigned int idx)
+{
+	uint64_t bit = 1ULL << idx;
+
+	if (chunk->childvec & bit)
+		return chunk->ptrs[__builtin_popcountll(chunk->childvec &
+							(bit - 1))];
+
+	/* (bit << 1) - 1 wraps around to all ones for idx 63 */
+	return chunk->ptrs[__builtin_popcountll(chunk->childvec) +
+			   __builtin_popcountll(chunk->leafvec &
+						((bit << 1) - 1)) -
+			   1];
+}
+
+static void lpm_chunk_expand(const struct route_lpm_chunk *chunk,
+			     uintptr_t *e)
+{
+	unsigned int nchild = __builtin_popcountll(chunk->childvec);
+	unsigned int ci = 0, li = nchild;
+	uintptr_t leaf = 0;
+	unsigned int i;
+
+	for (i = 0; i < LPM_CHUNK_SIZE; i++) {
+		uint64_t bit = 1ULL << i;
+
+		if (chunk->childvec & bit) {
+			e[i] = chunk->ptrs[ci++];
+			continue;
+		}
+		if (chunk->leafvec & bit)
+			leaf = chunk->ptrs[li++];
+		e[i] = leaf;
+	}
+}
+
+/* returns the entry that replaces the chunk;  that's the leaf itself if
+ * all entries are the same leaf
+ */
+static uintptr_t lpm_chunk_compress(struct route_lpm *lpm, const uintptr_t *e)
+{
+	struct route_lpm_chunk *chunk;
+	uint64_t leafvec = 0, childvec = 0;
+	unsigned int nchild = 0, nleaf = 0, ci, li;
+	uintptr_t last = 0;
+	unsigned int i;
+
+	for (i = 0; i < LPM_CHUNK_SIZE; i++) {
+		if (LPM_IS_CHUNK(e[i])) {
+			childvec |= 1ULL << i;
+			nchild++;
+		} else if (!nleaf || e[i] != last) {
+			leafvec |= 1ULL << i;
+			nleaf++;
+			last = e[i];
+		}
+	}
+
+	if (!nchild && nleaf == 1)
+		return last;
+
+	chunk = XMALLOC(MTYPE_ROUTE_LPM_CHUNK,
+			sizeof(*chunk) + (nchild + nleaf) * sizeof(uintptr_t));
+	chunk->leafvec = leafvec;
+	chunk->childvec = childvec;
+
+	ci = 0;
+	li = nchild;
+	for (i = 0; i < LPM_CHUNK_SIZE; i++) {
+		if (childvec & (1ULL << i))
+			chunk->ptrs[ci++] = e[i];
+		else if (leafvec & (1ULL << i))
+			chunk->ptrs[li++] = e[i];
+	}
+
+	lpm->chunks++;
+	return (uintptr_t)chunk | 1;
+}
+
+static void lpm_chunk_free(struct route_lpm *lpm, struct route_lpm_chunk *chunk)
+{
+	lpm->chunks--;
+	XFREE(MTYPE_ROUTE_LPM_CHUNK, chunk);
+}
+
+static void lpm_chunk_free_all(struct route_lpm *lpm,
+			       struct route_lpm_chunk *chunk)
+{
+	unsigned int nchild = __builtin_popcountll(chunk->childvec);
+	unsigned int i;
+
+	for (i = 0; i < nchild; i++)
+		lpm_chunk_free_all(lpm, LPM_CHUNK(chunk->ptrs[i]));
+	lpm_chunk_free(lpm, chunk);
+}
+
+static uintptr_t lpm_update_leaf(const struct lpm_update *u, uintptr_t e)
+{
+	struct route_node *cur = LPM_NODE(e);
+
+	if (u->del)
+		return cur == u->node ? (uintptr_t)u->repl : e;
+
+	/* both cover the address, the longer one is more specific */
+	if (!cur || cur->p.prefixlen < u->prefixlen)
+		return (uintptr_t)u->node;
+	return e;
+}
+
+static bool lpm_update_level(struct route_lpm *lpm, const struct lpm_update *u,
+			     uintptr_t *e, unsigned int level);
+
+/* applies u below entry, which belongs to the given level */
+static uintptr_t lpm_update_below(struct route_lpm *lpm,
+				  const struct lpm_update *u, uintptr_t entry,
+				  unsigned int level)
+{
+	uintptr_t e[LPM_CHUNK_SIZE];
+	unsigned int i;
+
+	if (LPM_IS_CHUNK(entry))
+		lpm_chunk_expand(LPM_CHUNK(entry), e);
+	else
+		for (i = 0; i < LPM_CHUNK_SIZE; i++)
+			e[i] = entry;
+
+	if (!lpm_update_level(lpm, u, e, level + 1))
+		return entry;
+
+	if (LPM_IS_CHUNK(entry))
+		lpm_chunk_free(lpm, LPM_CHUNK(entry));
+	return lpm_chunk_compress(lpm, e);
+}
+
+/* e is the (expanded) entry array of the given level */
+static bool lpm_update_level(struct route_lpm *lpm, const struct lpm_update *u,
+			     uintptr_t *e, unsigned int level)
+{
+	unsigned int off = lpm_level_off(level);
+	unsigned int bits = lpm_level_bits(level);
+	unsigned int first, count, i;
+	bool changed = false;
+	uintptr_t prev;
+
+	if (u->prefixlen > off + bits) {
+		/* more specific than this level, goes into a chunk below */
+		i = lpm_bits(&u->key, off, bits);
+		if (!LPM_IS_CHUNK(e[i]) && u->del)
+			return false;
+
+		prev = e[i];
+		e[i] = lpm_update_below(lpm, u, e[i], level);
+		return e[i] != prev;
+	}
+
+	if (u->prefixlen <= off) {
+		first = 0;
+		count = 1 << bits;
+	} else {
+		count = 1 << (off + bits - u->prefixlen);
+		first = lpm_bits(&u->key, off, bits) & ~(count - 1);
+	}
+
+	for (i = first; i < first + count; i++) {
+		prev = e[i];
+		if (LPM_IS_CHUNK(e[i]))
+			e[i] = lpm_update_below(lpm, u, e[i], level);
+		else
+			e[i] = lpm_update_leaf(u, e[i]);
+		changed |= e[i] != prev;
+	}
+	return changed;
+}
+
+static void lpm_update(struct route_lpm *lpm, struct lpm_update *u)
+{
+	if (u->node->p.family != lpm->family)
+		return;
+
+	lpm_key_get(&u->key, &u->node->p);
+	u->prefixlen = u->node->p.prefixlen;
+	lpm_update_level(lpm, u, lpm->dp, 0);
+}
+
+void route_lpm_add(struct route_lpm *lpm, struct route_node *node)
+{
+	struct lpm_update u = {
+		.node = node,
+	};
+
+	if (node->lpm_indexed)
+		return;
+	node->lpm_indexed = true;
+
+	lpm_update(lpm, &u);
+}
+
+void route_lpm_del(struct route_lpm *lpm, struct route_node *node,
+		   struct route_node *parent)
+{
+	struct lpm_update u = {
+		.node = node,
+		.del = true,
+	};
+
+	if (!node->lpm_indexed)
+		return;
+	node->lpm_indexed = false;
+
+	while (parent && !parent->lpm_indexed)
+		parent = parent->parent;
+	u.repl = parent;
+
+	lpm_update(lpm, &u);
+}
+
+bool route_lpm_match(const struct route_lpm *lpm, const struct prefix *p,
+		     struct route_node **node)
+{
+	struct lpm_key key;
+	unsigned int off;
+	uintptr_t e;
+
+	if (p->family != lpm->family)
+		return false;
+
+	lpm_key_get(&key, p);
+	e = lpm->dp[lpm_bits(&key, 0, LPM_DP_BITS)];
+
+	for (off = LPM_DP_BITS; LPM_IS_CHUNK(e); off += LPM_STRIDE)
+		e = lpm_chunk_get(LPM_CHUNK(e), lpm_bits(&key, off, LPM_STRIDE));
+
+	*node = LPM_NODE(e);
+	return true;
+}
+
+struct route_lpm *route_lpm_new(int family)
+{
+	struct route_lpm *lpm;
+
+	assert(family == AF_INET || family == AF_INET6);
+
+	lpm = XCALLOC(MTYPE_ROUTE_LPM, sizeof(*lpm));
+	lpm->family = family;
+	return lpm;
+}
+
+void route_lpm_free(struct route_lpm *lpm)
+{
+	unsigned int i;
+
+	if (!lpm)
+		return;
+
+	for (i = 0; i < array_size(lpm->dp); i++)
+		if (LPM_IS_CHUNK(lpm->dp[i]))
+			lpm_chunk_free_all(lpm, LPM_CHUNK(lpm->dp[i]));
+
+	assert(lpm->chunks == 0);
+	XFREE(MTYPE_ROUTE_LPM, lpm);
+}
@@ -0,0 +1,36 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Longest-prefix match index for route tables
+ *
+ * Internal to lib/table.c, see route_table_lpm_enable().
+ */
+
+#ifndef _FRR_TABLE_LPM_H
+#define _FRR_TABLE_LPM_H
+
+#include "table.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern struct route_lpm *route_lpm_new(int family);
+extern void route_lpm_free(struct route_lpm *lpm);
+
+/* node has been added to the table */
+extern void route_lpm_add(struct route_lpm *lpm, struct route_node *node);
+/* node is being removed from the table, parent takes over its addresses */
+extern void route_lpm_del(struct route_lpm *lpm, struct route_node *node,
+			  struct route_node *parent);
+
+/* Finds the most specific node (with or without info) covering p's address.
+ * Returns false if p is not of the index' family.
+ */
+extern bool route_lpm_match(const struct route_lpm *lpm, const struct prefix *p,
+			    struct route_node **node);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_TABLE_LPM_H */
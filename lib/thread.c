@@ -73,6 +73,8 @@ pthread_key_t thread_current;
 static pthread_mutex_t masters_mtx = PTHREAD_MUTEX_INITIALIZER;
 static struct list *masters;
 
+static enum thread_io_backend io_backend_default = THREAD_IO_POLL;
+
 static void thread_free(struct thread_master *master, struct thread *thread);
 
 #ifndef EXCLUDE_CPU_TIME
@@ -407,6 +409,8 @@ static void show_thread_poll_helper(struct vty *vty, struct thread_master *m)
 
 	vty_out(vty, "\nShowing poll FD's for %s\n", name);
 	vty_out(vty, "----------------------%s\n", underline);
+	vty_out(vty, "Backend: %s\n",
+		thread_io_backend_name(m->handler.backend));
 	vty_out(vty, "Count: %u/%d\n", (uint32_t)m->handler.pfdcount,
 		m->fd_limit);
 	for (i = 0; i < m->handler.pfdcount; i++) {
@@ -538,6 +542,207 @@ static void cancelreq_del(void *cr)
 	XFREE(MTYPE_TMP, cr);
 }
 
+/* I/O backends ------------------------------------------------------------- */
+
+/* upper bound on events fetched by a single epoll_wait() call */
+#define THREAD_EPOLL_EVENTS 1024
+
+static const char *const io_backend_names[] = {
+	[THREAD_IO_POLL] = "poll",
+	[THREAD_IO_EPOLL] = "epoll",
+	[THREAD_IO_EPOLL_ET] = "epoll-et",
+};
+
+const char *thread_io_backend_name(enum thread_io_backend backend)
+{
+	if ((size_t)backend >= array_size(io_backend_names))
+		return "unknown";
+	return io_backend_names[backend];
+}
+
+bool thread_io_backend_set_default(const char *name)
+{
+	for (size_t i = 0; i < array_size(io_backend_names); i++) {
+		if (strcmp(name, io_backend_names[i]))
+			continue;
+#ifndef HAVE_EPOLL
+		if (i != THREAD_IO_POLL)
+			return false;
+#endif
+		io_backend_default = i;
+		return true;
+	}
+	return false;
+}
+
+#ifdef HAVE_EPOLL
+static uint32_t poll2epoll(const struct fd_handler *h, short events)
+{
+	uint32_t ev = 0;
+
+	if (events & POLLIN)
+		ev |= EPOLLIN;
+	if (events & POLLOUT)
+		ev |= EPOLLOUT;
+	if (ev && h->backend == THREAD_IO_EPOLL_ET)
+		ev |= EPOLLET | EPOLLONESHOT;
+	return ev;
+}
+
+static short epoll2poll(uint32_t ev)
+{
+	short events = 0;
+
+	if (ev & EPOLLIN)
+		events |= POLLIN;
+	if (ev & EPOLLOUT)
+		events |= POLLOUT;
+	if (ev & EPOLLERR)
+		events |= POLLERR;
+	if (ev & EPOLLHUP)
+		events |= POLLHUP;
+	return events;
+}
+#endif
+
+/* Push the events of pfds[pos] into the kernel's epoll set. */
+static void fd_handler_sync(struct thread_master *m, nfds_t pos)
+{
+#ifdef HAVE_EPOLL
+	struct fd_handler *h = &m->handler;
+	struct epoll_event ev = {};
+	int fd = h->pfds[pos].fd;
+	int op;
+
+	if (h->backend == THREAD_IO_POLL)
+		return;
+
+	ev.events = poll2epoll(h, h->pfds[pos].events);
+	ev.data.fd = fd;
+
+	/* Nothing to wait for: the kernel would still report EPOLLHUP and
+	 * EPOLLERR for an fd left in the set, so take it out until the next
+	 * task registers for it.
+	 */
+	if (!ev.events) {
+		if (h->epoll_set[fd])
+			epoll_ctl(h->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+		h->epoll_set[fd] = false;
+		return;
+	}
+
+	op = h->epoll_set[fd] ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+	h->epoll_set[fd] = true;
+
+	if (epoll_ctl(h->epoll_fd, op, fd, &ev) == 0)
+		return;
+
+	/* Closing an fd silently drops it from the epoll set, so a pollfd
+	 * we still know about may be gone from the kernel (or a reused fd
+	 * may already be there).  Retry with the other operation.
+	 */
+	if (errno == ENOENT || errno == EEXIST) {
+		op = (op == EPOLL_CTL_ADD) ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+		if (epoll_ctl(h->epoll_fd, op, fd, &ev) == 0)
+			return;
+	}
+
+	h->epoll_set[fd] = false;
+	flog_err(EC_LIB_SYSTEM_CALL, "%s: epoll_ctl(%d) for fd %d failed: %s",
+		 __func__, op, fd, safe_strerror(errno));
+#endif
+}
+
+/* Delete pfds[pos], keeping the fd -> position index up to date. */
+static void fd_handler_remove(struct thread_master *m, nfds_t pos)
+{
+	struct fd_handler *h = &m->handler;
+	int fd = h->pfds[pos].fd;
+
+#ifdef HAVE_EPOLL
+	/* failure is fine, a closed fd has already left the epoll set */
+	if (h->backend != THREAD_IO_POLL && h->epoll_set[fd])
+		epoll_ctl(h->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+	h->epoll_set[fd] = false;
+#endif
+	h->fdpos[fd] = -1;
+
+	memmove(h->pfds + pos, h->pfds + pos + 1,
+		(h->pfdcount - pos - 1) * sizeof(struct pollfd));
+	h->pfdcount--;
+	h->pfds[h->pfdcount].fd = 0;
+	h->pfds[h->pfdcount].events = 0;
+
+	for (nfds_t i = pos; i < h->pfdcount; i++)
+		h->fdpos[h->pfds[i].fd] = i;
+}
+
+/* (Re)initialize the backend; callers make sure no fds are registered. */
+static void fd_handler_backend_init(struct thread_master *m,
+				    enum thread_io_backend backend)
+{
+	struct fd_handler *h = &m->handler;
+
+#ifdef HAVE_EPOLL
+	struct epoll_event ev = {};
+
+	if (h->backend != THREAD_IO_POLL) {
+		close(h->epoll_fd);
+		XFREE(MTYPE_THREAD_MASTER, h->events);
+	}
+	h->backend = THREAD_IO_POLL;
+	h->epoll_fd = -1;
+
+	if (backend == THREAD_IO_POLL)
+		return;
+
+	h->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (h->epoll_fd < 0) {
+		flog_err(EC_LIB_SYSTEM_CALL,
+			 "%s: epoll_create1() failed, using poll(): %s",
+			 __func__, safe_strerror(errno));
+		return;
+	}
+
+	/* the pipe poker stays registered for the lifetime of the set */
+	ev.events = EPOLLIN;
+	ev.data.fd = m->io_pipe[0];
+	if (epoll_ctl(h->epoll_fd, EPOLL_CTL_ADD, m->io_pipe[0], &ev) < 0) {
+		flog_err(EC_LIB_SYSTEM_CALL,
+			 "%s: epoll_ctl() on pipe poker failed, using poll(): %s",
+			 __func__, safe_strerror(errno));
+		close(h->epoll_fd);
+		h->epoll_fd = -1;
+		return;
+	}
+
+	h->eventsize = MIN(m->fd_limit, THREAD_EPOLL_EVENTS);
+	h->events = XCALLOC(MTYPE_THREAD_MASTER,
+			    sizeof(struct epoll_event) * h->eventsize);
+	h->backend = backend;
+#else
+	h->backend = THREAD_IO_POLL;
+#endif
+}
+
+int thread_master_set_io_backend(struct thread_master *m,
+				 enum thread_io_backend backend)
+{
+	int ret = 0;
+
+	frr_with_mutex (&m->mtx) {
+		if (m->handler.pfdcount) {
+			ret = -1;
+			break;
+		}
+
+		fd_handler_backend_init(m, backend);
+		if (m->handler.backend != backend)
+			ret = -1;
+	}
+	return ret;
+}
+
 /* initializer, only ever called once */
 static void initializer(void)
 {
@@ -611,6 +816,16 @@ struct thread_master *thread_master_create(const char *name)
 				   sizeof(struct pollfd) * rv->handler.pfdsize);
 	rv->handler.copy = XCALLOC(MTYPE_THREAD_MASTER,
 				   sizeof(struct pollfd) * rv->handler.pfdsize);
+	rv->handler.fdpos = XMALLOC(MTYPE_THREAD_MASTER,
+				    sizeof(int) * rv->fd_limit);
+	for (int i = 0; i < rv->fd_limit; i++)
+		rv->handler.fdpos[i] = -1;
+#ifdef HAVE_EPOLL
+	rv->handler.epoll_set = XCALLOC(MTYPE_THREAD_MASTER,
+					sizeof(bool) * rv->fd_limit);
+#endif
+
+	fd_handler_backend_init(rv, io_backend_default);
 
 	/* add to list of threadmasters */
 	frr_with_mutex (&masters_mtx) {
@@ -719,6 +934,7 @@ void thread_master_free(struct thread_master *m)
 	thread_list_free(m, &m->unuse);
 	pthread_mutex_destroy(&m->mtx);
 	pthread_cond_destroy(&m->cancel_cond);
+	fd_handler_backend_init(m, THREAD_IO_POLL);
 	close(m->io_pipe[0]);
 	close(m->io_pipe[1]);
 	list_delete(&m->cancel_req);
@@ -731,6 +947,10 @@ void thread_master_free(struct thread_master *m)
 	XFREE(MTYPE_THREAD_MASTER, m->name);
 	XFREE(MTYPE_THREAD_MASTER, m->handler.pfds);
 	XFREE(MTYPE_THREAD_MASTER, m->handler.copy);
+	XFREE(MTYPE_THREAD_MASTER, m->handler.fdpos);
+#ifdef HAVE_EPOLL
+	XFREE(MTYPE_THREAD_MASTER, m->handler.epoll_set);
+#endif
 	XFREE(MTYPE_THREAD_MASTER, m);
 }
 
@@ -853,6 +1073,26 @@ static void thread_free(struct thread_master *master, struct thread *thread)
 	XFREE(MTYPE_THREAD, thread);
 }
 
+#ifdef HAVE_EPOLL
+/* Drain the pipe poker and drop it from the epoll results. */
+static int fd_epoll_strip_poker(struct thread_master *m, int num)
+{
+	struct epoll_event *events = m->handler.events;
+	unsigned char trash[64];
+
+	for (int i = 0; i < num; i++) {
+		if (events[i].data.fd != m->io_pipe[0])
+			continue;
+
+		while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
+			;
+		events[i] = events[--num];
+		break;
+	}
+	return num;
+}
+#endif
+
 static int fd_poll(struct thread_master *m, const struct timeval *timer_wait,
 		   bool *eintr_p)
 {
@@ -918,6 +1158,15 @@ static int fd_poll(struct thread_master *m, const struct timeval *timer_wait,
 		pthread_sigmask(SIG_SETMASK, NULL, &origsigs);
 	}
 
+#ifdef HAVE_EPOLL
+	if (m->handler.backend != THREAD_IO_POLL) {
+		num = epoll_pwait(m->handler.epoll_fd, m->handler.events,
+				  m->handler.eventsize, timeout, &origsigs);
+		pthread_sigmask(SIG_SETMASK, &origsigs, NULL);
+		goto done;
+	}
+#endif
+
 #if defined(HAVE_PPOLL)
 	struct timespec ts, *tsp;
 
@@ -941,6 +1190,11 @@ done:
 	if (num < 0 && errno == EINTR)
 		*eintr_p = true;
 
+#ifdef HAVE_EPOLL
+	if (num > 0 && m->handler.backend != THREAD_IO_POLL)
+		num = fd_epoll_strip_poker(m, num);
+#endif
+
 	if (num > 0 && m->handler.copy[count].revents != 0 && num--)
 		while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
 			;
@@ -986,22 +1240,19 @@ void _thread_add_read_write(const struct xref_threadsched *xref,
 		else
 			thread_array = m->write;
 
-		/* if we already have a pollfd for our file descriptor, find and
-		 * use it */
-		for (nfds_t i = 0; i < m->handler.pfdcount; i++)
-			if (m->handler.pfds[i].fd == fd) {
-				queuepos = i;
+		/* if we already have a pollfd for our file descriptor, use it */
+		if (m->handler.fdpos[fd] >= 0) {
+			queuepos = m->handler.fdpos[fd];
 
 #ifdef DEV_BUILD
-				/*
-				 * What happens if we have a thread already
-				 * created for this event?
-				 */
-				if (thread_array[fd])
-					assert(!"Thread already scheduled for file descriptor");
+			/*
+			 * What happens if we have a thread already
+			 * created for this event?
+			 */
+			if (thread_array[fd])
+				assert(!"Thread already scheduled for file descriptor");
 #endif
-				break;
-			}
+		}
 
 		/* make sure we have room for this fd + pipe poker fd */
 		assert(queuepos + 1 < m->handler.pfdsize);
@@ -1012,8 +1263,12 @@ void _thread_add_read_write(const struct xref_threadsched *xref,
 		m->handler.pfds[queuepos].events |=
 			(dir == THREAD_READ ? POLLIN : POLLOUT);
 
-		if (queuepos == m->handler.pfdcount)
+		if (queuepos == m->handler.pfdcount) {
+			m->handler.fdpos[fd] = queuepos;
 			m->handler.pfdcount++;
+		}
+
+		fd_handler_sync(m, queuepos);
 
 		if (thread) {
 			frr_with_mutex (&thread->mtx) {
@@ -1027,7 +1282,9 @@ void _thread_add_read_write(const struct xref_threadsched *xref,
 			}
 		}
 
-		AWAKEN(m);
+		/* epoll_ctl() takes effect on a concurrent epoll_wait() */
+		if (m->handler.backend == THREAD_IO_POLL)
+			AWAKEN(m);
 	}
 }
 
@@ -1188,13 +1445,9 @@ static void thread_cancel_rw(struct thread_master *master, int fd, short state,
 	if (idx_hint >= 0) {
 		i = idx_hint;
 		found = true;
-	} else {
-		/* Have to look for the fd in the pfd array */
-		for (i = 0; i < master->handler.pfdcount; i++)
-			if (master->handler.pfds[i].fd == fd) {
-				found = true;
-				break;
-			}
+	} else if (fd < master->fd_limit && master->handler.fdpos[fd] >= 0) {
+		i = master->handler.fdpos[fd];
+		found = true;
 	}
 
 	if (!found) {
@@ -1209,14 +1462,10 @@ static void thread_cancel_rw(struct thread_master *master, int fd, short state,
 	master->handler.pfds[i].events &= ~(state);
 
 	/* If all events are canceled, delete / resize the pollfd array. */
-	if (master->handler.pfds[i].events == 0) {
-		memmove(master->handler.pfds + i, master->handler.pfds + i + 1,
-			(master->handler.pfdcount - i - 1)
-				* sizeof(struct pollfd));
-		master->handler.pfdcount--;
-		master->handler.pfds[master->handler.pfdcount].fd = 0;
-		master->handler.pfds[master->handler.pfdcount].events = 0;
-	}
+	if (master->handler.pfds[i].events == 0)
+		fd_handler_remove(master, i);
+	else
+		fd_handler_sync(master, i);
 
 	/* If we have the same pollfd in the copy, perform the same operations,
 	 * otherwise return. */
@@ -1620,6 +1869,49 @@ static int thread_process_io_helper(struct thread_master *m,
 	return 1;
 }
 
+#ifdef HAVE_EPOLL
+/*
+ * epoll variant of thread_process_io(): only the fds that are actually ready
+ * are visited, and the fd -> pfds index replaces the scan over all pollfds.
+ */
+static void thread_process_io_epoll(struct thread_master *m, unsigned int num)
+{
+	struct fd_handler *h = &m->handler;
+
+	for (unsigned int i = 0; i < num; i++) {
+		int fd = h->events[i].data.fd;
+		short revents = epoll2poll(h->events[i].events);
+		struct pollfd *pfd;
+		int pos = h->fdpos[fd];
+
+		/* cancelled while we were waiting */
+		if (pos < 0)
+			continue;
+
+		pfd = &h->pfds[pos];
+
+		/* errors and hangups wake up whoever waits on the fd, the
+		 * subsequent read()/write() will report the actual problem
+		 */
+		if ((revents & (POLLIN | POLLHUP | POLLERR))
+		    && (pfd->events & POLLIN))
+			thread_process_io_helper(m, m->read[fd], POLLIN,
+						 revents, pos);
+		if ((revents & (POLLOUT | POLLHUP | POLLERR))
+		    && (pfd->events & POLLOUT))
+			thread_process_io_helper(m, m->write[fd], POLLOUT,
+						 revents, pos);
+
+		/* Level-triggered fds must be disarmed for what just fired;
+		 * one-shot fds were disarmed by the kernel and only need to
+		 * be re-armed if a task still waits for the other direction.
+		 */
+		if (pfd->events || h->backend == THREAD_IO_EPOLL)
+			fd_handler_sync(m, pos);
+	}
+}
+#endif
+
 /**
  * Process I/O events.
  *
@@ -1634,6 +1926,13 @@ static void thread_process_io(struct thread_master *m, unsigned int num)
 	unsigned int ready = 0;
 	struct pollfd *pfds = m->handler.copy;
 
+#ifdef HAVE_EPOLL
+	if (m->handler.backend != THREAD_IO_POLL) {
+		thread_process_io_epoll(m, num);
+		return;
+	}
+#endif
+
 	for (nfds_t i = 0; i < m->handler.copycount && ready < num; ++i) {
 		/* no event for current fd? immediately continue */
 		if (pfds[i].revents == 0)
@@ -1667,12 +1966,7 @@ static void thread_process_io(struct thread_master *m, unsigned int num)
 		 * from
 		 * both pfds + update sizes and index */
 		if (pfds[i].revents & POLLNVAL) {
-			memmove(m->handler.pfds + i, m->handler.pfds + i + 1,
-				(m->handler.pfdcount - i - 1)
-					* sizeof(struct pollfd));
-			m->handler.pfdcount--;
-			m->handler.pfds[m->handler.pfdcount].fd = 0;
-			m->handler.pfds[m->handler.pfdcount].events = 0;
+			fd_handler_remove(m, i);
 
 			memmove(pfds + i, pfds + i + 1,
 				(m->handler.copycount - i - 1)
@@ -1819,11 +2113,14 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 
 		/*
 		 * Copy pollfd array + # active pollfds in it. Not necessary to
-		 * copy the array size as this is fixed.
+		 * copy the array size as this is fixed.  epoll keeps its
+		 * interest set in the kernel and does not need the copy.
 		 */
-		m->handler.copycount = m->handler.pfdcount;
-		memcpy(m->handler.copy, m->handler.pfds,
-		       m->handler.copycount * sizeof(struct pollfd));
+		if (m->handler.backend == THREAD_IO_POLL) {
+			m->handler.copycount = m->handler.pfdcount;
+			memcpy(m->handler.copy, m->handler.pfds,
+			       m->handler.copycount * sizeof(struct pollfd));
+		}
 
 		pthread_mutex_unlock(&m->mtx);
 		{
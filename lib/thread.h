@@ -9,6 +9,9 @@
 #include <zebra.h>
 #include <pthread.h>
 #include <poll.h>
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
 #include "monotime.h"
 #include "frratomic.h"
 #include "typesafe.h"
@@ -40,7 +43,18 @@ struct rusage_t {
 PREDECL_LIST(thread_list);
 PREDECL_HEAP(thread_timer_list);
 
+/* Mechanism used by a thread_master to wait for I/O readiness. */
+enum thread_io_backend {
+	THREAD_IO_POLL = 0,
+	/* level-triggered epoll, fds are disarmed when their task fires */
+	THREAD_IO_EPOLL,
+	/* edge-triggered one-shot epoll, the kernel disarms fds for us */
+	THREAD_IO_EPOLL_ET,
+};
+
 struct fd_handler {
+	enum thread_io_backend backend;
+
 	/* number of pfd that fit in the allocated space of pfds. This is a
 	 * constant and is the same for both pfds and copy.
 	 */
@@ -55,6 +69,18 @@ struct fd_handler {
 	struct pollfd *copy;
 	/* number of pollfds stored in copy */
 	nfds_t copycount;
+
+	/* index of each fd's pollfd in pfds, -1 if none.  Indexed by fd. */
+	int *fdpos;
+
+#ifdef HAVE_EPOLL
+	int epoll_fd;
+	/* whether each fd is in the epoll set.  Indexed by fd. */
+	bool *epoll_set;
+	/* result buffer for epoll_wait() */
+	struct epoll_event *events;
+	int eventsize;
+#endif
 };
 
 struct xref_threadsched {
@@ -207,6 +233,14 @@ struct cpu_thread_history {
 /* Prototypes. */
 extern struct thread_master *thread_master_create(const char *);
 void thread_master_set_name(struct thread_master *master, const char *name);
+/* Switch the I/O backend; only possible while no fds are registered. */
+extern int thread_master_set_io_backend(struct thread_master *master,
+					enum thread_io_backend backend);
+/* Default backend for thread_masters created after this call, takes
+ * "poll", "epoll" or "epoll-et".  Returns false on unknown/unsupported.
+ */
+extern bool thread_io_backend_set_default(const char *name);
+extern const char *thread_io_backend_name(enum thread_io_backend backend);
 extern void thread_master_free(struct thread_master *);
 extern void thread_master_free_unused(struct thread_master *);
 
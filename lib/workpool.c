@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Worker pthread pool for parallel loops.
+ */
+
+#include <zebra.h>
+#include <pthread.h>
+
+#include "frr_pthread.h"
+#include "frratomic.h"
+#include "frrcu.h"
+#include "memory.h"
+#include "workpool.h"
+
+DEFINE_MTYPE_STATIC(LIB, WORKPOOL, "Worker pool");
+
+/*
+ * A parallel-for over [0, count). Indices are handed out one at a time from
+ * 'next', so uneven per-index cost balances out across the workers.
+ */
+struct workpool_job {
+	void (*func)(void *arg, size_t idx);
+	void *arg;
+	size_t count;
+
+	atomic_size_t next;
+};
+
+struct workpool {
+	pthread_mutex_t mtx;
+	/* signalled when a new job is posted, or on shutdown */
+	pthread_cond_t work_cond;
+	/* signalled when the last worker leaves a job */
+	pthread_cond_t done_cond;
+
+	/* configured number of workers, including the calling pthread */
+	unsigned int workers;
+
+	struct frr_pthread **threads;
+	unsigned int nthreads;
+
+	/* current job; 'generation' tells workers whether they've seen it */
+	struct workpool_job *job;
+	uint64_t generation;
+	/* number of workers currently working on 'job' */
+	unsigned int active;
+
+	char name[32];
+	char os_name[OS_THREAD_NAMELEN];
+};
+
+static void workpool_job_work(struct workpool_job *job)
+{
+	size_t idx;
+
+	while ((idx = atomic_fetch_add_explicit(&job->next, 1,
+						memory_order_relaxed)) <
+	       job->count)
+		job->func(job->arg, idx);
+}
+
+static void *workpool_worker_start(void *arg)
+{
+	struct frr_pthread *fpt = arg;
+	struct workpool *wp = fpt->data;
+	struct workpool_job *job;
+	uint64_t seen;
+
+	/* Not an event loop pthread, see bgp_keepalives_start() */
+	rcu_read_unlock();
+
+	frr_pthread_set_name(fpt);
+	frr_pthread_notify_running(fpt);
+
+	pthread_mutex_lock(&wp->mtx);
+	seen = wp->generation;
+
+	while (atomic_load_explicit(&fpt->running, memory_order_relaxed)) {
+		if (!wp->job || wp->generation == seen) {
+			pthread_cond_wait(&wp->work_cond, &wp->mtx);
+			continue;
+		}
+
+		job = wp->job;
+		seen = wp->generation;
+		wp->active++;
+
+		pthread_mutex_unlock(&wp->mtx);
+		workpool_job_work(job);
+		pthread_mutex_lock(&wp->mtx);
+
+		if (--wp->active == 0)
+			pthread_cond_signal(&wp->done_cond);
+	}
+
+	pthread_mutex_unlock(&wp->mtx);
+
+	return NULL;
+}
+
+static int workpool_worker_stop(struct frr_pthread *fpt, void **result)
+{
+	struct workpool *wp = fpt->data;
+
+	assert(fpt->running);
+
+	frr_with_mutex (&wp->mtx) {
+		atomic_store_explicit(&fpt->running, false,
+				      memory_order_relaxed);
+		pthread_cond_broadcast(&wp->work_cond);
+	}
+
+	pthread_join(fpt->thread, result);
+	return 0;
+}
+
+void workpool_stop(struct workpool *wp)
+{
+	unsigned int i;
+
+	for (i = 0; i < wp->nthreads; i++) {
+		if (atomic_load_explicit(&wp->threads[i]->running,
+					 memory_order_relaxed))
+			frr_pthread_stop(wp->threads[i], NULL);
+		frr_pthread_destroy(wp->threads[i]);
+	}
+
+	XFREE(MTYPE_WORKPOOL, wp->threads);
+	wp->nthreads = 0;
+}
+
+/* Bring the worker pthreads in line with the configuration */
+static void workpool_threads_update(struct workpool *wp)
+{
+	struct frr_pthread_attr attr = {
+		.start = workpool_worker_start,
+		.stop = workpool_worker_stop,
+	};
+	unsigned int want = wp->workers - 1;
+	char name[48], os_name[OS_THREAD_NAMELEN];
+	unsigned int i;
+
+	if (want == wp->nthreads)
+		return;
+
+	workpool_stop(wp);
+	if (!want)
+		return;
+
+	wp->threads = XCALLOC(MTYPE_WORKPOOL, want * sizeof(*wp->threads));
+
+	for (i = 0; i < want; i++) {
+		snprintf(name, sizeof(name), "%s %u", wp->name, i);
+		snprintf(os_name, sizeof(os_name), "%s%u", wp->os_name, i);
+
+		wp->threads[i] = frr_pthread_new(&attr, name, os_name);
+		wp->threads[i]->data = wp;
+		frr_pthread_run(wp->threads[i], NULL);
+	}
+	for (i = 0; i < want; i++)
+		frr_pthread_wait_running(wp->threads[i]);
+
+	wp->nthreads = want;
+}
+
+struct workpool *workpool_new(const char *name, const char *os_name)
+{
+	struct workpool *wp = XCALLOC(MTYPE_WORKPOOL, sizeof(*wp));
+
+	pthread_mutex_init(&wp->mtx, NULL);
+	pthread_cond_init(&wp->work_cond, NULL);
+	pthread_cond_init(&wp->done_cond, NULL);
+	wp->workers = 1;
+	strlcpy(wp->name, name, sizeof(wp->name));
+	strlcpy(wp->os_name, os_name, sizeof(wp->os_name));
+	return wp;
+}
+
+void workpool_free(struct workpool **wpp)
+{
+	struct workpool *wp = *wpp;
+
+	if (!wp)
+		return;
+
+	workpool_stop(wp);
+	pthread_cond_destroy(&wp->done_cond);
+	pthread_cond_destroy(&wp->work_cond);
+	pthread_mutex_destroy(&wp->mtx);
+	XFREE(MTYPE_WORKPOOL, *wpp);
+}
+
+void workpool_set_workers(struct workpool *wp, unsigned int workers)
+{
+	if (workers < 1)
+		workers = 1;
+	if (workers > WORKPOOL_WORKERS_MAX)
+		workers = WORKPOOL_WORKERS_MAX;
+
+	wp->workers = workers;
+}
+
+unsigned int workpool_get_workers(const struct workpool *wp)
+{
+	return wp->workers;
+}
+
+void workpool_run(struct workpool *wp, void (*func)(void *arg, size_t idx),
+		  void *arg, size_t count)
+{
+	struct workpool_job job = {
+		.func = func,
+		.arg = arg,
+		.count = count,
+	};
+
+	atomic_store_explicit(&job.next, 0, memory_order_relaxed);
+
+	workpool_threads_update(wp);
+
+	if (wp->nthreads == 0 || count < 2) {
+		workpool_job_work(&job);
+		return;
+	}
+
+	frr_with_mutex (&wp->mtx) {
+		wp->job = &job;
+		wp->generation++;
+		pthread_cond_broadcast(&wp->work_cond);
+	}
+
+	/* The calling pthread takes its share as well */
+	workpool_job_work(&job);
+
+	frr_with_mutex (&wp->mtx) {
+		while (wp->active)
+			pthread_cond_wait(&wp->done_cond, &wp->mtx);
+		wp->job = NULL;
+	}
+}
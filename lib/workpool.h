@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Worker pthread pool for parallel loops.
+ *
+ * Runs func(arg, idx) for a range of indices on a set of worker pthreads and
+ * the calling pthread, and returns once all of them are done.  Meant for the
+ * read-mostly parts of bulk work on the main pthread, e.g. best path
+ * selection, where the main pthread waits for the result anyway.
+ */
+
+#ifndef _FRR_WORKPOOL_H
+#define _FRR_WORKPOOL_H
+
+#include "memory.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WORKPOOL_WORKERS_MAX 64
+
+struct workpool;
+
+/*
+ * Creates a pool with a single worker, i.e. without pthreads of its own.
+ *
+ * name
+ *    prefix of the pthread names, the worker number is appended
+ *
+ * os_name
+ *    prefix of the OS pthread names, at most OS_THREAD_NAMELEN - 3 chars
+ */
+extern struct workpool *workpool_new(const char *name, const char *os_name);
+
+/*
+ * Stops the pool's pthreads and frees it.
+ */
+extern void workpool_free(struct workpool **wpp);
+
+/*
+ * Sets the number of pthreads taking part in workpool_run(), including the
+ * calling pthread.  With one worker everything runs in the calling pthread.
+ *
+ * Worker pthreads are started on the next workpool_run(), so configuration
+ * read before fork() doesn't start any.  Must not be called while
+ * workpool_run() is running.
+ */
+extern void workpool_set_workers(struct workpool *wp, unsigned int workers);
+
+/*
+ * Returns the configured number of workers, including the calling pthread.
+ */
+extern unsigned int workpool_get_workers(const struct workpool *wp);
+
+/*
+ * Calls func(arg, idx) for every idx in [0, count), spread over the worker
+ * pthreads and the calling pthread.  Indices are handed out one at a time,
+ * so uneven per-index cost balances out.  Returns once all calls have
+ * completed.
+ *
+ * The calling pthread is blocked in here while the workers run, so func may
+ * read anything the calling pthread owns without locking, but must not
+ * modify state shared with other calls.
+ */
+extern void workpool_run(struct workpool *wp,
+			 void (*func)(void *arg, size_t idx), void *arg,
+			 size_t count);
+
+/*
+ * Stops the worker pthreads, e.g. at shutdown.  They are started again on
+ * the next workpool_run().
+ */
+extern void workpool_stop(struct workpool *wp);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_WORKPOOL_H */
@@ -28,6 +28,7 @@
 #include "srte.h"
 #include "printfrr.h"
 #include "srv6.h"
+#include "shmring.h"
 
 DEFINE_MTYPE_STATIC(LIB, ZCLIENT, "Zclient");
 DEFINE_MTYPE_STATIC(LIB, REDIST_INST, "Redistribution instance IDs");
@@ -38,6 +39,8 @@ enum zclient_event { ZCLIENT_SCHEDULE, ZCLIENT_READ, ZCLIENT_CONNECT };
 /* Prototype for event manager. */
 static void zclient_event(enum zclient_event, struct zclient *);
 
+static void zclient_ring_stop(struct zclient *zclient);
+
 static void zebra_interface_if_set_value(struct stream *s,
 					 struct interface *ifp);
 
@@ -50,6 +53,17 @@ socklen_t zclient_addr_len;
 /* This file local debug flag. */
 static int zclient_debug;
 
+/* Size of the shared memory ring offered to zebra, 0 for none. */
+static size_t zclient_ring_size;
+
+/* Seconds to wait for zebra to accept or reject the ring. */
+#define ZCLIENT_RING_REPLY_TIMEOUT 10
+
+void zclient_ring_set_default(size_t size)
+{
+	zclient_ring_size = size;
+}
+
 /* Allocate zclient structure. */
 struct zclient *zclient_new(struct thread_master *master,
 			    struct zclient_options *opt,
@@ -86,8 +100,13 @@ void zclient_free(struct zclient *zclient)
 		stream_free(zclient->ibuf);
 	if (zclient->obuf)
 		stream_free(zclient->obuf);
+	if (zclient->bulk)
+		stream_free(zclient->bulk);
+	if (zclient->bulk_scratch)
+		stream_free(zclient->bulk_scratch);
 	if (zclient->wb)
 		buffer_free(zclient->wb);
+	zclient_ring_stop(zclient);
 
 	XFREE(MTYPE_ZCLIENT, zclient);
 }
@@ -163,13 +182,16 @@ void zclient_stop(struct zclient *zclient)
 	THREAD_OFF(zclient->t_read);
 	THREAD_OFF(zclient->t_connect);
 	THREAD_OFF(zclient->t_write);
+	THREAD_OFF(zclient->t_bulk);
 
 	/* Reset streams. */
 	stream_reset(zclient->ibuf);
 	stream_reset(zclient->obuf);
+	zclient->bulk_count = 0;
 
 	/* Empty the write buffer. */
 	buffer_reset(zclient->wb);
+	zclient_ring_stop(zclient);
 
 	/* Close socket. */
 	if (zclient->sock >= 0) {
@@ -282,13 +304,12 @@ static void zclient_flush_data(struct thread *thread)
  * ZCLIENT_SEND_SUCCESS  - means we sent data to zebra
  * ZCLIENT_SEND_BUFFERED - means we are buffering
  */
-enum zclient_send_status zclient_send_message(struct zclient *zclient)
+static enum zclient_send_status zclient_write_sock(struct zclient *zclient,
+						   const void *data, size_t len)
 {
 	if (zclient->sock < 0)
 		return ZCLIENT_SEND_FAILURE;
-	switch (buffer_write(zclient->wb, zclient->sock,
-			     STREAM_DATA(zclient->obuf),
-			     stream_get_endp(zclient->obuf))) {
+	switch (buffer_write(zclient->wb, zclient->sock, data, len)) {
 	case BUFFER_ERROR:
 		flog_err(EC_LIB_ZAPI_SOCKET,
 			 "%s: buffer_write failed to zclient fd %d, closing",
@@ -307,6 +328,132 @@ enum zclient_send_status zclient_send_message(struct zclient *zclient)
 	return ZCLIENT_SEND_SUCCESS;
 }
 
+/* Lets zebra know there is something in the ring, if it went idle. */
+static enum zclient_send_status zclient_ring_kick(struct zclient *zclient)
+{
+	struct stream *s = zclient->ring_doorbell;
+
+	if (!shmring_wakeup(zclient->ring))
+		return ZCLIENT_SEND_SUCCESS;
+
+	return zclient_write_sock(zclient, STREAM_DATA(s), stream_get_endp(s));
+}
+
+static void zclient_ring_flush(struct thread *thread)
+{
+	struct zclient *zclient = THREAD_ARG(thread);
+	struct stream *s;
+	bool sent = false;
+
+	while ((s = stream_fifo_head(zclient->ring_backlog))) {
+		if (!shmring_put(zclient->ring, STREAM_DATA(s),
+				 stream_get_endp(s)))
+			break;
+		stream_free(stream_fifo_pop(zclient->ring_backlog));
+		sent = true;
+	}
+
+	/* on failure zclient_stop() has already torn the ring down */
+	if (sent && zclient_ring_kick(zclient) == ZCLIENT_SEND_FAILURE)
+		return;
+
+	/* zebra is behind, look again in a bit */
+	if (stream_fifo_head(zclient->ring_backlog))
+		thread_add_timer_msec(zclient->master, zclient_ring_flush,
+				      zclient, 1, &zclient->t_ring);
+	else if (zclient->zebra_buffer_write_ready)
+		(*zclient->zebra_buffer_write_ready)();
+}
+
+static enum zclient_send_status zclient_ring_send(struct zclient *zclient,
+						  struct stream *s)
+{
+	/* nothing may overtake the backlog */
+	if (!stream_fifo_head(zclient->ring_backlog)
+	    && shmring_put(zclient->ring, STREAM_DATA(s), stream_get_endp(s)))
+		return zclient_ring_kick(zclient);
+
+	stream_fifo_push(zclient->ring_backlog, stream_dup(s));
+	thread_add_timer_msec(zclient->master, zclient_ring_flush, zclient, 1,
+			      &zclient->t_ring);
+	return ZCLIENT_SEND_BUFFERED;
+}
+
+static enum zclient_send_status zclient_send_stream(struct zclient *zclient,
+						    struct stream *s)
+{
+	/* Switch over only once everything written to the socket so far is
+	 * out, zebra reads whatever precedes the first doorbell first.
+	 */
+	if (zclient->ring_accepted && !zclient->ring_active
+	    && buffer_empty(zclient->wb)) {
+		zclient->ring_active = true;
+		if (zclient_debug)
+			zlog_debug("zclient %p switching to ring %s", zclient,
+				   zclient->ring->name);
+	}
+
+	if (zclient->ring_active)
+		return zclient_ring_send(zclient, s);
+
+	return zclient_write_sock(zclient, STREAM_DATA(s), stream_get_endp(s));
+}
+
+/* zebra never answered the hello, e.g. it doesn't know about rings */
+static void zclient_ring_reply_timeout(struct thread *thread)
+{
+	struct zclient *zclient = THREAD_ARG(thread);
+
+	if (zclient_debug)
+		zlog_debug("zclient %p ring %s not acknowledged, dropping it",
+			   zclient, zclient->ring->name);
+
+	zclient_ring_stop(zclient);
+}
+
+static void zclient_ring_start(struct zclient *zclient)
+{
+	struct stream *s;
+
+	zclient->ring = shmring_create(zclient_ring_size);
+	if (!zclient->ring)
+		return;
+
+	zclient->ring_backlog = stream_fifo_new();
+
+	s = zclient->ring_doorbell = stream_new(ZEBRA_HEADER_SIZE);
+	zclient_create_header(s, ZEBRA_RING_DOORBELL, VRF_DEFAULT);
+}
+
+static void zclient_ring_stop(struct zclient *zclient)
+{
+	THREAD_OFF(zclient->t_ring);
+
+	if (zclient->ring) {
+		shmring_del(zclient->ring);
+		zclient->ring = NULL;
+	}
+	if (zclient->ring_backlog) {
+		stream_fifo_free(zclient->ring_backlog);
+		zclient->ring_backlog = NULL;
+	}
+	if (zclient->ring_doorbell) {
+		stream_free(zclient->ring_doorbell);
+		zclient->ring_doorbell = NULL;
+	}
+	zclient->ring_accepted = false;
+	zclient->ring_active = false;
+}
+
+enum zclient_send_status zclient_send_message(struct zclient *zclient)
+{
+	/* routes collected for a bulk message go first */
+	if (zclient->bulk_count)
+		zclient_route_bulk_flush(zclient);
+
+	return zclient_send_stream(zclient, zclient->obuf);
+}
+
 /*
  * If we add more data to this structure please ensure that
  * struct zmsghdr in lib/zclient.h is updated as appropriate.
@@ -384,6 +531,10 @@ enum zclient_send_status zclient_send_hello(struct zclient *zclient)
 	struct stream *s;
 
 	if (zclient->redist_default || zclient->synchronous) {
+		if (zclient_ring_size && !zclient->synchronous
+		    && zclient->master && !zclient->ring)
+			zclient_ring_start(zclient);
+
 		s = zclient->obuf;
 		stream_reset(s);
 
@@ -400,6 +551,24 @@ enum zclient_send_status zclient_send_hello(struct zclient *zclient)
 			stream_putc(s, 1);
 		else
 			stream_putc(s, 0);
+		/* optional, zebra answers with ZEBRA_RING_REPLY */
+		if (zclient->ring) {
+			size_t len = strlen(zclient->ring->name);
+
+			stream_putl(s, zclient->ring->size);
+			stream_putc(s, len);
+			stream_put(s, zclient->ring->name, len);
+
+			/* t_ring is only used for the backlog once zebra
+			 * accepted the ring
+			 */
+			if (!zclient->ring_accepted)
+				thread_add_timer(zclient->master,
+						 zclient_ring_reply_timeout,
+						 zclient,
+						 ZCLIENT_RING_REPLY_TIMEOUT,
+						 &zclient->t_ring);
+		}
 
 		stream_putw_at(s, 0, stream_get_endp(s));
 		return zclient_send_message(zclient);
@@ -1193,15 +1362,9 @@ enum zclient_send_status zclient_nhg_send(struct zclient *zclient, int cmd,
 	return zclient_send_message(zclient);
 }
 
-int zapi_route_encode(uint8_t cmd, struct stream *s, struct zapi_route *api)
+/* Type and flags, which come ahead of the prefix */
+static int zapi_route_encode_type(struct stream *s, struct zapi_route *api)
 {
-	struct zapi_nexthop *api_nh;
-	int i;
-	int psize;
-
-	stream_reset(s);
-	zclient_create_header(s, cmd, api->vrf_id);
-
 	if (api->type >= ZEBRA_ROUTE_MAX) {
 		flog_err(EC_LIB_ZAPI_ENCODE,
 			 "%s: Specified route type (%u) is not a legal value",
@@ -1222,17 +1385,14 @@ int zapi_route_encode(uint8_t cmd, struct stream *s, struct zapi_route *api)
 	}
 	stream_putc(s, api->safi);
 
-	/* Put prefix information. */
-	stream_putc(s, api->prefix.family);
-	psize = PSIZE(api->prefix.prefixlen);
-	stream_putc(s, api->prefix.prefixlen);
-	stream_write(s, &api->prefix.u.prefix, psize);
+	return 0;
+}
 
-	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)) {
-		psize = PSIZE(api->src_prefix.prefixlen);
-		stream_putc(s, api->src_prefix.prefixlen);
-		stream_write(s, (uint8_t *)&api->src_prefix.prefix, psize);
-	}
+/* Nexthops and attributes, which follow the prefix */
+static int zapi_route_encode_attrs(struct stream *s, struct zapi_route *api)
+{
+	struct zapi_nexthop *api_nh;
+	int i;
 
 	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_NHG))
 		stream_putl(s, api->nhgid);
@@ -1340,6 +1500,35 @@ int zapi_route_encode(uint8_t cmd, struct stream *s, struct zapi_route *api)
 		stream_putw(s, api->opaque.length);
 		stream_write(s, api->opaque.data, api->opaque.length);
 	}
+
+	return 0;
+}
+
+int zapi_route_encode(uint8_t cmd, struct stream *s, struct zapi_route *api)
+{
+	int psize;
+
+	stream_reset(s);
+	zclient_create_header(s, cmd, api->vrf_id);
+
+	if (zapi_route_encode_type(s, api) < 0)
+		return -1;
+
+	/* Put prefix information. */
+	stream_putc(s, api->prefix.family);
+	psize = PSIZE(api->prefix.prefixlen);
+	stream_putc(s, api->prefix.prefixlen);
+	stream_write(s, &api->prefix.u.prefix, psize);
+
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)) {
+		psize = PSIZE(api->src_prefix.prefixlen);
+		stream_putc(s, api->src_prefix.prefixlen);
+		stream_write(s, (uint8_t *)&api->src_prefix.prefix, psize);
+	}
+
+	if (zapi_route_encode_attrs(s, api) < 0)
+		return -1;
+
 	/* Put length at the first point of the stream. */
 	stream_putw_at(s, 0, stream_get_endp(s));
 
@@ -1437,14 +1626,9 @@ stream_failure:
 	return ret;
 }
 
-int zapi_route_decode(struct stream *s, struct zapi_route *api)
+/* Type and flags, which come ahead of the prefix */
+static int zapi_route_decode_type(struct stream *s, struct zapi_route *api)
 {
-	struct zapi_nexthop *api_nh;
-	int i;
-
-	memset(api, 0, sizeof(*api));
-
-	/* Type, flags, message. */
 	STREAM_GETC(s, api->type);
 	if (api->type >= ZEBRA_ROUTE_MAX) {
 		flog_err(EC_LIB_ZAPI_ENCODE,
@@ -1464,58 +1648,47 @@ int zapi_route_decode(struct stream *s, struct zapi_route *api)
 		return -1;
 	}
 
-	/* Prefix. */
-	STREAM_GETC(s, api->prefix.family);
-	STREAM_GETC(s, api->prefix.prefixlen);
-	switch (api->prefix.family) {
+	return 0;
+stream_failure:
+	return -1;
+}
+
+static int zapi_route_check_prefix(const struct prefix *p)
+{
+	switch (p->family) {
 	case AF_INET:
-		if (api->prefix.prefixlen > IPV4_MAX_BITLEN) {
+		if (p->prefixlen > IPV4_MAX_BITLEN) {
 			flog_err(
 				EC_LIB_ZAPI_ENCODE,
 				"%s: V4 prefixlen is %d which should not be more than 32",
-				__func__, api->prefix.prefixlen);
+				__func__, p->prefixlen);
 			return -1;
 		}
 		break;
 	case AF_INET6:
-		if (api->prefix.prefixlen > IPV6_MAX_BITLEN) {
+		if (p->prefixlen > IPV6_MAX_BITLEN) {
 			flog_err(
 				EC_LIB_ZAPI_ENCODE,
 				"%s: v6 prefixlen is %d which should not be more than 128",
-				__func__, api->prefix.prefixlen);
+				__func__, p->prefixlen);
 			return -1;
 		}
 		break;
 	default:
 		flog_err(EC_LIB_ZAPI_ENCODE,
 			 "%s: Specified family %d is not v4 or v6", __func__,
-			 api->prefix.family);
+			 p->family);
 		return -1;
 	}
-	STREAM_GET(&api->prefix.u.prefix, s, PSIZE(api->prefix.prefixlen));
 
-	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)) {
-		api->src_prefix.family = AF_INET6;
-		STREAM_GETC(s, api->src_prefix.prefixlen);
-		if (api->src_prefix.prefixlen > IPV6_MAX_BITLEN) {
-			flog_err(
-				EC_LIB_ZAPI_ENCODE,
-				"%s: SRC Prefix prefixlen received: %d is too large",
-				__func__, api->src_prefix.prefixlen);
-			return -1;
-		}
-		STREAM_GET(&api->src_prefix.prefix, s,
-			   PSIZE(api->src_prefix.prefixlen));
+	return 0;
+}
 
-		if (api->prefix.family != AF_INET6
-		    || api->src_prefix.prefixlen == 0) {
-			flog_err(
-				EC_LIB_ZAPI_ENCODE,
-				"%s: SRC prefix specified in some manner that makes no sense",
-				__func__);
-			return -1;
-		}
-	}
+/* Nexthops and attributes, which follow the prefix */
+static int zapi_route_decode_attrs(struct stream *s, struct zapi_route *api)
+{
+	struct zapi_nexthop *api_nh;
+	int i;
 
 	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_NHG))
 		STREAM_GETL(s, api->nhgid);
@@ -1590,6 +1763,185 @@ stream_failure:
 	return -1;
 }
 
+int zapi_route_decode(struct stream *s, struct zapi_route *api)
+{
+	memset(api, 0, sizeof(*api));
+
+	/* Type, flags, message. */
+	if (zapi_route_decode_type(s, api) < 0)
+		return -1;
+
+	/* Prefix. */
+	STREAM_GETC(s, api->prefix.family);
+	STREAM_GETC(s, api->prefix.prefixlen);
+	if (zapi_route_check_prefix(&api->prefix) < 0)
+		return -1;
+	STREAM_GET(&api->prefix.u.prefix, s, PSIZE(api->prefix.prefixlen));
+
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)) {
+		api->src_prefix.family = AF_INET6;
+		STREAM_GETC(s, api->src_prefix.prefixlen);
+		if (api->src_prefix.prefixlen > IPV6_MAX_BITLEN) {
+			flog_err(
+				EC_LIB_ZAPI_ENCODE,
+				"%s: SRC Prefix prefixlen received: %d is too large",
+				__func__, api->src_prefix.prefixlen);
+			return -1;
+		}
+		STREAM_GET(&api->src_prefix.prefix, s,
+			   PSIZE(api->src_prefix.prefixlen));
+
+		if (api->prefix.family != AF_INET6
+		    || api->src_prefix.prefixlen == 0) {
+			flog_err(
+				EC_LIB_ZAPI_ENCODE,
+				"%s: SRC prefix specified in some manner that makes no sense",
+				__func__);
+			return -1;
+		}
+	}
+
+	return zapi_route_decode_attrs(s, api);
+stream_failure:
+	return -1;
+}
+
+/*
+ * Bulk route messages carry routes that only differ in their prefix.  After
+ * the header come the number of routes, the type and flags as in a single
+ * route message, the address family, the nexthops and attributes, and then
+ * the prefixes, each as prefix length and address bytes.  Routes with a
+ * source prefix or EVPN routes, whose nexthops depend on the prefix, are
+ * always sent on their own.
+ */
+#define ZAPI_BULK_COUNT_OFFSET ZEBRA_HEADER_SIZE
+
+static bool zapi_route_bulk_ok(const struct zapi_route *api)
+{
+	return !CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)
+	       && !CHECK_FLAG(api->flags, ZEBRA_FLAG_EVPN_ROUTE);
+}
+
+static void zclient_route_bulk_timer(struct thread *thread)
+{
+	struct zclient *zclient = THREAD_ARG(thread);
+
+	zclient_route_bulk_flush(zclient);
+}
+
+void zclient_route_bulk_flush(struct zclient *zclient)
+{
+	struct stream *s = zclient->bulk;
+
+	THREAD_OFF(zclient->t_bulk);
+	if (!zclient->bulk_count)
+		return;
+
+	stream_putl_at(s, ZAPI_BULK_COUNT_OFFSET, zclient->bulk_count);
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zclient->bulk_count = 0;
+
+	zclient_send_stream(zclient, s);
+}
+
+enum zclient_send_status zclient_route_send_bulk(uint8_t cmd,
+						 struct zclient *zclient,
+						 struct zapi_route *api)
+{
+	struct stream *s, *bulk;
+	size_t len, psize = PSIZE(api->prefix.prefixlen);
+
+	if (zclient->synchronous || !zclient->master || !zapi_route_bulk_ok(api))
+		return zclient_route_send(cmd, zclient, api);
+
+	if (!zclient->bulk) {
+		zclient->bulk = stream_new(ZEBRA_MAX_PACKET_SIZ);
+		zclient->bulk_scratch =
+			stream_new(MAX(ZEBRA_MAX_PACKET_SIZ,
+				       sizeof(struct zapi_route)));
+	}
+
+	/* everything but the prefix */
+	s = zclient->bulk_scratch;
+	stream_reset(s);
+	zclient_create_header(s, cmd == ZEBRA_ROUTE_ADD
+					 ? ZEBRA_ROUTE_ADD_BULK
+					 : ZEBRA_ROUTE_DELETE_BULK,
+			      api->vrf_id);
+	stream_putl(s, 0);
+	if (zapi_route_encode_type(s, api) < 0)
+		return ZCLIENT_SEND_FAILURE;
+	stream_putc(s, api->prefix.family);
+	if (zapi_route_encode_attrs(s, api) < 0)
+		return ZCLIENT_SEND_FAILURE;
+	len = stream_get_endp(s);
+
+	/* too big to share with other routes anyway */
+	if (len + 1 + psize > STREAM_SIZE(zclient->bulk))
+		return zclient_route_send(cmd, zclient, api);
+
+	/* the length in the header is only filled in when sending */
+	bulk = zclient->bulk;
+	if (zclient->bulk_count
+	    && (len != zclient->bulk_shared
+		|| memcmp(STREAM_DATA(s) + 2, STREAM_DATA(bulk) + 2, len - 2)
+		|| STREAM_WRITEABLE(bulk) < 1 + psize))
+		zclient_route_bulk_flush(zclient);
+
+	if (!zclient->bulk_count) {
+		stream_reset(bulk);
+		stream_put(bulk, STREAM_DATA(s), len);
+		zclient->bulk_shared = len;
+		thread_add_event(zclient->master, zclient_route_bulk_timer,
+				 zclient, 0, &zclient->t_bulk);
+	}
+
+	stream_putc(bulk, api->prefix.prefixlen);
+	stream_write(bulk, &api->prefix.u.prefix, psize);
+	zclient->bulk_count++;
+
+	return ZCLIENT_SEND_BUFFERED;
+}
+
+int zapi_route_bulk_decode(struct stream *s, struct zapi_route *api,
+			   uint32_t *count)
+{
+	memset(api, 0, sizeof(*api));
+
+	STREAM_GETL(s, *count);
+	if (zapi_route_decode_type(s, api) < 0)
+		return -1;
+
+	STREAM_GETC(s, api->prefix.family);
+	if (zapi_route_check_prefix(&api->prefix) < 0)
+		return -1;
+
+	if (!zapi_route_bulk_ok(api)) {
+		flog_err(EC_LIB_ZAPI_ENCODE,
+			 "%s: route flags 0x%x message 0x%x can't be sent in bulk",
+			 __func__, api->flags, api->message);
+		return -1;
+	}
+
+	return zapi_route_decode_attrs(s, api);
+stream_failure:
+	return -1;
+}
+
+int zapi_route_bulk_decode_prefix(struct stream *s, struct zapi_route *api)
+{
+	memset(&api->prefix.u, 0, sizeof(api->prefix.u));
+
+	STREAM_GETC(s, api->prefix.prefixlen);
+	if (zapi_route_check_prefix(&api->prefix) < 0)
+		return -1;
+	STREAM_GET(&api->prefix.u.prefix, s, PSIZE(api->prefix.prefixlen));
+
+	return 0;
+stream_failure:
+	return -1;
+}
+
 static void zapi_encode_prefix(struct stream *s, struct prefix *p,
 			       uint8_t family)
 {
@@ -2376,6 +2728,35 @@ static int zclient_interface_down(ZAPI_CALLBACK_ARGS)
 	return 0;
 }
 
+static int zclient_ring_reply(ZAPI_CALLBACK_ARGS)
+{
+	uint8_t accepted;
+
+	STREAM_GETC(zclient->ibuf, accepted);
+	if (!zclient->ring)
+		return 0;
+
+	THREAD_OFF(zclient->t_ring);
+
+	if (zclient_debug)
+		zlog_debug("zclient %p ring %s %s", zclient,
+			   zclient->ring->name,
+			   accepted ? "accepted" : "rejected");
+
+	if (!accepted) {
+		zclient_ring_stop(zclient);
+		return 0;
+	}
+
+	/* zebra has it mapped, nobody else needs to find it */
+	shmring_unlink(zclient->ring);
+	zclient->ring_accepted = true;
+	return 0;
+
+stream_failure:
+	return -1;
+}
+
 static int zclient_handle_error(ZAPI_CALLBACK_ARGS)
 {
 	enum zebra_error_types error;
@@ -4011,6 +4392,7 @@ static zclient_handler *const lib_handlers[] = {
 	/* fundamentals */
 	[ZEBRA_CAPABILITIES] = zclient_capability_decode,
 	[ZEBRA_ERROR] = zclient_handle_error,
+	[ZEBRA_RING_REPLY] = zclient_ring_reply,
 
 	/* VRF & interface code is shared in lib */
 	[ZEBRA_VRF_ADD] = zclient_vrf_add,
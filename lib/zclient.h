@@ -7,6 +7,7 @@
 #define _ZEBRA_ZCLIENT_H
 
 struct zclient;
+struct shmring;
 
 /* For struct zapi_route. */
 #include "prefix.h"
@@ -232,6 +233,10 @@ typedef enum {
 	ZEBRA_TC_CLASS_DELETE,
 	ZEBRA_TC_FILTER_ADD,
 	ZEBRA_TC_FILTER_DELETE,
+	ZEBRA_ROUTE_ADD_BULK,
+	ZEBRA_ROUTE_DELETE_BULK,
+	ZEBRA_RING_REPLY,
+	ZEBRA_RING_DOORBELL,
 } zebra_message_types_t;
 
 enum zebra_error_types {
@@ -329,6 +334,29 @@ struct zclient {
 	/* Thread to write buffered data to zebra. */
 	struct thread *t_write;
 
+	/* Bulk route message being collected, see zclient_route_send_bulk().
+	 * bulk_shared is the length of its header and shared part.
+	 */
+	struct stream *bulk;
+	struct stream *bulk_scratch;
+	size_t bulk_shared;
+	uint32_t bulk_count;
+	struct thread *t_bulk;
+
+	/* Shared memory ring offered to zebra in the hello, see
+	 * zclient_ring_set_default().  Messages go through it instead of the
+	 * socket once zebra accepted it and the socket has nothing left to
+	 * write; ring_backlog holds messages that didn't fit.  Until zebra
+	 * answers, t_ring times out the offer; the ring is unlinked and
+	 * dropped if no answer comes.
+	 */
+	struct shmring *ring;
+	bool ring_accepted;
+	bool ring_active;
+	struct stream_fifo *ring_backlog;
+	struct stream *ring_doorbell;
+	struct thread *t_ring;
+
 	/* Redistribute information. */
 	uint8_t redist_default; /* clients protocol */
 	unsigned short instance;
@@ -818,6 +846,12 @@ struct zclient_options {
 
 extern struct zclient_options zclient_options_default;
 
+/* Asks zebra to take messages from asynchronous clients through a shared
+ * memory ring of the given size instead of the socket, for all zclients
+ * connecting from now on.  0 turns it off again.
+ */
+extern void zclient_ring_set_default(size_t size);
+
 /* link layer representation for GRE like interfaces
  * ip_in is the underlay IP, ip_out is the tunnel dest
  * index stands for the index of the interface
@@ -1073,6 +1107,15 @@ extern int zebra_read_pw_status_update(ZAPI_CALLBACK_ARGS,
 
 extern enum zclient_send_status zclient_route_send(uint8_t, struct zclient *,
 						   struct zapi_route *);
+/* Like zclient_route_send(), but routes sharing everything but their prefix
+ * are collected and sent as one ZEBRA_ROUTE_ADD_BULK or ZEBRA_ROUTE_DELETE_BULK
+ * message.  The message goes out before any other message is sent and at
+ * the latest once the current event has finished.
+ */
+extern enum zclient_send_status
+zclient_route_send_bulk(uint8_t cmd, struct zclient *zclient,
+			struct zapi_route *api);
+extern void zclient_route_bulk_flush(struct zclient *zclient);
 extern enum zclient_send_status
 zclient_send_rnh(struct zclient *zclient, int command, const struct prefix *p,
 		 safi_t safi, bool connected, bool resolve_via_default,
@@ -1081,6 +1124,14 @@ int zapi_nexthop_encode(struct stream *s, const struct zapi_nexthop *api_nh,
 			uint32_t api_flags, uint32_t api_message);
 extern int zapi_route_encode(uint8_t, struct stream *, struct zapi_route *);
 extern int zapi_route_decode(struct stream *s, struct zapi_route *api);
+/* Decodes the part of a bulk route message shared by all of its routes into
+ * api, whose prefix only has the family set.  The prefixes follow, each is
+ * read into api by zapi_route_bulk_decode_prefix().
+ */
+extern int zapi_route_bulk_decode(struct stream *s, struct zapi_route *api,
+				  uint32_t *count);
+extern int zapi_route_bulk_decode_prefix(struct stream *s,
+					 struct zapi_route *api);
 extern int zapi_nexthop_decode(struct stream *s, struct zapi_nexthop *api_nh,
 			       uint32_t api_flags, uint32_t api_message);
 bool zapi_nhg_notify_decode(struct stream *s, uint32_t *id,
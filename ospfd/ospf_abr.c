@@ -353,6 +353,7 @@ static int ospf_abr_nssa_am_elected(struct ospf_area *area)
 			if (IS_DEBUG_OSPF_NSSA)
 				zlog_debug("%s: router %pI4 asserts Nt",
 					   __func__, &lsa->data->id);
+			LSDB_LOOP_UNLOCK(rn);
 			return 0;
 		}
 
@@ -656,6 +656,9 @@ void ospf_ase_register_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
 	/* We assume that if LSA is deleted from DB
 	   is is also deleted from this RT */
 	listnode_add(lst, ospf_lsa_lock(lsa)); /* external_lsas lst */
+
+	if (al->e[0].fwd_addr.s_addr != INADDR_ANY)
+		top->external_fwd_lsas++;
 }
 
 void ospf_ase_unregister_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
@@ -678,6 +681,8 @@ void ospf_ase_unregister_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
 		struct listnode *node = listnode_lookup(lst, lsa);
 		/* Unlock lsa only if node is present in the list */
 		if (node) {
+			if (al->e[0].fwd_addr.s_addr != INADDR_ANY)
+				top->external_fwd_lsas--;
 			listnode_delete(lst, lsa);
 			ospf_lsa_unlock(&lsa); /* external_lsas list */
 		}
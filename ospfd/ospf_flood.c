@@ -1098,13 +1098,11 @@ void ospf_ls_retransmit_clear(struct ospf_neighbor *nbr)
 	lsdb = &nbr->ls_rxmt;
 
 	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-		struct route_table *table = lsdb->type[i].db;
 		struct route_node *rn;
 		struct ospf_lsa *lsa;
 
-		for (rn = route_top(table); rn; rn = route_next(rn))
-			if ((lsa = rn->info) != NULL)
-				ospf_ls_retransmit_delete(nbr, lsa);
+		LSDB_LOOP (lsdb->type[i].db, rn, lsa)
+			ospf_ls_retransmit_delete(nbr, lsa);
 	}
 
 	ospf_lsa_unlock(&nbr->ls_req_last);
@@ -318,11 +318,7 @@ void ospf_gr_check_lsdb_consistency(struct ospf *ospf, struct ospf_area *area)
 	struct route_node *rn;
 	struct ospf_lsa *lsa;
 
-	for (rn = route_top(ROUTER_LSDB(area)); rn; rn = route_next(rn)) {
-		lsa = rn->info;
-		if (!lsa)
-			continue;
-
+	LSDB_LOOP (ROUTER_LSDB(area), rn, lsa) {
 		if (!ospf_gr_check_router_lsa_consistency(ospf, area, lsa)) {
 			char reason[256];
 
@@ -330,7 +326,7 @@ void ospf_gr_check_lsdb_consistency(struct ospf *ospf, struct ospf_area *area)
 				   "detected inconsistent LSA[%s] [area %pI4]",
 				   dump_lsa_key(lsa), &area->area_id);
 			ospf_gr_restart_exit(ospf, reason);
-			route_unlock_node(rn);
+			LSDB_LOOP_UNLOCK(rn);
 			return;
 		}
 	}
@@ -557,36 +557,48 @@ static bool ospf_check_change_in_rxmt_list(struct ospf_neighbor *nbr)
 {
 	struct route_node *rn;
 	struct ospf_lsa *lsa;
-	struct route_table *tbl;
+	LSDB_TABLE *tbl;
 
 	tbl = nbr->ls_rxmt.type[OSPF_ROUTER_LSA].db;
 	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
+		if (lsa->to_be_acknowledged) {
+			LSDB_LOOP_UNLOCK(rn);
 			return OSPF_GR_TRUE;
+		}
 	tbl = nbr->ls_rxmt.type[OSPF_NETWORK_LSA].db;
 	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
+		if (lsa->to_be_acknowledged) {
+			LSDB_LOOP_UNLOCK(rn);
 			return OSPF_GR_TRUE;
+		}
 
 	tbl = nbr->ls_rxmt.type[OSPF_SUMMARY_LSA].db;
 	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
+		if (lsa->to_be_acknowledged) {
+			LSDB_LOOP_UNLOCK(rn);
 			return OSPF_GR_TRUE;
+		}
 
 	tbl = nbr->ls_rxmt.type[OSPF_ASBR_SUMMARY_LSA].db;
 	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
+		if (lsa->to_be_acknowledged) {
+			LSDB_LOOP_UNLOCK(rn);
 			return OSPF_GR_TRUE;
+		}
 
 	tbl = nbr->ls_rxmt.type[OSPF_AS_EXTERNAL_LSA].db;
 	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
+		if (lsa->to_be_acknowledged) {
+			LSDB_LOOP_UNLOCK(rn);
 			return OSPF_GR_TRUE;
+		}
 
 	tbl = nbr->ls_rxmt.type[OSPF_AS_NSSA_LSA].db;
 	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
+		if (lsa->to_be_acknowledged) {
+			LSDB_LOOP_UNLOCK(rn);
 			return OSPF_GR_TRUE;
+		}
 
 	return OSPF_GR_FALSE;
 }
@@ -29,6 +29,8 @@
 #include "ospfd/ospf_abr.h"
 #include "ospfd/ospf_ia.h"
 #include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_zebra.h"
+#include "ospfd/ospf_sr.h"
 
 static struct ospf_route *ospf_find_abr_route(struct route_table *rtrs,
 					      struct prefix_ipv4 *abr,
@@ -255,7 +257,7 @@ static int process_summary_lsa(struct ospf_area *area, struct route_table *rt,
 }
 
 static void ospf_examine_summaries(struct ospf_area *area,
-				   struct route_table *lsdb_rt,
+				   LSDB_TABLE *lsdb_rt,
 				   struct route_table *rt,
 				   struct route_table *rtrs)
 {
@@ -547,7 +549,7 @@ static int process_transit_summary_lsa(struct ospf_area *area,
 }
 
 static void ospf_examine_transit_summaries(struct ospf_area *area,
-					   struct route_table *lsdb_rt,
+					   LSDB_TABLE *lsdb_rt,
 					   struct route_table *rt,
 					   struct route_table *rtrs)
 {
@@ -666,3 +668,214 @@ void ospf_ia_routing(struct ospf *ospf, struct route_table *rt,
 			OSPF_EXAMINE_SUMMARIES_ALL(area, rt, rtrs);
 	}
 }
+
+/*
+ * Partial route calculation (PRC).
+ *
+ * A summary-LSA only describes a prefix: a new instance of one, or its
+ * flushing, changes nothing but the route to that prefix.  Routers that are
+ * not ABRs (which originate summaries from their routes) queue the prefix
+ * instead of scheduling SPF, and calculate its inter-area route again from
+ * the summary-LSAs for it, against the ABR routes of the last SPF run.
+ */
+
+static bool ospf_prc_possible(struct ospf *ospf)
+{
+	return ospf->spf_incremental && !IS_OSPF_ABR(ospf)
+	       && !ospf->ti_lfa_enabled && ospf->new_table && ospf->new_rtrs
+	       && !ospf->t_spf_calc;
+}
+
+/* An inter-area route now takes precedence over the external one */
+static void ospf_prc_delete_external(struct ospf *ospf, struct prefix_ipv4 *p)
+{
+	struct route_node *rn;
+
+	rn = route_node_lookup(ospf->old_external_route, (struct prefix *)p);
+	if (!rn)
+		return;
+
+	if (rn->info) {
+		ospf_zebra_delete(ospf, p, rn->info);
+		ospf_route_free(rn->info);
+		rn->info = NULL;
+		route_unlock_node(rn);
+	}
+	route_unlock_node(rn);
+}
+
+/* Calculate the route to 'p' again, returns whether it changed */
+static bool ospf_prc_route(struct ospf *ospf, struct prefix_ipv4 *p)
+{
+	struct route_table *rt;
+	struct route_node *rn, *new_rn;
+	struct ospf_route *or, *new_or = NULL;
+	struct ospf_area *area;
+	struct listnode *node;
+	struct ospf_lsa *lsa;
+	struct summary_lsa *sl;
+	struct list *lsas;
+	bool changed;
+
+	rn = route_node_get(ospf->new_table, (struct prefix *)p);
+	or = rn->info;
+
+	/* Intra-area routes are preferred to any summary */
+	if (or && or->path_type == OSPF_PATH_INTRA_AREA) {
+		route_unlock_node(rn);
+		return false;
+	}
+
+	/* As ospf_ia_routing() does, but for summary-LSAs to 'p' only */
+	rt = route_table_init();
+	for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area)) {
+		lsa = NULL;
+		while ((lsa = ospf_lsdb_lookup_by_id_range(
+				area->lsdb, OSPF_SUMMARY_LSA, p, lsa))) {
+			sl = (struct summary_lsa *)lsa->data;
+			if (ip_masklen(sl->mask) == p->prefixlen)
+				process_summary_lsa(area, rt, ospf->new_rtrs,
+						    lsa);
+		}
+	}
+
+	new_rn = route_node_lookup(rt, (struct prefix *)p);
+	if (new_rn) {
+		route_unlock_node(new_rn);
+		new_or = new_rn->info;
+		if (new_or) {
+			new_rn->info = NULL;
+			route_unlock_node(new_rn);
+		}
+	}
+	ospf_route_table_free(rt);
+
+	if (!or && !new_or) {
+		route_unlock_node(rn);
+		return false;
+	}
+
+	changed = !or || !new_or
+		  || !ospf_route_match_same(ospf->new_table, p, new_or);
+
+	if (!new_or)
+		ospf_zebra_delete(ospf, p, or);
+	else if (changed) {
+		ospf_prc_delete_external(ospf, p);
+		ospf_zebra_add(ospf, p, new_or);
+	}
+
+	/* The node keeps one lock while it has a route */
+	rn->info = new_or;
+	if (or) {
+		ospf_route_free(or);
+		route_unlock_node(rn);
+	}
+	if (!new_or)
+		route_unlock_node(rn);
+
+	/* Without an inter-area route, an external one may apply again */
+	if (!new_or) {
+		rn = route_node_lookup(ospf->external_lsas, (struct prefix *)p);
+		if (rn) {
+			route_unlock_node(rn);
+			lsas = rn->info;
+			lsa = lsas ? listnode_head(lsas) : NULL;
+			if (lsa)
+				ospf_ase_incremental_update(ospf, lsa);
+		}
+	}
+
+	return changed;
+}
+
+static void ospf_prc_calculate(struct thread *thread)
+{
+	struct ospf *ospf = THREAD_ARG(thread);
+	struct route_node *rn;
+	struct timeval start_time;
+	unsigned long count = 0, changed = 0;
+
+	ospf->t_prc_calc = NULL;
+
+	/* The SPF run will take care of everything */
+	if (!ospf_prc_possible(ospf)) {
+		ospf_prc_cancel(ospf);
+		return;
+	}
+
+	monotime(&start_time);
+
+	for (rn = route_top(ospf->prc_prefixes); rn; rn = route_next(rn)) {
+		if (!rn->info)
+			continue;
+
+		rn->info = NULL;
+		route_unlock_node(rn);
+
+		count++;
+		if (ospf_prc_route(ospf, (struct prefix_ipv4 *)&rn->p))
+			changed++;
+	}
+
+	ospf->prc_runs++;
+
+	if (changed) {
+		/* Forwarding addresses may resolve through changed routes */
+		if (ospf->external_fwd_lsas) {
+			ospf_ase_calculate_schedule(ospf);
+			ospf_ase_calculate_timer_add(ospf);
+		}
+
+		ospf_sr_update_task(ospf);
+	}
+
+	if (IS_DEBUG_OSPF_EVENT)
+		zlog_debug("%s: %lu prefixes, %lu routes changed, %lu usecs",
+			   __func__, count, changed,
+			   (unsigned long)monotime_since(&start_time, NULL));
+}
+
+/*
+ * Queue the prefix of summary-LSA 'lsa' for a partial route calculation.
+ * Returns false if SPF has to run instead.
+ */
+bool ospf_prc_schedule(struct ospf *ospf, struct ospf_lsa *lsa)
+{
+	struct summary_lsa *sl = (struct summary_lsa *)lsa->data;
+	struct route_node *rn;
+	struct prefix_ipv4 p;
+
+	if (lsa->data->type != OSPF_SUMMARY_LSA || !ospf_prc_possible(ospf))
+		return false;
+
+	p.family = AF_INET;
+	p.prefix = sl->header.id;
+	p.prefixlen = ip_masklen(sl->mask);
+	apply_mask_ipv4(&p);
+
+	rn = route_node_get(ospf->prc_prefixes, (struct prefix *)&p);
+	if (rn->info)
+		route_unlock_node(rn);
+	else
+		rn->info = ospf; /* only the prefix matters */
+
+	/* Let changes arriving together be calculated together */
+	thread_add_timer_msec(master, ospf_prc_calculate, ospf,
+			      ospf->spf_delay, &ospf->t_prc_calc);
+
+	return true;
+}
+
+void ospf_prc_cancel(struct ospf *ospf)
+{
+	struct route_node *rn;
+
+	THREAD_OFF(ospf->t_prc_calc);
+
+	for (rn = route_top(ospf->prc_prefixes); rn; rn = route_next(rn))
+		if (rn->info) {
+			rn->info = NULL;
+			route_unlock_node(rn);
+		}
+}
@@ -25,5 +25,7 @@
 extern void ospf_ia_routing(struct ospf *, struct route_table *,
 			    struct route_table *);
 extern int ospf_area_is_transit(struct ospf_area *);
+extern bool ospf_prc_schedule(struct ospf *ospf, struct ospf_lsa *lsa);
+extern void ospf_prc_cancel(struct ospf *ospf);
 
 #endif /* _ZEBRA_OSPF_IA_H */
@@ -34,6 +34,7 @@
 #include "ospfd/ospf_dump.h"
 #include "ospfd/ospf_route.h"
 #include "ospfd/ospf_ase.h"
+#include "ospfd/ospf_ia.h"
 #include "ospfd/ospf_zebra.h"
 #include "ospfd/ospf_abr.h"
 #include "ospfd/ospf_errors.h"
@@ -2113,6 +2114,7 @@ struct ospf_lsa *ospf_translated_nssa_refresh(struct ospf *ospf,
 				if (lsa->data->id.s_addr
 				    == type5->data->id.s_addr) {
 					type7 = lsa;
+					LSDB_LOOP_UNLOCK(rn);
 					break;
 				}
 			}
@@ -2708,7 +2710,9 @@ ospf_summary_lsa_install(struct ospf *ospf, struct ospf_lsa *new, int rt_recalc)
    necessary to re-examine all the AS-external-LSAs.
 */
 
-		ospf_spf_calculate_schedule(ospf, SPF_FLAG_SUMMARY_LSA_INSTALL);
+		if (!ospf_prc_schedule(ospf, new))
+			ospf_spf_calculate_schedule(
+				ospf, SPF_FLAG_SUMMARY_LSA_INSTALL);
 	}
 
 	if (IS_LSA_SELF(new))
@@ -2930,6 +2934,18 @@ struct ospf_lsa *ospf_lsa_install(struct ospf *ospf, struct ospf_interface *oi,
 		}
 	}
 
+	/* Tell incremental SPF whether the topology of the area changed */
+	if (rt_recalc && lsa->area
+	    && (lsa->data->type == OSPF_ROUTER_LSA
+		|| lsa->data->type == OSPF_NETWORK_LSA))
+		ospf_spf_lsa_changed(lsa->area, old, lsa);
+
+	/* A summary-LSA whose mask changed no longer describes its prefix */
+	if (rt_recalc && old && lsa->data->type == OSPF_SUMMARY_LSA
+	    && ((struct summary_lsa *)old->data)->mask.s_addr
+		       != ((struct summary_lsa *)lsa->data)->mask.s_addr)
+		ospf_prc_schedule(ospf, old);
+
 	/* discard old LSA from LSDB */
 	if (old != NULL)
 		ospf_discard_from_db(ospf, lsdb, lsa);
@@ -3273,6 +3289,11 @@ static int ospf_lsa_maxage_walker_remover(struct ospf *ospf,
 			case OSPF_AS_NSSA_LSA:
 				ospf_ase_incremental_update(ospf, lsa);
 				break;
+			case OSPF_SUMMARY_LSA:
+				if (!ospf_prc_schedule(ospf, lsa))
+					ospf_spf_calculate_schedule(
+						ospf, SPF_FLAG_MAXAGE);
+				break;
 			default:
 				ospf_spf_calculate_schedule(ospf,
 							    SPF_FLAG_MAXAGE);
@@ -3393,13 +3414,11 @@ struct ospf_lsa *ospf_lsa_lookup_by_id(struct ospf_area *area, uint32_t type,
 	case OSPF_ROUTER_LSA:
 		return ospf_lsdb_lookup_by_id(area->lsdb, type, id, id);
 	case OSPF_NETWORK_LSA:
-		for (rn = route_top(NETWORK_LSDB(area)); rn;
-		     rn = route_next(rn))
-			if ((lsa = rn->info))
-				if (IPV4_ADDR_SAME(&lsa->data->id, &id)) {
-					route_unlock_node(rn);
-					return lsa;
-				}
+		LSDB_LOOP (NETWORK_LSDB(area), rn, lsa)
+			if (IPV4_ADDR_SAME(&lsa->data->id, &id)) {
+				LSDB_LOOP_UNLOCK(rn);
+				return lsa;
+			}
 		break;
 	case OSPF_SUMMARY_LSA:
 	case OSPF_ASBR_SUMMARY_LSA:
@@ -10,6 +10,7 @@
 #include "table.h"
 #include "memory.h"
 #include "log.h"
+#include "jhash.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_asbr.h"
@@ -26,32 +27,12 @@ struct ospf_lsdb *ospf_lsdb_new(void)
 	return new;
 }
 
-void ospf_lsdb_init(struct ospf_lsdb *lsdb)
-{
-	int i;
-
-	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
-		lsdb->type[i].db = route_table_init();
-}
-
 void ospf_lsdb_free(struct ospf_lsdb *lsdb)
 {
 	ospf_lsdb_cleanup(lsdb);
 	XFREE(MTYPE_OSPF_LSDB, lsdb);
 }
 
-void ospf_lsdb_cleanup(struct ospf_lsdb *lsdb)
-{
-	int i;
-	assert(lsdb);
-	assert(lsdb->total == 0);
-
-	ospf_lsdb_delete_all(lsdb);
-
-	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
-		route_table_finish(lsdb->type[i].db);
-}
-
 void ls_prefix_set(struct prefix_ls *lp, struct ospf_lsa *lsa)
 {
 	if (lp && lsa && lsa->data) {
@@ -62,16 +43,30 @@ void ls_prefix_set(struct prefix_ls *lp, struct ospf_lsa *lsa)
 	}
 }
 
-static void ospf_lsdb_delete_entry(struct ospf_lsdb *lsdb,
-				   struct route_node *rn)
+/* Account for an LSA about to be stored in the LSDB */
+static void ospf_lsdb_lsa_added(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 {
-	struct ospf_lsa *lsa = rn->info;
+	if (IS_LSA_SELF(lsa))
+		lsdb->type[lsa->data->type].count_self++;
+	lsdb->type[lsa->data->type].count++;
+	lsdb->total++;
 
-	if (!lsa)
-		return;
+	/* Increment number of router LSAs received with DC bit set */
+	if (lsa->area && (lsa->area->lsdb == lsdb) && !IS_LSA_SELF(lsa) &&
+	    (lsa->data->type == OSPF_ROUTER_LSA) &&
+	    CHECK_FLAG(lsa->data->options, OSPF_OPTION_DC))
+		lsa->area->fr_info.router_lsas_recv_dc_bit++;
 
-	assert(rn->table == lsdb->type[lsa->data->type].db);
+#ifdef MONITOR_LSDB_CHANGE
+	if (lsdb->new_lsa_hook != NULL)
+		(*lsdb->new_lsa_hook)(lsa);
+#endif /* MONITOR_LSDB_CHANGE */
+	lsdb->type[lsa->data->type].checksum += ntohs(lsa->data->checksum);
+}
 
+/* Account for an LSA just taken out of the LSDB, and drop its lock */
+static void ospf_lsdb_lsa_removed(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
+{
 	if (IS_LSA_SELF(lsa))
 		lsdb->type[lsa->data->type].count_self--;
 	lsdb->type[lsa->data->type].count--;
@@ -92,14 +87,430 @@ static void ospf_lsdb_delete_entry(struct ospf_lsdb *lsdb,
 	    (lsa->area->fr_info.indication_lsa_self == lsa))
 		lsa->area->fr_info.indication_lsa_self = NULL;
 
-	rn->info = NULL;
-	route_unlock_node(rn);
 #ifdef MONITOR_LSDB_CHANGE
 	if (lsdb->del_lsa_hook != NULL)
 		(*lsdb->del_lsa_hook)(lsa);
 #endif			       /* MONITOR_LSDB_CHANGE */
 	ospf_lsa_unlock(&lsa); /* lsdb */
-	return;
+}
+
+#ifdef OSPF_LSDB_HASH
+/*
+ * Hash backend.
+ *
+ * Each LSA type is a hash of entries keyed by Link State ID and Advertising
+ * Router, so that adding, replacing, deleting and looking up an LSA is a
+ * single hash lookup rather than a route_table insert or lookup of a
+ * synthetic prefix, and there are no interior trie nodes.
+ *
+ * The order the walks need is built on demand: a sorted array of the keys
+ * and entries (the "view"), built when a walk starts after an entry with a
+ * new key was added.  LSAs being replaced or flushed do not invalidate it:
+ * the entries of deleted LSAs stay in the view, with no info, until the
+ * next rebuild.  The cursor of a walk keeps the key it is at, so that it
+ * can carry on from there after the view has been rebuilt underneath it.
+ */
+PREDECL_HASH(ospf_lsdb_hash);
+
+struct ospf_lsdb_entry {
+	/* What LSDB_LOOP hands out: p is the same /64 as in the route_table */
+	struct route_node rn;
+
+	struct ospf_lsdb_hash_item hitem;
+
+	/* Index in the view, OSPF_LSDB_NOT_IN_VIEW if added since */
+	unsigned int pos;
+};
+
+#define OSPF_LSDB_NOT_IN_VIEW UINT_MAX
+
+struct ospf_lsdb_view_item {
+	uint64_t key;
+	struct ospf_lsdb_entry *entry;
+};
+
+struct ospf_lsdb_table {
+	struct ospf_lsdb_hash_head hash;
+
+	struct ospf_lsdb_view_item *view;
+	unsigned int view_count;
+	unsigned int view_size;
+	/* Entries in the view without LSA */
+	unsigned int view_dead;
+	/* An entry not in the view has an LSA */
+	bool view_stale;
+	/* Changes with each rebuild, never 0 */
+	uint32_t gen;
+};
+
+/* Sorts the same as the /64 prefixes in a route_table */
+static inline uint64_t ospf_lsdb_key(struct in_addr id,
+				     struct in_addr adv_router)
+{
+	return ((uint64_t)ntohl(id.s_addr) << 32) | ntohl(adv_router.s_addr);
+}
+
+static inline uint64_t ospf_lsdb_entry_key(const struct ospf_lsdb_entry *e)
+{
+	const struct prefix_ls *lp = (const struct prefix_ls *)&e->rn.p;
+
+	return ospf_lsdb_key(lp->id, lp->adv_router);
+}
+
+static int ospf_lsdb_entry_cmp(const struct ospf_lsdb_entry *e1,
+			       const struct ospf_lsdb_entry *e2)
+{
+	uint64_t k1 = ospf_lsdb_entry_key(e1), k2 = ospf_lsdb_entry_key(e2);
+
+	return k1 < k2 ? -1 : k1 > k2;
+}
+
+static uint32_t ospf_lsdb_entry_hash(const struct ospf_lsdb_entry *e)
+{
+	const struct prefix_ls *lp = (const struct prefix_ls *)&e->rn.p;
+
+	return jhash_2words(lp->id.s_addr, lp->adv_router.s_addr, 0);
+}
+
+DECLARE_HASH(ospf_lsdb_hash, struct ospf_lsdb_entry, hitem,
+	     ospf_lsdb_entry_cmp, ospf_lsdb_entry_hash);
+
+static int ospf_lsdb_view_cmp(const void *a, const void *b)
+{
+	const struct ospf_lsdb_view_item *i1 = a, *i2 = b;
+
+	return i1->key < i2->key ? -1 : i1->key > i2->key;
+}
+
+/* Free the entries without LSA, and sort the others */
+static void ospf_lsdb_view_build(struct ospf_lsdb_table *t)
+{
+	struct ospf_lsdb_entry *e;
+	unsigned int count = 0, i;
+	size_t size;
+
+	frr_each_safe (ospf_lsdb_hash, &t->hash, e) {
+		if (!e->rn.info) {
+			ospf_lsdb_hash_del(&t->hash, e);
+			XFREE(MTYPE_OSPF_LSDB_NODE, e);
+		}
+	}
+
+	size = ospf_lsdb_hash_count(&t->hash);
+	if (size > t->view_size || size < t->view_size / 4) {
+		t->view_size = size;
+		t->view = XREALLOC(MTYPE_OSPF_LSDB_TABLE, t->view,
+				   (size ? size : 1) * sizeof(*t->view));
+	}
+
+	frr_each (ospf_lsdb_hash, &t->hash, e) {
+		t->view[count].key = ospf_lsdb_entry_key(e);
+		t->view[count].entry = e;
+		count++;
+	}
+
+	qsort(t->view, count, sizeof(*t->view), ospf_lsdb_view_cmp);
+	for (i = 0; i < count; i++)
+		t->view[i].entry->pos = i;
+
+	t->view_count = count;
+	t->view_dead = 0;
+	t->view_stale = false;
+	if (++t->gen == 0)
+		t->gen = 1;
+}
+
+/* First position in the view after, or at if 'inclusive', the key */
+static unsigned int ospf_lsdb_view_find(struct ospf_lsdb_table *t,
+					uint64_t key, bool inclusive)
+{
+	unsigned int lo = 0, hi = t->view_count, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (t->view[mid].key < key
+		    || (t->view[mid].key == key && !inclusive))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* The view, up to date, for a walk or lookup starting */
+static void ospf_lsdb_view_get(struct ospf_lsdb_table *t)
+{
+	if (t->view_stale || t->view_dead > t->view_count / 2)
+		ospf_lsdb_view_build(t);
+}
+
+struct route_node *ospf_lsdb_walk(struct ospf_lsdb_table *t,
+				  struct ospf_lsdb_cursor *cursor)
+{
+	struct ospf_lsdb_entry *e;
+	unsigned int pos;
+
+	if (!cursor->gen) {
+		ospf_lsdb_view_get(t);
+		pos = 0;
+	} else {
+		/* An LSA with a new key was added by the loop's body */
+		if (t->view_stale)
+			ospf_lsdb_view_build(t);
+
+		if (cursor->gen == t->gen)
+			pos = cursor->pos + 1;
+		else
+			pos = ospf_lsdb_view_find(t, cursor->key, false);
+	}
+
+	for (; pos < t->view_count; pos++) {
+		e = t->view[pos].entry;
+		if (!e->rn.info)
+			continue;
+
+		cursor->gen = t->gen;
+		cursor->pos = pos;
+		cursor->key = t->view[pos].key;
+		return &e->rn;
+	}
+
+	return NULL;
+}
+
+static struct ospf_lsdb_entry *ospf_lsdb_entry_find(struct ospf_lsdb_table *t,
+						    struct in_addr id,
+						    struct in_addr adv_router)
+{
+	struct ospf_lsdb_entry key;
+	struct prefix_ls *lp = (struct prefix_ls *)&key.rn.p;
+
+	lp->id = id;
+	lp->adv_router = adv_router;
+	return ospf_lsdb_hash_find(&t->hash, &key);
+}
+
+/* Drop the LSA of an entry, and the entry unless a walk may be on it */
+static void ospf_lsdb_entry_clear(struct ospf_lsdb_table *t,
+				  struct ospf_lsdb_entry *e)
+{
+	e->rn.info = NULL;
+
+	if (e->pos != OSPF_LSDB_NOT_IN_VIEW) {
+		t->view_dead++;
+		return;
+	}
+
+	ospf_lsdb_hash_del(&t->hash, e);
+	XFREE(MTYPE_OSPF_LSDB_NODE, e);
+}
+
+void ospf_lsdb_init(struct ospf_lsdb *lsdb)
+{
+	struct ospf_lsdb_table *t;
+	int i;
+
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
+		t = XCALLOC(MTYPE_OSPF_LSDB_TABLE, sizeof(*t));
+		ospf_lsdb_hash_init(&t->hash);
+		lsdb->type[i].db = t;
+	}
+}
+
+void ospf_lsdb_cleanup(struct ospf_lsdb *lsdb)
+{
+	struct ospf_lsdb_table *t;
+	struct ospf_lsdb_entry *e;
+	int i;
+	assert(lsdb);
+	assert(lsdb->total == 0);
+
+	ospf_lsdb_delete_all(lsdb);
+
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
+		t = lsdb->type[i].db;
+		while ((e = ospf_lsdb_hash_pop(&t->hash)))
+			XFREE(MTYPE_OSPF_LSDB_NODE, e);
+		ospf_lsdb_hash_fini(&t->hash);
+		XFREE(MTYPE_OSPF_LSDB_TABLE, t->view);
+		XFREE(MTYPE_OSPF_LSDB_TABLE, t);
+		lsdb->type[i].db = NULL;
+	}
+}
+
+/* Add new LSA to lsdb. */
+void ospf_lsdb_add(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
+{
+	struct ospf_lsdb_table *t;
+	struct ospf_lsdb_entry *e;
+	struct ospf_lsa *old;
+
+	t = lsdb->type[lsa->data->type].db;
+	e = ospf_lsdb_entry_find(t, lsa->data->id, lsa->data->adv_router);
+	if (!e) {
+		e = XCALLOC(MTYPE_OSPF_LSDB_NODE, sizeof(*e));
+		ls_prefix_set((struct prefix_ls *)&e->rn.p, lsa);
+		e->pos = OSPF_LSDB_NOT_IN_VIEW;
+		ospf_lsdb_hash_add(&t->hash, e);
+		t->view_stale = true;
+	}
+
+	old = e->rn.info;
+
+	/* nothing to do? */
+	if (old == lsa)
+		return;
+
+	/* purge old entry? */
+	if (old) {
+		e->rn.info = NULL;
+		ospf_lsdb_lsa_removed(lsdb, old);
+	} else if (e->pos != OSPF_LSDB_NOT_IN_VIEW)
+		t->view_dead--;
+
+	ospf_lsdb_lsa_added(lsdb, lsa);
+	e->rn.info = ospf_lsa_lock(lsa); /* lsdb */
+}
+
+void ospf_lsdb_delete(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
+{
+	struct ospf_lsdb_table *t;
+	struct ospf_lsdb_entry *e;
+
+	if (!lsdb || !lsa)
+		return;
+
+	assert(lsa->data->type < OSPF_MAX_LSA);
+	t = lsdb->type[lsa->data->type].db;
+	e = ospf_lsdb_entry_find(t, lsa->data->id, lsa->data->adv_router);
+	if (e && e->rn.info == lsa) {
+		ospf_lsdb_entry_clear(t, e);
+		ospf_lsdb_lsa_removed(lsdb, lsa);
+	}
+}
+
+void ospf_lsdb_delete_all(struct ospf_lsdb *lsdb)
+{
+	struct ospf_lsdb_table *t;
+	struct ospf_lsdb_entry *e;
+	struct ospf_lsa *lsa;
+	int i;
+
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
+		t = lsdb->type[i].db;
+		frr_each_safe (ospf_lsdb_hash, &t->hash, e) {
+			lsa = e->rn.info;
+			if (!lsa)
+				continue;
+			ospf_lsdb_entry_clear(t, e);
+			ospf_lsdb_lsa_removed(lsdb, lsa);
+		}
+	}
+}
+
+struct ospf_lsa *ospf_lsdb_lookup(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
+{
+	return ospf_lsdb_lookup_by_id(lsdb, lsa->data->type, lsa->data->id,
+				      lsa->data->adv_router);
+}
+
+struct ospf_lsa *ospf_lsdb_lookup_by_id(struct ospf_lsdb *lsdb, uint8_t type,
+					struct in_addr id,
+					struct in_addr adv_router)
+{
+	struct ospf_lsdb_entry *e;
+
+	e = ospf_lsdb_entry_find(lsdb->type[type].db, id, adv_router);
+	return e ? e->rn.info : NULL;
+}
+
+struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *lsdb,
+					     uint8_t type, struct in_addr id,
+					     struct in_addr adv_router,
+					     int first)
+{
+	struct ospf_lsdb_table *t = lsdb->type[type].db;
+	unsigned int pos = 0;
+
+	if (!first && !ospf_lsdb_lookup_by_id(lsdb, type, id, adv_router))
+		return NULL;
+
+	ospf_lsdb_view_get(t);
+	if (!first)
+		pos = ospf_lsdb_view_find(t, ospf_lsdb_key(id, adv_router),
+					  false);
+
+	for (; pos < t->view_count; pos++)
+		if (t->view[pos].entry->rn.info)
+			return t->view[pos].entry->rn.info;
+	return NULL;
+}
+
+/*
+ * LSAs of the type whose Link State ID is within 'p', in Link State ID
+ * order: pass NULL for the first one, then the previous one.
+ */
+struct ospf_lsa *ospf_lsdb_lookup_by_id_range(struct ospf_lsdb *lsdb,
+					      uint8_t type,
+					      const struct prefix_ipv4 *p,
+					      struct ospf_lsa *prev)
+{
+	struct ospf_lsdb_table *t = lsdb->type[type].db;
+	struct in_addr mask;
+	uint64_t start, end, key;
+	unsigned int pos;
+
+	/* The range of keys of the range's Link State IDs */
+	masklen2ip(p->prefixlen, &mask);
+	start = (uint64_t)(ntohl(p->prefix.s_addr) & ntohl(mask.s_addr)) << 32;
+	end = start | ((uint64_t)~ntohl(mask.s_addr) << 32) | UINT32_MAX;
+
+	ospf_lsdb_view_get(t);
+	if (prev) {
+		key = ospf_lsdb_key(prev->data->id, prev->data->adv_router);
+		pos = ospf_lsdb_view_find(t, key, false);
+	} else
+		pos = ospf_lsdb_view_find(t, start, true);
+
+	for (; pos < t->view_count && t->view[pos].key <= end; pos++)
+		if (t->view[pos].entry->rn.info)
+			return t->view[pos].entry->rn.info;
+	return NULL;
+}
+#else
+void ospf_lsdb_init(struct ospf_lsdb *lsdb)
+{
+	int i;
+
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
+		lsdb->type[i].db = route_table_init();
+}
+
+void ospf_lsdb_cleanup(struct ospf_lsdb *lsdb)
+{
+	int i;
+	assert(lsdb);
+	assert(lsdb->total == 0);
+
+	ospf_lsdb_delete_all(lsdb);
+
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
+		route_table_finish(lsdb->type[i].db);
+}
+
+static void ospf_lsdb_delete_entry(struct ospf_lsdb *lsdb,
+				   struct route_node *rn)
+{
+	struct ospf_lsa *lsa = rn->info;
+
+	if (!lsa)
+		return;
+
+	assert(rn->table == lsdb->type[lsa->data->type].db);
+
+	rn->info = NULL;
+	route_unlock_node(rn);
+	ospf_lsdb_lsa_removed(lsdb, lsa);
 }
 
 /* Add new LSA to lsdb. */
@@ -123,22 +534,7 @@ void ospf_lsdb_add(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 	if (rn->info)
 		ospf_lsdb_delete_entry(lsdb, rn);
 
-	if (IS_LSA_SELF(lsa))
-		lsdb->type[lsa->data->type].count_self++;
-	lsdb->type[lsa->data->type].count++;
-	lsdb->total++;
-
-	/* Increment number of router LSAs received with DC bit set */
-	if (lsa->area && (lsa->area->lsdb == lsdb) && !IS_LSA_SELF(lsa) &&
-	    (lsa->data->type == OSPF_ROUTER_LSA) &&
-	    CHECK_FLAG(lsa->data->options, OSPF_OPTION_DC))
-		lsa->area->fr_info.router_lsas_recv_dc_bit++;
-
-#ifdef MONITOR_LSDB_CHANGE
-	if (lsdb->new_lsa_hook != NULL)
-		(*lsdb->new_lsa_hook)(lsa);
-#endif /* MONITOR_LSDB_CHANGE */
-	lsdb->type[lsa->data->type].checksum += ntohs(lsa->data->checksum);
+	ospf_lsdb_lsa_added(lsdb, lsa);
 	rn->info = ospf_lsa_lock(lsa); /* lsdb */
 }
 
@@ -258,6 +654,48 @@ struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *lsdb,
 	return NULL;
 }
 
+/*
+ * LSAs of the type whose Link State ID is within 'p', in Link State ID
+ * order: pass NULL for the first one, then the previous one.
+ */
+struct ospf_lsa *ospf_lsdb_lookup_by_id_range(struct ospf_lsdb *lsdb,
+					      uint8_t type,
+					      const struct prefix_ipv4 *p,
+					      struct ospf_lsa *prev)
+{
+	struct route_table *table;
+	struct prefix_ls range, lp;
+	struct route_node *rn;
+
+	table = lsdb->type[type].db;
+
+	memset(&range, 0, sizeof(range));
+	range.family = AF_UNSPEC;
+	range.prefixlen = p->prefixlen;
+	range.id = p->prefix;
+
+	if (prev) {
+		ls_prefix_set(&lp, prev);
+		rn = route_table_get_next(table, (struct prefix *)&lp);
+	} else
+		rn = route_table_get_next(table, (struct prefix *)&range);
+
+	/* The LSAs in the range are the subtree right after it */
+	for (; rn; rn = route_next(rn)) {
+		if (!prefix_match((struct prefix *)&range, &rn->p))
+			break;
+		if (rn->info) {
+			route_unlock_node(rn);
+			return rn->info;
+		}
+	}
+
+	if (rn)
+		route_unlock_node(rn);
+	return NULL;
+}
+#endif /* OSPF_LSDB_HASH */
+
 unsigned long ospf_lsdb_count_all(struct ospf_lsdb *lsdb)
 {
 	return lsdb->total;
@@ -7,13 +7,28 @@
 #ifndef _ZEBRA_OSPF_LSDB_H
 #define _ZEBRA_OSPF_LSDB_H
 
+/*
+ * Each LSA type of an LSDB is kept in Link State ID and Advertising Router
+ * order, either in a route_table of /64 prefixes made of the two, or with
+ * --enable-ospf-lsdb-hash in a hash table that sorts its entries when
+ * walked (see ospf_lsdb.c).  Either way LSDB_LOOP hands out route_nodes
+ * whose info is the LSA.
+ */
+#ifdef OSPF_LSDB_HASH
+struct route_node;
+struct ospf_lsdb_table;
+#define LSDB_TABLE struct ospf_lsdb_table
+#else
+#define LSDB_TABLE struct route_table
+#endif
+
 /* OSPF LSDB structure. */
 struct ospf_lsdb {
 	struct {
 		unsigned long count;
 		unsigned long count_self;
 		unsigned int checksum;
-		struct route_table *db;
+		LSDB_TABLE *db;
 	} type[OSPF_MAX_LSA];
 	unsigned long total;
 #define MONITOR_LSDB_CHANGE 1 /* XXX */
@@ -25,11 +40,32 @@ struct ospf_lsdb {
 };
 
 /* Macros. */
+#ifdef OSPF_LSDB_HASH
+/* Position of an LSDB_LOOP, which survives changes to the LSDB */
+struct ospf_lsdb_cursor {
+	uint32_t gen;
+	unsigned int pos;
+	uint64_t key;
+};
+
+#define LSDB_LOOP(T, N, L)                                                     \
+	if ((T) != NULL)                                                       \
+		for (struct ospf_lsdb_cursor N##_cursor = {};                  \
+		     ((N) = ospf_lsdb_walk((T), &N##_cursor));)                \
+			if (((L) = (N)->info))
+
+/* Leaving an LSDB_LOOP early */
+#define LSDB_LOOP_UNLOCK(N) (void)(N)
+#else
 #define LSDB_LOOP(T, N, L)                                                     \
 	if ((T) != NULL)                                                       \
 		for ((N) = route_top((T)); ((N)); ((N)) = route_next((N)))     \
 			if (((L) = (N)->info))
 
+/* Leaving an LSDB_LOOP early */
+#define LSDB_LOOP_UNLOCK(N) route_unlock_node(N)
+#endif
+
 #define ROUTER_LSDB(A)       ((A)->lsdb->type[OSPF_ROUTER_LSA].db)
 #define NETWORK_LSDB(A)	     ((A)->lsdb->type[OSPF_NETWORK_LSA].db)
 #define SUMMARY_LSDB(A)      ((A)->lsdb->type[OSPF_SUMMARY_LSA].db)
@@ -58,10 +94,18 @@ extern struct ospf_lsa *ospf_lsdb_lookup_by_id(struct ospf_lsdb *, uint8_t,
 extern struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *, uint8_t,
 						    struct in_addr,
 						    struct in_addr, int);
+extern struct ospf_lsa *
+ospf_lsdb_lookup_by_id_range(struct ospf_lsdb *lsdb, uint8_t type,
+			     const struct prefix_ipv4 *p,
+			     struct ospf_lsa *prev);
 extern unsigned long ospf_lsdb_count_all(struct ospf_lsdb *);
 extern unsigned long ospf_lsdb_count(struct ospf_lsdb *, int);
 extern unsigned long ospf_lsdb_count_self(struct ospf_lsdb *, int);
 extern unsigned int ospf_lsdb_checksum(struct ospf_lsdb *, int);
 extern unsigned long ospf_lsdb_isempty(struct ospf_lsdb *);
+#ifdef OSPF_LSDB_HASH
+extern struct route_node *ospf_lsdb_walk(struct ospf_lsdb_table *table,
+					 struct ospf_lsdb_cursor *cursor);
+#endif
 
 #endif /* _ZEBRA_OSPF_LSDB_H */
@@ -23,6 +23,8 @@ DEFINE_MTYPE(OSPFD, OSPF_TMP, "OSPF tmp mem");
 DEFINE_MTYPE(OSPFD, OSPF_LSA, "OSPF LSA");
 DEFINE_MTYPE(OSPFD, OSPF_LSA_DATA, "OSPF LSA data");
 DEFINE_MTYPE(OSPFD, OSPF_LSDB, "OSPF LSDB");
+DEFINE_MTYPE(OSPFD, OSPF_LSDB_TABLE, "OSPF LSDB hash table");
+DEFINE_MTYPE(OSPFD, OSPF_LSDB_NODE, "OSPF LSDB hash entry");
 DEFINE_MTYPE(OSPFD, OSPF_PACKET, "OSPF packet");
 DEFINE_MTYPE(OSPFD, OSPF_FIFO, "OSPF FIFO queue");
 DEFINE_MTYPE(OSPFD, OSPF_VERTEX, "OSPF vertex");
@@ -45,3 +47,4 @@ DEFINE_MTYPE(OSPFD, OSPF_GR_HELPER, "OSPF Graceful Restart Helper");
 DEFINE_MTYPE(OSPFD, OSPF_EXTERNAL_RT_AGGR, "OSPF External Route Summarisation");
 DEFINE_MTYPE(OSPFD, OSPF_P_SPACE, "OSPF TI-LFA P-Space");
 DEFINE_MTYPE(OSPFD, OSPF_Q_SPACE, "OSPF TI-LFA Q-Space");
+DEFINE_MTYPE(OSPFD, OSPF_SPF_INDEX, "OSPF SPF adjacency index");
@@ -22,6 +22,8 @@ DECLARE_MTYPE(OSPF_TMP);
 DECLARE_MTYPE(OSPF_LSA);
 DECLARE_MTYPE(OSPF_LSA_DATA);
 DECLARE_MTYPE(OSPF_LSDB);
+DECLARE_MTYPE(OSPF_LSDB_TABLE);
+DECLARE_MTYPE(OSPF_LSDB_NODE);
 DECLARE_MTYPE(OSPF_PACKET);
 DECLARE_MTYPE(OSPF_FIFO);
 DECLARE_MTYPE(OSPF_VERTEX);
@@ -44,5 +46,6 @@ DECLARE_MTYPE(OSPF_GR_HELPER);
 DECLARE_MTYPE(OSPF_EXTERNAL_RT_AGGR);
 DECLARE_MTYPE(OSPF_P_SPACE);
 DECLARE_MTYPE(OSPF_Q_SPACE);
+DECLARE_MTYPE(OSPF_SPF_INDEX);
 
 #endif /* _QUAGGA_OSPF_MEMORY_H */
@@ -252,12 +252,11 @@ void ospf_db_summary_clear(struct ospf_neighbor *nbr)
 
 	lsdb = &nbr->db_sum;
 	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-		struct route_table *table = lsdb->type[i].db;
 		struct route_node *rn;
+		struct ospf_lsa *lsa;
 
-		for (rn = route_top(table); rn; rn = route_next(rn))
-			if (rn->info)
-				ospf_lsdb_delete(&nbr->db_sum, rn->info);
+		LSDB_LOOP (lsdb->type[i].db, rn, lsa)
+			ospf_lsdb_delete(&nbr->db_sum, lsa);
 	}
 }
 
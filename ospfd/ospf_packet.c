@@ -479,30 +479,26 @@ void ospf_ls_upd_timer(struct thread *thread)
 		update = list_new();
 
 		for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-			struct route_table *table = lsdb->type[i].db;
 			struct route_node *rn;
-
-			for (rn = route_top(table); rn; rn = route_next(rn)) {
-				struct ospf_lsa *lsa;
-
-				if ((lsa = rn->info) != NULL) {
-					/* Don't retransmit an LSA if we
-					  received it within
-					  the last RxmtInterval seconds - this
-					  is to allow the
-					  neighbour a chance to acknowledge the
-					  LSA as it may
-					  have ben just received before the
-					  retransmit timer
-					  fired.  This is a small tweak to what
-					  is in the RFC,
-					  but it will cut out out a lot of
-					  retransmit traffic
-					  - MAG */
-					if (monotime_since(&lsa->tv_recv, NULL)
-					    >= retransmit_interval * 1000000LL)
-						listnode_add(update, rn->info);
-				}
+			struct ospf_lsa *lsa;
+
+			LSDB_LOOP (lsdb->type[i].db, rn, lsa) {
+				/* Don't retransmit an LSA if we
+				  received it within
+				  the last RxmtInterval seconds - this
+				  is to allow the
+				  neighbour a chance to acknowledge the
+				  LSA as it may
+				  have ben just received before the
+				  retransmit timer
+				  fired.  This is a small tweak to what
+				  is in the RFC,
+				  but it will cut out out a lot of
+				  retransmit traffic
+				  - MAG */
+				if (monotime_since(&lsa->tv_recv, NULL)
+				    >= retransmit_interval * 1000000LL)
+					listnode_add(update, lsa);
 			}
 		}
 
@@ -3433,48 +3429,46 @@ static int ospf_make_db_desc(struct ospf_interface *oi,
 	lsdb = &nbr->db_sum;
 
 	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-		struct route_table *table = lsdb->type[i].db;
 		struct route_node *rn;
 
-		for (rn = route_top(table); rn; rn = route_next(rn))
-			if ((lsa = rn->info) != NULL) {
-				if (IS_OPAQUE_LSA(lsa->data->type)
-				    && (!CHECK_FLAG(options, OSPF_OPTION_O))) {
-					/* Suppress advertising
-					 * opaque-information. */
-					/* Remove LSA from DB summary list. */
-					ospf_lsdb_delete(lsdb, lsa);
-					continue;
-				}
+		LSDB_LOOP (lsdb->type[i].db, rn, lsa) {
+			if (IS_OPAQUE_LSA(lsa->data->type)
+			    && (!CHECK_FLAG(options, OSPF_OPTION_O))) {
+				/* Suppress advertising
+				 * opaque-information. */
+				/* Remove LSA from DB summary list. */
+				ospf_lsdb_delete(lsdb, lsa);
+				continue;
+			}
+
+			if (!CHECK_FLAG(lsa->flags, OSPF_LSA_DISCARD)) {
+				struct lsa_header *lsah;
+				uint16_t ls_age;
 
-				if (!CHECK_FLAG(lsa->flags, OSPF_LSA_DISCARD)) {
-					struct lsa_header *lsah;
-					uint16_t ls_age;
-
-					/* DD packet overflows interface MTU. */
-					if (length + OSPF_LSA_HEADER_SIZE
-					    > ospf_packet_max(oi))
-						break;
-
-					/* Keep pointer to LS age. */
-					lsah = (struct lsa_header
-							*)(STREAM_DATA(s)
-							   + stream_get_endp(
-								     s));
-
-					/* Proceed stream pointer. */
-					stream_put(s, lsa->data,
-						   OSPF_LSA_HEADER_SIZE);
-					length += OSPF_LSA_HEADER_SIZE;
-
-					/* Set LS age. */
-					ls_age = LS_AGE(lsa);
-					lsah->ls_age = htons(ls_age);
+				/* DD packet overflows interface MTU. */
+				if (length + OSPF_LSA_HEADER_SIZE
+				    > ospf_packet_max(oi)) {
+					LSDB_LOOP_UNLOCK(rn);
+					break;
 				}
 
-				/* Remove LSA from DB summary list. */
-				ospf_lsdb_delete(lsdb, lsa);
+				/* Keep pointer to LS age. */
+				lsah = (struct lsa_header
+						*)(STREAM_DATA(s)
+						   + stream_get_endp(s));
+
+				/* Proceed stream pointer. */
+				stream_put(s, lsa->data, OSPF_LSA_HEADER_SIZE);
+				length += OSPF_LSA_HEADER_SIZE;
+
+				/* Set LS age. */
+				ls_age = LS_AGE(lsa);
+				lsah->ls_age = htons(ls_age);
 			}
+
+			/* Remove LSA from DB summary list. */
+			ospf_lsdb_delete(lsdb, lsa);
+		}
 	}
 
 	/* Update 'More' bit */
@@ -3526,24 +3520,19 @@ static int ospf_make_ls_req(struct ospf_neighbor *nbr, struct stream *s)
 	struct ospf_lsa *lsa;
 	uint16_t length = OSPF_LS_REQ_MIN_SIZE;
 	unsigned long delta = 12;
-	struct route_table *table;
 	struct route_node *rn;
 	int i;
 	struct ospf_lsdb *lsdb;
 
 	lsdb = &nbr->ls_req;
 
-	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-		table = lsdb->type[i].db;
-		for (rn = route_top(table); rn; rn = route_next(rn))
-			if ((lsa = (rn->info)) != NULL)
-				if (ospf_make_ls_req_func(s, &length, delta,
-							  nbr, lsa)
-				    == 0) {
-					route_unlock_node(rn);
-					break;
-				}
-	}
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
+		LSDB_LOOP (lsdb->type[i].db, rn, lsa)
+			if (ospf_make_ls_req_func(s, &length, delta, nbr, lsa)
+			    == 0) {
+				LSDB_LOOP_UNLOCK(rn);
+				break;
+			}
 	return length;
 }
 
@@ -9,12 +9,14 @@
 #include "thread.h"
 #include "memory.h"
 #include "hash.h"
+#include "jhash.h"
 #include "linklist.h"
 #include "prefix.h"
 #include "if.h"
 #include "table.h"
 #include "log.h"
 #include "sockunion.h" /* for inet_ntop () */
+#include "workpool.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_interface.h"
@@ -82,17 +84,13 @@ DECLARE_SKIPLIST_NONUNIQ(vertex_pqueue, struct vertex, pqi, vertex_cmp);
 
 static void lsdb_clean_stat(struct ospf_lsdb *lsdb)
 {
-	struct route_table *table;
 	struct route_node *rn;
 	struct ospf_lsa *lsa;
 	int i;
 
-	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-		table = lsdb->type[i].db;
-		for (rn = route_top(table); rn; rn = route_next(rn))
-			if ((lsa = (rn->info)) != NULL)
-				lsa->stat = LSA_SPF_NOT_EXPLORED;
-	}
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
+		LSDB_LOOP (lsdb->type[i].db, rn, lsa)
+			lsa->stat = LSA_SPF_NOT_EXPLORED;
 }
 
 static struct vertex_nexthop *vertex_nexthop_new(void)
@@ -214,7 +212,7 @@ static void ospf_vertex_free(void *data)
 	if (IS_DEBUG_OSPF_EVENT)
 		zlog_debug("%s: Free %s vertex %pI4", __func__,
 			   v->type == OSPF_VERTEX_ROUTER ? "Router" : "Network",
-			   &v->lsa->id);
+			   &v->id);
 
 	if (v->children)
 		list_delete(&v->children);
@@ -347,8 +345,8 @@ ospf_spf_vertex_parent_copy(struct vertex_parent *vertex_parent)
 	struct vertex_parent *vertex_parent_copy;
 	struct vertex_nexthop *nexthop_copy, *local_nexthop_copy;
 
-	vertex_parent_copy =
-		XCALLOC(MTYPE_OSPF_VERTEX, sizeof(struct vertex_parent));
+	vertex_parent_copy = XCALLOC(MTYPE_OSPF_VERTEX_PARENT,
+				     sizeof(struct vertex_parent));
 
 	nexthop_copy = vertex_nexthop_new();
 	local_nexthop_copy = vertex_nexthop_new();
@@ -440,12 +438,17 @@ static void ospf_spf_remove_branch(struct vertex_parent *vertex_parent,
 	 * be done anyway.
 	 */
 	listnode_delete(child->parents, vertex_parent);
+	vertex_parent_free(vertex_parent);
 
 	/*
 	 * Are there actually more parents left? If not, then delete the child!
 	 * This is done by recursively removing the links to the grandchildren,
 	 * such that finally the child can be removed without leaving unused
 	 * partial branches.
+	 *
+	 * Only the links from the child itself go: a grandchild with other
+	 * parents stays, and removing those links could delete entries of the
+	 * lists walked here or further up.
 	 */
 	if (child->parents->count == 0) {
 		for (ALL_LIST_ELEMENTS(child->children, node, nnode,
@@ -453,6 +456,9 @@ static void ospf_spf_remove_branch(struct vertex_parent *vertex_parent,
 			for (ALL_LIST_ELEMENTS(grandchild->parents, inner_node,
 					       inner_nnode,
 					       vertex_parent_found)) {
+				if (vertex_parent_found->parent != child)
+					continue;
+
 				ospf_spf_remove_branch(vertex_parent_found,
 						       grandchild, vertex_list);
 			}
@@ -612,23 +618,384 @@ static int ospf_lsa_has_link(struct lsa_header *w, struct lsa_header *v)
 	return -1;
 }
 
+/*
+ * Adjacency index for one SPF run.
+ *
+ * Every router- and network-LSA the SPF could look up gets a node, and the
+ * transit links of all of them are parsed once into a single array, with
+ * the far end and the backlink already resolved.  The links are also hashed
+ * by (LSA, link type, neighbor), which replaces the walks over the LSA body
+ * in ospf_lsa_has_link() and ospf_get_next_link().  The index refers into
+ * the LSDB, so it only lives for the duration of ospf_spf_calculate().
+ */
+PREDECL_HASH(spf_adj_nodes);
+PREDECL_HASH(spf_adj_links);
+
+/* Link type for the routers attached to a network-LSA */
+#define SPF_ADJ_ATTACHED 0
+
+struct spf_adj_node {
+	struct spf_adj_nodes_item item;
+	uint8_t type;
+	struct in_addr id;
+	struct ospf_lsa *lsa;
+
+	/* Transit links, in LSA order, in index->link */
+	uint32_t first;
+	uint32_t count;
+
+	/*
+	 * TOS metrics or a link count not matching the LSA length: the
+	 * backlink index is then left to ospf_lsa_has_link().
+	 */
+	bool irregular;
+};
+
+struct spf_adj_link {
+	struct spf_adj_links_item item;
+	struct spf_adj_node *owner;
+	uint8_t type;
+	struct in_addr id;
+
+	struct router_lsa_link *l; /* NULL for attached routers */
+	int lsa_pos;
+
+	struct spf_adj_node *w; /* far end, NULL if not in the LSDB */
+	int backlink;		/* see ospf_lsa_has_link() */
+
+	/* Next parallel link from the same LSA to the same neighbor */
+	struct spf_adj_link *next;
+};
+
+struct ospf_spf_index {
+	struct spf_adj_nodes_head nodes;
+	struct spf_adj_links_head links;
+
+	struct spf_adj_node *node;
+	uint32_t node_count;
+	struct spf_adj_link *link;
+	uint32_t link_count;
+};
+
+static int spf_adj_nodes_cmp(const struct spf_adj_node *a,
+			     const struct spf_adj_node *b)
+{
+	if (a->type != b->type)
+		return numcmp(a->type, b->type);
+	return IPV4_ADDR_CMP(&a->id, &b->id);
+}
+
+static uint32_t spf_adj_nodes_hash(const struct spf_adj_node *n)
+{
+	return jhash_2words(n->id.s_addr, n->type, 0);
+}
+
+DECLARE_HASH(spf_adj_nodes, struct spf_adj_node, item, spf_adj_nodes_cmp,
+	     spf_adj_nodes_hash);
+
+static int spf_adj_links_cmp(const struct spf_adj_link *a,
+			     const struct spf_adj_link *b)
+{
+	if (a->owner != b->owner)
+		return a->owner < b->owner ? -1 : 1;
+	if (a->type != b->type)
+		return numcmp(a->type, b->type);
+	return IPV4_ADDR_CMP(&a->id, &b->id);
+}
+
+static uint32_t spf_adj_links_hash(const struct spf_adj_link *l)
+{
+	return jhash_3words(l->id.s_addr, l->type,
+			    (uint32_t)(uintptr_t)l->owner, 0);
+}
+
+DECLARE_HASH(spf_adj_links, struct spf_adj_link, item, spf_adj_links_cmp,
+	     spf_adj_links_hash);
+
+static struct spf_adj_node *spf_adj_node_find(struct ospf_spf_index *idx,
+					      uint8_t type, struct in_addr id)
+{
+	struct spf_adj_node key = { .type = type, .id = id };
+
+	return spf_adj_nodes_find(&idx->nodes, &key);
+}
+
+static struct spf_adj_link *spf_adj_link_find(struct ospf_spf_index *idx,
+					      struct spf_adj_node *owner,
+					      uint8_t type, struct in_addr id)
+{
+	struct spf_adj_link key = { .owner = owner, .type = type, .id = id };
+
+	return spf_adj_links_find(&idx->links, &key);
+}
+
+/* Index node of an LSA, NULL if there is no index or the LSA isn't in it */
+static struct spf_adj_node *ospf_spf_index_node(struct ospf_area *area,
+						struct ospf_lsa *lsa)
+{
+	struct spf_adj_node *n;
+
+	if (!area->spf_index || !lsa)
+		return NULL;
+
+	n = spf_adj_node_find(area->spf_index, lsa->data->type, lsa->data->id);
+	if (!n || n->lsa != lsa)
+		return NULL;
+	return n;
+}
+
+/* Same as ospf_lsa_has_link(), for a node that isn't irregular */
+static int spf_adj_backlink(struct ospf_spf_index *idx, struct spf_adj_node *w,
+			    struct lsa_header *v)
+{
+	struct spf_adj_link *p2p, *vl, *l = NULL;
+
+	if (w->type == OSPF_NETWORK_LSA) {
+		if (v->type == OSPF_ROUTER_LSA)
+			l = spf_adj_link_find(idx, w, SPF_ADJ_ATTACHED, v->id);
+	} else if (v->type == OSPF_ROUTER_LSA) {
+		p2p = spf_adj_link_find(idx, w, LSA_LINK_TYPE_POINTOPOINT,
+					v->id);
+		vl = spf_adj_link_find(idx, w, LSA_LINK_TYPE_VIRTUALLINK,
+				       v->id);
+		l = (p2p && (!vl || p2p->lsa_pos < vl->lsa_pos)) ? p2p : vl;
+	} else if (v->type == OSPF_NETWORK_LSA)
+		l = spf_adj_link_find(idx, w, LSA_LINK_TYPE_TRANSIT, v->id);
+
+	return l ? l->lsa_pos : -1;
+}
+
+static void spf_adj_link_add(struct ospf_spf_index *idx,
+			     struct spf_adj_node *n, uint8_t type,
+			     struct in_addr id, struct router_lsa_link *l,
+			     int lsa_pos)
+{
+	struct spf_adj_link *link, *first;
+
+	n->count++;
+	if (!idx->link) {
+		idx->link_count++;
+		return;
+	}
+
+	link = &idx->link[idx->link_count++];
+	link->owner = n;
+	link->type = type;
+	link->id = id;
+	link->l = l;
+	link->lsa_pos = lsa_pos;
+
+	first = spf_adj_links_add(&idx->links, link);
+	if (first) {
+		while (first->next)
+			first = first->next;
+		first->next = link;
+	}
+}
+
+/*
+ * Parse the transit links of an LSA the same way ospf_spf_next() walks
+ * them.  Without idx->link allocated yet, only count them.
+ */
+static void spf_adj_node_parse(struct ospf_spf_index *idx,
+			       struct spf_adj_node *n)
+{
+	struct lsa_header *lsa = n->lsa->data;
+	struct router_lsa_link *l;
+	uint8_t *p, *lim;
+	int pos = 0;
+
+	n->first = idx->link_count;
+	n->count = 0;
+
+	p = ((uint8_t *)lsa) + OSPF_LSA_HEADER_SIZE + 4;
+	lim = ((uint8_t *)lsa) + ntohs(lsa->length);
+
+	if (lsa->type == OSPF_NETWORK_LSA) {
+		n->irregular = (lim - p) % sizeof(struct in_addr) != 0;
+		for (; p < lim; p += sizeof(struct in_addr))
+			spf_adj_link_add(idx, n, SPF_ADJ_ATTACHED,
+					 *(struct in_addr *)p, NULL, pos++);
+		return;
+	}
+
+	n->irregular = (lim - p) % OSPF_ROUTER_LSA_LINK_SIZE != 0
+		       || (lim - p) / OSPF_ROUTER_LSA_LINK_SIZE
+				  != ntohs(((struct router_lsa *)lsa)->links);
+
+	while (p < lim) {
+		l = (struct router_lsa_link *)p;
+
+		p += (OSPF_ROUTER_LSA_LINK_SIZE
+		      + (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+
+		if (l->m[0].tos_count)
+			n->irregular = true;
+
+		if (l->m[0].type != LSA_LINK_TYPE_STUB)
+			spf_adj_link_add(idx, n, l->m[0].type, l->link_id, l,
+					 pos);
+		pos++;
+	}
+}
+
+static void spf_adj_nodes_collect(struct ospf_spf_index *idx, LSDB_TABLE *db)
+{
+	struct route_node *rn;
+	struct ospf_lsa *lsa;
+	struct spf_adj_node *n;
+
+	LSDB_LOOP (db, rn, lsa) {
+		/* ospf_lsa_lookup() only finds router-LSAs by ID == adv */
+		if (lsa->data->type == OSPF_ROUTER_LSA
+		    && !IPV4_ADDR_SAME(&lsa->data->id, &lsa->data->adv_router))
+			continue;
+
+		if (!idx->node) {
+			idx->node_count++;
+			spf_adj_node_parse(idx, &(struct spf_adj_node){
+							.lsa = lsa,
+						});
+			continue;
+		}
+
+		n = &idx->node[idx->node_count];
+		n->type = lsa->data->type;
+		n->id = lsa->data->id;
+		n->lsa = lsa;
+
+		/*
+		 * Like ospf_lsa_lookup_by_id(), the first network-LSA with a
+		 * given ID in LSDB order is the one the SPF uses.
+		 */
+		if (spf_adj_nodes_add(&idx->nodes, n))
+			continue;
+
+		idx->node_count++;
+		spf_adj_node_parse(idx, n);
+	}
+}
+
+static void ospf_spf_index_build(struct ospf_area *area)
+{
+	struct ospf_spf_index *idx;
+	struct spf_adj_link *link;
+	struct lsa_header *v;
+	uint32_t nodes, links, i;
+
+	idx = XCALLOC(MTYPE_OSPF_SPF_INDEX, sizeof(*idx));
+	spf_adj_nodes_init(&idx->nodes);
+	spf_adj_links_init(&idx->links);
+
+	/* Size everything first, so that the arrays never move */
+	spf_adj_nodes_collect(idx, ROUTER_LSDB(area));
+	spf_adj_nodes_collect(idx, NETWORK_LSDB(area));
+	nodes = idx->node_count;
+	links = idx->link_count;
+
+	idx->node = XCALLOC(MTYPE_OSPF_SPF_INDEX,
+			    (nodes ? nodes : 1) * sizeof(*idx->node));
+	idx->link = XCALLOC(MTYPE_OSPF_SPF_INDEX,
+			    (links ? links : 1) * sizeof(*idx->link));
+	idx->node_count = idx->link_count = 0;
+	spf_adj_nodes_collect(idx, ROUTER_LSDB(area));
+	spf_adj_nodes_collect(idx, NETWORK_LSDB(area));
+
+	/* Resolve the far end of every link and the way back from there */
+	for (i = 0; i < idx->link_count; i++) {
+		link = &idx->link[i];
+		link->backlink = -1;
+
+		switch (link->type) {
+		case LSA_LINK_TYPE_POINTOPOINT:
+		case LSA_LINK_TYPE_VIRTUALLINK:
+		case SPF_ADJ_ATTACHED:
+			link->w = spf_adj_node_find(idx, OSPF_ROUTER_LSA,
+						    link->id);
+			break;
+		case LSA_LINK_TYPE_TRANSIT:
+			link->w = spf_adj_node_find(idx, OSPF_NETWORK_LSA,
+						    link->id);
+			break;
+		default:
+			continue;
+		}
+
+		if (!link->w)
+			continue;
+
+		v = link->owner->lsa->data;
+		if (link->w->irregular)
+			link->backlink = ospf_lsa_has_link(link->w->lsa->data,
+							   v);
+		else
+			link->backlink = spf_adj_backlink(idx, link->w, v);
+	}
+
+	area->spf_index = idx;
+}
+
+static void ospf_spf_index_free(struct ospf_area *area)
+{
+	struct ospf_spf_index *idx = area->spf_index;
+
+	if (!idx)
+		return;
+
+	while (spf_adj_links_pop(&idx->links))
+		;
+	while (spf_adj_nodes_pop(&idx->nodes))
+		;
+	spf_adj_links_fini(&idx->links);
+	spf_adj_nodes_fini(&idx->nodes);
+
+	XFREE(MTYPE_OSPF_SPF_INDEX, idx->link);
+	XFREE(MTYPE_OSPF_SPF_INDEX, idx->node);
+	XFREE(MTYPE_OSPF_SPF_INDEX, idx);
+	area->spf_index = NULL;
+}
+
+/* Index of the link back to V from W, or -1, as ospf_lsa_has_link() */
+static int ospf_spf_backlink(struct ospf_area *area, struct vertex *w,
+			     struct vertex *v)
+{
+	struct spf_adj_node *n = ospf_spf_index_node(area, w->lsa_p);
+
+	if (!n || n->irregular)
+		return ospf_lsa_has_link(w->lsa, v->lsa);
+	return spf_adj_backlink(area->spf_index, n, v->lsa);
+}
+
 /*
  * Find the next link after prev_link from v to w.  If prev_link is
  * NULL, return the first link from v to w.  Ignore stub and virtual links;
  * these link types will never be returned.
  */
 static struct router_lsa_link *
-ospf_get_next_link(struct vertex *v, struct vertex *w,
+ospf_get_next_link(struct ospf_area *area, struct vertex *v, struct vertex *w,
 		   struct router_lsa_link *prev_link)
 {
 	uint8_t *p;
 	uint8_t *lim;
 	uint8_t lsa_type = LSA_LINK_TYPE_TRANSIT;
 	struct router_lsa_link *l;
+	struct spf_adj_node *n;
+	struct spf_adj_link *link;
 
 	if (w->type == OSPF_VERTEX_ROUTER)
 		lsa_type = LSA_LINK_TYPE_POINTOPOINT;
 
+	n = ospf_spf_index_node(area, v->lsa_p);
+	if (n && n->type == OSPF_ROUTER_LSA) {
+		link = spf_adj_link_find(area->spf_index, n, lsa_type, w->id);
+		if (prev_link)
+			while (link && link->l != prev_link)
+				link = link->next;
+		if (link && prev_link)
+			link = link->next;
+		return link ? link->l : NULL;
+	}
+
 	if (prev_link == NULL)
 		p = ((uint8_t *)v->lsa) + OSPF_LSA_HEADER_SIZE + 4;
 	else {
@@ -674,7 +1041,8 @@ static void ospf_spf_flush_parents(struct vertex *w)
  * Returns vertex parent pointer if created otherwise `NULL` if it already
  * exists.
  */
-static struct vertex_parent *ospf_spf_add_parent(struct vertex *v,
+static struct vertex_parent *ospf_spf_add_parent(struct ospf_area *area,
+						 struct vertex *v,
 						 struct vertex *w,
 						 struct vertex_nexthop *newhop,
 						 struct vertex_nexthop *newlhop,
@@ -729,7 +1097,7 @@ static struct vertex_parent *ospf_spf_add_parent(struct vertex *v,
 		}
 	}
 
-	vp = vertex_parent_new(v, ospf_lsa_has_link(w->lsa, v->lsa), newhop,
+	vp = vertex_parent_new(v, ospf_spf_backlink(area, w, v), newhop,
 			       newlhop);
 	listnode_add_sort(w->parents, vp);
 
@@ -920,7 +1288,8 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 					/* Reverse lookup */
 					if (!added) {
 						while ((l2 = ospf_get_next_link(
-								w, v, l2))) {
+								area, w, v,
+								l2))) {
 							if (match_stub_prefix(
 								    v->lsa,
 								    l->link_data,
@@ -943,8 +1312,8 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 					 * V links to W on PtMP interface;
 					 * find the interface address on W
 					 */
-					while ((l2 = ospf_get_next_link(w, v,
-									l2))) {
+					while ((l2 = ospf_get_next_link(
+							area, w, v, l2))) {
 						la.prefix = l2->link_data;
 
 						if (prefix_cmp((struct prefix
@@ -971,9 +1340,9 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 					memcpy(lnh, nh,
 					       sizeof(struct vertex_nexthop));
 
-					if (ospf_spf_add_parent(v, w, nh, lnh,
-								distance) ==
-					    NULL) {
+					if (ospf_spf_add_parent(area, v, w, nh,
+								lnh, distance)
+					    == NULL) {
 						vertex_nexthop_free(nh);
 						vertex_nexthop_free(lnh);
 					}
@@ -1015,9 +1384,9 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 					memcpy(lnh, nh,
 					       sizeof(struct vertex_nexthop));
 
-					if (ospf_spf_add_parent(v, w, nh, lnh,
-								distance) ==
-					    NULL) {
+					if (ospf_spf_add_parent(area, v, w, nh,
+								lnh, distance)
+					    == NULL) {
 						vertex_nexthop_free(nh);
 						vertex_nexthop_free(lnh);
 					}
@@ -1044,8 +1413,8 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 			lnh = vertex_nexthop_new();
 			memcpy(lnh, nh, sizeof(struct vertex_nexthop));
 
-			if (ospf_spf_add_parent(v, w, nh, lnh, distance) ==
-			    NULL) {
+			if (ospf_spf_add_parent(area, v, w, nh, lnh, distance)
+			    == NULL) {
 				vertex_nexthop_free(nh);
 				vertex_nexthop_free(lnh);
 			}
@@ -1068,7 +1437,8 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 				 */
 
 				assert(w->type == OSPF_VERTEX_ROUTER);
-				while ((l = ospf_get_next_link(w, v, l))) {
+				while ((l = ospf_get_next_link(area, w, v,
+								l))) {
 					/*
 					 * ... For each link in the router-LSA
 					 * that points back to the parent
@@ -1092,9 +1462,9 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 					       sizeof(struct vertex_nexthop));
 
 					added = 1;
-					if (ospf_spf_add_parent(v, w, nh, lnh,
-								distance) ==
-					    NULL) {
+					if (ospf_spf_add_parent(area, v, w, nh,
+								lnh, distance)
+					    == NULL) {
 						vertex_nexthop_free(nh);
 						vertex_nexthop_free(lnh);
 					}
@@ -1161,7 +1531,8 @@ static unsigned int ospf_nexthop_calculation(struct ospf_area *area,
 		nh = vertex_nexthop_new();
 		*nh = *vp->nexthop;
 
-		if (ospf_spf_add_parent(v, w, nh, lnh, distance) == NULL) {
+		if (ospf_spf_add_parent(area, v, w, nh, lnh, distance)
+		    == NULL) {
 			vertex_nexthop_free(nh);
 			vertex_nexthop_free(lnh);
 		}
@@ -1315,6 +1686,10 @@ static void ospf_spf_next(struct vertex *v, struct ospf_area *area,
 	struct in_addr *r;
 	int type = 0, lsa_pos = -1, lsa_pos_next = 0;
 	uint16_t link_distance;
+	struct spf_adj_node *n;
+	struct spf_adj_link *link = NULL;
+	uint32_t i = 0;
+	int backlink;
 
 	/*
 	 * If this is a router-LSA, and bit V of the router-LSA (see Section
@@ -1333,19 +1708,31 @@ static void ospf_spf_next(struct vertex *v, struct ospf_area *area,
 	p = ((uint8_t *)v->lsa) + OSPF_LSA_HEADER_SIZE + 4;
 	lim = ((uint8_t *)v->lsa) + ntohs(v->lsa->length);
 
-	while (p < lim) {
+	/* Use the pre-parsed links if V is in the adjacency index */
+	n = ospf_spf_index_node(area, v->lsa_p);
+
+	while (n ? i < n->count : p < lim) {
 		struct vertex *w;
 		unsigned int distance;
 
+		if (n)
+			link = &area->spf_index->link[n->first + i++];
+
 		/* In case of V is Router-LSA. */
 		if (v->lsa->type == OSPF_ROUTER_LSA) {
-			l = (struct router_lsa_link *)p;
-
-			lsa_pos = lsa_pos_next; /* LSA link position */
-			lsa_pos_next++;
-
-			p += (OSPF_ROUTER_LSA_LINK_SIZE
-			      + (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE));
+			if (link) {
+				l = link->l;
+				lsa_pos = link->lsa_pos;
+			} else {
+				l = (struct router_lsa_link *)p;
+
+				lsa_pos = lsa_pos_next; /* LSA link position */
+				lsa_pos_next++;
+
+				p += (OSPF_ROUTER_LSA_LINK_SIZE
+				      + (l->m[0].tos_count
+					 * OSPF_ROUTER_LSA_TOS_SIZE));
+			}
 
 			/*
 			 * (a) If this is a link to a stub network, examine the
@@ -1380,9 +1767,13 @@ static void ospf_spf_next(struct vertex *v, struct ospf_area *area,
 					zlog_debug(
 						"looking up LSA through VL: %pI4",
 						&l->link_id);
-				w_lsa = ospf_lsa_lookup(area->ospf, area,
-							OSPF_ROUTER_LSA,
-							l->link_id, l->link_id);
+				if (link)
+					w_lsa = link->w ? link->w->lsa : NULL;
+				else
+					w_lsa = ospf_lsa_lookup(
+						area->ospf, area,
+						OSPF_ROUTER_LSA, l->link_id,
+						l->link_id);
 				if (w_lsa && IS_DEBUG_OSPF_EVENT)
 					zlog_debug("found Router LSA %pI4",
 						   &l->link_id);
@@ -1392,8 +1783,12 @@ static void ospf_spf_next(struct vertex *v, struct ospf_area *area,
 					zlog_debug(
 						"Looking up Network LSA, ID: %pI4",
 						&l->link_id);
-				w_lsa = ospf_lsa_lookup_by_id(
-					area, OSPF_NETWORK_LSA, l->link_id);
+				if (link)
+					w_lsa = link->w ? link->w->lsa : NULL;
+				else
+					w_lsa = ospf_lsa_lookup_by_id(
+						area, OSPF_NETWORK_LSA,
+						l->link_id);
 				if (w_lsa && IS_DEBUG_OSPF_EVENT)
 					zlog_debug("found the LSA");
 				break;
@@ -1418,12 +1813,17 @@ static void ospf_spf_next(struct vertex *v, struct ospf_area *area,
 			distance = v->distance + link_distance;
 		} else {
 			/* In case of V is Network-LSA. */
-			r = (struct in_addr *)p;
-			p += sizeof(struct in_addr);
+			if (link)
+				w_lsa = link->w ? link->w->lsa : NULL;
+			else {
+				r = (struct in_addr *)p;
+				p += sizeof(struct in_addr);
+
+				/* Lookup the vertex W's LSA. */
+				w_lsa = ospf_lsa_lookup_by_id(
+					area, OSPF_ROUTER_LSA, *r);
+			}
 
-			/* Lookup the vertex W's LSA. */
-			w_lsa = ospf_lsa_lookup_by_id(area, OSPF_ROUTER_LSA,
-						      *r);
 			if (w_lsa && IS_DEBUG_OSPF_EVENT)
 				zlog_debug("found Router LSA %pI4",
 					   &w_lsa->data->id);
@@ -1449,7 +1849,11 @@ static void ospf_spf_next(struct vertex *v, struct ospf_area *area,
 			continue;
 		}
 
-		if (ospf_lsa_has_link(w_lsa->data, v->lsa) < 0) {
+		if (link)
+			backlink = link->backlink;
+		else
+			backlink = ospf_lsa_has_link(w_lsa->data, v->lsa);
+		if (backlink < 0) {
 			if (IS_DEBUG_OSPF_EVENT)
 				zlog_debug("The LSA doesn't have a link back");
 			continue;
@@ -1690,15 +2094,21 @@ void ospf_spf_cleanup(struct vertex *spf, struct list *vertex_list)
 		list_delete(&vertex_list);
 }
 
-/* Calculating the shortest-path tree for an area, see RFC2328 16.1. */
-void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
-			struct route_table *new_table,
-			struct route_table *all_rtrs,
-			struct route_table *new_rtrs, bool is_dry_run,
-			bool is_root_node)
+/*
+ * RFC2328 16.1. (1) to (3): build the shortest-path tree of the area,
+ * rooted at root_lsa, in area->spf.  Returns false if there is no root.
+ *
+ * This only touches the area and the stat field of the LSAs in its LSDB,
+ * so the trees of different areas can be built in parallel, see
+ * ospf_spf_calculate_areas().
+ */
+static bool ospf_spf_calculate_tree(struct ospf_area *area,
+				    struct ospf_lsa *root_lsa, bool is_dry_run,
+				    bool is_root_node)
 {
 	struct vertex_pqueue_head candidate;
 	struct vertex *v;
+	uint32_t order = 0;
 
 	if (IS_DEBUG_OSPF_EVENT) {
 		zlog_debug("%s: Start: running Dijkstra for area %pI4",
@@ -1715,7 +2125,7 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 			zlog_debug(
 				"%s: Skip area %pI4's calculation due to empty root LSA",
 				__func__, &area->area_id);
-		return;
+		return false;
 	}
 
 	/* Initialize the algorithm's data structures, see RFC2328 16.1. (1). */
@@ -1734,6 +2144,7 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 	 * the router doing the calculation).
 	 */
 	ospf_spf_init(area, root_lsa, is_dry_run, is_root_node);
+	ospf_spf_index_build(area);
 
 	/* Set Area A's TransitCapability to false. */
 	area->transit = OSPF_TRANSIT_FALSE;
@@ -1757,10 +2168,45 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 			break;
 
 		v->lsa_p->stat = LSA_SPF_IN_SPFTREE;
+		v->order = ++order;
 
 		ospf_vertex_add_parent(v);
 
-		/* RFC2328 16.1. (4). */
+		/* Iterate back to (2), see RFC2328 16.1. (5). */
+	}
+
+	ospf_spf_index_free(area);
+
+	return true;
+}
+
+/*
+ * RFC2328 16.1. (4) for every vertex of the tree ospf_spf_calculate_tree()
+ * built, in the order they were added to it, then the second stage for the
+ * stub networks.
+ */
+static void ospf_spf_calculate_routes(struct ospf_area *area,
+				      struct route_table *new_table,
+				      struct route_table *all_rtrs,
+				      struct route_table *new_rtrs)
+{
+	struct listnode *node;
+	struct vertex **tree, *v;
+	unsigned int count, i;
+
+	/* Every vertex but the root got a distinct order, from 1 on */
+	count = listcount(area->spf_vertex_list) - 1;
+	tree = XCALLOC(MTYPE_TMP, (count ? count : 1) * sizeof(*tree));
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		if (v == area->spf)
+			continue;
+		assert(v->order >= 1 && v->order <= count);
+		tree[v->order - 1] = v;
+	}
+
+	for (i = 0; i < count; i++) {
+		v = tree[i];
+
 		if (v->type != OSPF_VERTEX_ROUTER)
 			ospf_intra_add_transit(new_table, v, area);
 		else {
@@ -1768,10 +2214,10 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 			if (all_rtrs)
 				ospf_intra_add_router(all_rtrs, v, area, true);
 		}
-
-		/* Iterate back to (2), see RFC2328 16.1. (5). */
 	}
 
+	XFREE(MTYPE_TMP, tree);
+
 	if (IS_DEBUG_OSPF_EVENT) {
 		ospf_spf_dump(area->spf, 0);
 		ospf_route_table_dump(new_table);
@@ -1790,30 +2236,490 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 	/* Increment SPF Calculation Counter. */
 	area->spf_calculation++;
 
-	monotime(&area->ospf->ts_spf);
-	area->ts_spf = area->ospf->ts_spf;
+	/*
+	 * TI-LFA may run its dry runs on a worker pthread, the instance's
+	 * time stamp is left to the main calculation.
+	 */
+	if (!area->spf_dry_run) {
+		monotime(&area->ospf->ts_spf);
+		area->ts_spf = area->ospf->ts_spf;
+	}
 
 	if (IS_DEBUG_OSPF_EVENT)
 		zlog_debug("%s: Stop. %zd vertices", __func__,
 			   mtype_stats_alloc(MTYPE_OSPF_VERTEX));
 }
 
+/* Calculating the shortest-path tree for an area, see RFC2328 16.1. */
+void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
+			struct route_table *new_table,
+			struct route_table *all_rtrs,
+			struct route_table *new_rtrs, bool is_dry_run,
+			bool is_root_node)
+{
+	if (!ospf_spf_calculate_tree(area, root_lsa, is_dry_run, is_root_node))
+		return;
+
+	ospf_spf_calculate_routes(area, new_table, all_rtrs, new_rtrs);
+}
+
+/*
+ * Incremental SPF.
+ *
+ * Most LSA changes leave the shortest-path tree of an area alone: a new
+ * instance of a router-LSA whose point-to-point, transit and virtual links
+ * are unchanged (its stub links changed, or it was just refreshed), and
+ * summary-LSAs, which only matter to the inter-area calculation.  So the
+ * tree of the last full run is kept, and until the topology of the area
+ * changes the next calculation walks that tree again instead of running
+ * Dijkstra: the routers and transit networks get their routes from the
+ * kept vertices, and only the stub networks are calculated again.
+ */
+
+static int vertex_order_cmp(const void **a, const void **b)
+{
+	const struct vertex *v1 = *a, *v2 = *b;
+
+	return v1->order < v2->order ? -1 : v1->order > v2->order;
+}
+
+/*
+ * Next link of a router-LSA that is not a stub link, NULL at the end.  'pos'
+ * is the position of the link returned, counting all links.
+ */
+static struct router_lsa_link *ospf_router_lsa_topo_link(uint8_t **p,
+							 const uint8_t *lim,
+							 int *pos, size_t *size)
+{
+	struct router_lsa_link *l;
+
+	while (*p + OSPF_ROUTER_LSA_LINK_SIZE <= lim) {
+		l = (struct router_lsa_link *)*p;
+		*size = OSPF_ROUTER_LSA_LINK_SIZE
+			+ l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE;
+		*p += *size;
+		(*pos)++;
+		if (l->m[0].type != LSA_LINK_TYPE_STUB)
+			return l;
+	}
+
+	return NULL;
+}
+
+/*
+ * Whether two instances of a router-LSA have the same flags and the same
+ * point-to-point, transit and virtual links, in the same order.  Stub links
+ * may differ, be added or be removed.
+ *
+ * The nexthops kept in the tree refer to the links of the root's router-LSA
+ * by their position (see ospf_if_lookup_by_lsa_pos()), so for the root's
+ * own LSA the other links must also stay at the same positions.
+ */
+static bool ospf_router_lsa_same_topology(struct lsa_header *old,
+					  struct lsa_header *new,
+					  bool same_pos)
+{
+	struct router_lsa *rl_old = (struct router_lsa *)old;
+	struct router_lsa *rl_new = (struct router_lsa *)new;
+	struct router_lsa_link *l_old, *l_new;
+	uint8_t *p_old, *p_new, *lim_old, *lim_new;
+	size_t size_old = 0, size_new = 0;
+	int pos_old = -1, pos_new = -1;
+
+	if (rl_old->flags != rl_new->flags)
+		return false;
+
+	p_old = ((uint8_t *)old) + OSPF_LSA_HEADER_SIZE + 4;
+	lim_old = ((uint8_t *)old) + ntohs(old->length);
+	p_new = ((uint8_t *)new) + OSPF_LSA_HEADER_SIZE + 4;
+	lim_new = ((uint8_t *)new) + ntohs(new->length);
+
+	for (;;) {
+		l_old = ospf_router_lsa_topo_link(&p_old, lim_old, &pos_old,
+						  &size_old);
+		l_new = ospf_router_lsa_topo_link(&p_new, lim_new, &pos_new,
+						  &size_new);
+		if (!l_old || !l_new)
+			return !l_old && !l_new;
+
+		if (size_old != size_new || memcmp(l_old, l_new, size_old))
+			return false;
+		if (same_pos && pos_old != pos_new)
+			return false;
+	}
+}
+
+/*
+ * Called when 'new' replaces 'old' (NULL if there was none) in the LSDB of
+ * the area, for router and network-LSAs that need routes to be calculated
+ * again.  Records whether the next SPF run can reuse the kept tree.
+ */
+void ospf_spf_lsa_changed(struct ospf_area *area, struct ospf_lsa *old,
+			  struct ospf_lsa *new)
+{
+	if (new->data->type == OSPF_ROUTER_LSA && old && !IS_LSA_MAXAGE(old)
+	    && !IS_LSA_MAXAGE(new)
+	    && ospf_router_lsa_same_topology(
+		    old->data, new->data,
+		    IPV4_ADDR_SAME(&new->data->adv_router,
+				   &area->ospf->router_id)))
+		return;
+
+	if (IS_DEBUG_OSPF_EVENT && !area->spf_topology_changed)
+		zlog_debug("%s: area %pI4 topology changed by LSA type %u id %pI4",
+			   __func__, &area->area_id, new->data->type,
+			   &new->data->id);
+
+	area->spf_topology_changed = true;
+}
+
+/* Keep the tree of the last ospf_spf_calculate() run of the area. */
+void ospf_spf_tree_keep(struct ospf_area *area)
+{
+	ospf_spf_tree_free(area);
+
+	if (!area->spf)
+		return;
+
+	/*
+	 * Vertices in the order they were added to the tree, root first.  The
+	 * LSAs they point to may go away, ospf_spf_calculate_incremental()
+	 * looks them up again before using the tree.
+	 */
+	list_sort(area->spf_vertex_list, vertex_order_cmp);
+
+	area->spf_kept = area->spf;
+	area->spf_kept_vertex_list = area->spf_vertex_list;
+	area->spf_topology_changed = false;
+
+	area->spf = NULL;
+	area->spf_vertex_list = NULL;
+}
+
+void ospf_spf_tree_free(struct ospf_area *area)
+{
+	ospf_spf_cleanup(area->spf_kept, area->spf_kept_vertex_list);
+
+	area->spf_kept = NULL;
+	area->spf_kept_vertex_list = NULL;
+}
+
+/*
+ * Calculate the routes of the area from the tree kept by
+ * ospf_spf_tree_keep(), as ospf_spf_calculate() would.  Returns false, and
+ * leaves the tables alone, if the topology changed since and a full run is
+ * needed.
+ */
+bool ospf_spf_calculate_incremental(struct ospf_area *area,
+				    struct route_table *new_table,
+				    struct route_table *all_rtrs,
+				    struct route_table *new_rtrs)
+{
+	struct listnode *node;
+	struct ospf_lsa *lsa;
+	struct vertex *v;
+
+	if (!area->spf_kept || area->spf_topology_changed) {
+		ospf_spf_tree_free(area);
+		return false;
+	}
+
+	/*
+	 * The LSAs the kept tree points to may have been replaced since, by
+	 * instances with the same topology.  Find the current ones.
+	 */
+	for (ALL_LIST_ELEMENTS_RO(area->spf_kept_vertex_list, node, v)) {
+		if (v == area->spf_kept)
+			lsa = area->router_lsa_self;
+		else if (v->type == OSPF_VERTEX_ROUTER)
+			lsa = ospf_lsa_lookup_by_id(area, OSPF_ROUTER_LSA,
+						    v->id);
+		else
+			lsa = ospf_lsa_lookup_by_id(area, OSPF_NETWORK_LSA,
+						    v->id);
+
+		if (!lsa || IS_LSA_MAXAGE(lsa)) {
+			if (IS_DEBUG_OSPF_EVENT)
+				zlog_debug("%s: area %pI4 vertex %pI4 is gone, running full SPF",
+					   __func__, &area->area_id, &v->id);
+			ospf_spf_tree_free(area);
+			return false;
+		}
+
+		v->lsa_p = lsa;
+		v->lsa = lsa->data;
+		UNSET_FLAG(v->flags, OSPF_VERTEX_PROCESSED);
+	}
+
+	if (IS_DEBUG_OSPF_EVENT)
+		zlog_debug("%s: Start: reusing the SPF tree of area %pI4",
+			   __func__, &area->area_id);
+
+	area->spf = area->spf_kept;
+	area->spf_vertex_list = area->spf_kept_vertex_list;
+
+	/* What ospf_spf_init() and ospf_spf_next() set up along the way */
+	area->abr_count = 0;
+	area->asbr_count = 0;
+	area->transit = OSPF_TRANSIT_FALSE;
+	area->shortcut_capability = 1;
+
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		if (v->type == OSPF_VERTEX_ROUTER
+		    && IS_ROUTER_LSA_VIRTUAL((struct router_lsa *)v->lsa))
+			area->transit = OSPF_TRANSIT_TRUE;
+
+		if (v == area->spf)
+			continue;
+
+		if (v->type != OSPF_VERTEX_ROUTER)
+			ospf_intra_add_transit(new_table, v, area);
+		else {
+			ospf_intra_add_router(new_rtrs, v, area, false);
+			if (all_rtrs)
+				ospf_intra_add_router(all_rtrs, v, area, true);
+		}
+	}
+
+	ospf_spf_process_stubs(area, area->spf, new_table, 0);
+
+	area->spf = NULL;
+	area->spf_vertex_list = NULL;
+
+	area->spf_calculation++;
+
+	monotime(&area->ospf->ts_spf);
+	area->ts_spf = area->ospf->ts_spf;
+
+	return true;
+}
+
+/*
+ * Area state the dry runs of TI-LFA would otherwise overwrite with that of
+ * their own trees.
+ */
+struct ospf_spf_area_state {
+	uint8_t transit;
+	int shortcut_capability;
+	uint32_t abr_count;
+	uint32_t asbr_count;
+	bool dry_run;
+	bool root_node;
+};
+
+static void ospf_spf_area_state_save(struct ospf_area *area,
+				     struct ospf_spf_area_state *state)
+{
+	state->transit = area->transit;
+	state->shortcut_capability = area->shortcut_capability;
+	state->abr_count = area->abr_count;
+	state->asbr_count = area->asbr_count;
+	state->dry_run = area->spf_dry_run;
+	state->root_node = area->spf_root_node;
+}
+
+static void ospf_spf_area_state_restore(struct ospf_area *area,
+					struct ospf_spf_area_state *state)
+{
+	area->transit = state->transit;
+	area->shortcut_capability = state->shortcut_capability;
+	area->abr_count = state->abr_count;
+	area->asbr_count = state->asbr_count;
+	area->spf_dry_run = state->dry_run;
+	area->spf_root_node = state->root_node;
+}
+
+/* Keep or free the tree of a full run, once its routes are calculated */
+static void ospf_spf_calculate_area_done(struct ospf_area *area, bool keep)
+{
+	if (keep) {
+		ospf_spf_tree_keep(area);
+		return;
+	}
+
+	ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+
+	area->spf = NULL;
+	area->spf_vertex_list = NULL;
+}
+
 void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
 			     struct route_table *new_table,
 			     struct route_table *all_rtrs,
 			     struct route_table *new_rtrs)
 {
+	/* TI-LFA runs SPF for every protected resource on top of the tree */
+	bool keep = ospf->spf_incremental && !ospf->ti_lfa_enabled;
+	struct ospf_spf_area_state state;
+
+	if (keep
+	    && ospf_spf_calculate_incremental(area, new_table, all_rtrs,
+					      new_rtrs)) {
+		area->spf_incremental_runs++;
+		return;
+	}
+
+	ospf_spf_tree_free(area);
+
 	ospf_spf_calculate(area, area->router_lsa_self, new_table, all_rtrs,
 			   new_rtrs, false, true);
+	area->spf_full_runs++;
 
-	if (ospf->ti_lfa_enabled)
+	if (ospf->ti_lfa_enabled) {
+		ospf_spf_area_state_save(area, &state);
 		ospf_ti_lfa_compute(area, new_table,
 				    ospf->ti_lfa_protection_type);
+		ospf_spf_area_state_restore(area, &state);
+	}
 
-	ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+	ospf_spf_calculate_area_done(area, keep);
+}
 
-	area->spf = NULL;
-	area->spf_vertex_list = NULL;
+/*
+ * Parallel SPF.
+ *
+ * With "spf-workers", the trees of the areas that need a full SPF run, and
+ * their TI-LFA P and Q spaces, are calculated on a pool of pthreads.  The
+ * main pthread is blocked meanwhile, so the LSDBs stay as they are, and the
+ * calculation for an area only writes to the area and to the stat field of
+ * the LSAs in its own LSDB.  The routes all go into the same tables, so
+ * they are calculated from the trees afterwards, on the main pthread and in
+ * the same area order as ospf_spf_calculate_areas().
+ *
+ * Not with virtual links: the nexthops of the backbone's virtual links are
+ * calculated along with the routes of their transit areas, which have to
+ * come before the backbone's tree.
+ */
+struct ospf_spf_job {
+	struct ospf_area *area;
+	bool built;
+};
+
+static void ospf_spf_job_run(void *arg, size_t idx)
+{
+	struct ospf_spf_job *job = (struct ospf_spf_job *)arg + idx;
+	struct ospf_area *area = job->area;
+	struct ospf *ospf = area->ospf;
+	struct ospf_spf_area_state state;
+
+	job->built = ospf_spf_calculate_tree(area, area->router_lsa_self, false,
+					     true);
+
+	/* The backup paths are inserted along with the routes */
+	if (ospf->ti_lfa_enabled) {
+		ospf_spf_area_state_save(area, &state);
+		ospf_ti_lfa_generate_p_spaces(area,
+					      ospf->ti_lfa_protection_type);
+		ospf_spf_area_state_restore(area, &state);
+	}
+}
+
+/* Whether an area gets a full run, rather than reusing its kept tree */
+static bool ospf_spf_area_needs_tree(struct ospf *ospf, struct ospf_area *area)
+{
+	bool keep = ospf->spf_incremental && !ospf->ti_lfa_enabled;
+
+	return !keep || !area->spf_kept || area->spf_topology_changed;
+}
+
+static bool ospf_spf_calculate_areas_parallel(struct ospf *ospf,
+					      struct route_table *new_table,
+					      struct route_table *all_rtrs,
+					      struct route_table *new_rtrs)
+{
+	bool keep = ospf->spf_incremental && !ospf->ti_lfa_enabled;
+	struct ospf_spf_job *jobs, **area_jobs;
+	struct ospf_area **areas, *area;
+	struct listnode *node;
+	unsigned int count = 0, njobs = 0, i;
+
+	if (!ospf->spf_pool || workpool_get_workers(ospf->spf_pool) < 2
+	    || listcount(ospf->vlinks))
+		return false;
+
+	/* The backbone comes last, as in ospf_spf_calculate_areas() */
+	areas = XCALLOC(MTYPE_TMP,
+			(listcount(ospf->areas) + 1) * sizeof(*areas));
+	for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area))
+		if (area != ospf->backbone)
+			areas[count++] = area;
+	if (ospf->backbone)
+		areas[count++] = ospf->backbone;
+
+	for (i = 0; i < count; i++)
+		if (ospf_spf_area_needs_tree(ospf, areas[i]))
+			njobs++;
+
+	if (njobs < 2) {
+		XFREE(MTYPE_TMP, areas);
+		return false;
+	}
+
+	jobs = XCALLOC(MTYPE_TMP, njobs * sizeof(*jobs));
+	area_jobs = XCALLOC(MTYPE_TMP, count * sizeof(*area_jobs));
+	njobs = 0;
+	for (i = 0; i < count; i++) {
+		if (!ospf_spf_area_needs_tree(ospf, areas[i]))
+			continue;
+
+		ospf_spf_tree_free(areas[i]);
+		jobs[njobs].area = areas[i];
+		area_jobs[i] = &jobs[njobs++];
+	}
+
+	if (IS_DEBUG_OSPF_EVENT)
+		zlog_debug("%s: building %u area trees on %u pthreads",
+			   __func__, njobs,
+			   workpool_get_workers(ospf->spf_pool));
+
+	workpool_run(ospf->spf_pool, ospf_spf_job_run, jobs, njobs);
+
+	for (i = 0; i < count; i++) {
+		area = areas[i];
+
+		/* Reusing the kept tree is quick, and happens right here */
+		if (!area_jobs[i]) {
+			ospf_spf_calculate_area(ospf, area, new_table, all_rtrs,
+						new_rtrs);
+			continue;
+		}
+
+		if (area_jobs[i]->built)
+			ospf_spf_calculate_routes(area, new_table, all_rtrs,
+						  new_rtrs);
+		area->spf_full_runs++;
+
+		if (ospf->ti_lfa_enabled) {
+			ospf_ti_lfa_insert_backup_paths(area, new_table);
+			ospf_ti_lfa_free_p_spaces(area);
+		}
+
+		ospf_spf_calculate_area_done(area, keep);
+	}
+
+	XFREE(MTYPE_TMP, area_jobs);
+	XFREE(MTYPE_TMP, jobs);
+	XFREE(MTYPE_TMP, areas);
+
+	return true;
+}
+
+void ospf_spf_set_workers(struct ospf *ospf, unsigned int workers)
+{
+	if (workers < 2) {
+		if (ospf->spf_pool)
+			workpool_free(&ospf->spf_pool);
+		return;
+	}
+
+	if (!ospf->spf_pool)
+		ospf->spf_pool = workpool_new("OSPF SPF worker", "ospfd_spf");
+	workpool_set_workers(ospf->spf_pool, workers);
+}
+
+unsigned int ospf_spf_get_workers(struct ospf *ospf)
+{
+	return ospf->spf_pool ? workpool_get_workers(ospf->spf_pool) : 1;
 }
 
 void ospf_spf_calculate_areas(struct ospf *ospf, struct route_table *new_table,
@@ -1823,6 +2729,10 @@ void ospf_spf_calculate_areas(struct ospf *ospf, struct route_table *new_table,
 	struct ospf_area *area;
 	struct listnode *node, *nnode;
 
+	if (ospf_spf_calculate_areas_parallel(ospf, new_table, all_rtrs,
+					      new_rtrs))
+		return;
+
 	/* Calculate SPF for each area. */
 	for (ALL_LIST_ELEMENTS(ospf->areas, node, nnode, area)) {
 		/* Do backbone last, so as to first discover intra-area paths
@@ -1856,6 +2766,9 @@ static void ospf_spf_calculate_schedule_worker(struct thread *thread)
 
 	ospf->t_spf_calc = NULL;
 
+	/* Covers the prefixes queued for a partial route calculation */
+	ospf_prc_cancel(ospf);
+
 	ospf_vl_unapprove(ospf);
 
 	/* Execute SPF for each area including backbone, see RFC 2328 16.1. */
@@ -2002,6 +2915,22 @@ void ospf_spf_calculate_schedule(struct ospf *ospf, ospf_spf_reason_t reason)
 
 	ospf_spf_set_reason(reason);
 
+	/*
+	 * Router and network-LSAs tell ospf_spf_lsa_changed() what changed,
+	 * summary-LSAs leave the trees alone.  Anything else may have changed
+	 * the topology.
+	 */
+	if (reason != SPF_FLAG_ROUTER_LSA_INSTALL
+	    && reason != SPF_FLAG_NETWORK_LSA_INSTALL
+	    && reason != SPF_FLAG_SUMMARY_LSA_INSTALL
+	    && reason != SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL) {
+		struct ospf_area *area;
+		struct listnode *node;
+
+		for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area))
+			area->spf_topology_changed = true;
+	}
+
 	/* SPF calculation timer is already scheduled. */
 	if (ospf->t_spf_calc) {
 		if (IS_DEBUG_OSPF_EVENT)
@@ -28,6 +28,7 @@ struct vertex {
 	struct ospf_lsa *lsa_p;
 	struct lsa_header *lsa; /* Router or Network LSA */
 	uint32_t distance;      /* from root to this vertex */
+	uint32_t order;		/* when it was added to the SPF tree */
 	struct list *parents;   /* list of parents in SPF tree */
 	struct list *children;  /* list of children in SPF tree*/
 };
@@ -72,6 +73,16 @@ extern void ospf_spf_calculate_areas(struct ospf *ospf,
 				     struct route_table *new_table,
 				     struct route_table *all_rtrs,
 				     struct route_table *new_rtrs);
+extern void ospf_spf_set_workers(struct ospf *ospf, unsigned int workers);
+extern unsigned int ospf_spf_get_workers(struct ospf *ospf);
+extern bool ospf_spf_calculate_incremental(struct ospf_area *area,
+					   struct route_table *new_table,
+					   struct route_table *all_rtrs,
+					   struct route_table *new_rtrs);
+extern void ospf_spf_tree_keep(struct ospf_area *area);
+extern void ospf_spf_tree_free(struct ospf_area *area);
+extern void ospf_spf_lsa_changed(struct ospf_area *area, struct ospf_lsa *old,
+				 struct ospf_lsa *new);
 extern void ospf_rtrs_free(struct route_table *);
 extern void ospf_spf_cleanup(struct vertex *spf, struct list *vertex_list);
 extern void ospf_spf_copy(struct vertex *vertex, struct list *vertex_list);
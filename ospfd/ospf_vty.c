@@ -2681,6 +2681,48 @@ DEFUN(no_ospf_ti_lfa, no_ospf_ti_lfa_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFPY(ospf_incremental_spf, ospf_incremental_spf_cmd,
+      "[no] incremental-spf",
+      NO_STR
+      "Reuse the shortest-path tree when only stub links change\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+
+	if (ospf->spf_incremental == !no)
+		return CMD_SUCCESS;
+
+	ospf->spf_incremental = !no;
+
+	ospf_spf_calculate_schedule(ospf, SPF_FLAG_CONFIG_CHANGE);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY(ospf_spf_workers, ospf_spf_workers_cmd,
+      "spf-workers (1-64)$workers",
+      "Calculate the shortest-path trees of several areas in parallel\n"
+      "Number of pthreads, including the main one\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+
+	ospf_spf_set_workers(ospf, workers);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY(no_ospf_spf_workers, no_ospf_spf_workers_cmd,
+      "no spf-workers [(1-64)]",
+      NO_STR
+      "Calculate the shortest-path trees of several areas in parallel\n"
+      "Number of pthreads, including the main one\n")
+{
+	VTY_DECLVAR_INSTANCE_CONTEXT(ospf, ospf);
+
+	ospf_spf_set_workers(ospf, 1);
+
+	return CMD_SUCCESS;
+}
+
 static void ospf_maxpath_set(struct vty *vty, struct ospf *ospf, uint16_t paths)
 {
 	if (ospf->max_multipath == paths)
@@ -2936,6 +2978,10 @@ static void show_ip_ospf_area(struct vty *vty, struct ospf_area *area,
 		/* Show SPF calculation times. */
 		json_object_int_add(json_area, "spfExecutedCounter",
 				    area->spf_calculation);
+		json_object_int_add(json_area, "spfFullCounter",
+				    area->spf_full_runs);
+		json_object_int_add(json_area, "spfIncrementalCounter",
+				    area->spf_incremental_runs);
 		json_object_int_add(json_area, "lsaNumber", area->lsdb->total);
 		json_object_int_add(
 			json_area, "lsaRouterNumber",
@@ -2990,6 +3036,10 @@ static void show_ip_ospf_area(struct vty *vty, struct ospf_area *area,
 		/* Show SPF calculation times. */
 		vty_out(vty, "   SPF algorithm executed %d times\n",
 			area->spf_calculation);
+		if (area->ospf->spf_incremental)
+			vty_out(vty, "   SPF runs: %u full, %u incremental\n",
+				area->spf_full_runs,
+				area->spf_incremental_runs);
 
 		/* Show number of LSA. */
 		vty_out(vty, "   Number of LSA %ld\n", area->lsdb->total);
@@ -3237,6 +3287,14 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 					    time_store);
 		} else
 			json_object_boolean_true_add(json_vrf, "spfHasNotRun");
+		if (ospf->spf_incremental) {
+			json_object_boolean_true_add(json_vrf,
+						     "spfIncremental");
+			json_object_int_add(json_vrf, "prcExecutedCounter",
+					    ospf->prc_runs);
+		}
+		json_object_int_add(json_vrf, "spfWorkers",
+				    ospf_spf_get_workers(ospf));
 	} else {
 		vty_out(vty, " SPF algorithm ");
 		if (ospf->ts_spf.tv_sec || ospf->ts_spf.tv_usec) {
@@ -3249,6 +3307,13 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 						  timebuf, sizeof(timebuf)));
 		} else
 			vty_out(vty, "has not been run\n");
+		if (ospf->spf_incremental)
+			vty_out(vty,
+				" Incremental SPF enabled, partial route calculation executed %u times\n",
+				ospf->prc_runs);
+		if (ospf->spf_pool)
+			vty_out(vty, " SPF calculated on %u pthreads\n",
+				ospf_spf_get_workers(ospf));
 	}
 
 	if (json) {
@@ -6681,51 +6746,44 @@ int (*show_function[])(struct vty *, struct ospf_lsa *, json_object *) = {
 	show_opaque_lsa_detail,
 };
 
-static void show_lsa_prefix_set(struct vty *vty, struct prefix_ls *lp,
-				struct in_addr *id, struct in_addr *adv_router)
+static void show_lsa_detail_one(struct vty *vty, struct ospf_lsa *lsa,
+				json_object *json)
 {
-	memset(lp, 0, sizeof(struct prefix_ls));
-	lp->family = AF_UNSPEC;
-	if (id == NULL)
-		lp->prefixlen = 0;
-	else if (adv_router == NULL) {
-		lp->prefixlen = IPV4_MAX_BITLEN;
-		lp->id = *id;
-	} else {
-		lp->prefixlen = 64;
-		lp->id = *id;
-		lp->adv_router = *adv_router;
+	json_object *json_lsa = NULL;
+
+	if (show_function[lsa->data->type] != NULL) {
+		if (json) {
+			json_lsa = json_object_new_object();
+			json_object_array_add(json, json_lsa);
+		}
+
+		show_function[lsa->data->type](vty, lsa, json_lsa);
 	}
 }
 
-static void show_lsa_detail_proc(struct vty *vty, struct route_table *rt,
-				 struct in_addr *id, struct in_addr *adv_router,
-				 json_object *json)
+/* LSAs of the type with that Link State ID and Advertising Router, if set */
+static void show_lsa_detail_proc(struct vty *vty, struct ospf_lsdb *lsdb,
+				 uint8_t type, struct in_addr *id,
+				 struct in_addr *adv_router, json_object *json)
 {
-	struct prefix_ls lp;
-	struct route_node *rn, *start;
-	struct ospf_lsa *lsa;
-	json_object *json_lsa = NULL;
-
-	show_lsa_prefix_set(vty, &lp, id, adv_router);
-	start = route_node_get(rt, (struct prefix *)&lp);
-	if (start) {
-		route_lock_node(start);
-		for (rn = start; rn; rn = route_next_until(rn, start))
-			if ((lsa = rn->info)) {
-				if (show_function[lsa->data->type] != NULL) {
-					if (json) {
-						json_lsa =
-							json_object_new_object();
-						json_object_array_add(json,
-								      json_lsa);
-					}
-
-					show_function[lsa->data->type](
-						vty, lsa, json_lsa);
-				}
-			}
-		route_unlock_node(start);
+	struct prefix_ipv4 p;
+	struct route_node *rn;
+	struct ospf_lsa *lsa = NULL;
+
+	if (id == NULL) {
+		LSDB_LOOP (lsdb->type[type].db, rn, lsa)
+			show_lsa_detail_one(vty, lsa, json);
+	} else if (adv_router == NULL) {
+		p.family = AF_INET;
+		p.prefixlen = IPV4_MAX_BITLEN;
+		p.prefix = *id;
+		while ((lsa = ospf_lsdb_lookup_by_id_range(lsdb, type, &p,
+							   lsa)))
+			show_lsa_detail_one(vty, lsa, json);
+	} else {
+		lsa = ospf_lsdb_lookup_by_id(lsdb, type, *id, *adv_router);
+		if (lsa)
+			show_lsa_detail_one(vty, lsa, json);
 	}
 }
 
@@ -6751,7 +6809,7 @@ static void show_lsa_detail(struct vty *vty, struct ospf *ospf, int type,
 		else
 			json_lsa_array = json_object_new_array();
 
-		show_lsa_detail_proc(vty, AS_LSDB(ospf, type), id, adv_router,
+		show_lsa_detail_proc(vty, ospf->lsdb, type, id, adv_router,
 				     json_lsa_array);
 		if (json)
 			json_object_object_add(json,
@@ -6779,7 +6837,7 @@ static void show_lsa_detail(struct vty *vty, struct ospf *ospf, int type,
 						       json_lsa_array);
 			}
 
-			show_lsa_detail_proc(vty, AREA_LSDB(area, type), id,
+			show_lsa_detail_proc(vty, area->lsdb, type, id,
 					     adv_router, json_lsa_array);
 		}
 
@@ -6795,8 +6853,7 @@ static void show_lsa_detail(struct vty *vty, struct ospf *ospf, int type,
 	}
 }
 
-static void show_lsa_detail_adv_router_proc(struct vty *vty,
-					    struct route_table *rt,
+static void show_lsa_detail_adv_router_proc(struct vty *vty, LSDB_TABLE *rt,
 					    struct in_addr *adv_router,
 					    json_object *json)
 {
@@ -6804,29 +6861,26 @@ static void show_lsa_detail_adv_router_proc(struct vty *vty,
 	struct route_node *rn;
 	struct ospf_lsa *lsa;
 
-	for (rn = route_top(rt); rn; rn = route_next(rn))
-		if ((lsa = rn->info)) {
-			json_object *json_lsa = NULL;
+	LSDB_LOOP (rt, rn, lsa) {
+		json_object *json_lsa = NULL;
 
-			if (IPV4_ADDR_SAME(adv_router,
-					   &lsa->data->adv_router)) {
-				if (CHECK_FLAG(lsa->flags, OSPF_LSA_LOCAL_XLT))
-					continue;
-				if (json)
-					json_lsa = json_object_new_object();
+		if (IPV4_ADDR_SAME(adv_router, &lsa->data->adv_router)) {
+			if (CHECK_FLAG(lsa->flags, OSPF_LSA_LOCAL_XLT))
+				continue;
+			if (json)
+				json_lsa = json_object_new_object();
 
-				if (show_function[lsa->data->type] != NULL)
-					show_function[lsa->data->type](
-						vty, lsa, json_lsa);
-				if (json)
-					json_object_object_add(
-						json,
-						inet_ntop(AF_INET,
-							  &lsa->data->id,
-							  buf, sizeof(buf)),
-						json_lsa);
-			}
+			if (show_function[lsa->data->type] != NULL)
+				show_function[lsa->data->type](vty, lsa,
+							       json_lsa);
+			if (json)
+				json_object_object_add(
+					json,
+					inet_ntop(AF_INET, &lsa->data->id, buf,
+						  sizeof(buf)),
+					json_lsa);
 		}
+	}
 }
 
 /* Show detail LSA information. */
@@ -12716,6 +12770,12 @@ static int ospf_config_write_one(struct vty *vty, struct ospf *ospf)
 			vty_out(vty, " fast-reroute ti-lfa\n");
 	}
 
+	if (ospf->spf_incremental)
+		vty_out(vty, " incremental-spf\n");
+
+	if (ospf->spf_pool)
+		vty_out(vty, " spf-workers %u\n", ospf_spf_get_workers(ospf));
+
 	/* Network area print. */
 	config_write_network_area(vty, ospf);
 
@@ -13356,6 +13416,11 @@ void ospf_vty_init(void)
 	install_element(OSPF_NODE, &ospf_ti_lfa_cmd);
 	install_element(OSPF_NODE, &no_ospf_ti_lfa_cmd);
 
+	/* incremental SPF */
+	install_element(OSPF_NODE, &ospf_incremental_spf_cmd);
+	install_element(OSPF_NODE, &ospf_spf_workers_cmd);
+	install_element(OSPF_NODE, &no_ospf_spf_workers_cmd);
+
 	/* Max path configurations */
 	install_element(OSPF_NODE, &ospf_max_multipath_cmd);
 	install_element(OSPF_NODE, &no_ospf_max_multipath_cmd);
@@ -44,6 +44,7 @@
 #include "ospfd/ospf_abr.h"
 #include "ospfd/ospf_flood.h"
 #include "ospfd/ospf_ase.h"
+#include "ospfd/ospf_ia.h"
 #include "ospfd/ospf_ldp_sync.h"
 #include "ospfd/ospf_gr.h"
 #include "ospfd/ospf_apiserver.h"
@@ -359,6 +360,7 @@ struct ospf *ospf_new_alloc(unsigned short instance, const char *name)
 	new->new_external_route = route_table_init();
 	new->old_external_route = route_table_init();
 	new->external_lsas = route_table_init();
+	new->prc_prefixes = route_table_init();
 
 	new->stub_router_startup_time = OSPF_STUB_ROUTER_UNCONFIGURED;
 	new->stub_router_shutdown_time = OSPF_STUB_ROUTER_UNCONFIGURED;
@@ -801,6 +803,8 @@ static void ospf_finish_final(struct ospf *ospf)
 	THREAD_OFF(ospf->t_write);
 	THREAD_OFF(ospf->t_spf_calc);
 	THREAD_OFF(ospf->t_ase_calc);
+	ospf_prc_cancel(ospf);
+	ospf_spf_set_workers(ospf, 1);
 	THREAD_OFF(ospf->t_maxage);
 	THREAD_OFF(ospf->t_maxage_walker);
 	THREAD_OFF(ospf->t_abr_task);
@@ -860,6 +864,7 @@ static void ospf_finish_final(struct ospf *ospf)
 	if (ospf->external_lsas) {
 		ospf_ase_external_lsas_finish(ospf->external_lsas);
 	}
+	route_table_finish(ospf->prc_prefixes);
 
 	for (i = ZEBRA_ROUTE_SYSTEM; i <= ZEBRA_ROUTE_MAX; i++) {
 		struct list *ext_list;
@@ -998,6 +1003,8 @@ static void ospf_area_free(struct ospf_area *area)
 {
 	ospf_opaque_type10_lsa_term(area);
 
+	ospf_spf_tree_free(area);
+
 	/* Free LSDBs. */
 	ospf_area_lsdb_discard_delete(area);
 
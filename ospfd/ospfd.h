@@ -248,6 +248,12 @@ struct ospf {
 
 	struct route_table *external_lsas; /* Database of external LSAs,
 					      prefix is LSA's adv. network*/
+	/* Of which with a forwarding address */
+	unsigned long external_fwd_lsas;
+
+	/* Prefixes waiting for a partial route calculation, see ospf_ia.c */
+	struct route_table *prc_prefixes;
+	uint32_t prc_runs; /* Partial route calculation count. */
 
 	/* Time stamps */
 	struct timeval ts_spf;		/* SPF calculation time stamp. */
@@ -265,6 +271,7 @@ struct ospf {
 	struct thread *t_distribute_update; /* Distirbute list update timer. */
 	struct thread *t_spf_calc;	  /* SPF calculation timer. */
 	struct thread *t_ase_calc;	  /* ASE calculation timer. */
+	struct thread *t_prc_calc; /* Partial route calculation timer. */
 	struct thread
 		*t_opaque_lsa_self; /* Type-11 Opaque-LSAs origin event. */
 	struct thread *t_sr_update; /* Segment Routing update timer */
@@ -410,6 +417,12 @@ struct ospf {
 	bool ti_lfa_enabled;
 	enum protection_type ti_lfa_protection_type;
 
+	/* Reuse the shortest-path trees when the topology did not change */
+	bool spf_incremental;
+
+	/* Pthreads calculating the SPF of several areas, see ospf_spf.c */
+	struct workpool *spf_pool;
+
 	/* Flood Reduction configuration state */
 	bool fr_configured;
 
@@ -566,6 +579,17 @@ struct ospf_area {
 	struct vertex *spf;
 	struct list *spf_vertex_list;
 
+	/* Adjacencies pre-parsed from the LSDB, only during an SPF run */
+	struct ospf_spf_index *spf_index;
+
+	/*
+	 * Shortest Path Tree of the last full SPF run, kept for incremental
+	 * SPF until a change to the area's topology, see ospf_spf.c.
+	 */
+	struct vertex *spf_kept;
+	struct list *spf_kept_vertex_list;
+	bool spf_topology_changed;
+
 	bool spf_dry_run;   /* flag for checking if the SPF calculation is
 			       intended for the local RIB */
 	bool spf_root_node; /* flag for checking if the calculating node is the
@@ -583,6 +607,8 @@ struct ospf_area {
 
 	/* Statistics field. */
 	uint32_t spf_calculation; /* SPF Calculation Count. */
+	uint32_t spf_full_runs;	       /* Full SPF runs. */
+	uint32_t spf_incremental_runs; /* SPF runs reusing the kept tree. */
 
 	/* reverse SPF (used for TI-LFA Q spaces) */
 	bool spf_reversed;
@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * BGP best path selection, serial vs. parallel
+ *
+ * Builds two identical RIBs from the same seed, runs best path selection
+ * serially (bgp_best_selection) on one and with the selection worker
+ * pthreads (bgp_best_selection_multi) on the other, then checks that the
+ * results, path flags and multipath state are the same.  Several rounds
+ * with identical random changes in between exercise the old best path,
+ * deterministic-med and removed path handling.
+ */
+
+#include <zebra.h>
+
+#include "qobj.h"
+#include "vty.h"
+#include "prng.h"
+#include "privs.h"
+#include "linklist.h"
+#include "memory.h"
+#include "zclient.h"
+#include "frr_pthread.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_mpath.h"
+#include "bgpd/bgp_network.h"
+#include "bgpd/bgp_select.h"
+
+/* need these to link in libbgp */
+struct thread_master *master = NULL;
+extern struct zclient *zclient;
+struct zebra_privs_t bgpd_privs = {
+	.user = NULL,
+	.group = NULL,
+	.vty_group = NULL,
+};
+
+#define NDESTS 2048
+#define NPEERS 24
+#define MAXPATHS_PER_DEST 12
+#define ROUNDS 8
+#define WORKERS 4
+
+static const char *const aspaths[] = {
+	"100",		 "100 200",	  "100 300",	 "200",
+	"200 100",	 "200 300 400", "300 400",	 "300",
+	"400 500 600", "(65001) 100", "(65001) 200", "(65002) 100 200",
+};
+
+struct test_rib {
+	struct bgp *bgp;
+	struct peer peers[NPEERS];
+	struct bgp_dest *dests[NDESTS];
+};
+
+static struct bgp *bgp_create_fake(as_t as)
+{
+	struct bgp *bgp;
+	afi_t afi;
+	safi_t safi;
+
+	bgp = XCALLOC(MTYPE_BGP, sizeof(struct bgp));
+	bgp_lock(bgp);
+
+	bgp->peer = list_new();
+	bgp->group = list_new();
+
+	FOREACH_AFI_SAFI (afi, safi) {
+		bgp->rib[afi][safi] = bgp_table_init(bgp, afi, safi);
+		bgp->maxpaths[afi][safi].maxpaths_ebgp = 1;
+		bgp->maxpaths[afi][safi].maxpaths_ibgp = 1;
+	}
+
+	bgp->default_local_pref = BGP_DEFAULT_LOCAL_PREF;
+	bgp->as = as;
+	bgp->confed_id = 65000;
+	bgp->name_pretty = XSTRDUP(MTYPE_BGP, "VRF default");
+
+	return bgp;
+}
+
+static void peers_init(struct test_rib *rib)
+{
+	char addr[32];
+	int i;
+
+	for (i = 0; i < NPEERS; i++) {
+		struct peer *peer = &rib->peers[i];
+
+		snprintf(addr, sizeof(addr), "10.0.%d.%d", i / 8, i + 1);
+
+		peer->bgp = rib->bgp;
+		peer->host = XSTRDUP(MTYPE_BGP_PEER_HOST, addr);
+		peer->su_remote = sockunion_str2su(addr);
+		peer->remote_id.s_addr = htonl(0x0a000000 + (i % 7) * 3 + 1);
+		peer->status = Established;
+		/* paths hold references; never let this go to zero */
+		peer->lock = 1 << 24;
+
+		switch (i % 4) {
+		case 0:
+			peer->sort = BGP_PEER_IBGP;
+			peer->as = rib->bgp->as;
+			break;
+		case 1:
+			peer->sort = BGP_PEER_CONFED;
+			peer->as = 65001 + (i % 2);
+			break;
+		default:
+			peer->sort = BGP_PEER_EBGP;
+			peer->as = 100 * (1 + i % 4);
+			break;
+		}
+	}
+}
+
+static struct attr *random_attr(struct prng *prng, struct test_rib *rib)
+{
+	struct attr attr = {};
+
+	bgp_attr_default_set(&attr, rib->bgp, prng_rand(prng) % 3);
+	attr.aspath = aspath_str2aspath(
+		aspaths[prng_rand(prng) % array_size(aspaths)],
+		ASNOTATION_PLAIN);
+
+	/* small value ranges, so that ties go deep into the decision */
+	if (prng_rand(prng) % 4) {
+		attr.local_pref = 100 + 50 * (prng_rand(prng) % 2);
+		attr.flag |= ATTR_FLAG_BIT(BGP_ATTR_LOCAL_PREF);
+	}
+	if (prng_rand(prng) % 2) {
+		attr.med = 10 * (prng_rand(prng) % 3);
+		attr.flag |= ATTR_FLAG_BIT(BGP_ATTR_MULTI_EXIT_DISC);
+	}
+	if (!(prng_rand(prng) % 8))
+		attr.weight = 100;
+
+	attr.nexthop.s_addr = htonl(0xc0a80000 + prng_rand(prng) % 16);
+	attr.flag |= ATTR_FLAG_BIT(BGP_ATTR_NEXT_HOP);
+
+	return bgp_attr_intern(&attr);
+}
+
+static void add_path(struct prng *prng, struct test_rib *rib,
+		     struct bgp_dest *dest)
+{
+	struct bgp_path_info *pi;
+	struct peer *peer = &rib->peers[prng_rand(prng) % NPEERS];
+
+	pi = info_make(ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL, 0, peer,
+		       random_attr(prng, rib), dest);
+	/* deterministic age, for "prefer the oldest route" */
+	pi->uptime = 1000 + prng_rand(prng) % 8;
+	SET_FLAG(pi->flags, BGP_PATH_VALID);
+
+	bgp_path_info_add(dest, pi);
+}
+
+static void rib_init(struct test_rib *rib, unsigned int seed)
+{
+	struct prng *prng = prng_new(seed);
+	struct prefix p;
+	int i, j, n;
+
+	memset(rib, 0, sizeof(*rib));
+	rib->bgp = bgp_create_fake(65000);
+	peers_init(rib);
+
+	for (i = 0; i < NDESTS; i++) {
+		p.family = AF_INET;
+		p.prefixlen = 24;
+		p.u.prefix4.s_addr = htonl(0x14000000 + (i << 8));
+
+		rib->dests[i] =
+			bgp_node_get(rib->bgp->rib[AFI_IP][SAFI_UNICAST], &p);
+
+		n = 1 + prng_rand(prng) % MAXPATHS_PER_DEST;
+		for (j = 0; j < n; j++)
+			add_path(prng, rib, rib->dests[i]);
+	}
+
+	prng_free(prng);
+}
+
+static void rib_fini(struct test_rib *rib)
+{
+	struct bgp_table *table = rib->bgp->rib[AFI_IP][SAFI_UNICAST];
+	struct bgp_path_info *pi, *next;
+	struct bgp_dest *dest;
+	int i;
+
+	for (i = 0; i < NDESTS; i++) {
+		dest = rib->dests[i];
+		for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = next) {
+			next = pi->next;
+			bgp_path_info_reap(dest, pi);
+		}
+		bgp_dest_unlock_node(dest);
+	}
+
+	for (i = 0; i < NPEERS; i++) {
+		XFREE(MTYPE_BGP_PEER_HOST, rib->peers[i].host);
+		sockunion_free(rib->peers[i].su_remote);
+	}
+
+	bgp_table_unlock(table);
+	bgp_path_slabs_free(rib->bgp);
+}
+
+/* What bgp_process_main_one() does with the result, as far as it matters
+ * for the next selection.
+ */
+static void apply_result(struct bgp_dest *dest,
+			 struct bgp_path_info_pair *result)
+{
+	if (result->old == result->new)
+		return;
+	if (result->old)
+		bgp_path_info_unset_flag(dest, result->old, BGP_PATH_SELECTED);
+	if (result->new)
+		bgp_path_info_set_flag(dest, result->new, BGP_PATH_SELECTED);
+}
+
+/* Identical random changes to both RIBs between rounds */
+static void rib_churn(struct prng *prng, struct test_rib *rib)
+{
+	struct bgp_path_info *pi;
+	struct bgp_dest *dest;
+	struct attr *attr;
+	int i, n;
+
+	for (i = 0; i < NDESTS; i++) {
+		dest = rib->dests[i];
+
+		for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next) {
+			switch (prng_rand(prng) % 16) {
+			case 0:
+				if (!CHECK_FLAG(pi->flags, BGP_PATH_REMOVED))
+					bgp_path_info_delete(dest, pi);
+				break;
+			case 1:
+				attr = random_attr(prng, rib);
+				bgp_attr_unintern(&pi->attr);
+				pi->attr = attr;
+				break;
+			default:
+				break;
+			}
+		}
+
+		n = prng_rand(prng) % 4;
+		if (n == 0)
+			add_path(prng, rib, dest);
+	}
+}
+
+static int path_index(struct bgp_dest *dest, struct bgp_path_info *target)
+{
+	struct bgp_path_info *pi;
+	int i = 0;
+
+	if (!target)
+		return -1;
+
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next, i++)
+		if (pi == target)
+			return i;
+
+	return -2;
+}
+
+static bool compare_dest(struct bgp_dest *da, struct bgp_path_info_pair *ra,
+			 struct bgp_dest *db, struct bgp_path_info_pair *rb)
+{
+	struct bgp_path_info *pa, *pb;
+
+	if (da->reason != db->reason)
+		return false;
+	if (path_index(da, ra->new) != path_index(db, rb->new))
+		return false;
+	if (path_index(da, ra->old) != path_index(db, rb->old))
+		return false;
+
+	for (pa = bgp_dest_get_bgp_path_info(da),
+	    pb = bgp_dest_get_bgp_path_info(db);
+	     pa && pb; pa = pa->next, pb = pb->next) {
+		if (pa->flags != pb->flags)
+			return false;
+		if (bgp_path_info_mpath_count(pa)
+		    != bgp_path_info_mpath_count(pb))
+			return false;
+	}
+
+	return pa == NULL && pb == NULL;
+}
+
+static bool run_one(const char *desc, bool dmed, uint16_t maxpaths)
+{
+	static struct test_rib rib_a, rib_b;
+	static struct bgp_path_info_pair res_a[NDESTS], res_b[NDESTS];
+	struct prng *churn_a, *churn_b;
+	unsigned long mismatch = 0, changed = 0;
+	int round, i;
+
+	rib_init(&rib_a, 1);
+	rib_init(&rib_b, 1);
+	churn_a = prng_new(2);
+	churn_b = prng_new(2);
+
+	for (i = 0; i < 2; i++) {
+		struct bgp *bgp = i ? rib_b.bgp : rib_a.bgp;
+
+		if (dmed)
+			SET_FLAG(bgp->flags, BGP_FLAG_DETERMINISTIC_MED);
+		bgp->maxpaths[AFI_IP][SAFI_UNICAST].maxpaths_ebgp = maxpaths;
+		bgp->maxpaths[AFI_IP][SAFI_UNICAST].maxpaths_ibgp = maxpaths;
+	}
+
+	for (round = 0; round < ROUNDS; round++) {
+		bgp_select_set_workers(1);
+		for (i = 0; i < NDESTS; i++)
+			bgp_best_selection(rib_a.bgp, rib_a.dests[i],
+					   &rib_a.bgp->maxpaths[AFI_IP]
+							       [SAFI_UNICAST],
+					   &res_a[i], AFI_IP, SAFI_UNICAST);
+
+		bgp_select_set_workers(WORKERS);
+		bgp_best_selection_multi(rib_b.bgp, rib_b.dests, NDESTS,
+					 res_b);
+
+		for (i = 0; i < NDESTS; i++) {
+			if (!compare_dest(rib_a.dests[i], &res_a[i],
+					  rib_b.dests[i], &res_b[i]))
+				mismatch++;
+			if (res_a[i].old != res_a[i].new)
+				changed++;
+
+			apply_result(rib_a.dests[i], &res_a[i]);
+			apply_result(rib_b.dests[i], &res_b[i]);
+		}
+
+		rib_churn(churn_a, &rib_a);
+		rib_churn(churn_b, &rib_b);
+	}
+
+	prng_free(churn_a);
+	prng_free(churn_b);
+	rib_fini(&rib_a);
+	rib_fini(&rib_b);
+
+	/* make sure the test actually exercised something */
+	if (changed < NDESTS)
+		mismatch++;
+
+	printf("%s: %s (%lu best path changes, %lu mismatches)\n", desc,
+	       mismatch ? "failed" : "OK", changed, mismatch);
+	return mismatch == 0;
+}
+
+int main(void)
+{
+	int fail = 0;
+
+	qobj_init();
+	master = thread_master_create(NULL);
+	zclient = zclient_new(master, &zclient_options_default, NULL, 0);
+	bgp_master_init(master, BGP_SOCKET_SNDBUF_SIZE, list_new());
+	vrf_init(NULL, NULL, NULL, NULL);
+	bgp_option_set(BGP_OPT_NO_LISTEN);
+	bgp_attr_init();
+	frr_pthread_init();
+
+	fail += !run_one("default", false, 1);
+	fail += !run_one("deterministic-med", true, 1);
+	fail += !run_one("multipath", false, 4);
+	fail += !run_one("deterministic-med multipath", true, 4);
+
+	bgp_select_finish();
+	frr_pthread_finish();
+	zclient_free(zclient);
+	thread_master_free(master);
+
+	return fail;
+}
@@ -0,0 +1,11 @@
+import frrtest
+
+
+class TestBestpath(frrtest.TestMultiOut):
+    program = "./test_bestpath"
+
+
+TestBestpath.okfail("default")
+TestBestpath.okfail("deterministic-med")
+TestBestpath.okfail("multipath")
+TestBestpath.okfail("deterministic-med multipath")
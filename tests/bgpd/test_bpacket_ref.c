@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Shared subgroup packets in peer output queues
+ *
+ * Queues one UPDATE on a subgroup packet queue and hands it to several
+ * peers through bpacket_reformat_for_peer().  Checks that every peer's
+ * reference writes out the packet with its own nexthop, also when written
+ * in small pieces, and that the packet outlives the subgroup queue until the
+ * last reference is gone.
+ */
+
+#include <zebra.h>
+#include <sys/uio.h>
+
+#include "vty.h"
+#include "privs.h"
+#include "linklist.h"
+#include "memory.h"
+#include "stream.h"
+#include "zclient.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_packet.h"
+#include "bgpd/bgp_updgrp.h"
+
+/* need these to link in libbgp */
+struct thread_master *master = NULL;
+extern struct zclient *zclient;
+struct zebra_privs_t bgpd_privs = {
+	.user = NULL,
+	.group = NULL,
+	.vty_group = NULL,
+};
+
+#define NPEERS 4
+#define PKT_SIZE 200
+/* where the nexthop length goes; the nexthop follows */
+#define NH_OFFSET 60
+
+static struct peer peers[NPEERS];
+static struct peer_af pafs[NPEERS];
+
+static struct stream *make_packet(void)
+{
+	struct stream *s;
+	unsigned int i;
+
+	s = stream_new(BGP_STANDARD_MESSAGE_MAX_PACKET_SIZE);
+	bgp_packet_set_marker(s, BGP_MSG_UPDATE);
+	for (i = stream_get_endp(s); i < PKT_SIZE; i++)
+		stream_putc(s, i);
+
+	/* unspecified IPv4 nexthop, to be filled in per peer */
+	stream_putc_at(s, NH_OFFSET, BGP_ATTR_NHLEN_IPV4);
+	stream_putl_at(s, NH_OFFSET + 1, 0);
+
+	bgp_packet_set_size(s);
+	return s;
+}
+
+/* Writes out what's left of ref, 'chunk' bytes at a time. */
+static size_t gather(struct stream *ref, uint8_t *buf, size_t chunk)
+{
+	struct iovec iov[3];
+	unsigned int n, i;
+	size_t len = 0, take;
+
+	while (bpacket_ref_remain(ref)) {
+		take = chunk;
+		n = bpacket_ref_iov(ref, iov);
+		assert(n >= 1 && n <= array_size(iov));
+
+		for (i = 0; i < n && take; i++) {
+			size_t part = MIN(take, iov[i].iov_len);
+
+			memcpy(buf + len, iov[i].iov_base, part);
+			len += part;
+			take -= part;
+		}
+		bpacket_ref_forward(ref, chunk - take);
+	}
+	return len;
+}
+
+static int check_peer(struct stream *ref, struct stream *orig, int i,
+		      size_t chunk)
+{
+	uint8_t buf[PKT_SIZE], want[PKT_SIZE];
+	size_t len;
+
+	memcpy(want, STREAM_DATA(orig), PKT_SIZE);
+	memcpy(want + NH_OFFSET + 1, &peers[i].nexthop.v4, IPV4_MAX_BYTELEN);
+
+	len = gather(ref, buf, chunk);
+	if (len != PKT_SIZE || memcmp(buf, want, PKT_SIZE)) {
+		printf("peer %d, chunk %zu: packet differs\n", i, chunk);
+		return 1;
+	}
+	return 0;
+}
+
+int main(void)
+{
+	struct bpacket_attr_vec_arr vecarr;
+	struct bpacket_queue q = {};
+	struct stream *orig, *refs[NPEERS], *plain;
+	struct bpacket *pkt;
+	uint8_t buf[PKT_SIZE];
+	int i, fail = 0;
+
+	for (i = 0; i < NPEERS; i++) {
+		peers[i].host = XSTRDUP(MTYPE_BGP_PEER_HOST, "test");
+		peers[i].sort = BGP_PEER_IBGP;
+		peers[i].nexthop.v4.s_addr = htonl(0xc0000201 + i);
+		pafs[i].peer = &peers[i];
+		pafs[i].afi = AFI_IP;
+		pafs[i].safi = SAFI_UNICAST;
+	}
+
+	orig = make_packet();
+
+	bpacket_attr_vec_arr_reset(&vecarr);
+	vecarr.entries[BGP_ATTR_VEC_NH].flags = BPKT_ATTRVEC_FLAGS_UPDATED;
+	vecarr.entries[BGP_ATTR_VEC_NH].offset = NH_OFFSET;
+
+	/* the subgroup queue always ends in an empty packet */
+	bpacket_queue_init(&q);
+	bpacket_queue_add(&q, NULL, NULL);
+	pkt = bpacket_queue_add(&q, stream_dup(orig), &vecarr);
+
+	for (i = 0; i < NPEERS; i++) {
+		refs[i] = bpacket_reformat_for_peer(pkt, &pafs[i]);
+		assert(bpacket_ref_is(refs[i]));
+		assert(bpacket_ref_type(refs[i]) == BGP_MSG_UPDATE);
+	}
+
+	/* a packet without nexthop to fill in is shared as is */
+	bpacket_attr_vec_arr_reset(&vecarr);
+	pkt = bpacket_queue_add(&q, stream_dup(orig), &vecarr);
+	plain = bpacket_reformat_for_peer(pkt, &pafs[0]);
+
+	/* regular messages aren't mistaken for references */
+	assert(!bpacket_ref_is(orig));
+
+	/* the references keep the packets after the subgroup lets go */
+	bpacket_queue_cleanup(&q);
+
+	/* all at once, and in pieces that end inside and around the patch */
+	fail += check_peer(refs[0], orig, 0, PKT_SIZE);
+	fail += check_peer(refs[1], orig, 1, 1);
+	fail += check_peer(refs[2], orig, 2, 7);
+	fail += check_peer(refs[3], orig, 3, NH_OFFSET + 3);
+
+	if (gather(plain, buf, 13) != PKT_SIZE
+	    || memcmp(buf, STREAM_DATA(orig), PKT_SIZE)) {
+		printf("unpatched packet differs\n");
+		fail++;
+	}
+
+	for (i = 0; i < NPEERS; i++)
+		bgp_obuf_free(refs[i]);
+	bgp_obuf_free(plain);
+	stream_free(orig);
+
+	for (i = 0; i < NPEERS; i++)
+		XFREE(MTYPE_BGP_PEER_HOST, peers[i].host);
+
+	if (!fail)
+		printf("Shared packet test successful.\n");
+	return fail;
+}
@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestBpacketRef(frrtest.TestMultiOut):
+    program = "./test_bpacket_ref"
+
+
+TestBpacketRef.onesimple("Shared packet test successful.")
@@ -0,0 +1,248 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * BGP UPDATE parse workers
+ *
+ * Queues random UPDATEs (plus some KEEPALIVEs and malformed AS paths) on a
+ * peer and takes them off the way bgp_process_packet() does.  Every AS path
+ * that was parsed ahead by the workers has to be the very same interned
+ * path aspath_parse() returns for it, and nothing may be left interned once
+ * the packets are gone, also when they are flushed unprocessed.
+ */
+
+#include <zebra.h>
+
+#include "qobj.h"
+#include "vty.h"
+#include "prng.h"
+#include "privs.h"
+#include "linklist.h"
+#include "memory.h"
+#include "stream.h"
+#include "frr_pthread.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_network.h"
+#include "bgpd/bgp_packet.h"
+#include "bgpd/bgp_update_parse.h"
+
+/* need these to link in libbgp */
+struct thread_master *master = NULL;
+struct zebra_privs_t bgpd_privs = {
+	.user = NULL,
+	.group = NULL,
+	.vty_group = NULL,
+};
+
+#define ROUNDS 16
+#define MAXQUEUE 600
+#define WORKERS 4
+
+static struct peer peer;
+static struct prng *prng;
+
+static void put_aspath(struct stream *s, uint8_t type, bool malformed)
+{
+	unsigned int i, asns = 1 + prng_rand(prng) % 8;
+	size_t lenp;
+
+	stream_putc(s, BGP_ATTR_FLAG_TRANS
+			       | (type == BGP_ATTR_AS4_PATH
+					  ? BGP_ATTR_FLAG_OPTIONAL
+					  : 0)
+			       | BGP_ATTR_FLAG_EXTLEN);
+	stream_putc(s, type);
+	lenp = stream_get_endp(s);
+	stream_putw(s, 0);
+
+	stream_putc(s, AS_SEQUENCE);
+	stream_putc(s, asns);
+	/* few different ASNs, so that the workers often share paths */
+	for (i = 0; i < asns; i++)
+		stream_putl(s, 64512 + prng_rand(prng) % 4);
+	if (malformed)
+		stream_putc(s, 0);
+
+	stream_putw_at(s, lenp, stream_get_endp(s) - lenp - 2);
+}
+
+static void queue_packet(void)
+{
+	struct stream *s = stream_new(BGP_MAX_PACKET_SIZE);
+	size_t lenp;
+	int kind = prng_rand(prng) % 16;
+
+	if (kind == 0) {
+		bgp_packet_set_marker(s, BGP_MSG_KEEPALIVE);
+		bgp_packet_set_size(s);
+		stream_fifo_push(peer.ibuf, s);
+		return;
+	}
+
+	bgp_packet_set_marker(s, BGP_MSG_UPDATE);
+	stream_putw(s, 0);
+	lenp = stream_get_endp(s);
+	stream_putw(s, 0);
+
+	stream_putc(s, BGP_ATTR_FLAG_TRANS);
+	stream_putc(s, BGP_ATTR_ORIGIN);
+	stream_putc(s, 1);
+	stream_putc(s, BGP_ORIGIN_IGP);
+	put_aspath(s, BGP_ATTR_AS_PATH, kind == 1);
+	if (kind < 4)
+		put_aspath(s, BGP_ATTR_AS4_PATH, false);
+
+	stream_putw_at(s, lenp, stream_get_endp(s) - lenp - 2);
+
+	stream_putc(s, 24);
+	stream_putc(s, 10);
+	stream_putw(s, prng_rand(prng));
+	bgp_packet_set_size(s);
+
+	stream_fifo_push(peer.ibuf, s);
+}
+
+/* Compares each AS path attribute against a plain aspath_parse() */
+static void check_update(unsigned long *ahead, unsigned long *mismatch)
+{
+	struct stream *s = peer.curr;
+	struct aspath *parsed, *aspath;
+	size_t attr_end, length;
+	uint8_t type;
+
+	stream_set_getp(s, BGP_HEADER_SIZE);
+	stream_forward_getp(s, stream_getw(s));
+	attr_end = stream_getw(s);
+	attr_end += stream_get_getp(s);
+
+	while (stream_get_getp(s) < attr_end) {
+		stream_getc(s);
+		type = stream_getc(s);
+		length = type == BGP_ATTR_ORIGIN ? stream_getc(s)
+						 : stream_getw(s);
+
+		if (type == BGP_ATTR_ORIGIN) {
+			stream_forward_getp(s, length);
+			continue;
+		}
+
+		parsed = bgp_update_parsed_aspath(&peer, type, length, 1,
+						  ASNOTATION_PLAIN);
+		if (parsed) {
+			(*ahead)++;
+			stream_set_getp(s, stream_get_getp(s) - length);
+		}
+
+		aspath = aspath_parse(s, length, 1, ASNOTATION_PLAIN);
+		if (parsed && parsed != aspath)
+			(*mismatch)++;
+		/* all well-formed paths of a parsed packet have to be there */
+		if (!parsed && aspath && peer.curr_parsed)
+			(*mismatch)++;
+		/* malformed ones have their trailing byte left over */
+		if (!aspath)
+			stream_set_getp(s, attr_end);
+
+		aspath_unintern(&parsed);
+		aspath_unintern(&aspath);
+	}
+}
+
+static void process_queue(unsigned long *ahead, unsigned long *mismatch)
+{
+	while (true) {
+		bgp_update_parse_queued(&peer);
+
+		peer.curr = stream_fifo_pop(peer.ibuf);
+		if (!peer.curr)
+			break;
+
+		bgp_update_parse_start(&peer);
+		if (stream_getc_from(peer.curr, BGP_MARKER_SIZE + 2)
+		    == BGP_MSG_UPDATE)
+			check_update(ahead, mismatch);
+		bgp_update_parse_end(&peer);
+
+		stream_free(peer.curr);
+		peer.curr = NULL;
+	}
+}
+
+static bool run_one(const char *desc, unsigned int workers, bool flush)
+{
+	unsigned long ahead = 0, mismatch = 0, leftover;
+	unsigned int round, i, count;
+
+	prng = prng_new(0);
+	bgp_update_parse_set_workers(workers);
+
+	for (round = 0; round < ROUNDS; round++) {
+		count = prng_rand(prng) % MAXQUEUE;
+		for (i = 0; i < count; i++)
+			queue_packet();
+
+		if (flush) {
+			/* drop a parsed batch halfway through */
+			bgp_update_parse_queued(&peer);
+			for (i = 0; i < count / 2; i++) {
+				peer.curr = stream_fifo_pop(peer.ibuf);
+				bgp_update_parse_start(&peer);
+				bgp_update_parse_end(&peer);
+				stream_free(peer.curr);
+				peer.curr = NULL;
+			}
+			bgp_update_parse_flush(&peer);
+			stream_fifo_clean(peer.ibuf);
+			continue;
+		}
+
+		process_queue(&ahead, &mismatch);
+	}
+
+	prng_free(prng);
+
+	/* make sure the workers actually did something */
+	if (workers > 1 && !flush && !ahead)
+		mismatch++;
+	if (workers == 1 && ahead)
+		mismatch++;
+
+	leftover = aspath_count();
+
+	printf("%s: %s (%lu AS paths parsed ahead, %lu mismatches, %lu left interned)\n",
+	       desc, mismatch || leftover ? "failed" : "OK", ahead, mismatch,
+	       leftover);
+	return !mismatch && !leftover;
+}
+
+int main(void)
+{
+	int fail = 0;
+
+	qobj_init();
+	master = thread_master_create(NULL);
+	bgp_master_init(master, BGP_SOCKET_SNDBUF_SIZE, list_new());
+	bgp_option_set(BGP_OPT_NO_LISTEN);
+	bgp_attr_init();
+	frr_pthread_init();
+
+	peer.host = (char *)"test";
+	peer.status = Established;
+	peer.ibuf = stream_fifo_new();
+	pthread_mutex_init(&peer.io_mtx, NULL);
+	SET_FLAG(peer.cap, PEER_CAP_AS4_RCV | PEER_CAP_AS4_ADV);
+
+	fail += !run_one("serial", 1, false);
+	fail += !run_one("workers", WORKERS, false);
+	fail += !run_one("flush", WORKERS, true);
+
+	stream_fifo_free(peer.ibuf);
+	pthread_mutex_destroy(&peer.io_mtx);
+
+	bgp_update_parse_finish();
+	frr_pthread_finish();
+	thread_master_free(master);
+
+	return fail;
+}
@@ -0,0 +1,10 @@
+import frrtest
+
+
+class TestUpdateParse(frrtest.TestMultiOut):
+    program = "./test_update_parse"
+
+
+TestUpdateParse.okfail("serial")
+TestUpdateParse.okfail("workers")
+TestUpdateParse.okfail("flush")
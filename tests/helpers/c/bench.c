@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Helpers shared by the benchmarks under tests/.
+ */
+
+#include <zebra.h>
+
+#ifdef HAVE_MALLINFO2
+#include <malloc.h>
+#endif
+
+#include "bench.h"
+
+void bench_report(const char *phase, uint64_t ops, const struct timeval *start)
+{
+	bench_report_usec(phase, ops, monotime_since(start, NULL));
+}
+
+void bench_report_usec(const char *phase, uint64_t ops, int64_t usec)
+{
+	printf("  %-8s %12.0f ops/s %8.1f ns/op\n", phase,
+	       usec ? ops / (usec / 1e6) : 0.0,
+	       ops ? usec * 1000.0 / ops : 0.0);
+}
+
+size_t bench_heap_used(void)
+{
+#ifdef HAVE_MALLINFO2
+	return mallinfo2().uordblks;
+#else
+	return 0;
+#endif
+}
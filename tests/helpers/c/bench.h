@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Helpers shared by the benchmarks under tests/.
+ */
+
+#ifndef _FRR_TESTS_BENCH_H
+#define _FRR_TESTS_BENCH_H
+
+#include "monotime.h"
+
+/*
+ * Prints ops/s and ns/op for a phase of a benchmark that did 'ops' operations
+ * since 'start' (taken with monotime()).
+ */
+extern void bench_report(const char *phase, uint64_t ops,
+			 const struct timeval *start);
+
+/* Same, for 'ops' operations that took 'usec' microseconds altogether */
+extern void bench_report_usec(const char *phase, uint64_t ops, int64_t usec);
+
+/* Heap bytes in use, 0 where mallinfo2() is not available */
+extern size_t bench_heap_used(void);
+
+#endif /* _FRR_TESTS_BENCH_H */
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures intern/unintern throughput of the
+ * concurrent intern table with 1..N pthreads hammering the same key space.
+ */
+
+#include <zebra.h>
+
+#include <pthread.h>
+
+#include "intern.h"
+#include "frrcu.h"
+#include "jhash.h"
+#include "monotime.h"
+#include "prng.h"
+
+#define NKEYS 4096
+#define NHOLD 64
+#define OPS_PER_THREAD 1000000
+
+struct item {
+	uint32_t key;
+	struct intern_item item;
+};
+
+static unsigned int item_hash(const void *data)
+{
+	const struct item *it = data;
+
+	return jhash_1word(it->key, 0);
+}
+
+static bool item_cmp(const void *a, const void *b)
+{
+	const struct item *ia = a, *ib = b;
+
+	return ia->key == ib->key;
+}
+
+static void *item_alloc(const void *key)
+{
+	const struct item *ik = key;
+	struct item *it = calloc(1, sizeof(*it));
+
+	it->key = ik->key;
+	return it;
+}
+
+static void item_free(void *data)
+{
+	free(data);
+}
+
+static const struct intern_ops item_ops = {
+	.offset = offsetof(struct item, item),
+	.hash_key = item_hash,
+	.hash_cmp = item_cmp,
+	.alloc = item_alloc,
+	.free = item_free,
+};
+
+static struct intern_table table;
+
+struct worker {
+	pthread_t pt;
+	struct rcu_thread *rcu_thr;
+	unsigned int seed;
+	size_t errors;
+};
+
+static void *worker_func(void *arg)
+{
+	struct worker *w = arg;
+	struct item *held[NHOLD] = {};
+	struct item key = {};
+	struct prng *prng;
+	size_t i;
+
+	rcu_thread_start(w->rcu_thr);
+	/* new threads start out RCU-locked, intern_get does its own locking */
+	rcu_read_unlock();
+
+	prng = prng_new(w->seed);
+
+	for (i = 0; i < OPS_PER_THREAD; i++) {
+		struct item *it;
+
+		key.key = prng_rand(prng) % NKEYS;
+		it = intern_get(&table, &key);
+		if (it->key != key.key || intern_refcnt(&table, it) == 0)
+			w->errors++;
+
+		if (held[i % NHOLD])
+			intern_put(&table, held[i % NHOLD]);
+		held[i % NHOLD] = it;
+	}
+
+	for (i = 0; i < NHOLD; i++)
+		if (held[i])
+			intern_put(&table, held[i]);
+
+	prng_free(prng);
+
+	rcu_read_lock();
+	return NULL;
+}
+
+static int run(unsigned int nthreads)
+{
+	struct worker *workers;
+	struct timeval tv_start, tv_stop;
+	unsigned long usec;
+	size_t errors = 0;
+	unsigned int i;
+
+	workers = calloc(nthreads, sizeof(*workers));
+	intern_table_init(&table, "test", &item_ops);
+
+	monotime(&tv_start);
+	for (i = 0; i < nthreads; i++) {
+		workers[i].seed = i + 1;
+		workers[i].rcu_thr = rcu_thread_prepare();
+		pthread_create(&workers[i].pt, NULL, worker_func, &workers[i]);
+	}
+
+	/* don't hold up RCU cleanup while waiting */
+	rcu_read_unlock();
+	for (i = 0; i < nthreads; i++) {
+		pthread_join(workers[i].pt, NULL);
+		errors += workers[i].errors;
+	}
+	rcu_read_lock();
+	monotime(&tv_stop);
+
+	usec = 1000000 * (tv_stop.tv_sec - tv_start.tv_sec);
+	usec += tv_stop.tv_usec - tv_start.tv_usec;
+	if (!usec)
+		usec = 1;
+
+	printf("%8u %12lu %14.1f\n", nthreads, usec / 1000,
+	       2.0 * OPS_PER_THREAD * nthreads / usec);
+
+	if (intern_count(&table) != 0) {
+		printf("%zu items left in table after all references dropped\n",
+		       intern_count(&table));
+		errors++;
+	}
+
+	intern_table_fini(&table);
+	free(workers);
+	return errors ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int maxthreads = 8, n;
+	int ret = 0;
+
+	if (argc > 1)
+		maxthreads = atoi(argv[1]);
+
+	printf("%8s %12s %14s\n", "threads", "msec", "Mops/sec");
+
+	for (n = 1; n <= maxthreads; n *= 2)
+		ret |= run(n);
+	fflush(stdout);
+
+	return ret;
+}
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures event loop wakeup latency depending on the
+ * number of registered file descriptors, for each available I/O backend.
+ */
+
+#include <zebra.h>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "thread.h"
+#include "prng.h"
+
+#define WAKEUPS 20000
+
+static const int fd_counts[] = { 16, 256, 1024, 4096, 16384 };
+
+static const enum thread_io_backend backends[] = {
+	THREAD_IO_POLL,
+	THREAD_IO_EPOLL,
+	THREAD_IO_EPOLL_ET,
+};
+
+struct thread_master *master;
+
+static int *pipes;
+static struct thread **readers;
+static int fired;
+
+static void read_func(struct thread *thread)
+{
+	int idx = (intptr_t)THREAD_ARG(thread);
+	char buf[16];
+
+	if (read(THREAD_FD(thread), buf, sizeof(buf)) < 0)
+		perror("read");
+
+	fired = idx;
+	thread_add_read(master, read_func, THREAD_ARG(thread),
+			pipes[idx * 2], &readers[idx]);
+}
+
+static int run(enum thread_io_backend backend, int nfds,
+	       unsigned long *usec)
+{
+	struct prng *prng;
+	struct thread t;
+	struct timeval tv_start, tv_stop;
+	int i;
+
+	master = thread_master_create(NULL);
+	if (thread_master_set_io_backend(master, backend)) {
+		thread_master_free(master);
+		return -1;
+	}
+
+	pipes = calloc(nfds * 2, sizeof(*pipes));
+	readers = calloc(nfds, sizeof(*readers));
+	for (i = 0; i < nfds; i++) {
+		if (pipe(&pipes[i * 2])) {
+			perror("pipe");
+			exit(1);
+		}
+		thread_add_read(master, read_func, (void *)(intptr_t)i,
+				pipes[i * 2], &readers[i]);
+	}
+
+	prng = prng_new(0);
+	monotime(&tv_start);
+
+	for (i = 0; i < WAKEUPS; i++) {
+		int idx = prng_rand(prng) % nfds;
+
+		fired = -1;
+		if (write(pipes[idx * 2 + 1], "x", 1) != 1) {
+			perror("write");
+			exit(1);
+		}
+
+		while (fired != idx && thread_fetch(master, &t))
+			thread_call(&t);
+	}
+
+	monotime(&tv_stop);
+
+	*usec = 1000000 * (tv_stop.tv_sec - tv_start.tv_sec);
+	*usec += tv_stop.tv_usec - tv_start.tv_usec;
+
+	for (i = 0; i < nfds; i++) {
+		thread_cancel(&readers[i]);
+		close(pipes[i * 2]);
+		close(pipes[i * 2 + 1]);
+	}
+	free(readers);
+	free(pipes);
+	prng_free(prng);
+	thread_master_free(master);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct rlimit limit;
+	size_t i, j;
+
+	/* the thread_master sizes its fd arrays from the soft limit */
+	getrlimit(RLIMIT_NOFILE, &limit);
+	limit.rlim_cur = limit.rlim_max;
+	setrlimit(RLIMIT_NOFILE, &limit);
+
+	printf("%8s %10s %14s\n", "fds", "backend", "usec/wakeup");
+
+	for (i = 0; i < array_size(fd_counts); i++) {
+		if ((rlim_t)fd_counts[i] * 2 + 16 > limit.rlim_cur) {
+			printf("%8d %10s %14s\n", fd_counts[i], "-",
+			       "(fd limit)");
+			continue;
+		}
+
+		for (j = 0; j < array_size(backends); j++) {
+			const char *name = thread_io_backend_name(backends[j]);
+			unsigned long usec;
+
+			if (run(backends[j], fd_counts[i], &usec)) {
+				printf("%8d %10s %14s\n", fd_counts[i], name,
+				       "(unavailable)");
+				continue;
+			}
+
+			printf("%8d %10s %10lu.%03lu\n", fd_counts[i], name,
+			       usec / WAKEUPS, (usec % WAKEUPS) * 1000 / WAKEUPS);
+		}
+	}
+	fflush(stdout);
+
+	return 0;
+}
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Slab allocator tests
+ */
+
+#include <zebra.h>
+
+#include "memory.h"
+#include "slab.h"
+
+#include "tests/helpers/c/prng.h"
+
+DEFINE_MGROUP(TEST_SLAB, "slab test");
+DEFINE_MTYPE_STATIC(TEST_SLAB, TEST_SLAB_PAGE, "slab test page");
+
+#define NOBJS 20000
+
+struct item {
+	uint32_t id;
+	uint32_t pad[25];
+};
+
+static struct item *items[NOBJS];
+
+static void check_item(struct item *item, unsigned int i)
+{
+	unsigned int j;
+
+	assert(item->id == i);
+	for (j = 0; j < array_size(item->pad); j++)
+		assert(item->pad[j] == i + j);
+}
+
+static void fill_item(struct item *item, unsigned int i)
+{
+	unsigned int j;
+
+	for (j = 0; j < array_size(item->pad); j++)
+		assert(item->pad[j] == 0);
+
+	item->id = i;
+	for (j = 0; j < array_size(item->pad); j++)
+		item->pad[j] = i + j;
+}
+
+int main(int argc, char **argv)
+{
+	struct slab_stats stats = {};
+	struct prng *prng;
+	struct slab *slab;
+	unsigned int i, round, n;
+
+	prng = prng_new(0);
+	slab = slab_new(MTYPE_TEST_SLAB_PAGE, "test", sizeof(struct item),
+			&stats);
+
+	/* 1. fill up, every object usable and distinct */
+	for (i = 0; i < NOBJS; i++) {
+		items[i] = slab_alloc(slab);
+		assert(((uintptr_t)items[i] & (sizeof(void *) - 1)) == 0);
+		fill_item(items[i], i);
+	}
+	assert(slab_count(slab) == NOBJS);
+	assert(stats.objects == NOBJS);
+	assert(stats.pages == (NOBJS + slab->per_page - 1) / slab->per_page);
+	assert(mtype_stats_alloc(MTYPE_TEST_SLAB_PAGE) == stats.pages);
+
+	for (i = 0; i < NOBJS; i++)
+		check_item(items[i], i);
+
+	/* 2. random churn; freed objects are reused and zeroed again */
+	for (round = 0; round < 10; round++) {
+		for (n = 0; n < NOBJS / 2; n++) {
+			i = prng_rand(prng) % NOBJS;
+			if (!items[i])
+				continue;
+			check_item(items[i], i);
+			slab_free(items[i]);
+			items[i] = NULL;
+		}
+		for (i = 0; i < NOBJS; i++) {
+			if (items[i] || (prng_rand(prng) & 1))
+				continue;
+			items[i] = slab_alloc(slab);
+			fill_item(items[i], i);
+		}
+
+		n = 0;
+		for (i = 0; i < NOBJS; i++)
+			if (items[i]) {
+				check_item(items[i], i);
+				n++;
+			}
+		assert(slab_count(slab) == n);
+	}
+
+	/* 3. emptying out releases all but one page */
+	for (i = 0; i < NOBJS; i++) {
+		slab_free(items[i]);
+		items[i] = NULL;
+	}
+	assert(stats.objects == 0);
+	assert(stats.pages == 1);
+
+	/* 4. deleting a slab with objects left keeps them valid, and the
+	 * slab goes away along with the last one
+	 */
+	for (i = 0; i < NOBJS; i++) {
+		items[i] = slab_alloc(slab);
+		fill_item(items[i], i);
+	}
+	slab_delete(&slab);
+	assert(slab == NULL);
+
+	for (i = 0; i < NOBJS; i += 2) {
+		check_item(items[i], i);
+		slab_free(items[i]);
+	}
+	for (i = 1; i < NOBJS; i += 2) {
+		check_item(items[i], i);
+		slab_free(items[i]);
+	}
+	assert(stats.objects == 0);
+	assert(stats.pages == 0);
+	assert(mtype_stats_alloc(MTYPE_TEST_SLAB_PAGE) == 0);
+
+	prng_free(prng);
+	printf("Slab test successful.\n");
+	return 0;
+}
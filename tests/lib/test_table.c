@@ -11,6 +11,8 @@
 #include "prefix.h"
 #include "table.h"
 
+#include "tests/helpers/c/prng.h"
+
 /*
  * test_node_t
  *
@@ -477,6 +479,143 @@ static void test_iter_pause(void)
 	route_table_finish(table);
 }
 
+/*
+ * verify_match
+ *
+ * Check that looking up addr finds the expected prefix (or none, for a NULL
+ * expected_str.)
+ */
+static void verify_match(struct route_table *table, const char *addr,
+			 const char *expected_str)
+{
+	struct prefix_ipv4 p;
+	struct route_node *rn;
+	test_node_t *node;
+
+	assert(str2prefix_ipv4(addr, &p) > 0);
+
+	rn = route_node_match(table, (struct prefix *)&p);
+	if (!expected_str) {
+		assert(!rn);
+		return;
+	}
+
+	assert(rn);
+	node = rn->info;
+	assert(!strcmp(node->prefix_str, expected_str));
+	route_unlock_node(rn);
+}
+
+static void del_node(struct route_table *table, const char *prefix_str)
+{
+	struct prefix_ipv4 p;
+	struct route_node *rn;
+	test_node_t *node;
+
+	assert(str2prefix_ipv4(prefix_str, &p) > 0);
+
+	rn = route_node_lookup(table, (struct prefix *)&p);
+	assert(rn);
+	node = rn->info;
+	rn->info = NULL;
+	route_unlock_node(rn);
+	route_unlock_node(rn);
+	free(node->prefix_str);
+	free(node);
+}
+
+/*
+ * test_lpm
+ *
+ * The LPM index must give the same results as walking the tree, while nodes
+ * come and go.
+ */
+static void test_lpm(void)
+{
+	struct route_table *table;
+	struct route_lpm *lpm;
+	struct route_node *rn, *walk_rn;
+	struct prefix_ipv4 p;
+	struct prng *prng;
+	char buf[PREFIX_STRLEN];
+	int i, j;
+
+	printf("\n\nTesting the LPM index\n");
+	table = route_table_init();
+	route_table_lpm_enable(table, AF_INET);
+
+	/* the two /24s get a glue /23 above them, which then becomes a real
+	 * node
+	 */
+	add_nodes(table, "10.0.0.0/24", "10.0.1.0/24", "10.0.0.0/8",
+		  "10.0.0.128/25", "10.255.255.255/32", NULL);
+	verify_match(table, "10.0.0.1/32", "10.0.0.0/24");
+	verify_match(table, "10.0.0.129/32", "10.0.0.128/25");
+	verify_match(table, "10.0.2.1/32", "10.0.0.0/8");
+	verify_match(table, "10.255.255.255/32", "10.255.255.255/32");
+	verify_match(table, "10.255.255.254/32", "10.0.0.0/8");
+	verify_match(table, "11.0.0.1/32", NULL);
+	verify_match(table, "10.0.0.1/23", "10.0.0.0/8");
+
+	add_nodes(table, "10.0.0.0/23", "0.0.0.0/0", NULL);
+	verify_match(table, "10.0.1.1/24", "10.0.1.0/24");
+	verify_match(table, "10.0.1.1/23", "10.0.0.0/23");
+	verify_match(table, "10.0.0.1/22", "10.0.0.0/8");
+	verify_match(table, "11.0.0.1/32", "0.0.0.0/0");
+
+	del_node(table, "10.0.0.0/24");
+	verify_match(table, "10.0.0.1/32", "10.0.0.0/23");
+	verify_match(table, "10.0.0.129/32", "10.0.0.128/25");
+	del_node(table, "10.0.0.0/23");
+	del_node(table, "10.0.0.128/25");
+	verify_match(table, "10.0.0.129/32", "10.0.0.0/8");
+	del_node(table, "0.0.0.0/0");
+	verify_match(table, "11.0.0.1/32", NULL);
+
+	clear_table(table);
+
+	/* random churn, compared against a walk of the tree */
+	prng = prng_new(0);
+	for (i = 0; i < 20000; i++) {
+		memset(&p, 0, sizeof(p));
+		p.family = AF_INET;
+		p.prefix.s_addr = htonl(0x0a000000 | (prng_rand(prng) & 0xffff));
+		p.prefixlen = 8 + prng_rand(prng) % 25;
+		apply_mask_ipv4(&p);
+		prefix2str(&p, buf, sizeof(buf));
+
+		rn = route_node_lookup(table, (struct prefix *)&p);
+		if (rn) {
+			route_unlock_node(rn);
+			del_node(table, buf);
+		} else
+			add_node(table, buf);
+
+		for (j = 0; j < 8; j++) {
+			p.prefix.s_addr =
+				htonl(0x0a000000 | (prng_rand(prng) & 0xffff));
+			p.prefixlen = 16 + prng_rand(prng) % 17;
+
+			rn = route_node_match(table, (struct prefix *)&p);
+			lpm = table->lpm;
+			table->lpm = NULL;
+			walk_rn = route_node_match(table, (struct prefix *)&p);
+			table->lpm = lpm;
+
+			assert(rn == walk_rn);
+			if (rn) {
+				route_unlock_node(rn);
+				route_unlock_node(walk_rn);
+			}
+		}
+	}
+	prng_free(prng);
+
+	clear_table(table);
+	route_table_finish(table);
+	printf("Verified LPM index\n");
+}
+
 /*
  * run_tests
  */
@@ -485,6 +624,7 @@ static void run_tests(void)
 	test_prefix_iter_cmp();
 	test_get_next();
 	test_iter_pause();
+	test_lpm();
 }
 
 /*
@@ -0,0 +1,210 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures route_node_match() throughput on a large
+ * table, with and without the LPM index, and checks that both agree.
+ */
+
+#include <zebra.h>
+
+#include "table.h"
+#include "monotime.h"
+#include "prng.h"
+
+#define NLOOKUPS (1 << 20)
+#define ROUNDS 8
+
+static struct prng *prng;
+
+/* roughly the prefix length mix of an internet table */
+static unsigned int random_plen(int family)
+{
+	unsigned int r = prng_rand(prng) % 100;
+
+	if (family == AF_INET) {
+		if (r < 60)
+			return 24;
+		if (r < 80)
+			return 16 + prng_rand(prng) % 8;
+		if (r < 90)
+			return 8 + prng_rand(prng) % 8;
+		return 25 + prng_rand(prng) % 8;
+	}
+
+	if (r < 50)
+		return 48;
+	if (r < 80)
+		return 32 + prng_rand(prng) % 16;
+	if (r < 90)
+		return 16 + prng_rand(prng) % 16;
+	return 49 + prng_rand(prng) % 80;
+}
+
+static void random_addr(int family, struct prefix *p)
+{
+	unsigned int i;
+
+	memset(p, 0, sizeof(*p));
+	p->family = family;
+	if (family == AF_INET) {
+		p->prefixlen = IPV4_MAX_BITLEN;
+		p->u.prefix4.s_addr =
+			prng_rand(prng) ^ ((uint32_t)prng_rand(prng) << 16);
+		return;
+	}
+
+	p->prefixlen = IPV6_MAX_BITLEN;
+	/* keep it within 2000::/4 like the real thing */
+	for (i = 0; i < 16; i++)
+		p->u.prefix6.s6_addr[i] = prng_rand(prng);
+	p->u.prefix6.s6_addr[0] = 0x20 | (p->u.prefix6.s6_addr[0] & 0x0f);
+}
+
+static unsigned long usec_since(struct timeval *start)
+{
+	struct timeval now;
+	unsigned long usec;
+
+	monotime(&now);
+	usec = 1000000 * (now.tv_sec - start->tv_sec);
+	usec += now.tv_usec - start->tv_usec;
+	return usec ? usec : 1;
+}
+
+static double run_lookups(struct route_table *table, struct prefix *addrs,
+			  struct route_node **results)
+{
+	struct timeval start;
+	struct route_node *rn;
+	unsigned int round, i;
+
+	monotime(&start);
+	for (round = 0; round < ROUNDS; round++)
+		for (i = 0; i < NLOOKUPS; i++) {
+			rn = route_node_match(table, &addrs[i]);
+			if (rn)
+				route_unlock_node(rn);
+			results[i] = rn;
+		}
+
+	return (double)ROUNDS * NLOOKUPS / usec_since(&start);
+}
+
+static int verify(struct route_table *table, struct prefix *addrs,
+		  struct route_node **with, struct route_node **without)
+{
+	struct route_lpm *lpm;
+	unsigned int i;
+	int errors = 0;
+
+	run_lookups(table, addrs, with);
+
+	/* lookups ignore the index if there is none */
+	lpm = table->lpm;
+	table->lpm = NULL;
+	run_lookups(table, addrs, without);
+	table->lpm = lpm;
+
+	for (i = 0; i < NLOOKUPS; i++)
+		if (with[i] != without[i])
+			errors++;
+
+	if (errors)
+		printf("%d lookups differ between index and tree walk\n",
+		       errors);
+	return errors;
+}
+
+static int run(int family, unsigned int nprefixes)
+{
+	struct route_node **nodes, **with, **without, *rn;
+	struct route_table *table;
+	struct prefix *addrs, p;
+	unsigned int i, count = 0;
+	double walk, index;
+	int errors = 0;
+
+	table = route_table_init();
+	nodes = calloc(nprefixes, sizeof(*nodes));
+	addrs = calloc(NLOOKUPS, sizeof(*addrs));
+	with = calloc(NLOOKUPS, sizeof(*with));
+	without = calloc(NLOOKUPS, sizeof(*without));
+
+	for (i = 0; i < nprefixes; i++) {
+		random_addr(family, &p);
+		p.prefixlen = random_plen(family);
+		apply_mask(&p);
+
+		rn = route_node_get(table, &p);
+		if (rn->info) {
+			route_unlock_node(rn);
+			continue;
+		}
+		rn->info = rn;
+		nodes[count++] = rn;
+	}
+
+	/* half the lookups hit a prefix from the table, the rest is random */
+	for (i = 0; i < NLOOKUPS; i++) {
+		random_addr(family, &addrs[i]);
+		if (i & 1) {
+			rn = nodes[prng_rand(prng) % count];
+			prefix_copy(&p, &rn->p);
+			memcpy(&addrs[i].u, &p.u, p.prefixlen / 8);
+		}
+	}
+
+	walk = run_lookups(table, addrs, without);
+	route_table_lpm_enable(table, family);
+	index = run_lookups(table, addrs, with);
+
+	printf("%6s %8u %8lu %14.2f %14.2f\n",
+	       family == AF_INET ? "ipv4" : "ipv6", count, table->count, walk,
+	       index);
+
+	errors += verify(table, addrs, with, without);
+
+	/* withdraw half the table, index has to follow */
+	for (i = 0; i < count; i += 2) {
+		nodes[i]->info = NULL;
+		route_unlock_node(nodes[i]);
+	}
+	errors += verify(table, addrs, with, without);
+
+	for (i = 1; i < count; i += 2) {
+		nodes[i]->info = NULL;
+		route_unlock_node(nodes[i]);
+	}
+	errors += verify(table, addrs, with, without);
+	if (table->count != 0) {
+		printf("%lu nodes left in table\n", table->count);
+		errors++;
+	}
+
+	route_table_finish(table);
+	free(nodes);
+	free(addrs);
+	free(with);
+	free(without);
+	return errors ? 1 : 0;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int nprefixes = 1000000;
+	int ret = 0;
+
+	if (argc > 1)
+		nprefixes = atoi(argv[1]);
+
+	prng = prng_new(0);
+
+	printf("%6s %8s %8s %14s %14s\n", "family", "prefixes", "nodes",
+	       "walk Mlkup/s", "index Mlkup/s");
+
+	ret |= run(AF_INET, nprefixes);
+	ret |= run(AF_INET6, nprefixes);
+	fflush(stdout);
+
+	prng_free(prng);
+	return ret;
+}
@@ -0,0 +1,183 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Bulk ZAPI route message tests
+ *
+ * Collects routes through zclient_route_send_bulk() on a zclient that isn't
+ * connected, so nothing is written and the pending message can be looked at
+ * directly, and decodes it again.
+ */
+
+#include <zebra.h>
+
+#include "thread.h"
+#include "stream.h"
+#include "zclient.h"
+
+static struct thread_master *master;
+static struct zclient *zclient;
+
+static void make_route(struct zapi_route *api, int family, uint32_t i)
+{
+	struct zapi_nexthop *api_nh;
+
+	memset(api, 0, sizeof(*api));
+	api->vrf_id = VRF_DEFAULT;
+	api->type = ZEBRA_ROUTE_BGP;
+	api->safi = SAFI_UNICAST;
+	api->flags = ZEBRA_FLAG_ALLOW_RECURSION;
+
+	api->prefix.family = family;
+	if (family == AF_INET) {
+		api->prefix.prefixlen = 24;
+		api->prefix.u.prefix4.s_addr = htonl(0x0a000000 + (i << 8));
+	} else {
+		api->prefix.prefixlen = 128;
+		api->prefix.u.prefix6.s6_addr[0] = 0x20;
+		api->prefix.u.prefix6.s6_addr[1] = 0x01;
+		api->prefix.u.prefix6.s6_addr32[3] = htonl(i);
+	}
+
+	SET_FLAG(api->message, ZAPI_MESSAGE_NEXTHOP);
+	api->nexthop_num = 2;
+	api_nh = &api->nexthops[0];
+	api_nh->vrf_id = VRF_DEFAULT;
+	api_nh->type = NEXTHOP_TYPE_IPV4;
+	api_nh->gate.ipv4.s_addr = htonl(0xc0000202);
+	api_nh = &api->nexthops[1];
+	api_nh->vrf_id = VRF_DEFAULT;
+	api_nh->type = NEXTHOP_TYPE_IPV4;
+	api_nh->gate.ipv4.s_addr = htonl(0xc0000201);
+
+	SET_FLAG(api->message, ZAPI_MESSAGE_METRIC);
+	api->metric = 100;
+}
+
+/* Decodes the pending bulk message, checks it holds routes first to
+ * first + count - 1, and drops it.
+ */
+static void check_bulk(uint16_t cmd, int family, uint32_t first,
+		       uint32_t count)
+{
+	struct stream *s = zclient->bulk;
+	struct zapi_route api, want;
+	uint32_t n, i;
+	uint16_t len, command;
+
+	assert(zclient->bulk_count == count);
+
+	/* what zclient_route_bulk_flush() fills in */
+	stream_putl_at(s, ZEBRA_HEADER_SIZE, zclient->bulk_count);
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	stream_set_getp(s, 0);
+	len = stream_getw(s);
+	assert(len == stream_get_endp(s));
+	assert(len <= ZEBRA_MAX_PACKET_SIZ);
+	stream_forward_getp(s, ZAPI_HEADER_CMD_LOCATION - 2);
+	command = stream_getw(s);
+	assert(command == cmd);
+
+	assert(zapi_route_bulk_decode(s, &api, &n) == 0);
+	assert(n == count);
+	assert(api.prefix.family == family);
+	assert(api.type == ZEBRA_ROUTE_BGP);
+	assert(api.metric == 100);
+	assert(api.nexthop_num == 2);
+
+	/* nexthops are sorted on the way */
+	assert(api.nexthops[0].gate.ipv4.s_addr == htonl(0xc0000201));
+	assert(api.nexthops[1].gate.ipv4.s_addr == htonl(0xc0000202));
+
+	for (i = 0; i < count; i++) {
+		make_route(&want, family, first + i);
+		assert(zapi_route_bulk_decode_prefix(s, &api) == 0);
+		assert(prefix_same(&api.prefix, &want.prefix));
+	}
+	assert(!STREAM_READABLE(s));
+
+	/* not connected, so this just drops the message */
+	zclient_route_bulk_flush(zclient);
+	assert(zclient->bulk_count == 0);
+}
+
+int main(int argc, char **argv)
+{
+	struct zapi_route api;
+	uint32_t i, sent;
+
+	master = thread_master_create(NULL);
+	zclient = zclient_new(master, &zclient_options_default, NULL, 0);
+	zclient->sock = -1;
+
+	/* 1. routes sharing everything but the prefix go into one message */
+	for (i = 0; i < 100; i++) {
+		make_route(&api, AF_INET, i);
+		assert(zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api)
+		       == ZCLIENT_SEND_BUFFERED);
+	}
+	check_bulk(ZEBRA_ROUTE_ADD_BULK, AF_INET, 0, 100);
+
+	/* 2. a different attribute, family or command starts a new one */
+	for (i = 0; i < 10; i++) {
+		make_route(&api, AF_INET, i);
+		zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+	}
+	make_route(&api, AF_INET, 10);
+	api.metric = 200;
+	zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+	assert(zclient->bulk_count == 1);
+	zclient_route_bulk_flush(zclient);
+
+	for (i = 0; i < 10; i++) {
+		make_route(&api, AF_INET, i);
+		zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+	}
+	make_route(&api, AF_INET6, 0);
+	zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+	check_bulk(ZEBRA_ROUTE_ADD_BULK, AF_INET6, 0, 1);
+
+	for (i = 0; i < 10; i++) {
+		make_route(&api, AF_INET, i);
+		zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+	}
+	for (i = 0; i < 5; i++) {
+		make_route(&api, AF_INET, i);
+		zclient_route_send_bulk(ZEBRA_ROUTE_DELETE, zclient, &api);
+	}
+	check_bulk(ZEBRA_ROUTE_DELETE_BULK, AF_INET, 0, 5);
+
+	/* 3. routes that can't be sent in bulk go out on their own, after
+	 * the ones collected so far
+	 */
+	for (i = 0; i < 10; i++) {
+		make_route(&api, AF_INET6, i);
+		zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+	}
+	make_route(&api, AF_INET6, 10);
+	SET_FLAG(api.message, ZAPI_MESSAGE_SRCPFX);
+	api.src_prefix.family = AF_INET6;
+	api.src_prefix.prefixlen = 64;
+	zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+	assert(zclient->bulk_count == 0);
+
+	/* 4. a full message is sent and a new one started */
+	sent = 0;
+	for (i = 0; i < 10000; i++) {
+		make_route(&api, AF_INET6, i);
+		zclient_route_send_bulk(ZEBRA_ROUTE_ADD, zclient, &api);
+		if (zclient->bulk_count == 1 && i) {
+			/* the previous one was full */
+			sent = i;
+			break;
+		}
+	}
+	assert(sent > 100);
+	check_bulk(ZEBRA_ROUTE_ADD_BULK, AF_INET6, sent, 1);
+
+	zclient_stop(zclient);
+	zclient_free(zclient);
+	thread_master_free(master);
+
+	printf("ZAPI bulk route test successful.\n");
+	return 0;
+}
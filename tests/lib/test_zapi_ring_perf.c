@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Test program which measures how fast ZAPI route messages get from one
+ * thread to another, over a unix stream socket the way zserv_read() reads
+ * them and through a shared memory ring with a doorbell the way
+ * zserv_ring_read() does, and checks that both deliver the same bytes.
+ *
+ * The routes look like the ones "sharp install routes" sends.  For the real
+ * thing, run sharpd with and without --zapi-ring and compare the
+ * "Installed All Items" times it logs.
+ */
+
+#include <zebra.h>
+
+#include <pthread.h>
+#include <sched.h>
+
+#include "monotime.h"
+#include "network.h"
+#include "stream.h"
+#include "zclient.h"
+#include "shmring.h"
+
+#define RING_SIZE (1U << 22)
+
+struct run {
+	unsigned int nroutes;
+	int sock[2];
+	int bell[2];
+	struct shmring *ring;
+
+	/* what the reader got */
+	unsigned int nmsgs;
+	uint64_t nbytes;
+	uint32_t sum;
+};
+
+static uint32_t checksum(uint32_t sum, const uint8_t *data, size_t len)
+{
+	size_t i;
+
+	for (i = 0; i < len; i++)
+		sum = sum * 31 + data[i];
+	return sum;
+}
+
+static void encode_route(struct stream *s, unsigned int i)
+{
+	struct zapi_route api = {};
+	struct zapi_nexthop *api_nh;
+
+	api.vrf_id = VRF_DEFAULT;
+	api.type = ZEBRA_ROUTE_SHARP;
+	api.safi = SAFI_UNICAST;
+	api.prefix.family = AF_INET;
+	api.prefix.prefixlen = 32;
+	api.prefix.u.prefix4.s_addr = htonl(0x0a000000 + i);
+
+	SET_FLAG(api.flags, ZEBRA_FLAG_ALLOW_RECURSION);
+	SET_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP);
+	api.nexthop_num = 1;
+	api_nh = &api.nexthops[0];
+	api_nh->vrf_id = VRF_DEFAULT;
+	api_nh->type = NEXTHOP_TYPE_IPV4;
+	api_nh->gate.ipv4.s_addr = htonl(0xc0000201);
+
+	stream_reset(s);
+	assert(zapi_route_encode(ZEBRA_ROUTE_ADD, s, &api) == 0);
+}
+
+static void *sock_writer(void *arg)
+{
+	struct run *run = arg;
+	struct stream *s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	unsigned int i;
+
+	for (i = 0; i < run->nroutes; i++) {
+		encode_route(s, i);
+		if (writen(run->sock[0], STREAM_DATA(s), stream_get_endp(s))
+		    != (int)stream_get_endp(s))
+			break;
+	}
+
+	stream_free(s);
+	return NULL;
+}
+
+static void sock_reader(struct run *run)
+{
+	struct stream *ibuf = stream_new(ZEBRA_MAX_PACKET_SIZ), *msg;
+	uint16_t length;
+
+	while (run->nmsgs < run->nroutes) {
+		/* header first, then the rest, like zserv_read() */
+		stream_reset(ibuf);
+		if (stream_read(ibuf, run->sock[1], ZEBRA_HEADER_SIZE)
+		    != ZEBRA_HEADER_SIZE)
+			break;
+		length = stream_getw_from(ibuf, 0);
+		if (stream_read(ibuf, run->sock[1], length - ZEBRA_HEADER_SIZE)
+		    != length - ZEBRA_HEADER_SIZE)
+			break;
+
+		msg = stream_dup(ibuf);
+		run->sum = checksum(run->sum, STREAM_DATA(msg), length);
+		run->nbytes += length;
+		run->nmsgs++;
+		stream_free(msg);
+	}
+
+	stream_free(ibuf);
+}
+
+static void *ring_writer(void *arg)
+{
+	struct run *run = arg;
+	struct stream *s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	uint8_t bell = 0;
+	unsigned int i;
+
+	for (i = 0; i < run->nroutes; i++) {
+		encode_route(s, i);
+		while (!shmring_put(run->ring, STREAM_DATA(s),
+				    stream_get_endp(s)))
+			sched_yield();
+		if (shmring_wakeup(run->ring)
+		    && write(run->bell[0], &bell, 1) != 1)
+			break;
+	}
+
+	stream_free(s);
+	return NULL;
+}
+
+static void ring_reader(struct run *run)
+{
+	struct shmring *ring = run->ring;
+	struct stream *msg;
+	uint8_t hdr[ZEBRA_HEADER_SIZE], bell;
+	uint16_t length;
+
+	while (run->nmsgs < run->nroutes) {
+		if (!shmring_remain(ring)) {
+			if (shmring_idle(ring)
+			    && read(run->bell[1], &bell, 1) != 1)
+				break;
+			continue;
+		}
+
+		shmring_peek(ring, 0, hdr, sizeof(hdr));
+		length = (hdr[0] << 8) | hdr[1];
+		assert(length >= ZEBRA_HEADER_SIZE
+		       && length <= shmring_remain(ring));
+
+		msg = stream_new(length);
+		shmring_peek(ring, 0, STREAM_DATA(msg), length);
+		stream_set_endp(msg, length);
+		shmring_consume(ring, length);
+
+		run->sum = checksum(run->sum, STREAM_DATA(msg), length);
+		run->nbytes += length;
+		run->nmsgs++;
+		stream_free(msg);
+	}
+}
+
+static double run_one(struct run *run, void *(*writer)(void *),
+		      void (*reader)(struct run *))
+{
+	struct timeval start, now;
+	pthread_t thread;
+	double usec;
+
+	run->nmsgs = 0;
+	run->nbytes = 0;
+	run->sum = 0;
+
+	monotime(&start);
+	if (pthread_create(&thread, NULL, writer, run))
+		return 0;
+	reader(run);
+	pthread_join(thread, NULL);
+	monotime(&now);
+
+	usec = 1000000.0 * (now.tv_sec - start.tv_sec)
+	       + (now.tv_usec - start.tv_usec);
+	return run->nmsgs / (usec ? usec : 1);
+}
+
+int main(int argc, char **argv)
+{
+	struct run run = {};
+	unsigned int nroutes = 1000000;
+	uint32_t sock_sum;
+	uint64_t sock_bytes;
+	double sock_rate, ring_rate;
+	int ret = 0;
+
+	if (argc > 1)
+		nroutes = atoi(argv[1]);
+	run.nroutes = nroutes;
+
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, run.sock) || pipe(run.bell)) {
+		perror("socketpair/pipe");
+		return 1;
+	}
+	run.ring = shmring_create(RING_SIZE);
+	if (!run.ring) {
+		printf("can't create shared memory ring, skipping\n");
+		return 0;
+	}
+
+	sock_rate = run_one(&run, sock_writer, sock_reader);
+	sock_sum = run.sum;
+	sock_bytes = run.nbytes;
+
+	ring_rate = run_one(&run, ring_writer, ring_reader);
+
+	printf("%10s %12s %14s %14s\n", "routes", "bytes", "socket Mmsg/s",
+	       "ring Mmsg/s");
+	printf("%10u %12" PRIu64 " %14.2f %14.2f\n", nroutes, sock_bytes,
+	       sock_rate, ring_rate);
+
+	if (run.nmsgs != nroutes || run.sum != sock_sum
+	    || run.nbytes != sock_bytes) {
+		printf("ring delivered different data than the socket\n");
+		ret = 1;
+	}
+
+	shmring_del(run.ring);
+	close(run.sock[0]);
+	close(run.sock[1]);
+	close(run.bell[0]);
+	close(run.bell[1]);
+	return ret;
+}
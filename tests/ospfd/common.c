@@ -33,6 +33,8 @@ struct ospf_topology *test_find_topology(const char *name)
 		return &topo4;
 	else if (strmatch(name, "topo5"))
 		return &topo5;
+	else if (strmatch(name, "topo6"))
+		return &topo6;
 
 	return NULL;
 }
@@ -93,27 +95,31 @@ struct ospf_test_node *test_find_node(struct ospf_topology *topology,
 	return NULL;
 }
 
-static void inject_router_lsa(struct vty *vty, struct ospf *ospf,
+/*
+ * The metrics of the point-to-point and stub links of the node are raised by
+ * 'p2p_delta' and 'stub_delta', and its loopback stub is only advertised if
+ * 'loopback' is set, to test LSA changes.
+ */
+static void inject_router_lsa(struct vty *vty, struct ospf_area *area,
 			      struct ospf_topology *topology,
 			      struct ospf_test_node *root,
-			      struct ospf_test_node *tnode)
+			      struct ospf_test_node *tnode, uint32_t p2p_delta,
+			      uint32_t stub_delta, bool loopback)
 {
-	struct ospf_area *area;
 	struct in_addr router_id;
 	struct in_addr adj_router_id;
 	struct prefix_ipv4 prefix;
 	struct in_addr data;
 	struct stream *s;
 	struct lsa_header *lsah;
-	struct ospf_lsa *new;
+	struct ospf_lsa *new, *old;
 	int length;
 	unsigned long putp;
-	uint16_t link_count;
+	uint16_t link_count, links = 0;
 	struct ospf_test_node *tfound_adj_node;
 	struct ospf_test_adj *tadj;
 	bool is_self_lsa = false;
 
-	area = ospf->backbone;
 	inet_aton(tnode->router_id, &router_id);
 
 	if (strncmp(root->router_id, tnode->router_id, 256) == 0)
@@ -138,21 +144,34 @@ static void inject_router_lsa(struct vty *vty, struct ospf *ospf,
 
 		inet_aton(tfound_adj_node->router_id, &adj_router_id);
 		data.s_addr = prefix.prefix.s_addr;
-		link_info_set(&s, adj_router_id, data,
-			      LSA_LINK_TYPE_POINTOPOINT, 0, tadj->metric);
+
+		/* The network-LSA of a broadcast network has its prefix */
+		if (tfound_adj_node->dr) {
+			links += link_info_set(&s, adj_router_id, data,
+					       LSA_LINK_TYPE_TRANSIT, 0,
+					       tadj->metric + p2p_delta);
+			continue;
+		}
+
+		links += link_info_set(&s, adj_router_id, data,
+				       LSA_LINK_TYPE_POINTOPOINT, 0,
+				       tadj->metric + p2p_delta);
 
 		masklen2ip(prefix.prefixlen, &data);
-		link_info_set(&s, prefix.prefix, data, LSA_LINK_TYPE_STUB, 0,
-			      tadj->metric);
+		links += link_info_set(&s, prefix.prefix, data,
+				       LSA_LINK_TYPE_STUB, 0,
+				       tadj->metric + stub_delta);
 	}
 
 	/* Don't forget the node itself (just a stub) */
-	str2prefix_ipv4(tnode->router_id, &prefix);
-	data.s_addr = 0xffffffff;
-	link_info_set(&s, prefix.prefix, data, LSA_LINK_TYPE_STUB, 0, 0);
+	if (loopback) {
+		str2prefix_ipv4(tnode->router_id, &prefix);
+		data.s_addr = 0xffffffff;
+		links += link_info_set(&s, prefix.prefix, data,
+				       LSA_LINK_TYPE_STUB, 0, stub_delta);
+	}
 
-	/* Take twice the link count (for P2P and stub) plus the local stub */
-	stream_putw_at(s, putp, (2 * link_count) + 1);
+	stream_putw_at(s, putp, links);
 
 	length = stream_get_endp(s);
 	lsah = (struct lsa_header *)STREAM_DATA(s);
@@ -168,6 +187,11 @@ static void inject_router_lsa(struct vty *vty, struct ospf *ospf,
 	memcpy(new->data, lsah, length);
 	stream_free(s);
 
+	/* As ospf_lsa_install() does for a new instance */
+	old = ospf_lsdb_lookup(area->lsdb, new);
+	if (old)
+		ospf_spf_lsa_changed(area, old, new);
+
 	ospf_lsdb_add(area->lsdb, new);
 
 	if (is_self_lsa) {
@@ -176,6 +200,61 @@ static void inject_router_lsa(struct vty *vty, struct ospf *ospf,
 	}
 }
 
+/* The network-LSA of the broadcast network 'tnode', from its DR */
+static void inject_network_lsa(struct vty *vty, struct ospf_area *area,
+			       struct ospf_topology *topology,
+			       struct ospf_test_node *root,
+			       struct ospf_test_node *tnode)
+{
+	struct ospf_test_node *tdr, *tfound_adj_node;
+	struct ospf_test_adj *tadj;
+	struct in_addr id, dr_id, router_id, mask;
+	struct prefix_ipv4 prefix = {};
+	struct stream *s;
+	struct lsa_header *lsah;
+	struct ospf_lsa *new;
+	int length;
+
+	tdr = test_find_node(topology, tnode->dr);
+	inet_aton(tnode->router_id, &id);
+	inet_aton(tdr->router_id, &dr_id);
+
+	/* The mask is that of the DR's interface to the network */
+	for (tadj = tdr->adjacencies; tadj->hostname[0]; tadj++)
+		if (strmatch(tadj->hostname, tnode->hostname))
+			str2prefix_ipv4(tadj->network, &prefix);
+
+	s = stream_new(OSPF_MAX_LSA_SIZE);
+	lsa_header_set(s, LSA_OPTIONS_GET(area) | LSA_OPTIONS_NSSA_GET(area),
+		       OSPF_NETWORK_LSA, id, dr_id);
+
+	masklen2ip(prefix.prefixlen, &mask);
+	stream_put_ipv4(s, mask.s_addr);
+
+	/* The routers on the network, the DR included */
+	for (tadj = tnode->adjacencies; tadj->hostname[0]; tadj++) {
+		tfound_adj_node = test_find_node(topology, tadj->hostname);
+		inet_aton(tfound_adj_node->router_id, &router_id);
+		stream_put_ipv4(s, router_id.s_addr);
+	}
+
+	length = stream_get_endp(s);
+	lsah = (struct lsa_header *)STREAM_DATA(s);
+	lsah->length = htons(length);
+
+	new = ospf_lsa_new_and_data(length);
+	new->area = area;
+	new->vrf_id = area->ospf->vrf_id;
+
+	if (strmatch(root->hostname, tdr->hostname))
+		SET_FLAG(new->flags, OSPF_LSA_SELF | OSPF_LSA_SELF_CHECKED);
+
+	memcpy(new->data, lsah, length);
+	stream_free(s);
+
+	ospf_lsdb_add(area->lsdb, new);
+}
+
 static void inject_sr_db_entry(struct vty *vty, struct ospf_test_node *tnode,
 			       struct ospf_topology *topology)
 {
@@ -212,6 +291,8 @@ static void inject_sr_db_entry(struct vty *vty, struct ospf_test_node *tnode,
 	     link_count++) {
 		tadj = &tnode->adjacencies[link_count];
 		tfound_adj_node = test_find_node(topology, tadj->hostname);
+		if (tfound_adj_node->dr)
+			continue;
 
 		srl = XCALLOC(MTYPE_OSPF_SR_PARAMS, sizeof(struct sr_link));
 		srl->adv_router = router_id;
@@ -229,21 +310,63 @@ static void inject_sr_db_entry(struct vty *vty, struct ospf_test_node *tnode,
 
 int topology_load(struct vty *vty, struct ospf_topology *topology,
 		  struct ospf_test_node *root, struct ospf *ospf)
+{
+	return topology_load_area(vty, topology, root, ospf->backbone);
+}
+
+int topology_load_area(struct vty *vty, struct ospf_topology *topology,
+		       struct ospf_test_node *root, struct ospf_area *area)
 {
 	struct ospf_test_node *tnode;
 
 	for (int i = 0; topology->nodes[i].hostname[0]; i++) {
 		tnode = &topology->nodes[i];
 
+		if (tnode->dr) {
+			inject_network_lsa(vty, area, topology, root, tnode);
+			continue;
+		}
+
 		/* Inject a router LSA for each node, used for SPF */
-		inject_router_lsa(vty, ospf, topology, root, tnode);
+		inject_router_lsa(vty, area, topology, root, tnode, 0, 0, true);
 
 		/*
 		 * SR information could also be inected via LSAs, but directly
-		 * filling the SR DB with labels is just easier.
+		 * filling the SR DB with labels is just easier.  The SR DB is
+		 * per instance, the backbone's copy of the topology fills it.
 		 */
-		inject_sr_db_entry(vty, tnode, topology);
+		if (area == area->ospf->backbone)
+			inject_sr_db_entry(vty, tnode, topology);
 	}
 
 	return 0;
 }
+
+/*
+ * The calculation on behalf of the router itself, unlike the dry runs, looks
+ * up the interfaces of the root's links.  The test topologies have none, a
+ * single point-to-point interface stands in for all of them.
+ */
+void test_area_interface(struct ospf_area *area)
+{
+	struct ospf_interface *oi;
+
+	oi = XCALLOC(MTYPE_TMP, sizeof(*oi));
+	oi->ifp = XCALLOC(MTYPE_TMP, sizeof(*oi->ifp));
+	oi->connected = XCALLOC(MTYPE_TMP, sizeof(*oi->connected));
+	oi->nbrs = route_table_init();
+	oi->type = OSPF_IFTYPE_POINTOPOINT;
+	oi->area = area;
+	oi->lsa_pos_beg = 0;
+	oi->lsa_pos_end = OSPF_MAX_LSA_SIZE;
+	listnode_add(area->oiflist, oi);
+}
+
+void topology_update_node(struct vty *vty, struct ospf_topology *topology,
+			  struct ospf_test_node *root, struct ospf *ospf,
+			  struct ospf_test_node *tnode, uint32_t p2p_delta,
+			  uint32_t stub_delta, bool loopback)
+{
+	inject_router_lsa(vty, ospf->backbone, topology, root, tnode, p2p_delta,
+			  stub_delta, loopback);
+}
@@ -11,23 +11,43 @@ struct ospf_test_adj {
 	mpls_label_t label;
 };
 
+/*
+ * A node with a 'dr' is a broadcast network: 'router_id' is the interface
+ * address of its designated router, the adjacencies are the routers on it.
+ */
 struct ospf_test_node {
 	char hostname[256];
 	const char *router_id;
+	const char *dr;
 	mpls_label_t label;
 	struct ospf_test_adj adjacencies[MAX_ADJACENCIES + 1];
 };
 
+/* Nodes, terminated by one with an empty hostname */
 struct ospf_topology {
-	struct ospf_test_node nodes[MAX_NODES + 1];
+	struct ospf_test_node *nodes;
 };
 
 /* Prototypes. */
 extern struct ospf_topology *test_find_topology(const char *name);
 extern struct ospf_test_node *test_find_node(struct ospf_topology *topology,
 					     const char *hostname);
+extern struct ospf_topology *topology_grid_new(unsigned int rows,
+					       unsigned int cols);
+extern void topology_grid_free(struct ospf_topology *topology);
 extern int topology_load(struct vty *vty, struct ospf_topology *topology,
 			 struct ospf_test_node *root, struct ospf *ospf);
+extern int topology_load_area(struct vty *vty, struct ospf_topology *topology,
+			      struct ospf_test_node *root,
+			      struct ospf_area *area);
+extern void test_area_interface(struct ospf_area *area);
+extern void topology_update_node(struct vty *vty,
+				 struct ospf_topology *topology,
+				 struct ospf_test_node *root,
+				 struct ospf *ospf,
+				 struct ospf_test_node *tnode,
+				 uint32_t p2p_delta, uint32_t stub_delta,
+				 bool loopback);
 
 /* Global variables. */
 extern struct thread_master *master;
@@ -36,6 +56,7 @@ extern struct ospf_topology topo2;
 extern struct ospf_topology topo3;
 extern struct ospf_topology topo4;
 extern struct ospf_topology topo5;
+extern struct ospf_topology topo6;
 extern struct zebra_privs_t ospfd_privs;
 
 /* For stable order in unit tests */
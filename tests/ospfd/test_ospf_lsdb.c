@@ -0,0 +1,268 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * OSPF LSDB test.
+ *
+ * Randomly adds, replaces and deletes LSAs, also from within LSDB_LOOP, and
+ * checks the walks, lookups and counters against a plain array of the LSAs.
+ * Built for both LSDB backends: test_ospf_lsdb with the one configured,
+ * test_ospf_lsdb_hash with the hash tables.
+ */
+
+#include <zebra.h>
+
+#include "table.h"
+#include "prefix.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
+
+#include "prng.h"
+
+/*
+ * The Link State IDs are 0.0.0.0, 0.0.0.1, 1.0.0.0, 1.0.0.1 and so on, for
+ * ranges of them to have several LSAs, the Advertising Routers 0.0.0.1 on.
+ * Keys number them in the order of the LSDB: by ID, then by router.
+ */
+#define TEST_IDS 128
+#define TEST_ADVS 8
+#define TEST_KEYS (TEST_IDS * TEST_ADVS)
+#define TEST_ROUNDS 300
+
+static const uint8_t test_types[] = { OSPF_ROUTER_LSA, OSPF_AS_EXTERNAL_LSA };
+#define TEST_TYPES array_size(test_types)
+
+static struct prng *prng;
+static struct ospf_lsdb *lsdb;
+
+/* The LSAs in the LSDB, by type and key */
+static struct ospf_lsa *model[TEST_TYPES][TEST_KEYS];
+
+static uint16_t test_checksum;
+
+static struct in_addr key_id(unsigned int key)
+{
+	unsigned int id = key / TEST_ADVS;
+	struct in_addr addr;
+
+	addr.s_addr = htonl((id >> 1) << 24 | (id & 1));
+	return addr;
+}
+
+static struct in_addr key_adv_router(unsigned int key)
+{
+	struct in_addr addr;
+
+	addr.s_addr = htonl(key % TEST_ADVS + 1);
+	return addr;
+}
+
+static unsigned int lsa_key(struct ospf_lsa *lsa)
+{
+	uint32_t id = ntohl(lsa->data->id.s_addr);
+
+	return ((id >> 24) << 1 | (id & 1)) * TEST_ADVS
+	       + ntohl(lsa->data->adv_router.s_addr) - 1;
+}
+
+/* The first key from 'key' on with an LSA, TEST_KEYS if none */
+static unsigned int model_next(unsigned int t, unsigned int key)
+{
+	while (key < TEST_KEYS && !model[t][key])
+		key++;
+	return key;
+}
+
+/* Add a new instance of the LSA, which the LSDB then holds the only lock of */
+static void test_add(unsigned int t, unsigned int key)
+{
+	struct ospf_lsa *lsa;
+
+	lsa = ospf_lsa_new_and_data(OSPF_LSA_HEADER_SIZE);
+	lsa->data->type = test_types[t];
+	lsa->data->id = key_id(key);
+	lsa->data->adv_router = key_adv_router(key);
+	lsa->data->checksum = htons(++test_checksum);
+	lsa->data->length = htons(OSPF_LSA_HEADER_SIZE);
+
+	ospf_lsdb_add(lsdb, lsa);
+	model[t][key] = lsa;
+	ospf_lsa_discard(lsa);
+}
+
+static void test_delete(unsigned int t, unsigned int key)
+{
+	struct ospf_lsa *lsa = model[t][key];
+
+	if (!lsa)
+		return;
+
+	model[t][key] = NULL;
+	ospf_lsdb_delete(lsdb, lsa);
+}
+
+static void test_change(unsigned int t)
+{
+	unsigned int key = prng_rand(prng) % TEST_KEYS;
+
+	/* Keep the LSDB about half full */
+	if (prng_rand(prng) % 2)
+		test_add(t, key);
+	else
+		test_delete(t, key);
+}
+
+static void test_lookup(unsigned int t)
+{
+	unsigned int key, count = 0, checksum = 0;
+
+	for (key = 0; key < TEST_KEYS; key++) {
+		assert(ospf_lsdb_lookup_by_id(lsdb, test_types[t], key_id(key),
+					      key_adv_router(key))
+		       == model[t][key]);
+		if (model[t][key]) {
+			count++;
+			checksum += ntohs(model[t][key]->data->checksum);
+		}
+	}
+
+	assert(ospf_lsdb_count(lsdb, test_types[t]) == count);
+	assert(ospf_lsdb_checksum(lsdb, test_types[t]) == checksum);
+}
+
+/*
+ * Walk the LSAs, changing the LSDB as the loop goes.  Each step has to come
+ * up with the next LSA of the LSDB as it is then: LSAs added past the
+ * current one are walked, deleted ones are not.
+ */
+static void test_walk(unsigned int t)
+{
+	struct route_node *rn;
+	struct ospf_lsa *lsa;
+	struct in_addr none = {};
+	unsigned int key, next = 0;
+
+	LSDB_LOOP (lsdb->type[test_types[t]].db, rn, lsa) {
+		key = model_next(t, next);
+		assert(key < TEST_KEYS && lsa == model[t][key]);
+		assert(lsa_key(lsa) == key);
+		next = key + 1;
+
+		switch (prng_rand(prng) % 8) {
+		case 0:
+			test_delete(t, key);
+			break;
+		case 1:
+			/* A new instance of the current LSA */
+			test_add(t, key);
+			break;
+		case 2:
+			test_change(t);
+			break;
+		case 3:
+			/* Sort what was added while the walk goes on */
+			test_add(t, prng_rand(prng) % TEST_KEYS);
+			ospf_lsdb_lookup_by_id_next(lsdb, test_types[t], none,
+						    none, 1);
+			break;
+		default:
+			break;
+		}
+	}
+
+	assert(model_next(t, next) == TEST_KEYS);
+}
+
+static void test_lookup_next(unsigned int t)
+{
+	struct ospf_lsa *lsa;
+	struct in_addr id = {}, adv_router = {};
+	unsigned int key = 0;
+	int first = 1;
+
+	while ((lsa = ospf_lsdb_lookup_by_id_next(lsdb, test_types[t], id,
+						  adv_router, first))) {
+		key = model_next(t, key);
+		assert(lsa == model[t][key]);
+		key++;
+
+		id = lsa->data->id;
+		adv_router = lsa->data->adv_router;
+		first = 0;
+	}
+	assert(model_next(t, key) == TEST_KEYS);
+
+	/* There is no next one for an LSA that is not in the LSDB */
+	key = prng_rand(prng) % TEST_KEYS;
+	if (!model[t][key])
+		assert(!ospf_lsdb_lookup_by_id_next(lsdb, test_types[t],
+						    key_id(key),
+						    key_adv_router(key), 0));
+}
+
+/* Whether the key has an LSA whose Link State ID is within 'p' */
+static bool model_in_range(unsigned int t, unsigned int key,
+			   const struct prefix_ipv4 *p, struct in_addr mask)
+{
+	return model[t][key]
+	       && (key_id(key).s_addr & mask.s_addr) == p->prefix.s_addr;
+}
+
+static void test_range(unsigned int t)
+{
+	static const uint8_t plens[] = { 0, 1, 4, 7, 8, 16, 31, 32 };
+	struct prefix_ipv4 p = { .family = AF_INET };
+	struct ospf_lsa *lsa = NULL;
+	struct in_addr mask;
+	unsigned int key = 0;
+
+	p.prefixlen = plens[prng_rand(prng) % array_size(plens)];
+	p.prefix = key_id(prng_rand(prng) % TEST_KEYS);
+	apply_mask_ipv4(&p);
+	masklen2ip(p.prefixlen, &mask);
+
+	while ((lsa = ospf_lsdb_lookup_by_id_range(lsdb, test_types[t], &p,
+						   lsa))) {
+		while (key < TEST_KEYS && !model_in_range(t, key, &p, mask))
+			key++;
+		assert(key < TEST_KEYS && lsa == model[t][key]);
+		key++;
+	}
+
+	for (; key < TEST_KEYS; key++)
+		assert(!model_in_range(t, key, &p, mask));
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int round, t, i, changes;
+
+	prng = prng_new(0);
+	lsdb = ospf_lsdb_new();
+
+	for (round = 0; round < TEST_ROUNDS; round++) {
+		for (t = 0; t < TEST_TYPES; t++) {
+			changes = prng_rand(prng) % 64;
+			for (i = 0; i < changes; i++)
+				test_change(t);
+
+			test_lookup(t);
+			test_walk(t);
+			test_lookup(t);
+			test_lookup_next(t);
+			test_range(t);
+		}
+	}
+	printf("Verified walks\n");
+	printf("Verified lookups\n");
+	printf("Verified range lookups\n");
+
+	ospf_lsdb_delete_all(lsdb);
+	assert(ospf_lsdb_isempty(lsdb));
+	ospf_lsdb_free(lsdb);
+	prng_free(prng);
+
+	printf("Verified freeing\n");
+	return 0;
+}
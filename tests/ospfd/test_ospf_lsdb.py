@@ -0,0 +1,16 @@
+import frrtest
+
+
+class TestOspfLsdb(frrtest.TestMultiOut):
+    program = "./test_ospf_lsdb"
+
+
+class TestOspfLsdbHash(frrtest.TestMultiOut):
+    program = "./test_ospf_lsdb_hash"
+
+
+for cls in TestOspfLsdb, TestOspfLsdbHash:
+    cls.onesimple("Verified walks")
+    cls.onesimple("Verified lookups")
+    cls.onesimple("Verified range lookups")
+    cls.onesimple("Verified freeing")
@@ -0,0 +1,201 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * OSPF LSDB benchmark.
+ *
+ * Installs AS-external-LSAs into an LSDB the way ospf_lsa_install() does,
+ * then looks them up, refreshes them, walks them the way flooding and the
+ * MaxAge walker do, and flushes them.  The LSDB backend is picked at build
+ * time (--enable-ospf-lsdb-hash): run the benchmark from both builds to
+ * compare them.
+ *
+ * Prints ops/s for each phase, and the memory the LSDB takes on top of the
+ * LSAs themselves.
+ */
+
+#include <zebra.h>
+
+#include "table.h"
+#include "prefix.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
+
+#include "bench.h"
+
+#ifdef OSPF_LSDB_HASH
+#define BACKEND "hash"
+#else
+#define BACKEND "route_table"
+#endif
+
+/* Address 'i' of 10.0.0.0/8, spread out: distinct for the first 2^24 */
+static struct in_addr lsa_id(unsigned int i)
+{
+	struct in_addr id;
+
+	id.s_addr = htonl(0x0a000000 | ((i * 2654435761U) & 0xffffff));
+	return id;
+}
+
+static struct ospf_lsa *lsa_new(unsigned int i, unsigned int asbrs,
+				uint32_t seqnum)
+{
+	struct ospf_lsa *lsa;
+
+	lsa = ospf_lsa_new_and_data(OSPF_LSA_HEADER_SIZE);
+	lsa->data->type = OSPF_AS_EXTERNAL_LSA;
+	lsa->data->id = lsa_id(i);
+	lsa->data->adv_router.s_addr = htonl(0x01010100 | (i % asbrs));
+	lsa->data->ls_seqnum = htonl(seqnum);
+	lsa->data->checksum = htons(i);
+	lsa->data->length = htons(OSPF_LSA_HEADER_SIZE);
+	return lsa;
+}
+
+/* As ospf_lsa_install(): look the old instance up, then replace it */
+static void lsa_install(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
+{
+	struct ospf_lsa *old;
+
+	old = ospf_lsdb_lookup(lsdb, lsa);
+	if (old && old == lsa)
+		return;
+	ospf_lsdb_add(lsdb, lsa);
+}
+
+/* The order of the LSDB: Link State ID, then Advertising Router */
+static uint64_t lsa_key(struct ospf_lsa *lsa)
+{
+	return ((uint64_t)ntohl(lsa->data->id.s_addr) << 32)
+	       | ntohl(lsa->data->adv_router.s_addr);
+}
+
+/* Walk the LSAs, checking they come in order */
+static unsigned long lsdb_walk(struct ospf_lsdb *lsdb, bool *sorted)
+{
+	struct route_node *rn;
+	struct ospf_lsa *lsa, *prev = NULL;
+	unsigned long count = 0;
+
+	LSDB_LOOP (lsdb->type[OSPF_AS_EXTERNAL_LSA].db, rn, lsa) {
+		if (prev && lsa_key(prev) >= lsa_key(lsa))
+			*sorted = false;
+		prev = lsa;
+		count++;
+	}
+	return count;
+}
+
+static int run(unsigned int count, unsigned int asbrs)
+{
+	struct ospf_lsdb *lsdb;
+	struct ospf_lsa **lsas, *lsa;
+	struct timeval start;
+	unsigned int i, extra = count / 100;
+	unsigned long found = 0, walked;
+	size_t heap;
+	bool sorted = true;
+
+	printf("%s LSDB, %u AS-external-LSAs from %u ASBRs:\n", BACKEND, count,
+	       asbrs);
+
+	/* LSAs are allocated up front so that only the LSDB is measured */
+	lsas = XCALLOC(MTYPE_TMP, (count + extra) * sizeof(*lsas));
+	for (i = 0; i < count + extra; i++)
+		lsas[i] = lsa_new(i, asbrs, OSPF_INITIAL_SEQUENCE_NUMBER);
+
+	heap = bench_heap_used();
+	lsdb = ospf_lsdb_new();
+
+	monotime(&start);
+	for (i = 0; i < count; i++)
+		lsa_install(lsdb, lsas[i]);
+	bench_report("install", count, &start);
+
+	heap = bench_heap_used() - heap;
+
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		lsa = lsas[(i * 7919ULL) % count];
+		if (ospf_lsdb_lookup_by_id(lsdb, OSPF_AS_EXTERNAL_LSA,
+					   lsa->data->id,
+					   lsa->data->adv_router) == lsa)
+			found++;
+	}
+	bench_report("lookup", count, &start);
+
+	/* Flooding walks the LSDB for database exchange, MaxAge and refresh */
+	monotime(&start);
+	walked = lsdb_walk(lsdb, &sorted);
+	bench_report("walk", walked, &start);
+
+	monotime(&start);
+	walked += lsdb_walk(lsdb, &sorted);
+	bench_report("rewalk", count, &start);
+
+	/* New instances of every LSA, as with a refresh of all of them */
+	monotime(&start);
+	for (i = 0; i < count; i++) {
+		lsa = lsa_new(i, asbrs, OSPF_INITIAL_SEQUENCE_NUMBER + 1);
+		lsa_install(lsdb, lsa);
+		ospf_lsa_discard(lsa);
+	}
+	bench_report("refresh", count, &start);
+
+	/* A few new prefixes, then another walk */
+	for (i = count; i < count + extra; i++)
+		lsa_install(lsdb, lsas[i]);
+	monotime(&start);
+	walked += lsdb_walk(lsdb, &sorted);
+	bench_report("walk+1%", count + extra, &start);
+
+	monotime(&start);
+	for (i = 0; i < count + extra; i++) {
+		lsa = ospf_lsdb_lookup(lsdb, lsas[i]);
+		ospf_lsdb_delete(lsdb, lsa);
+	}
+	bench_report("flush", count + extra, &start);
+
+	printf("  LSDB memory %zu bytes, %.1f bytes/LSA\n\n", heap,
+	       (double)heap / count);
+
+	ospf_lsdb_free(lsdb);
+	for (i = 0; i < count + extra; i++)
+		ospf_lsa_discard(lsas[i]);
+	XFREE(MTYPE_TMP, lsas);
+
+	if (found != count || walked != 3UL * count + extra || !sorted)
+		return 1;
+	return 0;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-n LSAs] [-a ASBRs]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int count = 500000, asbrs = 16;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:a:")) != -1) {
+		switch (opt) {
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		case 'a':
+			asbrs = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!count || !asbrs || count >= (1U << 24))
+		usage(argv[0]);
+
+	return run(count, asbrs);
+}
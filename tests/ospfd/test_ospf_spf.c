@@ -9,10 +9,15 @@
 #include "vrf.h"
 #include "table.h"
 #include "mpls.h"
+#include "zclient.h"
+#include "frr_pthread.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_ia.h"
+#include "ospfd/ospf_interface.h"
 #include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
 #include "ospfd/ospf_route.h"
 #include "ospfd/ospf_spf.h"
 #include "ospfd/ospf_ti_lfa.h"
@@ -202,6 +207,472 @@ DEFUN(test_ospf, test_ospf_cmd,
 	return test_run(vty, topology, root, protection_type, verbose);
 }
 
+/* Whether both paths have the same backup label stack, if any */
+static bool path_backup_same(struct ospf_path *path1, struct ospf_path *path2)
+{
+	struct mpls_label_stack *ls1 = path1->srni.backup_label_stack;
+	struct mpls_label_stack *ls2 = path2->srni.backup_label_stack;
+
+	if (!ls1 || !ls2)
+		return !ls1 && !ls2;
+
+	return ls1->num_labels == ls2->num_labels
+	       && !memcmp(ls1->label, ls2->label,
+			  ls1->num_labels * sizeof(ls1->label[0]));
+}
+
+/* Whether both tables have the same routes, with the same paths */
+static bool route_table_same(struct route_table *rt1, struct route_table *rt2)
+{
+	struct route_node *rn1, *rn2;
+	struct ospf_route *or1, *or2;
+	struct listnode *node1, *node2;
+	struct ospf_path *path1, *path2;
+
+	rn1 = route_top(rt1);
+	rn2 = route_top(rt2);
+	for (;;) {
+		while (rn1 && !rn1->info)
+			rn1 = route_next(rn1);
+		while (rn2 && !rn2->info)
+			rn2 = route_next(rn2);
+		if (!rn1 || !rn2)
+			break;
+
+		or1 = rn1->info;
+		or2 = rn2->info;
+		if (prefix_cmp(&rn1->p, &rn2->p) || or1->cost != or2->cost
+		    || or1->u.std.area_id.s_addr != or2->u.std.area_id.s_addr
+		    || listcount(or1->paths) != listcount(or2->paths))
+			break;
+
+		list_sort(or1->paths, sort_paths);
+		list_sort(or2->paths, sort_paths);
+		node2 = listhead(or2->paths);
+		for (ALL_LIST_ELEMENTS_RO(or1->paths, node1, path1)) {
+			path2 = listgetdata(node2);
+			if (path1->nexthop.s_addr != path2->nexthop.s_addr
+			    || path1->adv_router.s_addr
+				       != path2->adv_router.s_addr
+			    || !path_backup_same(path1, path2))
+				break;
+			node2 = listnextnode(node2);
+		}
+		if (node1)
+			break;
+
+		rn1 = route_next(rn1);
+		rn2 = route_next(rn2);
+	}
+
+	if (rn1)
+		route_unlock_node(rn1);
+	if (rn2)
+		route_unlock_node(rn2);
+
+	return !rn1 && !rn2;
+}
+
+/*
+ * Run SPF incrementally after a change described by 'what', and compare the
+ * routes with those of a full run.
+ */
+static void test_run_incremental_step(struct vty *vty, struct ospf_area *area,
+				      const char *what)
+{
+	struct route_table *new_table, *new_rtrs, *all_rtrs;
+	struct route_table *full_table, *full_rtrs, *full_all_rtrs;
+	bool incremental;
+
+	new_table = route_table_init();
+	new_rtrs = route_table_init();
+	all_rtrs = route_table_init();
+	incremental = ospf_spf_calculate_incremental(area, new_table,
+						     all_rtrs, new_rtrs);
+	vty_out(vty, "%s: %s SPF\n", what,
+		incremental ? "incremental" : "full");
+	if (!incremental)
+		goto out;
+
+	print_route_table(vty, new_table);
+
+	full_table = route_table_init();
+	full_rtrs = route_table_init();
+	full_all_rtrs = route_table_init();
+	ospf_spf_calculate(area, area->router_lsa_self, full_table,
+			   full_all_rtrs, full_rtrs, true, false);
+	ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+	area->spf = NULL;
+	area->spf_vertex_list = NULL;
+	vty_out(vty, "full SPF: %s routes\n",
+		route_table_same(new_table, full_table) ? "same" : "different");
+
+	ospf_route_table_free(full_table);
+	ospf_rtrs_free(full_rtrs);
+	ospf_rtrs_free(full_all_rtrs);
+out:
+	ospf_route_table_free(new_table);
+	ospf_rtrs_free(new_rtrs);
+	ospf_rtrs_free(all_rtrs);
+}
+
+static void test_run_incremental(struct vty *vty,
+				 struct ospf_topology *topology,
+				 struct ospf_test_node *root,
+				 struct ospf_test_node *tnode)
+{
+	struct route_table *new_table, *new_rtrs, *all_rtrs;
+	struct ospf_area *area;
+	struct ospf *ospf;
+	char what[64];
+
+	ospf = test_init(root);
+	ospf->spf_incremental = true;
+
+	if (topology_load(vty, topology, root, ospf)) {
+		vty_out(vty, "%% Failed to load topology\n");
+		return;
+	}
+
+	area = ospf->backbone;
+
+	/* Full run, whose tree is kept */
+	new_table = route_table_init();
+	new_rtrs = route_table_init();
+	all_rtrs = route_table_init();
+	ospf_spf_calculate(area, area->router_lsa_self, new_table, all_rtrs,
+			   new_rtrs, true, false);
+	ospf_spf_tree_keep(area);
+	ospf_route_table_free(new_table);
+	ospf_rtrs_free(new_rtrs);
+	ospf_rtrs_free(all_rtrs);
+
+	/* Only the stub links of the node change: the tree is reused */
+	topology_update_node(vty, topology, root, ospf, tnode, 0, 5, true);
+	snprintf(what, sizeof(what), "stub metrics of %s raised",
+		 tnode->hostname);
+	test_run_incremental_step(vty, area, what);
+
+	/* So is it when one of them goes away */
+	topology_update_node(vty, topology, root, ospf, tnode, 0, 5, false);
+	snprintf(what, sizeof(what), "loopback of %s withdrawn",
+		 tnode->hostname);
+	test_run_incremental_step(vty, area, what);
+
+	/* Its point-to-point links change too: a full run is needed */
+	topology_update_node(vty, topology, root, ospf, tnode, 5, 5, false);
+	snprintf(what, sizeof(what), "link metrics of %s raised",
+		 tnode->hostname);
+	test_run_incremental_step(vty, area, what);
+
+	ospf_spf_tree_free(area);
+}
+
+DEFUN(test_ospf_incremental, test_ospf_incremental_cmd,
+      "test ospf topology WORD root HOSTNAME incremental-spf node HOSTNAME",
+      "Test mode\n"
+      "Choose OSPF for SPF testing\n"
+      "Network topology to choose\n"
+      "Name of the network topology to choose\n"
+      "Root node to choose\n"
+      "Hostname of the root node to choose\n"
+      "Reuse the SPF tree after a stub link change\n"
+      "Node whose links to change\n"
+      "Hostname of the node whose links to change\n")
+{
+	struct ospf_topology *topology;
+	struct ospf_test_node *root, *tnode;
+
+	topology = test_find_topology(argv[3]->arg);
+	if (!topology) {
+		vty_out(vty, "%% Topology not found\n");
+		return CMD_WARNING;
+	}
+
+	root = test_find_node(topology, argv[5]->arg);
+	tnode = test_find_node(topology, argv[8]->arg);
+	if (!root || !tnode) {
+		vty_out(vty, "%% Node not found\n");
+		return CMD_WARNING;
+	}
+
+	test_run_incremental(vty, topology, root, tnode);
+
+	return CMD_SUCCESS;
+}
+
+/*
+ * Full route calculation of the test area into '*table' and '*rtrs', as
+ * ospf_spf_calculate_schedule_worker() does.
+ */
+static void test_prc_spf(struct ospf *ospf, struct route_table **table,
+			 struct route_table **rtrs)
+{
+	struct ospf_area *area = ospf->backbone;
+
+	if (*table)
+		ospf_route_table_free(*table);
+	if (*rtrs)
+		ospf_rtrs_free(*rtrs);
+	*table = route_table_init();
+	*rtrs = route_table_init();
+
+	/*
+	 * The test topologies have no interfaces, nexthops are only found the
+	 * way TI-LFA does (see ospf_nexthop_calculation()).  The PRC itself
+	 * only runs with TI-LFA off.
+	 */
+	ospf->ti_lfa_enabled = true;
+	ospf_spf_calculate(area, area->router_lsa_self, *table, NULL, *rtrs,
+			   true, false);
+	ospf->ti_lfa_enabled = false;
+	ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+	area->spf = NULL;
+	area->spf_vertex_list = NULL;
+
+	ospf_ia_routing(ospf, *table, *rtrs);
+}
+
+/* Install a summary-LSA or ASBR-summary-LSA from 'abr', MaxAge if 'flush' */
+static struct ospf_lsa *test_summary_lsa(struct ospf_area *area, uint8_t type,
+					 struct in_addr abr,
+					 struct prefix_ipv4 *p, uint32_t metric,
+					 bool flush)
+{
+	struct stream *s;
+	struct lsa_header *lsah;
+	struct ospf_lsa *new;
+	struct in_addr mask;
+	int length;
+
+	s = stream_new(OSPF_MAX_LSA_SIZE);
+	lsa_header_set(s, LSA_OPTIONS_GET(area) | LSA_OPTIONS_NSSA_GET(area),
+		       type, p->prefix, abr);
+
+	masklen2ip(type == OSPF_SUMMARY_LSA ? p->prefixlen : 0, &mask);
+	stream_put_ipv4(s, mask.s_addr);
+	stream_putc(s, 0);
+	stream_put3(s, metric);
+
+	length = stream_get_endp(s);
+	lsah = (struct lsa_header *)STREAM_DATA(s);
+	lsah->length = htons(length);
+	if (flush)
+		lsah->ls_age = htons(OSPF_LSA_MAXAGE);
+
+	new = ospf_lsa_new_and_data(length);
+	new->area = area;
+	new->vrf_id = area->ospf->vrf_id;
+	memcpy(new->data, lsah, length);
+	stream_free(s);
+
+	ospf_lsdb_add(area->lsdb, new);
+
+	return new;
+}
+
+/*
+ * Calculate the routes again after 'lsa' was installed, as ospf_lsa_install()
+ * would have it done, and compare them with those of a full run.
+ */
+static void test_run_prc_step(struct vty *vty, struct ospf *ospf,
+			      struct ospf_lsa *lsa, const char *what)
+{
+	struct route_table *full_table = NULL, *full_rtrs = NULL;
+	struct thread thread;
+
+	if (!ospf_prc_schedule(ospf, lsa)) {
+		vty_out(vty, "%s: full SPF\n", what);
+		test_prc_spf(ospf, &ospf->new_table, &ospf->new_rtrs);
+		return;
+	}
+
+	while (ospf->t_prc_calc && thread_fetch(master, &thread))
+		thread_call(&thread);
+
+	vty_out(vty, "%s: PRC\n", what);
+	print_route_table(vty, ospf->new_table);
+
+	test_prc_spf(ospf, &full_table, &full_rtrs);
+	vty_out(vty, "full SPF: %s routes\n",
+		route_table_same(ospf->new_table, full_table) ? "same"
+							      : "different");
+	ospf_route_table_free(full_table);
+	ospf_rtrs_free(full_rtrs);
+}
+
+static void test_run_prc(struct vty *vty, struct ospf_topology *topology,
+			 struct ospf_test_node *root,
+			 struct ospf_test_node *tabr)
+{
+	struct ospf_area *area;
+	struct ospf *ospf;
+	struct ospf_lsa *lsa;
+	struct router_lsa *rl;
+	struct in_addr abr;
+	struct prefix_ipv4 net, asbr;
+
+	ospf = test_init(root);
+	ospf->spf_incremental = true;
+
+	if (topology_load(vty, topology, root, ospf)) {
+		vty_out(vty, "%% Failed to load topology\n");
+		return;
+	}
+
+	area = ospf->backbone;
+
+	/* The node is an ABR, that connects to areas the test doesn't see */
+	inet_aton(tabr->router_id, &abr);
+	lsa = ospf_lsa_lookup_by_id(area, OSPF_ROUTER_LSA, abr);
+	rl = (struct router_lsa *)lsa->data;
+	SET_FLAG(rl->flags, ROUTER_LSA_BORDER);
+
+	test_prc_spf(ospf, &ospf->new_table, &ospf->new_rtrs);
+
+	str2prefix_ipv4("192.168.1.0/24", &net);
+	str2prefix_ipv4("9.9.9.9/32", &asbr);
+
+	/* ASBR-summaries change the routes of AS-external-LSAs: full SPF */
+	lsa = test_summary_lsa(area, OSPF_ASBR_SUMMARY_LSA, abr, &asbr, 10,
+			       false);
+	test_run_prc_step(vty, ospf, lsa, "ASBR-summary-LSA originated");
+
+	lsa = test_summary_lsa(area, OSPF_SUMMARY_LSA, abr, &net, 10, false);
+	test_run_prc_step(vty, ospf, lsa, "summary-LSA originated");
+
+	lsa = test_summary_lsa(area, OSPF_SUMMARY_LSA, abr, &net, 10, true);
+	test_run_prc_step(vty, ospf, lsa, "summary-LSA flushed");
+
+	lsa = test_summary_lsa(area, OSPF_ASBR_SUMMARY_LSA, abr, &asbr, 10,
+			       true);
+	test_run_prc_step(vty, ospf, lsa, "ASBR-summary-LSA flushed");
+
+	ospf_route_table_free(ospf->new_table);
+	ospf_rtrs_free(ospf->new_rtrs);
+	ospf->new_table = NULL;
+	ospf->new_rtrs = NULL;
+}
+
+DEFUN(test_ospf_prc, test_ospf_prc_cmd,
+      "test ospf topology WORD root HOSTNAME prc abr HOSTNAME",
+      "Test mode\n"
+      "Choose OSPF for SPF testing\n"
+      "Network topology to choose\n"
+      "Name of the network topology to choose\n"
+      "Root node to choose\n"
+      "Hostname of the root node to choose\n"
+      "Calculate only the routes summary-LSAs change\n"
+      "Node that originates the summary-LSAs\n"
+      "Hostname of the node that originates the summary-LSAs\n")
+{
+	struct ospf_topology *topology;
+	struct ospf_test_node *root, *tabr;
+
+	topology = test_find_topology(argv[3]->arg);
+	if (!topology) {
+		vty_out(vty, "%% Topology not found\n");
+		return CMD_WARNING;
+	}
+
+	root = test_find_node(topology, argv[5]->arg);
+	tabr = test_find_node(topology, argv[8]->arg);
+	if (!root || !tabr) {
+		vty_out(vty, "%% Node not found\n");
+		return CMD_WARNING;
+	}
+
+	test_run_prc(vty, topology, root, tabr);
+
+	return CMD_SUCCESS;
+}
+
+/* Areas besides the backbone, each with its own copy of the topology */
+#define TEST_WORKERS_AREAS 3
+
+/*
+ * Calculate the routes of several areas on 'workers' pthreads, and compare
+ * them with those of the same areas calculated one after the other.
+ */
+static void test_run_workers(struct vty *vty, struct ospf_topology *topology,
+			     struct ospf_test_node *root, unsigned int workers)
+{
+	struct route_table *seq_table, *seq_rtrs, *new_table, *new_rtrs;
+	struct ospf_area *area;
+	struct in_addr area_id;
+	struct ospf *ospf;
+	unsigned int i;
+
+	ospf = test_init(root);
+	ospf->ti_lfa_protection_type = OSPF_TI_LFA_LINK_PROTECTION;
+
+	if (topology_load(vty, topology, root, ospf)) {
+		vty_out(vty, "%% Failed to load topology\n");
+		return;
+	}
+	test_area_interface(ospf->backbone);
+
+	for (i = 1; i <= TEST_WORKERS_AREAS; i++) {
+		area_id.s_addr = htonl(i);
+		area = ospf_area_new(ospf, area_id);
+		listnode_add_sort(ospf->areas, area);
+		topology_load_area(vty, topology, root, area);
+		test_area_interface(area);
+	}
+
+	seq_table = route_table_init();
+	seq_rtrs = route_table_init();
+	ospf_spf_calculate_areas(ospf, seq_table, NULL, seq_rtrs);
+	print_route_table(vty, seq_table);
+
+	ospf_spf_set_workers(ospf, workers);
+	new_table = route_table_init();
+	new_rtrs = route_table_init();
+	ospf_spf_calculate_areas(ospf, new_table, NULL, new_rtrs);
+	ospf_spf_set_workers(ospf, 1);
+
+	vty_out(vty, "%u areas on %u pthreads: %s routes\n",
+		listcount(ospf->areas), workers,
+		route_table_same(seq_table, new_table) ? "same" : "different");
+
+	ospf_route_table_free(seq_table);
+	ospf_rtrs_free(seq_rtrs);
+	ospf_route_table_free(new_table);
+	ospf_rtrs_free(new_rtrs);
+}
+
+DEFUN(test_ospf_workers, test_ospf_workers_cmd,
+      "test ospf topology WORD root HOSTNAME spf-workers (2-64)",
+      "Test mode\n"
+      "Choose OSPF for SPF testing\n"
+      "Network topology to choose\n"
+      "Name of the network topology to choose\n"
+      "Root node to choose\n"
+      "Hostname of the root node to choose\n"
+      "Calculate the areas in parallel\n"
+      "Number of pthreads, including the main one\n")
+{
+	struct ospf_topology *topology;
+	struct ospf_test_node *root;
+
+	topology = test_find_topology(argv[3]->arg);
+	if (!topology) {
+		vty_out(vty, "%% Topology not found\n");
+		return CMD_WARNING;
+	}
+
+	root = test_find_node(topology, argv[5]->arg);
+	if (!root) {
+		vty_out(vty, "%% Root not found\n");
+		return CMD_WARNING;
+	}
+
+	test_run_workers(vty, topology, root,
+			 strtoul(argv[7]->arg, NULL, 10));
+
+	return CMD_SUCCESS;
+}
+
 static void vty_do_exit(int isexit)
 {
 	printf("\nend.\n");
@@ -275,6 +746,9 @@ int main(int argc, char **argv)
 	/* master init. */
 	master = thread_master_create(NULL);
 
+	/* The SPF workers are frr_pthreads */
+	frr_pthread_init();
+
 	/* Library inits. */
 	cmd_init(1);
 	cmd_hostname_set("test");
@@ -286,11 +760,18 @@ int main(int argc, char **argv)
 
 	/* Install test command. */
 	install_element(VIEW_NODE, &test_ospf_cmd);
+	install_element(VIEW_NODE, &test_ospf_incremental_cmd);
+	install_element(VIEW_NODE, &test_ospf_prc_cmd);
+	install_element(VIEW_NODE, &test_ospf_workers_cmd);
 
 	/* needed for SR DB init */
 	ospf_vty_init();
 	ospf_sr_init();
 
+	/* Routes the PRC changes go to a zebra that isn't there */
+	zclient = zclient_new(master, &zclient_options_default, NULL, 0);
+	zclient->sock = -1;
+
 	term_debug_ospf_ti_lfa = 1;
 
 	/* Read input from .in file. */
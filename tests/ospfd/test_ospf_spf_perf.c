@@ -0,0 +1,179 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * OSPF SPF benchmark.
+ *
+ * Loads generated grids of routers (see topology_grid_new()) into the
+ * backbone and times the SPF run on behalf of a corner of the grid, without
+ * touching the routing table.  With -l, the TI-LFA link protection backup
+ * paths are calculated and timed too.
+ *
+ * Prints the runs per second and the time per run for each grid size.
+ */
+
+#include <zebra.h>
+
+#include "thread.h"
+#include "vty.h"
+#include "command.h"
+#include "log.h"
+#include "vrf.h"
+#include "table.h"
+#include "mpls.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_route.h"
+#include "ospfd/ospf_spf.h"
+#include "ospfd/ospf_vty.h"
+#include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_sr.h"
+#include "ospfd/ospf_ti_lfa.h"
+
+#include "common.h"
+#include "bench.h"
+
+static struct ospf *bench_init(struct ospf_test_node *root, bool ti_lfa)
+{
+	struct ospf *ospf;
+	struct ospf_area *area;
+	struct in_addr area_id;
+	struct in_addr router_id;
+
+	ospf = ospf_new_alloc(0, VRF_DEFAULT_NAME);
+
+	area_id.s_addr = OSPF_AREA_BACKBONE;
+	area = ospf_area_new(ospf, area_id);
+	listnode_add_sort(ospf->areas, area);
+
+	inet_aton(root->router_id, &router_id);
+	ospf->router_id = router_id;
+	ospf->router_id_static = router_id;
+
+	test_area_interface(area);
+
+	ospf->ti_lfa_enabled = ti_lfa;
+	ospf->ti_lfa_protection_type = OSPF_TI_LFA_LINK_PROTECTION;
+
+	return ospf;
+}
+
+static int run(unsigned int size, unsigned int iterations, bool ti_lfa)
+{
+	struct ospf_topology *topology;
+	struct ospf *ospf;
+	struct ospf_area *area;
+	struct route_table *new_table, *new_rtrs, *all_rtrs;
+	struct timeval start;
+	int64_t spf_usec = 0, ti_lfa_usec = 0;
+	unsigned int i;
+	unsigned long routes = 0;
+	struct route_node *rn;
+
+	topology = topology_grid_new(size, size);
+	ospf = bench_init(&topology->nodes[0], ti_lfa);
+	area = ospf->backbone;
+
+	monotime(&start);
+	topology_load(NULL, topology, &topology->nodes[0], ospf);
+	printf("%ux%u grid, %u routers, loaded in %.1f ms:\n", size, size,
+	       size * size, monotime_since(&start, NULL) / 1e3);
+
+	for (i = 0; i < iterations; i++) {
+		new_table = route_table_init();
+		new_rtrs = route_table_init();
+		all_rtrs = route_table_init();
+
+		monotime(&start);
+		ospf_spf_calculate(area, area->router_lsa_self, new_table,
+				   all_rtrs, new_rtrs, true, true);
+		spf_usec += monotime_since(&start, NULL);
+
+		if (ti_lfa) {
+			monotime(&start);
+			ospf_ti_lfa_compute(area, new_table,
+					    ospf->ti_lfa_protection_type);
+			ti_lfa_usec += monotime_since(&start, NULL);
+		}
+
+		if (i == 0)
+			for (rn = route_top(new_table); rn; rn = route_next(rn))
+				if (rn->info)
+					routes++;
+
+		ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+		area->spf = NULL;
+		area->spf_vertex_list = NULL;
+
+		ospf_route_table_free(new_table);
+		ospf_rtrs_free(new_rtrs);
+		ospf_rtrs_free(all_rtrs);
+	}
+
+	printf("  %lu routes\n", routes);
+	bench_report_usec("spf", iterations, spf_usec);
+	if (ti_lfa)
+		bench_report_usec("ti-lfa", iterations, ti_lfa_usec);
+	printf("\n");
+
+	topology_grid_free(topology);
+
+	/* One route per link and one per router */
+	return routes == 2 * size * (size - 1) + size * size ? 0 : 1;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-g grid size] [-n iterations] [-l]\n",
+		prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	static const unsigned int sizes[] = { 16, 32, 64 };
+	unsigned int size = 0, iterations = 10, i;
+	bool ti_lfa = false;
+	int opt, ret = 0;
+
+	while ((opt = getopt(argc, argv, "g:n:l")) != -1) {
+		switch (opt) {
+		case 'g':
+			size = strtoul(optarg, NULL, 0);
+			if (!size)
+				usage(argv[0]);
+			break;
+		case 'n':
+			iterations = strtoul(optarg, NULL, 0);
+			break;
+		case 'l':
+			ti_lfa = true;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!iterations)
+		usage(argv[0]);
+
+	master = thread_master_create(NULL);
+	cmd_init(1);
+	vty_init(master, false);
+	zlog_aux_init("NONE: ", ZLOG_DISABLED);
+
+	/* needed for SR DB init */
+	ospf_vty_init();
+	ospf_sr_init();
+
+	if (size)
+		ret |= run(size, iterations, ti_lfa);
+	else
+		for (i = 0; i < array_size(sizes); i++)
+			ret |= run(sizes[i], iterations, ti_lfa);
+
+	cmd_terminate();
+	vty_terminate();
+	thread_master_free(master);
+
+	return ret;
+}
@@ -1,5 +1,6 @@
 #include <zebra.h>
 
+#include "memory.h"
 #include "mpls.h"
 #include "if.h"
 
@@ -35,7 +36,7 @@
  */
 struct ospf_topology topo1 = {
 	.nodes =
-		{
+		(struct ospf_test_node[MAX_NODES + 1]){
 			{
 				.hostname = "rt1",
 				.router_id = "1.1.1.1",
@@ -137,7 +138,7 @@ struct ospf_topology topo1 = {
  */
 struct ospf_topology topo2 = {
 	.nodes =
-		{
+		(struct ospf_test_node[MAX_NODES + 1]){
 			{
 				.hostname = "rt1",
 				.router_id = "1.1.1.1",
@@ -239,7 +240,7 @@ struct ospf_topology topo2 = {
  */
 struct ospf_topology topo3 = {
 	.nodes =
-		{
+		(struct ospf_test_node[MAX_NODES + 1]){
 			{
 				.hostname = "rt1",
 				.router_id = "1.1.1.1",
@@ -359,7 +360,7 @@ struct ospf_topology topo3 = {
  */
 struct ospf_topology topo4 = {
 	.nodes =
-		{
+		(struct ospf_test_node[MAX_NODES + 1]){
 			{
 				.hostname = "rt1",
 				.router_id = "1.1.1.1",
@@ -482,7 +483,7 @@ struct ospf_topology topo4 = {
  */
 struct ospf_topology topo5 = {
 	.nodes =
-		{
+		(struct ospf_test_node[MAX_NODES + 1]){
 			{
 				.hostname = "rt1",
 				.router_id = "1.1.1.1",
@@ -573,3 +574,224 @@ struct ospf_topology topo5 = {
 			},
 		},
 };
+
+/*
+ * +---------+                     +---------+
+ * |         |                     |         |
+ * |   RT1   |eth-rt2       eth-rt1|   RT2   |
+ * | 1.1.1.1 +---------------------+ 2.2.2.2 |
+ * |         |     10.0.1.0/24     |         |
+ * +---------+                     +---------+
+ *      |eth-lan2                eth-lan1|
+ *      |                                |
+ *      |10.0.30.0/24 (DR: RT1)          |10.0.20.0/24 (DR: RT3)
+ *      +----------+          +----------+-------------+
+ *                 |          |                        |
+ *         eth-lan2|          |eth-lan1                |eth-lan1
+ *               +---------+                      +---------+
+ *               |         |                      |         |
+ *               |   RT4   |                      |   RT3   |
+ *               | 4.4.4.4 |                      | 3.3.3.3 |
+ *               |         |                      |         |
+ *               +---------+                      +---------+
+ *
+ * Broadcast networks, described by network-LSAs: RT3 is reached over
+ * 10.0.20.0/24 through both RT2 and RT4.
+ */
+struct ospf_topology topo6 = {
+	.nodes =
+		(struct ospf_test_node[MAX_NODES + 1]){
+			{
+				.hostname = "rt1",
+				.router_id = "1.1.1.1",
+				.label = 10,
+				.adjacencies =
+					{
+						{
+							.hostname = "rt2",
+							.network =
+								"10.0.1.1/24",
+							.metric = 10,
+							.label = 1,
+						},
+						{
+							.hostname = "lan2",
+							.network =
+								"10.0.30.1/24",
+							.metric = 10,
+							.label = 2,
+						},
+					},
+			},
+			{
+				.hostname = "rt2",
+				.router_id = "2.2.2.2",
+				.label = 20,
+				.adjacencies =
+					{
+						{
+							.hostname = "rt1",
+							.network =
+								"10.0.1.2/24",
+							.metric = 10,
+							.label = 3,
+						},
+						{
+							.hostname = "lan1",
+							.network =
+								"10.0.20.2/24",
+							.metric = 10,
+							.label = 4,
+						},
+					},
+			},
+			{
+				.hostname = "rt3",
+				.router_id = "3.3.3.3",
+				.label = 30,
+				.adjacencies =
+					{
+						{
+							.hostname = "lan1",
+							.network =
+								"10.0.20.3/24",
+							.metric = 10,
+							.label = 5,
+						},
+					},
+			},
+			{
+				.hostname = "rt4",
+				.router_id = "4.4.4.4",
+				.label = 40,
+				.adjacencies =
+					{
+						{
+							.hostname = "lan1",
+							.network =
+								"10.0.20.4/24",
+							.metric = 10,
+							.label = 6,
+						},
+						{
+							.hostname = "lan2",
+							.network =
+								"10.0.30.4/24",
+							.metric = 10,
+							.label = 7,
+						},
+					},
+			},
+			{
+				.hostname = "lan1",
+				.router_id = "10.0.20.3",
+				.dr = "rt3",
+				.adjacencies =
+					{
+						{
+							.hostname = "rt2",
+						},
+						{
+							.hostname = "rt3",
+						},
+						{
+							.hostname = "rt4",
+						},
+					},
+			},
+			{
+				.hostname = "lan2",
+				.router_id = "10.0.30.1",
+				.dr = "rt1",
+				.adjacencies =
+					{
+						{
+							.hostname = "rt1",
+						},
+						{
+							.hostname = "rt4",
+						},
+					},
+			},
+		},
+};
+
+/*
+ * Generated grid of 'rows' x 'cols' routers, each connected to its
+ * neighbors to the right and below by point-to-point links of metric 10.
+ * Routers are named rt<row>-<col>, with router IDs from 1.0.0.1 on, the
+ * links are numbered /30s from 10.0.0.0 on.  Used for benchmarking.
+ */
+static void grid_link(struct ospf_test_node *a, struct ospf_test_node *b,
+		      uint32_t link)
+{
+	struct ospf_test_adj *adj;
+	struct in_addr addr;
+	int i;
+
+	for (i = 0; a->adjacencies[i].hostname[0]; i++)
+		;
+	adj = &a->adjacencies[i];
+	strlcpy(adj->hostname, b->hostname, sizeof(adj->hostname));
+	addr.s_addr = htonl(0x0a000000 + 4 * link + 1);
+	snprintfrr(adj->network, sizeof(adj->network), "%pI4/30", &addr);
+	adj->metric = 10;
+	adj->label = i + 1;
+
+	for (i = 0; b->adjacencies[i].hostname[0]; i++)
+		;
+	adj = &b->adjacencies[i];
+	strlcpy(adj->hostname, a->hostname, sizeof(adj->hostname));
+	addr.s_addr = htonl(0x0a000000 + 4 * link + 2);
+	snprintfrr(adj->network, sizeof(adj->network), "%pI4/30", &addr);
+	adj->metric = 10;
+	adj->label = i + 1;
+}
+
+struct ospf_topology *topology_grid_new(unsigned int rows, unsigned int cols)
+{
+	struct ospf_topology *topology;
+	struct ospf_test_node *node;
+	char *router_ids;
+	struct in_addr id;
+	unsigned int r, c, n = rows * cols;
+	uint32_t link = 0;
+
+	topology = XCALLOC(MTYPE_TMP, sizeof(*topology));
+	topology->nodes = XCALLOC(MTYPE_TMP, (n + 1) * sizeof(*node));
+	router_ids = XCALLOC(MTYPE_TMP, n * INET_ADDRSTRLEN);
+
+	for (r = 0; r < rows; r++)
+		for (c = 0; c < cols; c++) {
+			node = &topology->nodes[r * cols + c];
+			snprintf(node->hostname, sizeof(node->hostname),
+				 "rt%u-%u", r, c);
+
+			id.s_addr = htonl(0x01000000 + r * cols + c + 1);
+			inet_ntop(AF_INET, &id, router_ids, INET_ADDRSTRLEN);
+			node->router_id = router_ids;
+			router_ids += INET_ADDRSTRLEN;
+			node->label = r * cols + c + 1;
+		}
+
+	for (r = 0; r < rows; r++)
+		for (c = 0; c < cols; c++) {
+			node = &topology->nodes[r * cols + c];
+			if (c + 1 < cols)
+				grid_link(node, node + 1, link++);
+			if (r + 1 < rows)
+				grid_link(node, node + cols, link++);
+		}
+
+	return topology;
+}
+
+void topology_grid_free(struct ospf_topology *topology)
+{
+	/* All router IDs were allocated in one go, with the first one */
+	void *router_ids = (void *)topology->nodes[0].router_id;
+
+	XFREE(MTYPE_TMP, router_ids);
+	XFREE(MTYPE_TMP, topology->nodes);
+	XFREE(MTYPE_TMP, topology);
+}
@@ -13,7 +13,9 @@ Test is indended for validating zebra NH resolution logic
 
 import os
 import sys
+import json
 import pytest
+from functools import partial
 
 from lib.common_config import (
     start_topology,
@@ -148,6 +150,74 @@ def test_verify_zebra_nh_resolution(request):
     "Error: Nexthop became unresolved".format(
         tc_name, result)
 
+def _nht_statistics(router, trigger):
+    output = json.loads(router.vtysh_cmd("show ip nht json"))
+    return output["default"]["statistics"][trigger]
+
+
+def _nht_statistics_grew(router, trigger, before, fields):
+    after = _nht_statistics(router, trigger)
+    for field in fields:
+        if after[field] <= before[field]:
+            return "{} {}: {} -> {}".format(
+                trigger, field, before[field], after[field]
+            )
+    return None
+
+
+def _check_nht_statistics(router, trigger, before, fields):
+    test_func = partial(_nht_statistics_grew, router, trigger, before, fields)
+    _, result = topotest.run_and_expect(test_func, None, count=20, wait=1)
+    return result
+
+
+def test_verify_zebra_nht_statistics(request):
+    tgen = get_topogen()
+    tc_name = request.node.name
+    if tgen.routers_have_failure():
+        pytest.skip(tgen.errors)
+    r1 = tgen.gears["r1"]
+
+    step("Add a more specific route covering NH 2.2.2.32")
+    before = _nht_statistics(r1, "route")
+    input_dict = {
+        "r1": {"static_routes": [{"network": "2.2.2.0/25", "next_hop": "r1-eth0"}]}
+    }
+    result = create_static_routes(tgen, input_dict)
+    assert result is True, "Testcase {} : Failed \n Error: {}".format(
+        tc_name, result
+    )
+
+    step("Verify that the route change re-evaluated and notified NH 2.2.2.32")
+    result = _check_nht_statistics(
+        r1, "route", before, ["runs", "evaluated", "notified"]
+    )
+    assert result is None, "Testcase {} : Failed \n Error: {}".format(
+        tc_name, result
+    )
+
+    step("Add a default route and watch NH 3.3.3.3, which stays unresolved")
+    input_dict = {
+        "r1": {"static_routes": [{"network": "0.0.0.0/0", "next_hop": "r1-eth0"}]}
+    }
+    result = create_static_routes(tgen, input_dict)
+    assert result is True, "Testcase {} : Failed \n Error: {}".format(
+        tc_name, result
+    )
+    r1.vtysh_cmd("sharp watch nexthop 3.3.3.3")
+
+    step("Verify that resolve-via-default re-evaluates NH 3.3.3.3")
+    before = _nht_statistics(r1, "resolve-via-default")
+    r1.vtysh_cmd("configure terminal\nip nht resolve-via-default")
+    result = _check_nht_statistics(
+        r1, "resolve-via-default", before, ["runs", "evaluated", "notified"]
+    )
+    r1.vtysh_cmd("configure terminal\nno ip nht resolve-via-default")
+    assert result is None, "Testcase {} : Failed \n Error: {}".format(
+        tc_name, result
+    )
+
+
 if __name__ == "__main__":
     args = ["-s"] + sys.argv[1:]
     sys.exit(pytest.main(args))
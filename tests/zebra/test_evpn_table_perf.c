@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * EVPN MAC/neighbor table benchmark.
+ *
+ * Fills the per-VNI MAC and neighbor tables the way zebra_evpn_mac_add()
+ * and zebra_evpn_neigh_add() do, then looks entries up, walks and deletes
+ * them.  Each table type runs against the typesafe hash zebra keeps these
+ * entries in, and against lib/hash, which is what they used to live in
+ * (and what the L3VNI RMAC and next-hop tables still use).
+ *
+ * Prints ops/s for each phase, and the memory taken by the table indexes
+ * on top of the entries themselves.
+ */
+
+#include <zebra.h>
+
+#include "memory.h"
+#include "hash.h"
+#include "jhash.h"
+#include "ipaddr.h"
+
+#include "zebra/debug.h"
+#include "zebra/zebra_vxlan.h"
+#include "zebra/zebra_vxlan_if.h"
+#include "zebra/zebra_evpn.h"
+#include "zebra/zebra_evpn_mac.h"
+#include "zebra/zebra_evpn_neigh.h"
+
+#include "bench.h"
+
+DEFINE_MGROUP(TEST_EVPNPERF, "EVPN table benchmark");
+DEFINE_MTYPE_STATIC(TEST_EVPNPERF, EVPNPERF, "EVPN table entry");
+
+enum table_kind {
+	TABLE_HASH,
+	TABLE_TYPESAFE,
+};
+
+static const char *const kind_names[] = {
+	[TABLE_HASH] = "lib/hash",
+	[TABLE_TYPESAFE] = "typesafe",
+};
+
+struct bench {
+	unsigned int nvni;
+	unsigned int per_vni;
+
+	/* One of these per VNI, depending on the kind */
+	struct hash **hashes;
+	struct zebra_mac_db_head *macs;
+	struct zebra_neigh_db_head *neighs;
+
+	/* Entries, in insertion order, VNIs interleaved */
+	void **entries;
+};
+
+static unsigned int mac_hash_keymake(const void *p)
+{
+	return zebra_mac_db_hash(p);
+}
+
+static bool mac_cmp(const void *p1, const void *p2)
+{
+	return zebra_mac_db_cmp(p1, p2) == 0;
+}
+
+static unsigned int neigh_hash_keymake(const void *p)
+{
+	return zebra_neigh_db_hash(p);
+}
+
+static bool neigh_cmp(const void *p1, const void *p2)
+{
+	return zebra_neigh_db_cmp(p1, p2) == 0;
+}
+
+/* MAC 'i' of the VNI, spread the way a fabric hands out addresses */
+static void mac_key(struct ethaddr *mac, unsigned int vni, unsigned int i)
+{
+	mac->octet[0] = 0x02;
+	mac->octet[1] = vni & 0xff;
+	mac->octet[2] = (i >> 24) & 0xff;
+	mac->octet[3] = (i >> 16) & 0xff;
+	mac->octet[4] = (i >> 8) & 0xff;
+	mac->octet[5] = i & 0xff;
+}
+
+/* Every other neighbor is IPv6, as with dual stack hosts */
+static void neigh_key(struct ipaddr *ip, unsigned int vni, unsigned int i)
+{
+	memset(ip, 0, sizeof(*ip));
+	if (i & 1) {
+		ip->ipa_type = IPADDR_V6;
+		ip->ipaddr_v6.s6_addr32[0] = htonl(0x20010db8);
+		ip->ipaddr_v6.s6_addr32[1] = htonl(vni);
+		ip->ipaddr_v6.s6_addr32[3] = htonl(i);
+	} else {
+		ip->ipa_type = IPADDR_V4;
+		ip->ipaddr_v4.s_addr = htonl(0x0a000000 | (i & 0xffffff));
+	}
+}
+
+static void *entry_new(bool neigh, unsigned int vni, unsigned int i)
+{
+	struct zebra_mac *mac;
+	struct zebra_neigh *n;
+
+	if (neigh) {
+		n = XCALLOC(MTYPE_EVPNPERF, sizeof(*n));
+		neigh_key(&n->ip, vni, i);
+		return n;
+	}
+
+	mac = XCALLOC(MTYPE_EVPNPERF, sizeof(*mac));
+	mac_key(&mac->macaddr, vni, i);
+	return mac;
+}
+
+static void table_init(struct bench *b, enum table_kind kind, bool neigh)
+{
+	unsigned int v;
+
+	for (v = 0; v < b->nvni; v++) {
+		if (kind == TABLE_HASH && neigh)
+			b->hashes[v] = hash_create_size(8, neigh_hash_keymake,
+							neigh_cmp, NULL);
+		else if (kind == TABLE_HASH)
+			b->hashes[v] = hash_create_size(8, mac_hash_keymake,
+							mac_cmp, NULL);
+		else if (neigh)
+			zebra_neigh_db_init(&b->neighs[v]);
+		else
+			zebra_mac_db_init(&b->macs[v]);
+	}
+}
+
+static void table_fini(struct bench *b, enum table_kind kind, bool neigh)
+{
+	unsigned int v;
+
+	for (v = 0; v < b->nvni; v++) {
+		if (kind == TABLE_HASH)
+			hash_free(b->hashes[v]);
+		else if (neigh)
+			zebra_neigh_db_fini(&b->neighs[v]);
+		else
+			zebra_mac_db_fini(&b->macs[v]);
+	}
+}
+
+static void table_add(struct bench *b, enum table_kind kind, bool neigh,
+		      unsigned int v, void *entry)
+{
+	if (kind == TABLE_HASH)
+		hash_get(b->hashes[v], entry, hash_alloc_intern);
+	else if (neigh)
+		zebra_neigh_db_add(&b->neighs[v], entry);
+	else
+		zebra_mac_db_add(&b->macs[v], entry);
+}
+
+static void *table_find(struct bench *b, enum table_kind kind, bool neigh,
+			unsigned int v, void *key)
+{
+	if (kind == TABLE_HASH)
+		return hash_lookup(b->hashes[v], key);
+	if (neigh)
+		return zebra_neigh_db_find(&b->neighs[v], key);
+	return zebra_mac_db_find(&b->macs[v], key);
+}
+
+static void table_del(struct bench *b, enum table_kind kind, bool neigh,
+		      unsigned int v, void *entry)
+{
+	if (kind == TABLE_HASH)
+		hash_release(b->hashes[v], entry);
+	else if (neigh)
+		zebra_neigh_db_del(&b->neighs[v], entry);
+	else
+		zebra_mac_db_del(&b->macs[v], entry);
+}
+
+static void walk_count(struct hash_bucket *bucket, void *arg)
+{
+	(*(size_t *)arg)++;
+}
+
+static size_t table_walk(struct bench *b, enum table_kind kind, bool neigh,
+			 unsigned int v)
+{
+	struct zebra_mac *mac;
+	struct zebra_neigh *n;
+	size_t count = 0;
+
+	if (kind == TABLE_HASH)
+		hash_iterate(b->hashes[v], walk_count, &count);
+	else if (neigh)
+		frr_each (zebra_neigh_db, &b->neighs[v], n)
+			count++;
+	else
+		frr_each (zebra_mac_db, &b->macs[v], mac)
+			count++;
+	return count;
+}
+
+/* Bytes taken by the table itself, not counting the entries */
+static size_t table_bytes(struct bench *b, enum table_kind kind, bool neigh)
+{
+	size_t bytes = 0;
+	unsigned int v;
+
+	for (v = 0; v < b->nvni; v++) {
+		if (kind == TABLE_HASH)
+			bytes += b->hashes[v]->size * sizeof(void *)
+				 + b->hashes[v]->count
+					   * sizeof(struct hash_bucket);
+		else if (neigh)
+			bytes += HASH_SIZE(b->neighs[v].hh) * sizeof(void *);
+		else
+			bytes += HASH_SIZE(b->macs[v].hh) * sizeof(void *);
+	}
+	return bytes;
+}
+
+static int run(struct bench *b, enum table_kind kind, bool neigh)
+{
+	uint64_t total = (uint64_t)b->nvni * b->per_vni, i, found = 0;
+	size_t heap, index, walked = 0;
+	struct timeval start;
+	unsigned int v;
+	union {
+		struct zebra_mac mac;
+		struct zebra_neigh n;
+	} key;
+
+	printf("%s %s tables, %u VNIs x %u entries:\n",
+	       neigh ? "neighbor" : "MAC", kind_names[kind], b->nvni,
+	       b->per_vni);
+
+	/* Entries are allocated up front so that only the table is measured */
+	for (i = 0; i < total; i++)
+		b->entries[i] = entry_new(neigh, i % b->nvni, i / b->nvni);
+
+	heap = bench_heap_used();
+	table_init(b, kind, neigh);
+
+	monotime(&start);
+	for (i = 0; i < total; i++)
+		table_add(b, kind, neigh, i % b->nvni, b->entries[i]);
+	bench_report("add", total, &start);
+
+	index = table_bytes(b, kind, neigh);
+	heap = bench_heap_used() - heap;
+
+	monotime(&start);
+	for (i = 0; i < total; i++) {
+		v = (i * 7) % b->nvni;
+		memset(&key, 0, sizeof(key));
+		if (neigh)
+			neigh_key(&key.n.ip, v, i % b->per_vni);
+		else
+			mac_key(&key.mac.macaddr, v, i % b->per_vni);
+		if (table_find(b, kind, neigh, v, &key))
+			found++;
+	}
+	bench_report("lookup", total, &start);
+
+	monotime(&start);
+	for (i = 0; i < total; i++) {
+		v = i % b->nvni;
+		memset(&key, 0, sizeof(key));
+		if (neigh)
+			neigh_key(&key.n.ip, v, b->per_vni + i);
+		else
+			mac_key(&key.mac.macaddr, v, b->per_vni + i);
+		if (table_find(b, kind, neigh, v, &key))
+			found++;
+	}
+	bench_report("miss", total, &start);
+
+	monotime(&start);
+	for (v = 0; v < b->nvni; v++)
+		walked += table_walk(b, kind, neigh, v);
+	bench_report("walk", walked, &start);
+
+	monotime(&start);
+	for (i = 0; i < total; i++)
+		table_del(b, kind, neigh, i % b->nvni, b->entries[i]);
+	bench_report("delete", total, &start);
+
+	printf("  table memory %zu bytes, %.1f bytes/entry", index,
+	       (double)index / total);
+	if (heap)
+		printf(" (heap %.1f bytes/entry)", (double)heap / total);
+	printf("\n\n");
+
+	table_fini(b, kind, neigh);
+	for (i = 0; i < total; i++)
+		XFREE(MTYPE_EVPNPERF, b->entries[i]);
+
+	return (found == total && walked == total) ? 0 : 1;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-v vnis] [-n entries per vni]\n", prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct bench b = { .nvni = 64, .per_vni = 4096 };
+	int opt, ret = 0;
+
+	while ((opt = getopt(argc, argv, "v:n:")) != -1) {
+		switch (opt) {
+		case 'v':
+			b.nvni = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			b.per_vni = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+	if (!b.nvni || !b.per_vni)
+		usage(argv[0]);
+
+	b.hashes = XCALLOC(MTYPE_EVPNPERF, b.nvni * sizeof(*b.hashes));
+	b.macs = XCALLOC(MTYPE_EVPNPERF, b.nvni * sizeof(*b.macs));
+	b.neighs = XCALLOC(MTYPE_EVPNPERF, b.nvni * sizeof(*b.neighs));
+	b.entries = XCALLOC(MTYPE_EVPNPERF, (size_t)b.nvni * b.per_vni
+						    * sizeof(*b.entries));
+
+	ret |= run(&b, TABLE_HASH, false);
+	ret |= run(&b, TABLE_TYPESAFE, false);
+	ret |= run(&b, TABLE_HASH, true);
+	ret |= run(&b, TABLE_TYPESAFE, true);
+
+	XFREE(MTYPE_EVPNPERF, b.entries);
+	XFREE(MTYPE_EVPNPERF, b.neighs);
+	XFREE(MTYPE_EVPNPERF, b.macs);
+	XFREE(MTYPE_EVPNPERF, b.hashes);
+
+	return ret;
+}
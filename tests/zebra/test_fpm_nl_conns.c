@@ -0,0 +1,569 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * FPM connections tests.
+ *
+ * Runs next hop groups and the routes using them through the netlink FPM
+ * provider with several connections to the server, and checks what each
+ * connection has to send: the routes are spread among all of them, while
+ * every connection gets every group, before its routes using it, and the
+ * routes leaving a group before the group delete.
+ */
+
+#include <zebra.h>
+
+#include "lib/module.h"
+
+/* The provider is built into the test, not loaded as a module */
+#undef FRR_MODULE_SETUP
+#define FRR_MODULE_SETUP(...) FRR_COREMOD_SETUP(__VA_ARGS__)
+
+/* Contexts are handed to fpm_nl_process() by the test, not by the dplane */
+#define dplane_provider_get_data test_provider_get_data
+#define dplane_provider_get_work_limit test_provider_get_work_limit
+#define dplane_provider_dequeue_in_ctx test_provider_dequeue_in_ctx
+#define dplane_provider_enqueue_out_ctx test_provider_enqueue_out_ctx
+#define dplane_provider_out_ctx_queue_len test_provider_out_ctx_queue_len
+#define dplane_provider_work_ready test_provider_work_ready
+
+#include "zebra/dplane_fpm_nl.c"
+
+#include "zebra/zebra_nhg.h"
+#include "zebra/zebra_ns.h"
+
+#define CONNS  4
+#define NHGS   8
+#define ROUTES 256
+
+/* The next hop group of route 'i', which is also carried in its metric */
+#define ROUTE_NHG(i) ((i) % NHGS + 1)
+
+static struct fpm_nl_ctx *fnc;
+static struct dplane_ctx_list_head in_q;
+static unsigned int contexts_in, contexts_out;
+
+/* shim out unused functions/variables to allow dplane_fpm_nl to link */
+DEFINE_MGROUP(ZEBRA, "zebra");
+struct zebra_router zrouter;
+unsigned long zebra_debug_fpm;
+unsigned long zebra_debug_dplane;
+unsigned long zebra_debug_dplane_detail;
+unsigned long zebra_debug_vxlan;
+unsigned long zebra_debug_evpn_mh;
+
+static struct zebra_ns zns;
+
+struct zebra_ns *zebra_ns_lookup(ns_id_t ns_id)
+{
+	return &zns;
+}
+
+bool zebra_nhg_depends_is_empty(const struct nhg_hash_entry *nhe)
+{
+	return true;
+}
+
+/* Not reached with the contexts used here */
+struct route_table *rib_tables_iter_next(rib_tables_iter_t *iter)
+{
+	return NULL;
+}
+
+int rib_add_multipath(afi_t afi, safi_t safi, struct prefix *p,
+		      struct prefix_ipv6 *src_p, struct route_entry *re,
+		      struct nexthop_group *ng, bool startup)
+{
+	return 0;
+}
+
+struct nhg_hash_entry *zebra_nhg_resolve(struct nhg_hash_entry *nhe)
+{
+	return nhe;
+}
+
+uint8_t zebra_nhg_nhe2grp(struct nh_grp *grp, struct nhg_hash_entry *nhe,
+			  int size)
+{
+	return 0;
+}
+
+bool zebra_nhg_kernel_nexthops_enabled(void)
+{
+	return false;
+}
+
+struct interface *if_lookup_by_index_per_ns(struct zebra_ns *ns, uint32_t idx)
+{
+	return NULL;
+}
+
+struct zebra_l3vni *zl3vni_from_vrf(vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+struct zebra_vxlan_vni *zebra_vxlan_if_vni_find(const struct zebra_if *zif,
+						vni_t vni)
+{
+	return NULL;
+}
+
+struct zebra_vrf *zebra_vrf_lookup_by_id(vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+struct route_table *zebra_vrf_table(afi_t afi, safi_t safi, vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+uint32_t zebra_router_get_next_sequence(void)
+{
+	return 0;
+}
+
+void zebra_finalize(struct thread *event)
+{
+	exit(0);
+}
+
+int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
+					       ns_id_t ns_id, int startup,
+					       struct zebra_dplane_ctx *ctx)
+{
+	return 0;
+}
+
+ssize_t netlink_macfdb_update_ctx(struct zebra_dplane_ctx *ctx, void *data,
+				  size_t datalen)
+{
+	return 0;
+}
+
+ssize_t netlink_lsp_msg_encoder(struct zebra_dplane_ctx *ctx, void *buf,
+				size_t buflen)
+{
+	return 0;
+}
+
+int netlink_request_netconf(int sockfd)
+{
+	return 0;
+}
+
+void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
+{
+}
+
+int kernel_dplane_read(struct zebra_dplane_info *info)
+{
+	return 0;
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_nhlfe(
+	struct zebra_lsp *lsp, enum lsp_types_t lsp_type,
+	enum nexthop_types_t gtype, const union g_addr *gate,
+	ifindex_t ifindex, uint8_t num_labels, const mpls_label_t *out_labels)
+{
+	return NULL;
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_backup_nhlfe(
+	struct zebra_lsp *lsp, enum lsp_types_t lsp_type,
+	enum nexthop_types_t gtype, const union g_addr *gate,
+	ifindex_t ifindex, uint8_t num_labels, const mpls_label_t *out_labels)
+{
+	return NULL;
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_nh(struct zebra_lsp *lsp,
+					  enum lsp_types_t lsp_type,
+					  const struct nexthop *nh)
+{
+	return NULL;
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_backup_nh(struct zebra_lsp *lsp,
+						 enum lsp_types_t lsp_type,
+						 const struct nexthop *nh)
+{
+	return NULL;
+}
+
+void zebra_mpls_nhlfe_free(struct zebra_nhlfe *nhlfe)
+{
+}
+
+void zebra_pbr_process_iptable(struct zebra_dplane_ctx *ctx)
+{
+}
+
+void zebra_pbr_process_ipset(struct zebra_dplane_ctx *ctx)
+{
+}
+
+void zebra_pbr_process_ipset_entry(struct zebra_dplane_ctx *ctx)
+{
+}
+
+const char *zebra_pbr_ipset_type2str(uint32_t type)
+{
+	return "";
+}
+
+const char *tc_filter_kind2str(uint32_t type)
+{
+	return "";
+}
+
+const char *tc_qdisc_kind2str(uint32_t type)
+{
+	return "";
+}
+
+void *test_provider_get_data(const struct zebra_dplane_provider *prov)
+{
+	return fnc;
+}
+
+int test_provider_get_work_limit(const struct zebra_dplane_provider *prov)
+{
+	return INT_MAX;
+}
+
+struct zebra_dplane_ctx *
+test_provider_dequeue_in_ctx(struct zebra_dplane_provider *prov)
+{
+	return dplane_ctx_dequeue(&in_q);
+}
+
+void test_provider_enqueue_out_ctx(struct zebra_dplane_provider *prov,
+				   struct zebra_dplane_ctx *ctx)
+{
+	contexts_out++;
+	dplane_ctx_fini(&ctx);
+}
+
+uint32_t test_provider_out_ctx_queue_len(struct zebra_dplane_provider *prov)
+{
+	return 0;
+}
+
+int test_provider_work_ready(void)
+{
+	return 0;
+}
+
+/*
+ * What the test encoders below write for each context: the message type,
+ * the group and, for routes, the destination.
+ */
+struct test_msg {
+	struct nlmsghdr n;
+	uint32_t nhg_id;
+	struct in_addr dst;
+};
+
+static ssize_t test_msg_encode(uint16_t type, uint32_t nhg_id,
+			       const struct prefix *p, void *data,
+			       size_t datalen)
+{
+	struct test_msg *msg = data;
+
+	if (datalen < sizeof(*msg))
+		return 0;
+
+	memset(msg, 0, sizeof(*msg));
+	msg->n.nlmsg_len = sizeof(*msg);
+	msg->n.nlmsg_type = type;
+	msg->nhg_id = nhg_id;
+	if (p)
+		msg->dst = p->u.prefix4;
+
+	return sizeof(*msg);
+}
+
+ssize_t netlink_route_multipath_msg_encode(int cmd,
+					   struct zebra_dplane_ctx *ctx,
+					   uint8_t *data, size_t datalen,
+					   bool fpm, bool force_nhg)
+{
+	return test_msg_encode(cmd, dplane_ctx_get_metric(ctx),
+			       dplane_ctx_get_dest(ctx), data, datalen);
+}
+
+ssize_t netlink_nexthop_msg_encode(uint16_t cmd,
+				   const struct zebra_dplane_ctx *ctx,
+				   void *buf, size_t buflen, bool fpm)
+{
+	return test_msg_encode(cmd, dplane_ctx_get_nhe_id(ctx), NULL, buf,
+			       buflen);
+}
+
+static struct zebra_dplane_ctx *nhg_ctx(enum dplane_op_e op, uint32_t id)
+{
+	struct zebra_dplane_ctx *ctx = dplane_ctx_alloc();
+	struct nhg_hash_entry nhe = {};
+
+	nhe.id = id;
+	nhe.afi = AFI_IP;
+	nhe.vrf_id = VRF_DEFAULT;
+	nhe.type = ZEBRA_ROUTE_BGP;
+	dplane_ctx_nexthop_init(ctx, op, &nhe);
+
+	return ctx;
+}
+
+static struct zebra_dplane_ctx *route_ctx(enum dplane_op_e op, unsigned int i,
+					  uint32_t nhg_id)
+{
+	struct zebra_dplane_ctx *ctx = dplane_ctx_alloc();
+	struct prefix p = { .family = AF_INET, .prefixlen = 16 };
+	struct route_entry re = {};
+
+	p.u.prefix4.s_addr = htonl(0x0a000000 | (i << 16));
+	re.type = ZEBRA_ROUTE_BGP;
+	re.vrf_id = VRF_DEFAULT;
+	re.metric = nhg_id;
+	dplane_ctx_route_init_basic(ctx, op, &re, &p, NULL, AFI_IP,
+				    SAFI_UNICAST);
+
+	return ctx;
+}
+
+static void queue(struct zebra_dplane_ctx *ctx)
+{
+	contexts_in++;
+	dplane_ctx_enqueue_tail(&in_q, ctx);
+}
+
+/*
+ * Connections are set up as by fpm_nl_start() and fpm_conn_start(), but with
+ * pthreads that don't run: the test takes over their work.
+ */
+static void conns_init(void)
+{
+	struct fpm_nl_conn *conn;
+	char name[64];
+	unsigned int i;
+
+	fnc = calloc(1, sizeof(*fnc));
+	fnc->fthread = frr_pthread_new(NULL, prov_name, prov_name);
+	fnc->use_nhg = true;
+	fnc->conf_connections = CONNS;
+	fnc->connections = CONNS;
+
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		conn->fnc = fnc;
+		conn->idx = i;
+		conn->socket = -1;
+		conn->batch = FPM_BATCH_DEFAULT;
+		pthread_mutex_init(&conn->obuf_mutex, NULL);
+		dplane_ctx_q_init(&conn->ctxqueue);
+		dplane_ctx_q_init(&conn->pending);
+		pthread_mutex_init(&conn->ctxqueue_mutex, NULL);
+		if (i >= CONNS)
+			continue;
+
+		snprintf(name, sizeof(name), "conn %u", i);
+		conn->ibuf = stream_new(NL_PKT_BUF_SIZE);
+		conn->obuf = stream_new(NL_PKT_BUF_SIZE * 128);
+		conn->fthread = frr_pthread_new(NULL, name, name);
+		conn->socket = open("/dev/null", O_WRONLY);
+		assert(conn->socket >= 0);
+	}
+}
+
+static void conns_fini(void)
+{
+	struct fpm_nl_conn *conn;
+	unsigned int i;
+
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		if (conn->fthread) {
+			close(conn->socket);
+			stream_free(conn->ibuf);
+			stream_free(conn->obuf);
+		}
+
+		pthread_mutex_destroy(&conn->obuf_mutex);
+		pthread_mutex_destroy(&conn->ctxqueue_mutex);
+	}
+
+	frr_pthread_finish();
+	free(fnc);
+}
+
+/* Runs a connection queue the way its pthread does */
+static void conn_drain(struct fpm_nl_conn *conn)
+{
+	struct thread t = { .arg = conn };
+
+	while (atomic_load_explicit(&conn->counters.ctxqueue_len,
+				    memory_order_relaxed)
+	       > 0)
+		fpm_process_queue(&t);
+}
+
+struct conn_result {
+	unsigned int routes;
+	unsigned int groups;
+	unsigned int deletes;
+	bool ordered;
+};
+
+static void conn_check_msg(const struct test_msg *msg, bool *nhg_up,
+			   uint32_t *route_nhg, struct conn_result *res)
+{
+	unsigned int i, route = (ntohl(msg->dst.s_addr) >> 16) & 0xff;
+
+	switch (msg->n.nlmsg_type) {
+	case RTM_NEWNEXTHOP:
+		nhg_up[msg->nhg_id] = true;
+		res->groups++;
+		break;
+	case RTM_DELNEXTHOP:
+		for (i = 0; i < ROUTES; i++)
+			if (route_nhg[i] == msg->nhg_id)
+				res->ordered = false;
+		nhg_up[msg->nhg_id] = false;
+		res->deletes++;
+		break;
+	case RTM_NEWROUTE:
+		if (!nhg_up[msg->nhg_id])
+			res->ordered = false;
+		route_nhg[route] = msg->nhg_id;
+		res->routes++;
+		break;
+	case RTM_DELROUTE:
+		route_nhg[route] = 0;
+		break;
+	}
+}
+
+/*
+ * Goes through what a connection has to send, checking that each route uses
+ * a group sent before it, and that no route still uses a deleted group.
+ */
+static void conn_check(struct fpm_nl_conn *conn, struct conn_result *res)
+{
+	struct stream *s = conn->obuf;
+	struct test_msg msg;
+	bool nhg_up[NHGS + 1] = {};
+	uint32_t route_nhg[ROUTES] = {};
+	uint16_t len;
+
+	memset(res, 0, sizeof(*res));
+	res->ordered = true;
+
+	while (STREAM_READABLE(s) >= FPM_HEADER_SIZE) {
+		stream_forward_getp(s, 2);
+		len = stream_getw(s) - FPM_HEADER_SIZE;
+
+		/* Route updates are a delete and an install in one message */
+		for (; len >= sizeof(msg); len -= sizeof(msg)) {
+			stream_get(&msg, s, sizeof(msg));
+			conn_check_msg(&msg, nhg_up, route_nhg, res);
+		}
+		assert(len == 0);
+	}
+}
+
+/*
+ * Installs the groups and the routes, moves the routes of the last group to
+ * the first one and deletes it.
+ */
+static int test_process(void)
+{
+	struct conn_result res[CONNS];
+	unsigned int i, routes = 0, moved = 0;
+	bool spread = true, groups = true, ordered = true, contexts;
+
+	for (i = 1; i <= NHGS; i++)
+		queue(nhg_ctx(DPLANE_OP_NH_INSTALL, i));
+	for (i = 0; i < ROUTES; i++)
+		queue(route_ctx(DPLANE_OP_ROUTE_INSTALL, i, ROUTE_NHG(i)));
+	for (i = 0; i < ROUTES; i++) {
+		if (ROUTE_NHG(i) != NHGS)
+			continue;
+
+		queue(route_ctx(DPLANE_OP_ROUTE_UPDATE, i, 1));
+		moved++;
+	}
+	queue(nhg_ctx(DPLANE_OP_NH_DELETE, NHGS));
+
+	fpm_nl_process(NULL);
+
+	for (i = 0; i < CONNS; i++) {
+		conn_drain(&fnc->conns[i]);
+		conn_check(&fnc->conns[i], &res[i]);
+
+		if (res[i].routes == 0)
+			spread = false;
+		if (res[i].groups != NHGS || res[i].deletes != 1)
+			groups = false;
+		if (!res[i].ordered)
+			ordered = false;
+		routes += res[i].routes;
+	}
+
+	if (routes != ROUTES + moved)
+		spread = false;
+	contexts = (contexts_out == contexts_in);
+
+	printf("spread: %s (%u route messages on %u connections)\n",
+	       spread ? "OK" : "failed", routes, CONNS);
+	printf("groups: %s\n", groups ? "OK" : "failed");
+	printf("ordered: %s\n", ordered ? "OK" : "failed");
+	printf("contexts: %s (%u of %u given back)\n",
+	       contexts ? "OK" : "failed", contexts_out, contexts_in);
+
+	return !spread + !groups + !ordered + !contexts;
+}
+
+/* The walk after a (re)connection sends the groups on all connections too */
+static int test_walk(void)
+{
+	struct zebra_dplane_ctx *ctx;
+	struct conn_result res;
+	unsigned int i, groups = 0, routes = 0;
+	bool ok;
+
+	for (i = 0; i < CONNS; i++)
+		stream_reset(fnc->conns[i].obuf);
+
+	ctx = nhg_ctx(DPLANE_OP_NH_INSTALL, 1);
+	assert(fpm_nl_walk_enqueue(fnc, ctx) == 0);
+	dplane_ctx_fini(&ctx);
+	ctx = route_ctx(DPLANE_OP_ROUTE_INSTALL, 0, 1);
+	assert(fpm_nl_walk_enqueue(fnc, ctx) == 0);
+	dplane_ctx_fini(&ctx);
+
+	for (i = 0; i < CONNS; i++) {
+		conn_check(&fnc->conns[i], &res);
+		groups += res.groups;
+		routes += res.routes;
+	}
+
+	ok = (groups == CONNS && routes == 1);
+	printf("walk: %s\n", ok ? "OK" : "failed");
+
+	return !ok;
+}
+
+int main(int argc, char **argv)
+{
+	int fail = 0;
+
+	frr_pthread_init();
+	dplane_ctx_q_init(&in_q);
+	conns_init();
+
+	fail += test_process();
+	fail += test_walk();
+
+	conns_fini();
+	return fail;
+}
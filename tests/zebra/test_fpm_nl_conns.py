@@ -0,0 +1,12 @@
+import frrtest
+
+
+class TestFpmNlConns(frrtest.TestMultiOut):
+    program = "./test_fpm_nl_conns"
+
+
+TestFpmNlConns.okfail("spread")
+TestFpmNlConns.okfail("groups")
+TestFpmNlConns.okfail("ordered")
+TestFpmNlConns.okfail("contexts")
+TestFpmNlConns.okfail("walk")
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Netlink route decoding test.
+ *
+ * Replays a captured netlink route dump (hex, one message per line, on
+ * stdin) through the decoder zebra uses for kernel routes, and prints what
+ * was decoded.
+ */
+
+#include <zebra.h>
+
+#include "printfrr.h"
+#include "nexthop.h"
+
+#include "zebra/rt_netlink_decode.h"
+
+static union {
+	struct nlmsghdr h;
+	uint8_t buf[8192];
+} msg;
+
+static unsigned int decoded, ignored, broken;
+
+static size_t hex_to_msg(const char *line)
+{
+	size_t len = 0;
+	unsigned int byte;
+
+	while (isxdigit((unsigned char)line[0])
+	       && isxdigit((unsigned char)line[1])
+	       && len < sizeof(msg.buf)) {
+		sscanf(line, "%2x", &byte);
+		msg.buf[len++] = byte;
+		line += 2;
+	}
+
+	return len;
+}
+
+static void print_nexthop(const struct nl_route *route,
+			  const struct nexthop *nh)
+{
+	int i;
+
+	switch (nh->type) {
+	case NEXTHOP_TYPE_IFINDEX:
+		printf("    directly connected");
+		break;
+	case NEXTHOP_TYPE_IPV4:
+	case NEXTHOP_TYPE_IPV4_IFINDEX:
+		printfrr("    via %pI4", &nh->gate.ipv4);
+		break;
+	case NEXTHOP_TYPE_IPV6:
+	case NEXTHOP_TYPE_IPV6_IFINDEX:
+		printfrr("    via %pI6", &nh->gate.ipv6);
+		break;
+	case NEXTHOP_TYPE_BLACKHOLE:
+		printf("    blackhole %d", nh->bh_type);
+		break;
+	}
+
+	if (nh->ifindex)
+		printf(" ifindex %d", nh->ifindex);
+	if (route->family == AF_INET && nh->src.ipv4.s_addr)
+		printfrr(" src %pI4", &nh->src.ipv4);
+	if (nh->weight)
+		printf(" weight %u", nh->weight);
+	if (CHECK_FLAG(nh->flags, NEXTHOP_FLAG_ONLINK))
+		printf(" onlink");
+	if (CHECK_FLAG(nh->flags, NEXTHOP_FLAG_LINKDOWN))
+		printf(" linkdown");
+	if (nh->nh_label) {
+		printf(" label");
+		for (i = 0; i < nh->nh_label->num_labels; i++)
+			printf("%c%u", i ? '/' : ' ', nh->nh_label->label[i]);
+	}
+	printf("\n");
+}
+
+static void replay(size_t len)
+{
+	struct nexthop nhs[NL_ROUTE_NEXTHOP_MAX];
+	struct nl_route route = { .nh = nhs, .nh_max = array_size(nhs) };
+	struct rtmsg *rtm = NLMSG_DATA(&msg.h);
+	unsigned int i;
+	int ret;
+
+	if (len < NLMSG_LENGTH(sizeof(struct rtmsg)) || msg.h.nlmsg_len > len) {
+		printf("short message, %zu bytes\n", len);
+		broken++;
+		return;
+	}
+
+	ret = netlink_route_decode(&msg.h, &route);
+	if (ret < 0) {
+		printf("broken message\n");
+		broken++;
+		return;
+	}
+	if (ret == 0) {
+		printf("%s ignored: type %u protocol %u family %u table %u\n",
+		       msg.h.nlmsg_type == RTM_NEWROUTE ? "add" : "delete",
+		       rtm->rtm_type, rtm->rtm_protocol, rtm->rtm_family,
+		       rtm->rtm_table);
+		ignored++;
+		return;
+	}
+
+	decoded++;
+	printfrr("%s %pFX", route.msg_type == RTM_NEWROUTE ? "add" : "delete",
+		 &route.p);
+	if (route.src_p.prefixlen)
+		printfrr(" from %pFX", &route.src_p);
+	printf(" table %u protocol %u metric %u", route.table, route.protocol,
+	       route.metric);
+	if (route.mtu)
+		printf(" mtu %u", route.mtu);
+	if (route.nhe_id)
+		printf(" nhid %u", route.nhe_id);
+	if (route.multipath)
+		printf(" multipath");
+	printf(", %u nexthops\n", route.nh_num);
+
+	for (i = 0; i < route.nh_num; i++)
+		print_nexthop(&route, &route.nh[i]);
+
+	netlink_route_free(&route);
+}
+
+int main(int argc, char **argv)
+{
+	char line[sizeof(msg.buf) * 2 + 64];
+	size_t len;
+
+	while (fgets(line, sizeof(line), stdin)) {
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		memset(&msg, 0, sizeof(msg));
+		len = hex_to_msg(line);
+		replay(len);
+	}
+
+	printf("%u routes decoded, %u ignored, %u broken\n", decoded, ignored,
+	       broken);
+	return 0;
+}
@@ -0,0 +1,5 @@
+import frrtest
+
+
+class TestNetlinkReplay(frrtest.TestRefOut):
+    program = "./test_netlink_replay"
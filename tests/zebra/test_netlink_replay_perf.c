@@ -0,0 +1,1078 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Netlink receive benchmark for zebra, without a kernel.
+ *
+ * Replays recorded netlink messages (a pcap file captured on an nlmon
+ * interface, or a synthetic route table) through zebra's own receive path:
+ * netlink_parse_info() reads them off a replay socket, one receive buffer
+ * per recvmsg(), and hands them to the handlers in rt_netlink.c.  New
+ * routes are decoded into dataplane contexts and passed on to zebra the way
+ * dplane_fpm_nl.c does it; deleted ones go to the kernel route batch, as
+ * they do in kernel_read().  Neighbors end up in the neighbor table calls,
+ * and links only get their attributes parsed, since if_netlink.c isn't
+ * linked in.
+ *
+ * Prints routes/s and, for each kind of message, the time it took to handle
+ * one, from a nanosecond clock: average, p50 and p99 (upper bounds of
+ * power-of-two buckets) and max.
+ *
+ * Capturing from a live box:
+ *   ip link add nlmon0 type nlmon && ip link set nlmon0 up
+ *   tcpdump -i nlmon0 -w routes.pcap
+ */
+
+#include <zebra.h>
+
+#include <byteswap.h>
+#include <sys/syscall.h>
+#include <linux/if_link.h>
+#include <linux/neighbour.h>
+
+#include "memory.h"
+#include "prefix.h"
+#include "nexthop.h"
+#include "vrf.h"
+#include "if.h"
+
+#include "zebra/rib.h"
+#include "zebra/zebra_dplane.h"
+#include "zebra/kernel_netlink.h"
+#include "zebra/debug.h"
+#include "zebra/if_netlink.h"
+#include "zebra/interface.h"
+#include "zebra/netconf_netlink.h"
+#include "zebra/rt_netlink.h"
+#include "zebra/rt_netlink_decode.h"
+#include "zebra/rule_netlink.h"
+#include "zebra/tc_netlink.h"
+#include "zebra/zapi_msg.h"
+#include "zebra/zebra_evpn_mh.h"
+#include "zebra/zebra_mpls.h"
+#include "zebra/zebra_neigh.h"
+#include "zebra/zebra_nhg.h"
+#include "zebra/zebra_ns.h"
+#include "zebra/zebra_pbr.h"
+#include "zebra/zebra_router.h"
+#include "zebra/zebra_tc.h"
+#include "zebra/zebra_vrf.h"
+#include "zebra/zebra_vxlan.h"
+#include "zebra/zebra_vxlan_if.h"
+#include "zebra/zebra_vxlan_private.h"
+#include "zebra/zserv.h"
+
+#include "bench.h"
+
+DEFINE_MGROUP(TEST_NLPERF, "netlink replay benchmark");
+DEFINE_MTYPE_STATIC(TEST_NLPERF, NLPERF, "netlink replay buffer");
+
+#define LINKTYPE_LINUX_SLL 113
+#define LINKTYPE_NETLINK   253
+#define SLL_HDR_LEN	   16
+
+/* Size of the synthetic receive buffers, like NL_RCV_PKT_BUF_SIZE */
+#define REPLAY_BUF_SIZE (32 * 1024)
+
+/* Receive buffers read per netlink_parse_info(), as in kernel_read() */
+#define REPLAY_READS 5
+
+#define MSG_TAIL ((void *)(msg.buf + NLMSG_ALIGN(msg.h.nlmsg_len)))
+
+#ifndef NDA_RTA
+#define NDA_RTA(r)                                                             \
+	((struct rtattr *)(((char *)(r)) + NLMSG_ALIGN(sizeof(struct ndmsg))))
+#endif
+
+struct pcap_hdr {
+	uint32_t magic;
+	uint16_t version_major;
+	uint16_t version_minor;
+	int32_t thiszone;
+	uint32_t sigfigs;
+	uint32_t snaplen;
+	uint32_t linktype;
+};
+
+struct pcap_rec {
+	uint32_t ts_sec;
+	uint32_t ts_usec;
+	uint32_t incl_len;
+	uint32_t orig_len;
+};
+
+/* One receive buffer's worth of netlink messages */
+struct replay_buf {
+	uint8_t *data;
+	size_t len;
+};
+
+struct replay {
+	struct replay_buf *bufs;
+	unsigned int nbufs;
+	unsigned int bufs_size;
+};
+
+/* Time taken by one kind of message, in a log2 histogram */
+struct stage {
+	const char *name;
+	uint64_t count;
+	uint64_t total;
+	uint64_t max;
+	uint64_t hist[64];
+};
+
+static struct stage route_stage = { .name = "route" };
+static struct stage link_stage = { .name = "link" };
+static struct stage neigh_stage = { .name = "neighbor" };
+
+/* Routes decoded, and those that made it to zebra */
+static uint64_t nroute_msgs, nroutes_new, nroutes_del;
+static uint64_t nneighs, nignored, nbroken;
+
+/* The replay socket, standing in for zebra's netlink listener */
+static struct {
+	int fd;
+	const struct replay *rp;
+	unsigned int next;
+} rsock = { .fd = -1 };
+
+/* Every interface index is this interface, in the default VRF */
+static struct vrf replay_vrf = { .vrf_id = VRF_DEFAULT, .name = "default" };
+static struct zebra_if replay_zif;
+static struct interface replay_ifp = {
+	.name = "replay",
+	.vrf = &replay_vrf,
+	.info = &replay_zif,
+};
+
+/* shim out the rest of zebra, for kernel_netlink, rt_netlink and dplane */
+DEFINE_MGROUP(ZEBRA, "zebra");
+struct zebra_router zrouter;
+struct zebra_privs_t zserv_privs;
+unsigned long zebra_debug_kernel;
+unsigned long zebra_debug_dplane;
+unsigned long zebra_debug_nexthop;
+unsigned long zebra_debug_vxlan;
+unsigned long zebra_debug_evpn_mh;
+uint32_t rcvbufsize;
+bool v6_rr_semantics;
+
+static struct zebra_evpn_mh_info replay_mh_info;
+static struct route_entry replay_re;
+
+void zebra_rib_route_entry_init(struct route_entry *re, vrf_id_t vrf_id,
+				int type, uint8_t instance, uint32_t flags,
+				uint32_t nhe_id, uint32_t table_id,
+				uint32_t metric, uint32_t mtu,
+				uint8_t distance, route_tag_t tag)
+{
+	memset(re, 0, sizeof(*re));
+	re->type = type;
+	re->instance = instance;
+	re->distance = distance;
+	re->flags = flags;
+	re->nhe_id = nhe_id;
+	re->metric = metric;
+	re->mtu = mtu;
+	re->table = table_id;
+	re->vrf_id = vrf_id;
+	re->tag = tag;
+}
+
+/* The dataplane context takes a copy, see dplane_rib_add_multipath() */
+struct route_entry *zebra_rib_route_entry_new(vrf_id_t vrf_id, int type,
+					      uint8_t instance, uint32_t flags,
+					      uint32_t nhe_id,
+					      uint32_t table_id,
+					      uint32_t metric, uint32_t mtu,
+					      uint8_t distance,
+					      route_tag_t tag)
+{
+	zebra_rib_route_entry_init(&replay_re, vrf_id, type, instance, flags,
+				   nhe_id, table_id, metric, mtu, distance,
+				   tag);
+	return &replay_re;
+}
+
+/* Takes over what the nexthops hold, like the real batch */
+void rib_kernel_batch_add(afi_t afi, struct prefix *p,
+			  struct prefix_ipv6 *src_p,
+			  const struct route_entry *re,
+			  const struct nexthop *nh, unsigned int nh_num,
+			  bool startup, bool deletion)
+{
+	struct nl_route route = {
+		.nh = (struct nexthop *)nh,
+		.nh_num = nh_num,
+	};
+
+	netlink_route_free(&route);
+	if (deletion)
+		nroutes_del++;
+}
+
+void rib_kernel_batch_flush(void)
+{
+}
+
+int rib_add_multipath(afi_t afi, safi_t safi, struct prefix *p,
+		      struct prefix_ipv6 *src_p, struct route_entry *re,
+		      struct nexthop_group *ng, bool startup)
+{
+	return 0;
+}
+
+int is_zebra_valid_kernel_table(uint32_t table_id)
+{
+	return 1;
+}
+
+int is_zebra_main_routing_table(uint32_t table_id)
+{
+	return table_id == RT_TABLE_MAIN;
+}
+
+struct zebra_ns *zebra_ns_lookup(ns_id_t ns_id)
+{
+	return NULL;
+}
+
+struct interface *if_lookup_by_index_per_ns(struct zebra_ns *ns,
+					    uint32_t ifindex)
+{
+	return &replay_ifp;
+}
+
+bool zserv_nexthop_num_warn(const char *caller, const struct prefix *p,
+			    const unsigned int nexthop_num)
+{
+	return false;
+}
+
+void zsend_nhrp_neighbor_notify(int cmd, struct interface *ifp,
+				struct ipaddr *ipaddr, int ndm_state,
+				union sockunion *link_layer_ipv4)
+{
+}
+
+void zebra_neigh_add(struct interface *ifp, struct ipaddr *ip,
+		     struct ethaddr *mac)
+{
+	nneighs++;
+}
+
+void zebra_neigh_del(struct interface *ifp, struct ipaddr *ip)
+{
+	nneighs++;
+}
+
+/* if_netlink.c: only the attributes are looked at */
+int netlink_link_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	struct ifinfomsg *ifi = NLMSG_DATA(h);
+	struct rtattr *tb[IFLA_MAX + 1];
+	int len = h->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi));
+
+	if (len < 0)
+		return -1;
+
+	netlink_parse_rtattr_flags(tb, IFLA_MAX, IFLA_RTA(ifi), len,
+				   NLA_F_NESTED);
+	return tb[IFLA_IFNAME] ? 0 : -1;
+}
+
+/* Not reached with the messages replayed here */
+void if_nbr_ipv6ll_to_ipv4ll_neigh_update(struct interface *ifp,
+					  struct in6_addr *address, int add)
+{
+}
+
+bool if_netlink_frr_protodown_r_bit_is_set(void)
+{
+	return false;
+}
+
+uint8_t if_netlink_get_frr_protodown_r_bit(void)
+{
+	return FRR_PROTODOWN_REASON_DEFAULT_BIT;
+}
+
+int netlink_interface_addr_dplane(struct nlmsghdr *h, ns_id_t ns_id,
+				  int startup)
+{
+	return 0;
+}
+
+int netlink_netconf_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	return 0;
+}
+
+int netlink_request_netconf(int sockfd)
+{
+	return 0;
+}
+
+int netlink_rule_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	return 0;
+}
+
+int netlink_qdisc_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	return 0;
+}
+
+int netlink_tclass_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	return 0;
+}
+
+int netlink_tfilter_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	return 0;
+}
+
+int netlink_vlan_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	return 0;
+}
+
+enum netlink_msg_status
+netlink_put_address_update_msg(struct nl_batch *bth,
+			       struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_gre_set_msg(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_intf_netconfig(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_intf_update_msg(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_lsp_update_msg(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_pw_update_msg(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_rule_update_msg(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_tc_class_update_msg(struct nl_batch *bth,
+				struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_tc_filter_update_msg(struct nl_batch *bth,
+				 struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+enum netlink_msg_status
+netlink_put_tc_qdisc_update_msg(struct nl_batch *bth,
+				struct zebra_dplane_ctx *ctx)
+{
+	return FRR_NETLINK_ERROR;
+}
+
+const char *tc_filter_kind2str(uint32_t type)
+{
+	return "";
+}
+
+const char *tc_qdisc_kind2str(uint32_t type)
+{
+	return "";
+}
+
+void zebra_finalize(struct thread *event)
+{
+	exit(0);
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_nhlfe(
+	struct zebra_lsp *lsp, enum lsp_types_t lsp_type,
+	enum nexthop_types_t gtype, const union g_addr *gate,
+	ifindex_t ifindex, uint8_t num_labels, const mpls_label_t *out_labels)
+{
+	return NULL;
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_backup_nhlfe(
+	struct zebra_lsp *lsp, enum lsp_types_t lsp_type,
+	enum nexthop_types_t gtype, const union g_addr *gate,
+	ifindex_t ifindex, uint8_t num_labels, const mpls_label_t *out_labels)
+{
+	return NULL;
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_nh(struct zebra_lsp *lsp,
+					  enum lsp_types_t lsp_type,
+					  const struct nexthop *nh)
+{
+	return NULL;
+}
+
+struct zebra_nhlfe *zebra_mpls_lsp_add_backup_nh(struct zebra_lsp *lsp,
+						 enum lsp_types_t lsp_type,
+						 const struct nexthop *nh)
+{
+	return NULL;
+}
+
+void zebra_mpls_nhlfe_free(struct zebra_nhlfe *nhlfe)
+{
+}
+
+bool zebra_nhg_depends_is_empty(const struct nhg_hash_entry *nhe)
+{
+	return true;
+}
+
+int zebra_nhg_kernel_find(uint32_t id, struct nexthop *nh, struct nh_grp *grp,
+			  uint8_t count, vrf_id_t vrf_id, afi_t afi, int type,
+			  int startup, struct nhg_resilience *resilience)
+{
+	return 0;
+}
+
+int zebra_nhg_kernel_del(uint32_t id, vrf_id_t vrf_id)
+{
+	return 0;
+}
+
+bool zebra_nhg_kernel_nexthops_enabled(void)
+{
+	return false;
+}
+
+bool zebra_nhg_proto_nexthops_only(void)
+{
+	return false;
+}
+
+uint8_t zebra_nhg_nhe2grp(struct nh_grp *grp, struct nhg_hash_entry *nhe,
+			  int size)
+{
+	return 0;
+}
+
+struct nhg_hash_entry *zebra_nhg_resolve(struct nhg_hash_entry *nhe)
+{
+	return nhe;
+}
+
+const char *zebra_pbr_ipset_type2str(uint32_t type)
+{
+	return "";
+}
+
+void zebra_pbr_process_iptable(struct zebra_dplane_ctx *ctx)
+{
+}
+
+void zebra_pbr_process_ipset(struct zebra_dplane_ctx *ctx)
+{
+}
+
+void zebra_pbr_process_ipset_entry(struct zebra_dplane_ctx *ctx)
+{
+}
+
+uint32_t zebra_router_get_next_sequence(void)
+{
+	return 0;
+}
+
+struct zebra_vrf *zebra_vrf_lookup_by_id(vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+struct route_table *zebra_vrf_table(afi_t afi, safi_t safi, vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+int zebra_vxlan_check_readd_vtep(struct interface *ifp, vni_t vni,
+				 struct in_addr vtep_ip)
+{
+	return 0;
+}
+
+int zebra_vxlan_dp_network_mac_add(struct interface *ifp,
+				   struct interface *br_if,
+				   struct ethaddr *macaddr, vlanid_t vid,
+				   vni_t vni, uint32_t nhg_id, bool sticky,
+				   bool dp_static)
+{
+	return 0;
+}
+
+int zebra_vxlan_handle_kernel_neigh_update(
+	struct interface *ifp, struct interface *link_if, struct ipaddr *ip,
+	struct ethaddr *macaddr, uint16_t state, bool is_ext, bool is_router,
+	bool local_inactive, bool dp_static)
+{
+	return 0;
+}
+
+int zebra_vxlan_handle_kernel_neigh_del(struct interface *ifp,
+					struct interface *link_if,
+					struct ipaddr *ip)
+{
+	return 0;
+}
+
+int zebra_vxlan_local_mac_add_update(struct interface *ifp,
+				     struct interface *br_if,
+				     struct ethaddr *mac, vlanid_t vid,
+				     bool sticky, bool local_inactive,
+				     bool dp_static)
+{
+	return 0;
+}
+
+int zebra_vxlan_local_mac_del(struct interface *ifp, struct interface *br_if,
+			      struct ethaddr *mac, vlanid_t vid)
+{
+	return 0;
+}
+
+struct zebra_vxlan_vni *zebra_vxlan_if_vni_find(const struct zebra_if *zif,
+						vni_t vni)
+{
+	return NULL;
+}
+
+int zebra_vxlan_if_vni_mcast_group_add_update(struct interface *ifp,
+					      vni_t vni_id,
+					      struct in_addr *mcast_group)
+{
+	return 0;
+}
+
+int zebra_vxlan_if_vni_mcast_group_del(struct interface *ifp, vni_t vni_id,
+				       struct in_addr *mcast_group)
+{
+	return 0;
+}
+
+struct zebra_l3vni *zl3vni_from_vrf(vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+static int64_t now_nsec(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static void stage_add(struct stage *st, uint64_t ns)
+{
+	st->count++;
+	st->total += ns;
+	if (ns > st->max)
+		st->max = ns;
+	st->hist[ns ? 64 - __builtin_clzll(ns) : 0]++;
+}
+
+/* Upper bound of the histogram bucket holding percentile 'pct' */
+static uint64_t stage_pct(const struct stage *st, unsigned int pct)
+{
+	uint64_t want = (st->count * pct + 99) / 100, seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < array_size(st->hist); i++) {
+		seen += st->hist[i];
+		if (seen >= want && seen)
+			return i ? (1ULL << i) - 1 : 0;
+	}
+	return st->max;
+}
+
+static void stage_print(const struct stage *st)
+{
+	printf("%-10s %10" PRIu64 " %10.0f %10" PRIu64 " %10" PRIu64
+	       " %10" PRIu64 "\n",
+	       st->name, st->count,
+	       st->count ? (double)st->total / st->count : 0.0,
+	       stage_pct(st, 50), stage_pct(st, 99), st->max);
+}
+
+static uint8_t *replay_add_buf(struct replay *rp, size_t len)
+{
+	struct replay_buf *buf;
+
+	if (rp->nbufs == rp->bufs_size) {
+		rp->bufs_size = rp->bufs_size ? rp->bufs_size * 2 : 64;
+		rp->bufs = XREALLOC(MTYPE_NLPERF, rp->bufs,
+				    rp->bufs_size * sizeof(*rp->bufs));
+	}
+
+	buf = &rp->bufs[rp->nbufs++];
+	buf->data = XCALLOC(MTYPE_NLPERF, len);
+	buf->len = len;
+	return buf->data;
+}
+
+static int replay_load_pcap(struct replay *rp, const char *path)
+{
+	struct pcap_hdr hdr;
+	struct pcap_rec rec;
+	size_t skip = 0;
+	uint8_t *data;
+	bool swap;
+	FILE *f;
+
+	f = fopen(path, "r");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return -1;
+	}
+
+	if (fread(&hdr, sizeof(hdr), 1, f) != 1)
+		goto bad;
+
+	if (hdr.magic == 0xa1b2c3d4 || hdr.magic == 0xa1b23c4d)
+		swap = false;
+	else if (hdr.magic == 0xd4c3b2a1 || hdr.magic == 0x4d3cb2a1)
+		swap = true;
+	else
+		goto bad;
+
+	if (swap)
+		hdr.linktype = bswap_32(hdr.linktype);
+	if (hdr.linktype == LINKTYPE_LINUX_SLL)
+		skip = SLL_HDR_LEN;
+	else if (hdr.linktype != LINKTYPE_NETLINK) {
+		fprintf(stderr, "%s: link type %u, not netlink\n", path,
+			hdr.linktype);
+		fclose(f);
+		return -1;
+	}
+
+	while (fread(&rec, sizeof(rec), 1, f) == 1) {
+		if (swap)
+			rec.incl_len = bswap_32(rec.incl_len);
+		if (rec.incl_len > 16 * 1024 * 1024)
+			goto bad;
+		if (rec.incl_len <= skip) {
+			if (fseek(f, rec.incl_len, SEEK_CUR))
+				goto bad;
+			continue;
+		}
+
+		if (skip && fseek(f, skip, SEEK_CUR))
+			goto bad;
+		data = replay_add_buf(rp, rec.incl_len - skip);
+		if (fread(data, rec.incl_len - skip, 1, f) != 1)
+			goto bad;
+	}
+
+	fclose(f);
+	return 0;
+
+bad:
+	fprintf(stderr, "%s: not a usable pcap file\n", path);
+	fclose(f);
+	return -1;
+}
+
+static void replay_save_pcap(const struct replay *rp, const char *path)
+{
+	struct pcap_hdr hdr = {
+		.magic = 0xa1b2c3d4,
+		.version_major = 2,
+		.version_minor = 4,
+		.snaplen = 262144,
+		.linktype = LINKTYPE_NETLINK,
+	};
+	struct pcap_rec rec = {};
+	unsigned int i;
+	FILE *f;
+
+	f = fopen(path, "w");
+	if (!f) {
+		fprintf(stderr, "%s: %s\n", path, strerror(errno));
+		return;
+	}
+
+	fwrite(&hdr, sizeof(hdr), 1, f);
+	for (i = 0; i < rp->nbufs; i++) {
+		rec.incl_len = rec.orig_len = rp->bufs[i].len;
+		fwrite(&rec, sizeof(rec), 1, f);
+		fwrite(rp->bufs[i].data, rp->bufs[i].len, 1, f);
+	}
+	fclose(f);
+}
+
+/* Synthetic messages, built in 'msg' before being copied to a buffer */
+static union {
+	struct nlmsghdr h;
+	uint8_t buf[1024];
+} msg;
+
+static void msg_start(uint16_t type, size_t hdrlen)
+{
+	memset(&msg, 0, sizeof(msg));
+	msg.h.nlmsg_len = NLMSG_LENGTH(hdrlen);
+	msg.h.nlmsg_type = type;
+	msg.h.nlmsg_flags = NLM_F_MULTI;
+}
+
+static struct rtattr *msg_attr(int type, const void *data, size_t len)
+{
+	struct rtattr *rta = MSG_TAIL;
+
+	rta->rta_type = type;
+	rta->rta_len = RTA_LENGTH(len);
+	if (data)
+		memcpy(RTA_DATA(rta), data, len);
+	msg.h.nlmsg_len = NLMSG_ALIGN(msg.h.nlmsg_len) + RTA_ALIGN(rta->rta_len);
+	return rta;
+}
+
+static void msg_attr32(int type, uint32_t val)
+{
+	msg_attr(type, &val, sizeof(val));
+}
+
+/* Append 'msg' to the replay, in buffers of up to REPLAY_BUF_SIZE */
+static void msg_done(struct replay *rp, size_t *fill)
+{
+	struct replay_buf *buf;
+	size_t len = NLMSG_ALIGN(msg.h.nlmsg_len);
+
+	if (!rp->nbufs || *fill + len > REPLAY_BUF_SIZE) {
+		replay_add_buf(rp, REPLAY_BUF_SIZE);
+		*fill = 0;
+	}
+
+	buf = &rp->bufs[rp->nbufs - 1];
+	memcpy(buf->data + *fill, &msg, msg.h.nlmsg_len);
+	*fill += len;
+	buf->len = *fill;
+}
+
+/*
+ * Interfaces, a neighbor on each, and 'count' BGP routes: one out of four
+ * has two paths, the rest go through a single gateway.
+ */
+static void replay_synthesize(struct replay *rp, unsigned int count,
+			      unsigned int nifs)
+{
+	struct ifinfomsg *ifi;
+	struct ndmsg *ndm;
+	struct rtmsg *rtm;
+	struct rtattr *mp;
+	struct rtnexthop *rtnh;
+	char name[IFNAMSIZ];
+	uint8_t mac[6] = { 0x02, 0, 0, 0, 0, 0 };
+	struct in_addr addr;
+	size_t fill = 0;
+	unsigned int i, j;
+
+	for (i = 0; i < nifs; i++) {
+		msg_start(RTM_NEWLINK, sizeof(*ifi));
+		ifi = NLMSG_DATA(&msg.h);
+		ifi->ifi_family = AF_UNSPEC;
+		ifi->ifi_index = i + 2;
+		ifi->ifi_flags = IFF_UP | IFF_RUNNING;
+		snprintf(name, sizeof(name), "eth%u", i);
+		msg_attr(IFLA_IFNAME, name, strlen(name) + 1);
+		msg_attr32(IFLA_MTU, 1500);
+		mac[5] = i;
+		msg_attr(IFLA_ADDRESS, mac, sizeof(mac));
+		msg_done(rp, &fill);
+	}
+
+	for (i = 0; i < nifs; i++) {
+		msg_start(RTM_NEWNEIGH, sizeof(*ndm));
+		ndm = NLMSG_DATA(&msg.h);
+		ndm->ndm_family = AF_INET;
+		ndm->ndm_ifindex = i + 2;
+		ndm->ndm_state = NUD_REACHABLE;
+		ndm->ndm_type = RTN_UNICAST;
+		addr.s_addr = htonl(0x0a000001 + (i << 8));
+		msg_attr(NDA_DST, &addr, sizeof(addr));
+		mac[4] = 1;
+		mac[5] = i;
+		msg_attr(NDA_LLADDR, mac, sizeof(mac));
+		msg_done(rp, &fill);
+	}
+
+	for (i = 0; i < count; i++) {
+		msg_start(RTM_NEWROUTE, sizeof(*rtm));
+		rtm = NLMSG_DATA(&msg.h);
+		rtm->rtm_family = AF_INET;
+		rtm->rtm_dst_len = 32;
+		rtm->rtm_table = RT_TABLE_MAIN;
+		rtm->rtm_protocol = 186;
+		rtm->rtm_scope = RT_SCOPE_UNIVERSE;
+		rtm->rtm_type = RTN_UNICAST;
+
+		addr.s_addr = htonl(0x10000000 + i);
+		msg_attr(RTA_DST, &addr, sizeof(addr));
+		msg_attr32(RTA_PRIORITY, 20);
+
+		if (i % 4) {
+			j = i % nifs;
+			addr.s_addr = htonl(0x0a000001 + (j << 8));
+			msg_attr(RTA_GATEWAY, &addr, sizeof(addr));
+			msg_attr32(RTA_OIF, j + 2);
+		} else {
+			mp = msg_attr(RTA_MULTIPATH, NULL, 0);
+			for (j = 0; j < 2; j++) {
+				unsigned int ifi_n = (i + j) % nifs;
+
+				rtnh = MSG_TAIL;
+				rtnh->rtnh_len = sizeof(*rtnh);
+				rtnh->rtnh_ifindex = ifi_n + 2;
+				msg.h.nlmsg_len += sizeof(*rtnh);
+
+				addr.s_addr = htonl(0x0a000001 + (ifi_n << 8));
+				msg_attr(RTA_GATEWAY, &addr, sizeof(addr));
+				rtnh->rtnh_len = (uint8_t *)MSG_TAIL
+						 - (uint8_t *)rtnh;
+			}
+			mp->rta_len = (uint8_t *)MSG_TAIL
+				      - (uint8_t *)mp;
+		}
+		msg_done(rp, &fill);
+	}
+}
+
+/*
+ * netlink_recv_msg() peeks at the size of the next message and then reads
+ * it.  Any other socket still gets a real one.
+ */
+ssize_t recv(int fd, void *buf, size_t len, int flags)
+{
+	if (fd != rsock.fd)
+		return syscall(SYS_recvfrom, fd, buf, len, flags, NULL, NULL);
+
+	if (rsock.next == rsock.rp->nbufs) {
+		errno = EAGAIN;
+		return -1;
+	}
+	return rsock.rp->bufs[rsock.next].len;
+}
+
+ssize_t recvmsg(int fd, struct msghdr *msg, int flags)
+{
+	const struct replay_buf *buf;
+	struct sockaddr_nl *snl = msg->msg_name;
+	size_t len;
+
+	if (fd != rsock.fd)
+		return syscall(SYS_recvmsg, fd, msg, flags);
+
+	if (rsock.next == rsock.rp->nbufs) {
+		errno = EAGAIN;
+		return -1;
+	}
+
+	buf = &rsock.rp->bufs[rsock.next++];
+	len = MIN(buf->len, msg->msg_iov[0].iov_len);
+	memcpy(msg->msg_iov[0].iov_base, buf->data, len);
+	msg->msg_flags = len < buf->len ? MSG_TRUNC : 0;
+
+	/* Sent by the kernel */
+	memset(snl, 0, sizeof(*snl));
+	snl->nl_family = AF_NETLINK;
+	msg->msg_namelen = sizeof(*snl);
+
+	return len;
+}
+
+/* Zebra's end of the dataplane, for the routes decoded into contexts */
+static int replay_results(struct dplane_ctx_list_head *ctxlist)
+{
+	struct zebra_dplane_ctx *ctx;
+
+	while ((ctx = dplane_ctx_dequeue(ctxlist)) != NULL) {
+		nroutes_new++;
+		dplane_ctx_fini(&ctx);
+	}
+
+	return 0;
+}
+
+/* The dispatch of netlink_information_fetch(), timing each message */
+static int replay_filter(struct nlmsghdr *h, ns_id_t ns_id, int startup)
+{
+	struct zebra_dplane_ctx *ctx;
+	struct stage *st;
+	int64_t start = now_nsec();
+	int ret;
+
+	switch (h->nlmsg_type) {
+	case RTM_NEWROUTE:
+		st = &route_stage;
+		ctx = dplane_ctx_alloc();
+		dplane_ctx_set_op(ctx, DPLANE_OP_ROUTE_NOTIFY);
+		ret = netlink_route_change_read_unicast_internal(h, ns_id,
+								 startup, ctx);
+		if (ret == 1)
+			nroute_msgs++;
+		else
+			dplane_ctx_fini(&ctx);
+		break;
+	case RTM_DELROUTE:
+		st = &route_stage;
+		ret = netlink_route_change(h, ns_id, startup);
+		break;
+	case RTM_NEWLINK:
+	case RTM_DELLINK:
+		st = &link_stage;
+		ret = netlink_link_change(h, ns_id, startup);
+		break;
+	case RTM_NEWNEIGH:
+	case RTM_DELNEIGH:
+		st = &neigh_stage;
+		ret = netlink_neigh_change(h, ns_id);
+		break;
+	default:
+		nignored++;
+		return 0;
+	}
+
+	stage_add(st, now_nsec() - start);
+	if (ret < 0)
+		nbroken++;
+	else if (ret == 0 && h->nlmsg_type == RTM_NEWROUTE)
+		nignored++;
+
+	return ret;
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"usage: %s [-f capture.pcap] [-n routes] [-i interfaces] [-w out.pcap]\n",
+		prog);
+	exit(1);
+}
+
+int main(int argc, char **argv)
+{
+	struct replay rp = {};
+	struct nlsock nl = {};
+	struct zebra_dplane_info dp_info = {};
+	const char *in = NULL, *out = NULL;
+	unsigned int count = 500000, nifs = 16, i;
+	struct timeval start;
+	int64_t elapsed;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "f:n:i:w:")) != -1) {
+		switch (opt) {
+		case 'f':
+			in = optarg;
+			break;
+		case 'n':
+			count = strtoul(optarg, NULL, 0);
+			break;
+		case 'i':
+			nifs = strtoul(optarg, NULL, 0);
+			if (!nifs)
+				usage(argv[0]);
+			break;
+		case 'w':
+			out = optarg;
+			break;
+		default:
+			usage(argv[0]);
+		}
+	}
+
+	if (in) {
+		if (replay_load_pcap(&rp, in) < 0)
+			return 1;
+	} else
+		replay_synthesize(&rp, count, nifs);
+
+	if (out)
+		replay_save_pcap(&rp, out);
+
+	zrouter.mh_info = &replay_mh_info;
+	zebra_dplane_init(replay_results);
+
+	/* Large enough that netlink_recv_msg() never has to grow it */
+	nl.buflen = NL_RCV_PKT_BUF_SIZE;
+	for (i = 0; i < rp.nbufs; i++)
+		nl.buflen = MAX(nl.buflen, rp.bufs[i].len);
+	nl.buf = XMALLOC(MTYPE_NLPERF, nl.buflen);
+	strlcpy(nl.name, "netlink-replay", sizeof(nl.name));
+
+	rsock.fd = open("/dev/null", O_RDONLY);
+	if (rsock.fd < 0) {
+		perror("/dev/null");
+		return 1;
+	}
+	rsock.rp = &rp;
+	nl.sock = rsock.fd;
+	dp_info.ns_id = NS_DEFAULT;
+	dp_info.sock = rsock.fd;
+
+	monotime(&start);
+	while (rsock.next < rp.nbufs) {
+		netlink_parse_info(replay_filter, &nl, &dp_info, REPLAY_READS,
+				   false);
+		rib_kernel_batch_flush();
+	}
+	elapsed = monotime_since(&start, NULL);
+
+	printf("%u buffers: %" PRIu64 " routes added, %" PRIu64
+	       " deleted, %" PRIu64 " links, %" PRIu64 " neighbors, %" PRIu64
+	       " ignored, %" PRIu64 " broken\n",
+	       rp.nbufs, nroutes_new, nroutes_del, link_stage.count, nneighs,
+	       nignored, nbroken);
+	bench_report_usec("routes", nroutes_new + nroutes_del, elapsed);
+	printf("\n");
+
+	printf("%-10s %10s %10s %10s %10s %10s\n", "message", "count",
+	       "avg ns", "p50 ns", "p99 ns", "max ns");
+	stage_print(&route_stage);
+	stage_print(&link_stage);
+	stage_print(&neigh_stage);
+
+	close(rsock.fd);
+	XFREE(MTYPE_NLPERF, nl.buf);
+	for (i = 0; i < rp.nbufs; i++)
+		XFREE(MTYPE_NLPERF, rp.bufs[i].data);
+	XFREE(MTYPE_NLPERF, rp.bufs);
+
+	/* Every route decoded into a context has to have reached zebra */
+	return nroutes_new == nroute_msgs ? 0 : 1;
+}
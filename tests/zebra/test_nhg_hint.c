@@ -0,0 +1,310 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Nexthop group source hint tests.
+ *
+ * Looks up the nhes of routes that go back and forth between a few nexthop
+ * groups, the way a daemon sends them, and checks that the per-source hints
+ * find every group they have seen without a hash lookup, and that they
+ * always come up with the same nhe as a plain lookup.
+ */
+
+#include <zebra.h>
+
+#include "hash.h"
+#include "nexthop.h"
+#include "nexthop_group.h"
+#include "prng.h"
+
+#include "zebra/debug.h"
+#include "zebra/interface.h"
+#include "zebra/rib.h"
+#include "zebra/zapi_msg.h"
+#include "zebra/zebra_dplane.h"
+#include "zebra/zebra_nhg.h"
+#include "zebra/zebra_rnh.h"
+#include "zebra/zebra_router.h"
+#include "zebra/zebra_routemap.h"
+#include "zebra/zebra_srte.h"
+#include "zebra/zebra_vxlan.h"
+
+/* shim out unused functions/variables to allow zebra_nhg to link */
+DEFINE_MGROUP(ZEBRA, "zebra");
+struct zebra_router zrouter;
+unsigned long zebra_debug_rib;
+unsigned long zebra_debug_dplane;
+unsigned long zebra_debug_nexthop;
+
+uint32_t dplane_ctx_get_nhe_id(const struct zebra_dplane_ctx *ctx)
+{
+	return 0;
+}
+
+enum dplane_op_e dplane_ctx_get_op(const struct zebra_dplane_ctx *ctx)
+{
+	return DPLANE_OP_NONE;
+}
+
+enum zebra_dplane_result dplane_ctx_get_status(
+	const struct zebra_dplane_ctx *ctx)
+{
+	return ZEBRA_DPLANE_REQUEST_SUCCESS;
+}
+
+enum zebra_dplane_result dplane_nexthop_add(struct nhg_hash_entry *nhe)
+{
+	return ZEBRA_DPLANE_REQUEST_SUCCESS;
+}
+
+enum zebra_dplane_result dplane_nexthop_delete(struct nhg_hash_entry *nhe)
+{
+	return ZEBRA_DPLANE_REQUEST_SUCCESS;
+}
+
+const char *dplane_op2str(enum dplane_op_e op)
+{
+	return "";
+}
+
+const char *dplane_res2str(enum zebra_dplane_result res)
+{
+	return "";
+}
+
+vni_t get_l3vni_vni(vrf_id_t vrf_id)
+{
+	return 0;
+}
+
+ifindex_t get_l3vni_vxlan_ifindex(vrf_id_t vrf_id)
+{
+	return 0;
+}
+
+bool is_vrf_l3vni_svd_backed(vrf_id_t vrf_id)
+{
+	return false;
+}
+
+void if_nhg_dependents_add(struct interface *ifp, struct nhg_hash_entry *nhe)
+{
+}
+
+void if_nhg_dependents_del(struct interface *ifp, struct nhg_hash_entry *nhe)
+{
+}
+
+void rib_handle_nhg_replace(struct nhg_hash_entry *old_entry,
+			    struct nhg_hash_entry *new_entry)
+{
+}
+
+int rib_queue_nhg_ctx_add(struct nhg_ctx *ctx)
+{
+	return 0;
+}
+
+int rnh_resolve_via_default(struct zebra_vrf *zvrf, int family)
+{
+	return 0;
+}
+
+int route_entry_update_nhe(struct route_entry *re,
+			   struct nhg_hash_entry *new_nhghe)
+{
+	return 0;
+}
+
+route_map_result_t zebra_route_map_check(afi_t family, int rib_type,
+					 uint8_t instance,
+					 const struct prefix *p,
+					 struct nexthop *nexthop,
+					 struct zebra_vrf *zvrf, route_tag_t tag)
+{
+	return RMAP_PERMITMATCH;
+}
+
+uint32_t zebra_router_get_next_sequence(void)
+{
+	return 0;
+}
+
+struct zebra_sr_policy *zebra_sr_policy_find(uint32_t color,
+					     struct ipaddr *endpoint)
+{
+	return NULL;
+}
+
+struct zebra_vrf *zebra_vrf_lookup_by_id(vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+struct route_table *zebra_vrf_table(afi_t afi, safi_t safi, vrf_id_t vrf_id)
+{
+	return NULL;
+}
+
+int zsend_nhg_notify(uint16_t type, uint16_t instance, uint32_t session_id,
+		     uint32_t id, enum zapi_nhg_notify_owner note)
+{
+	return 0;
+}
+
+/* As many groups as there are hints per source, see zebra_nhg.c */
+#define HINTS 4
+#define GROUPS (HINTS + 1)
+#define LOOKUPS 1000
+
+static struct prng *prng;
+
+/* The nhes of the routes, as received: keyed, and with two nexthops each */
+static struct nhg_hash_entry *routes[GROUPS];
+
+static void routes_init(void)
+{
+	struct nhg_hash_entry *nhe;
+	struct in_addr gate;
+	unsigned int g, i;
+
+	for (g = 0; g < GROUPS; g++) {
+		nhe = zebra_nhg_alloc();
+		nhe->type = ZEBRA_ROUTE_BGP;
+		nhe->vrf_id = VRF_DEFAULT;
+		nhe->afi = AFI_IP;
+
+		for (i = 0; i < 2; i++) {
+			gate.s_addr = htonl(0x0a000001 + g * 2 + i);
+			nexthop_group_add_sorted(
+				&nhe->nhg,
+				nexthop_from_ipv4(&gate, NULL, VRF_DEFAULT));
+		}
+
+		zebra_nhe_set_key(nhe);
+		routes[g] = nhe;
+	}
+}
+
+static void routes_fini(void)
+{
+	unsigned int g;
+
+	for (g = 0; g < GROUPS; g++)
+		zebra_nhg_free(routes[g]);
+}
+
+static void nhgs_init(void)
+{
+	zrouter.nhgs = hash_create_size(8, zebra_nhg_hash_key,
+					zebra_nhg_hash_equal, "NHG test");
+	zrouter.nhgs_id = hash_create_size(8, zebra_nhg_id_key,
+					   zebra_nhg_hash_id_equal,
+					   "NHG test ID index");
+}
+
+/* As zebra_router_terminate() */
+static void nhgs_fini(void)
+{
+	hash_iterate(zrouter.nhgs_id, zebra_nhg_hash_free_zero_id, NULL);
+	hash_clean(zrouter.nhgs_id, zebra_nhg_hash_free);
+	hash_free(zrouter.nhgs_id);
+	hash_clean(zrouter.nhgs, NULL);
+	hash_free(zrouter.nhgs);
+}
+
+/*
+ * Looks up the nhe of a route of group 'g', checking it against a plain
+ * lookup, and against what the same group came up with before.
+ */
+static bool lookup_one(unsigned int g, bool resolved, uint16_t instance,
+		       struct nhg_hash_entry **seen)
+{
+	struct nhg_hash_entry *rt_nhe, *nhe;
+	bool ok;
+
+	/* Each route gets its own copy, see zapi_route_add_queue(); resolved
+	 * ones come without a key, see nexthop_active_update()
+	 */
+	rt_nhe = resolved ? zebra_nhe_copy(routes[g], 0)
+			  : zebra_nhe_copy_keyed(routes[g]);
+
+	nhe = zebra_nhg_rib_find_nhe_src(rt_nhe, AFI_IP, ZEBRA_ROUTE_BGP,
+					 instance);
+	ok = nhe && nhe == zebra_nhg_rib_find_nhe(rt_nhe, AFI_IP);
+	if (seen[g] && nhe != seen[g])
+		ok = false;
+	seen[g] = nhe;
+
+	/* Keyed for the lookup, with the key the routes came with */
+	if (!CHECK_FLAG(rt_nhe->flags, NEXTHOP_GROUP_KEYED)
+	    || rt_nhe->key != routes[g]->key)
+		ok = false;
+
+	zebra_nhg_free(rt_nhe);
+	return ok;
+}
+
+/*
+ * Does LOOKUPS lookups over 'groups' groups, in turn or at random, and
+ * expects 'hits' hint hits, or all but the first lookup of each group if
+ * -1.
+ */
+static bool run_one(const char *desc, unsigned int groups, bool random,
+		    bool resolved, uint16_t instance, long hits,
+		    struct nhg_hash_entry **seen)
+{
+	uint64_t hits0, misses0, hits1, misses1;
+	unsigned int i, g, mismatch = 0;
+
+	zebra_nhg_src_hint_counts(&hits0, &misses0);
+
+	for (i = 0; i < LOOKUPS; i++) {
+		g = random ? prng_rand(prng) % groups : i % groups;
+		if (!lookup_one(g, resolved, instance, seen))
+			mismatch++;
+	}
+
+	zebra_nhg_src_hint_counts(&hits1, &misses1);
+	hits1 -= hits0;
+	misses1 -= misses0;
+
+	if (hits < 0)
+		hits = LOOKUPS - groups;
+	if (hits1 != (uint64_t)hits || hits1 + misses1 != LOOKUPS)
+		mismatch++;
+
+	printf("%s: %s (%" PRIu64 " hint hits, %" PRIu64
+	       " misses, %u mismatches)\n",
+	       desc, mismatch ? "failed" : "OK", hits1, misses1, mismatch);
+	return !mismatch;
+}
+
+int main(int argc, char **argv)
+{
+	struct nhg_hash_entry *seen[GROUPS] = {};
+	struct nhg_hash_entry *reseen[GROUPS] = {};
+	int fail = 0;
+
+	prng = prng_new(0);
+	nhgs_init();
+	routes_init();
+
+	fail += !run_one("alternate", HINTS, false, false, 0, -1, seen);
+	fail += !run_one("random", HINTS, true, false, 0, LOOKUPS, seen);
+	fail += !run_one("resolved", HINTS, true, true, 0, -1, seen);
+	/* One more group than hints: after the groups hinted above, the one
+	 * needed next is always the one that just dropped out
+	 */
+	fail += !run_one("overflow", GROUPS, false, false, 0, HINTS, seen);
+	fail += !run_one("instance", HINTS, false, false, 1, -1, seen);
+
+	/* No hint may outlive its nhe, even with all of them hinted */
+	nhgs_fini();
+	nhgs_init();
+	fail += !run_one("freed", HINTS, false, false, 1, -1, reseen);
+
+	nhgs_fini();
+	routes_fini();
+	prng_free(prng);
+
+	return fail;
+}
@@ -0,0 +1,13 @@
+import frrtest
+
+
+class TestNhgHint(frrtest.TestMultiOut):
+    program = "./test_nhg_hint"
+
+
+TestNhgHint.okfail("alternate")
+TestNhgHint.okfail("random")
+TestNhgHint.okfail("resolved")
+TestNhgHint.okfail("overflow")
+TestNhgHint.okfail("instance")
+TestNhgHint.okfail("freed")
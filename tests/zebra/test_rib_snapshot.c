@@ -0,0 +1,214 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * RIB snapshot tests.
+ *
+ * Saves a table of installed routes, loads it back, and checks that the
+ * routes read from the kernel at startup are recognized, and that changed
+ * ones aren't. A snapshot that is truncated, corrupted or from another
+ * version must not be loaded at all.
+ */
+
+#include <zebra.h>
+
+#include "nexthop.h"
+#include "prefix.h"
+#include "srcdest_table.h"
+#include "table.h"
+
+#include "zebra/debug.h"
+#include "zebra/rib.h"
+#include "zebra/zebra_dplane.h"
+#include "zebra/zebra_nhg.h"
+#include "zebra/zebra_rib_snapshot.h"
+#include "zebra/zebra_router.h"
+
+/* shim out unused functions/variables to allow zebra_rib_snapshot to link */
+DEFINE_MGROUP(ZEBRA, "zebra");
+struct zebra_router zrouter;
+unsigned long zebra_debug_rib;
+
+static int zebra_router_table_entry_compare(const struct zebra_router_table *e1,
+					    const struct zebra_router_table *e2)
+{
+	return e1->tableid - e2->tableid;
+}
+
+RB_GENERATE(zebra_router_table_head, zebra_router_table,
+	    zebra_router_table_entry, zebra_router_table_entry_compare);
+
+struct nexthop_group *zebra_nhg_get_backup_nhg(struct nhg_hash_entry *nhe)
+{
+	return NULL;
+}
+
+uint32_t dplane_provider_count(void)
+{
+	return 1;
+}
+
+#define ROUTES 64
+
+static struct zebra_router_table zrt;
+static struct rib_table_info info;
+static struct route_node *nodes[ROUTES];
+static char path[64];
+
+static struct route_entry *route_new(unsigned int i, unsigned int gw)
+{
+	struct route_entry *re;
+	struct nexthop *nh;
+	struct in_addr gate;
+
+	re = XCALLOC(MTYPE_TMP, sizeof(*re));
+	re->type = ZEBRA_ROUTE_BGP;
+	re->vrf_id = VRF_DEFAULT;
+	re->distance = 20;
+	re->metric = i;
+	re->nhe = XCALLOC(MTYPE_TMP, sizeof(*re->nhe));
+
+	gate.s_addr = htonl(0xc0a80001 + gw);
+	nh = nexthop_from_ipv4(&gate, NULL, VRF_DEFAULT);
+	SET_FLAG(nh->flags, NEXTHOP_FLAG_ACTIVE);
+	re->nhe->nhg.nexthop = nh;
+
+	return re;
+}
+
+static void route_free(struct route_entry *re)
+{
+	nexthops_free(re->nhe->nhg.nexthop);
+	XFREE(MTYPE_TMP, re->nhe);
+	XFREE(MTYPE_TMP, re);
+}
+
+/* The installed routes: 10.<i>.0.0/16 via 192.168.0.<i + 1> */
+static void table_init(void)
+{
+	struct prefix p = { .family = AF_INET, .prefixlen = 16 };
+	struct route_entry *re;
+	rib_dest_t *dest;
+	unsigned int i;
+
+	zrt.tableid = RT_TABLE_MAIN;
+	zrt.afi = AFI_IP;
+	zrt.safi = SAFI_UNICAST;
+	zrt.table = srcdest_table_init();
+	info.afi = AFI_IP;
+	info.safi = SAFI_UNICAST;
+	info.table_id = RT_TABLE_MAIN;
+	route_table_set_info(zrt.table, &info);
+	RB_INSERT(zebra_router_table_head, &zrouter.tables, &zrt);
+
+	for (i = 0; i < ROUTES; i++) {
+		p.u.prefix4.s_addr = htonl(0x0a000000 | (i << 16));
+		nodes[i] = srcdest_rnode_get(zrt.table, &p, NULL);
+
+		re = route_new(i, i);
+		SET_FLAG(re->status, ROUTE_ENTRY_INSTALLED);
+		dest = XCALLOC(MTYPE_TMP, sizeof(*dest));
+		dest->selected_fib = re;
+		nodes[i]->info = dest;
+	}
+}
+
+static void table_fini(void)
+{
+	rib_dest_t *dest;
+	unsigned int i;
+
+	for (i = 0; i < ROUTES; i++) {
+		dest = rib_dest_from_rnode(nodes[i]);
+		route_free(dest->selected_fib);
+		XFREE(MTYPE_TMP, dest);
+		nodes[i]->info = NULL;
+		route_unlock_node(nodes[i]);
+	}
+
+	RB_REMOVE(zebra_router_table_head, &zrouter.tables, &zrt);
+	route_table_finish(zrt.table);
+}
+
+/*
+ * How many routes are taken over as they come back from the kernel, with
+ * the nexthops of every other one changed if 'changed' is set.
+ */
+static unsigned int match_all(bool changed)
+{
+	struct route_entry *re;
+	unsigned int i, matched = 0;
+
+	for (i = 0; i < ROUTES; i++) {
+		re = route_new(i, changed && i % 2 ? i + ROUTES : i);
+		SET_FLAG(re->flags, ZEBRA_FLAG_SELFROUTE);
+		if (zebra_rib_snapshot_match(nodes[i], re, NULL))
+			matched++;
+		route_free(re);
+	}
+
+	return matched;
+}
+
+/* Rewrites the saved snapshot, with 'len' bytes and 'val' at 'off' */
+static void mangle(off_t len, off_t off, uint8_t val)
+{
+	int fd = open(path, O_WRONLY);
+
+	assert(fd >= 0);
+	if (off >= 0)
+		assert(pwrite(fd, &val, 1, off) == 1);
+	if (len >= 0)
+		assert(ftruncate(fd, len) == 0);
+	close(fd);
+}
+
+/* Loads the snapshot after mangle(), which has to fail if 'bad' is set */
+static bool run_one(const char *desc, off_t len, off_t off, uint8_t val,
+		    bool bad)
+{
+	unsigned int matched, expected = bad ? 0 : ROUTES;
+	bool ok = true;
+
+	if (zebra_rib_snapshot_save(path) < 0)
+		ok = false;
+	mangle(len, off, val);
+
+	if ((zebra_rib_snapshot_load(path) < 0) != bad)
+		ok = false;
+	matched = match_all(false);
+	if (matched != expected)
+		ok = false;
+	if (match_all(true) != expected / 2)
+		ok = false;
+	zebra_rib_snapshot_release();
+
+	printf("%s: %s (%u of %u routes taken over)\n", desc,
+	       ok ? "OK" : "failed", matched, ROUTES);
+	return ok;
+}
+
+int main(int argc, char **argv)
+{
+	struct stat st;
+	int fail = 0;
+
+	RB_INIT(zebra_router_table_head, &zrouter.tables);
+	zrouter.startup_time = 1;
+	snprintf(path, sizeof(path), "test_rib_snapshot.%ld", (long)getpid());
+
+	table_init();
+
+	fail += !run_one("roundtrip", -1, -1, 0, false);
+
+	assert(stat(path, &st) == 0);
+	fail += !run_one("truncated", st.st_size - 1, -1, 0, true);
+	fail += !run_one("short", 8, -1, 0, true);
+	/* in the middle of the route records */
+	fail += !run_one("corrupt", -1, st.st_size / 2, 0xff, true);
+	/* the version follows the 32 bit magic */
+	fail += !run_one("version", -1, 4, 0xff, true);
+
+	unlink(path);
+	table_fini();
+
+	return fail;
+}
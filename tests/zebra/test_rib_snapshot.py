@@ -0,0 +1,12 @@
+import frrtest
+
+
+class TestRibSnapshot(frrtest.TestMultiOut):
+    program = "./test_rib_snapshot"
+
+
+TestRibSnapshot.okfail("roundtrip")
+TestRibSnapshot.okfail("truncated")
+TestRibSnapshot.okfail("short")
+TestRibSnapshot.okfail("corrupt")
+TestRibSnapshot.okfail("version")
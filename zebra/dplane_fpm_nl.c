@@ -27,6 +27,7 @@
 #include "lib/network.h"
 #include "lib/ns.h"
 #include "lib/frr_pthread.h"
+#include "lib/monotime.h"
 #include "zebra/debug.h"
 #include "zebra/interface.h"
 #include "zebra/zebra_dplane.h"
@@ -59,13 +60,61 @@
 
 static const char *prov_name = "dplane_fpm_nl";
 
-struct fpm_nl_ctx {
+/* Most FPM server connections that can be configured. */
+#define FPM_CONNECTIONS_MAX 16
+
+/*
+ * Amount of data plane contexts a connection encodes at once: halved when
+ * the server can't keep up (socket or output buffer full), doubled when the
+ * output buffer was drained in the meantime.
+ */
+#define FPM_BATCH_MIN 16
+#define FPM_BATCH_DEFAULT 128
+#define FPM_BATCH_MAX 4096
+
+struct fpm_nl_counters {
+	/* Amount of bytes read into ibuf. */
+	_Atomic uint32_t bytes_read;
+	/* Amount of bytes written from obuf. */
+	_Atomic uint32_t bytes_sent;
+	/* Output buffer current usage. */
+	_Atomic uint32_t obuf_bytes;
+	/* Output buffer peak usage. */
+	_Atomic uint32_t obuf_peak;
+
+	/* Amount of connection closes. */
+	_Atomic uint32_t connection_closes;
+	/* Amount of connection errors. */
+	_Atomic uint32_t connection_errors;
+
+	/* Amount of data plane context processed. */
+	_Atomic uint32_t dplane_contexts;
+	/* Amount of data plane contexts enqueued. */
+	_Atomic uint32_t ctxqueue_len;
+	/* Peak amount of data plane contexts enqueued. */
+	_Atomic uint32_t ctxqueue_len_peak;
+
+	/* Amount of buffer full events. */
+	_Atomic uint32_t buffer_full;
+	/* Amount of writes the socket didn't take. */
+	_Atomic uint32_t write_blocked;
+};
+
+struct fpm_nl_ctx;
+
+/*
+ * One connection to the FPM server, with its own pthread doing the encoding
+ * and the socket I/O.
+ */
+struct fpm_nl_conn {
+	struct fpm_nl_ctx *fnc;
+	unsigned int idx;
+
 	/* data plane connection. */
 	int socket;
-	bool disabled;
 	bool connecting;
-	bool use_nhg;
-	struct sockaddr_storage addr;
+	/* Start of the throughput measurement. */
+	struct timeval since;
 
 	/* data plane buffers. */
 	struct stream *ibuf;
@@ -80,16 +129,49 @@ struct fpm_nl_ctx {
 	struct dplane_ctx_list_head ctxqueue;
 	pthread_mutex_t ctxqueue_mutex;
 
-	/* data plane events. */
-	struct zebra_dplane_provider *prov;
+	/*
+	 * Contexts taken out of `ctxqueue` waiting for output buffer space,
+	 * and the current batch size (only used by the connection pthread).
+	 */
+	struct dplane_ctx_list_head pending;
+	uint32_t pending_len;
+	_Atomic uint32_t batch;
+	/* Server pushed back since the last batch. */
+	bool blocked;
+
+	/* connection events. */
 	struct frr_pthread *fthread;
 	struct thread *t_connect;
 	struct thread *t_read;
 	struct thread *t_write;
 	struct thread *t_event;
-	struct thread *t_nhg;
 	struct thread *t_dequeue;
 
+	/* Statistic counters. */
+	struct fpm_nl_counters counters;
+};
+
+struct fpm_nl_ctx {
+	/* data plane connection configuration. */
+	bool disabled;
+	bool use_nhg;
+	struct sockaddr_storage addr;
+
+	/*
+	 * Connections to the server: routes are spread among them by prefix,
+	 * next hop groups go through all of them and everything else through
+	 * the first one.
+	 */
+	uint32_t conf_connections;
+	_Atomic uint32_t connections;
+	struct fpm_nl_conn conns[FPM_CONNECTIONS_MAX];
+
+	/* data plane events. */
+	struct zebra_dplane_provider *prov;
+	struct frr_pthread *fthread;
+	struct thread *t_event;
+	struct thread *t_nhg;
+
 	/* zebra events. */
 	struct thread *t_lspreset;
 	struct thread *t_lspwalk;
@@ -102,34 +184,10 @@ struct fpm_nl_ctx {
 
 	/* Statistic counters. */
 	struct {
-		/* Amount of bytes read into ibuf. */
-		_Atomic uint32_t bytes_read;
-		/* Amount of bytes written from obuf. */
-		_Atomic uint32_t bytes_sent;
-		/* Output buffer current usage. */
-		_Atomic uint32_t obuf_bytes;
-		/* Output buffer peak usage. */
-		_Atomic uint32_t obuf_peak;
-
-		/* Amount of connection closes. */
-		_Atomic uint32_t connection_closes;
-		/* Amount of connection errors. */
-		_Atomic uint32_t connection_errors;
-
 		/* Amount of user configurations: FNE_RECONNECT. */
 		_Atomic uint32_t user_configures;
 		/* Amount of user disable requests: FNE_DISABLE. */
 		_Atomic uint32_t user_disables;
-
-		/* Amount of data plane context processed. */
-		_Atomic uint32_t dplane_contexts;
-		/* Amount of data plane contexts enqueued. */
-		_Atomic uint32_t ctxqueue_len;
-		/* Peak amount of data plane contexts enqueued. */
-		_Atomic uint32_t ctxqueue_len_peak;
-
-		/* Amount of buffer full events. */
-		_Atomic uint32_t buffer_full;
 	} counters;
 } *gfnc;
 
@@ -142,6 +200,8 @@ enum fpm_nl_events {
 	FNE_RESET_COUNTERS,
 	/* Toggle next hop group feature. */
 	FNE_TOGGLE_NHG,
+	/* Change the amount of connections. */
+	FNE_CONNECTIONS,
 	/* Reconnect request by our own code to avoid races. */
 	FNE_INTERNAL_RECONNECT,
 
@@ -155,9 +215,9 @@ enum fpm_nl_events {
 	FNE_RMAC_FINISHED,
 };
 
-#define FPM_RECONNECT(fnc)                                                     \
-	thread_add_event((fnc)->fthread->master, fpm_process_event, (fnc),     \
-			 FNE_INTERNAL_RECONNECT, &(fnc)->t_event)
+#define FPM_RECONNECT(conn)                                                    \
+	thread_add_event((conn)->fthread->master, fpm_conn_event, (conn),      \
+			 FNE_INTERNAL_RECONNECT, &(conn)->t_event)
 
 #define WALK_FINISH(fnc, ev)                                                   \
 	thread_add_event((fnc)->fthread->master, fpm_process_event, (fnc),     \
@@ -167,7 +227,9 @@ enum fpm_nl_events {
  * Prototypes.
  */
 static void fpm_process_event(struct thread *t);
-static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx);
+static void fpm_conn_event(struct thread *t);
+static int fpm_nl_enqueue(struct fpm_nl_conn *conn,
+			  struct zebra_dplane_ctx *ctx);
 static void fpm_lsp_send(struct thread *t);
 static void fpm_lsp_reset(struct thread *t);
 static void fpm_nhg_send(struct thread *t);
@@ -282,6 +344,31 @@ DEFUN(no_fpm_use_nhg, no_fpm_use_nhg_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFUN(fpm_connections, fpm_connections_cmd,
+      "fpm connections (1-16)",
+      FPM_STR
+      "Amount of connections to the FPM server\n"
+      "Amount of connections\n")
+{
+	gfnc->conf_connections = strtoul(argv[2]->arg, NULL, 10);
+	thread_add_event(gfnc->fthread->master, fpm_process_event, gfnc,
+			 FNE_CONNECTIONS, NULL);
+	return CMD_SUCCESS;
+}
+
+DEFUN(no_fpm_connections, no_fpm_connections_cmd,
+      "no fpm connections [(1-16)]",
+      NO_STR
+      FPM_STR
+      "Amount of connections to the FPM server\n"
+      "Amount of connections\n")
+{
+	gfnc->conf_connections = 1;
+	thread_add_event(gfnc->fthread->master, fpm_process_event, gfnc,
+			 FNE_CONNECTIONS, NULL);
+	return CMD_SUCCESS;
+}
+
 DEFUN(fpm_reset_counters, fpm_reset_counters_cmd,
       "clear fpm counters",
       CLEAR_STR
@@ -293,30 +380,57 @@ DEFUN(fpm_reset_counters, fpm_reset_counters_cmd,
 	return CMD_SUCCESS;
 }
 
+/* Add up the counters of all connections. */
+static void fpm_counters_sum(struct fpm_nl_counters *sum)
+{
+	const struct fpm_nl_counters *c;
+	unsigned int i;
+
+	memset(sum, 0, sizeof(*sum));
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		c = &gfnc->conns[i].counters;
+
+		sum->bytes_read += c->bytes_read;
+		sum->bytes_sent += c->bytes_sent;
+		sum->obuf_bytes += c->obuf_bytes;
+		sum->obuf_peak = MAX(sum->obuf_peak, c->obuf_peak);
+		sum->connection_closes += c->connection_closes;
+		sum->connection_errors += c->connection_errors;
+		sum->dplane_contexts += c->dplane_contexts;
+		sum->ctxqueue_len += c->ctxqueue_len;
+		sum->ctxqueue_len_peak =
+			MAX(sum->ctxqueue_len_peak, c->ctxqueue_len_peak);
+		sum->buffer_full += c->buffer_full;
+		sum->write_blocked += c->write_blocked;
+	}
+}
+
 DEFUN(fpm_show_counters, fpm_show_counters_cmd,
       "show fpm counters",
       SHOW_STR
       FPM_STR
       "FPM statistic counters\n")
 {
+	struct fpm_nl_counters sum;
+
+	fpm_counters_sum(&sum);
+
 	vty_out(vty, "%30s\n%30s\n", "FPM counters", "============");
 
 #define SHOW_COUNTER(label, counter) \
 	vty_out(vty, "%28s: %u\n", (label), (counter))
 
-	SHOW_COUNTER("Input bytes", gfnc->counters.bytes_read);
-	SHOW_COUNTER("Output bytes", gfnc->counters.bytes_sent);
-	SHOW_COUNTER("Output buffer current size", gfnc->counters.obuf_bytes);
-	SHOW_COUNTER("Output buffer peak size", gfnc->counters.obuf_peak);
-	SHOW_COUNTER("Connection closes", gfnc->counters.connection_closes);
-	SHOW_COUNTER("Connection errors", gfnc->counters.connection_errors);
-	SHOW_COUNTER("Data plane items processed",
-		     gfnc->counters.dplane_contexts);
-	SHOW_COUNTER("Data plane items enqueued",
-		     gfnc->counters.ctxqueue_len);
-	SHOW_COUNTER("Data plane items queue peak",
-		     gfnc->counters.ctxqueue_len_peak);
-	SHOW_COUNTER("Buffer full hits", gfnc->counters.buffer_full);
+	SHOW_COUNTER("Input bytes", sum.bytes_read);
+	SHOW_COUNTER("Output bytes", sum.bytes_sent);
+	SHOW_COUNTER("Output buffer current size", sum.obuf_bytes);
+	SHOW_COUNTER("Output buffer peak size", sum.obuf_peak);
+	SHOW_COUNTER("Connection closes", sum.connection_closes);
+	SHOW_COUNTER("Connection errors", sum.connection_errors);
+	SHOW_COUNTER("Data plane items processed", sum.dplane_contexts);
+	SHOW_COUNTER("Data plane items enqueued", sum.ctxqueue_len);
+	SHOW_COUNTER("Data plane items queue peak", sum.ctxqueue_len_peak);
+	SHOW_COUNTER("Buffer full hits", sum.buffer_full);
+	SHOW_COUNTER("Socket write blocks", sum.write_blocked);
 	SHOW_COUNTER("User FPM configurations", gfnc->counters.user_configures);
 	SHOW_COUNTER("User FPM disable requests", gfnc->counters.user_disables);
 
@@ -333,23 +447,23 @@ DEFUN(fpm_show_counters_json, fpm_show_counters_json_cmd,
       JSON_STR)
 {
 	struct json_object *jo;
+	struct fpm_nl_counters sum;
+
+	fpm_counters_sum(&sum);
 
 	jo = json_object_new_object();
-	json_object_int_add(jo, "bytes-read", gfnc->counters.bytes_read);
-	json_object_int_add(jo, "bytes-sent", gfnc->counters.bytes_sent);
-	json_object_int_add(jo, "obuf-bytes", gfnc->counters.obuf_bytes);
-	json_object_int_add(jo, "obuf-bytes-peak", gfnc->counters.obuf_peak);
-	json_object_int_add(jo, "connection-closes",
-			    gfnc->counters.connection_closes);
-	json_object_int_add(jo, "connection-errors",
-			    gfnc->counters.connection_errors);
-	json_object_int_add(jo, "data-plane-contexts",
-			    gfnc->counters.dplane_contexts);
-	json_object_int_add(jo, "data-plane-contexts-queue",
-			    gfnc->counters.ctxqueue_len);
+	json_object_int_add(jo, "bytes-read", sum.bytes_read);
+	json_object_int_add(jo, "bytes-sent", sum.bytes_sent);
+	json_object_int_add(jo, "obuf-bytes", sum.obuf_bytes);
+	json_object_int_add(jo, "obuf-bytes-peak", sum.obuf_peak);
+	json_object_int_add(jo, "connection-closes", sum.connection_closes);
+	json_object_int_add(jo, "connection-errors", sum.connection_errors);
+	json_object_int_add(jo, "data-plane-contexts", sum.dplane_contexts);
+	json_object_int_add(jo, "data-plane-contexts-queue", sum.ctxqueue_len);
 	json_object_int_add(jo, "data-plane-contexts-queue-peak",
-			    gfnc->counters.ctxqueue_len_peak);
-	json_object_int_add(jo, "buffer-full-hits", gfnc->counters.buffer_full);
+			    sum.ctxqueue_len_peak);
+	json_object_int_add(jo, "buffer-full-hits", sum.buffer_full);
+	json_object_int_add(jo, "write-blocks", sum.write_blocked);
 	json_object_int_add(jo, "user-configures",
 			    gfnc->counters.user_configures);
 	json_object_int_add(jo, "user-disables", gfnc->counters.user_disables);
@@ -358,12 +472,126 @@ DEFUN(fpm_show_counters_json, fpm_show_counters_json_cmd,
 	return CMD_SUCCESS;
 }
 
+static const char *fpm_conn_state(const struct fpm_nl_conn *conn)
+{
+	if (conn->socket == -1)
+		return "down";
+	if (conn->connecting)
+		return "connecting";
+
+	return "up";
+}
+
+/* Per second rate of `count` since the connection came up. */
+static uint64_t fpm_conn_rate(const struct fpm_nl_conn *conn, uint32_t count)
+{
+	int64_t usecs;
+
+	if (conn->socket == -1)
+		return 0;
+
+	usecs = monotime_since(&conn->since, NULL);
+	if (usecs <= 0)
+		return 0;
+
+	return (uint64_t)count * 1000000 / usecs;
+}
+
+DEFUN(fpm_show_status, fpm_show_status_cmd,
+      "show fpm status [json]",
+      SHOW_STR
+      FPM_STR
+      "FPM connections status\n"
+      JSON_STR)
+{
+	struct fpm_nl_conn *conn;
+	struct json_object *jo = NULL, *jconns = NULL, *jconn;
+	uint32_t connections;
+	unsigned int i;
+
+	connections = atomic_load_explicit(&gfnc->connections,
+					   memory_order_relaxed);
+
+	if (argc == 4) {
+		jo = json_object_new_object();
+		json_object_boolean_add(jo, "disabled", gfnc->disabled);
+		json_object_boolean_add(jo, "use-next-hop-groups",
+					gfnc->use_nhg);
+		json_object_int_add(jo, "connections", connections);
+		jconns = json_object_new_array();
+		json_object_object_add(jo, "connection", jconns);
+	} else {
+		vty_out(vty, "FPM is %s, using %u connection%s\n\n",
+			gfnc->disabled ? "disabled" : "enabled", connections,
+			connections == 1 ? "" : "s");
+		vty_out(vty, "%4s %-10s %10s %8s %6s %8s %10s %12s\n", "Conn",
+			"State", "Processed", "Queue", "Batch", "Blocked",
+			"Items/s", "Bytes/s");
+	}
+
+	for (i = 0; i < connections; i++) {
+		conn = &gfnc->conns[i];
+
+		if (jconns) {
+			jconn = json_object_new_object();
+			json_object_int_add(jconn, "index", i);
+			json_object_string_add(jconn, "state",
+					       fpm_conn_state(conn));
+			json_object_int_add(jconn, "bytes-read",
+					    conn->counters.bytes_read);
+			json_object_int_add(jconn, "bytes-sent",
+					    conn->counters.bytes_sent);
+			json_object_int_add(jconn, "obuf-bytes",
+					    conn->counters.obuf_bytes);
+			json_object_int_add(jconn, "data-plane-contexts",
+					    conn->counters.dplane_contexts);
+			json_object_int_add(jconn, "data-plane-contexts-queue",
+					    conn->counters.ctxqueue_len);
+			json_object_int_add(jconn,
+					    "data-plane-contexts-queue-peak",
+					    conn->counters.ctxqueue_len_peak);
+			json_object_int_add(jconn, "batch", conn->batch);
+			json_object_int_add(jconn, "buffer-full-hits",
+					    conn->counters.buffer_full);
+			json_object_int_add(jconn, "write-blocks",
+					    conn->counters.write_blocked);
+			json_object_int_add(
+				jconn, "data-plane-contexts-per-second",
+				fpm_conn_rate(conn,
+					      conn->counters.dplane_contexts));
+			json_object_int_add(
+				jconn, "bytes-sent-per-second",
+				fpm_conn_rate(conn, conn->counters.bytes_sent));
+			json_object_array_add(jconns, jconn);
+			continue;
+		}
+
+		vty_out(vty, "%4u %-10s %10u %8u %6u %8u %10" PRIu64
+			     " %12" PRIu64 "\n",
+			i, fpm_conn_state(conn), conn->counters.dplane_contexts,
+			conn->counters.ctxqueue_len, conn->batch,
+			conn->counters.write_blocked,
+			fpm_conn_rate(conn, conn->counters.dplane_contexts),
+			fpm_conn_rate(conn, conn->counters.bytes_sent));
+	}
+
+	if (jo)
+		vty_json(vty, jo);
+
+	return CMD_SUCCESS;
+}
+
 static int fpm_write_config(struct vty *vty)
 {
 	struct sockaddr_in *sin;
 	struct sockaddr_in6 *sin6;
 	int written = 0;
 
+	if (gfnc->conf_connections != 1) {
+		vty_out(vty, "fpm connections %u\n", gfnc->conf_connections);
+		written = 1;
+	}
+
 	if (gfnc->disabled)
 		return written;
 
@@ -411,9 +639,8 @@ static struct cmd_node fpm_node = {
  */
 static void fpm_connect(struct thread *t);
 
-static void fpm_reconnect(struct fpm_nl_ctx *fnc)
+static void fpm_walk_cancel(struct fpm_nl_ctx *fnc)
 {
-	/* Cancel all zebra threads first. */
 	thread_cancel_async(zrouter.master, &fnc->t_lspreset, NULL);
 	thread_cancel_async(zrouter.master, &fnc->t_lspwalk, NULL);
 	thread_cancel_async(zrouter.master, &fnc->t_nhgreset, NULL);
@@ -422,35 +649,65 @@ static void fpm_reconnect(struct fpm_nl_ctx *fnc)
 	thread_cancel_async(zrouter.master, &fnc->t_ribwalk, NULL);
 	thread_cancel_async(zrouter.master, &fnc->t_rmacreset, NULL);
 	thread_cancel_async(zrouter.master, &fnc->t_rmacwalk, NULL);
+}
+
+static bool fpm_conn_others_up(const struct fpm_nl_conn *conn)
+{
+	const struct fpm_nl_ctx *fnc = conn->fnc;
+	unsigned int i;
+
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++)
+		if (i != conn->idx && fnc->conns[i].socket != -1)
+			return true;
+
+	return false;
+}
+
+static void fpm_reconnect(struct fpm_nl_conn *conn)
+{
+	struct fpm_nl_ctx *fnc = conn->fnc;
+
+	/*
+	 * Cancel all zebra threads first, unless another connection still
+	 * needs the walk: this one will get its share of it again once
+	 * connected.
+	 */
+	if (!fpm_conn_others_up(conn))
+		fpm_walk_cancel(fnc);
 
 	/*
 	 * Grab the lock to empty the streams (data plane might try to
 	 * enqueue updates while we are closing).
 	 */
-	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
+	frr_mutex_lock_autounlock(&conn->obuf_mutex);
 
 	/* Avoid calling close on `-1`. */
-	if (fnc->socket != -1) {
-		close(fnc->socket);
-		fnc->socket = -1;
+	if (conn->socket != -1) {
+		close(conn->socket);
+		conn->socket = -1;
 	}
 
-	stream_reset(fnc->ibuf);
-	stream_reset(fnc->obuf);
-	THREAD_OFF(fnc->t_read);
-	THREAD_OFF(fnc->t_write);
-
-	/* FPM is disabled, don't attempt to connect. */
-	if (fnc->disabled)
+	stream_reset(conn->ibuf);
+	stream_reset(conn->obuf);
+	atomic_store_explicit(&conn->counters.obuf_bytes, 0,
+			      memory_order_relaxed);
+	THREAD_OFF(conn->t_read);
+	THREAD_OFF(conn->t_write);
+	THREAD_OFF(conn->t_connect);
+
+	/* FPM is disabled or connection unused, don't attempt to connect. */
+	if (fnc->disabled
+	    || conn->idx >= atomic_load_explicit(&fnc->connections,
+						 memory_order_relaxed))
 		return;
 
-	thread_add_timer(fnc->fthread->master, fpm_connect, fnc, 3,
-			 &fnc->t_connect);
+	thread_add_timer(conn->fthread->master, fpm_connect, conn, 3,
+			 &conn->t_connect);
 }
 
 static void fpm_read(struct thread *t)
 {
-	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
+	struct fpm_nl_conn *conn = THREAD_ARG(t);
 	fpm_msg_hdr_t fpm;
 	ssize_t rv;
 	char buf[65535];
@@ -460,30 +717,30 @@ static void fpm_read(struct thread *t)
 	size_t hdr_available_bytes;
 
 	/* Let's ignore the input at the moment. */
-	rv = stream_read_try(fnc->ibuf, fnc->socket,
-			     STREAM_WRITEABLE(fnc->ibuf));
+	rv = stream_read_try(conn->ibuf, conn->socket,
+			     STREAM_WRITEABLE(conn->ibuf));
 	if (rv == 0) {
-		atomic_fetch_add_explicit(&fnc->counters.connection_closes, 1,
+		atomic_fetch_add_explicit(&conn->counters.connection_closes, 1,
 					  memory_order_relaxed);
 
 		if (IS_ZEBRA_DEBUG_FPM)
 			zlog_debug("%s: connection closed", __func__);
 
-		FPM_RECONNECT(fnc);
+		FPM_RECONNECT(conn);
 		return;
 	}
 	if (rv == -1) {
-		atomic_fetch_add_explicit(&fnc->counters.connection_errors, 1,
+		atomic_fetch_add_explicit(&conn->counters.connection_errors, 1,
 					  memory_order_relaxed);
 		zlog_warn("%s: connection failure: %s", __func__,
 			  strerror(errno));
-		FPM_RECONNECT(fnc);
+		FPM_RECONNECT(conn);
 		return;
 	}
 
 	/* Schedule the next read */
-	thread_add_read(fnc->fthread->master, fpm_read, fnc, fnc->socket,
-			&fnc->t_read);
+	thread_add_read(conn->fthread->master, fpm_read, conn, conn->socket,
+			&conn->t_read);
 
 	/* We've got an interruption. */
 	if (rv == -2)
@@ -491,28 +748,28 @@ static void fpm_read(struct thread *t)
 
 
 	/* Account all bytes read. */
-	atomic_fetch_add_explicit(&fnc->counters.bytes_read, rv,
+	atomic_fetch_add_explicit(&conn->counters.bytes_read, rv,
 				  memory_order_relaxed);
 
-	available_bytes = STREAM_READABLE(fnc->ibuf);
+	available_bytes = STREAM_READABLE(conn->ibuf);
 	while (available_bytes) {
 		if (available_bytes < (ssize_t)FPM_MSG_HDR_LEN) {
-			stream_pulldown(fnc->ibuf);
+			stream_pulldown(conn->ibuf);
 			return;
 		}
 
-		fpm.version = stream_getc(fnc->ibuf);
-		fpm.msg_type = stream_getc(fnc->ibuf);
-		fpm.msg_len = stream_getw(fnc->ibuf);
+		fpm.version = stream_getc(conn->ibuf);
+		fpm.msg_type = stream_getc(conn->ibuf);
+		fpm.msg_len = stream_getw(conn->ibuf);
 
 		if (fpm.version != FPM_PROTO_VERSION &&
 		    fpm.msg_type != FPM_MSG_TYPE_NETLINK) {
-			stream_reset(fnc->ibuf);
+			stream_reset(conn->ibuf);
 			zlog_warn(
 				"%s: Received version/msg_type %u/%u, expected 1/1",
 				__func__, fpm.version, fpm.msg_type);
 
-			FPM_RECONNECT(fnc);
+			FPM_RECONNECT(conn);
 			return;
 		}
 
@@ -524,7 +781,7 @@ static void fpm_read(struct thread *t)
 			zlog_warn(
 				"%s: Received message length: %u that does not even fill the FPM header",
 				__func__, fpm.msg_len);
-			FPM_RECONNECT(fnc);
+			FPM_RECONNECT(conn);
 			return;
 		}
 
@@ -534,8 +791,8 @@ static void fpm_read(struct thread *t)
 		 * top.
 		 */
 		if (fpm.msg_len > available_bytes) {
-			stream_rewind_getp(fnc->ibuf, FPM_MSG_HDR_LEN);
-			stream_pulldown(fnc->ibuf);
+			stream_rewind_getp(conn->ibuf, FPM_MSG_HDR_LEN);
+			stream_pulldown(conn->ibuf);
 			return;
 		}
 
@@ -545,7 +802,7 @@ static void fpm_read(struct thread *t)
 		 * Place the data from the stream into a buffer
 		 */
 		hdr = (struct nlmsghdr *)buf;
-		stream_get(buf, fnc->ibuf, fpm.msg_len - FPM_MSG_HDR_LEN);
+		stream_get(buf, conn->ibuf, fpm.msg_len - FPM_MSG_HDR_LEN);
 		hdr_available_bytes = fpm.msg_len - FPM_MSG_HDR_LEN;
 		available_bytes -= hdr_available_bytes;
 
@@ -561,7 +818,7 @@ static void fpm_read(struct thread *t)
 			zlog_warn(
 				"%s: Received a inner header length of %u that is greater than the fpm total length of %u",
 				__func__, hdr->nlmsg_len, fpm.msg_len);
-			FPM_RECONNECT(fnc);
+			FPM_RECONNECT(conn);
 		}
 		/* Not enough bytes available. */
 		if (hdr->nlmsg_len > hdr_available_bytes) {
@@ -591,7 +848,7 @@ static void fpm_read(struct thread *t)
 			if (netlink_route_change_read_unicast_internal(
 				    hdr, 0, false, ctx) != 1) {
 				dplane_ctx_fini(&ctx);
-				stream_pulldown(fnc->ibuf);
+				stream_pulldown(conn->ibuf);
 				/*
 				 * Let's continue to read other messages
 				 * Even if we ignore this one.
@@ -607,22 +864,22 @@ static void fpm_read(struct thread *t)
 		}
 	}
 
-	stream_reset(fnc->ibuf);
+	stream_reset(conn->ibuf);
 }
 
 static void fpm_write(struct thread *t)
 {
-	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
+	struct fpm_nl_conn *conn = THREAD_ARG(t);
 	socklen_t statuslen;
 	ssize_t bwritten;
 	int rv, status;
 	size_t btotal;
 
-	if (fnc->connecting == true) {
+	if (conn->connecting == true) {
 		status = 0;
 		statuslen = sizeof(status);
 
-		rv = getsockopt(fnc->socket, SOL_SOCKET, SO_ERROR, &status,
+		rv = getsockopt(conn->socket, SOL_SOCKET, SO_ERROR, &status,
 				&statuslen);
 		if (rv == -1 || status != 0) {
 			if (rv != -1)
@@ -633,43 +890,44 @@ static void fpm_write(struct thread *t)
 					  strerror(status));
 
 			atomic_fetch_add_explicit(
-				&fnc->counters.connection_errors, 1,
+				&conn->counters.connection_errors, 1,
 				memory_order_relaxed);
 
-			FPM_RECONNECT(fnc);
+			FPM_RECONNECT(conn);
 			return;
 		}
 
-		fnc->connecting = false;
+		conn->connecting = false;
+		monotime(&conn->since);
 
 		/*
 		 * Starting with LSPs walk all FPM objects, marking them
 		 * as unsent and then replaying them.
 		 */
-		thread_add_timer(zrouter.master, fpm_lsp_reset, fnc, 0,
-				 &fnc->t_lspreset);
+		thread_add_timer(zrouter.master, fpm_lsp_reset, conn->fnc, 0,
+				 &conn->fnc->t_lspreset);
 
 		/* Permit receiving messages now. */
-		thread_add_read(fnc->fthread->master, fpm_read, fnc,
-				fnc->socket, &fnc->t_read);
+		thread_add_read(conn->fthread->master, fpm_read, conn,
+				conn->socket, &conn->t_read);
 	}
 
-	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
+	frr_mutex_lock_autounlock(&conn->obuf_mutex);
 
 	while (true) {
 		/* Stream is empty: reset pointers and return. */
-		if (STREAM_READABLE(fnc->obuf) == 0) {
-			stream_reset(fnc->obuf);
+		if (STREAM_READABLE(conn->obuf) == 0) {
+			stream_reset(conn->obuf);
 			break;
 		}
 
 		/* Try to write all at once. */
-		btotal = stream_get_endp(fnc->obuf) -
-			stream_get_getp(fnc->obuf);
-		bwritten = write(fnc->socket, stream_pnt(fnc->obuf), btotal);
+		btotal = stream_get_endp(conn->obuf) -
+			stream_get_getp(conn->obuf);
+		bwritten = write(conn->socket, stream_pnt(conn->obuf), btotal);
 		if (bwritten == 0) {
 			atomic_fetch_add_explicit(
-				&fnc->counters.connection_closes, 1,
+				&conn->counters.connection_closes, 1,
 				memory_order_relaxed);
 
 			if (IS_ZEBRA_DEBUG_FPM)
@@ -681,60 +939,65 @@ static void fpm_write(struct thread *t)
 			if (errno == EINTR)
 				continue;
 			/* Receiver is probably slow, lets give it some time. */
-			if (errno == EAGAIN || errno == EWOULDBLOCK)
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				atomic_fetch_add_explicit(
+					&conn->counters.write_blocked, 1,
+					memory_order_relaxed);
+				conn->blocked = true;
 				break;
+			}
 
 			atomic_fetch_add_explicit(
-				&fnc->counters.connection_errors, 1,
+				&conn->counters.connection_errors, 1,
 				memory_order_relaxed);
 			zlog_warn("%s: connection failure: %s", __func__,
 				  strerror(errno));
 
-			FPM_RECONNECT(fnc);
+			FPM_RECONNECT(conn);
 			return;
 		}
 
 		/* Account all bytes sent. */
-		atomic_fetch_add_explicit(&fnc->counters.bytes_sent, bwritten,
+		atomic_fetch_add_explicit(&conn->counters.bytes_sent, bwritten,
 					  memory_order_relaxed);
 
 		/* Account number of bytes free. */
-		atomic_fetch_sub_explicit(&fnc->counters.obuf_bytes, bwritten,
+		atomic_fetch_sub_explicit(&conn->counters.obuf_bytes, bwritten,
 					  memory_order_relaxed);
 
-		stream_forward_getp(fnc->obuf, (size_t)bwritten);
+		stream_forward_getp(conn->obuf, (size_t)bwritten);
 	}
 
 	/* Stream is not empty yet, we must schedule more writes. */
-	if (STREAM_READABLE(fnc->obuf)) {
-		stream_pulldown(fnc->obuf);
-		thread_add_write(fnc->fthread->master, fpm_write, fnc,
-				 fnc->socket, &fnc->t_write);
+	if (STREAM_READABLE(conn->obuf)) {
+		stream_pulldown(conn->obuf);
+		thread_add_write(conn->fthread->master, fpm_write, conn,
+				 conn->socket, &conn->t_write);
 		return;
 	}
 }
 
 static void fpm_connect(struct thread *t)
 {
-	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
-	struct sockaddr_in *sin = (struct sockaddr_in *)&fnc->addr;
-	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&fnc->addr;
+	struct fpm_nl_conn *conn = THREAD_ARG(t);
+	struct sockaddr_in *sin = (struct sockaddr_in *)&conn->fnc->addr;
+	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&conn->fnc->addr;
 	socklen_t slen;
 	int rv, sock;
 	char addrstr[INET6_ADDRSTRLEN];
 
-	sock = socket(fnc->addr.ss_family, SOCK_STREAM, 0);
+	sock = socket(conn->fnc->addr.ss_family, SOCK_STREAM, 0);
 	if (sock == -1) {
 		zlog_err("%s: fpm socket failed: %s", __func__,
 			 strerror(errno));
-		thread_add_timer(fnc->fthread->master, fpm_connect, fnc, 3,
-				 &fnc->t_connect);
+		thread_add_timer(conn->fthread->master, fpm_connect, conn, 3,
+				 &conn->t_connect);
 		return;
 	}
 
 	set_nonblocking(sock);
 
-	if (fnc->addr.ss_family == AF_INET) {
+	if (conn->fnc->addr.ss_family == AF_INET) {
 		inet_ntop(AF_INET, &sin->sin_addr, addrstr, sizeof(addrstr));
 		slen = sizeof(*sin);
 	} else {
@@ -746,25 +1009,26 @@ static void fpm_connect(struct thread *t)
 		zlog_debug("%s: attempting to connect to %s:%d", __func__,
 			   addrstr, ntohs(sin->sin_port));
 
-	rv = connect(sock, (struct sockaddr *)&fnc->addr, slen);
+	rv = connect(sock, (struct sockaddr *)&conn->fnc->addr, slen);
 	if (rv == -1 && errno != EINPROGRESS) {
-		atomic_fetch_add_explicit(&fnc->counters.connection_errors, 1,
+		atomic_fetch_add_explicit(&conn->counters.connection_errors, 1,
 					  memory_order_relaxed);
 		close(sock);
 		zlog_warn("%s: fpm connection failed: %s", __func__,
 			  strerror(errno));
-		thread_add_timer(fnc->fthread->master, fpm_connect, fnc, 3,
-				 &fnc->t_connect);
+		thread_add_timer(conn->fthread->master, fpm_connect, conn, 3,
+				 &conn->t_connect);
 		return;
 	}
 
-	fnc->connecting = (errno == EINPROGRESS);
-	fnc->socket = sock;
-	if (!fnc->connecting)
-		thread_add_read(fnc->fthread->master, fpm_read, fnc, sock,
-				&fnc->t_read);
-	thread_add_write(fnc->fthread->master, fpm_write, fnc, sock,
-			 &fnc->t_write);
+	conn->connecting = (errno == EINPROGRESS);
+	conn->socket = sock;
+	monotime(&conn->since);
+	if (!conn->connecting)
+		thread_add_read(conn->fthread->master, fpm_read, conn, sock,
+				&conn->t_read);
+	thread_add_write(conn->fthread->master, fpm_write, conn, sock,
+			 &conn->t_write);
 
 	/*
 	 * Starting with LSPs walk all FPM objects, marking them
@@ -772,21 +1036,23 @@ static void fpm_connect(struct thread *t)
 	 *
 	 * If we are not connected, then delay the objects reset/send.
 	 */
-	if (!fnc->connecting)
-		thread_add_timer(zrouter.master, fpm_lsp_reset, fnc, 0,
-				 &fnc->t_lspreset);
+	if (!conn->connecting)
+		thread_add_timer(zrouter.master, fpm_lsp_reset, conn->fnc, 0,
+				 &conn->fnc->t_lspreset);
 }
 
 /**
  * Encode data plane operation context into netlink and enqueue it in the FPM
  * output buffer.
  *
- * @param fnc the netlink FPM context.
+ * @param conn the FPM server connection.
  * @param ctx the data plane operation context data.
  * @return 0 on success or -1 on not enough space.
  */
-static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
+static int fpm_nl_enqueue(struct fpm_nl_conn *conn,
+			  struct zebra_dplane_ctx *ctx)
 {
+	struct fpm_nl_ctx *fnc = conn->fnc;
 	uint8_t nl_buf[NL_PKT_BUF_SIZE];
 	size_t nl_buf_len;
 	ssize_t rv;
@@ -804,7 +1070,7 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 
 	nl_buf_len = 0;
 
-	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
+	frr_mutex_lock_autounlock(&conn->obuf_mutex);
 
 	switch (op) {
 	case DPLANE_OP_ROUTE_UPDATE:
@@ -945,15 +1211,15 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 	assert((nl_buf_len + FPM_HEADER_SIZE) <= UINT16_MAX);
 
 	/* Check if we have enough buffer space. */
-	if (STREAM_WRITEABLE(fnc->obuf) < (nl_buf_len + FPM_HEADER_SIZE)) {
-		atomic_fetch_add_explicit(&fnc->counters.buffer_full, 1,
+	if (STREAM_WRITEABLE(conn->obuf) < (nl_buf_len + FPM_HEADER_SIZE)) {
+		atomic_fetch_add_explicit(&conn->counters.buffer_full, 1,
 					  memory_order_relaxed);
 
 		if (IS_ZEBRA_DEBUG_FPM)
 			zlog_debug(
 				"%s: buffer full: wants to write %zu but has %zu",
 				__func__, nl_buf_len + FPM_HEADER_SIZE,
-				STREAM_WRITEABLE(fnc->obuf));
+				STREAM_WRITEABLE(conn->obuf));
 
 		return -1;
 	}
@@ -963,32 +1229,100 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 	 *
 	 * See FPM_HEADER_SIZE definition for more information.
 	 */
-	stream_putc(fnc->obuf, 1);
-	stream_putc(fnc->obuf, 1);
-	stream_putw(fnc->obuf, nl_buf_len + FPM_HEADER_SIZE);
+	stream_putc(conn->obuf, 1);
+	stream_putc(conn->obuf, 1);
+	stream_putw(conn->obuf, nl_buf_len + FPM_HEADER_SIZE);
 
 	/* Write current data. */
-	stream_write(fnc->obuf, nl_buf, (size_t)nl_buf_len);
+	stream_write(conn->obuf, nl_buf, (size_t)nl_buf_len);
 
 	/* Account number of bytes waiting to be written. */
-	atomic_fetch_add_explicit(&fnc->counters.obuf_bytes,
+	atomic_fetch_add_explicit(&conn->counters.obuf_bytes,
 				  nl_buf_len + FPM_HEADER_SIZE,
 				  memory_order_relaxed);
-	obytes = atomic_load_explicit(&fnc->counters.obuf_bytes,
+	obytes = atomic_load_explicit(&conn->counters.obuf_bytes,
 				      memory_order_relaxed);
-	obytes_peak = atomic_load_explicit(&fnc->counters.obuf_peak,
+	obytes_peak = atomic_load_explicit(&conn->counters.obuf_peak,
 					   memory_order_relaxed);
 	if (obytes_peak < obytes)
-		atomic_store_explicit(&fnc->counters.obuf_peak, obytes,
+		atomic_store_explicit(&conn->counters.obuf_peak, obytes,
 				      memory_order_relaxed);
 
 	/* Tell the thread to start writing. */
-	thread_add_write(fnc->fthread->master, fpm_write, fnc, fnc->socket,
-			 &fnc->t_write);
+	thread_add_write(conn->fthread->master, fpm_write, conn, conn->socket,
+			 &conn->t_write);
 
 	return 0;
 }
 
+static bool fpm_nl_op_is_nhg(enum dplane_op_e op)
+{
+	return op == DPLANE_OP_NH_INSTALL || op == DPLANE_OP_NH_UPDATE
+	       || op == DPLANE_OP_NH_DELETE;
+}
+
+/*
+ * Connection a data plane context goes through: routes are spread by prefix,
+ * so that the updates of one prefix keep their order, everything else goes
+ * through the first connection.  Next hop groups are also sent on all the
+ * others (see fpm_nl_process()), so that every connection sees a group before
+ * the routes using it, and the routes leaving it before its delete.
+ */
+static struct fpm_nl_conn *fpm_nl_ctx_conn(struct fpm_nl_ctx *fnc,
+					   const struct zebra_dplane_ctx *ctx)
+{
+	enum dplane_op_e op = dplane_ctx_get_op(ctx);
+	uint32_t connections;
+
+	connections = atomic_load_explicit(&fnc->connections,
+					   memory_order_relaxed);
+	if (connections <= 1)
+		return &fnc->conns[0];
+
+	if (op == DPLANE_OP_ROUTE_INSTALL || op == DPLANE_OP_ROUTE_UPDATE
+	    || op == DPLANE_OP_ROUTE_DELETE)
+		return &fnc->conns[prefix_hash_key(dplane_ctx_get_dest(ctx))
+				   % connections];
+
+	return &fnc->conns[0];
+}
+
+/*
+ * Enqueue a context built by one of the walks below. Contexts for connections
+ * that are not up are skipped: they will be walked again once connected.
+ *
+ * @return 0 on success or -1 on not enough space.
+ */
+static int fpm_nl_walk_enqueue(struct fpm_nl_ctx *fnc,
+			       struct zebra_dplane_ctx *ctx)
+{
+	struct fpm_nl_conn *conn;
+	uint32_t connections;
+	unsigned int i;
+
+	if (fpm_nl_op_is_nhg(dplane_ctx_get_op(ctx))) {
+		connections = atomic_load_explicit(&fnc->connections,
+						   memory_order_relaxed);
+		for (i = 0; i < connections; i++) {
+			conn = &fnc->conns[i];
+			if (conn->socket == -1 || conn->connecting)
+				continue;
+
+			/* Groups sent already are just replaced on retry. */
+			if (fpm_nl_enqueue(conn, ctx) == -1)
+				return -1;
+		}
+
+		return 0;
+	}
+
+	conn = fpm_nl_ctx_conn(fnc, ctx);
+	if (conn->socket == -1 || conn->connecting)
+		return 0;
+
+	return fpm_nl_enqueue(conn, ctx);
+}
+
 /*
  * LSP walk/send functions
  */
@@ -1010,7 +1344,7 @@ static int fpm_lsp_send_cb(struct hash_bucket *bucket, void *arg)
 	dplane_ctx_reset(fla->ctx);
 	dplane_ctx_lsp_init(fla->ctx, DPLANE_OP_LSP_INSTALL, lsp);
 
-	if (fpm_nl_enqueue(fla->fnc, fla->ctx) == -1) {
+	if (fpm_nl_walk_enqueue(fla->fnc, fla->ctx) == -1) {
 		fla->complete = false;
 		return HASHWALK_ABORT;
 	}
@@ -1068,7 +1402,7 @@ static int fpm_nhg_send_cb(struct hash_bucket *bucket, void *arg)
 	/* Reset ctx to reuse allocated memory, take a snapshot and send it. */
 	dplane_ctx_reset(fna->ctx);
 	dplane_ctx_nexthop_init(fna->ctx, DPLANE_OP_NH_INSTALL, nhe);
-	if (fpm_nl_enqueue(fna->fnc, fna->ctx) == -1) {
+	if (fpm_nl_walk_enqueue(fna->fnc, fna->ctx) == -1) {
 		/* Our buffers are full, lets give it some cycles. */
 		fna->complete = false;
 		return HASHWALK_ABORT;
@@ -1137,7 +1471,7 @@ static void fpm_rib_send(struct thread *t)
 			dplane_ctx_reset(ctx);
 			dplane_ctx_route_init(ctx, DPLANE_OP_ROUTE_INSTALL, rn,
 					      dest->selected_fib);
-			if (fpm_nl_enqueue(fnc, ctx) == -1) {
+			if (fpm_nl_walk_enqueue(fnc, ctx) == -1) {
 				/* Free the temporary allocated context. */
 				dplane_ctx_fini(&ctx);
 
@@ -1198,7 +1532,7 @@ static void fpm_enqueue_rmac_table(struct hash_bucket *bucket, void *arg)
 			zif->brslave_info.br_if, vid, &zrmac->macaddr, vni->vni,
 			zrmac->fwd_info.r_vtep_ip, sticky, 0 /*nhg*/,
 			0 /*update_flags*/);
-	if (fpm_nl_enqueue(fra->fnc, fra->ctx) == -1) {
+	if (fpm_nl_walk_enqueue(fra->fnc, fra->ctx) == -1) {
 		thread_add_timer(zrouter.master, fpm_rmac_send,
 				 fra->fnc, 1, &fra->fnc->t_rmacwalk);
 		fra->complete = false;
@@ -1326,53 +1660,94 @@ static void fpm_rmac_reset(struct thread *t)
 			 &fnc->t_rmacwalk);
 }
 
+/*
+ * Adapt the batch size to the server speed: shrink it when the server
+ * pushed back since the last run, grow it when all we had to send is gone.
+ */
+static void fpm_conn_batch_adjust(struct fpm_nl_conn *conn)
+{
+	uint32_t batch;
+	bool drained;
+
+	frr_with_mutex (&conn->obuf_mutex) {
+		drained = (STREAM_READABLE(conn->obuf) == 0);
+	}
+
+	batch = atomic_load_explicit(&conn->batch, memory_order_relaxed);
+	if (conn->blocked)
+		batch = MAX(batch / 2, FPM_BATCH_MIN);
+	else if (drained)
+		batch = MIN(batch * 2, FPM_BATCH_MAX);
+
+	conn->blocked = false;
+	atomic_store_explicit(&conn->batch, batch, memory_order_relaxed);
+}
+
 static void fpm_process_queue(struct thread *t)
 {
-	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
+	struct fpm_nl_conn *conn = THREAD_ARG(t);
+	struct fpm_nl_ctx *fnc = conn->fnc;
 	struct zebra_dplane_ctx *ctx;
 	bool no_bufs = false;
 	uint64_t processed_contexts = 0;
+	uint32_t batch;
 
-	while (true) {
-		/* No space available yet. */
-		if (STREAM_WRITEABLE(fnc->obuf) < NL_PKT_BUF_SIZE) {
-			no_bufs = true;
-			break;
-		}
+	fpm_conn_batch_adjust(conn);
+	batch = atomic_load_explicit(&conn->batch, memory_order_relaxed);
 
-		/* Dequeue next item or quit processing. */
-		frr_with_mutex (&fnc->ctxqueue_mutex) {
-			ctx = dplane_ctx_dequeue(&fnc->ctxqueue);
+	/* Take the next batch with a single lock. */
+	frr_with_mutex (&conn->ctxqueue_mutex) {
+		while (conn->pending_len < batch) {
+			ctx = dplane_ctx_dequeue(&conn->ctxqueue);
+			if (ctx == NULL)
+				break;
+
+			dplane_ctx_enqueue_tail(&conn->pending, ctx);
+			conn->pending_len++;
 		}
-		if (ctx == NULL)
+	}
+
+	while ((ctx = dplane_ctx_get_head(&conn->pending)) != NULL) {
+		/* No space available yet, keep it for the next run. */
+		if (conn->socket != -1 && fpm_nl_enqueue(conn, ctx) == -1) {
+			conn->blocked = true;
+			no_bufs = true;
 			break;
+		}
 
-		/*
-		 * Intentionally ignoring the return value
-		 * as that we are ensuring that we can write to
-		 * the output data in the STREAM_WRITEABLE
-		 * check above, so we can ignore the return
-		 */
-		if (fnc->socket != -1)
-			(void)fpm_nl_enqueue(fnc, ctx);
+		dplane_ctx_dequeue(&conn->pending);
+		conn->pending_len--;
 
 		/* Account the processed entries. */
 		processed_contexts++;
-		atomic_fetch_sub_explicit(&fnc->counters.ctxqueue_len, 1,
+		atomic_fetch_sub_explicit(&conn->counters.ctxqueue_len, 1,
 					  memory_order_relaxed);
 
+		/* Copies of next hop groups are ours, see fpm_nl_process(). */
+		if (conn->idx != 0
+		    && fpm_nl_op_is_nhg(dplane_ctx_get_op(ctx))) {
+			dplane_ctx_fini(&ctx);
+			continue;
+		}
+
 		dplane_ctx_set_status(ctx, ZEBRA_DPLANE_REQUEST_SUCCESS);
 		dplane_provider_enqueue_out_ctx(fnc->prov, ctx);
 	}
 
 	/* Update count of processed contexts */
-	atomic_fetch_add_explicit(&fnc->counters.dplane_contexts,
+	atomic_fetch_add_explicit(&conn->counters.dplane_contexts,
 				  processed_contexts, memory_order_relaxed);
 
-	/* Re-schedule if we ran out of buffer space */
-	if (no_bufs)
-		thread_add_timer(fnc->fthread->master, fpm_process_queue,
-				 fnc, 0, &fnc->t_dequeue);
+	/*
+	 * Re-schedule if we ran out of buffer space or if there is more than
+	 * a batch waiting.
+	 */
+	if (no_bufs
+	    || atomic_load_explicit(&conn->counters.ctxqueue_len,
+				    memory_order_relaxed)
+		       > 0)
+		thread_add_timer(conn->fthread->master, fpm_process_queue,
+				 conn, 0, &conn->t_dequeue);
 
 	/*
 	 * Let the dataplane thread know if there are items in the
@@ -1384,6 +1759,93 @@ static void fpm_process_queue(struct thread *t)
 		dplane_provider_work_ready();
 }
 
+/**
+ * Handles the events of one connection, in its pthread.
+ */
+static void fpm_conn_event(struct thread *t)
+{
+	struct fpm_nl_conn *conn = THREAD_ARG(t);
+	enum fpm_nl_events event = THREAD_VAL(t);
+	uint32_t ctxqueue_len, obuf_bytes;
+
+	switch (event) {
+	case FNE_INTERNAL_RECONNECT:
+		fpm_reconnect(conn);
+		break;
+
+	case FNE_RESET_COUNTERS:
+		/* Keep what describes the current queue and buffer. */
+		ctxqueue_len = atomic_load_explicit(
+			&conn->counters.ctxqueue_len, memory_order_relaxed);
+		obuf_bytes = atomic_load_explicit(&conn->counters.obuf_bytes,
+						  memory_order_relaxed);
+		memset(&conn->counters, 0, sizeof(conn->counters));
+		atomic_store_explicit(&conn->counters.ctxqueue_len,
+				      ctxqueue_len, memory_order_relaxed);
+		atomic_store_explicit(&conn->counters.obuf_bytes, obuf_bytes,
+				      memory_order_relaxed);
+		monotime(&conn->since);
+		break;
+
+	case FNE_RECONNECT:
+	case FNE_DISABLE:
+	case FNE_TOGGLE_NHG:
+	case FNE_CONNECTIONS:
+	case FNE_LSP_FINISHED:
+	case FNE_NHG_FINISHED:
+	case FNE_RIB_FINISHED:
+	case FNE_RMAC_FINISHED:
+		break;
+	}
+}
+
+/* Connections get their buffers and pthread the first time they are used. */
+static void fpm_conn_start(struct fpm_nl_conn *conn)
+{
+	char name[64], os_name[OS_THREAD_NAMELEN];
+
+	if (conn->fthread)
+		return;
+
+	snprintf(name, sizeof(name), "%s connection %u", prov_name,
+		 conn->idx);
+	snprintf(os_name, sizeof(os_name), "fpm_nl_%u", conn->idx);
+
+	conn->ibuf = stream_new(NL_PKT_BUF_SIZE);
+	conn->obuf = stream_new(NL_PKT_BUF_SIZE * 128);
+	conn->fthread = frr_pthread_new(NULL, name, os_name);
+	assert(frr_pthread_run(conn->fthread, NULL) == 0);
+}
+
+/*
+ * Ask all connections to reconnect (or to just close, when disabled or no
+ * longer in use).
+ */
+static void fpm_reconnect_all(struct fpm_nl_ctx *fnc)
+{
+	struct fpm_nl_conn *conn;
+	uint32_t connections;
+	unsigned int i;
+
+	/* Cancel all zebra threads first. */
+	fpm_walk_cancel(fnc);
+
+	connections = atomic_load_explicit(&fnc->connections,
+					   memory_order_relaxed);
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		if (conn->fthread == NULL) {
+			if (fnc->disabled || i >= connections)
+				continue;
+
+			fpm_conn_start(conn);
+		}
+
+		thread_add_event(conn->fthread->master, fpm_conn_event, conn,
+				 FNE_INTERNAL_RECONNECT, &conn->t_event);
+	}
+}
+
 /**
  * Handles external (e.g. CLI, data plane or others) events.
  */
@@ -1391,6 +1853,7 @@ static void fpm_process_event(struct thread *t)
 {
 	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
 	enum fpm_nl_events event = THREAD_VAL(t);
+	unsigned int i;
 
 	switch (event) {
 	case FNE_DISABLE:
@@ -1400,7 +1863,7 @@ static void fpm_process_event(struct thread *t)
 					  memory_order_relaxed);
 
 		/* Call reconnect to disable timers and clean up context. */
-		fpm_reconnect(fnc);
+		fpm_reconnect_all(fnc);
 		break;
 
 	case FNE_RECONNECT:
@@ -1408,22 +1871,43 @@ static void fpm_process_event(struct thread *t)
 		fnc->disabled = false;
 		atomic_fetch_add_explicit(&fnc->counters.user_configures, 1,
 					  memory_order_relaxed);
-		fpm_reconnect(fnc);
+		fpm_reconnect_all(fnc);
 		break;
 
 	case FNE_RESET_COUNTERS:
 		zlog_info("%s: manual FPM counters reset event", __func__);
 		memset(&fnc->counters, 0, sizeof(fnc->counters));
+		for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+			if (fnc->conns[i].fthread == NULL)
+				continue;
+
+			thread_add_event(fnc->conns[i].fthread->master,
+					 fpm_conn_event, &fnc->conns[i],
+					 FNE_RESET_COUNTERS, NULL);
+		}
 		break;
 
 	case FNE_TOGGLE_NHG:
 		zlog_info("%s: toggle next hop groups support", __func__);
 		fnc->use_nhg = !fnc->use_nhg;
-		fpm_reconnect(fnc);
+		fpm_reconnect_all(fnc);
+		break;
+
+	case FNE_CONNECTIONS:
+		if (fnc->conf_connections
+		    == atomic_load_explicit(&fnc->connections,
+					    memory_order_relaxed))
+			break;
+
+		zlog_info("%s: using %u FPM connections", __func__,
+			  fnc->conf_connections);
+		atomic_store_explicit(&fnc->connections, fnc->conf_connections,
+				      memory_order_relaxed);
+		fpm_reconnect_all(fnc);
 		break;
 
 	case FNE_INTERNAL_RECONNECT:
-		fpm_reconnect(fnc);
+		fpm_reconnect_all(fnc);
 		break;
 
 	case FNE_NHG_FINISHED:
@@ -1452,28 +1936,41 @@ static void fpm_process_event(struct thread *t)
 static int fpm_nl_start(struct zebra_dplane_provider *prov)
 {
 	struct fpm_nl_ctx *fnc;
+	struct fpm_nl_conn *conn;
+	unsigned int i;
 
 	fnc = dplane_provider_get_data(prov);
 	fnc->fthread = frr_pthread_new(NULL, prov_name, prov_name);
 	assert(frr_pthread_run(fnc->fthread, NULL) == 0);
-	fnc->ibuf = stream_new(NL_PKT_BUF_SIZE);
-	fnc->obuf = stream_new(NL_PKT_BUF_SIZE * 128);
-	pthread_mutex_init(&fnc->obuf_mutex, NULL);
-	fnc->socket = -1;
 	fnc->disabled = true;
 	fnc->prov = prov;
-	dplane_ctx_q_init(&fnc->ctxqueue);
-	pthread_mutex_init(&fnc->ctxqueue_mutex, NULL);
+
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		conn->fnc = fnc;
+		conn->idx = i;
+		conn->socket = -1;
+		conn->batch = FPM_BATCH_DEFAULT;
+		pthread_mutex_init(&conn->obuf_mutex, NULL);
+		dplane_ctx_q_init(&conn->ctxqueue);
+		dplane_ctx_q_init(&conn->pending);
+		pthread_mutex_init(&conn->ctxqueue_mutex, NULL);
+	}
 
 	/* Set default values. */
 	fnc->use_nhg = true;
+	fnc->conf_connections = 1;
+	fnc->connections = 1;
 
 	return 0;
 }
 
 static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 {
-	/* Disable all events and close socket. */
+	struct fpm_nl_conn *conn;
+	unsigned int i;
+
+	/* Disable all events and close sockets. */
 	THREAD_OFF(fnc->t_lspreset);
 	THREAD_OFF(fnc->t_lspwalk);
 	THREAD_OFF(fnc->t_nhgreset);
@@ -1484,13 +1981,22 @@ static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 	THREAD_OFF(fnc->t_rmacwalk);
 	THREAD_OFF(fnc->t_event);
 	THREAD_OFF(fnc->t_nhg);
-	thread_cancel_async(fnc->fthread->master, &fnc->t_read, NULL);
-	thread_cancel_async(fnc->fthread->master, &fnc->t_write, NULL);
-	thread_cancel_async(fnc->fthread->master, &fnc->t_connect, NULL);
 
-	if (fnc->socket != -1) {
-		close(fnc->socket);
-		fnc->socket = -1;
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		if (conn->fthread == NULL)
+			continue;
+
+		thread_cancel_async(conn->fthread->master, &conn->t_read, NULL);
+		thread_cancel_async(conn->fthread->master, &conn->t_write,
+				    NULL);
+		thread_cancel_async(conn->fthread->master, &conn->t_connect,
+				    NULL);
+
+		if (conn->socket != -1) {
+			close(conn->socket);
+			conn->socket = -1;
+		}
 	}
 
 	return 0;
@@ -1498,14 +2004,25 @@ static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 
 static int fpm_nl_finish_late(struct fpm_nl_ctx *fnc)
 {
-	/* Stop the running thread. */
+	struct fpm_nl_conn *conn;
+	unsigned int i;
+
+	/* Stop the running threads. */
 	frr_pthread_stop(fnc->fthread, NULL);
 
 	/* Free all allocated resources. */
-	pthread_mutex_destroy(&fnc->obuf_mutex);
-	pthread_mutex_destroy(&fnc->ctxqueue_mutex);
-	stream_free(fnc->ibuf);
-	stream_free(fnc->obuf);
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		if (conn->fthread) {
+			frr_pthread_stop(conn->fthread, NULL);
+			stream_free(conn->ibuf);
+			stream_free(conn->obuf);
+		}
+
+		pthread_mutex_destroy(&conn->obuf_mutex);
+		pthread_mutex_destroy(&conn->ctxqueue_mutex);
+	}
+
 	free(gfnc);
 	gfnc = NULL;
 
@@ -1523,12 +2040,74 @@ static int fpm_nl_finish(struct zebra_dplane_provider *prov, bool early)
 	return fpm_nl_finish_late(fnc);
 }
 
+/*
+ * Queue a context for a connection, unless it is not connected: we'll walk
+ * the RIB anyway.
+ */
+static bool fpm_nl_conn_queue(struct fpm_nl_conn *conn,
+			      struct zebra_dplane_ctx *ctx,
+			      uint64_t *peak_queue)
+{
+	uint64_t cur_queue;
+
+	if (conn->socket == -1 || conn->connecting)
+		return false;
+
+	/*
+	 * Update the number of queued contexts *before* enqueueing, to ensure
+	 * counter consistency.
+	 */
+	atomic_fetch_add_explicit(&conn->counters.ctxqueue_len, 1,
+				  memory_order_relaxed);
+
+	frr_with_mutex (&conn->ctxqueue_mutex) {
+		dplane_ctx_enqueue_tail(&conn->ctxqueue, ctx);
+	}
+
+	cur_queue = atomic_load_explicit(&conn->counters.ctxqueue_len,
+					 memory_order_relaxed);
+	if (peak_queue[conn->idx] < cur_queue)
+		peak_queue[conn->idx] = cur_queue;
+
+	return true;
+}
+
+/*
+ * Queue a copy of a next hop group context for every connection but the
+ * first, which gets the context itself.  The copies are freed once sent.
+ */
+static void fpm_nl_queue_nhg_copies(struct fpm_nl_ctx *fnc,
+				    const struct zebra_dplane_ctx *ctx,
+				    uint64_t *peak_queue)
+{
+	struct zebra_dplane_ctx *copy;
+	struct fpm_nl_conn *conn;
+	uint32_t connections;
+	unsigned int i;
+
+	connections = atomic_load_explicit(&fnc->connections,
+					   memory_order_relaxed);
+	for (i = 1; i < connections; i++) {
+		conn = &fnc->conns[i];
+		if (conn->socket == -1 || conn->connecting)
+			continue;
+
+		copy = dplane_ctx_alloc();
+		dplane_ctx_nexthop_copy(copy, ctx);
+		if (!fpm_nl_conn_queue(conn, copy, peak_queue))
+			dplane_ctx_fini(&copy);
+	}
+}
+
 static int fpm_nl_process(struct zebra_dplane_provider *prov)
 {
 	struct zebra_dplane_ctx *ctx;
 	struct fpm_nl_ctx *fnc;
+	struct fpm_nl_conn *conn;
 	int counter, limit;
-	uint64_t cur_queue, peak_queue = 0, stored_peak_queue;
+	unsigned int i;
+	uint64_t stored_peak_queue;
+	uint64_t peak_queue[FPM_CONNECTIONS_MAX] = {};
 
 	fnc = dplane_provider_get_data(prov);
 	limit = dplane_provider_get_work_limit(prov);
@@ -1537,46 +2116,38 @@ static int fpm_nl_process(struct zebra_dplane_provider *prov)
 		if (ctx == NULL)
 			break;
 
-		/*
-		 * Skip all notifications if not connected, we'll walk the RIB
-		 * anyway.
-		 */
-		if (fnc->socket != -1 && fnc->connecting == false) {
-			/*
-			 * Update the number of queued contexts *before*
-			 * enqueueing, to ensure counter consistency.
-			 */
-			atomic_fetch_add_explicit(&fnc->counters.ctxqueue_len,
-						  1, memory_order_relaxed);
-
-			frr_with_mutex (&fnc->ctxqueue_mutex) {
-				dplane_ctx_enqueue_tail(&fnc->ctxqueue, ctx);
-			}
+		if (fnc->use_nhg && fpm_nl_op_is_nhg(dplane_ctx_get_op(ctx)))
+			fpm_nl_queue_nhg_copies(fnc, ctx, peak_queue);
 
-			cur_queue = atomic_load_explicit(
-				&fnc->counters.ctxqueue_len,
-				memory_order_relaxed);
-			if (peak_queue < cur_queue)
-				peak_queue = cur_queue;
+		conn = fpm_nl_ctx_conn(fnc, ctx);
+		if (fpm_nl_conn_queue(conn, ctx, peak_queue))
 			continue;
-		}
 
 		dplane_ctx_set_status(ctx, ZEBRA_DPLANE_REQUEST_SUCCESS);
 		dplane_provider_enqueue_out_ctx(prov, ctx);
 	}
 
-	/* Update peak queue length, if we just observed a new peak */
-	stored_peak_queue = atomic_load_explicit(
-		&fnc->counters.ctxqueue_len_peak, memory_order_relaxed);
-	if (stored_peak_queue < peak_queue)
-		atomic_store_explicit(&fnc->counters.ctxqueue_len_peak,
-				      peak_queue, memory_order_relaxed);
+	for (i = 0; i < FPM_CONNECTIONS_MAX; i++) {
+		conn = &fnc->conns[i];
+		if (conn->fthread == NULL)
+			continue;
 
-	if (atomic_load_explicit(&fnc->counters.ctxqueue_len,
-				 memory_order_relaxed)
-	    > 0)
-		thread_add_timer(fnc->fthread->master, fpm_process_queue,
-				 fnc, 0, &fnc->t_dequeue);
+		/* Update peak queue length, if we just observed a new peak */
+		stored_peak_queue = atomic_load_explicit(
+			&conn->counters.ctxqueue_len_peak,
+			memory_order_relaxed);
+		if (stored_peak_queue < peak_queue[i])
+			atomic_store_explicit(&conn->counters.ctxqueue_len_peak,
+					      peak_queue[i],
+					      memory_order_relaxed);
+
+		if (atomic_load_explicit(&conn->counters.ctxqueue_len,
+					 memory_order_relaxed)
+		    > 0)
+			thread_add_timer(conn->fthread->master,
+					 fpm_process_queue, conn, 0,
+					 &conn->t_dequeue);
+	}
 
 	/* Ensure dataplane thread is rescheduled if we hit the work limit */
 	if (counter >= limit)
@@ -1602,11 +2173,14 @@ static int fpm_nl_new(struct thread_master *tm)
 	install_node(&fpm_node);
 	install_element(ENABLE_NODE, &fpm_show_counters_cmd);
 	install_element(ENABLE_NODE, &fpm_show_counters_json_cmd);
+	install_element(ENABLE_NODE, &fpm_show_status_cmd);
 	install_element(ENABLE_NODE, &fpm_reset_counters_cmd);
 	install_element(CONFIG_NODE, &fpm_set_address_cmd);
 	install_element(CONFIG_NODE, &no_fpm_set_address_cmd);
 	install_element(CONFIG_NODE, &fpm_use_nhg_cmd);
 	install_element(CONFIG_NODE, &no_fpm_use_nhg_cmd);
+	install_element(CONFIG_NODE, &fpm_connections_cmd);
+	install_element(CONFIG_NODE, &no_fpm_connections_cmd);
 
 	return 0;
 }
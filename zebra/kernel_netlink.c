@@ -76,6 +76,20 @@
  */
 #define NL_DEFAULT_BATCH_SEND_THRESHOLD (15 * NL_PKT_BUF_SIZE)
 
+/*
+ * Number of batches that may be sent before the responses for them are read
+ * back.  The kernel only answers dplane requests with errors (we don't ask for
+ * NLM_F_ACK), and processes each sendmsg() synchronously, so the error
+ * responses of several batches can be collected with a single pass over the
+ * socket.  The socket's receive buffer (-s option) must be large enough to
+ * hold the errors of all batches in flight.
+ */
+#define NL_DEFAULT_BATCH_PIPELINE 1
+#define NL_BATCH_PIPELINE_MAX 64
+
+/* Per-batch latency histogram, log2 buckets in microseconds */
+#define NL_BATCH_LAT_BUCKETS 20
+
 static const struct message nlmsg_str[] = {{RTM_NEWROUTE, "RTM_NEWROUTE"},
 					   {RTM_DELROUTE, "RTM_DELROUTE"},
 					   {RTM_GETROUTE, "RTM_GETROUTE"},
@@ -173,11 +187,40 @@ pthread_mutex_t nlsock_mutex;
 #define NLSOCK_LOCK() pthread_mutex_lock(&nlsock_mutex)
 #define NLSOCK_UNLOCK() pthread_mutex_unlock(&nlsock_mutex)
 
-size_t nl_batch_tx_bufsize;
-char *nl_batch_tx_buf;
+/*
+ * Batch buffers are per pthread, so that several dplane shards can encode
+ * their messages at the same time.
+ */
+struct nl_batch_buf {
+	size_t size;
+	char *buf;
+};
+
+static pthread_key_t nl_batch_buf_key;
+static pthread_once_t nl_batch_buf_once = PTHREAD_ONCE_INIT;
+
+/*
+ * Sending a batch and reading back its responses must not interleave with
+ * another pthread doing the same on the dplane socket, or the responses
+ * could be picked up by the wrong sender.  The lock is held from the first
+ * batch sent until all responses of the pipeline have been read.
+ */
+static pthread_mutex_t nl_batch_tx_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 _Atomic uint32_t nl_batch_bufsize = NL_DEFAULT_BATCH_BUFSIZE;
 _Atomic uint32_t nl_batch_send_threshold = NL_DEFAULT_BATCH_SEND_THRESHOLD;
+_Atomic uint32_t nl_batch_pipeline = NL_DEFAULT_BATCH_PIPELINE;
+
+/* Written by the dplane pthread, read by the vty */
+static struct nl_batch_stats {
+	_Atomic uint64_t batches;
+	_Atomic uint64_t msgs;
+	_Atomic uint64_t drains;
+	_Atomic uint64_t send_errors;
+	_Atomic uint64_t inflight_max;
+	_Atomic uint64_t lat_max;
+	_Atomic uint64_t lat_hist[NL_BATCH_LAT_BUCKETS];
+} nl_batch_stats;
 
 struct nl_batch {
 	void *buf;
@@ -192,6 +235,18 @@ struct nl_batch {
 
 	struct dplane_ctx_list_head ctx_list;
 
+	/*
+	 * Contexts of batches that were sent but whose responses have not
+	 * been read yet, in sequence order, and the send times of those
+	 * batches.
+	 */
+	struct dplane_ctx_list_head inflight;
+	const struct zebra_dplane_info *inflight_zns;
+	unsigned int inflight_cnt;
+	bool tx_locked;
+	unsigned int pipeline;
+	struct timeval inflight_sent[NL_BATCH_PIPELINE_MAX];
+
 	/*
 	 * Pointer to the queue of completed contexts outbound back
 	 * towards the dataplane module.
@@ -206,11 +261,18 @@ int netlink_config_write_helper(struct vty *vty)
 	uint32_t threshold = atomic_load_explicit(&nl_batch_send_threshold,
 						  memory_order_relaxed);
 
+	uint32_t pipeline =
+		atomic_load_explicit(&nl_batch_pipeline, memory_order_relaxed);
+
 	if (size != NL_DEFAULT_BATCH_BUFSIZE
 	    || threshold != NL_DEFAULT_BATCH_SEND_THRESHOLD)
 		vty_out(vty, "zebra kernel netlink batch-tx-buf %u %u\n", size,
 			threshold);
 
+	if (pipeline != NL_DEFAULT_BATCH_PIPELINE)
+		vty_out(vty, "zebra kernel netlink batch-tx-pipeline %u\n",
+			pipeline);
+
 	if (if_netlink_frr_protodown_r_bit_is_set())
 		vty_out(vty, "zebra protodown reason-bit %u\n",
 			if_netlink_get_frr_protodown_r_bit());
@@ -230,6 +292,81 @@ void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold, bool set)
 			      memory_order_relaxed);
 }
 
+void netlink_set_batch_pipeline(uint32_t depth, bool set)
+{
+	if (!set)
+		depth = NL_DEFAULT_BATCH_PIPELINE;
+
+	atomic_store_explicit(&nl_batch_pipeline, depth, memory_order_relaxed);
+}
+
+void netlink_batch_show_helper(struct vty *vty)
+{
+	uint64_t val, prev = 0;
+	unsigned int i;
+
+	vty_out(vty, "Netlink batching:\n");
+	vty_out(vty, "  Pipeline depth:           %u\n",
+		atomic_load_explicit(&nl_batch_pipeline,
+				     memory_order_relaxed));
+	vty_out(vty, "  Batches sent:             %" PRIu64 "\n",
+		atomic_load_explicit(&nl_batch_stats.batches,
+				     memory_order_relaxed));
+	vty_out(vty, "  Messages sent:            %" PRIu64 "\n",
+		atomic_load_explicit(&nl_batch_stats.msgs,
+				     memory_order_relaxed));
+	vty_out(vty, "  Send errors:              %" PRIu64 "\n",
+		atomic_load_explicit(&nl_batch_stats.send_errors,
+				     memory_order_relaxed));
+	vty_out(vty, "  Response reads:           %" PRIu64 "\n",
+		atomic_load_explicit(&nl_batch_stats.drains,
+				     memory_order_relaxed));
+	vty_out(vty, "  Max batches in flight:    %" PRIu64 "\n",
+		atomic_load_explicit(&nl_batch_stats.inflight_max,
+				     memory_order_relaxed));
+	vty_out(vty, "  Max batch latency:        %" PRIu64 " usec\n",
+		atomic_load_explicit(&nl_batch_stats.lat_max,
+				     memory_order_relaxed));
+	vty_out(vty, "  Batch latency histogram (usec):\n");
+
+	for (i = 0; i < NL_BATCH_LAT_BUCKETS; i++) {
+		uint64_t upper = 2ULL << i;
+
+		val = atomic_load_explicit(&nl_batch_stats.lat_hist[i],
+					   memory_order_relaxed);
+		if (val) {
+			if (i == NL_BATCH_LAT_BUCKETS - 1)
+				vty_out(vty, "    %8" PRIu64 " +        %" PRIu64
+					"\n", prev, val);
+			else
+				vty_out(vty, "    %8" PRIu64 " - %-8" PRIu64
+					" %" PRIu64 "\n", prev, upper - 1, val);
+		}
+		prev = upper;
+	}
+}
+
+static void nl_batch_stats_latency(int64_t usec)
+{
+	unsigned int bucket = 0;
+	uint64_t max;
+
+	if (usec < 0)
+		usec = 0;
+
+	while (bucket < NL_BATCH_LAT_BUCKETS - 1 && (usec >> (bucket + 1)))
+		bucket++;
+
+	atomic_fetch_add_explicit(&nl_batch_stats.lat_hist[bucket], 1,
+				  memory_order_relaxed);
+
+	max = atomic_load_explicit(&nl_batch_stats.lat_max,
+				   memory_order_relaxed);
+	if ((uint64_t)usec > max)
+		atomic_store_explicit(&nl_batch_stats.lat_max, usec,
+				      memory_order_relaxed);
+}
+
 int netlink_talk_filter(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 {
 	/*
@@ -493,6 +630,9 @@ static void kernel_read(struct thread *thread)
 	netlink_parse_info(netlink_information_fetch, &zns->netlink, &dp_info,
 			   5, false);
 
+	/* Queue the routes that were read */
+	rib_kernel_batch_flush();
+
 	thread_add_read(zrouter.master, kernel_read, zns, zns->netlink.sock,
 			&zns->t_netlink);
 }
@@ -602,43 +742,6 @@ static void netlink_install_filter(int sock, uint32_t pid, uint32_t dplane_pid)
 			     safe_strerror(errno));
 }
 
-void netlink_parse_rtattr_flags(struct rtattr **tb, int max, struct rtattr *rta,
-				int len, unsigned short flags)
-{
-	unsigned short type;
-
-	memset(tb, 0, sizeof(struct rtattr *) * (max + 1));
-	while (RTA_OK(rta, len)) {
-		type = rta->rta_type & ~flags;
-		if ((type <= max) && (!tb[type]))
-			tb[type] = rta;
-		rta = RTA_NEXT(rta, len);
-	}
-}
-
-void netlink_parse_rtattr(struct rtattr **tb, int max, struct rtattr *rta,
-			  int len)
-{
-	memset(tb, 0, sizeof(struct rtattr *) * (max + 1));
-	while (RTA_OK(rta, len)) {
-		if (rta->rta_type <= max)
-			tb[rta->rta_type] = rta;
-		rta = RTA_NEXT(rta, len);
-	}
-}
-
-/**
- * netlink_parse_rtattr_nested() - Parses a nested route attribute
- * @tb:         Pointer to array for storing rtattr in.
- * @max:        Max number to store.
- * @rta:        Pointer to rtattr to look for nested items in.
- */
-void netlink_parse_rtattr_nested(struct rtattr **tb, int max,
-				 struct rtattr *rta)
-{
-	netlink_parse_rtattr(tb, max, RTA_DATA(rta), RTA_PAYLOAD(rta));
-}
-
 bool nl_addraw_l(struct nlmsghdr *n, unsigned int maxlen, const void *data,
 		 unsigned int len)
 {
@@ -1299,7 +1402,10 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 	struct zebra_dplane_ctx *ctx;
 	bool ignore_msg;
 
-	nl = kernel_netlink_nlsock_lookup(bth->zns->sock);
+	nl = kernel_netlink_nlsock_lookup(bth->inflight_zns->sock);
+
+	atomic_fetch_add_explicit(&nl_batch_stats.drains, 1,
+				  memory_order_relaxed);
 
 	msg.msg_name = (void *)&snl;
 	msg.msg_namelen = sizeof(snl);
@@ -1319,7 +1425,7 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 		 *
 		 */
 		if (status == -1 || status == 0) {
-			while ((ctx = dplane_ctx_dequeue(&(bth->ctx_list))) !=
+			while ((ctx = dplane_ctx_dequeue(&(bth->inflight))) !=
 			       NULL) {
 				if (status == -1)
 					dplane_ctx_set_status(
@@ -1340,7 +1446,7 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 		 * requests at same time.
 		 */
 		while (true) {
-			ctx = dplane_ctx_get_head(&(bth->ctx_list));
+			ctx = dplane_ctx_get_head(&(bth->inflight));
 			if (ctx == NULL) {
 				/*
 				 * This is a situation where we have gotten
@@ -1367,7 +1473,7 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 				break;
 			}
 
-			ctx = dplane_ctx_dequeue(&(bth->ctx_list));
+			ctx = dplane_ctx_dequeue(&(bth->inflight));
 			dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
 
 			/* We have found corresponding context object. */
@@ -1388,7 +1494,7 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 			 * message for our operator to understand
 			 * what is going on
 			 */
-			int err = netlink_parse_error(nl, h, bth->zns->is_cmd,
+			int err = netlink_parse_error(nl, h, bth->inflight_zns->is_cmd,
 						      false);
 
 			zlog_debug("%s: netlink error message seq=%d %d",
@@ -1405,12 +1511,12 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 				zlog_debug(
 					"%s: skipping unassociated response, seq number %d NS %u",
 					__func__, h->nlmsg_seq,
-					bth->zns->ns_id);
+					bth->inflight_zns->ns_id);
 			continue;
 		}
 
 		if (h->nlmsg_type == NLMSG_ERROR) {
-			int err = netlink_parse_error(nl, h, bth->zns->is_cmd,
+			int err = netlink_parse_error(nl, h, bth->inflight_zns->is_cmd,
 						      false);
 
 			if (err == -1)
@@ -1432,7 +1538,7 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 			zlog_debug("%s: ignoring message type 0x%04x(%s) NS %u",
 				   __func__, h->nlmsg_type,
 				   nl_msg_type_to_str(h->nlmsg_type),
-				   bth->zns->ns_id);
+				   bth->inflight_zns->ns_id);
 	}
 
 	return 0;
@@ -1448,72 +1554,179 @@ static void nl_batch_reset(struct nl_batch *bth)
 	dplane_ctx_q_init(&(bth->ctx_list));
 }
 
+static void nl_batch_buf_free(void *arg)
+{
+	struct nl_batch_buf *nbuf = arg;
+
+	XFREE(MTYPE_NL_BUF, nbuf->buf);
+	XFREE(MTYPE_NL_BUF, nbuf);
+}
+
+static void nl_batch_buf_key_init(void)
+{
+	pthread_key_create(&nl_batch_buf_key, nl_batch_buf_free);
+}
+
 static void nl_batch_init(struct nl_batch *bth,
 			  struct dplane_ctx_list_head *ctx_out_q)
 {
+	struct nl_batch_buf *nbuf;
+	size_t bufsize =
+		atomic_load_explicit(&nl_batch_bufsize, memory_order_relaxed);
+
+	pthread_once(&nl_batch_buf_once, nl_batch_buf_key_init);
+
+	nbuf = pthread_getspecific(nl_batch_buf_key);
+	if (!nbuf) {
+		nbuf = XCALLOC(MTYPE_NL_BUF, sizeof(*nbuf));
+		pthread_setspecific(nl_batch_buf_key, nbuf);
+	}
+
 	/*
 	 * If the size of the buffer has changed, free and then allocate a new
 	 * one.
 	 */
-	size_t bufsize =
-		atomic_load_explicit(&nl_batch_bufsize, memory_order_relaxed);
-	if (bufsize != nl_batch_tx_bufsize) {
-		if (nl_batch_tx_buf)
-			XFREE(MTYPE_NL_BUF, nl_batch_tx_buf);
+	if (bufsize != nbuf->size) {
+		XFREE(MTYPE_NL_BUF, nbuf->buf);
 
-		nl_batch_tx_buf = XCALLOC(MTYPE_NL_BUF, bufsize);
-		nl_batch_tx_bufsize = bufsize;
+		nbuf->buf = XCALLOC(MTYPE_NL_BUF, bufsize);
+		nbuf->size = bufsize;
 	}
 
-	bth->buf = nl_batch_tx_buf;
+	bth->buf = nbuf->buf;
 	bth->bufsiz = bufsize;
 	bth->limit = atomic_load_explicit(&nl_batch_send_threshold,
 					  memory_order_relaxed);
+	bth->pipeline = atomic_load_explicit(&nl_batch_pipeline,
+					     memory_order_relaxed);
+	if (bth->pipeline < 1 || bth->pipeline > NL_BATCH_PIPELINE_MAX)
+		bth->pipeline = NL_DEFAULT_BATCH_PIPELINE;
 
 	bth->ctx_out_q = ctx_out_q;
 
+	dplane_ctx_q_init(&(bth->inflight));
+	bth->inflight_zns = NULL;
+	bth->inflight_cnt = 0;
+	bth->tx_locked = false;
+
 	nl_batch_reset(bth);
 }
 
+/*
+ * Read the responses for all batches in flight and hand their contexts back
+ * to the dataplane.
+ */
+static void nl_batch_read_inflight(struct nl_batch *bth)
+{
+	struct zebra_dplane_ctx *ctx;
+	unsigned int i;
+
+	if (bth->inflight_cnt > 0)
+		nl_batch_read_resp(bth);
+
+	/* Contexts that didn't need a kernel message at all end up here too */
+	while ((ctx = dplane_ctx_dequeue(&(bth->inflight))) != NULL)
+		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+
+	for (i = 0; i < bth->inflight_cnt; i++)
+		nl_batch_stats_latency(
+			monotime_since(&bth->inflight_sent[i], NULL));
+
+	bth->inflight_cnt = 0;
+	bth->inflight_zns = NULL;
+
+	if (bth->tx_locked) {
+		pthread_mutex_unlock(&nl_batch_tx_mutex);
+		bth->tx_locked = false;
+	}
+}
+
 static void nl_batch_send(struct nl_batch *bth)
 {
 	struct zebra_dplane_ctx *ctx;
+	struct timeval sent;
 	bool err = false;
+	bool sent_batch = false;
+
+	/* Responses are read per socket, don't mix namespaces in flight */
+	if (bth->inflight_zns && bth->zns
+	    && bth->inflight_zns->ns_id != bth->zns->ns_id)
+		nl_batch_read_inflight(bth);
 
 	if (bth->curlen != 0 && bth->zns != NULL) {
 		struct nlsock *nl =
 			kernel_netlink_nlsock_lookup(bth->zns->sock);
 
 		if (IS_ZEBRA_DEBUG_KERNEL)
-			zlog_debug("%s: %s, batch size=%zu, msg cnt=%zu",
+			zlog_debug("%s: %s, batch size=%zu, msg cnt=%zu, in flight=%u",
 				   __func__, nl->name, bth->curlen,
-				   bth->msgcnt);
+				   bth->msgcnt, bth->inflight_cnt);
 
-		if (netlink_send_msg(nl, bth->buf, bth->curlen) == -1)
-			err = true;
+		if (!bth->tx_locked) {
+			pthread_mutex_lock(&nl_batch_tx_mutex);
+			bth->tx_locked = true;
+		}
 
-		if (!err) {
-			if (nl_batch_read_resp(bth) == -1)
-				err = true;
+		monotime(&sent);
+		if (netlink_send_msg(nl, bth->buf, bth->curlen) == -1) {
+			err = true;
+		} else {
+			sent_batch = true;
+			atomic_fetch_add_explicit(&nl_batch_stats.batches, 1,
+						  memory_order_relaxed);
+			atomic_fetch_add_explicit(&nl_batch_stats.msgs,
+						  bth->msgcnt,
+						  memory_order_relaxed);
 		}
 	}
 
-	/* Move remaining contexts to the outbound queue. */
-	while (true) {
-		ctx = dplane_ctx_dequeue(&(bth->ctx_list));
-		if (ctx == NULL)
-			break;
+	if (err) {
+		atomic_fetch_add_explicit(&nl_batch_stats.send_errors, 1,
+					  memory_order_relaxed);
+
+		/* Keep the outbound queue in order */
+		nl_batch_read_inflight(bth);
 
-		if (err)
+		while ((ctx = dplane_ctx_dequeue(&(bth->ctx_list))) != NULL) {
 			dplane_ctx_set_status(ctx,
 					      ZEBRA_DPLANE_REQUEST_FAILURE);
+			dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+		}
+	} else if (sent_batch || bth->inflight_cnt > 0) {
+		/* Defer reading responses until the pipeline is full */
+		dplane_ctx_list_append(&(bth->inflight), &(bth->ctx_list));
+
+		if (sent_batch) {
+			bth->inflight_zns = bth->zns;
+			bth->inflight_sent[bth->inflight_cnt++] = sent;
+
+			if (bth->inflight_cnt
+			    > atomic_load_explicit(&nl_batch_stats.inflight_max,
+						   memory_order_relaxed))
+				atomic_store_explicit(
+					&nl_batch_stats.inflight_max,
+					bth->inflight_cnt,
+					memory_order_relaxed);
+		}
 
-		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+		if (bth->inflight_cnt >= bth->pipeline)
+			nl_batch_read_inflight(bth);
+	} else {
+		/* Nothing was sent and nothing is pending, no responses */
+		while ((ctx = dplane_ctx_dequeue(&(bth->ctx_list))) != NULL)
+			dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
 	}
 
 	nl_batch_reset(bth);
 }
 
+/* Send the current batch and wait for all responses */
+static void nl_batch_flush(struct nl_batch *bth)
+{
+	nl_batch_send(bth);
+	nl_batch_read_inflight(bth);
+}
+
 enum netlink_msg_status netlink_batch_add_msg(
 	struct nl_batch *bth, struct zebra_dplane_ctx *ctx,
 	ssize_t (*msg_encoder)(struct zebra_dplane_ctx *, void *, size_t),
@@ -1682,7 +1895,7 @@ void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
 
 		if (batch.zns != NULL
 		    && batch.zns->ns_id != dplane_ctx_get_ns(ctx)->ns_id)
-			nl_batch_send(&batch);
+			nl_batch_flush(&batch);
 
 		/*
 		 * Assume all messages will succeed and then mark only the ones
@@ -1701,7 +1914,7 @@ void kernel_update_multi(struct dplane_ctx_list_head *ctx_list)
 			nl_batch_send(&batch);
 	}
 
-	nl_batch_send(&batch);
+	nl_batch_flush(&batch);
 
 	dplane_ctx_q_init(ctx_list);
 	dplane_ctx_list_append(ctx_list, &handled_list);
@@ -12,6 +12,8 @@ extern "C" {
 
 #ifdef HAVE_NETLINK
 
+#include "zebra/rt_netlink_decode.h"
+
 #define RTM_NHA(h)                                                             \
 	((struct rtattr *)(((char *)(h)) + NLMSG_ALIGN(sizeof(struct nhmsg))))
 
@@ -70,13 +72,6 @@ extern struct rtnexthop *nl_attr_rtnh(struct nlmsghdr *n, unsigned int maxlen);
  */
 extern void nl_attr_rtnh_end(struct nlmsghdr *n, struct rtnexthop *rtnh);
 
-extern void netlink_parse_rtattr(struct rtattr **tb, int max,
-				 struct rtattr *rta, int len);
-extern void netlink_parse_rtattr_flags(struct rtattr **tb, int max,
-				 struct rtattr *rta, int len,
-				 unsigned short flags);
-extern void netlink_parse_rtattr_nested(struct rtattr **tb, int max,
-					struct rtattr *rta);
 /*
  * nl_addraw_l copies raw form the netlink message buffer into netlink
  * message header pointer. It ensures the aligned data buffer does not
@@ -170,6 +165,15 @@ extern int netlink_config_write_helper(struct vty *vty);
 extern void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold,
 					  bool set);
 
+/*
+ * Configure how many batches may be in flight before their responses are
+ * read. If 'unset', reset to default value.
+ */
+extern void netlink_set_batch_pipeline(uint32_t depth, bool set);
+
+/* Batch counters and latency histogram for 'show zebra dplane' */
+extern void netlink_batch_show_helper(struct vty *vty);
+
 extern struct nlsock *kernel_netlink_nlsock_lookup(int sock);
 #endif /* HAVE_NETLINK */
 
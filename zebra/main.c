@@ -45,6 +45,7 @@
 #include "zebra/zebra_srte.h"
 #include "zebra/zebra_srv6.h"
 #include "zebra/zebra_srv6_vty.h"
+#include "zebra/zebra_rib_snapshot.h"
 
 #define ZEBRA_PTM_SUPPORT
 
@@ -71,6 +72,7 @@ uint32_t rcvbufsize = 128 * 1024;
 
 #define OPTION_V6_RR_SEMANTICS 2000
 #define OPTION_ASIC_OFFLOAD    2001
+#define OPTION_RIB_SNAPSHOT    2002
 
 /* Command line options. */
 const struct option longopts[] = {
@@ -81,6 +83,7 @@ const struct option longopts[] = {
 	{"retain", no_argument, NULL, 'r'},
 	{"graceful_restart", required_argument, NULL, 'K'},
 	{"asic-offload", optional_argument, NULL, OPTION_ASIC_OFFLOAD},
+	{"rib-snapshot", required_argument, NULL, OPTION_RIB_SNAPSHOT},
 #ifdef HAVE_NETLINK
 	{"vrfwnetns", no_argument, NULL, 'n'},
 	{"nl-bufsize", required_argument, NULL, 's'},
@@ -137,6 +140,10 @@ static void sigint(void)
 	atomic_store_explicit(&zrouter.in_shutdown, true,
 			      memory_order_relaxed);
 
+	/* Record what is installed before anything gets torn down */
+	zebra_rib_snapshot_save(NULL);
+	zebra_rib_snapshot_release();
+
 	/* send RA lifetime of 0 before stopping. rfc4861/6.2.5 */
 	rtadv_stop_ra_all();
 
@@ -301,6 +308,7 @@ int main(int argc, char **argv)
 		"  -r, --retain             When program terminates, retain added route by zebra.\n"
 		"  -K, --graceful_restart   Graceful restart at the kernel level, timer in seconds for expiration\n"
 		"  -A, --asic-offload       FRR is interacting with an asic underneath the linux kernel\n"
+		"      --rib-snapshot       Save the RIB to this file at exit, reuse it on the next start\n"
 #ifdef HAVE_NETLINK
 		"  -s, --nl-bufsize         Set netlink receive buffer size\n"
 		"  -n, --vrfwnetns          Use NetNS as VRF backend\n"
@@ -355,6 +363,9 @@ int main(int argc, char **argv)
 		case 'K':
 			graceful_restart = atoi(optarg);
 			break;
+		case OPTION_RIB_SNAPSHOT:
+			zebra_rib_snapshot_set_path(optarg);
+			break;
 		case 's':
 			rcvbufsize = atoi(optarg);
 			if (rcvbufsize < RCVBUFSIZE_MIN)
@@ -434,6 +445,8 @@ int main(int argc, char **argv)
 	*  will be equal to the current getpid(). To know about such routes,
 	* we have to have route_read() called before.
 	*/
+	zebra_rib_snapshot_load(NULL);
+
 	zrouter.startup_time = monotime(NULL);
 	thread_add_timer(zrouter.master, rib_sweep_route, NULL,
 			 graceful_restart, &zrouter.sweeper);
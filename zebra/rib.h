@@ -181,8 +181,27 @@ struct route_entry {
  *              don't generate routes
  */
 #define MQ_SIZE 10
+
+/* Per sub-queue counters, see "show zebra" */
+struct meta_queue_stats {
+	uint64_t enqueued;
+	uint64_t dequeued;
+	uint32_t depth_max;
+
+	/* Time from enqueue to dequeue, in microseconds */
+	uint64_t wait_total;
+	uint64_t wait_max;
+
+	/* Enqueue times of the queued items, oldest first, in a ring */
+	int64_t *times;
+	uint32_t times_head;
+	uint32_t times_count;
+	uint32_t times_size;
+};
+
 struct meta_queue {
 	struct list *subq[MQ_SIZE];
+	struct meta_queue_stats stats[MQ_SIZE];
 	uint32_t size; /* sum of lengths of all subqueues */
 };
 
@@ -251,6 +270,12 @@ DECLARE_LIST(re_list, struct route_entry, next);
 
 #define RIB_DEST_UPDATE_LSPS   (1 << (ZEBRA_MAX_QINDEX + 3))
 
+/*
+ * The nexthops of this dest's changed routes have been resolved ahead of
+ * rib_process() by a parallel meta-queue batch.
+ */
+#define RIB_DEST_PREPARED      (1 << (ZEBRA_MAX_QINDEX + 4))
+
 /*
  * Macro to iterate over each route for a destination (prefix).
  */
@@ -341,6 +366,11 @@ zebra_rib_route_entry_new(vrf_id_t vrf_id, int type, uint8_t instance,
 			  uint32_t flags, uint32_t nhe_id, uint32_t table_id,
 			  uint32_t metric, uint32_t mtu, uint8_t distance,
 			  route_tag_t tag);
+void zebra_rib_route_entry_init(struct route_entry *re, vrf_id_t vrf_id,
+				int type, uint8_t instance, uint32_t flags,
+				uint32_t nhe_id, uint32_t table_id,
+				uint32_t metric, uint32_t mtu,
+				uint8_t distance, route_tag_t tag);
 
 #define ZEBRA_RIB_LOOKUP_ERROR -1
 #define ZEBRA_RIB_FOUND_EXACT 0
@@ -389,6 +419,20 @@ extern void rib_delete(afi_t afi, safi_t safi, vrf_id_t vrf_id, int type,
 		       uint32_t table_id, uint32_t metric, uint8_t distance,
 		       bool fromkernel);
 
+/*
+ * Routes read from the kernel are queued in batches, see
+ * rib_kernel_batch_add() in zebra_rib.c.  're' is copied, and the batch
+ * takes over the labels and SRv6 data of the 'nh_num' nexthops in 'nh'.
+ * The batch goes on the meta queue when flushed, which the netlink readers
+ * do once they are done with a read.
+ */
+extern void rib_kernel_batch_add(afi_t afi, struct prefix *p,
+				 struct prefix_ipv6 *src_p,
+				 const struct route_entry *re,
+				 const struct nexthop *nh, unsigned int nh_num,
+				 bool startup, bool deletion);
+extern void rib_kernel_batch_flush(void);
+
 extern struct route_entry *rib_match(afi_t afi, safi_t safi, vrf_id_t vrf_id,
 				     const union g_addr *addr,
 				     struct route_node **rn_out);
@@ -452,6 +496,16 @@ int zebra_rib_queue_evpn_rem_vtep_del(vrf_id_t vrf_id, vni_t vni,
 				      struct in_addr vtep_ip);
 
 extern void meta_queue_free(struct meta_queue *mq, struct zebra_vrf *zvrf);
+
+/*
+ * Number of pthreads resolving nexthops for the meta-queue, including the
+ * main pthread.  With one, route nodes are processed one at a time.
+ */
+extern void zebra_rib_set_workers(unsigned int workers);
+extern unsigned int zebra_rib_get_workers(void);
+
+/* Meta-queue statistics, for "show zebra" */
+extern void zebra_rib_queue_show(struct vty *vty);
 extern int zebra_rib_labeled_unicast(struct route_entry *re);
 extern struct route_table *rib_table_ipv6;
 
@@ -59,6 +59,7 @@
 #include "zebra/zebra_mpls.h"
 #include "zebra/kernel_netlink.h"
 #include "zebra/rt_netlink.h"
+#include "zebra/rt_netlink_decode.h"
 #include "zebra/zebra_nhg.h"
 #include "zebra/zebra_mroute.h"
 #include "zebra/zebra_vxlan.h"
@@ -407,289 +408,35 @@ vrf_id_t vrf_lookup_by_table(uint32_t table_id, ns_id_t ns_id)
 	return VRF_DEFAULT;
 }
 
-/**
- * @parse_encap_mpls() - Parses encapsulated mpls attributes
- * @tb:         Pointer to rtattr to look for nested items in.
- * @labels:     Pointer to store labels in.
- *
- * Return:      Number of mpls labels found.
+/*
+ * netlink_route_decode() doesn't know about interfaces: put each nexthop in
+ * the vrf of its interface, or in the route's vrf.
  */
-static int parse_encap_mpls(struct rtattr *tb, mpls_label_t *labels)
+static void netlink_route_nexthop_vrf(struct nl_route *route, ns_id_t ns_id,
+				      vrf_id_t vrf_id)
 {
-	struct rtattr *tb_encap[MPLS_IPTUNNEL_MAX + 1] = {0};
-	mpls_lse_t *lses = NULL;
-	int num_labels = 0;
-	uint32_t ttl = 0;
-	uint32_t bos = 0;
-	uint32_t exp = 0;
-	mpls_label_t label = 0;
-
-	netlink_parse_rtattr_nested(tb_encap, MPLS_IPTUNNEL_MAX, tb);
-	lses = (mpls_lse_t *)RTA_DATA(tb_encap[MPLS_IPTUNNEL_DST]);
-	while (!bos && num_labels < MPLS_MAX_LABELS) {
-		mpls_lse_decode(lses[num_labels], &label, &ttl, &exp, &bos);
-		labels[num_labels++] = label;
-	}
-
-	return num_labels;
-}
-
-static enum seg6local_action_t
-parse_encap_seg6local(struct rtattr *tb,
-		      struct seg6local_context *ctx)
-{
-	struct rtattr *tb_encap[SEG6_LOCAL_MAX + 1] = {};
-	enum seg6local_action_t act = ZEBRA_SEG6_LOCAL_ACTION_UNSPEC;
-
-	netlink_parse_rtattr_nested(tb_encap, SEG6_LOCAL_MAX, tb);
-
-	if (tb_encap[SEG6_LOCAL_ACTION])
-		act = *(uint32_t *)RTA_DATA(tb_encap[SEG6_LOCAL_ACTION]);
-
-	if (tb_encap[SEG6_LOCAL_NH4])
-		ctx->nh4 = *(struct in_addr *)RTA_DATA(
-				tb_encap[SEG6_LOCAL_NH4]);
-
-	if (tb_encap[SEG6_LOCAL_NH6])
-		ctx->nh6 = *(struct in6_addr *)RTA_DATA(
-				tb_encap[SEG6_LOCAL_NH6]);
-
-	if (tb_encap[SEG6_LOCAL_TABLE])
-		ctx->table = *(uint32_t *)RTA_DATA(tb_encap[SEG6_LOCAL_TABLE]);
-
-	if (tb_encap[SEG6_LOCAL_VRFTABLE])
-		ctx->table =
-			*(uint32_t *)RTA_DATA(tb_encap[SEG6_LOCAL_VRFTABLE]);
-
-	return act;
-}
-
-static int parse_encap_seg6(struct rtattr *tb, struct in6_addr *segs)
-{
-	struct rtattr *tb_encap[SEG6_IPTUNNEL_MAX + 1] = {};
-	struct seg6_iptunnel_encap *ipt = NULL;
-	struct in6_addr *segments = NULL;
-
-	netlink_parse_rtattr_nested(tb_encap, SEG6_IPTUNNEL_MAX, tb);
-
-	/*
-	 * TODO: It's not support multiple SID list.
-	 */
-	if (tb_encap[SEG6_IPTUNNEL_SRH]) {
-		ipt = (struct seg6_iptunnel_encap *)
-			RTA_DATA(tb_encap[SEG6_IPTUNNEL_SRH]);
-		segments = ipt->srh[0].segments;
-		*segs = segments[0];
-		return 1;
-	}
-
-	return 0;
-}
-
+	struct zebra_ns *zns = zebra_ns_lookup(ns_id);
+	struct interface *ifp;
+	struct nexthop *nh;
+	unsigned int i;
 
-static struct nexthop
-parse_nexthop_unicast(ns_id_t ns_id, struct rtmsg *rtm, struct rtattr **tb,
-		      enum blackhole_type bh_type, int index, void *prefsrc,
-		      void *gate, afi_t afi, vrf_id_t vrf_id)
-{
-	struct interface *ifp = NULL;
-	struct nexthop nh = {0};
-	mpls_label_t labels[MPLS_MAX_LABELS] = {0};
-	int num_labels = 0;
-	enum seg6local_action_t seg6l_act = ZEBRA_SEG6_LOCAL_ACTION_UNSPEC;
-	struct seg6local_context seg6l_ctx = {};
-	struct in6_addr seg6_segs = {};
-	int num_segs = 0;
-
-	vrf_id_t nh_vrf_id = vrf_id;
-	size_t sz = (afi == AFI_IP) ? 4 : 16;
-
-	if (bh_type == BLACKHOLE_UNSPEC) {
-		if (index && !gate)
-			nh.type = NEXTHOP_TYPE_IFINDEX;
-		else if (index && gate)
-			nh.type = (afi == AFI_IP) ? NEXTHOP_TYPE_IPV4_IFINDEX
-						  : NEXTHOP_TYPE_IPV6_IFINDEX;
-		else if (!index && gate)
-			nh.type = (afi == AFI_IP) ? NEXTHOP_TYPE_IPV4
-						  : NEXTHOP_TYPE_IPV6;
-		else {
-			nh.type = NEXTHOP_TYPE_BLACKHOLE;
-			nh.bh_type = bh_type;
-		}
-	} else {
-		nh.type = NEXTHOP_TYPE_BLACKHOLE;
-		nh.bh_type = bh_type;
-	}
-	nh.ifindex = index;
-	if (prefsrc)
-		memcpy(&nh.src, prefsrc, sz);
-	if (gate)
-		memcpy(&nh.gate, gate, sz);
+	for (i = 0; i < route->nh_num; i++) {
+		nh = &route->nh[i];
+		nh->vrf_id = vrf_id;
+		if (!nh->ifindex)
+			continue;
 
-	if (index) {
-		ifp = if_lookup_by_index_per_ns(zebra_ns_lookup(ns_id), index);
+		ifp = if_lookup_by_index_per_ns(zns, nh->ifindex);
 		if (ifp)
-			nh_vrf_id = ifp->vrf->vrf_id;
-	}
-	nh.vrf_id = nh_vrf_id;
-
-	if (tb[RTA_ENCAP] && tb[RTA_ENCAP_TYPE]
-	    && *(uint16_t *)RTA_DATA(tb[RTA_ENCAP_TYPE])
-		       == LWTUNNEL_ENCAP_MPLS) {
-		num_labels = parse_encap_mpls(tb[RTA_ENCAP], labels);
-	}
-	if (tb[RTA_ENCAP] && tb[RTA_ENCAP_TYPE]
-	    && *(uint16_t *)RTA_DATA(tb[RTA_ENCAP_TYPE])
-		       == LWTUNNEL_ENCAP_SEG6_LOCAL) {
-		seg6l_act = parse_encap_seg6local(tb[RTA_ENCAP], &seg6l_ctx);
-	}
-	if (tb[RTA_ENCAP] && tb[RTA_ENCAP_TYPE]
-	    && *(uint16_t *)RTA_DATA(tb[RTA_ENCAP_TYPE])
-		       == LWTUNNEL_ENCAP_SEG6) {
-		num_segs = parse_encap_seg6(tb[RTA_ENCAP], &seg6_segs);
-	}
-
-	if (rtm->rtm_flags & RTNH_F_ONLINK)
-		SET_FLAG(nh.flags, NEXTHOP_FLAG_ONLINK);
-
-	if (rtm->rtm_flags & RTNH_F_LINKDOWN)
-		SET_FLAG(nh.flags, NEXTHOP_FLAG_LINKDOWN);
-
-	if (num_labels)
-		nexthop_add_labels(&nh, ZEBRA_LSP_STATIC, num_labels, labels);
-
-	if (seg6l_act != ZEBRA_SEG6_LOCAL_ACTION_UNSPEC)
-		nexthop_add_srv6_seg6local(&nh, seg6l_act, &seg6l_ctx);
-
-	if (num_segs)
-		nexthop_add_srv6_seg6(&nh, &seg6_segs);
-
-	return nh;
-}
-
-static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
-						struct nexthop_group *ng,
-						struct rtmsg *rtm,
-						struct rtnexthop *rtnh,
-						struct rtattr **tb,
-						void *prefsrc, vrf_id_t vrf_id)
-{
-	void *gate = NULL;
-	struct interface *ifp = NULL;
-	int index = 0;
-	/* MPLS labels */
-	mpls_label_t labels[MPLS_MAX_LABELS] = {0};
-	int num_labels = 0;
-	enum seg6local_action_t seg6l_act = ZEBRA_SEG6_LOCAL_ACTION_UNSPEC;
-	struct seg6local_context seg6l_ctx = {};
-	struct in6_addr seg6_segs = {};
-	int num_segs = 0;
-	struct rtattr *rtnh_tb[RTA_MAX + 1] = {};
-
-	int len = RTA_PAYLOAD(tb[RTA_MULTIPATH]);
-	vrf_id_t nh_vrf_id = vrf_id;
-
-	for (;;) {
-		struct nexthop *nh = NULL;
-
-		if (len < (int)sizeof(*rtnh) || rtnh->rtnh_len > len)
-			break;
-
-		index = rtnh->rtnh_ifindex;
-		if (index) {
-			/*
-			 * Yes we are looking this up
-			 * for every nexthop and just
-			 * using the last one looked
-			 * up right now
-			 */
-			ifp = if_lookup_by_index_per_ns(zebra_ns_lookup(ns_id),
-							index);
-			if (ifp)
-				nh_vrf_id = ifp->vrf->vrf_id;
-			else {
-				flog_warn(
-					EC_ZEBRA_UNKNOWN_INTERFACE,
-					"%s: Unknown interface %u specified, defaulting to VRF_DEFAULT",
-					__func__, index);
-				nh_vrf_id = VRF_DEFAULT;
-			}
-		} else
-			nh_vrf_id = vrf_id;
-
-		if (rtnh->rtnh_len > sizeof(*rtnh)) {
-			netlink_parse_rtattr(rtnh_tb, RTA_MAX, RTNH_DATA(rtnh),
-					     rtnh->rtnh_len - sizeof(*rtnh));
-			if (rtnh_tb[RTA_GATEWAY])
-				gate = RTA_DATA(rtnh_tb[RTA_GATEWAY]);
-			if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
-			    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
-				       == LWTUNNEL_ENCAP_MPLS) {
-				num_labels = parse_encap_mpls(
-					rtnh_tb[RTA_ENCAP], labels);
-			}
-			if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
-			    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
-				       == LWTUNNEL_ENCAP_SEG6_LOCAL) {
-				seg6l_act = parse_encap_seg6local(
-					rtnh_tb[RTA_ENCAP], &seg6l_ctx);
-			}
-			if (rtnh_tb[RTA_ENCAP] && rtnh_tb[RTA_ENCAP_TYPE]
-			    && *(uint16_t *)RTA_DATA(rtnh_tb[RTA_ENCAP_TYPE])
-				       == LWTUNNEL_ENCAP_SEG6) {
-				num_segs = parse_encap_seg6(rtnh_tb[RTA_ENCAP],
-							   &seg6_segs);
-			}
-		}
-
-		if (gate && rtm->rtm_family == AF_INET) {
-			if (index)
-				nh = nexthop_from_ipv4_ifindex(
-					gate, prefsrc, index, nh_vrf_id);
-			else
-				nh = nexthop_from_ipv4(gate, prefsrc,
-						       nh_vrf_id);
-		} else if (gate && rtm->rtm_family == AF_INET6) {
-			if (index)
-				nh = nexthop_from_ipv6_ifindex(
-					gate, index, nh_vrf_id);
-			else
-				nh = nexthop_from_ipv6(gate, nh_vrf_id);
-		} else
-			nh = nexthop_from_ifindex(index, nh_vrf_id);
-
-		if (nh) {
-			nh->weight = rtnh->rtnh_hops + 1;
-
-			if (num_labels)
-				nexthop_add_labels(nh, ZEBRA_LSP_STATIC,
-						   num_labels, labels);
-
-			if (seg6l_act != ZEBRA_SEG6_LOCAL_ACTION_UNSPEC)
-				nexthop_add_srv6_seg6local(nh, seg6l_act,
-							   &seg6l_ctx);
-
-			if (num_segs)
-				nexthop_add_srv6_seg6(nh, &seg6_segs);
-
-			if (rtnh->rtnh_flags & RTNH_F_ONLINK)
-				SET_FLAG(nh->flags, NEXTHOP_FLAG_ONLINK);
-
-			/* Add to temporary list */
-			nexthop_group_add_sorted(ng, nh);
+			nh->vrf_id = ifp->vrf->vrf_id;
+		else if (route->multipath) {
+			flog_warn(
+				EC_ZEBRA_UNKNOWN_INTERFACE,
+				"%s: Unknown interface %u specified, defaulting to VRF_DEFAULT",
+				__func__, nh->ifindex);
+			nh->vrf_id = VRF_DEFAULT;
 		}
-
-		if (rtnh->rtnh_len == 0)
-			break;
-
-		len -= NLMSG_ALIGN(rtnh->rtnh_len);
-		rtnh = RTNH_NEXT(rtnh);
 	}
-
-	uint8_t nhop_num = nexthop_group_nexthop_num(ng);
-
-	return nhop_num;
 }
 
 /* Looking up routing table by netlink interface. */
@@ -697,31 +444,19 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 					       ns_id_t ns_id, int startup,
 					       struct zebra_dplane_ctx *ctx)
 {
-	int len;
 	struct rtmsg *rtm;
-	struct rtattr *tb[RTA_MAX + 1];
+	struct nl_route route;
+	struct nexthop nhs[NL_ROUTE_NEXTHOP_MAX];
+	struct route_entry re;
 	uint32_t flags = 0;
-	struct prefix p;
-	struct prefix_ipv6 src_p = {};
 	vrf_id_t vrf_id;
 	bool selfroute;
-
-	char anyaddr[16] = {0};
+	int ret;
 
 	int proto = ZEBRA_ROUTE_KERNEL;
-	int index = 0;
-	int table;
-	int metric = 0;
-	uint32_t mtu = 0;
+	uint32_t metric;
 	uint8_t distance = 0;
-	route_tag_t tag = 0;
-	uint32_t nhe_id = 0;
-
-	void *dest = NULL;
-	void *gate = NULL;
-	void *prefsrc = NULL; /* IPv4 preferred source host address */
-	void *src = NULL;     /* IPv6 srcdest   source prefix */
-	enum blackhole_type bh_type = BLACKHOLE_UNSPEC;
+	afi_t afi;
 
 	frrtrace(3, frr_zebra, netlink_route_change_read_unicast, h, ns_id,
 		 startup);
@@ -730,43 +465,6 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 
 	if (startup && h->nlmsg_type != RTM_NEWROUTE)
 		return 0;
-	switch (rtm->rtm_type) {
-	case RTN_UNICAST:
-		break;
-	case RTN_BLACKHOLE:
-		bh_type = BLACKHOLE_NULL;
-		break;
-	case RTN_UNREACHABLE:
-		bh_type = BLACKHOLE_REJECT;
-		break;
-	case RTN_PROHIBIT:
-		bh_type = BLACKHOLE_ADMINPROHIB;
-		break;
-	default:
-		if (IS_ZEBRA_DEBUG_KERNEL)
-			zlog_debug("Route rtm_type: %s(%d) intentionally ignoring",
-				   nl_rttype_to_str(rtm->rtm_type),
-				   rtm->rtm_type);
-		return 0;
-	}
-
-	len = h->nlmsg_len - NLMSG_LENGTH(sizeof(struct rtmsg));
-	if (len < 0) {
-		zlog_err(
-			"%s: Message received from netlink is of a broken size %d %zu",
-			__func__, h->nlmsg_len,
-			(size_t)NLMSG_LENGTH(sizeof(struct rtmsg)));
-		return -1;
-	}
-
-	netlink_parse_rtattr(tb, RTA_MAX, RTM_RTA(rtm), len);
-
-	if (rtm->rtm_flags & RTM_F_CLONED)
-		return 0;
-	if (rtm->rtm_protocol == RTPROT_REDIRECT)
-		return 0;
-	if (rtm->rtm_protocol == RTPROT_KERNEL)
-		return 0;
 
 	selfroute = is_selfroute(rtm->rtm_protocol);
 
@@ -778,127 +476,50 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 		return 0;
 	}
 
-	/* We don't care about change notifications for the MPLS table. */
-	/* TODO: Revisit this. */
-	if (rtm->rtm_family == AF_MPLS)
-		return 0;
-
-	/* Table corresponding to route. */
-	if (tb[RTA_TABLE])
-		table = *(int *)RTA_DATA(tb[RTA_TABLE]);
-	else
-		table = rtm->rtm_table;
+	route.nh = nhs;
+	route.nh_max = array_size(nhs);
+	ret = netlink_route_decode(h, &route);
+	if (ret <= 0) {
+		if (ret == 0 && IS_ZEBRA_DEBUG_KERNEL)
+			zlog_debug("Route rtm_type: %s(%d) protocol %u family %u flags 0x%x intentionally ignoring",
+				   nl_rttype_to_str(rtm->rtm_type),
+				   rtm->rtm_type, rtm->rtm_protocol,
+				   rtm->rtm_family, rtm->rtm_flags);
+		return ret;
+	}
 
 	/* Map to VRF */
-	vrf_id = vrf_lookup_by_table(table, ns_id);
+	vrf_id = vrf_lookup_by_table(route.table, ns_id);
 	if (vrf_id == VRF_DEFAULT) {
-		if (!is_zebra_valid_kernel_table(table)
-		    && !is_zebra_main_routing_table(table))
+		if (!is_zebra_valid_kernel_table(route.table)
+		    && !is_zebra_main_routing_table(route.table)) {
+			netlink_route_free(&route);
 			return 0;
+		}
 	}
 
-	if (rtm->rtm_flags & RTM_F_TRAP)
+	if (route.family == AF_INET && route.src_p.prefixlen) {
+		flog_warn(EC_ZEBRA_UNSUPPORTED_V4_SRCDEST,
+			  "unsupported IPv4 sourcedest route (dest %pFX vrf %u)",
+			  &route.p, vrf_id);
+		netlink_route_free(&route);
+		return 0;
+	}
+
+	if (route.rtm_flags & RTM_F_TRAP)
 		flags |= ZEBRA_FLAG_TRAPPED;
-	if (rtm->rtm_flags & RTM_F_OFFLOAD)
+	if (route.rtm_flags & RTM_F_OFFLOAD)
 		flags |= ZEBRA_FLAG_OFFLOADED;
-	if (rtm->rtm_flags & RTM_F_OFFLOAD_FAILED)
+	if (route.rtm_flags & RTM_F_OFFLOAD_FAILED)
 		flags |= ZEBRA_FLAG_OFFLOAD_FAILED;
 
-	if (h->nlmsg_flags & NLM_F_APPEND)
+	if (route.msg_flags & NLM_F_APPEND)
 		flags |= ZEBRA_FLAG_OUTOFSYNC;
 
 	/* Route which inserted by Zebra. */
 	if (selfroute) {
 		flags |= ZEBRA_FLAG_SELFROUTE;
-		proto = proto2zebra(rtm->rtm_protocol, rtm->rtm_family, false);
-	}
-	if (tb[RTA_OIF])
-		index = *(int *)RTA_DATA(tb[RTA_OIF]);
-
-	if (tb[RTA_DST])
-		dest = RTA_DATA(tb[RTA_DST]);
-	else
-		dest = anyaddr;
-
-	if (tb[RTA_SRC])
-		src = RTA_DATA(tb[RTA_SRC]);
-	else
-		src = anyaddr;
-
-	if (tb[RTA_PREFSRC])
-		prefsrc = RTA_DATA(tb[RTA_PREFSRC]);
-
-	if (tb[RTA_GATEWAY])
-		gate = RTA_DATA(tb[RTA_GATEWAY]);
-
-	if (tb[RTA_NH_ID])
-		nhe_id = *(uint32_t *)RTA_DATA(tb[RTA_NH_ID]);
-
-	if (tb[RTA_PRIORITY])
-		metric = *(int *)RTA_DATA(tb[RTA_PRIORITY]);
-
-#if defined(SUPPORT_REALMS)
-	if (tb[RTA_FLOW])
-		tag = *(uint32_t *)RTA_DATA(tb[RTA_FLOW]);
-#endif
-
-	if (tb[RTA_METRICS]) {
-		struct rtattr *mxrta[RTAX_MAX + 1];
-
-		netlink_parse_rtattr(mxrta, RTAX_MAX, RTA_DATA(tb[RTA_METRICS]),
-				     RTA_PAYLOAD(tb[RTA_METRICS]));
-
-		if (mxrta[RTAX_MTU])
-			mtu = *(uint32_t *)RTA_DATA(mxrta[RTAX_MTU]);
-	}
-
-	if (rtm->rtm_family == AF_INET) {
-		p.family = AF_INET;
-		if (rtm->rtm_dst_len > IPV4_MAX_BITLEN) {
-			zlog_err(
-				"Invalid destination prefix length: %u received from kernel route change",
-				rtm->rtm_dst_len);
-			return -1;
-		}
-		memcpy(&p.u.prefix4, dest, 4);
-		p.prefixlen = rtm->rtm_dst_len;
-
-		if (rtm->rtm_src_len != 0) {
-			flog_warn(
-				EC_ZEBRA_UNSUPPORTED_V4_SRCDEST,
-				"unsupported IPv4 sourcedest route (dest %pFX vrf %u)",
-				&p, vrf_id);
-			return 0;
-		}
-
-		/* Force debug below to not display anything for source */
-		src_p.prefixlen = 0;
-	} else if (rtm->rtm_family == AF_INET6) {
-		p.family = AF_INET6;
-		if (rtm->rtm_dst_len > IPV6_MAX_BITLEN) {
-			zlog_err(
-				"Invalid destination prefix length: %u received from kernel route change",
-				rtm->rtm_dst_len);
-			return -1;
-		}
-		memcpy(&p.u.prefix6, dest, 16);
-		p.prefixlen = rtm->rtm_dst_len;
-
-		src_p.family = AF_INET6;
-		if (rtm->rtm_src_len > IPV6_MAX_BITLEN) {
-			zlog_err(
-				"Invalid source prefix length: %u received from kernel route change",
-				rtm->rtm_src_len);
-			return -1;
-		}
-		memcpy(&src_p.prefix, src, 16);
-		src_p.prefixlen = rtm->rtm_src_len;
-	} else {
-		/* We only handle the AFs we handle... */
-		if (IS_ZEBRA_DEBUG_KERNEL)
-			zlog_debug("%s: unknown address-family %u", __func__,
-				   rtm->rtm_family);
-		return 0;
+		proto = proto2zebra(route.protocol, route.family, false);
 	}
 
 	/*
@@ -918,6 +539,7 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 	 *    values will end up with a admin distance of 0, which
 	 *    will cause them to win for the purposes of zebra.
 	 */
+	metric = route.metric;
 	if (proto == ZEBRA_ROUTE_KERNEL) {
 		distance = (metric >> 24) & 0xFF;
 		metric = (metric & 0x00FFFFFF);
@@ -928,72 +550,25 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 
 		zlog_debug(
 			"%s %pFX%s%s vrf %s(%u) table_id: %u metric: %d Admin Distance: %d",
-			nl_msg_type_to_str(h->nlmsg_type), &p,
-			src_p.prefixlen ? " from " : "",
-			src_p.prefixlen ? prefix2str(&src_p, buf2, sizeof(buf2))
-					: "",
-			vrf_id_to_name(vrf_id), vrf_id, table, metric,
+			nl_msg_type_to_str(h->nlmsg_type), &route.p,
+			route.src_p.prefixlen ? " from " : "",
+			route.src_p.prefixlen
+				? prefix2str(&route.src_p, buf2, sizeof(buf2))
+				: "",
+			vrf_id_to_name(vrf_id), vrf_id, route.table, metric,
 			distance);
 	}
 
-	afi_t afi = AFI_IP;
-	if (rtm->rtm_family == AF_INET6)
-		afi = AFI_IP6;
+	afi = (route.family == AF_INET6) ? AFI_IP6 : AFI_IP;
 
-	if (h->nlmsg_type == RTM_NEWROUTE) {
-		struct route_entry *re;
-		struct nexthop_group *ng = NULL;
-
-		re = zebra_rib_route_entry_new(vrf_id, proto, 0, flags, nhe_id,
-					       table, metric, mtu, distance,
-					       tag);
-		if (!nhe_id)
-			ng = nexthop_group_new();
-
-		if (!tb[RTA_MULTIPATH]) {
-			struct nexthop *nexthop, nh;
-
-			if (!nhe_id) {
-				nh = parse_nexthop_unicast(
-					ns_id, rtm, tb, bh_type, index, prefsrc,
-					gate, afi, vrf_id);
-
-				nexthop = nexthop_new();
-				*nexthop = nh;
-				nexthop_group_add_sorted(ng, nexthop);
-			}
-		} else {
-			/* This is a multipath route */
-			struct rtnexthop *rtnh =
-				(struct rtnexthop *)RTA_DATA(tb[RTA_MULTIPATH]);
+	netlink_route_nexthop_vrf(&route, ns_id, vrf_id);
 
-			if (!nhe_id) {
-				uint8_t nhop_num;
+	if (h->nlmsg_type == RTM_NEWROUTE) {
+		if (route.multipath && !route.nhe_id)
+			zserv_nexthop_num_warn(__func__, &route.p,
+					       route.nh_num);
 
-				/* Use temporary list of nexthops; parse
-				 * message payload's nexthops.
-				 */
-				nhop_num =
-					parse_multipath_nexthops_unicast(
-						ns_id, ng, rtm, rtnh, tb,
-						prefsrc, vrf_id);
-
-				zserv_nexthop_num_warn(
-					__func__, (const struct prefix *)&p,
-					nhop_num);
-
-				if (nhop_num == 0) {
-					nexthop_group_delete(&ng);
-					ng = NULL;
-				}
-			}
-		}
-		if (nhe_id || ng) {
-			dplane_rib_add_multipath(afi, SAFI_UNICAST, &p, &src_p,
-						 re, ng, startup, ctx);
-			if (ng)
-				nexthop_group_delete(&ng);
-		} else {
+		if (!route.nhe_id && !route.nh_num) {
 			/*
 			 * I really don't see how this is possible
 			 * but since we are testing for it let's
@@ -1003,39 +578,63 @@ int netlink_route_change_read_unicast_internal(struct nlmsghdr *h,
 			 */
 			zlog_err(
 				"%s: %pFX multipath RTM_NEWROUTE has a invalid nexthop group from the kernel",
-				__func__, &p);
-			XFREE(MTYPE_RE, re);
+				__func__, &route.p);
+			return 1;
+		}
+
+		if (!ctx) {
+			/* The batch takes over the decoded nexthops */
+			zebra_rib_route_entry_init(&re, vrf_id, proto, 0, flags,
+						   route.nhe_id, route.table,
+						   metric, route.mtu, distance,
+						   route.tag);
+			rib_kernel_batch_add(afi, &route.p, &route.src_p, &re,
+					     route.nh, route.nh_num, startup,
+					     false);
+		} else {
+			struct route_entry *new_re;
+			struct nexthop_group *ng = NULL;
+			struct nexthop *nexthop;
+			unsigned int i;
+
+			new_re = zebra_rib_route_entry_new(
+				vrf_id, proto, 0, flags, route.nhe_id,
+				route.table, metric, route.mtu, distance,
+				route.tag);
+
+			if (route.nh_num)
+				ng = nexthop_group_new();
+			for (i = 0; i < route.nh_num; i++) {
+				nexthop = nexthop_new();
+				*nexthop = route.nh[i];
+				nexthop_group_add_sorted(ng, nexthop);
+			}
+
+			dplane_rib_add_multipath(afi, SAFI_UNICAST, &route.p,
+						 &route.src_p, new_re, ng,
+						 startup, ctx);
+			if (ng)
+				nexthop_group_delete(&ng);
 		}
 	} else {
 		if (ctx) {
 			zlog_err(
 				"%s: %pFX RTM_DELROUTE received but received a context as well",
-				__func__, &p);
+				__func__, &route.p);
+			netlink_route_free(&route);
 			return 0;
 		}
 
-		if (nhe_id) {
-			rib_delete(afi, SAFI_UNICAST, vrf_id, proto, 0, flags,
-				   &p, &src_p, NULL, nhe_id, table, metric,
-				   distance, true);
-		} else {
-			if (!tb[RTA_MULTIPATH]) {
-				struct nexthop nh;
-
-				nh = parse_nexthop_unicast(
-					ns_id, rtm, tb, bh_type, index, prefsrc,
-					gate, afi, vrf_id);
-				rib_delete(afi, SAFI_UNICAST, vrf_id, proto, 0,
-					   flags, &p, &src_p, &nh, 0, table,
-					   metric, distance, true);
-			} else {
-				/* XXX: need to compare the entire list of
-				 * nexthops here for NLM_F_APPEND stupidity */
-				rib_delete(afi, SAFI_UNICAST, vrf_id, proto, 0,
-					   flags, &p, &src_p, NULL, 0, table,
-					   metric, distance, true);
-			}
-		}
+		/* XXX: need to compare the entire list of
+		 * nexthops here for NLM_F_APPEND stupidity */
+		if (route.multipath)
+			netlink_route_free(&route);
+
+		zebra_rib_route_entry_init(&re, vrf_id, proto, 0, flags,
+					   route.nhe_id, route.table, metric, 0,
+					   distance, 0);
+		rib_kernel_batch_add(afi, &route.p, &route.src_p, &re,
+				     route.nh, route.nh_num, false, true);
 	}
 
 	return 1;
@@ -1255,6 +854,7 @@ int netlink_route_read(struct zebra_ns *zns)
 		return ret;
 	ret = netlink_parse_info(netlink_route_change_read_unicast,
 				 &zns->netlink_cmd, &dp_info, 0, true);
+	rib_kernel_batch_flush();
 	if (ret < 0)
 		return ret;
 
@@ -1264,6 +864,7 @@ int netlink_route_read(struct zebra_ns *zns)
 		return ret;
 	ret = netlink_parse_info(netlink_route_change_read_unicast,
 				 &zns->netlink_cmd, &dp_info, 0, true);
+	rib_kernel_batch_flush();
 	if (ret < 0)
 		return ret;
 
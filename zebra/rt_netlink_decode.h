@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Decoding of netlink route messages, without looking at zebra's state.
+ */
+
+#ifndef _ZEBRA_RT_NETLINK_DECODE_H
+#define _ZEBRA_RT_NETLINK_DECODE_H
+
+#ifdef HAVE_NETLINK
+
+#include "prefix.h"
+#include "nexthop.h"
+#include "mpls.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Most nexthops a decoded route can carry */
+#define NL_ROUTE_NEXTHOP_MAX 255
+
+/*
+ * A unicast route, as the kernel describes it.  Nothing in here depends on
+ * zebra's interfaces or vrfs: the nexthops are left in the route's vrf
+ * (VRF_UNKNOWN), and the caller resolves them from their ifindex.
+ */
+struct nl_route {
+	uint16_t msg_type;
+	uint16_t msg_flags;
+
+	uint8_t family;
+	uint8_t protocol;
+	uint32_t rtm_flags;
+	uint32_t table;
+
+	struct prefix p;
+	struct prefix_ipv6 src_p;
+
+	enum blackhole_type bh_type;
+	uint32_t metric;
+	uint32_t mtu;
+	uint32_t nhe_id;
+	route_tag_t tag;
+
+	/* RTA_MULTIPATH was present */
+	bool multipath;
+
+	/*
+	 * Nexthops in message order, in an array provided by the caller.
+	 * Labels and SRv6 data are allocated, see netlink_route_free().
+	 * Nothing is decoded when the route refers to a nexthop id.
+	 */
+	struct nexthop *nh;
+	unsigned int nh_max;
+	unsigned int nh_num;
+};
+
+/*
+ * Decode RTM_NEWROUTE/RTM_DELROUTE 'h' into 'route', whose nh and nh_max
+ * are set by the caller.  Returns -1 for a malformed message, 0 for routes
+ * zebra never looks at (cloned, redirect and kernel-owned routes, MPLS and
+ * unknown families, route types other than unicast and blackholes), 1 if
+ * the route was decoded.
+ */
+extern int netlink_route_decode(struct nlmsghdr *h, struct nl_route *route);
+
+/* Free what netlink_route_decode() allocated for the nexthops */
+extern void netlink_route_free(struct nl_route *route);
+
+extern int parse_encap_mpls(struct rtattr *tb, mpls_label_t *labels);
+
+extern void netlink_parse_rtattr(struct rtattr **tb, int max,
+				 struct rtattr *rta, int len);
+extern void netlink_parse_rtattr_flags(struct rtattr **tb, int max,
+				 struct rtattr *rta, int len,
+				 unsigned short flags);
+extern void netlink_parse_rtattr_nested(struct rtattr **tb, int max,
+					struct rtattr *rta);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HAVE_NETLINK */
+
+#endif /* _ZEBRA_RT_NETLINK_DECODE_H */
@@ -22,6 +22,7 @@
 #include "lib/vrf.h"
 #include "lib/libfrr.h"
 #include "lib/lib_errors.h"
+#include "lib/shmring.h"
 
 #include "zebra/zebra_router.h"
 #include "zebra/rib.h"
@@ -2018,109 +2019,104 @@ static void zread_nhg_add(ZAPI_HANDLER_ARGS)
 
 }
 
-static void zread_route_add(ZAPI_HANDLER_ARGS)
+/*
+ * Checks the nexthops and attributes of a route (or of all routes in a bulk
+ * message) and reads the nexthops into a temporary nhe, unless the route
+ * refers to a nexthop group by ID.
+ */
+static bool zapi_route_add_prepare(struct zserv *client, struct zapi_route *api,
+				   struct nhg_hash_entry *nhe,
+				   struct nexthop_group **png,
+				   struct nhg_backup_info **pbnhg)
 {
-	struct stream *s;
-	struct zapi_route api;
-	afi_t afi;
-	struct prefix_ipv6 *src_p = NULL;
-	struct route_entry *re;
-	struct nexthop_group *ng = NULL;
-	struct nhg_backup_info *bnhg = NULL;
-	int ret;
-	vrf_id_t vrf_id;
-	struct nhg_hash_entry nhe, *n = NULL;
-
-	s = msg;
-	if (zapi_route_decode(s, &api) < 0) {
-		if (IS_ZEBRA_DEBUG_RECV)
-			zlog_debug("%s: Unable to decode zapi_route sent",
-				   __func__);
-		return;
-	}
-
-	vrf_id = zvrf_id(zvrf);
-
-	if (IS_ZEBRA_DEBUG_RECV)
-		zlog_debug("%s: p=(%u:%u)%pFX, msg flags=0x%x, flags=0x%x",
-			   __func__, vrf_id, api.tableid, &api.prefix,
-			   (int)api.message, api.flags);
-
-	/* Allocate new route. */
-	re = zebra_rib_route_entry_new(
-		vrf_id, api.type, api.instance, api.flags, api.nhgid,
-		api.tableid ? api.tableid : zvrf->table_id, api.metric, api.mtu,
-		api.distance, api.tag);
+	afi_t afi = family2afi(api->prefix.family);
 
-	if (!CHECK_FLAG(api.message, ZAPI_MESSAGE_NHG)
-	    && (!CHECK_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP)
-		|| api.nexthop_num == 0)) {
+	if (!CHECK_FLAG(api->message, ZAPI_MESSAGE_NHG)
+	    && (!CHECK_FLAG(api->message, ZAPI_MESSAGE_NEXTHOP)
+		|| api->nexthop_num == 0)) {
 		flog_warn(
 			EC_ZEBRA_RX_ROUTE_NO_NEXTHOPS,
 			"%s: received a route without nexthops for prefix %pFX from client %s",
-			__func__, &api.prefix,
+			__func__, &api->prefix,
 			zebra_route_string(client->proto));
-
-		XFREE(MTYPE_RE, re);
-		return;
+		return false;
 	}
 
 	/* Report misuse of the backup flag */
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_BACKUP_NEXTHOPS)
-	    && api.backup_nexthop_num == 0) {
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_BACKUP_NEXTHOPS)
+	    && api->backup_nexthop_num == 0) {
 		if (IS_ZEBRA_DEBUG_RECV || IS_ZEBRA_DEBUG_EVENT)
 			zlog_debug(
 				"%s: client %s: BACKUP flag set but no backup nexthops, prefix %pFX",
 				__func__, zebra_route_string(client->proto),
-				&api.prefix);
-	}
-
-	if (!re->nhe_id
-	    && (!zapi_read_nexthops(client, &api.prefix, api.nexthops,
-				    api.flags, api.message, api.nexthop_num,
-				    api.backup_nexthop_num, &ng, NULL)
-		|| !zapi_read_nexthops(client, &api.prefix, api.backup_nexthops,
-				       api.flags, api.message,
-				       api.backup_nexthop_num,
-				       api.backup_nexthop_num, NULL, &bnhg))) {
-
-		nexthop_group_delete(&ng);
-		zebra_nhg_backup_free(&bnhg);
-		XFREE(MTYPE_RE, re);
-		return;
-	}
-
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_OPAQUE)) {
-		re->opaque =
-			XMALLOC(MTYPE_RE_OPAQUE,
-				sizeof(struct re_opaque) + api.opaque.length);
-		re->opaque->length = api.opaque.length;
-		memcpy(re->opaque->data, api.opaque.data, re->opaque->length);
+				&api->prefix);
 	}
 
-	afi = family2afi(api.prefix.family);
-	if (afi != AFI_IP6 && CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX)) {
+	if (afi != AFI_IP6 && CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX)) {
 		flog_warn(EC_ZEBRA_RX_SRCDEST_WRONG_AFI,
 			  "%s: Received SRC Prefix but afi is not v6",
 			  __func__);
-		nexthop_group_delete(&ng);
-		zebra_nhg_backup_free(&bnhg);
-		XFREE(MTYPE_RE_OPAQUE, re->opaque);
-		XFREE(MTYPE_RE, re);
-		return;
+		return false;
 	}
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX))
-		src_p = &api.src_prefix;
 
-	if (api.safi != SAFI_UNICAST && api.safi != SAFI_MULTICAST) {
+	if (api->safi != SAFI_UNICAST && api->safi != SAFI_MULTICAST) {
 		flog_warn(EC_LIB_ZAPI_MISSMATCH,
 			  "%s: Received safi: %d but we can only accept UNICAST or MULTICAST",
-			  __func__, api.safi);
-		nexthop_group_delete(&ng);
-		zebra_nhg_backup_free(&bnhg);
-		XFREE(MTYPE_RE_OPAQUE, re->opaque);
-		XFREE(MTYPE_RE, re);
-		return;
+			  __func__, api->safi);
+		return false;
+	}
+
+	if (api->nhgid)
+		return true;
+
+	if (!zapi_read_nexthops(client, &api->prefix, api->nexthops,
+				api->flags, api->message, api->nexthop_num,
+				api->backup_nexthop_num, png, NULL)
+	    || !zapi_read_nexthops(client, &api->prefix, api->backup_nexthops,
+				   api->flags, api->message,
+				   api->backup_nexthop_num,
+				   api->backup_nexthop_num, NULL, pbnhg)) {
+		nexthop_group_delete(png);
+		zebra_nhg_backup_free(pbnhg);
+		return false;
+	}
+
+	/*
+	 * Include backup info with the route. We use a temporary nhe here;
+	 * if this is a new/unknown nhe, a new copy will be allocated
+	 * and stored.
+	 */
+	zebra_nhe_init(nhe, afi, (*png)->nexthop);
+	nhe->nhg.nexthop = (*png)->nexthop;
+	nhe->backup_info = *pbnhg;
+
+	/* hashed once here, not once for every route of a bulk message */
+	zebra_nhe_set_key(nhe);
+	return true;
+}
+
+/* Queues a route checked by zapi_route_add_prepare() for the RIB. */
+static void zapi_route_add_queue(struct zserv *client, struct zebra_vrf *zvrf,
+				 struct zapi_route *api,
+				 struct prefix_ipv6 *src_p,
+				 struct nhg_hash_entry *nhe)
+{
+	struct route_entry *re;
+	struct nhg_hash_entry *n = NULL;
+	int ret;
+
+	/* Allocate new route. */
+	re = zebra_rib_route_entry_new(
+		zvrf_id(zvrf), api->type, api->instance, api->flags,
+		api->nhgid, api->tableid ? api->tableid : zvrf->table_id,
+		api->metric, api->mtu, api->distance, api->tag);
+
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_OPAQUE)) {
+		re->opaque =
+			XMALLOC(MTYPE_RE_OPAQUE,
+				sizeof(struct re_opaque) + api->opaque.length);
+		re->opaque->length = api->opaque.length;
+		memcpy(re->opaque->data, api->opaque.data, re->opaque->length);
 	}
 
 	/*
@@ -2129,18 +2125,11 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	 *
 	 * Havent figured out how to handle backup NHs with this yet, so lets
 	 * keep that separate.
-	 * Include backup info with the route. We use a temporary nhe here;
-	 * if this is a new/unknown nhe, a new copy will be allocated
-	 * and stored.
 	 */
-	if (!re->nhe_id) {
-		zebra_nhe_init(&nhe, afi, ng->nexthop);
-		nhe.nhg.nexthop = ng->nexthop;
-		nhe.backup_info = bnhg;
-		n = zebra_nhe_copy(&nhe, 0);
-	}
-	ret = rib_add_multipath_nhe(afi, api.safi, &api.prefix, src_p, re, n,
-				    false);
+	if (!re->nhe_id)
+		n = zebra_nhe_copy_keyed(nhe);
+	ret = rib_add_multipath_nhe(family2afi(api->prefix.family), api->safi,
+				    &api->prefix, src_p, re, n, false);
 
 	/*
 	 * rib_add_multipath_nhe only fails in a couple spots
@@ -2152,16 +2141,8 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 		XFREE(MTYPE_RE, re);
 	}
 
-	/* At this point, these allocations are not needed: 're' has been
-	 * retained or freed, and if 're' still exists, it is using
-	 * a reference to a shared group object.
-	 */
-	nexthop_group_delete(&ng);
-	if (bnhg)
-		zebra_nhg_backup_free(&bnhg);
-
 	/* Stats */
-	switch (api.prefix.family) {
+	switch (api->prefix.family) {
 	case AF_INET:
 		if (ret == 0)
 			client->v4_route_add_cnt++;
@@ -2177,6 +2158,94 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	}
 }
 
+static void zread_route_add(ZAPI_HANDLER_ARGS)
+{
+	struct stream *s;
+	struct zapi_route api;
+	struct prefix_ipv6 *src_p = NULL;
+	struct nexthop_group *ng = NULL;
+	struct nhg_backup_info *bnhg = NULL;
+	struct nhg_hash_entry nhe;
+
+	s = msg;
+	if (zapi_route_decode(s, &api) < 0) {
+		if (IS_ZEBRA_DEBUG_RECV)
+			zlog_debug("%s: Unable to decode zapi_route sent",
+				   __func__);
+		return;
+	}
+
+	if (IS_ZEBRA_DEBUG_RECV)
+		zlog_debug("%s: p=(%u:%u)%pFX, msg flags=0x%x, flags=0x%x",
+			   __func__, zvrf_id(zvrf), api.tableid, &api.prefix,
+			   (int)api.message, api.flags);
+
+	if (!zapi_route_add_prepare(client, &api, &nhe, &ng, &bnhg))
+		return;
+
+	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX))
+		src_p = &api.src_prefix;
+
+	zapi_route_add_queue(client, zvrf, &api, src_p, &nhe);
+
+	/* At this point, these allocations are not needed: the route has
+	 * been retained or freed, and if it still exists, it is using
+	 * a reference to a shared group object.
+	 */
+	nexthop_group_delete(&ng);
+	if (bnhg)
+		zebra_nhg_backup_free(&bnhg);
+}
+
+/*
+ * Many routes sharing their nexthops and attributes: the nexthops are only
+ * read once, then each prefix is queued like a single route.
+ */
+static void zread_route_add_bulk(ZAPI_HANDLER_ARGS)
+{
+	struct stream *s;
+	struct zapi_route api;
+	struct nexthop_group *ng = NULL;
+	struct nhg_backup_info *bnhg = NULL;
+	struct nhg_hash_entry nhe;
+	uint32_t count, i;
+
+	s = msg;
+	if (zapi_route_bulk_decode(s, &api, &count) < 0) {
+		if (IS_ZEBRA_DEBUG_RECV)
+			zlog_debug("%s: Unable to decode zapi_route sent",
+				   __func__);
+		return;
+	}
+
+	if (IS_ZEBRA_DEBUG_RECV)
+		zlog_debug("%s: %u routes (%u:%u), msg flags=0x%x, flags=0x%x",
+			   __func__, count, zvrf_id(zvrf), api.tableid,
+			   (int)api.message, api.flags);
+
+	if (!zapi_route_add_prepare(client, &api, &nhe, &ng, &bnhg))
+		return;
+
+	for (i = 0; i < count; i++) {
+		if (zapi_route_bulk_decode_prefix(s, &api) < 0) {
+			if (IS_ZEBRA_DEBUG_RECV)
+				zlog_debug("%s: Unable to decode route %u of %u",
+					   __func__, i + 1, count);
+			break;
+		}
+
+		if (IS_ZEBRA_DEBUG_RECV && IS_ZEBRA_DEBUG_DETAIL)
+			zlog_debug("%s: p=(%u:%u)%pFX", __func__,
+				   zvrf_id(zvrf), api.tableid, &api.prefix);
+
+		zapi_route_add_queue(client, zvrf, &api, NULL, &nhe);
+	}
+
+	nexthop_group_delete(&ng);
+	if (bnhg)
+		zebra_nhg_backup_free(&bnhg);
+}
+
 void zapi_re_opaque_free(struct re_opaque *opaque)
 {
 	XFREE(MTYPE_RE_OPAQUE, opaque);
@@ -2229,6 +2298,52 @@ static void zread_route_del(ZAPI_HANDLER_ARGS)
 	}
 }
 
+static void zread_route_del_bulk(ZAPI_HANDLER_ARGS)
+{
+	struct stream *s;
+	struct zapi_route api;
+	uint32_t table_id, count, i;
+	afi_t afi;
+
+	s = msg;
+	if (zapi_route_bulk_decode(s, &api, &count) < 0)
+		return;
+
+	afi = family2afi(api.prefix.family);
+	if (api.tableid)
+		table_id = api.tableid;
+	else
+		table_id = zvrf->table_id;
+
+	if (IS_ZEBRA_DEBUG_RECV)
+		zlog_debug("%s: %u routes (%u:%u), msg flags=0x%x, flags=0x%x",
+			   __func__, count, zvrf_id(zvrf), table_id,
+			   (int)api.message, api.flags);
+
+	for (i = 0; i < count; i++) {
+		if (zapi_route_bulk_decode_prefix(s, &api) < 0) {
+			if (IS_ZEBRA_DEBUG_RECV)
+				zlog_debug("%s: Unable to decode route %u of %u",
+					   __func__, i + 1, count);
+			break;
+		}
+
+		if (IS_ZEBRA_DEBUG_RECV && IS_ZEBRA_DEBUG_DETAIL)
+			zlog_debug("%s: p=(%u:%u)%pFX", __func__,
+				   zvrf_id(zvrf), table_id, &api.prefix);
+
+		rib_delete(afi, api.safi, zvrf_id(zvrf), api.type, api.instance,
+			   api.flags, &api.prefix, NULL, NULL, 0, table_id,
+			   api.metric, api.distance, false);
+
+		/* Stats */
+		if (afi == AFI_IP)
+			client->v4_route_del_cnt++;
+		else
+			client->v6_route_del_cnt++;
+	}
+}
+
 /* MRIB Nexthop lookup for IPv4. */
 static void zread_nexthop_lookup_mrib(ZAPI_HANDLER_ARGS)
 {
@@ -2331,6 +2446,17 @@ static void zsend_capabilities(struct zserv *client, struct zebra_vrf *zvrf)
 	zserv_send_message(client, s);
 }
 
+static void zsend_ring_reply(struct zserv *client, bool accepted)
+{
+	struct stream *s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+
+	zclient_create_header(s, ZEBRA_RING_REPLY, VRF_DEFAULT);
+	stream_putc(s, accepted);
+
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zserv_send_message(client, s);
+}
+
 void zsend_capabilities_all_clients(void)
 {
 	struct listnode *node, *nnode;
@@ -2356,6 +2482,9 @@ static void zread_hello(ZAPI_HANDLER_ARGS)
 	uint8_t notify;
 	uint8_t synchronous;
 	uint32_t session_id;
+	uint32_t ring_size;
+	uint8_t namelen;
+	char name[SHMRING_NAMSIZ];
 
 	STREAM_GETC(msg, proto);
 	STREAM_GETW(msg, instance);
@@ -2389,6 +2518,19 @@ static void zread_hello(ZAPI_HANDLER_ARGS)
 		zsend_capabilities(client, zvrf);
 		zebra_vrf_update_all(client);
 	}
+
+	/* Optional shared memory ring offered by the client */
+	if (STREAM_READABLE(msg)) {
+		STREAM_GETL(msg, ring_size);
+		STREAM_GETC(msg, namelen);
+		if (namelen >= sizeof(name))
+			goto stream_failure;
+		STREAM_GET(name, msg, namelen);
+		name[namelen] = '\0';
+
+		zsend_ring_reply(client,
+				 zserv_ring_attach(client, name, ring_size));
+	}
 stream_failure:
 	return;
 }
@@ -3941,6 +4083,8 @@ void (*const zserv_handlers[])(ZAPI_HANDLER_ARGS) = {
 	[ZEBRA_TC_CLASS_DELETE] = zread_tc_class,
 	[ZEBRA_TC_FILTER_ADD] = zread_tc_filter,
 	[ZEBRA_TC_FILTER_DELETE] = zread_tc_filter,
+	[ZEBRA_ROUTE_ADD_BULK] = zread_route_add_bulk,
+	[ZEBRA_ROUTE_DELETE_BULK] = zread_route_del_bulk,
 };
 
 /*
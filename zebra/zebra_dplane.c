@@ -12,6 +12,7 @@
 #include "lib/debug.h"
 #include "lib/frratomic.h"
 #include "lib/frr_pthread.h"
+#include "lib/jhash.h"
 #include "lib/memory.h"
 #include "lib/zebra.h"
 #include "zebra/netconf_netlink.h"
@@ -32,6 +33,7 @@ DEFINE_MTYPE_STATIC(ZEBRA, DP_INTF, "Zebra DPlane Intf");
 DEFINE_MTYPE_STATIC(ZEBRA, DP_PROV, "Zebra DPlane Provider");
 DEFINE_MTYPE_STATIC(ZEBRA, DP_NETFILTER, "Zebra Netfilter Internal Object");
 DEFINE_MTYPE_STATIC(ZEBRA, DP_NS, "DPlane NSes");
+DEFINE_MTYPE_STATIC(ZEBRA, DP_SHARD, "Zebra DPlane Shard");
 
 #ifndef AOK
 #  define AOK 0
@@ -51,6 +53,11 @@ const uint32_t DPLANE_DEFAULT_MAX_QUEUED = 200;
 /* Default value for new work per cycle */
 const uint32_t DPLANE_DEFAULT_NEW_WORK = 100;
 
+/* Default number of worker pthreads for providers that support sharding;
+ * one means the provider runs in the dplane pthread itself.
+ */
+const uint32_t DPLANE_DEFAULT_SHARDS = 1;
+
 /* Validation check macro for context blocks */
 /* #define DPLANE_DEBUG 1 */
 
@@ -446,6 +453,19 @@ struct zebra_dplane_provider {
 
 	int (*dp_fini)(struct zebra_dplane_provider *prov, bool early_p);
 
+	/* Optional list-based entry point, used by the shard pthreads */
+	void (*dp_shard_fp)(struct zebra_dplane_provider *prov,
+			    struct dplane_ctx_list_head *list);
+
+	/* Shard pthreads, only (re)configured by the dplane pthread while
+	 * no work is out on them; dg_mutex protects them against the vty.
+	 */
+	struct dplane_shard *dp_shards;
+	uint32_t dp_shard_count;
+
+	/* Contexts handed to shards that haven't come back yet */
+	_Atomic uint32_t dp_shard_busy;
+
 	_Atomic uint32_t dp_in_counter;
 	_Atomic uint32_t dp_in_queued;
 	_Atomic uint32_t dp_in_max;
@@ -469,6 +489,26 @@ struct zebra_dplane_provider {
 /* Declare list of providers/plugins */
 DECLARE_DLIST(dplane_prov_list, struct zebra_dplane_provider, dp_link);
 
+/*
+ * Worker pthread for a sharded provider. Route updates are spread across
+ * the shards by prefix, so updates to one prefix are always handled by the
+ * same shard, in order.
+ */
+struct dplane_shard {
+	struct zebra_dplane_provider *prov;
+	uint32_t idx;
+
+	struct frr_pthread *fthread;
+	struct thread *t_work;
+
+	pthread_mutex_t mutex;
+	struct dplane_ctx_list_head in_list;
+
+	_Atomic uint32_t queued;
+	_Atomic uint32_t queued_max;
+	_Atomic uint32_t processed;
+};
+
 /* Declare types for list of zns info objects */
 PREDECL_DLIST(zns_info_list);
 
@@ -516,6 +556,9 @@ static struct zebra_dplane_globals {
 	/* Limit number of pending, unprocessed updates */
 	_Atomic uint32_t dg_max_queued_updates;
 
+	/* Number of shard pthreads for providers that support them */
+	_Atomic uint32_t dg_shard_count;
+
 	/* Control whether system route notifications should be produced. */
 	bool dg_sys_route_notifs;
 
@@ -2741,6 +2784,21 @@ void dplane_set_in_queue_limit(uint32_t limit, bool set)
 			      memory_order_relaxed);
 }
 
+/*
+ * Configure the number of shard pthreads; takes effect once the work
+ * currently out on the shards has completed.
+ */
+void dplane_set_shard_count(uint32_t count, bool set)
+{
+	if (!set)
+		count = DPLANE_DEFAULT_SHARDS;
+
+	atomic_store_explicit(&zdplane_info.dg_shard_count, count,
+			      memory_order_relaxed);
+
+	dplane_provider_work_ready();
+}
+
 /*
  * Retrieve the current queue depth of incoming, unprocessed updates
  */
@@ -3112,6 +3170,42 @@ int dplane_ctx_nexthop_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 	return ret;
 }
 
+/**
+ * dplane_ctx_nexthop_copy() - Initialize a context block from another
+ * nexthop context, for providers that send the same update more than once
+ *
+ * @ctx:	Dataplane context to init
+ * @src:	Nexthop context to copy
+ *
+ * Return:	Result status
+ */
+int dplane_ctx_nexthop_copy(struct zebra_dplane_ctx *ctx,
+			    const struct zebra_dplane_ctx *src)
+{
+	if (!ctx || !src)
+		return EINVAL;
+
+	ctx->zd_op = src->zd_op;
+	ctx->zd_status = src->zd_status;
+	ctx->zd_is_update = src->zd_is_update;
+	ctx->zd_vrf_id = src->zd_vrf_id;
+	ctx->zd_ns_info = src->zd_ns_info;
+
+	ctx->u.rinfo.nhe.id = src->u.rinfo.nhe.id;
+	ctx->u.rinfo.nhe.old_id = src->u.rinfo.nhe.old_id;
+	ctx->u.rinfo.nhe.afi = src->u.rinfo.nhe.afi;
+	ctx->u.rinfo.nhe.vrf_id = src->u.rinfo.nhe.vrf_id;
+	ctx->u.rinfo.nhe.type = src->u.rinfo.nhe.type;
+
+	nexthop_group_copy(&(ctx->u.rinfo.nhe.ng), &(src->u.rinfo.nhe.ng));
+
+	memcpy(ctx->u.rinfo.nhe.nh_grp, src->u.rinfo.nhe.nh_grp,
+	       sizeof(ctx->u.rinfo.nhe.nh_grp));
+	ctx->u.rinfo.nhe.nh_grp_count = src->u.rinfo.nhe.nh_grp_count;
+
+	return AOK;
+}
+
 /**
  * dplane_ctx_intf_init() - Initialize a context block for a interface update
  *
@@ -5508,6 +5602,35 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 	return CMD_SUCCESS;
 }
 
+static void dplane_show_shards(struct vty *vty,
+			       struct zebra_dplane_provider *prov)
+{
+	struct dplane_shard *shard;
+	uint32_t i;
+
+	DPLANE_LOCK();
+
+	vty_out(vty, "  shards: %u, busy: %u\n",
+		prov->dp_shard_count ? prov->dp_shard_count : 1,
+		atomic_load_explicit(&prov->dp_shard_busy,
+				     memory_order_relaxed));
+
+	for (i = 0; i < prov->dp_shard_count; i++) {
+		shard = &prov->dp_shards[i];
+
+		vty_out(vty, "    shard %u: processed: %u, q: %u, q_max: %u\n",
+			i,
+			atomic_load_explicit(&shard->processed,
+					     memory_order_relaxed),
+			atomic_load_explicit(&shard->queued,
+					     memory_order_relaxed),
+			atomic_load_explicit(&shard->queued_max,
+					     memory_order_relaxed));
+	}
+
+	DPLANE_UNLOCK();
+}
+
 /*
  * Handler for 'show dplane providers'
  */
@@ -5542,6 +5665,9 @@ int dplane_show_provs_helper(struct vty *vty, bool detailed)
 			prov->dp_name, prov->dp_id, in, in_q, in_max,
 			out, out_q, out_max);
 
+		if (prov->dp_shard_fp)
+			dplane_show_shards(vty, prov);
+
 		prov = dplane_prov_list_next(&zdplane_info.dg_providers, prov);
 	}
 
@@ -5553,10 +5679,17 @@ int dplane_show_provs_helper(struct vty *vty, bool detailed)
  */
 int dplane_config_write_helper(struct vty *vty)
 {
+	uint32_t shards;
+
 	if (zdplane_info.dg_max_queued_updates != DPLANE_DEFAULT_MAX_QUEUED)
 		vty_out(vty, "zebra dplane limit %u\n",
 			zdplane_info.dg_max_queued_updates);
 
+	shards = atomic_load_explicit(&zdplane_info.dg_shard_count,
+				      memory_order_relaxed);
+	if (shards != DPLANE_DEFAULT_SHARDS)
+		vty_out(vty, "zebra dplane shards %u\n", shards);
+
 	return 0;
 }
 
@@ -5638,6 +5771,18 @@ done:
 	return ret;
 }
 
+/* Number of registered providers, the kernel one included */
+uint32_t dplane_provider_count(void)
+{
+	uint32_t count;
+
+	DPLANE_LOCK();
+	count = dplane_prov_list_count(&zdplane_info.dg_providers);
+	DPLANE_UNLOCK();
+
+	return count;
+}
+
 /* Accessors for provider attributes */
 const char *dplane_provider_get_name(const struct zebra_dplane_provider *prov)
 {
@@ -5768,6 +5913,276 @@ bool dplane_provider_is_threaded(const struct zebra_dplane_provider *prov)
 	return (prov->dp_flags & DPLANE_PROV_FLAG_THREADED);
 }
 
+/*
+ * Offer a list-based entry point that may be run concurrently on several
+ * shard pthreads; only valid for THREADED providers, before the dplane
+ * pthread has started.
+ */
+int dplane_provider_set_shard_func(
+	struct zebra_dplane_provider *prov,
+	void (*fp)(struct zebra_dplane_provider *prov,
+		   struct dplane_ctx_list_head *list))
+{
+	if (!dplane_provider_is_threaded(prov))
+		return EINVAL;
+
+	prov->dp_shard_fp = fp;
+
+	return AOK;
+}
+
+/*
+ * Only route updates are spread across shards; anything else (nexthop
+ * groups, LSPs, interface and neighbor updates, ...) may be depended on by
+ * later route updates, so it is handled in order in the dplane pthread.
+ */
+static bool dplane_ctx_is_shardable(const struct zebra_dplane_ctx *ctx)
+{
+	switch (ctx->zd_op) {
+	case DPLANE_OP_ROUTE_INSTALL:
+	case DPLANE_OP_ROUTE_UPDATE:
+	case DPLANE_OP_ROUTE_DELETE:
+		return true;
+	default:
+		return false;
+	}
+}
+
+static uint32_t dplane_ctx_shard_hash(const struct zebra_dplane_ctx *ctx)
+{
+	return jhash_2words(prefix_hash_key(&ctx->u.rinfo.zd_dest),
+			    ctx->zd_table_id, ctx->zd_vrf_id);
+}
+
+/*
+ * Shard pthread event: run a batch of contexts through the provider.
+ */
+static void dplane_shard_work(struct thread *event)
+{
+	struct dplane_shard *shard = THREAD_ARG(event);
+	struct zebra_dplane_provider *prov = shard->prov;
+	struct dplane_ctx_list_head work_list;
+	struct zebra_dplane_ctx *ctx;
+	uint32_t counter = 0, limit;
+	bool reschedule;
+
+	limit = zdplane_info.dg_updates_per_cycle;
+	dplane_ctx_list_init(&work_list);
+
+	frr_with_mutex (&shard->mutex) {
+		while (counter < limit &&
+		       (ctx = dplane_ctx_list_pop(&shard->in_list)) != NULL) {
+			dplane_ctx_list_add_tail(&work_list, ctx);
+			counter++;
+		}
+		reschedule = dplane_ctx_list_count(&shard->in_list) > 0;
+	}
+
+	if (counter == 0)
+		return;
+
+	atomic_fetch_sub_explicit(&shard->queued, counter,
+				  memory_order_relaxed);
+
+	/* The provider passes each context on to its out-queue */
+	(*prov->dp_shard_fp)(prov, &work_list);
+
+	atomic_fetch_add_explicit(&shard->processed, counter,
+				  memory_order_relaxed);
+	atomic_fetch_sub_explicit(&prov->dp_shard_busy, counter,
+				  memory_order_release);
+
+	if (reschedule)
+		thread_add_event(shard->fthread->master, dplane_shard_work,
+				 shard, 0, &shard->t_work);
+
+	/* Results are ready for the next provider */
+	dplane_provider_work_ready();
+}
+
+static void dplane_shards_stop(struct zebra_dplane_provider *prov)
+{
+	struct dplane_shard *shards;
+	uint32_t i, count;
+
+	DPLANE_LOCK();
+	shards = prov->dp_shards;
+	count = prov->dp_shard_count;
+	prov->dp_shards = NULL;
+	prov->dp_shard_count = 0;
+	DPLANE_UNLOCK();
+
+	for (i = 0; i < count; i++) {
+		frr_pthread_stop(shards[i].fthread, NULL);
+		frr_pthread_destroy(shards[i].fthread);
+		pthread_mutex_destroy(&shards[i].mutex);
+	}
+
+	XFREE(MTYPE_DP_SHARD, shards);
+}
+
+static void dplane_shards_start(struct zebra_dplane_provider *prov,
+				uint32_t count)
+{
+	struct frr_pthread_attr pattr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop
+	};
+	struct dplane_shard *shards;
+	char name[DPLANE_PROVIDER_NAMELEN + 16];
+	char os_name[OS_THREAD_NAMELEN];
+	uint32_t i;
+
+	shards = XCALLOC(MTYPE_DP_SHARD, count * sizeof(*shards));
+
+	for (i = 0; i < count; i++) {
+		shards[i].prov = prov;
+		shards[i].idx = i;
+		pthread_mutex_init(&shards[i].mutex, NULL);
+		dplane_ctx_list_init(&shards[i].in_list);
+
+		snprintf(name, sizeof(name), "%s shard %u", prov->dp_name, i);
+		snprintf(os_name, sizeof(os_name), "zebra_dp%u_%u",
+			 prov->dp_id, i);
+
+		shards[i].fthread = frr_pthread_new(&pattr, name, os_name);
+		frr_pthread_run(shards[i].fthread, NULL);
+	}
+
+	DPLANE_LOCK();
+	prov->dp_shards = shards;
+	prov->dp_shard_count = count;
+	DPLANE_UNLOCK();
+}
+
+/*
+ * Bring the provider's shards in line with the configured count. This can
+ * only happen while no work is out on the shards, so that per-prefix
+ * ordering is kept across the change. Returns false if dispatching must
+ * wait for that.
+ */
+static bool dplane_shards_update(struct zebra_dplane_provider *prov)
+{
+	uint32_t want;
+
+	want = atomic_load_explicit(&zdplane_info.dg_shard_count,
+				    memory_order_relaxed);
+	if (want <= 1)
+		want = 0;
+
+	if (want == prov->dp_shard_count)
+		return true;
+
+	if (atomic_load_explicit(&prov->dp_shard_busy, memory_order_acquire))
+		return false;
+
+	if (IS_ZEBRA_DEBUG_DPLANE)
+		zlog_debug("dplane provider '%s': %u shards",
+			   dplane_provider_get_name(prov), want);
+
+	dplane_shards_stop(prov);
+	if (want)
+		dplane_shards_start(prov, want);
+
+	return true;
+}
+
+/* Run contexts that must not be reordered, in the dplane pthread */
+static void dplane_shard_run_serial(struct zebra_dplane_provider *prov,
+				    struct dplane_ctx_list_head *list)
+{
+	if (dplane_ctx_list_count(list) == 0)
+		return;
+
+	(*prov->dp_shard_fp)(prov, list);
+	dplane_ctx_list_init(list);
+}
+
+/*
+ * Replacement for the provider's own callback while it has shards: move
+ * work from the provider's in-queue to the shards.
+ */
+static void dplane_shard_dispatch(struct zebra_dplane_provider *prov)
+{
+	struct dplane_ctx_list_head serial_list;
+	struct zebra_dplane_ctx *ctx;
+	struct dplane_shard *shard;
+	uint32_t counter, limit, idx, curr, high, wake = 0;
+	bool shardable;
+
+	limit = dplane_provider_get_work_limit(prov);
+	dplane_ctx_list_init(&serial_list);
+
+	for (counter = 0; counter < limit; counter++) {
+		dplane_provider_lock(prov);
+
+		ctx = dplane_ctx_list_first(&(prov->dp_ctx_in_list));
+		shardable = ctx && dplane_ctx_is_shardable(ctx);
+
+		/* Ordered work waits until the shards have drained */
+		if (ctx && !shardable &&
+		    atomic_load_explicit(&prov->dp_shard_busy,
+					 memory_order_acquire))
+			ctx = NULL;
+
+		if (ctx) {
+			dplane_ctx_list_del(&(prov->dp_ctx_in_list), ctx);
+			atomic_fetch_sub_explicit(&prov->dp_in_queued, 1,
+						  memory_order_relaxed);
+		}
+
+		dplane_provider_unlock(prov);
+
+		if (ctx == NULL)
+			break;
+
+		if (!shardable) {
+			dplane_ctx_list_add_tail(&serial_list, ctx);
+			continue;
+		}
+
+		/* Anything ordered before this update goes first */
+		dplane_shard_run_serial(prov, &serial_list);
+
+		idx = dplane_ctx_shard_hash(ctx) % prov->dp_shard_count;
+		shard = &prov->dp_shards[idx];
+
+		atomic_fetch_add_explicit(&prov->dp_shard_busy, 1,
+					  memory_order_relaxed);
+
+		frr_with_mutex (&shard->mutex) {
+			dplane_ctx_list_add_tail(&shard->in_list, ctx);
+		}
+
+		curr = atomic_fetch_add_explicit(&shard->queued, 1,
+						 memory_order_relaxed) + 1;
+		high = atomic_load_explicit(&shard->queued_max,
+					    memory_order_relaxed);
+		if (curr > high)
+			atomic_store_explicit(&shard->queued_max, curr,
+					      memory_order_relaxed);
+
+		wake |= (1U << idx);
+	}
+
+	dplane_shard_run_serial(prov, &serial_list);
+
+	for (idx = 0; idx < prov->dp_shard_count; idx++) {
+		if (!(wake & (1U << idx)))
+			continue;
+
+		shard = &prov->dp_shards[idx];
+		thread_add_event(shard->fthread->master, dplane_shard_work,
+				 shard, 0, &shard->t_work);
+	}
+
+	if (counter >= limit) {
+		atomic_fetch_add_explicit(&zdplane_info.dg_update_yields, 1,
+					  memory_order_relaxed);
+		dplane_provider_work_ready();
+	}
+}
+
 #ifdef HAVE_NETLINK
 /*
  * Callback when an OS (netlink) incoming event read is ready. This runs
@@ -6307,26 +6722,18 @@ void dplane_rib_add_multipath(afi_t afi, safi_t safi, struct prefix *p,
 }
 
 /*
- * Kernel provider callback
+ * Kernel provider: process a list of contexts, passing each one on to the
+ * provider's out-queue. This may run in several shard pthreads at once.
  */
-static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
+static void kernel_dplane_process_list(struct zebra_dplane_provider *prov,
+				       struct dplane_ctx_list_head *list)
 {
 	struct zebra_dplane_ctx *ctx;
 	struct dplane_ctx_list_head work_list;
-	int counter, limit;
 
 	dplane_ctx_list_init(&work_list);
 
-	limit = dplane_provider_get_work_limit(prov);
-
-	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
-		zlog_debug("dplane provider '%s': processing",
-			   dplane_provider_get_name(prov));
-
-	for (counter = 0; counter < limit; counter++) {
-		ctx = dplane_provider_dequeue_in_ctx(prov);
-		if (ctx == NULL)
-			break;
+	while ((ctx = dplane_ctx_list_pop(list)) != NULL) {
 		if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
 			kernel_dplane_log_detail(ctx);
 
@@ -6351,6 +6758,27 @@ static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 
 		dplane_provider_enqueue_out_ctx(prov, ctx);
 	}
+}
+
+/*
+ * Kernel provider callback
+ */
+static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
+{
+	struct dplane_ctx_list_head work_list;
+	int counter, limit;
+
+	dplane_ctx_list_init(&work_list);
+
+	limit = dplane_provider_get_work_limit(prov);
+
+	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
+		zlog_debug("dplane provider '%s': processing",
+			   dplane_provider_get_name(prov));
+
+	counter = dplane_provider_dequeue_in_list(prov, &work_list);
+
+	kernel_dplane_process_list(prov, &work_list);
 
 	/* Ensure that we'll run the work loop again if there's still
 	 * more work to do.
@@ -6440,17 +6868,24 @@ static int test_dplane_shutdown_func(struct zebra_dplane_provider *prov,
 static void dplane_provider_init(void)
 {
 	int ret;
+	struct zebra_dplane_provider *prov;
 
+	/* The kernel provider can shard route updates across pthreads, so
+	 * its queues need locking.
+	 */
 	ret = dplane_provider_register("Kernel",
 				       DPLANE_PRIO_KERNEL,
-				       DPLANE_PROV_FLAGS_DEFAULT, NULL,
+				       DPLANE_PROV_FLAG_THREADED, NULL,
 				       kernel_dplane_process_func,
 				       NULL,
-				       NULL, NULL);
+				       NULL, &prov);
 
 	if (ret != AOK)
 		zlog_err("Unable to register kernel dplane provider: %d",
 			 ret);
+	else
+		dplane_provider_set_shard_func(prov,
+					       kernel_dplane_process_list);
 
 #ifdef DPLANE_TEST_PROVIDER
 	/* Optional test provider ... */
@@ -6581,6 +7016,10 @@ static bool dplane_work_pending(void)
 		if (ctx != NULL)
 			break;
 
+		if (atomic_load_explicit(&prov->dp_shard_busy,
+					 memory_order_relaxed))
+			return true;
+
 		prov = dplane_prov_list_next(&zdplane_info.dg_providers, prov);
 	}
 
@@ -6781,7 +7220,14 @@ static void dplane_thread_loop(struct thread *event)
 		 * unconditional: we offer to do work even if we don't enqueue
 		 * any _new_ work.
 		 */
-		(*prov->dp_fp)(prov);
+		if (prov->dp_shard_fp == NULL)
+			(*prov->dp_fp)(prov);
+		else if (dplane_shards_update(prov)) {
+			if (prov->dp_shard_count > 0)
+				dplane_shard_dispatch(prov);
+			else
+				(*prov->dp_fp)(prov);
+		}
 
 		/* Check for zebra shutdown */
 		if (!zdplane_info.dg_run)
@@ -6868,6 +7314,10 @@ void zebra_dplane_shutdown(void)
 	zdplane_info.dg_pthread = NULL;
 	zdplane_info.dg_master = NULL;
 
+	/* Stop any shard pthreads */
+	frr_each (dplane_prov_list, &zdplane_info.dg_providers, dp)
+		dplane_shards_stop(dp);
+
 	/* Notify provider(s) of final shutdown.
 	 * Note that this call is in the main pthread, so providers must
 	 * be prepared for that.
@@ -6902,6 +7352,8 @@ static void zebra_dplane_init_internal(void)
 
 	zdplane_info.dg_max_queued_updates = DPLANE_DEFAULT_MAX_QUEUED;
 
+	zdplane_info.dg_shard_count = DPLANE_DEFAULT_SHARDS;
+
 	/* Register default kernel 'provider' during init */
 	dplane_provider_init();
 }
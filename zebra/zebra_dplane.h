@@ -906,6 +906,10 @@ int dplane_ctx_route_init_basic(struct zebra_dplane_ctx *ctx,
 int dplane_ctx_nexthop_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 			    struct nhg_hash_entry *nhe);
 
+/* Copy the next hop information of another context, e.g. to send it twice. */
+int dplane_ctx_nexthop_copy(struct zebra_dplane_ctx *ctx,
+			    const struct zebra_dplane_ctx *src);
+
 /* Encode interface information into data plane context. */
 int dplane_ctx_intf_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 			 const struct interface *ifp);
@@ -921,6 +925,11 @@ uint32_t dplane_get_in_queue_limit(void);
  */
 void dplane_set_in_queue_limit(uint32_t limit, bool set);
 
+/* Configure the number of pthreads that sharding providers spread their
+ * work across. If 'unset', reset to default value.
+ */
+void dplane_set_shard_count(uint32_t count, bool set);
+
 /* Retrieve the current queue depth of incoming, unprocessed updates */
 uint32_t dplane_get_in_queue_len(void);
 
@@ -993,12 +1002,27 @@ int dplane_provider_register(const char *name,
 			     void *data,
 			     struct zebra_dplane_provider **prov_p);
 
+/* Number of registered providers, the kernel one included */
+uint32_t dplane_provider_count(void);
+
 /* Accessors for provider attributes */
 const char *dplane_provider_get_name(const struct zebra_dplane_provider *prov);
 uint32_t dplane_provider_get_id(const struct zebra_dplane_provider *prov);
 void *dplane_provider_get_data(const struct zebra_dplane_provider *prov);
 bool dplane_provider_is_threaded(const struct zebra_dplane_provider *prov);
 
+/* THREADED providers can offer a second entry point that takes a list of
+ * contexts and passes each one on with dplane_provider_enqueue_out_ctx().
+ * If 'zebra dplane shards' is configured, it is called concurrently on that
+ * many pthreads, with route updates spread across them by prefix; other
+ * updates are handled in order in the dplane pthread. The provider's
+ * regular callback isn't used while there are shards.
+ */
+int dplane_provider_set_shard_func(
+	struct zebra_dplane_provider *prov,
+	void (*fp)(struct zebra_dplane_provider *prov,
+		   struct dplane_ctx_list_head *list));
+
 /* Lock/unlock a provider's mutex - iff the provider was registered with
  * the THREADED flag.
  */
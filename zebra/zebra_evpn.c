@@ -127,7 +127,7 @@ CPP_NOTICE("Drop `vrf` from JSON output")
 		return;
 	}
 	num_macs = num_valid_macs(zevpn);
-	num_neigh = hashcount(zevpn->neigh_table);
+	num_neigh = zebra_neigh_db_count(&zevpn->neigh_table);
 	if (json == NULL) {
 		vty_out(vty, " VxLAN interface: %s\n", zevpn->vxlan_if->name);
 		vty_out(vty, " VxLAN ifIndex: %u\n", zevpn->vxlan_if->ifindex);
@@ -247,7 +247,7 @@ void zebra_evpn_print_hash(struct hash_bucket *bucket, void *ctxt[])
 	}
 
 	num_macs = num_valid_macs(zevpn);
-	num_neigh = hashcount(zevpn->neigh_table);
+	num_neigh = zebra_neigh_db_count(&zevpn->neigh_table);
 	if (json == NULL)
 		vty_out(vty, "%-10u %-4s %-21s %-8u %-8u %-15u %-37s\n",
 			zevpn->vni, "L2",
@@ -930,14 +930,10 @@ struct interface *zebra_evpn_map_to_macvlan(struct interface *br_if,
 /*
  * Uninstall MAC hash entry - called upon access VLAN change.
  */
-static void zebra_evpn_uninstall_mac_hash(struct hash_bucket *bucket,
-					  void *ctxt)
+static void zebra_evpn_uninstall_mac_hash(struct zebra_mac *mac, void *ctxt)
 {
-	struct zebra_mac *mac;
 	struct mac_walk_ctx *wctx = ctxt;
 
-	mac = (struct zebra_mac *)bucket->data;
-
 	if (CHECK_FLAG(mac->flags, ZEBRA_MAC_REMOTE))
 		zebra_evpn_rem_mac_uninstall(wctx->zevpn, mac, false);
 }
@@ -945,13 +941,10 @@ static void zebra_evpn_uninstall_mac_hash(struct hash_bucket *bucket,
 /*
  * Install MAC hash entry - called upon access VLAN change.
  */
-static void zebra_evpn_install_mac_hash(struct hash_bucket *bucket, void *ctxt)
+static void zebra_evpn_install_mac_hash(struct zebra_mac *mac, void *ctxt)
 {
-	struct zebra_mac *mac;
 	struct mac_walk_ctx *wctx = ctxt;
 
-	mac = (struct zebra_mac *)bucket->data;
-
 	if (CHECK_FLAG(mac->flags, ZEBRA_MAC_REMOTE))
 		zebra_evpn_rem_mac_install(wctx->zevpn, mac, false);
 }
@@ -963,16 +956,13 @@ void zebra_evpn_rem_mac_uninstall_all(struct zebra_evpn *zevpn)
 {
 	struct mac_walk_ctx wctx;
 
-	if (!zevpn->mac_table)
-		return;
-
 	memset(&wctx, 0, sizeof(struct mac_walk_ctx));
 	wctx.zevpn = zevpn;
 	wctx.uninstall = 1;
 	wctx.upd_client = 0;
 	wctx.flags = ZEBRA_MAC_REMOTE;
 
-	hash_iterate(zevpn->mac_table, zebra_evpn_uninstall_mac_hash, &wctx);
+	zebra_evpn_mac_iterate(zevpn, zebra_evpn_uninstall_mac_hash, &wctx);
 }
 
 /*
@@ -982,16 +972,13 @@ void zebra_evpn_rem_mac_install_all(struct zebra_evpn *zevpn)
 {
 	struct mac_walk_ctx wctx;
 
-	if (!zevpn->mac_table)
-		return;
-
 	memset(&wctx, 0, sizeof(struct mac_walk_ctx));
 	wctx.zevpn = zevpn;
 	wctx.uninstall = 0;
 	wctx.upd_client = 0;
 	wctx.flags = ZEBRA_MAC_REMOTE;
 
-	hash_iterate(zevpn->mac_table, zebra_evpn_install_mac_hash, &wctx);
+	zebra_evpn_mac_iterate(zevpn, zebra_evpn_install_mac_hash, &wctx);
 }
 
 /*
@@ -1112,7 +1099,6 @@ struct zebra_evpn *zebra_evpn_lookup(vni_t vni)
  */
 struct zebra_evpn *zebra_evpn_add(vni_t vni)
 {
-	char buffer[80];
 	struct zebra_vrf *zvrf;
 	struct zebra_evpn tmp_zevpn;
 	struct zebra_evpn *zevpn = NULL;
@@ -1124,14 +1110,9 @@ struct zebra_evpn *zebra_evpn_add(vni_t vni)
 
 	zebra_evpn_es_evi_init(zevpn);
 
-	snprintf(buffer, sizeof(buffer), "Zebra EVPN MAC Table vni: %u", vni);
-	/* Create hash table for MAC */
-	zevpn->mac_table = zebra_mac_db_create(buffer);
-
-	snprintf(buffer, sizeof(buffer), "Zebra EVPN Neighbor Table vni: %u",
-		 vni);
-	/* Create hash table for neighbors */
-	zevpn->neigh_table = zebra_neigh_db_create(buffer);
+	/* Create hash tables for MACs and neighbors */
+	zebra_mac_db_init(&zevpn->mac_table);
+	zebra_neigh_db_init(&zevpn->neigh_table);
 
 	return zevpn;
 }
@@ -1148,13 +1129,17 @@ int zebra_evpn_del(struct zebra_evpn *zevpn)
 
 	zevpn->svi_if = NULL;
 
-	/* Free the neighbor hash table. */
-	hash_free(zevpn->neigh_table);
-	zevpn->neigh_table = NULL;
+	/*
+	 * Free the neighbor and MAC hash tables.  Entries still in there are
+	 * unlinked only, as they were with the bucket based tables.
+	 */
+	while (zebra_neigh_db_pop(&zevpn->neigh_table))
+		;
+	zebra_neigh_db_fini(&zevpn->neigh_table);
 
-	/* Free the MAC hash table. */
-	hash_free(zevpn->mac_table);
-	zevpn->mac_table = NULL;
+	while (zebra_mac_db_pop(&zevpn->mac_table))
+		;
+	zebra_mac_db_fini(&zevpn->mac_table);
 
 	/* Remove references to the zevpn in the MH databases */
 	if (zevpn->vxlan_if)
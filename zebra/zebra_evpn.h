@@ -14,6 +14,7 @@
 #include "if.h"
 #include "linklist.h"
 #include "bitfield.h"
+#include "typesafe.h"
 
 #include "zebra/zebra_l2.h"
 #include "zebra/interface.h"
@@ -54,6 +55,10 @@ struct zebra_vtep {
 	struct zebra_vtep *prev;
 };
 
+/* MAC and neighbor tables, declared in zebra_evpn_mac.h/zebra_evpn_neigh.h */
+PREDECL_HASH(zebra_mac_db);
+PREDECL_HASH(zebra_neigh_db);
+
 /*
  * VNI hash table
  *
@@ -100,10 +105,10 @@ struct zebra_evpn {
 	vrf_id_t vrf_id;
 
 	/* List of local or remote MAC */
-	struct hash *mac_table;
+	struct zebra_mac_db_head mac_table;
 
 	/* List of local or remote neighbors (MAC+IP) */
-	struct hash *neigh_table;
+	struct zebra_neigh_db_head neigh_table;
 
 	/* RB tree of ES-EVIs */
 	struct zebra_es_evi_rb_head es_evi_rb_tree;
@@ -35,23 +35,14 @@ DEFINE_MTYPE_STATIC(ZEBRA, MAC, "EVPN MAC");
  */
 uint32_t num_valid_macs(struct zebra_evpn *zevpn)
 {
-	unsigned int i;
 	uint32_t num_macs = 0;
-	struct hash *hash;
-	struct hash_bucket *hb;
 	struct zebra_mac *mac;
 
-	hash = zevpn->mac_table;
-	if (!hash)
-		return num_macs;
-	for (i = 0; i < hash->size; i++) {
-		for (hb = hash->index[i]; hb; hb = hb->next) {
-			mac = (struct zebra_mac *)hb->data;
-			if (CHECK_FLAG(mac->flags, ZEBRA_MAC_REMOTE)
-			    || CHECK_FLAG(mac->flags, ZEBRA_MAC_LOCAL)
-			    || !CHECK_FLAG(mac->flags, ZEBRA_MAC_AUTO))
-				num_macs++;
-		}
+	frr_each (zebra_mac_db, &zevpn->mac_table, mac) {
+		if (CHECK_FLAG(mac->flags, ZEBRA_MAC_REMOTE)
+		    || CHECK_FLAG(mac->flags, ZEBRA_MAC_LOCAL)
+		    || !CHECK_FLAG(mac->flags, ZEBRA_MAC_AUTO))
+			num_macs++;
 	}
 
 	return num_macs;
@@ -59,26 +50,31 @@ uint32_t num_valid_macs(struct zebra_evpn *zevpn)
 
 uint32_t num_dup_detected_macs(struct zebra_evpn *zevpn)
 {
-	unsigned int i;
 	uint32_t num_macs = 0;
-	struct hash *hash;
-	struct hash_bucket *hb;
 	struct zebra_mac *mac;
 
-	hash = zevpn->mac_table;
-	if (!hash)
-		return num_macs;
-	for (i = 0; i < hash->size; i++) {
-		for (hb = hash->index[i]; hb; hb = hb->next) {
-			mac = (struct zebra_mac *)hb->data;
-			if (CHECK_FLAG(mac->flags, ZEBRA_MAC_DUPLICATE))
-				num_macs++;
-		}
+	frr_each (zebra_mac_db, &zevpn->mac_table, mac) {
+		if (CHECK_FLAG(mac->flags, ZEBRA_MAC_DUPLICATE))
+			num_macs++;
 	}
 
 	return num_macs;
 }
 
+/*
+ * Run 'func' on every MAC of the EVPN; 'func' may delete the MAC it is
+ * given.
+ */
+void zebra_evpn_mac_iterate(struct zebra_evpn *zevpn,
+			    void (*func)(struct zebra_mac *mac, void *arg),
+			    void *arg)
+{
+	struct zebra_mac *mac;
+
+	frr_each_safe (zebra_mac_db, &zevpn->mac_table, mac)
+		func(mac, arg);
+}
+
 /* Setup mac_list against the access port. This is done when a mac uses
  * the ifp as destination for the first time
  */
@@ -841,11 +837,10 @@ static char *zebra_evpn_print_mac_flags(struct zebra_mac *mac, char *flags_buf,
 /*
  * Print MAC hash entry - called for display of all MACs.
  */
-void zebra_evpn_print_mac_hash(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_print_mac_hash(struct zebra_mac *mac, void *ctxt)
 {
 	struct vty *vty;
 	json_object *json_mac_hdr = NULL, *json_mac = NULL;
-	struct zebra_mac *mac;
 	char buf1[ETHER_ADDR_STRLEN];
 	char addr_buf[PREFIX_STRLEN];
 	struct mac_walk_ctx *wctx = ctxt;
@@ -853,7 +848,6 @@ void zebra_evpn_print_mac_hash(struct hash_bucket *bucket, void *ctxt)
 
 	vty = wctx->vty;
 	json_mac_hdr = wctx->json;
-	mac = (struct zebra_mac *)bucket->data;
 
 	prefix_mac2str(&mac->macaddr, buf1, sizeof(buf1));
 
@@ -965,19 +959,15 @@ void zebra_evpn_print_mac_hash(struct hash_bucket *bucket, void *ctxt)
 /*
  * Print MAC hash entry in detail - called for display of all MACs.
  */
-void zebra_evpn_print_mac_hash_detail(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_print_mac_hash_detail(struct zebra_mac *mac, void *ctxt)
 {
 	struct vty *vty;
 	json_object *json_mac_hdr = NULL;
-	struct zebra_mac *mac;
 	struct mac_walk_ctx *wctx = ctxt;
 	char buf1[ETHER_ADDR_STRLEN];
 
 	vty = wctx->vty;
 	json_mac_hdr = wctx->json;
-	mac = (struct zebra_mac *)bucket->data;
-	if (!mac)
-		return;
 
 	wctx->count++;
 	prefix_mac2str(&mac->macaddr, buf1, sizeof(buf1));
@@ -1081,32 +1071,21 @@ static bool mac_cmp(const void *p1, const void *p2)
 		== 0);
 }
 
-/*
- * Callback to allocate MAC hash entry.
- */
-static void *zebra_evpn_mac_alloc(void *p)
-{
-	const struct zebra_mac *tmp_mac = p;
-	struct zebra_mac *mac;
-
-	mac = XCALLOC(MTYPE_MAC, sizeof(struct zebra_mac));
-	*mac = *tmp_mac;
-
-	return ((void *)mac);
-}
-
 /*
  * Add MAC entry.
  */
 struct zebra_mac *zebra_evpn_mac_add(struct zebra_evpn *zevpn,
 				     const struct ethaddr *macaddr)
 {
-	struct zebra_mac tmp_mac;
-	struct zebra_mac *mac = NULL;
+	struct zebra_mac *mac, *old;
 
-	memset(&tmp_mac, 0, sizeof(tmp_mac));
-	memcpy(&tmp_mac.macaddr, macaddr, ETH_ALEN);
-	mac = hash_get(zevpn->mac_table, &tmp_mac, zebra_evpn_mac_alloc);
+	mac = XCALLOC(MTYPE_MAC, sizeof(struct zebra_mac));
+	memcpy(&mac->macaddr, macaddr, ETH_ALEN);
+	old = zebra_mac_db_add(&zevpn->mac_table, mac);
+	if (old) {
+		XFREE(MTYPE_MAC, mac);
+		mac = old;
+	}
 
 	mac->zevpn = zevpn;
 	mac->dad_mac_auto_recovery_timer = NULL;
@@ -1131,8 +1110,6 @@ struct zebra_mac *zebra_evpn_mac_add(struct zebra_evpn *zevpn,
  */
 int zebra_evpn_mac_del(struct zebra_evpn *zevpn, struct zebra_mac *mac)
 {
-	struct zebra_mac *tmp_mac;
-
 	if (IS_ZEBRA_DEBUG_VXLAN || IS_ZEBRA_DEBUG_EVPN_MH_MAC) {
 		char mac_buf[MAC_BUF_SIZE];
 
@@ -1177,8 +1154,8 @@ int zebra_evpn_mac_del(struct zebra_evpn *zevpn, struct zebra_mac *mac)
 	list_delete(&mac->neigh_list);
 
 	/* Free the VNI hash entry and allocated memory. */
-	tmp_mac = hash_release(zevpn->mac_table, mac);
-	XFREE(MTYPE_MAC, tmp_mac);
+	zebra_mac_db_del(&zevpn->mac_table, mac);
+	XFREE(MTYPE_MAC, mac);
 
 	return 0;
 }
@@ -1236,10 +1213,9 @@ static bool zebra_evpn_check_mac_del_from_db(struct mac_walk_ctx *wctx,
 /*
  * Free MAC hash entry (callback)
  */
-static void zebra_evpn_mac_del_hash_entry(struct hash_bucket *bucket, void *arg)
+static void zebra_evpn_mac_del_hash_entry(struct zebra_mac *mac, void *arg)
 {
 	struct mac_walk_ctx *wctx = arg;
-	struct zebra_mac *mac = bucket->data;
 
 	if (zebra_evpn_check_mac_del_from_db(wctx, mac)) {
 		if (wctx->upd_client && (mac->flags & ZEBRA_MAC_LOCAL)) {
@@ -1273,16 +1249,13 @@ void zebra_evpn_mac_del_all(struct zebra_evpn *zevpn, int uninstall,
 {
 	struct mac_walk_ctx wctx;
 
-	if (!zevpn->mac_table)
-		return;
-
 	memset(&wctx, 0, sizeof(wctx));
 	wctx.zevpn = zevpn;
 	wctx.uninstall = uninstall;
 	wctx.upd_client = upd_client;
 	wctx.flags = flags;
 
-	hash_iterate(zevpn->mac_table, zebra_evpn_mac_del_hash_entry, &wctx);
+	zebra_evpn_mac_iterate(zevpn, zebra_evpn_mac_del_hash_entry, &wctx);
 }
 
 /*
@@ -1296,7 +1269,7 @@ struct zebra_mac *zebra_evpn_mac_lookup(struct zebra_evpn *zevpn,
 
 	memset(&tmp, 0, sizeof(tmp));
 	memcpy(&tmp.macaddr, mac, ETH_ALEN);
-	pmac = hash_lookup(zevpn->mac_table, &tmp);
+	pmac = zebra_mac_db_find(&zevpn->mac_table, &tmp);
 
 	return pmac;
 }
@@ -1354,9 +1327,10 @@ int zebra_evpn_mac_send_del_to_client(vni_t vni, const struct ethaddr *macaddr,
 }
 
 /*
- * wrapper to create a MAC hash table
+ * wrapper to create a lib/hash MAC table, as the L3-VNI RMAC table still is;
+ * per-VNI MACs are in a zebra_mac_db instead
  */
-struct hash *zebra_mac_db_create(const char *desc)
+struct hash *zebra_mac_hash_create(const char *desc)
 {
 	return hash_create_size(8, mac_hash_keymake, mac_cmp, desc);
 }
@@ -1911,11 +1885,10 @@ static bool zebra_evpn_local_mac_update_fwd_info(struct zebra_mac *mac,
 }
 
 /* Notify Local MACs to the clienti, skips GW MAC */
-static void zebra_evpn_send_mac_hash_entry_to_client(struct hash_bucket *bucket,
+static void zebra_evpn_send_mac_hash_entry_to_client(struct zebra_mac *zmac,
 						     void *arg)
 {
 	struct mac_walk_ctx *wctx = arg;
-	struct zebra_mac *zmac = bucket->data;
 
 	if (CHECK_FLAG(zmac->flags, ZEBRA_MAC_DEF_GW))
 		return;
@@ -1931,14 +1904,11 @@ void zebra_evpn_send_mac_list_to_client(struct zebra_evpn *zevpn)
 {
 	struct mac_walk_ctx wctx;
 
-	if (!zevpn->mac_table)
-		return;
-
 	memset(&wctx, 0, sizeof(wctx));
 	wctx.zevpn = zevpn;
 
-	hash_iterate(zevpn->mac_table, zebra_evpn_send_mac_hash_entry_to_client,
-		     &wctx);
+	zebra_evpn_mac_iterate(zevpn, zebra_evpn_send_mac_hash_entry_to_client,
+			       &wctx);
 }
 
 void zebra_evpn_rem_mac_del(struct zebra_evpn *zevpn, struct zebra_mac *mac)
@@ -1967,30 +1937,17 @@ void zebra_evpn_rem_mac_del(struct zebra_evpn *zevpn, struct zebra_mac *mac)
 }
 
 /* Print Duplicate MAC */
-void zebra_evpn_print_dad_mac_hash(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_print_dad_mac_hash(struct zebra_mac *mac, void *ctxt)
 {
-	struct zebra_mac *mac;
-
-	mac = (struct zebra_mac *)bucket->data;
-	if (!mac)
-		return;
-
 	if (CHECK_FLAG(mac->flags, ZEBRA_MAC_DUPLICATE))
-		zebra_evpn_print_mac_hash(bucket, ctxt);
+		zebra_evpn_print_mac_hash(mac, ctxt);
 }
 
 /* Print Duplicate MAC in detail */
-void zebra_evpn_print_dad_mac_hash_detail(struct hash_bucket *bucket,
-					  void *ctxt)
+void zebra_evpn_print_dad_mac_hash_detail(struct zebra_mac *mac, void *ctxt)
 {
-	struct zebra_mac *mac;
-
-	mac = (struct zebra_mac *)bucket->data;
-	if (!mac)
-		return;
-
 	if (CHECK_FLAG(mac->flags, ZEBRA_MAC_DUPLICATE))
-		zebra_evpn_print_mac_hash_detail(bucket, ctxt);
+		zebra_evpn_print_mac_hash_detail(mac, ctxt);
 }
 
 int zebra_evpn_mac_remote_macip_add(struct zebra_evpn *zevpn,
@@ -9,6 +9,8 @@
 #ifndef _ZEBRA_EVPN_MAC_H
 #define _ZEBRA_EVPN_MAC_H
 
+#include "jhash.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -39,6 +41,9 @@ struct zebra_mac {
 	/* MAC address. */
 	struct ethaddr macaddr;
 
+	/* Entry in the EVPN's MAC table, kept next to the key. */
+	struct zebra_mac_db_item db_item;
+
 	/* When modifying flags please fixup zebra_evpn_zebra_mac_flag_dump */
 	uint32_t flags;
 #define ZEBRA_MAC_LOCAL 0x01
@@ -131,6 +136,20 @@ struct zebra_mac {
 	time_t uptime;
 };
 
+static inline int zebra_mac_db_cmp(const struct zebra_mac *mac1,
+				   const struct zebra_mac *mac2)
+{
+	return memcmp(mac1->macaddr.octet, mac2->macaddr.octet, ETH_ALEN);
+}
+
+static inline uint32_t zebra_mac_db_hash(const struct zebra_mac *mac)
+{
+	return jhash(mac->macaddr.octet, ETH_ALEN, 0xa5a5a55a);
+}
+
+DECLARE_HASH(zebra_mac_db, struct zebra_mac, db_item, zebra_mac_db_cmp,
+	     zebra_mac_db_hash);
+
 /*
  * Context for MAC hash walk - used by callbacks.
  */
@@ -193,8 +212,11 @@ static inline bool zebra_evpn_mac_in_use(struct zebra_mac *mac)
 	       || CHECK_FLAG(mac->flags, ZEBRA_MAC_SVI);
 }
 
-struct hash *zebra_mac_db_create(const char *desc);
+struct hash *zebra_mac_hash_create(const char *desc);
 uint32_t num_valid_macs(struct zebra_evpn *zevi);
+void zebra_evpn_mac_iterate(struct zebra_evpn *zevpn,
+			    void (*func)(struct zebra_mac *mac, void *arg),
+			    void *arg);
 uint32_t num_dup_detected_macs(struct zebra_evpn *zevi);
 int zebra_evpn_rem_mac_uninstall(struct zebra_evpn *zevi, struct zebra_mac *mac,
 				 bool force);
@@ -214,8 +236,8 @@ int zebra_evpn_macip_send_msg_to_client(uint32_t id,
 					uint32_t seq, int state,
 					struct zebra_evpn_es *es, uint16_t cmd);
 void zebra_evpn_print_mac(struct zebra_mac *mac, void *ctxt, json_object *json);
-void zebra_evpn_print_mac_hash(struct hash_bucket *bucket, void *ctxt);
-void zebra_evpn_print_mac_hash_detail(struct hash_bucket *bucket, void *ctxt);
+void zebra_evpn_print_mac_hash(struct zebra_mac *mac, void *ctxt);
+void zebra_evpn_print_mac_hash_detail(struct zebra_mac *mac, void *ctxt);
 int zebra_evpn_sync_mac_dp_install(struct zebra_mac *mac, bool set_inactive,
 				   bool force_clear_static, const char *caller);
 void zebra_evpn_mac_send_add_del_to_client(struct zebra_mac *mac,
@@ -238,9 +260,8 @@ struct zebra_mac *zebra_evpn_proc_sync_mac_update(struct zebra_evpn *zevi,
 						  const esi_t *esi);
 void zebra_evpn_sync_mac_del(struct zebra_mac *mac);
 void zebra_evpn_rem_mac_del(struct zebra_evpn *zevi, struct zebra_mac *mac);
-void zebra_evpn_print_dad_mac_hash(struct hash_bucket *bucket, void *ctxt);
-void zebra_evpn_print_dad_mac_hash_detail(struct hash_bucket *bucket,
-					  void *ctxt);
+void zebra_evpn_print_dad_mac_hash(struct zebra_mac *mac, void *ctxt);
+void zebra_evpn_print_dad_mac_hash_detail(struct zebra_mac *mac, void *ctxt);
 int zebra_evpn_mac_remote_macip_add(struct zebra_evpn *zevpn,
 				    struct zebra_vrf *zvrf,
 				    const struct ethaddr *macaddr,
@@ -592,7 +592,7 @@ static void zebra_evpn_acc_vl_free(struct zebra_evpn_access_bd *acc_bd)
 	if (IS_ZEBRA_DEBUG_EVPN_MH_ES)
 		zlog_debug("access vlan %d del", acc_bd->vid);
 
-	if (acc_bd->vlan_zif && acc_bd->zevpn && acc_bd->zevpn->mac_table)
+	if (acc_bd->vlan_zif && acc_bd->zevpn)
 		zebra_evpn_mac_svi_del(acc_bd->vlan_zif->ifp, acc_bd->zevpn);
 
 	/* cleanup resources maintained against the ES */
@@ -678,7 +678,7 @@ void zebra_evpn_acc_bd_svi_set(struct zebra_if *vlan_zif,
 			zlog_debug("vlan %d bridge %s SVI clear", vid,
 				   tmp_br_zif->ifp->name);
 		acc_bd->vlan_zif = NULL;
-		if (acc_bd->zevpn && acc_bd->zevpn->mac_table)
+		if (acc_bd->zevpn)
 			zebra_evpn_mac_svi_del(vlan_zif->ifp, acc_bd->zevpn);
 	}
 }
@@ -719,7 +719,7 @@ static void zebra_evpn_acc_bd_evpn_set(struct zebra_evpn_access_bd *acc_bd,
 		if (zevpn)
 			zebra_evpn_mac_svi_add(acc_bd->vlan_zif->ifp,
 					       acc_bd->zevpn);
-		else if (old_zevpn && old_zevpn->mac_table)
+		else if (old_zevpn)
 			zebra_evpn_mac_svi_del(acc_bd->vlan_zif->ifp,
 					       old_zevpn);
 	}
@@ -69,47 +69,50 @@ int neigh_list_cmp(void *p1, void *p2)
 	return ipaddr_cmp(&n1->ip, &n2->ip);
 }
 
-struct hash *zebra_neigh_db_create(const char *desc)
+/* lib/hash neighbor table, for the L3-VNI and SVD next-hop tables */
+struct hash *zebra_neigh_hash_create(const char *desc)
 {
 	return hash_create_size(8, neigh_hash_keymake, neigh_cmp, desc);
 }
 
 uint32_t num_dup_detected_neighs(struct zebra_evpn *zevpn)
 {
-	unsigned int i;
 	uint32_t num_neighs = 0;
-	struct hash *hash;
-	struct hash_bucket *hb;
 	struct zebra_neigh *nbr;
 
-	hash = zevpn->neigh_table;
-	if (!hash)
-		return num_neighs;
-	for (i = 0; i < hash->size; i++) {
-		for (hb = hash->index[i]; hb; hb = hb->next) {
-			nbr = (struct zebra_neigh *)hb->data;
-			if (CHECK_FLAG(nbr->flags, ZEBRA_NEIGH_DUPLICATE))
-				num_neighs++;
-		}
+	frr_each (zebra_neigh_db, &zevpn->neigh_table, nbr) {
+		if (CHECK_FLAG(nbr->flags, ZEBRA_NEIGH_DUPLICATE))
+			num_neighs++;
 	}
 
 	return num_neighs;
 }
 
+/*
+ * Run 'func' on every neighbor of the EVPN; 'func' may delete the neighbor
+ * it is given.
+ */
+void zebra_evpn_neigh_iterate(struct zebra_evpn *zevpn,
+			      void (*func)(struct zebra_neigh *n, void *arg),
+			      void *arg)
+{
+	struct zebra_neigh *n;
+
+	frr_each_safe (zebra_neigh_db, &zevpn->neigh_table, n)
+		func(n, arg);
+}
+
 /*
  * Helper function to determine maximum width of neighbor IP address for
  * display - just because we're dealing with IPv6 addresses that can
  * widely vary.
  */
-void zebra_evpn_find_neigh_addr_width(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_find_neigh_addr_width(struct zebra_neigh *n, void *ctxt)
 {
-	struct zebra_neigh *n;
 	char buf[INET6_ADDRSTRLEN];
 	struct neigh_walk_ctx *wctx = ctxt;
 	int width;
 
-	n = (struct zebra_neigh *)bucket->data;
-
 	ipaddr2str(&n->ip, buf, sizeof(buf));
 	width = strlen(buf);
 	if (width > wctx->addr_width)
@@ -163,32 +166,15 @@ int zebra_evpn_rem_neigh_install(struct zebra_evpn *zevpn,
 /*
  * Install neighbor hash entry - called upon access VLAN change.
  */
-void zebra_evpn_install_neigh_hash(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_install_neigh_hash(struct zebra_neigh *n, void *ctxt)
 {
-	struct zebra_neigh *n;
 	struct neigh_walk_ctx *wctx = ctxt;
 
-	n = (struct zebra_neigh *)bucket->data;
-
 	if (CHECK_FLAG(n->flags, ZEBRA_NEIGH_REMOTE))
 		zebra_evpn_rem_neigh_install(wctx->zevpn, n,
 					     false /*was_static*/);
 }
 
-/*
- * Callback to allocate neighbor hash entry.
- */
-static void *zebra_evpn_neigh_alloc(void *p)
-{
-	const struct zebra_neigh *tmp_n = p;
-	struct zebra_neigh *n;
-
-	n = XCALLOC(MTYPE_NEIGH, sizeof(struct zebra_neigh));
-	*n = *tmp_n;
-
-	return ((void *)n);
-}
-
 static void zebra_evpn_local_neigh_ref_mac(struct zebra_neigh *n,
 					   const struct ethaddr *macaddr,
 					   struct zebra_mac *mac,
@@ -544,12 +530,15 @@ static struct zebra_neigh *zebra_evpn_neigh_add(struct zebra_evpn *zevpn,
 						struct zebra_mac *zmac,
 						uint32_t n_flags)
 {
-	struct zebra_neigh tmp_n;
-	struct zebra_neigh *n = NULL;
+	struct zebra_neigh *n, *old;
 
-	memset(&tmp_n, 0, sizeof(tmp_n));
-	memcpy(&tmp_n.ip, ip, sizeof(struct ipaddr));
-	n = hash_get(zevpn->neigh_table, &tmp_n, zebra_evpn_neigh_alloc);
+	n = XCALLOC(MTYPE_NEIGH, sizeof(struct zebra_neigh));
+	memcpy(&n->ip, ip, sizeof(struct ipaddr));
+	old = zebra_neigh_db_add(&zevpn->neigh_table, n);
+	if (old) {
+		XFREE(MTYPE_NEIGH, n);
+		n = old;
+	}
 
 	n->state = ZEBRA_NEIGH_INACTIVE;
 	n->zevpn = zevpn;
@@ -570,8 +559,6 @@ static struct zebra_neigh *zebra_evpn_neigh_add(struct zebra_evpn *zevpn,
  */
 int zebra_evpn_neigh_del(struct zebra_evpn *zevpn, struct zebra_neigh *n)
 {
-	struct zebra_neigh *tmp_n;
-
 	if (n->mac)
 		listnode_delete(n->mac->neigh_list, n);
 
@@ -582,8 +569,8 @@ int zebra_evpn_neigh_del(struct zebra_evpn *zevpn, struct zebra_neigh *n)
 	zebra_evpn_neigh_stop_hold_timer(n);
 
 	/* Free the VNI hash entry and allocated memory. */
-	tmp_n = hash_release(zevpn->neigh_table, n);
-	XFREE(MTYPE_NEIGH, tmp_n);
+	zebra_neigh_db_del(&zevpn->neigh_table, n);
+	XFREE(MTYPE_NEIGH, n);
 
 	return 0;
 }
@@ -828,11 +815,9 @@ static int zebra_evpn_neigh_uninstall(struct zebra_evpn *zevpn,
 /*
  * Free neighbor hash entry (callback)
  */
-static void zebra_evpn_neigh_del_hash_entry(struct hash_bucket *bucket,
-					    void *arg)
+static void zebra_evpn_neigh_del_hash_entry(struct zebra_neigh *n, void *arg)
 {
 	struct neigh_walk_ctx *wctx = arg;
-	struct zebra_neigh *n = bucket->data;
 
 	if (((wctx->flags & DEL_LOCAL_NEIGH) && (n->flags & ZEBRA_NEIGH_LOCAL))
 	    || ((wctx->flags & DEL_REMOTE_NEIGH)
@@ -869,17 +854,13 @@ void zebra_evpn_neigh_del_all(struct zebra_evpn *zevpn, int uninstall,
 {
 	struct neigh_walk_ctx wctx;
 
-	if (!zevpn->neigh_table)
-		return;
-
 	memset(&wctx, 0, sizeof(wctx));
 	wctx.zevpn = zevpn;
 	wctx.uninstall = uninstall;
 	wctx.upd_client = upd_client;
 	wctx.flags = flags;
 
-	hash_iterate(zevpn->neigh_table, zebra_evpn_neigh_del_hash_entry,
-		     &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_neigh_del_hash_entry, &wctx);
 }
 
 /*
@@ -893,7 +874,7 @@ struct zebra_neigh *zebra_evpn_neigh_lookup(struct zebra_evpn *zevpn,
 
 	memset(&tmp, 0, sizeof(tmp));
 	memcpy(&tmp.ip, ip, sizeof(struct ipaddr));
-	n = hash_lookup(zevpn->neigh_table, &tmp);
+	n = zebra_neigh_db_find(&zevpn->neigh_table, &tmp);
 
 	return n;
 }
@@ -1618,12 +1599,10 @@ int zebra_evpn_remote_neigh_update(struct zebra_evpn *zevpn,
 }
 
 /* Notify Neighbor entries to the Client, skips the GW entry */
-static void
-zebra_evpn_send_neigh_hash_entry_to_client(struct hash_bucket *bucket,
-					   void *arg)
+static void zebra_evpn_send_neigh_hash_entry_to_client(struct zebra_neigh *zn,
+						       void *arg)
 {
 	struct mac_walk_ctx *wctx = arg;
-	struct zebra_neigh *zn = bucket->data;
 	struct zebra_mac *zmac = NULL;
 
 	if (CHECK_FLAG(zn->flags, ZEBRA_NEIGH_DEF_GW))
@@ -1649,21 +1628,17 @@ void zebra_evpn_send_neigh_to_client(struct zebra_evpn *zevpn)
 	memset(&wctx, 0, sizeof(wctx));
 	wctx.zevpn = zevpn;
 
-	hash_iterate(zevpn->neigh_table,
-		     zebra_evpn_send_neigh_hash_entry_to_client, &wctx);
+	zebra_evpn_neigh_iterate(zevpn,
+				 zebra_evpn_send_neigh_hash_entry_to_client,
+				 &wctx);
 }
 
-void zebra_evpn_clear_dup_neigh_hash(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_clear_dup_neigh_hash(struct zebra_neigh *nbr, void *ctxt)
 {
 	struct neigh_walk_ctx *wctx = ctxt;
-	struct zebra_neigh *nbr;
 	struct zebra_evpn *zevpn;
 	char buf[INET6_ADDRSTRLEN];
 
-	nbr = (struct zebra_neigh *)bucket->data;
-	if (!nbr)
-		return;
-
 	zevpn = wctx->zevpn;
 
 	if (!CHECK_FLAG(nbr->flags, ZEBRA_NEIGH_DUPLICATE))
@@ -1862,11 +1837,10 @@ static char *zebra_evpn_print_neigh_flags(struct zebra_neigh *n,
 /*
  * Print neighbor hash entry - called for display of all neighbors.
  */
-void zebra_evpn_print_neigh_hash(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_print_neigh_hash(struct zebra_neigh *n, void *ctxt)
 {
 	struct vty *vty;
 	json_object *json_evpn = NULL, *json_row = NULL;
-	struct zebra_neigh *n;
 	char buf1[ETHER_ADDR_STRLEN];
 	char buf2[INET6_ADDRSTRLEN];
 	char addr_buf[PREFIX_STRLEN];
@@ -1876,7 +1850,6 @@ void zebra_evpn_print_neigh_hash(struct hash_bucket *bucket, void *ctxt)
 
 	vty = wctx->vty;
 	json_evpn = wctx->json;
-	n = (struct zebra_neigh *)bucket->data;
 
 	if (json_evpn)
 		json_row = json_object_new_object();
@@ -1971,19 +1944,15 @@ void zebra_evpn_print_neigh_hash(struct hash_bucket *bucket, void *ctxt)
 /*
  * Print neighbor hash entry in detail - called for display of all neighbors.
  */
-void zebra_evpn_print_neigh_hash_detail(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_print_neigh_hash_detail(struct zebra_neigh *n, void *ctxt)
 {
 	struct vty *vty;
 	json_object *json_evpn = NULL, *json_row = NULL;
-	struct zebra_neigh *n;
 	char buf[INET6_ADDRSTRLEN];
 	struct neigh_walk_ctx *wctx = ctxt;
 
 	vty = wctx->vty;
 	json_evpn = wctx->json;
-	n = (struct zebra_neigh *)bucket->data;
-	if (!n)
-		return;
 
 	ipaddr2str(&n->ip, buf, sizeof(buf));
 	if (json_evpn)
@@ -1995,29 +1964,17 @@ void zebra_evpn_print_neigh_hash_detail(struct hash_bucket *bucket, void *ctxt)
 		json_object_object_add(json_evpn, buf, json_row);
 }
 
-void zebra_evpn_print_dad_neigh_hash(struct hash_bucket *bucket, void *ctxt)
+void zebra_evpn_print_dad_neigh_hash(struct zebra_neigh *nbr, void *ctxt)
 {
-	struct zebra_neigh *nbr;
-
-	nbr = (struct zebra_neigh *)bucket->data;
-	if (!nbr)
-		return;
-
 	if (CHECK_FLAG(nbr->flags, ZEBRA_NEIGH_DUPLICATE))
-		zebra_evpn_print_neigh_hash(bucket, ctxt);
+		zebra_evpn_print_neigh_hash(nbr, ctxt);
 }
 
-void zebra_evpn_print_dad_neigh_hash_detail(struct hash_bucket *bucket,
+void zebra_evpn_print_dad_neigh_hash_detail(struct zebra_neigh *nbr,
 					    void *ctxt)
 {
-	struct zebra_neigh *nbr;
-
-	nbr = (struct zebra_neigh *)bucket->data;
-	if (!nbr)
-		return;
-
 	if (CHECK_FLAG(nbr->flags, ZEBRA_NEIGH_DUPLICATE))
-		zebra_evpn_print_neigh_hash_detail(bucket, ctxt);
+		zebra_evpn_print_neigh_hash_detail(nbr, ctxt);
 }
 
 void zebra_evpn_neigh_remote_macip_add(struct zebra_evpn *zevpn,
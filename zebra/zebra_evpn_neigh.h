@@ -9,6 +9,8 @@
 #ifndef _ZEBRA_EVPN_NEIGH_H
 #define _ZEBRA_EVPN_NEIGH_H
 
+#include "jhash.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -36,6 +38,9 @@ struct zebra_neigh {
 	/* IP address. */
 	struct ipaddr ip;
 
+	/* Entry in the EVPN's neighbor table, kept next to the key. */
+	struct zebra_neigh_db_item db_item;
+
 	/* MAC address. */
 	struct ethaddr emac;
 
@@ -104,6 +109,26 @@ struct zebra_neigh {
 	struct thread *hold_timer;
 };
 
+static inline int zebra_neigh_db_cmp(const struct zebra_neigh *n1,
+				     const struct zebra_neigh *n2)
+{
+	return ipaddr_cmp(&n1->ip, &n2->ip);
+}
+
+static inline uint32_t zebra_neigh_db_hash(const struct zebra_neigh *n)
+{
+	const struct ipaddr *ip = &n->ip;
+
+	if (IS_IPADDR_V4(ip))
+		return jhash_1word(ip->ipaddr_v4.s_addr, 0);
+
+	return jhash2(ip->ipaddr_v6.s6_addr32,
+		      array_size(ip->ipaddr_v6.s6_addr32), 0);
+}
+
+DECLARE_HASH(zebra_neigh_db, struct zebra_neigh, db_item, zebra_neigh_db_cmp,
+	     zebra_neigh_db_hash);
+
 /*
  * Context for neighbor hash walk - used by callbacks.
  */
@@ -195,13 +220,16 @@ static inline bool zebra_evpn_neigh_clear_sync_info(struct zebra_neigh *n)
 int remote_neigh_count(struct zebra_mac *zmac);
 
 int neigh_list_cmp(void *p1, void *p2);
-struct hash *zebra_neigh_db_create(const char *desc);
+struct hash *zebra_neigh_hash_create(const char *desc);
 uint32_t num_dup_detected_neighs(struct zebra_evpn *zevpn);
-void zebra_evpn_find_neigh_addr_width(struct hash_bucket *bucket, void *ctxt);
+void zebra_evpn_neigh_iterate(struct zebra_evpn *zevpn,
+			      void (*func)(struct zebra_neigh *n, void *arg),
+			      void *arg);
+void zebra_evpn_find_neigh_addr_width(struct zebra_neigh *n, void *ctxt);
 int remote_neigh_count(struct zebra_mac *zmac);
 int zebra_evpn_rem_neigh_install(struct zebra_evpn *zevpn,
 				 struct zebra_neigh *n, bool was_static);
-void zebra_evpn_install_neigh_hash(struct hash_bucket *bucket, void *ctxt);
+void zebra_evpn_install_neigh_hash(struct zebra_neigh *n, void *ctxt);
 int zebra_evpn_neigh_send_add_to_client(vni_t vni, const struct ipaddr *ip,
 					const struct ethaddr *macaddr,
 					struct zebra_mac *zmac,
@@ -247,15 +275,14 @@ int zebra_evpn_remote_neigh_update(struct zebra_evpn *zevpn,
 				   const struct ethaddr *macaddr,
 				   uint16_t state);
 void zebra_evpn_send_neigh_to_client(struct zebra_evpn *zevpn);
-void zebra_evpn_clear_dup_neigh_hash(struct hash_bucket *bucket, void *ctxt);
+void zebra_evpn_clear_dup_neigh_hash(struct zebra_neigh *n, void *ctxt);
 void zebra_evpn_print_neigh(struct zebra_neigh *n, void *ctxt,
 			    json_object *json);
-void zebra_evpn_print_neigh_hash(struct hash_bucket *bucket, void *ctxt);
+void zebra_evpn_print_neigh_hash(struct zebra_neigh *n, void *ctxt);
 void zebra_evpn_print_neigh_hdr(struct vty *vty, struct neigh_walk_ctx *wctx);
-void zebra_evpn_print_neigh_hash_detail(struct hash_bucket *bucket, void *ctxt);
-void zebra_evpn_print_dad_neigh_hash(struct hash_bucket *bucket, void *ctxt);
-void zebra_evpn_print_dad_neigh_hash_detail(struct hash_bucket *bucket,
-					    void *ctxt);
+void zebra_evpn_print_neigh_hash_detail(struct zebra_neigh *n, void *ctxt);
+void zebra_evpn_print_dad_neigh_hash(struct zebra_neigh *n, void *ctxt);
+void zebra_evpn_print_dad_neigh_hash_detail(struct zebra_neigh *n, void *ctxt);
 void zebra_evpn_neigh_remote_macip_add(struct zebra_evpn *zevpn,
 				       struct zebra_vrf *zvrf,
 				       const struct ipaddr *ipaddr,
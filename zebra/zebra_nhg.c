@@ -427,6 +427,18 @@ struct nhg_hash_entry *zebra_nhe_copy(const struct nhg_hash_entry *orig,
 	return nhe;
 }
 
+struct nhg_hash_entry *zebra_nhe_copy_keyed(const struct nhg_hash_entry *orig)
+{
+	struct nhg_hash_entry *nhe;
+
+	assert(CHECK_FLAG(orig->flags, NEXTHOP_GROUP_KEYED));
+
+	nhe = zebra_nhe_copy(orig, 0);
+	nhe->key = orig->key;
+	SET_FLAG(nhe->flags, NEXTHOP_GROUP_KEYED);
+	return nhe;
+}
+
 /* Allocation via hash handler */
 static void *zebra_nhg_hash_alloc(void *arg)
 {
@@ -463,9 +475,51 @@ static void *zebra_nhg_hash_alloc(void *arg)
 	return nhe;
 }
 
-uint32_t zebra_nhg_hash_key(const void *arg)
+/*
+ * Last few nhes found for each route source, most recently used first.
+ * Daemons tend to send runs of routes with the same nexthops, e.g. the
+ * prefixes of a BGP update, and to go back and forth between a handful of
+ * those, so this finds most of them by their cached key alone.  One set for
+ * the nhes the routes came with and one for the resolved ones.
+ */
+#define NHG_SRC_HINTS 4
+
+struct nhg_src_hint {
+	struct nhg_hash_entry *nhe;
+	uint16_t instance;
+	uint32_t key;
+};
+
+static struct nhg_src_hint nhg_src_hints[ZEBRA_ROUTE_MAX][2][NHG_SRC_HINTS];
+static uint64_t nhg_src_hint_hits, nhg_src_hint_misses;
+
+static void nhg_src_hint_forget(const struct nhg_hash_entry *nhe)
+{
+	unsigned int i, j, k;
+
+	for (i = 0; i < array_size(nhg_src_hints); i++)
+		for (j = 0; j < array_size(nhg_src_hints[i]); j++)
+			for (k = 0; k < NHG_SRC_HINTS; k++)
+				if (nhg_src_hints[i][j][k].nhe == nhe)
+					nhg_src_hints[i][j][k].nhe = NULL;
+}
+
+/* Put 'hint' first in its set, in place of hints[idx] */
+static void nhg_src_hint_use(struct nhg_src_hint *hints, unsigned int idx,
+			     struct nhg_src_hint hint)
+{
+	memmove(&hints[1], &hints[0], idx * sizeof(hints[0]));
+	hints[0] = hint;
+}
+
+void zebra_nhg_src_hint_counts(uint64_t *hits, uint64_t *misses)
+{
+	*hits = nhg_src_hint_hits;
+	*misses = nhg_src_hint_misses;
+}
+
+static uint32_t zebra_nhg_hash_key_compute(const struct nhg_hash_entry *nhe)
 {
-	const struct nhg_hash_entry *nhe = arg;
 	uint32_t key = 0x5a351234;
 	uint32_t primary = 0;
 	uint32_t backup = 0;
@@ -481,6 +535,22 @@ uint32_t zebra_nhg_hash_key(const void *arg)
 	return key;
 }
 
+uint32_t zebra_nhg_hash_key(const void *arg)
+{
+	const struct nhg_hash_entry *nhe = arg;
+
+	if (CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_KEYED))
+		return nhe->key;
+
+	return zebra_nhg_hash_key_compute(nhe);
+}
+
+void zebra_nhe_set_key(struct nhg_hash_entry *nhe)
+{
+	nhe->key = zebra_nhg_hash_key_compute(nhe);
+	SET_FLAG(nhe->flags, NEXTHOP_GROUP_KEYED);
+}
+
 uint32_t zebra_nhg_id_key(const void *arg)
 {
 	const struct nhg_hash_entry *nhe = arg;
@@ -723,6 +793,12 @@ static bool zebra_nhe_find(struct nhg_hash_entry **nhe, /* return value */
 		 */
 		newnhe = hash_get(zrouter.nhgs, lookup, zebra_nhg_hash_alloc);
 		zebra_nhg_insert_id(newnhe);
+
+		/* Keep the key it was hashed with, for the hash_release() */
+		if (CHECK_FLAG(lookup->flags, NEXTHOP_GROUP_KEYED)) {
+			newnhe->key = lookup->key;
+			SET_FLAG(newnhe->flags, NEXTHOP_GROUP_KEYED);
+		}
 	} else {
 		/*
 		 * This is upperproto owned NHG or one we read in from dataplane
@@ -903,6 +979,10 @@ static bool zebra_nhg_find(struct nhg_hash_entry **nhe, uint32_t id,
 		}
 	}
 
+	/* Hash the nexthops once for the lookup and the insertion */
+	if (!id)
+		zebra_nhe_set_key(&lookup);
+
 	created = zebra_nhe_find(nhe, &lookup, nhg_depends, afi, from_dplane);
 
 	return created;
@@ -1108,6 +1188,7 @@ static void zebra_nhg_release(struct nhg_hash_entry *nhe)
 		zlog_debug("%s: nhe %p (%pNG)", __func__, nhe, nhe);
 
 	zebra_nhg_release_all_deps(nhe);
+	nhg_src_hint_forget(nhe);
 
 	/*
 	 * If its not zebra owned, we didn't store it here and have to be
@@ -1532,6 +1613,67 @@ zebra_nhg_rib_find_nhe(struct nhg_hash_entry *rt_nhe, afi_t rt_afi)
 	return nhe;
 }
 
+struct nhg_hash_entry *zebra_nhg_rib_find_nhe_src(struct nhg_hash_entry *rt_nhe,
+						  afi_t rt_afi, int type,
+						  uint16_t instance)
+{
+	struct nhg_src_hint *hints, *hint;
+	struct nhg_hash_entry *nhe;
+	unsigned int i;
+	bool received;
+
+	/* Lookups by id, and anything that may end up outside the nhgs
+	 * hash, go the normal way
+	 */
+	if (!rt_nhe || !rt_nhe->nhg.nexthop || rt_nhe->id || type < 0
+	    || type >= ZEBRA_ROUTE_MAX)
+		return zebra_nhg_rib_find_nhe(rt_nhe, rt_afi);
+
+	/* Routes come with their nhe keyed, see zapi_route_add_prepare();
+	 * resolved ones are hashed here, once for the hints and the lookup.
+	 * Their nexthops don't change anymore by now.
+	 */
+	received = CHECK_FLAG(rt_nhe->flags, NEXTHOP_GROUP_KEYED);
+	if (!received)
+		zebra_nhe_set_key(rt_nhe);
+
+	hints = nhg_src_hints[type][received];
+
+	for (i = 0; i < NHG_SRC_HINTS; i++) {
+		hint = &hints[i];
+		if (!hint->nhe || hint->instance != instance
+		    || hint->key != rt_nhe->key
+		    || !zebra_nhg_hash_equal(hint->nhe, rt_nhe))
+			continue;
+
+		nhe = hint->nhe;
+		if (IS_ZEBRA_DEBUG_NHG_DETAIL)
+			zlog_debug("%s: rt_nhe %p => hint nhe %p (%pNG)",
+				   __func__, rt_nhe, nhe, nhe);
+
+		nhg_src_hint_use(hints, i, *hint);
+		nhg_src_hint_hits++;
+		nhe->uptime = monotime(NULL);
+		return nhe;
+	}
+
+	nhg_src_hint_misses++;
+	nhe = zebra_nhg_rib_find_nhe(rt_nhe, rt_afi);
+	if (nhe) {
+		/* Found in, or added to, zrouter.nhgs */
+		struct nhg_src_hint found = {
+			.nhe = nhe,
+			.instance = instance,
+			.key = rt_nhe->key,
+		};
+
+		/* the least recently used one drops out */
+		nhg_src_hint_use(hints, NHG_SRC_HINTS - 1, found);
+	}
+
+	return nhe;
+}
+
 /*
  * Allocate backup nexthop info object. Typically these are embedded in
  * nhg_hash_entry objects.
@@ -1621,6 +1763,9 @@ void zebra_nhg_free(struct nhg_hash_entry *nhe)
 
 	THREAD_OFF(nhe->timer);
 
+	if (nhe->id)
+		nhg_src_hint_forget(nhe);
+
 	zebra_nhg_free_members(nhe);
 
 	XFREE(MTYPE_NHG, nhe);
@@ -1646,6 +1791,8 @@ void zebra_nhg_hash_free(void *p)
 
 	THREAD_OFF(nhe->timer);
 
+	nhg_src_hint_forget(nhe);
+
 	nexthops_free(nhe->nhg.nexthop);
 
 	XFREE(MTYPE_NHG, nhe);
@@ -2878,13 +3025,20 @@ static uint32_t proto_nhg_nexthop_active_update(struct nexthop_group *nhg)
  */
 int nexthop_active_update(struct route_node *rn, struct route_entry *re)
 {
-	struct nhg_hash_entry *curr_nhe;
-	uint32_t curr_active = 0, backup_active = 0;
+	struct nexthop_active_result res;
 
 	if (PROTO_OWNED(re->nhe))
 		return proto_nhg_nexthop_active_update(&re->nhe->nhg);
 
-	afi_t rt_afi = family2afi(rn->p.family);
+	nexthop_active_resolve(rn, re, &res);
+	return nexthop_active_commit(rn, re, &res);
+}
+
+void nexthop_active_resolve(struct route_node *rn, struct route_entry *re,
+			    struct nexthop_active_result *res)
+{
+	struct nhg_hash_entry *curr_nhe;
+	uint32_t curr_active = 0, backup_active = 0;
 
 	UNSET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
 
@@ -2922,6 +3076,16 @@ int nexthop_active_update(struct route_node *rn, struct route_entry *re)
 			   backup_active);
 
 backups_done:
+	res->curr_nhe = curr_nhe;
+	res->curr_active = curr_active;
+}
+
+int nexthop_active_commit(struct route_node *rn, struct route_entry *re,
+			  struct nexthop_active_result *res)
+{
+	struct nhg_hash_entry *curr_nhe = res->curr_nhe;
+	uint32_t curr_active = res->curr_active;
+	afi_t rt_afi = family2afi(rn->p.family);
 
 	/*
 	 * Ref or create an nhe that matches the current state of the
@@ -2930,7 +3094,8 @@ backups_done:
 	if (CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)) {
 		struct nhg_hash_entry *new_nhe = NULL;
 
-		new_nhe = zebra_nhg_rib_find_nhe(curr_nhe, rt_afi);
+		new_nhe = zebra_nhg_rib_find_nhe_src(curr_nhe, rt_afi, re->type,
+						     re->instance);
 
 		if (IS_ZEBRA_DEBUG_NHG_DETAIL)
 			zlog_debug(
@@ -63,6 +63,9 @@ struct nhg_hash_entry {
 
 	uint32_t flags;
 
+	/* zebra_nhg_hash_key(), if NEXTHOP_GROUP_KEYED is set */
+	uint32_t key;
+
 	/* Dependency trees for other entries.
 	 * For instance a group with two
 	 * nexthops will have two dependencies
@@ -144,6 +147,13 @@ struct nhg_hash_entry {
  * Track FPM installation status..
  */
 #define NEXTHOP_GROUP_FPM (1 << 6)
+
+/*
+ * The hash key has been computed and cached in nhe->key, see
+ * zebra_nhe_set_key().  Only zebra_nhe_copy_keyed() copies it along, and
+ * entries of zrouter.nhgs keep the key of the nhe they were created from.
+ */
+#define NEXTHOP_GROUP_KEYED (1 << 7)
 };
 
 /* Upper 4 bits of the NHG are reserved for indicating the NHG type */
@@ -276,6 +286,17 @@ extern struct nhg_hash_entry *zebra_nhg_lookup_id(uint32_t id);
 
 /* Hash functions */
 extern uint32_t zebra_nhg_hash_key(const void *arg);
+
+/*
+ * Compute the hash key of an nhe once and keep it, so lookups with it don't
+ * hash all of its nexthops again.  Only for nhes whose nexthops don't change
+ * anymore, e.g. a route's nhe as received from a daemon.
+ */
+extern void zebra_nhe_set_key(struct nhg_hash_entry *nhe);
+
+/* Like zebra_nhe_copy(), keeping the key of an nhe keyed as above */
+extern struct nhg_hash_entry *
+zebra_nhe_copy_keyed(const struct nhg_hash_entry *orig);
 extern uint32_t zebra_nhg_id_key(const void *arg);
 
 extern bool zebra_nhg_hash_equal(const void *arg1, const void *arg2);
@@ -307,6 +328,19 @@ extern struct nhg_hash_entry *zebra_nhg_rib_find(uint32_t id,
 struct nhg_hash_entry *
 zebra_nhg_rib_find_nhe(struct nhg_hash_entry *rt_nhe, afi_t rt_afi);
 
+/*
+ * As zebra_nhg_rib_find_nhe(), for a route from the given source.  The last
+ * few nhes found for each source are tried first, which finds the nhe
+ * without a hash lookup when routes keep coming with the same nexthops.
+ * Keys rt_nhe, see zebra_nhe_set_key().
+ */
+struct nhg_hash_entry *zebra_nhg_rib_find_nhe_src(struct nhg_hash_entry *rt_nhe,
+						  afi_t rt_afi, int type,
+						  uint16_t instance);
+
+/* Lookups zebra_nhg_rib_find_nhe_src() answered from the hints, and not */
+extern void zebra_nhg_src_hint_counts(uint64_t *hits, uint64_t *misses);
+
 
 /**
  * Functions for Add/Del/Replace via protocol NHG creation.
@@ -378,6 +412,26 @@ extern void zebra_nhg_mark_keep(void);
 struct route_entry; /* Forward ref to avoid circular includes */
 extern int nexthop_active_update(struct route_node *rn, struct route_entry *re);
 
+/*
+ * nexthop_active_update() in two steps, for resolving many route entries
+ * on worker pthreads.  nexthop_active_resolve() only works on a private
+ * copy of re's nhe and on re itself; it may run concurrently for route
+ * entries whose nexthops all resolve in tables nobody else is looking at
+ * at the same time, and which aren't subject to a protocol route-map.
+ * nexthop_active_commit() puts the result in place and must run on the
+ * main pthread.
+ */
+struct nexthop_active_result {
+	struct nhg_hash_entry *curr_nhe;
+	uint32_t curr_active;
+};
+
+extern void nexthop_active_resolve(struct route_node *rn,
+				   struct route_entry *re,
+				   struct nexthop_active_result *res);
+extern int nexthop_active_commit(struct route_node *rn, struct route_entry *re,
+				 struct nexthop_active_result *res);
+
 #ifdef _FRR_ATTRIBUTE_PRINTFRR
 #pragma FRR printfrr_ext "%pNG" (const struct nhg_hash_entry *)
 #endif
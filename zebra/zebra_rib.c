@@ -21,6 +21,8 @@
 #include "thread.h"
 #include "vrf.h"
 #include "workqueue.h"
+#include "workpool.h"
+#include "monotime.h"
 #include "nexthop_group_private.h"
 #include "frr_pthread.h"
 #include "printfrr.h"
@@ -44,6 +46,7 @@
 #include "zebra/zebra_dplane.h"
 #include "zebra/zebra_evpn_mh.h"
 #include "zebra/zebra_script.h"
+#include "zebra/zebra_rib_snapshot.h"
 
 DEFINE_MGROUP(ZEBRA, "zebra");
 
@@ -51,6 +54,9 @@ DEFINE_MTYPE(ZEBRA, RE,       "Route Entry");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_DEST,       "RIB destination");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_UPDATE_CTX, "Rib update context object");
 DEFINE_MTYPE_STATIC(ZEBRA, WQ_WRAPPER, "WQ wrapper");
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_QUEUE_STATS, "RIB queue statistics");
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_BATCH, "RIB batch");
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_KERNEL_BATCH, "RIB kernel route batch");
 
 /*
  * Event, list, and mutex for delivery of dataplane results
@@ -624,6 +630,51 @@ int zebra_rib_labeled_unicast(struct route_entry *re)
 	return 1;
 }
 
+/*
+ * On a warm start, take over a route that the previous run of zebra left
+ * in the kernel instead of installing it again. This does what the
+ * dataplane result would have done for a successful install.
+ */
+static bool rib_adopt_kernel(struct route_node *rn, struct route_entry *re,
+			     struct route_entry *old)
+{
+	struct rib_table_info *info = srcdest_rnode_table_info(rn);
+	rib_dest_t *dest = rib_dest_from_rnode(rn);
+	struct nexthop *nexthop;
+
+	if (!zebra_rib_snapshot_match(rn, re, old))
+		return false;
+
+	if (old && old != re) {
+		UNSET_FLAG(old->status, ROUTE_ENTRY_INSTALLED);
+		UNSET_FLAG(old->status, ROUTE_ENTRY_USE_FIB_NHG);
+		if (old->fib_ng.nexthop) {
+			nexthops_free(old->fib_ng.nexthop);
+			old->fib_ng.nexthop = NULL;
+		}
+	}
+
+	for (ALL_NEXTHOPS(re->nhe->nhg, nexthop)) {
+		if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_RECURSIVE) ||
+		    !CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_ACTIVE))
+			continue;
+		SET_FLAG(nexthop->flags, NEXTHOP_FLAG_FIB);
+	}
+
+	UNSET_FLAG(re->status, ROUTE_ENTRY_FAILED);
+	SET_FLAG(re->status, ROUTE_ENTRY_INSTALLED);
+	dest->selected_fib = re;
+
+	hook_call(rib_update, rn, "taken over from kernel");
+	redistribute_update(rn, re, old);
+
+	if (zebra_router_notify_on_ack())
+		zsend_route_notify_owner(rn, re, ZAPI_ROUTE_INSTALLED,
+					 info->afi, info->safi);
+
+	return true;
+}
+
 /* Update flag indicates whether this is a "replace" or not. Currently, this
  * is only used for IPv4.
  */
@@ -646,6 +697,8 @@ void rib_install_kernel(struct route_node *rn, struct route_entry *re,
 		return;
 	}
 
+	if (rib_adopt_kernel(rn, re, old))
+		return;
 
 	/*
 	 * Install the resolved nexthop object first.
@@ -785,7 +838,10 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 				    bool rt_delete)
 {
 	rib_dest_t *dest = rib_dest_from_rnode(rn);
+	struct zebra_vrf *zvrf = NULL;
 	struct rnh *rnh;
+	afi_t afi = AFI_UNSPEC;
+	uint32_t evaluated = 0, notified = 0;
 
 	/*
 	 * We are storing the rnh's associated withb
@@ -822,9 +878,8 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 		 * nexthop tracking evaluation code
 		 */
 		frr_each_safe(rnh_list, &dest->nht, rnh) {
-			struct zebra_vrf *zvrf =
-				zebra_vrf_lookup_by_id(rnh->vrf_id);
-			struct prefix *p = &rnh->node->p;
+			zvrf = zebra_vrf_lookup_by_id(rnh->vrf_id);
+			afi = rnh->afi;
 
 			if (IS_ZEBRA_DEBUG_NHT_DETAILED)
 				zlog_debug(
@@ -852,14 +907,20 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq,
 			}
 
 			rnh->seqno = seq;
-			zebra_evaluate_rnh(zvrf, family2afi(p->family), 0, p,
-					   rnh->safi);
+			evaluated++;
+			if (zebra_evaluate_rnh_entry(zvrf, rnh))
+				notified++;
 		}
 
 		rn = rn->parent;
 		if (rn)
 			dest = rib_dest_from_rnode(rn);
 	}
+
+	/* all entries on a table's nodes belong to the same VRF and afi */
+	if (evaluated)
+		zebra_rnh_stats_add(zvrf, afi, RNH_TRIGGER_ROUTE, evaluated,
+				    notified);
 }
 
 /*
@@ -1162,6 +1223,132 @@ static struct route_entry *rib_choose_best(struct route_entry *current,
 }
 
 /* Core function for processing routing information base. */
+/*
+ * Parallel meta-queue processing.
+ *
+ * With more than one RIB worker, meta_queue_process() takes a batch of
+ * route nodes from the head of the highest priority non-empty route
+ * sub-queue, resolves the nexthops of their changed route entries on the
+ * worker pool, and then runs rib_process() on the nodes in queue order on
+ * the main pthread, using the resolved nexthops.
+ *
+ * Nexthop resolution looks up (and locks) route nodes in the tables of the
+ * nexthops' VRF, so the batch is split into one shard per VRF and each
+ * shard is worked on by a single pthread.  Route entries with nexthops in
+ * another VRF, or which are subject to a protocol route-map, are left to
+ * rib_process() as before.
+ *
+ * The whole batch is resolved against the RIB as it was before the batch,
+ * which is what the serial code does when the nodes are queued in another
+ * order.  If a node in the batch is touched again before rib_process() got
+ * to it, its results are dropped and it's resolved in rib_process().
+ */
+#define RIB_BATCH_MAX 256
+
+struct rib_batch_re {
+	/* NULL once the result has been used or released */
+	struct route_entry *re;
+	struct nexthop_active_result res;
+};
+
+struct rib_batch_node {
+	struct route_node *rn;
+	vrf_id_t vrf_id;
+
+	/* results in rib_batch.res */
+	uint32_t first;
+	uint32_t count;
+};
+
+static struct rib_batch {
+	struct rib_batch_node nodes[RIB_BATCH_MAX];
+	uint32_t nnodes;
+
+	struct rib_batch_re *res;
+	uint32_t nres;
+	uint32_t res_size;
+
+	/* nodes with results, sorted by VRF, and where each VRF starts */
+	uint32_t order[RIB_BATCH_MAX];
+	uint32_t shards[RIB_BATCH_MAX + 1];
+	uint32_t nshards;
+
+	/* node rib_process() is working on */
+	struct rib_batch_node *current;
+} rib_batch;
+
+static struct workpool *rib_pool;
+
+/* Release the unused results of a node, restoring the state
+ * rib_process() would have seen without them.
+ */
+static void rib_batch_release(struct rib_batch_node *bn)
+{
+	rib_dest_t *dest = rib_dest_from_rnode(bn->rn);
+	struct rib_batch_re *br;
+	struct route_entry *re;
+	uint32_t i;
+
+	/* Only look at route entries still on the node, others may be gone */
+	RNODE_FOREACH_RE (bn->rn, re) {
+		for (i = 0; i < bn->count; i++) {
+			br = &rib_batch.res[bn->first + i];
+			if (br->re == re)
+				SET_FLAG(re->status, ROUTE_ENTRY_CHANGED);
+		}
+	}
+
+	for (i = 0; i < bn->count; i++) {
+		br = &rib_batch.res[bn->first + i];
+		if (!br->re)
+			continue;
+
+		zebra_nhg_free(br->res.curr_nhe);
+		br->re = NULL;
+	}
+
+	if (dest)
+		UNSET_FLAG(dest->flags, RIB_DEST_PREPARED);
+}
+
+/* Something changed on a node of the running batch */
+static void rib_batch_drop(struct route_node *rn)
+{
+	rib_dest_t *dest = rib_dest_from_rnode(rn);
+	uint32_t i;
+
+	if (!dest || !CHECK_FLAG(dest->flags, RIB_DEST_PREPARED))
+		return;
+
+	for (i = 0; i < rib_batch.nnodes; i++)
+		if (rib_batch.nodes[i].rn == rn) {
+			rib_batch_release(&rib_batch.nodes[i]);
+			break;
+		}
+}
+
+/* Take the batch result for re, if there is one */
+static struct nexthop_active_result *rib_batch_take(struct route_node *rn,
+						    struct route_entry *re)
+{
+	struct rib_batch_node *bn = rib_batch.current;
+	struct rib_batch_re *br;
+	uint32_t i;
+
+	if (!bn || bn->rn != rn
+	    || !CHECK_FLAG(rib_dest_from_rnode(rn)->flags, RIB_DEST_PREPARED))
+		return NULL;
+
+	for (i = 0; i < bn->count; i++) {
+		br = &rib_batch.res[bn->first + i];
+		if (br->re == re) {
+			br->re = NULL;
+			return &br->res;
+		}
+	}
+	return NULL;
+}
+
 static void rib_process(struct route_node *rn)
 {
 	struct route_entry *re;
@@ -1174,6 +1361,7 @@ static void rib_process(struct route_node *rn)
 	rib_dest_t *dest;
 	struct zebra_vrf *zvrf = NULL;
 	struct vrf *vrf;
+	struct nexthop_active_result *res;
 
 	vrf_id_t vrf_id = VRF_UNKNOWN;
 
@@ -1242,8 +1430,10 @@ static void rib_process(struct route_node *rn)
 		 * then we cannot use this particular route entry so
 		 * skip it.
 		 */
-		if (CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)) {
-			if (!nexthop_active_update(rn, re)) {
+		res = rib_batch_take(rn, re);
+		if (res || CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)) {
+			if (!(res ? nexthop_active_commit(rn, re, res)
+				  : nexthop_active_update(rn, re))) {
 				const struct prefix *p;
 				struct rib_table_info *info;
 
@@ -2599,6 +2789,9 @@ static void process_subq_route(struct listnode *lnode, uint8_t qindex)
 
 	rib_process(rnode);
 
+	if (rib_batch.current && rib_batch.current->rn == rnode)
+		rib_batch_release(rib_batch.current);
+
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED) {
 		struct route_entry *re = NULL;
 
@@ -2645,10 +2838,64 @@ struct zebra_early_route {
 	bool startup;
 	bool deletion;
 	bool fromkernel;
+
+	/* Set if this lives in a batch of routes read from the kernel */
+	struct rib_kernel_batch *batch;
 };
 
+/*
+ * Routes read from the kernel are queued in batches: a single allocation
+ * holds the early route wrappers, route entries and nexthops of many routes,
+ * and goes on the meta queue as one item.  Only the routes that are added
+ * to the RIB get a route entry of their own, when they are processed.
+ */
+#define RIB_KERNEL_BATCH_SIZE (128 * 1024)
+
+struct rib_kernel_route {
+	struct zebra_early_route ere;
+	struct route_entry re;
+	struct nhg_hash_entry nhe;
+	unsigned int nh_num;
+	struct nexthop nh[];
+};
+
+struct rib_kernel_batch {
+	/* What is queued; head.batch points back at the batch */
+	struct zebra_early_route head;
+
+	size_t size;
+	size_t used;
+	uint32_t count;
+};
+
+#define RIB_KERNEL_ALIGN(x)                                                    \
+	(((x) + _Alignof(struct rib_kernel_route) - 1)                         \
+	 & ~(_Alignof(struct rib_kernel_route) - 1))
+#define RIB_KERNEL_ROUTE_SIZE(n)                                               \
+	RIB_KERNEL_ALIGN(sizeof(struct rib_kernel_route)                       \
+			 + (n) * sizeof(struct nexthop))
+#define RIB_KERNEL_BATCH_START RIB_KERNEL_ALIGN(sizeof(struct rib_kernel_batch))
+
+#define RIB_KERNEL_BATCH_FOREACH(batch, kr)                                    \
+	for (size_t _off = RIB_KERNEL_BATCH_START;                             \
+	     _off < (batch)->used                                              \
+	     && ((kr) = (void *)((uint8_t *)(batch) + _off));                  \
+	     _off += RIB_KERNEL_ROUTE_SIZE((kr)->nh_num))
+
+/* Batch being filled by the netlink reader, main pthread only */
+static struct rib_kernel_batch *rib_kernel_batch_cur;
+
 static void early_route_memory_free(struct zebra_early_route *ere)
 {
+	/* A batched route only has a route entry of its own while an add is
+	 * being processed; everything else is freed with the batch.
+	 */
+	if (ere->batch) {
+		if (!ere->deletion)
+			XFREE(MTYPE_RE, ere->re);
+		return;
+	}
+
 	if (ere->re_nhe)
 		zebra_nhg_free(ere->re_nhe);
 
@@ -2699,7 +2946,8 @@ static void process_subq_early_route_add(struct zebra_early_route *ere)
 		}
 	} else {
 		/* Lookup nhe from route information */
-		nhe = zebra_nhg_rib_find_nhe(ere->re_nhe, ere->afi);
+		nhe = zebra_nhg_rib_find_nhe_src(ere->re_nhe, ere->afi,
+						 re->type, re->instance);
 		if (!nhe) {
 			char buf2[PREFIX_STRLEN] = "";
 
@@ -2839,6 +3087,9 @@ static void process_subq_early_route_add(struct zebra_early_route *ere)
 	}
 
 	route_unlock_node(rn);
+	if (ere->batch)
+		return;
+
 	if (ere->re_nhe)
 		zebra_nhg_free(ere->re_nhe);
 	XFREE(MTYPE_WQ_WRAPPER, ere);
@@ -3079,28 +3330,160 @@ static void process_subq_early_route_delete(struct zebra_early_route *ere)
  * the nexthop group entries for the route entry is always
  * done after the nexthop group has had a chance to be processed
  */
+static void rib_kernel_batch_free(struct rib_kernel_batch *batch)
+{
+	struct rib_kernel_route *kr;
+	unsigned int i;
+
+	RIB_KERNEL_BATCH_FOREACH (batch, kr) {
+		for (i = 0; i < kr->nh_num; i++) {
+			nexthop_del_labels(&kr->nh[i]);
+			nexthop_del_srv6_seg6local(&kr->nh[i]);
+			nexthop_del_srv6_seg6(&kr->nh[i]);
+		}
+	}
+
+	XFREE(MTYPE_RIB_KERNEL_BATCH, batch);
+}
+
+static void process_subq_early_route_batch(struct rib_kernel_batch *batch)
+{
+	struct rib_kernel_route *kr;
+	struct zebra_early_route *ere;
+	struct nexthop_group ng;
+	unsigned int i;
+
+	RIB_KERNEL_BATCH_FOREACH (batch, kr) {
+		ere = &kr->ere;
+
+		/* Dropped along with its vrf */
+		if (!ere->re)
+			continue;
+
+		if (kr->nh_num) {
+			memset(&ng, 0, sizeof(ng));
+			for (i = 0; i < kr->nh_num; i++)
+				nexthop_group_add_sorted(&ng, &kr->nh[i]);
+
+			zebra_nhe_init(&kr->nhe, ere->afi, ng.nexthop);
+			kr->nhe.nhg.nexthop = ng.nexthop;
+			ere->re_nhe = &kr->nhe;
+		}
+
+		if (ere->deletion)
+			process_subq_early_route_delete(ere);
+		else {
+			ere->re = XMALLOC(MTYPE_RE, sizeof(struct route_entry));
+			*ere->re = kr->re;
+			process_subq_early_route_add(ere);
+		}
+	}
+
+	rib_kernel_batch_free(batch);
+}
+
 static void process_subq_early_route(struct listnode *lnode)
 {
 	struct zebra_early_route *ere = listgetdata(lnode);
 
-	if (ere->deletion)
+	if (ere->batch)
+		process_subq_early_route_batch(ere->batch);
+	else if (ere->deletion)
 		process_subq_early_route_delete(ere);
 	else
 		process_subq_early_route_add(ere);
 }
 
+static int64_t meta_queue_now(void)
+{
+	struct timeval tv;
+
+	monotime(&tv);
+	return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/* Add an item to the tail of a sub-queue */
+static void meta_queue_enqueue(struct meta_queue *mq,
+			       enum meta_queue_indexes qindex, void *data)
+{
+	struct meta_queue_stats *st = &mq->stats[qindex];
+	uint32_t depth, i, size;
+	int64_t *times;
+
+	listnode_add(mq->subq[qindex], data);
+	mq->size++;
+
+	st->enqueued++;
+	depth = listcount(mq->subq[qindex]);
+	if (depth > st->depth_max)
+		st->depth_max = depth;
+
+	if (st->times_count == st->times_size) {
+		size = st->times_size ? st->times_size * 2 : 64;
+		times = XCALLOC(MTYPE_RIB_QUEUE_STATS, size * sizeof(*times));
+		for (i = 0; i < st->times_count; i++)
+			times[i] = st->times[(st->times_head + i)
+					     & (st->times_size - 1)];
+
+		XFREE(MTYPE_RIB_QUEUE_STATS, st->times);
+		st->times = times;
+		st->times_head = 0;
+		st->times_size = size;
+	}
+
+	st->times[(st->times_head + st->times_count) & (st->times_size - 1)] =
+		meta_queue_now();
+	st->times_count++;
+}
+
+/* The head of a sub-queue is being taken off */
+static void meta_queue_stats_dequeue(struct meta_queue *mq,
+				     enum meta_queue_indexes qindex)
+{
+	struct meta_queue_stats *st = &mq->stats[qindex];
+	uint64_t wait;
+
+	st->dequeued++;
+	if (!st->times_count)
+		return;
+
+	wait = meta_queue_now() - st->times[st->times_head];
+	st->times_head = (st->times_head + 1) & (st->times_size - 1);
+	st->times_count--;
+
+	st->wait_total += wait;
+	if (wait > st->wait_max)
+		st->wait_max = wait;
+}
+
+/* Items were removed from the middle of a sub-queue.  Which ones isn't
+ * known here, so drop the newest enqueue times; the wait times are only
+ * approximate after that.
+ */
+static void meta_queue_stats_drop(struct meta_queue *mq,
+				  enum meta_queue_indexes qindex,
+				  uint32_t count)
+{
+	struct meta_queue_stats *st = &mq->stats[qindex];
+
+	st->times_count -= MIN(count, st->times_count);
+}
+
 /*
  * Examine the specified subqueue; process one entry and return 1 if
  * there is a node, return 0 otherwise.
  */
-static unsigned int process_subq(struct list *subq,
+static unsigned int process_subq(struct meta_queue *mq,
 				 enum meta_queue_indexes qindex)
 {
+	struct list *subq = mq->subq[qindex];
 	struct listnode *lnode = listhead(subq);
 
 	if (!lnode)
 		return 0;
 
+	meta_queue_stats_dequeue(mq, qindex);
+
 	switch (qindex) {
 	case META_QUEUE_EVPN:
 		process_subq_evpn(lnode);
@@ -3129,6 +3512,255 @@ static unsigned int process_subq(struct list *subq,
 	return 1;
 }
 
+/* Can route entry re of a node in zvrf be resolved on a worker? */
+static bool rib_batch_re_eligible(struct route_entry *re,
+				  struct zebra_vrf *zvrf)
+{
+	struct nexthop_group *nhg;
+	struct nexthop *nexthop;
+	afi_t afi;
+
+	if (!CHECK_FLAG(re->status, ROUTE_ENTRY_CHANGED)
+	    || CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED)
+	    || PROTO_OWNED(re->nhe) || re->vrf_id != zvrf_id(zvrf))
+		return false;
+
+	/* route_map_apply() isn't thread-safe */
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++)
+		if (PROTO_RM_NAME(zvrf, afi, re->type)
+		    || PROTO_RM_NAME(zvrf, afi, ZEBRA_ROUTE_MAX))
+			return false;
+
+	for (nexthop = re->nhe->nhg.nexthop; nexthop; nexthop = nexthop->next)
+		if (nexthop->vrf_id != re->vrf_id)
+			return false;
+
+	nhg = zebra_nhg_get_backup_nhg(re->nhe);
+	if (nhg)
+		for (nexthop = nhg->nexthop; nexthop; nexthop = nexthop->next)
+			if (nexthop->vrf_id != re->vrf_id)
+				return false;
+
+	return true;
+}
+
+static int rib_batch_cmp(const void *a, const void *b)
+{
+	const uint32_t *ia = a, *ib = b;
+	vrf_id_t va = rib_batch.nodes[*ia].vrf_id;
+	vrf_id_t vb = rib_batch.nodes[*ib].vrf_id;
+
+	if (va != vb)
+		return va < vb ? -1 : 1;
+	return *ia < *ib ? -1 : *ia > *ib;
+}
+
+/* Collect up to max nodes from the head of subq and their route entries
+ * that can be resolved on a worker.  Returns the number of shards.
+ */
+static uint32_t rib_batch_build(struct list *subq, uint32_t max)
+{
+	struct rib_batch_node *bn;
+	struct route_entry *re;
+	struct listnode *node;
+	struct route_node *rn;
+	rib_dest_t *dest;
+	struct zebra_vrf *zvrf;
+	uint32_t i, norder = 0;
+
+	rib_batch.nnodes = 0;
+	rib_batch.nres = 0;
+	rib_batch.nshards = 0;
+
+	for (ALL_LIST_ELEMENTS_RO(subq, node, rn)) {
+		if (rib_batch.nnodes == max)
+			break;
+
+		bn = &rib_batch.nodes[rib_batch.nnodes++];
+		bn->rn = rn;
+		bn->vrf_id = VRF_UNKNOWN;
+		bn->first = rib_batch.nres;
+		bn->count = 0;
+
+		dest = rib_dest_from_rnode(rn);
+		if (!dest)
+			continue;
+
+		zvrf = rib_dest_vrf(dest);
+		bn->vrf_id = zvrf_id(zvrf);
+
+		RNODE_FOREACH_RE (rn, re) {
+			if (!rib_batch_re_eligible(re, zvrf))
+				continue;
+
+			if (rib_batch.nres == rib_batch.res_size) {
+				rib_batch.res_size = rib_batch.res_size
+							     ? rib_batch.res_size * 2
+							     : RIB_BATCH_MAX;
+				rib_batch.res = XREALLOC(
+					MTYPE_RIB_BATCH, rib_batch.res,
+					rib_batch.res_size
+						* sizeof(*rib_batch.res));
+			}
+			rib_batch.res[rib_batch.nres++].re = re;
+			bn->count++;
+		}
+
+		if (bn->count)
+			rib_batch.order[norder++] = rib_batch.nnodes - 1;
+	}
+
+	qsort(rib_batch.order, norder, sizeof(rib_batch.order[0]),
+	      rib_batch_cmp);
+
+	for (i = 0; i < norder; i++)
+		if (i == 0
+		    || rib_batch.nodes[rib_batch.order[i]].vrf_id
+			       != rib_batch.nodes[rib_batch.order[i - 1]].vrf_id)
+			rib_batch.shards[rib_batch.nshards++] = i;
+	rib_batch.shards[rib_batch.nshards] = norder;
+
+	return rib_batch.nshards;
+}
+
+/* Worker: resolve the nexthops of one VRF's nodes */
+static void rib_batch_resolve(void *arg, size_t shard)
+{
+	struct rib_batch_node *bn;
+	struct rib_batch_re *br;
+	uint32_t i, j;
+
+	for (i = rib_batch.shards[shard]; i < rib_batch.shards[shard + 1];
+	     i++) {
+		bn = &rib_batch.nodes[rib_batch.order[i]];
+
+		for (j = 0; j < bn->count; j++) {
+			br = &rib_batch.res[bn->first + j];
+			nexthop_active_resolve(bn->rn, br->re, &br->res);
+		}
+	}
+}
+
+static bool rib_batch_wanted(struct meta_queue *mq,
+			     enum meta_queue_indexes qindex)
+{
+	if (!rib_pool || workpool_get_workers(rib_pool) < 2)
+		return false;
+
+	switch (qindex) {
+	case META_QUEUE_NHG:
+	case META_QUEUE_EVPN:
+	case META_QUEUE_EARLY_ROUTE:
+	case META_QUEUE_EARLY_LABEL:
+		return false;
+	case META_QUEUE_CONNECTED:
+	case META_QUEUE_KERNEL:
+	case META_QUEUE_STATIC:
+	case META_QUEUE_NOTBGP:
+	case META_QUEUE_BGP:
+	case META_QUEUE_OTHER:
+		break;
+	}
+
+	return listcount(mq->subq[qindex]) > 1;
+}
+
+/* Anything queued with a higher priority than qindex? */
+static bool meta_queue_higher_pending(struct meta_queue *mq,
+				      enum meta_queue_indexes qindex)
+{
+	unsigned int i;
+
+	for (i = 0; i < qindex; i++)
+		if (listcount(mq->subq[i]))
+			return true;
+	return false;
+}
+
+/* Process a batch of route nodes from sub-queue qindex, see the comment
+ * above rib_process().  Returns the number of nodes taken off the queue.
+ */
+static unsigned int rib_batch_process(struct meta_queue *mq,
+				      enum meta_queue_indexes qindex,
+				      uint32_t room)
+{
+	struct list *subq = mq->subq[qindex];
+	struct rib_batch_node *bn;
+	uint32_t i, max;
+
+	max = MIN(MAX(room, 1), RIB_BATCH_MAX);
+
+	/* Not worth it within a single VRF */
+	if (rib_batch_build(subq, max) < 2) {
+		rib_batch.nnodes = 0;
+		return process_subq(mq, qindex);
+	}
+
+	workpool_run(rib_pool, rib_batch_resolve, NULL, rib_batch.nshards);
+
+	for (i = 0; i < rib_batch.nnodes; i++) {
+		bn = &rib_batch.nodes[i];
+		if (bn->count)
+			SET_FLAG(rib_dest_from_rnode(bn->rn)->flags,
+				 RIB_DEST_PREPARED);
+	}
+
+	for (i = 0; i < rib_batch.nnodes; i++) {
+		bn = &rib_batch.nodes[i];
+
+		/* Keep to the priority order, and to the queue */
+		if (i && (meta_queue_higher_pending(mq, qindex)
+			  || listnode_head(subq) != bn->rn))
+			break;
+
+		rib_batch.current = bn;
+		process_subq(mq, qindex);
+		rib_batch.current = NULL;
+	}
+
+	max = i;
+	for (; i < rib_batch.nnodes; i++)
+		rib_batch_release(&rib_batch.nodes[i]);
+	rib_batch.nnodes = 0;
+
+	return max;
+}
+
+void zebra_rib_set_workers(unsigned int workers)
+{
+	if (!rib_pool)
+		rib_pool = workpool_new("RIB worker", "zebra_rib");
+	workpool_set_workers(rib_pool, workers);
+}
+
+unsigned int zebra_rib_get_workers(void)
+{
+	return rib_pool ? workpool_get_workers(rib_pool) : 1;
+}
+
+void zebra_rib_queue_show(struct vty *vty)
+{
+	struct meta_queue *mq = zrouter.mq;
+	struct meta_queue_stats *st;
+	unsigned int i;
+
+	vty_out(vty, "RIB workers: %u\n", zebra_rib_get_workers());
+	vty_out(vty, "%-31s %8s %8s %12s %12s %12s %12s\n", "Sub-queue",
+		"Depth", "Max", "Enqueued", "Dequeued", "Avg wait(us)",
+		"Max wait(us)");
+
+	for (i = 0; i < MQ_SIZE; i++) {
+		st = &mq->stats[i];
+		vty_out(vty,
+			"%-31s %8u %8u %12" PRIu64 " %12" PRIu64 " %12" PRIu64
+			" %12" PRIu64 "\n",
+			subqueue2str(i), listcount(mq->subq[i]), st->depth_max,
+			st->enqueued, st->dequeued,
+			st->dequeued ? st->wait_total / st->dequeued : 0,
+			st->wait_max);
+	}
+}
+
 /* Dispatch the meta queue by picking and processing the next node from
  * a non-empty sub-queue with lowest priority. wq is equal to zebra->ribq and
  * data is pointed to the meta queue structure.
@@ -3155,11 +3787,17 @@ static wq_item_status meta_queue_process(struct work_queue *dummy, void *data)
 		return WQ_QUEUE_BLOCKED;
 	}
 
-	for (i = 0; i < MQ_SIZE; i++)
-		if (process_subq(mq->subq[i], i)) {
+	for (i = 0; i < MQ_SIZE; i++) {
+		if (rib_batch_wanted(mq, i)) {
+			mq->size -= rib_batch_process(mq, i,
+						      queue_limit - queue_len);
+			break;
+		}
+		if (process_subq(mq, i)) {
 			mq->size--;
 			break;
 		}
+	}
 	return mq->size ? WQ_REQUEUE : WQ_SUCCESS;
 }
 
@@ -3191,6 +3829,9 @@ static int rib_meta_queue_add(struct meta_queue *mq, void *data)
 
 	rn = (struct route_node *)data;
 
+	/* Queued again while part of a running batch */
+	rib_batch_drop(rn);
+
 	RNODE_FOREACH_RE (rn, curr_re) {
 		curr_qindex = route_info[curr_re->type].meta_q_map;
 
@@ -3214,9 +3855,8 @@ static int rib_meta_queue_add(struct meta_queue *mq, void *data)
 	}
 
 	SET_FLAG(rib_dest_from_rnode(rn)->flags, RIB_ROUTE_QUEUED(qindex));
-	listnode_add(mq->subq[qindex], rn);
+	meta_queue_enqueue(mq, qindex, rn);
 	route_lock_node(rn);
-	mq->size++;
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		rnode_debug(rn, re->vrf_id, "queued rn %p into sub-queue %s",
@@ -3227,8 +3867,7 @@ static int rib_meta_queue_add(struct meta_queue *mq, void *data)
 
 static int early_label_meta_queue_add(struct meta_queue *mq, void *data)
 {
-	listnode_add(mq->subq[META_QUEUE_EARLY_LABEL], data);
-	mq->size++;
+	meta_queue_enqueue(mq, META_QUEUE_EARLY_LABEL, data);
 	return 0;
 }
 
@@ -3248,8 +3887,7 @@ static int rib_meta_queue_nhg_ctx_add(struct meta_queue *mq, void *data)
 	w->type = WQ_NHG_WRAPPER_TYPE_CTX;
 	w->u.ctx = ctx;
 
-	listnode_add(mq->subq[qindex], w);
-	mq->size++;
+	meta_queue_enqueue(mq, qindex, w);
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		zlog_debug("NHG Context id=%u queued into sub-queue %s",
@@ -3274,8 +3912,7 @@ static int rib_meta_queue_nhg_add(struct meta_queue *mq, void *data)
 	w->type = WQ_NHG_WRAPPER_TYPE_NHG;
 	w->u.nhe = nhe;
 
-	listnode_add(mq->subq[qindex], w);
-	mq->size++;
+	meta_queue_enqueue(mq, qindex, w);
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		zlog_debug("NHG id=%u queued into sub-queue %s", nhe->id,
@@ -3286,8 +3923,7 @@ static int rib_meta_queue_nhg_add(struct meta_queue *mq, void *data)
 
 static int rib_meta_queue_evpn_add(struct meta_queue *mq, void *data)
 {
-	listnode_add(mq->subq[META_QUEUE_EVPN], data);
-	mq->size++;
+	meta_queue_enqueue(mq, META_QUEUE_EVPN, data);
 
 	return 0;
 }
@@ -3710,6 +4346,18 @@ static void rib_meta_queue_free(struct meta_queue *mq, struct list *l,
 	}
 }
 
+/* Forget the routes of a batch that belong to 'zvrf' */
+static void rib_kernel_batch_drop_vrf(struct rib_kernel_batch *batch,
+				      struct zebra_vrf *zvrf)
+{
+	struct rib_kernel_route *kr;
+
+	RIB_KERNEL_BATCH_FOREACH (batch, kr) {
+		if (kr->ere.re && kr->re.vrf_id == zvrf->vrf->vrf_id)
+			kr->ere.re = NULL;
+	}
+}
+
 static void early_route_meta_queue_free(struct meta_queue *mq, struct list *l,
 					struct zebra_vrf *zvrf)
 {
@@ -3717,6 +4365,19 @@ static void early_route_meta_queue_free(struct meta_queue *mq, struct list *l,
 	struct listnode *node, *nnode;
 
 	for (ALL_LIST_ELEMENTS(l, node, nnode, ere)) {
+		if (ere->batch) {
+			if (zvrf) {
+				rib_kernel_batch_drop_vrf(ere->batch, zvrf);
+				continue;
+			}
+
+			rib_kernel_batch_free(ere->batch);
+			node->data = NULL;
+			list_delete_node(l, node);
+			mq->size--;
+			continue;
+		}
+
 		if (zvrf && ere->re->vrf_id != zvrf->vrf->vrf_id)
 			continue;
 
@@ -3730,8 +4391,11 @@ static void early_route_meta_queue_free(struct meta_queue *mq, struct list *l,
 void meta_queue_free(struct meta_queue *mq, struct zebra_vrf *zvrf)
 {
 	enum meta_queue_indexes i;
+	uint32_t count;
 
 	for (i = 0; i < MQ_SIZE; i++) {
+		count = listcount(mq->subq[i]);
+
 		/* Some subqueues may need cleanup - nhgs for example */
 		switch (i) {
 		case META_QUEUE_NHG:
@@ -3755,12 +4419,18 @@ void meta_queue_free(struct meta_queue *mq, struct zebra_vrf *zvrf)
 			rib_meta_queue_free(mq, mq->subq[i], zvrf);
 			break;
 		}
-		if (!zvrf)
+		meta_queue_stats_drop(mq, i, count - listcount(mq->subq[i]));
+		if (!zvrf) {
 			list_delete(&mq->subq[i]);
+			XFREE(MTYPE_RIB_QUEUE_STATS, mq->stats[i].times);
+		}
 	}
 
-	if (!zvrf)
+	if (!zvrf) {
 		XFREE(MTYPE_WORK_QUEUE, mq);
+		XFREE(MTYPE_RIB_BATCH, rib_batch.res);
+		workpool_free(&rib_pool);
+	}
 }
 
 /* initialise zebra rib work queue */
@@ -3909,6 +4579,8 @@ void rib_unlink(struct route_node *rn, struct route_entry *re)
 		rnode_debug(rn, re->vrf_id, "rn %p, re %p", (void *)rn,
 			    (void *)re);
 
+	rib_batch_drop(rn);
+
 	dest = rib_dest_from_rnode(rn);
 
 	re_list_del(&dest->routes, re);
@@ -4098,8 +4770,10 @@ static int rib_meta_queue_early_route_add(struct meta_queue *mq, void *data)
 {
 	struct zebra_early_route *ere = data;
 
-	listnode_add(mq->subq[META_QUEUE_EARLY_ROUTE], data);
-	mq->size++;
+	/* Keep the order in which the routes were read */
+	rib_kernel_batch_flush();
+
+	meta_queue_enqueue(mq, META_QUEUE_EARLY_ROUTE, data);
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		zlog_debug(
@@ -4110,16 +4784,97 @@ static int rib_meta_queue_early_route_add(struct meta_queue *mq, void *data)
 	return 0;
 }
 
-struct route_entry *zebra_rib_route_entry_new(vrf_id_t vrf_id, int type,
-					      uint8_t instance, uint32_t flags,
-					      uint32_t nhe_id,
-					      uint32_t table_id,
-					      uint32_t metric, uint32_t mtu,
-					      uint8_t distance, route_tag_t tag)
+static int rib_meta_queue_kernel_batch_add(struct meta_queue *mq, void *data)
 {
-	struct route_entry *re;
+	struct zebra_early_route *head = data;
 
-	re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
+	meta_queue_enqueue(mq, META_QUEUE_EARLY_ROUTE, data);
+
+	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
+		zlog_debug("%u kernel routes queued for processing into sub-queue %s",
+			   head->batch->count,
+			   subqueue2str(META_QUEUE_EARLY_ROUTE));
+
+	return 0;
+}
+
+void rib_kernel_batch_flush(void)
+{
+	struct rib_kernel_batch *batch = rib_kernel_batch_cur;
+
+	if (!batch)
+		return;
+
+	rib_kernel_batch_cur = NULL;
+	if (mq_add_handler(&batch->head, rib_meta_queue_kernel_batch_add) < 0)
+		rib_kernel_batch_free(batch);
+}
+
+void rib_kernel_batch_add(afi_t afi, struct prefix *p,
+			  struct prefix_ipv6 *src_p,
+			  const struct route_entry *re,
+			  const struct nexthop *nh, unsigned int nh_num,
+			  bool startup, bool deletion)
+{
+	struct rib_kernel_batch *batch = rib_kernel_batch_cur;
+	size_t size = RIB_KERNEL_ROUTE_SIZE(nh_num);
+	struct rib_kernel_route *kr;
+	struct zebra_early_route *ere;
+	unsigned int i;
+
+	assert(!src_p || !src_p->prefixlen || afi == AFI_IP6);
+
+	if (batch && batch->used + size > batch->size) {
+		rib_kernel_batch_flush();
+		batch = NULL;
+	}
+
+	if (!batch) {
+		size_t bsize = MAX(RIB_KERNEL_BATCH_SIZE,
+				   RIB_KERNEL_BATCH_START + size);
+
+		batch = XMALLOC(MTYPE_RIB_KERNEL_BATCH, bsize);
+		memset(&batch->head, 0, sizeof(batch->head));
+		batch->head.batch = batch;
+		batch->size = bsize;
+		batch->used = RIB_KERNEL_BATCH_START;
+		batch->count = 0;
+		rib_kernel_batch_cur = batch;
+	}
+
+	kr = (struct rib_kernel_route *)((uint8_t *)batch + batch->used);
+	batch->used += size;
+	batch->count++;
+
+	kr->re = *re;
+	kr->nh_num = nh_num;
+	for (i = 0; i < nh_num; i++) {
+		kr->nh[i] = nh[i];
+		kr->nh[i].next = kr->nh[i].prev = NULL;
+	}
+
+	ere = &kr->ere;
+	memset(ere, 0, sizeof(*ere));
+	ere->afi = afi;
+	ere->safi = SAFI_UNICAST;
+	ere->p = *p;
+	if (src_p)
+		ere->src_p = *src_p;
+	ere->src_p_provided = !!src_p;
+	ere->re = &kr->re;
+	ere->startup = startup;
+	ere->deletion = deletion;
+	ere->fromkernel = true;
+	ere->batch = batch;
+}
+
+void zebra_rib_route_entry_init(struct route_entry *re, vrf_id_t vrf_id,
+				int type, uint8_t instance, uint32_t flags,
+				uint32_t nhe_id, uint32_t table_id,
+				uint32_t metric, uint32_t mtu,
+				uint8_t distance, route_tag_t tag)
+{
+	memset(re, 0, sizeof(*re));
 	re->type = type;
 	re->instance = instance;
 	re->distance = distance;
@@ -4131,6 +4886,20 @@ struct route_entry *zebra_rib_route_entry_new(vrf_id_t vrf_id, int type,
 	re->uptime = monotime(NULL);
 	re->tag = tag;
 	re->nhe_id = nhe_id;
+}
+
+struct route_entry *zebra_rib_route_entry_new(vrf_id_t vrf_id, int type,
+					      uint8_t instance, uint32_t flags,
+					      uint32_t nhe_id,
+					      uint32_t table_id,
+					      uint32_t metric, uint32_t mtu,
+					      uint8_t distance, route_tag_t tag)
+{
+	struct route_entry *re;
+
+	re = XMALLOC(MTYPE_RE, sizeof(struct route_entry));
+	zebra_rib_route_entry_init(re, vrf_id, type, instance, flags, nhe_id,
+				   table_id, metric, mtu, distance, tag);
 
 	return re;
 }
@@ -4509,6 +5278,9 @@ void rib_sweep_route(struct thread *t)
 
 	zebra_router_sweep_route();
 	zebra_router_sweep_nhgs();
+
+	/* Nothing left from the previous run to take over */
+	zebra_rib_snapshot_release();
 }
 
 /* Remove specific by protocol routes from 'table'. */
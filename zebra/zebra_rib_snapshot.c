@@ -0,0 +1,668 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Zebra RIB snapshot, used to speed up warm restarts.
+ */
+
+#include <zebra.h>
+#include <sys/mman.h>
+
+#include "lib/hash.h"
+#include "lib/jhash.h"
+#include "lib/lib_errors.h"
+#include "lib/memory.h"
+#include "lib/nexthop.h"
+#include "lib/prefix.h"
+#include "lib/srcdest_table.h"
+#include "lib/table.h"
+#include "lib/vty.h"
+
+#include "zebra/zebra_router.h"
+#include "zebra/debug.h"
+#include "zebra/rib.h"
+#include "zebra/rt.h"
+#include "zebra/zebra_dplane.h"
+#include "zebra/zebra_nhg.h"
+#include "zebra/zebra_rib_snapshot.h"
+
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_SNAPSHOT, "RIB snapshot");
+
+/*
+ * On-disk layout: a header, 'nroutes' route records, then 'nnexthops'
+ * nexthop records. Each route owns the nh_num nexthops starting at
+ * nh_offset. The file is only ever read back by zebra on the same host,
+ * so everything is in host byte order; a foreign file fails the magic
+ * check.
+ */
+#define RIB_SNAPSHOT_MAGIC 0x5a52534e /* "ZRSN" */
+#define RIB_SNAPSHOT_VERSION 1
+
+struct rib_snapshot_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdrlen;
+	uint32_t nroutes;
+	uint32_t nnexthops;
+	uint64_t length;
+	uint32_t checksum;
+	uint32_t reserved;
+};
+
+struct rib_snapshot_route {
+	uint32_t vrf_id;
+	uint32_t table_id;
+	uint32_t metric;
+	uint32_t nh_offset;
+	uint16_t instance;
+	uint16_t nh_num;
+	uint8_t afi;
+	uint8_t type;
+	uint8_t distance;
+	uint8_t family;
+	uint8_t prefixlen;
+	uint8_t pad[3];
+	uint8_t addr[16];
+};
+
+/* Nexthops are stored the way the kernel reports them back */
+enum rib_snapshot_nh_kind {
+	RIB_SNAPSHOT_NH_IFINDEX = 1,
+	RIB_SNAPSHOT_NH_IPV4,
+	RIB_SNAPSHOT_NH_IPV6,
+	RIB_SNAPSHOT_NH_BLACKHOLE,
+};
+
+struct rib_snapshot_nexthop {
+	uint32_t vrf_id;
+	uint32_t ifindex;
+	uint16_t weight;
+	uint8_t kind;
+	uint8_t bh_type;
+	uint8_t gate[16];
+};
+
+_Static_assert(sizeof(struct rib_snapshot_hdr) == 32,
+	       "RIB snapshot header layout changed");
+_Static_assert(sizeof(struct rib_snapshot_route) == 44,
+	       "RIB snapshot route layout changed");
+_Static_assert(sizeof(struct rib_snapshot_nexthop) == 28,
+	       "RIB snapshot nexthop layout changed");
+
+/* Records collected while writing a snapshot */
+struct rib_snapshot_buf {
+	struct rib_snapshot_route *routes;
+	uint32_t nroutes, routes_size;
+
+	struct rib_snapshot_nexthop *nexthops;
+	uint32_t nnexthops, nexthops_size;
+};
+
+static struct rib_snapshot {
+	/* Default file, from the command line */
+	const char *path;
+
+	/* Mapped snapshot from the previous run, and its index */
+	void *map;
+	size_t maplen;
+	const struct rib_snapshot_route *routes;
+	const struct rib_snapshot_nexthop *nexthops;
+	uint32_t nroutes;
+	struct hash *index;
+
+	/* Counters */
+	uint32_t loaded;
+	uint32_t saved;
+	uint64_t adopted;
+	uint64_t mismatched;
+} snap;
+
+void zebra_rib_snapshot_set_path(const char *path)
+{
+	snap.path = path;
+}
+
+const char *zebra_rib_snapshot_get_path(void)
+{
+	return snap.path;
+}
+
+static bool rib_snapshot_nh_eligible(const struct nexthop *nh)
+{
+	return !CHECK_FLAG(nh->flags, NEXTHOP_FLAG_RECURSIVE) &&
+	       CHECK_FLAG(nh->flags, NEXTHOP_FLAG_ACTIVE) &&
+	       !CHECK_FLAG(nh->flags, NEXTHOP_FLAG_DUPLICATE);
+}
+
+/* Labels and SRv6 aren't recorded; such routes are always installed */
+static bool rib_snapshot_nh_supported(const struct nexthop *nh)
+{
+	if (nh->nh_label && nh->nh_label->num_labels)
+		return false;
+	if (nh->nh_srv6)
+		return false;
+
+	return true;
+}
+
+static void rib_snapshot_nh_encode(struct rib_snapshot_nexthop *rnh,
+				   const struct nexthop *nh)
+{
+	memset(rnh, 0, sizeof(*rnh));
+	rnh->vrf_id = nh->vrf_id;
+	rnh->weight = nh->weight;
+
+	switch (nh->type) {
+	case NEXTHOP_TYPE_IFINDEX:
+		rnh->kind = RIB_SNAPSHOT_NH_IFINDEX;
+		rnh->ifindex = nh->ifindex;
+		break;
+	case NEXTHOP_TYPE_IPV4:
+	case NEXTHOP_TYPE_IPV4_IFINDEX:
+		rnh->kind = RIB_SNAPSHOT_NH_IPV4;
+		rnh->ifindex = nh->ifindex;
+		memcpy(rnh->gate, &nh->gate.ipv4, sizeof(nh->gate.ipv4));
+		break;
+	case NEXTHOP_TYPE_IPV6:
+	case NEXTHOP_TYPE_IPV6_IFINDEX:
+		rnh->kind = RIB_SNAPSHOT_NH_IPV6;
+		rnh->ifindex = nh->ifindex;
+		memcpy(rnh->gate, &nh->gate.ipv6, sizeof(nh->gate.ipv6));
+		break;
+	case NEXTHOP_TYPE_BLACKHOLE:
+		rnh->kind = RIB_SNAPSHOT_NH_BLACKHOLE;
+		rnh->bh_type = nh->bh_type;
+		break;
+	}
+}
+
+/*
+ * Compare the installable nexthops of 'nhg' with those recorded for 'rr'.
+ * The kernel doesn't hand back the weight of a single path, so it is only
+ * compared when 'weight' is set.
+ */
+static bool rib_snapshot_nhg_match(const struct rib_snapshot_route *rr,
+				   struct nexthop_group *nhg, bool weight)
+{
+	const struct rib_snapshot_nexthop *rnh = &snap.nexthops[rr->nh_offset];
+	struct rib_snapshot_nexthop cur;
+	struct nexthop *nh;
+	unsigned int i = 0;
+
+	for (ALL_NEXTHOPS_PTR(nhg, nh)) {
+		if (!rib_snapshot_nh_eligible(nh))
+			continue;
+		if (!rib_snapshot_nh_supported(nh) || i >= rr->nh_num)
+			return false;
+
+		rib_snapshot_nh_encode(&cur, nh);
+		if (!weight)
+			cur.weight = rnh[i].weight;
+		if (memcmp(&cur, &rnh[i], sizeof(cur)))
+			return false;
+		i++;
+	}
+
+	return i > 0 && i == rr->nh_num;
+}
+
+static unsigned int rib_snapshot_route_key(const void *arg)
+{
+	const struct rib_snapshot_route *rr = arg;
+	uint32_t key;
+
+	key = jhash_3words(rr->vrf_id, rr->table_id,
+			   (rr->afi << 16) | (rr->family << 8) | rr->prefixlen,
+			   0xa5d1c0de);
+
+	return jhash(rr->addr, sizeof(rr->addr), key);
+}
+
+static bool rib_snapshot_route_cmp(const void *a, const void *b)
+{
+	const struct rib_snapshot_route *rr1 = a, *rr2 = b;
+
+	return rr1->vrf_id == rr2->vrf_id && rr1->table_id == rr2->table_id &&
+	       rr1->afi == rr2->afi && rr1->family == rr2->family &&
+	       rr1->prefixlen == rr2->prefixlen &&
+	       !memcmp(rr1->addr, rr2->addr, sizeof(rr1->addr));
+}
+
+static void rib_snapshot_route_set_key(struct rib_snapshot_route *rr,
+				       vrf_id_t vrf_id,
+				       const struct rib_table_info *info,
+				       const struct prefix *p)
+{
+	memset(rr, 0, sizeof(*rr));
+	rr->vrf_id = vrf_id;
+	rr->table_id = info->table_id;
+	rr->afi = info->afi;
+	rr->family = p->family;
+	rr->prefixlen = p->prefixlen;
+	memcpy(rr->addr, &p->u.prefix, prefix_blen(p));
+}
+
+/*
+ * Writing
+ */
+static bool rib_snapshot_re_eligible(struct route_entry *re)
+{
+	struct nexthop_group *nhg;
+
+	if (RIB_SYSTEM_ROUTE(re))
+		return false;
+
+	/* Only what is known to be in the kernel, exactly as intended */
+	if (!CHECK_FLAG(re->status, ROUTE_ENTRY_INSTALLED) ||
+	    CHECK_FLAG(re->status, ROUTE_ENTRY_QUEUED) ||
+	    CHECK_FLAG(re->status, ROUTE_ENTRY_FAILED) ||
+	    CHECK_FLAG(re->status, ROUTE_ENTRY_USE_FIB_NHG))
+		return false;
+
+	nhg = zebra_nhg_get_backup_nhg(re->nhe);
+	if (nhg && nhg->nexthop)
+		return false;
+
+	return true;
+}
+
+static void rib_snapshot_add(struct rib_snapshot_buf *buf,
+			     struct route_node *rn, struct route_entry *re)
+{
+	struct rib_table_info *info = srcdest_rnode_table_info(rn);
+	struct rib_snapshot_route *rr;
+	const struct prefix *p, *src_p;
+	struct nexthop *nh;
+
+	srcdest_rnode_prefixes(rn, &p, &src_p);
+	if (src_p && src_p->prefixlen)
+		return;
+
+	if (buf->nroutes == buf->routes_size) {
+		buf->routes_size = MAX(buf->routes_size * 2, 1024U);
+		buf->routes = XREALLOC(MTYPE_RIB_SNAPSHOT, buf->routes,
+				       buf->routes_size * sizeof(*buf->routes));
+	}
+
+	rr = &buf->routes[buf->nroutes];
+	rib_snapshot_route_set_key(rr, re->vrf_id, info, p);
+	rr->metric = re->metric;
+	rr->instance = re->instance;
+	rr->type = re->type;
+	rr->distance = re->distance;
+	rr->nh_offset = buf->nnexthops;
+
+	for (ALL_NEXTHOPS(re->nhe->nhg, nh)) {
+		if (!rib_snapshot_nh_eligible(nh))
+			continue;
+		if (!rib_snapshot_nh_supported(nh) || rr->nh_num == UINT16_MAX)
+			goto drop;
+
+		if (buf->nnexthops == buf->nexthops_size) {
+			buf->nexthops_size = MAX(buf->nexthops_size * 2, 1024U);
+			buf->nexthops = XREALLOC(MTYPE_RIB_SNAPSHOT,
+						 buf->nexthops,
+						 buf->nexthops_size *
+							 sizeof(*buf->nexthops));
+		}
+
+		rib_snapshot_nh_encode(&buf->nexthops[buf->nnexthops++], nh);
+		rr->nh_num++;
+	}
+
+	if (rr->nh_num) {
+		buf->nroutes++;
+		return;
+	}
+
+drop:
+	buf->nnexthops = rr->nh_offset;
+}
+
+static void rib_snapshot_add_table(struct rib_snapshot_buf *buf,
+				   struct route_table *table)
+{
+	struct route_node *rn;
+	rib_dest_t *dest;
+
+	for (rn = route_top(table); rn; rn = srcdest_route_next(rn)) {
+		dest = rib_dest_from_rnode(rn);
+		if (!dest || !dest->selected_fib)
+			continue;
+
+		if (rib_snapshot_re_eligible(dest->selected_fib))
+			rib_snapshot_add(buf, rn, dest->selected_fib);
+	}
+}
+
+static uint32_t rib_snapshot_checksum(const void *routes, uint32_t nroutes,
+				      const void *nexthops, uint32_t nnexthops)
+{
+	uint32_t csum;
+
+	csum = jhash(routes, nroutes * sizeof(struct rib_snapshot_route), 0);
+	return jhash(nexthops, nnexthops * sizeof(struct rib_snapshot_nexthop),
+		     csum);
+}
+
+static int rib_snapshot_write(int fd, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	ssize_t n;
+
+	while (len) {
+		n = write(fd, p, len);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int zebra_rib_snapshot_save(const char *path)
+{
+	struct rib_snapshot_buf buf = {};
+	struct rib_snapshot_hdr hdr = {};
+	struct zebra_router_table *zrt;
+	char tmp[MAXPATHLEN];
+	int fd, ret = -1;
+
+	if (!path)
+		path = snap.path;
+	if (!path)
+		return -1;
+
+	RB_FOREACH (zrt, zebra_router_table_head, &zrouter.tables) {
+		if (zrt->safi == SAFI_UNICAST)
+			rib_snapshot_add_table(&buf, zrt->table);
+	}
+
+	hdr.magic = RIB_SNAPSHOT_MAGIC;
+	hdr.version = RIB_SNAPSHOT_VERSION;
+	hdr.hdrlen = sizeof(hdr);
+	hdr.nroutes = buf.nroutes;
+	hdr.nnexthops = buf.nnexthops;
+	hdr.length = sizeof(hdr) +
+		     (uint64_t)buf.nroutes * sizeof(*buf.routes) +
+		     (uint64_t)buf.nnexthops * sizeof(*buf.nexthops);
+	hdr.checksum = rib_snapshot_checksum(buf.routes, buf.nroutes,
+					     buf.nexthops, buf.nnexthops);
+
+	/* Write aside and rename, so a crash never leaves half a snapshot */
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL,
+			     "RIB snapshot: can't open %s: %s", tmp,
+			     safe_strerror(errno));
+		goto out;
+	}
+
+	if (rib_snapshot_write(fd, &hdr, sizeof(hdr)) ||
+	    rib_snapshot_write(fd, buf.routes,
+			       buf.nroutes * sizeof(*buf.routes)) ||
+	    rib_snapshot_write(fd, buf.nexthops,
+			       buf.nnexthops * sizeof(*buf.nexthops)) ||
+	    fsync(fd) < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL,
+			     "RIB snapshot: can't write %s: %s", tmp,
+			     safe_strerror(errno));
+		close(fd);
+		unlink(tmp);
+		goto out;
+	}
+	close(fd);
+
+	if (rename(tmp, path) < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL,
+			     "RIB snapshot: can't rename %s to %s: %s", tmp,
+			     path, safe_strerror(errno));
+		unlink(tmp);
+		goto out;
+	}
+
+	snap.saved = buf.nroutes;
+	zlog_info("RIB snapshot: saved %u routes to %s", buf.nroutes, path);
+	ret = 0;
+
+out:
+	XFREE(MTYPE_RIB_SNAPSHOT, buf.routes);
+	XFREE(MTYPE_RIB_SNAPSHOT, buf.nexthops);
+	return ret;
+}
+
+/*
+ * Loading
+ */
+static bool rib_snapshot_valid(const struct rib_snapshot_hdr *hdr,
+			       size_t len)
+{
+	const struct rib_snapshot_route *routes;
+	const void *nexthops;
+	uint32_t i;
+
+	if (hdr->magic != RIB_SNAPSHOT_MAGIC ||
+	    hdr->version != RIB_SNAPSHOT_VERSION ||
+	    hdr->hdrlen != sizeof(*hdr) || hdr->length != len)
+		return false;
+
+	if (hdr->length != sizeof(*hdr) +
+				   (uint64_t)hdr->nroutes * sizeof(*routes) +
+				   (uint64_t)hdr->nnexthops *
+					   sizeof(struct rib_snapshot_nexthop))
+		return false;
+
+	routes = (const void *)(hdr + 1);
+	nexthops = routes + hdr->nroutes;
+
+	if (hdr->checksum != rib_snapshot_checksum(routes, hdr->nroutes,
+						   nexthops, hdr->nnexthops))
+		return false;
+
+	for (i = 0; i < hdr->nroutes; i++) {
+		const struct rib_snapshot_route *rr = &routes[i];
+
+		if ((uint64_t)rr->nh_offset + rr->nh_num > hdr->nnexthops)
+			return false;
+
+		if (!(rr->afi == AFI_IP && rr->family == AF_INET &&
+		      rr->prefixlen <= IPV4_MAX_BITLEN) &&
+		    !(rr->afi == AFI_IP6 && rr->family == AF_INET6 &&
+		      rr->prefixlen <= IPV6_MAX_BITLEN))
+			return false;
+	}
+
+	return true;
+}
+
+int zebra_rib_snapshot_load(const char *path)
+{
+	const struct rib_snapshot_hdr *hdr;
+	unsigned int size = 1;
+	struct stat st;
+	void *map;
+	uint32_t i;
+	int fd;
+
+	if (!path)
+		path = snap.path;
+	if (!path)
+		return -1;
+
+	zebra_rib_snapshot_release();
+
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		if (errno == ENOENT)
+			zlog_info("RIB snapshot: %s not found, cold start",
+				  path);
+		else
+			flog_err_sys(EC_LIB_SYSTEM_CALL,
+				     "RIB snapshot: can't open %s: %s", path,
+				     safe_strerror(errno));
+		return -1;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(*hdr)) {
+		zlog_warn("RIB snapshot: %s is too short, ignoring it", path);
+		close(fd);
+		return -1;
+	}
+
+	map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL,
+			     "RIB snapshot: can't map %s: %s", path,
+			     safe_strerror(errno));
+		return -1;
+	}
+
+	hdr = map;
+	if (!rib_snapshot_valid(hdr, st.st_size)) {
+		zlog_warn("RIB snapshot: %s is not usable, ignoring it", path);
+		munmap(map, st.st_size);
+		return -1;
+	}
+
+	snap.map = map;
+	snap.maplen = st.st_size;
+	snap.nroutes = hdr->nroutes;
+	snap.routes = (const void *)(hdr + 1);
+	snap.nexthops = (const void *)(snap.routes + hdr->nroutes);
+
+	while (size < snap.nroutes && size < (1U << 24))
+		size <<= 1;
+	snap.index = hash_create_size(size, rib_snapshot_route_key,
+				      rib_snapshot_route_cmp,
+				      "RIB snapshot index");
+
+	for (i = 0; i < snap.nroutes; i++)
+		(void)hash_get(snap.index, (void *)&snap.routes[i],
+			       hash_alloc_intern);
+
+	snap.loaded = snap.nroutes;
+	zlog_info("RIB snapshot: loaded %u routes from %s", snap.nroutes,
+		  path);
+
+	return 0;
+}
+
+void zebra_rib_snapshot_release(void)
+{
+	if (snap.index) {
+		hash_clean(snap.index, NULL);
+		hash_free(snap.index);
+		snap.index = NULL;
+	}
+
+	if (snap.map) {
+		munmap(snap.map, snap.maplen);
+		snap.map = NULL;
+		snap.maplen = 0;
+	}
+
+	snap.routes = NULL;
+	snap.nexthops = NULL;
+	snap.nroutes = 0;
+}
+
+/*
+ * Matching
+ */
+bool zebra_rib_snapshot_match(struct route_node *rn, struct route_entry *re,
+			      struct route_entry *old)
+{
+	struct rib_table_info *info = srcdest_rnode_table_info(rn);
+	const struct rib_snapshot_route *rr;
+	struct rib_snapshot_route key;
+	const struct prefix *p, *src_p;
+	struct route_entry *kre;
+
+	if (!snap.index)
+		return false;
+
+	/*
+	 * Anything behind the kernel (FPM, an asic) still has to be told
+	 * about the route.
+	 */
+	if (zrouter.asic_offloaded || dplane_provider_count() > 1)
+		return false;
+
+	if (RIB_SYSTEM_ROUTE(re))
+		return false;
+
+	srcdest_rnode_prefixes(rn, &p, &src_p);
+	if (src_p && src_p->prefixlen)
+		return false;
+
+	/*
+	 * 'kre' is the route read from the kernel at startup: either 're'
+	 * itself, or the one 're' replaces.
+	 */
+	kre = (old && old != re) ? old : re;
+
+	if (!CHECK_FLAG(kre->flags, ZEBRA_FLAG_SELFROUTE) ||
+	    kre->uptime > zrouter.startup_time || kre->type != re->type)
+		return false;
+
+	if (kre != re && (!CHECK_FLAG(kre->status, ROUTE_ENTRY_INSTALLED) ||
+			  CHECK_FLAG(kre->status, ROUTE_ENTRY_QUEUED) ||
+			  CHECK_FLAG(kre->status, ROUTE_ENTRY_USE_FIB_NHG)))
+		return false;
+
+	/*
+	 * A kernel route using a nexthop object would lose it once 'kre' is
+	 * gone, unless 're' holds on to the same object.
+	 */
+	if (CHECK_FLAG(kre->nhe->flags, NEXTHOP_GROUP_INSTALLED) &&
+	    kre->nhe != re->nhe)
+		return false;
+
+	rib_snapshot_route_set_key(&key, re->vrf_id, info, p);
+	rr = hash_lookup(snap.index, &key);
+	if (!rr)
+		return false;
+
+	/* The kernel still has what the previous run installed ... */
+	if (rr->type != kre->type ||
+	    !rib_snapshot_nhg_match(rr, &kre->nhe->nhg, false))
+		goto mismatch;
+
+	/* ... and the new route asks for exactly that again. Distance and
+	 * metric aren't kept in the kernel, so only the latter can tell.
+	 */
+	if (kre != re &&
+	    (rr->instance != re->instance || rr->distance != re->distance ||
+	     rr->metric != re->metric ||
+	     !rib_snapshot_nhg_match(rr, &re->nhe->nhg, true)))
+		goto mismatch;
+
+	snap.adopted++;
+
+	if (IS_ZEBRA_DEBUG_RIB)
+		zlog_debug("%u:%u:%pRN: taking over route from kernel",
+			   re->vrf_id, info->table_id, rn);
+
+	return true;
+
+mismatch:
+	snap.mismatched++;
+	return false;
+}
+
+void zebra_rib_snapshot_show(struct vty *vty)
+{
+	if (!snap.path && !snap.loaded && !snap.saved)
+		return;
+
+	vty_out(vty, "RIB snapshot: %s%s\n", snap.path ? snap.path : "-",
+		snap.index ? " (in use)" : "");
+	vty_out(vty,
+		"  Loaded %u, saved %u, routes taken over %" PRIu64
+		", mismatched %" PRIu64 "\n",
+		snap.loaded, snap.saved, snap.adopted, snap.mismatched);
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: GPL-2.0-or-later
+/*
+ * Zebra RIB snapshot, used to speed up warm restarts.
+ */
+
+#ifndef _ZEBRA_RIB_SNAPSHOT_H
+#define _ZEBRA_RIB_SNAPSHOT_H
+
+#include "zebra/rib.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * A snapshot is a flat file describing the routes zebra had installed in
+ * the kernel: which protocol owned each one and the nexthops that went
+ * into the FIB. It is written at shutdown (and on demand), and read back
+ * with mmap() on the next start.
+ *
+ * While the startup routes read from the kernel are still waiting to be
+ * swept, the snapshot lets zebra recognize routes that the previous run
+ * left in the kernel exactly as the protocols are asking for them again,
+ * and take those over instead of sending them through the dataplane a
+ * second time.
+ */
+
+/* Default file for the snapshot, set with --rib-snapshot */
+extern void zebra_rib_snapshot_set_path(const char *path);
+extern const char *zebra_rib_snapshot_get_path(void);
+
+/* Write the installed RIB to 'path' (default file if NULL) */
+extern int zebra_rib_snapshot_save(const char *path);
+
+/* Map a snapshot written by a previous run (default file if NULL) */
+extern int zebra_rib_snapshot_load(const char *path);
+
+/* Drop the loaded snapshot, once the startup routes have been swept */
+extern void zebra_rib_snapshot_release(void);
+
+/*
+ * Can 're' be taken over from the kernel instead of being installed?
+ * 'old' is the route currently selected for the FIB, if any.
+ */
+extern bool zebra_rib_snapshot_match(struct route_node *rn,
+				     struct route_entry *re,
+				     struct route_entry *old);
+
+extern void zebra_rib_snapshot_show(struct vty *vty);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_RIB_SNAPSHOT_H */
@@ -648,7 +648,7 @@ static void zebra_rnh_process_pseudowires(vrf_id_t vrfid, struct rnh *rnh)
  * take appropriate action; this involves notifying any clients and/or
  * scheduling dependent static routes for processing.
  */
-static void zebra_rnh_eval_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
+static bool zebra_rnh_eval_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
 					 int force, struct route_node *nrn,
 					 struct rnh *rnh,
 					 struct route_node *prn,
@@ -694,10 +694,12 @@ static void zebra_rnh_eval_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
 		/* Process pseudowires attached to this nexthop */
 		zebra_rnh_process_pseudowires(zvrf->vrf->vrf_id, rnh);
 	}
+
+	return state_changed || force;
 }
 
-/* Evaluate one tracked entry */
-static void zebra_rnh_evaluate_entry(struct zebra_vrf *zvrf, afi_t afi,
+/* Evaluate one tracked entry, returns true if clients were notified */
+static bool zebra_rnh_evaluate_entry(struct zebra_vrf *zvrf, afi_t afi,
 				     int force, struct route_node *nrn)
 {
 	struct rnh *rnh;
@@ -719,10 +721,11 @@ static void zebra_rnh_evaluate_entry(struct zebra_vrf *zvrf, afi_t afi,
 	 * there is nothing further to do.
 	 */
 	if (!re && rnh->state == NULL && !force)
-		return;
+		return false;
 
 	/* Process based on type of entry. */
-	zebra_rnh_eval_nexthop_entry(zvrf, afi, force, nrn, rnh, prn, re);
+	return zebra_rnh_eval_nexthop_entry(zvrf, afi, force, nrn, rnh, prn,
+					    re);
 }
 
 /*
@@ -750,6 +753,20 @@ static void zebra_rnh_clear_nhc_flag(struct zebra_vrf *zvrf, afi_t afi,
 		UNSET_FLAG(re->status, ROUTE_ENTRY_LABELS_CHANGED);
 }
 
+void zebra_rnh_stats_add(struct zebra_vrf *zvrf, afi_t afi,
+			 enum zebra_rnh_trigger trigger, uint32_t evaluated,
+			 uint32_t notified)
+{
+	struct zebra_rnh_stats *stats = &zvrf->rnh_stats[afi][trigger];
+
+	stats->runs++;
+	stats->evaluated += evaluated;
+	stats->notified += notified;
+	stats->last = evaluated;
+	if (evaluated > stats->max)
+		stats->max = evaluated;
+}
+
 /* Evaluate all tracked entries (nexthops or routes for import into BGP)
  * of a particular VRF and address-family or a specific prefix.
  */
@@ -758,6 +775,7 @@ void zebra_evaluate_rnh(struct zebra_vrf *zvrf, afi_t afi, int force,
 {
 	struct route_table *rnh_table;
 	struct route_node *nrn;
+	uint32_t evaluated = 0, notified = 0;
 
 	rnh_table = get_rnh_table(zvrf->vrf->vrf_id, afi, safi);
 	if (!rnh_table) // unexpected
@@ -766,17 +784,27 @@ void zebra_evaluate_rnh(struct zebra_vrf *zvrf, afi_t afi, int force,
 	if (p) {
 		/* Evaluating a specific entry, make sure it exists. */
 		nrn = route_node_lookup(rnh_table, p);
-		if (nrn && nrn->info)
-			zebra_rnh_evaluate_entry(zvrf, afi, force, nrn);
+		if (nrn && nrn->info) {
+			evaluated++;
+			if (zebra_rnh_evaluate_entry(zvrf, afi, force, nrn))
+				notified++;
+		}
 
 		if (nrn)
 			route_unlock_node(nrn);
+
+		zebra_rnh_stats_add(zvrf, afi, RNH_TRIGGER_REGISTER, evaluated,
+				    notified);
 	} else {
 		/* Evaluate entire table. */
 		nrn = route_top(rnh_table);
 		while (nrn) {
-			if (nrn->info)
-				zebra_rnh_evaluate_entry(zvrf, afi, force, nrn);
+			if (nrn->info) {
+				evaluated++;
+				if (zebra_rnh_evaluate_entry(zvrf, afi, force,
+							     nrn))
+					notified++;
+			}
 			nrn = route_next(nrn); /* this will also unlock nrn */
 		}
 		nrn = route_top(rnh_table);
@@ -785,9 +813,75 @@ void zebra_evaluate_rnh(struct zebra_vrf *zvrf, afi_t afi, int force,
 				zebra_rnh_clear_nhc_flag(zvrf, afi, nrn);
 			nrn = route_next(nrn); /* this will also unlock nrn */
 		}
+
+		zebra_rnh_stats_add(zvrf, afi, RNH_TRIGGER_ALL, evaluated,
+				    notified);
 	}
 }
 
+/* Evaluate a tracked entry found through the route it resolves over, i.e.
+ * on that route's dest->nht list.
+ */
+bool zebra_evaluate_rnh_entry(struct zebra_vrf *zvrf, struct rnh *rnh)
+{
+	return zebra_rnh_evaluate_entry(zvrf, rnh->afi, 0, rnh->node);
+}
+
+/*
+ * Evaluate the entries affected by a change of the VRF's resolve-via-default
+ * setting.  Those are the entries resolving over the default route and the
+ * unresolved ones, both of which are kept on the default route's dest->nht
+ * list, and re-evaluating them keeps them there.  Entries that registered
+ * with resolve-via-default themselves don't care about the VRF setting.
+ */
+void zebra_evaluate_rnh_default(struct zebra_vrf *zvrf, afi_t afi,
+				safi_t safi)
+{
+	struct route_table *table;
+	struct route_node *rn;
+	struct prefix p = {};
+	rib_dest_t *dest;
+	struct rnh *rnh;
+	uint32_t seq, evaluated = 0, notified = 0;
+
+	table = zvrf->table[afi][safi];
+	if (!table)
+		return;
+
+	p.family = afi2family(afi);
+	rn = route_node_lookup(table, &p);
+	if (!rn)
+		return;
+
+	dest = rib_dest_from_rnode(rn);
+	if (!dest) {
+		route_unlock_node(rn);
+		return;
+	}
+
+	/* entries staying on the list are put back at the end of it */
+	seq = zebra_router_get_next_sequence();
+	frr_each_safe (rnh_list, &dest->nht, rnh) {
+		if (rnh->seqno == seq
+		    || CHECK_FLAG(rnh->flags, ZEBRA_NHT_RESOLVE_VIA_DEFAULT))
+			continue;
+
+		rnh->seqno = seq;
+		evaluated++;
+		if (zebra_rnh_evaluate_entry(zvrf, afi, 0, rnh->node))
+			notified++;
+	}
+
+	frr_each (rnh_list, &dest->nht, rnh)
+		if (rnh->seqno == seq)
+			zebra_rnh_clear_nhc_flag(zvrf, afi, rnh->node);
+
+	route_unlock_node(rn);
+
+	zebra_rnh_stats_add(zvrf, afi, RNH_TRIGGER_DEFAULT, evaluated,
+			    notified);
+}
+
 void zebra_print_rnh_table(vrf_id_t vrfid, afi_t afi, safi_t safi,
 			   struct vty *vty, const struct prefix *p,
 			   json_object *json)
@@ -811,6 +905,48 @@ void zebra_print_rnh_table(vrf_id_t vrfid, afi_t afi, safi_t safi,
 	}
 }
 
+static const char *const rnh_trigger_names[RNH_TRIGGER_MAX] = {
+	[RNH_TRIGGER_ROUTE] = "route",
+	[RNH_TRIGGER_REGISTER] = "register",
+	[RNH_TRIGGER_DEFAULT] = "resolve-via-default",
+	[RNH_TRIGGER_ALL] = "full-table",
+};
+
+void zebra_rnh_stats_show(struct zebra_vrf *zvrf, afi_t afi, struct vty *vty,
+			  json_object *json)
+{
+	const struct zebra_rnh_stats *stats;
+	json_object *json_trigger;
+	int i;
+
+	if (!json)
+		vty_out(vty, "%-20s %10s %12s %12s %8s %8s\n", "Trigger", "Runs",
+			"Evaluated", "Notified", "Last", "Max");
+
+	for (i = 0; i < RNH_TRIGGER_MAX; i++) {
+		stats = &zvrf->rnh_stats[afi][i];
+
+		if (!json) {
+			vty_out(vty,
+				"%-20s %10" PRIu64 " %12" PRIu64 " %12" PRIu64
+				" %8u %8u\n",
+				rnh_trigger_names[i], stats->runs,
+				stats->evaluated, stats->notified, stats->last,
+				stats->max);
+			continue;
+		}
+
+		json_trigger = json_object_new_object();
+		json_object_int_add(json_trigger, "runs", stats->runs);
+		json_object_int_add(json_trigger, "evaluated", stats->evaluated);
+		json_object_int_add(json_trigger, "notified", stats->notified);
+		json_object_int_add(json_trigger, "last", stats->last);
+		json_object_int_add(json_trigger, "max", stats->max);
+		json_object_object_add(json, rnh_trigger_names[i],
+				       json_trigger);
+	}
+}
+
 /**
  * free_state - free up the re structure associated with the rnh.
  */
@@ -30,6 +30,14 @@ extern void zebra_deregister_rnh_pseudowire(vrf_id_t, struct zebra_pw *);
 extern void zebra_remove_rnh_client(struct rnh *rnh, struct zserv *client);
 extern void zebra_evaluate_rnh(struct zebra_vrf *zvrf, afi_t afi, int force,
 			       const struct prefix *p, safi_t safi);
+extern bool zebra_evaluate_rnh_entry(struct zebra_vrf *zvrf, struct rnh *rnh);
+extern void zebra_evaluate_rnh_default(struct zebra_vrf *zvrf, afi_t afi,
+				       safi_t safi);
+extern void zebra_rnh_stats_add(struct zebra_vrf *zvrf, afi_t afi,
+				enum zebra_rnh_trigger trigger,
+				uint32_t evaluated, uint32_t notified);
+extern void zebra_rnh_stats_show(struct zebra_vrf *zvrf, afi_t afi,
+				 struct vty *vty, json_object *json);
 extern void zebra_print_rnh_table(vrf_id_t vrfid, afi_t afi, safi_t safi,
 				  struct vty *vty, const struct prefix *p,
 				  json_object *json);
@@ -351,6 +351,11 @@ static void zebra_vrf_table_create(struct zebra_vrf *zvrf, afi_t afi,
 	zvrf->table[afi][safi] =
 		zebra_router_get_table(zvrf, zvrf->table_id, afi, safi);
 
+	/* nexthop resolution does a lot of longest-prefix matches here */
+	if (safi == SAFI_UNICAST)
+		route_table_lpm_enable(zvrf->table[afi][safi],
+				       afi2family(afi));
+
 	memset(&p, 0, sizeof(p));
 	p.family = afi2family(afi);
 
@@ -29,6 +29,30 @@ struct zebra_rmap {
 	struct route_map *map;
 };
 
+/* What made nexthop tracking re-evaluate its entries */
+enum zebra_rnh_trigger {
+	/* a route that entries resolve over changed */
+	RNH_TRIGGER_ROUTE = 0,
+	/* a single entry was (re-)registered */
+	RNH_TRIGGER_REGISTER,
+	/* the VRF's resolve-via-default setting changed */
+	RNH_TRIGGER_DEFAULT,
+	/* full table, e.g. after a NHT route-map change */
+	RNH_TRIGGER_ALL,
+
+	RNH_TRIGGER_MAX,
+};
+
+struct zebra_rnh_stats {
+	uint64_t runs;
+	/* entries looked at, and of those the ones clients were told about */
+	uint64_t evaluated;
+	uint64_t notified;
+	/* entries looked at by the last and by the largest run */
+	uint32_t last;
+	uint32_t max;
+};
+
 PREDECL_RBTREE_UNIQ(otable);
 
 struct other_route_table {
@@ -167,6 +191,9 @@ struct zebra_vrf {
 
 	bool zebra_rnh_ip_default_route;
 	bool zebra_rnh_ipv6_default_route;
+
+	/* Nexthop tracking re-evaluations */
+	struct zebra_rnh_stats rnh_stats[AFI_MAX][RNH_TRIGGER_MAX];
 };
 #define PROTO_RM_NAME(zvrf, afi, rtype) zvrf->proto_rm[afi][rtype].name
 #define NHT_RM_NAME(zvrf, afi, rtype) zvrf->nht_rm[afi][rtype].name
@@ -50,6 +50,7 @@
 #include "zebra/zebra_script.h"
 #include "zebra/rtadv.h"
 #include "zebra/zebra_neigh.h"
+#include "zebra/zebra_rib_snapshot.h"
 
 /* context to manage dumps in multiple tables or vrfs */
 struct route_show_ctx {
@@ -1038,6 +1039,16 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 	return CMD_SUCCESS;
 }
 
+/* The re-evaluation counters, next to the table they are about */
+static void show_nht_json_statistics(struct zebra_vrf *zvrf, afi_t afi,
+				     json_object *json_vrf)
+{
+	json_object *json_stats = json_object_new_object();
+
+	zebra_rnh_stats_show(zvrf, afi, NULL, json_stats);
+	json_object_object_add(json_vrf, "statistics", json_stats);
+}
+
 DEFPY (show_ip_nht,
        show_ip_nht_cmd,
        "show <ip$ipv4|ipv6$ipv6> <nht|import-check>$type [<A.B.C.D|X:X::X:X>$addr|vrf NAME$vrf_name [<A.B.C.D|X:X::X:X>$addr]|vrf all$vrf_all] [mrib$mrib] [json]",
@@ -1063,13 +1074,13 @@ DEFPY (show_ip_nht,
 	json_object *json = NULL;
 	json_object *json_vrf = NULL;
 	json_object *json_nexthop = NULL;
+	struct zebra_vrf *zvrf;
 
 	if (uj)
 		json = json_object_new_object();
 
 	if (vrf_all) {
 		struct vrf *vrf;
-		struct zebra_vrf *zvrf;
 
 		RB_FOREACH (vrf, vrf_name_head, &vrfs_by_name) {
 			if ((zvrf = vrf->info) != NULL) {
@@ -1084,6 +1095,8 @@ DEFPY (show_ip_nht,
 								       ? "ipv4"
 								       : "ipv6",
 							       json_nexthop);
+					show_nht_json_statistics(zvrf, afi,
+								 json_vrf);
 				} else {
 					vty_out(vty, "\nVRF %s:\n",
 						zvrf_name(zvrf));
@@ -1126,6 +1139,73 @@ DEFPY (show_ip_nht,
 
 	zebra_print_rnh_table(vrf_id, afi, safi, vty, p, json_nexthop);
 
+	if (uj) {
+		zvrf = zebra_vrf_lookup_by_id(vrf_id);
+		if (!p && zvrf)
+			show_nht_json_statistics(zvrf, afi, json_vrf);
+		vty_json(vty, json);
+	}
+
+	return CMD_SUCCESS;
+}
+
+static void show_nht_statistics(struct vty *vty, struct zebra_vrf *zvrf,
+				afi_t afi, json_object *json)
+{
+	json_object *json_vrf = NULL;
+	json_object *json_afi = NULL;
+
+	if (json) {
+		json_vrf = json_object_new_object();
+		json_afi = json_object_new_object();
+		json_object_object_add(json, zvrf_name(zvrf), json_vrf);
+		json_object_object_add(json_vrf,
+				       afi == AFI_IP ? "ipv4" : "ipv6",
+				       json_afi);
+	} else
+		vty_out(vty, "VRF %s:\n", zvrf_name(zvrf));
+
+	zebra_rnh_stats_show(zvrf, afi, vty, json_afi);
+}
+
+DEFPY (show_ip_nht_statistics,
+       show_ip_nht_statistics_cmd,
+       "show <ip$ipv4|ipv6$ipv6> nht statistics [vrf <NAME$vrf_name|all$vrf_all>] [json$uj]",
+       SHOW_STR
+       IP_STR
+       IP6_STR
+       "IP nexthop tracking table\n"
+       "Nexthop re-evaluation counters\n"
+       VRF_FULL_CMD_HELP_STR
+       JSON_STR)
+{
+	afi_t afi = ipv4 ? AFI_IP : AFI_IP6;
+	struct zebra_vrf *zvrf;
+	struct vrf *vrf;
+	json_object *json = NULL;
+
+	if (uj)
+		json = json_object_new_object();
+
+	if (vrf_all) {
+		RB_FOREACH (vrf, vrf_name_head, &vrfs_by_name) {
+			zvrf = vrf->info;
+			if (zvrf)
+				show_nht_statistics(vty, zvrf, afi, json);
+		}
+	} else {
+		zvrf = zebra_vrf_lookup_by_name(vrf_name ? vrf_name
+							 : VRF_DEFAULT_NAME);
+		if (!zvrf) {
+			if (uj)
+				json_object_free(json);
+			else
+				vty_out(vty, "%% VRF %s not found\n", vrf_name);
+			return CMD_WARNING;
+		}
+		show_nht_statistics(vty, zvrf, afi, json);
+	}
+
 	if (uj)
 		vty_json(vty, json);
 
@@ -1149,7 +1229,7 @@ DEFUN (ip_nht_default_route,
 
 	zvrf->zebra_rnh_ip_default_route = true;
 
-	zebra_evaluate_rnh(zvrf, AFI_IP, 0, NULL, SAFI_UNICAST);
+	zebra_evaluate_rnh_default(zvrf, AFI_IP, SAFI_UNICAST);
 	return CMD_SUCCESS;
 }
 
@@ -1668,7 +1748,7 @@ DEFUN (no_ip_nht_default_route,
 		return CMD_SUCCESS;
 
 	zvrf->zebra_rnh_ip_default_route = false;
-	zebra_evaluate_rnh(zvrf, AFI_IP, 0, NULL, SAFI_UNICAST);
+	zebra_evaluate_rnh_default(zvrf, AFI_IP, SAFI_UNICAST);
 	return CMD_SUCCESS;
 }
 
@@ -1688,7 +1768,7 @@ DEFUN (ipv6_nht_default_route,
 		return CMD_SUCCESS;
 
 	zvrf->zebra_rnh_ipv6_default_route = true;
-	zebra_evaluate_rnh(zvrf, AFI_IP6, 0, NULL, SAFI_UNICAST);
+	zebra_evaluate_rnh_default(zvrf, AFI_IP6, SAFI_UNICAST);
 	return CMD_SUCCESS;
 }
 
@@ -1709,7 +1789,7 @@ DEFUN (no_ipv6_nht_default_route,
 		return CMD_SUCCESS;
 
 	zvrf->zebra_rnh_ipv6_default_route = false;
-	zebra_evaluate_rnh(zvrf, AFI_IP6, 0, NULL, SAFI_UNICAST);
+	zebra_evaluate_rnh_default(zvrf, AFI_IP6, SAFI_UNICAST);
 	return CMD_SUCCESS;
 }
 
@@ -3893,6 +3973,42 @@ DEFUN_HIDDEN (no_zebra_workqueue_timer,
 	return CMD_SUCCESS;
 }
 
+DEFPY (zebra_rib_workers,
+       zebra_rib_workers_cmd,
+       "[no] zebra rib workers (1-64)$workers",
+       NO_STR
+       ZEBRA_STR
+       "Routing Information Base\n"
+       "Resolve nexthops of different VRFs in parallel\n"
+       "Number of pthreads, including the main pthread\n")
+{
+	zebra_rib_set_workers(no ? 1 : workers);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (zebra_rib_snapshot_save,
+       zebra_rib_snapshot_save_cmd,
+       "zebra rib snapshot save [FILE$file]",
+       ZEBRA_STR
+       "Routing Information Base\n"
+       "Snapshot of the installed routes, for warm restart\n"
+       "Write the snapshot now\n"
+       "File to write, instead of the one given at startup\n")
+{
+	if (!file && !zebra_rib_snapshot_get_path()) {
+		vty_out(vty, "%% No snapshot file given\n");
+		return CMD_WARNING;
+	}
+
+	if (zebra_rib_snapshot_save(file) < 0) {
+		vty_out(vty, "%% Failed to write the RIB snapshot\n");
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
 DEFUN (no_ip_zebra_import_table,
        no_ip_zebra_import_table_cmd,
        "no ip import-table (1-252) [distance (1-255)] [route-map NAME]",
@@ -3955,6 +4071,9 @@ static int config_write_protocol(struct vty *vty)
 	if (zrouter.ribq->spec.hold != ZEBRA_RIB_PROCESS_HOLD_TIME)
 		vty_out(vty, "zebra work-queue %u\n", zrouter.ribq->spec.hold);
 
+	if (zebra_rib_get_workers() != 1)
+		vty_out(vty, "zebra rib workers %u\n", zebra_rib_get_workers());
+
 	if (zrouter.packets_to_process != ZEBRA_ZAPI_PACKETS_TO_PROCESS)
 		vty_out(vty, "zebra zapi-packets %u\n",
 			zrouter.packets_to_process);
@@ -4097,6 +4216,10 @@ DEFUN (show_zebra,
 			zvrf->lsp_removals);
 	}
 
+	vty_out(vty, "\n");
+	zebra_rib_queue_show(vty);
+	zebra_rib_snapshot_show(vty);
+
 	return CMD_SUCCESS;
 }
 
@@ -4245,7 +4368,13 @@ DEFUN (show_dataplane,
 	if (argv_find(argv, argc, "detailed", &idx))
 		detailed = true;
 
-	return dplane_show_helper(vty, detailed);
+	dplane_show_helper(vty, detailed);
+
+#ifdef HAVE_NETLINK
+	netlink_batch_show_helper(vty);
+#endif /* HAVE_NETLINK */
+
+	return CMD_SUCCESS;
 }
 
 /* Display dataplane providers info */
@@ -4300,6 +4429,39 @@ DEFUN (no_zebra_dplane_queue_limit,
 	return CMD_SUCCESS;
 }
 
+/* Configure number of dataplane shard pthreads */
+DEFUN (zebra_dplane_shards,
+       zebra_dplane_shards_cmd,
+       "zebra dplane shards (1-16)",
+       ZEBRA_STR
+       "Zebra dataplane\n"
+       "Pthreads to spread dataplane provider work across\n"
+       "Number of pthreads\n")
+{
+	uint32_t count;
+
+	count = strtoul(argv[3]->arg, NULL, 10);
+
+	dplane_set_shard_count(count, true);
+
+	return CMD_SUCCESS;
+}
+
+/* Reset number of dataplane shard pthreads to default value */
+DEFUN (no_zebra_dplane_shards,
+       no_zebra_dplane_shards_cmd,
+       "no zebra dplane shards [(1-16)]",
+       NO_STR
+       ZEBRA_STR
+       "Zebra dataplane\n"
+       "Pthreads to spread dataplane provider work across\n"
+       "Number of pthreads\n")
+{
+	dplane_set_shard_count(0, false);
+
+	return CMD_SUCCESS;
+}
+
 DEFUN (zebra_show_routing_tables_summary,
        zebra_show_routing_tables_summary_cmd,
        "show zebra router table summary",
@@ -4430,6 +4592,38 @@ DEFUN_HIDDEN(no_zebra_kernel_netlink_batch_tx_buf,
 	return CMD_SUCCESS;
 }
 
+DEFUN_HIDDEN(zebra_kernel_netlink_batch_tx_pipeline,
+	     zebra_kernel_netlink_batch_tx_pipeline_cmd,
+	     "zebra kernel netlink batch-tx-pipeline (1-64)",
+	     ZEBRA_STR
+	     "Zebra kernel interface\n"
+	     "Set Netlink parameters\n"
+	     "Set number of batches sent before reading responses\n"
+	     "Batches in flight\n")
+{
+	uint32_t depth = 0;
+
+	depth = strtoul(argv[4]->arg, NULL, 10);
+
+	netlink_set_batch_pipeline(depth, true);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN_HIDDEN(no_zebra_kernel_netlink_batch_tx_pipeline,
+	     no_zebra_kernel_netlink_batch_tx_pipeline_cmd,
+	     "no zebra kernel netlink batch-tx-pipeline [(1-64)]",
+	     NO_STR ZEBRA_STR
+	     "Zebra kernel interface\n"
+	     "Set Netlink parameters\n"
+	     "Set number of batches sent before reading responses\n"
+	     "Batches in flight\n")
+{
+	netlink_set_batch_pipeline(0, false);
+
+	return CMD_SUCCESS;
+}
+
 DEFPY (zebra_protodown_bit,
        zebra_protodown_bit_cmd,
        "zebra protodown reason-bit (0-31)$bit",
@@ -4548,6 +4742,7 @@ void zebra_vty_init(void)
 	install_element(CONFIG_NODE, &ip_forwarding_cmd);
 	install_element(CONFIG_NODE, &no_ip_forwarding_cmd);
 	install_element(ENABLE_NODE, &show_zebra_cmd);
+	install_element(ENABLE_NODE, &zebra_rib_snapshot_save_cmd);
 
 	install_element(VIEW_NODE, &show_ipv6_forwarding_cmd);
 	install_element(CONFIG_NODE, &ipv6_forwarding_cmd);
@@ -4572,6 +4767,7 @@ void zebra_vty_init(void)
 	install_element(CONFIG_NODE, &no_ip_zebra_import_table_cmd);
 	install_element(CONFIG_NODE, &zebra_workqueue_timer_cmd);
 	install_element(CONFIG_NODE, &no_zebra_workqueue_timer_cmd);
+	install_element(CONFIG_NODE, &zebra_rib_workers_cmd);
 	install_element(CONFIG_NODE, &zebra_packet_process_cmd);
 	install_element(CONFIG_NODE, &no_zebra_packet_process_cmd);
 	install_element(CONFIG_NODE, &nexthop_group_use_enable_cmd);
@@ -4588,6 +4784,7 @@ void zebra_vty_init(void)
 	install_element(VIEW_NODE, &show_route_detail_cmd);
 	install_element(VIEW_NODE, &show_route_summary_cmd);
 	install_element(VIEW_NODE, &show_ip_nht_cmd);
+	install_element(VIEW_NODE, &show_ip_nht_statistics_cmd);
 
 	install_element(VIEW_NODE, &show_ip_rpf_cmd);
 	install_element(VIEW_NODE, &show_ip_rpf_addr_cmd);
@@ -4661,6 +4858,8 @@ void zebra_vty_init(void)
 	install_element(VIEW_NODE, &show_dataplane_providers_cmd);
 	install_element(CONFIG_NODE, &zebra_dplane_queue_limit_cmd);
 	install_element(CONFIG_NODE, &no_zebra_dplane_queue_limit_cmd);
+	install_element(CONFIG_NODE, &zebra_dplane_shards_cmd);
+	install_element(CONFIG_NODE, &no_zebra_dplane_shards_cmd);
 
 	install_element(CONFIG_NODE, &ip_table_range_cmd);
 	install_element(VRF_NODE, &ip_table_range_cmd);
@@ -4668,6 +4867,10 @@ void zebra_vty_init(void)
 #ifdef HAVE_NETLINK
 	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_tx_buf_cmd);
 	install_element(CONFIG_NODE, &no_zebra_kernel_netlink_batch_tx_buf_cmd);
+	install_element(CONFIG_NODE,
+			&zebra_kernel_netlink_batch_tx_pipeline_cmd);
+	install_element(CONFIG_NODE,
+			&no_zebra_kernel_netlink_batch_tx_pipeline_cmd);
 	install_element(CONFIG_NODE, &zebra_protodown_bit_cmd);
 	install_element(CONFIG_NODE, &no_zebra_protodown_bit_cmd);
 #endif /* HAVE_NETLINK */
@@ -240,7 +240,7 @@ static void zevpn_print_neigh_hash_all_evpn(struct hash_bucket *bucket,
 
 	zevpn = (struct zebra_evpn *)bucket->data;
 
-	num_neigh = hashcount(zevpn->neigh_table);
+	num_neigh = zebra_neigh_db_count(&zevpn->neigh_table);
 
 	if (print_dup)
 		num_neigh = num_dup_detected_neighs(zevpn);
@@ -270,18 +270,18 @@ static void zevpn_print_neigh_hash_all_evpn(struct hash_bucket *bucket,
 	wctx.vty = vty;
 	wctx.addr_width = 15;
 	wctx.json = json_evpn;
-	hash_iterate(zevpn->neigh_table, zebra_evpn_find_neigh_addr_width,
-		     &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_find_neigh_addr_width,
+				 &wctx);
 
 	if (json == NULL)
 		zebra_evpn_print_neigh_hdr(vty, &wctx);
 
 	if (print_dup)
-		hash_iterate(zevpn->neigh_table,
-			     zebra_evpn_print_dad_neigh_hash, &wctx);
+		zebra_evpn_neigh_iterate(zevpn, zebra_evpn_print_dad_neigh_hash,
+					 &wctx);
 	else
-		hash_iterate(zevpn->neigh_table, zebra_evpn_print_neigh_hash,
-			     &wctx);
+		zebra_evpn_neigh_iterate(zevpn, zebra_evpn_print_neigh_hash,
+					 &wctx);
 
 	if (json)
 		json_object_object_add(json, vni_str, json_evpn);
@@ -311,7 +311,7 @@ static void zevpn_print_neigh_hash_all_evpn_detail(struct hash_bucket *bucket,
 			vty_out(vty, "{}\n");
 		return;
 	}
-	num_neigh = hashcount(zevpn->neigh_table);
+	num_neigh = zebra_neigh_db_count(&zevpn->neigh_table);
 
 	if (print_dup && num_dup_detected_neighs(zevpn) == 0)
 		return;
@@ -338,11 +338,13 @@ static void zevpn_print_neigh_hash_all_evpn_detail(struct hash_bucket *bucket,
 	wctx.json = json_evpn;
 
 	if (print_dup)
-		hash_iterate(zevpn->neigh_table,
-			     zebra_evpn_print_dad_neigh_hash_detail, &wctx);
+		zebra_evpn_neigh_iterate(zevpn,
+					 zebra_evpn_print_dad_neigh_hash_detail,
+					 &wctx);
 	else
-		hash_iterate(zevpn->neigh_table,
-			     zebra_evpn_print_neigh_hash_detail, &wctx);
+		zebra_evpn_neigh_iterate(zevpn,
+					 zebra_evpn_print_neigh_hash_detail,
+					 &wctx);
 
 	if (json)
 		json_object_object_add(json, vni_str, json_evpn);
@@ -483,10 +485,10 @@ static void zevpn_print_mac_hash_all_evpn(struct hash_bucket *bucket, void *ctxt
 	 */
 	wctx->json = json_mac;
 	if (wctx->print_dup)
-		hash_iterate(zevpn->mac_table, zebra_evpn_print_dad_mac_hash,
-			     wctx);
+		zebra_evpn_mac_iterate(zevpn, zebra_evpn_print_dad_mac_hash,
+				       wctx);
 	else
-		hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash, wctx);
+		zebra_evpn_mac_iterate(zevpn, zebra_evpn_print_mac_hash, wctx);
 	wctx->json = json;
 	if (json) {
 		if (wctx->count)
@@ -549,11 +551,12 @@ static void zevpn_print_mac_hash_all_evpn_detail(struct hash_bucket *bucket,
 	 */
 	wctx->json = json_mac;
 	if (wctx->print_dup)
-		hash_iterate(zevpn->mac_table,
-			     zebra_evpn_print_dad_mac_hash_detail, wctx);
+		zebra_evpn_mac_iterate(zevpn,
+				       zebra_evpn_print_dad_mac_hash_detail,
+				       wctx);
 	else
-		hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash_detail,
-			     wctx);
+		zebra_evpn_mac_iterate(zevpn, zebra_evpn_print_mac_hash_detail,
+				       wctx);
 	wctx->json = json;
 	if (json) {
 		if (wctx->count)
@@ -1924,10 +1927,11 @@ static struct zebra_l3vni *zl3vni_add(vni_t vni, vrf_id_t vrf_id)
 	zl3vni->l2vnis->cmp = zebra_evpn_list_cmp;
 
 	/* Create hash table for remote RMAC */
-	zl3vni->rmac_table = zebra_mac_db_create("Zebra L3-VNI RMAC-Table");
+	zl3vni->rmac_table = zebra_mac_hash_create("Zebra L3-VNI RMAC-Table");
 
 	/* Create hash table for neighbors */
-	zl3vni->nh_table = zebra_neigh_db_create("Zebra L3-VNI next-hop table");
+	zl3vni->nh_table =
+		zebra_neigh_hash_create("Zebra L3-VNI next-hop table");
 
 	return zl3vni;
 }
@@ -2910,7 +2914,7 @@ void zebra_vxlan_print_neigh_vni(struct vty *vty, struct zebra_vrf *zvrf,
 			vty_out(vty, "%% VNI %u does not exist\n", vni);
 		return;
 	}
-	num_neigh = hashcount(zevpn->neigh_table);
+	num_neigh = zebra_neigh_db_count(&zevpn->neigh_table);
 	if (!num_neigh)
 		return;
 
@@ -2926,8 +2930,8 @@ void zebra_vxlan_print_neigh_vni(struct vty *vty, struct zebra_vrf *zvrf,
 	wctx.vty = vty;
 	wctx.addr_width = 15;
 	wctx.json = json;
-	hash_iterate(zevpn->neigh_table, zebra_evpn_find_neigh_addr_width,
-		     &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_find_neigh_addr_width,
+				 &wctx);
 
 	if (!use_json) {
 		vty_out(vty,
@@ -2937,7 +2941,7 @@ void zebra_vxlan_print_neigh_vni(struct vty *vty, struct zebra_vrf *zvrf,
 	} else
 		json_object_int_add(json, "numArpNd", num_neigh);
 
-	hash_iterate(zevpn->neigh_table, zebra_evpn_print_neigh_hash, &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_print_neigh_hash, &wctx);
 	if (use_json)
 		vty_json(vty, json);
 }
@@ -3058,7 +3062,7 @@ void zebra_vxlan_print_neigh_vni_vtep(struct vty *vty, struct zebra_vrf *zvrf,
 			vty_out(vty, "%% VNI %u does not exist\n", vni);
 		return;
 	}
-	num_neigh = hashcount(zevpn->neigh_table);
+	num_neigh = zebra_neigh_db_count(&zevpn->neigh_table);
 	if (!num_neigh)
 		return;
 
@@ -3072,9 +3076,9 @@ void zebra_vxlan_print_neigh_vni_vtep(struct vty *vty, struct zebra_vrf *zvrf,
 	wctx.flags = SHOW_REMOTE_NEIGH_FROM_VTEP;
 	wctx.r_vtep_ip = vtep_ip;
 	wctx.json = json;
-	hash_iterate(zevpn->neigh_table, zebra_evpn_find_neigh_addr_width,
-		     &wctx);
-	hash_iterate(zevpn->neigh_table, zebra_evpn_print_neigh_hash, &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_find_neigh_addr_width,
+				 &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_print_neigh_hash, &wctx);
 
 	if (use_json)
 		vty_json(vty, json);
@@ -3103,7 +3107,7 @@ void zebra_vxlan_print_neigh_vni_dad(struct vty *vty,
 		return;
 	}
 
-	num_neigh = hashcount(zevpn->neigh_table);
+	num_neigh = zebra_neigh_db_count(&zevpn->neigh_table);
 	if (!num_neigh)
 		return;
 
@@ -3123,8 +3127,8 @@ void zebra_vxlan_print_neigh_vni_dad(struct vty *vty,
 	wctx.vty = vty;
 	wctx.addr_width = 15;
 	wctx.json = json;
-	hash_iterate(zevpn->neigh_table, zebra_evpn_find_neigh_addr_width,
-		     &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_find_neigh_addr_width,
+				 &wctx);
 
 	if (!use_json) {
 		vty_out(vty,
@@ -3136,8 +3140,7 @@ void zebra_vxlan_print_neigh_vni_dad(struct vty *vty,
 	} else
 		json_object_int_add(json, "numArpNd", num_neigh);
 
-	hash_iterate(zevpn->neigh_table, zebra_evpn_print_dad_neigh_hash,
-		     &wctx);
+	zebra_evpn_neigh_iterate(zevpn, zebra_evpn_print_dad_neigh_hash, &wctx);
 
 	if (use_json)
 		vty_json(vty, json);
@@ -3197,11 +3200,10 @@ void zebra_vxlan_print_macs_vni(struct vty *vty, struct zebra_vrf *zvrf,
 		json_object_int_add(json, "numMacs", num_macs);
 
 	if (detail)
-		hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash_detail,
-			     &wctx);
+		zebra_evpn_mac_iterate(zevpn, zebra_evpn_print_mac_hash_detail,
+				       &wctx);
 	else
-		hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash,
-			     &wctx);
+		zebra_evpn_mac_iterate(zevpn, zebra_evpn_print_mac_hash, &wctx);
 
 	if (use_json) {
 		json_object_object_add(json, "macs", json_mac);
@@ -3380,7 +3382,7 @@ void zebra_vxlan_print_macs_vni_dad(struct vty *vty,
 	} else
 		json_object_int_add(json, "numMacs", num_macs);
 
-	hash_iterate(zevpn->mac_table, zebra_evpn_print_dad_mac_hash, &wctx);
+	zebra_evpn_mac_iterate(zevpn, zebra_evpn_print_dad_mac_hash, &wctx);
 
 	if (use_json) {
 		json_object_object_add(json, "macs", json_mac);
@@ -3544,18 +3546,13 @@ int zebra_vxlan_clear_dup_detect_vni_ip(struct zebra_vrf *zvrf, vni_t vni,
 	return 0;
 }
 
-static void zevpn_clear_dup_mac_hash(struct hash_bucket *bucket, void *ctxt)
+static void zevpn_clear_dup_mac_hash(struct zebra_mac *mac, void *ctxt)
 {
 	struct mac_walk_ctx *wctx = ctxt;
-	struct zebra_mac *mac;
 	struct zebra_evpn *zevpn;
 	struct listnode *node = NULL;
 	struct zebra_neigh *nbr = NULL;
 
-	mac = (struct zebra_mac *)bucket->data;
-	if (!mac)
-		return;
-
 	zevpn = wctx->zevpn;
 
 	if (!CHECK_FLAG(mac->flags, ZEBRA_MAC_DUPLICATE))
@@ -3614,19 +3611,20 @@ static void zevpn_clear_dup_detect_hash_vni_all(struct hash_bucket *bucket,
 
 	zvrf = (struct zebra_vrf *)args[0];
 
-	if (hashcount(zevpn->neigh_table)) {
+	if (zebra_neigh_db_count(&zevpn->neigh_table)) {
 		memset(&n_wctx, 0, sizeof(n_wctx));
 		n_wctx.zevpn = zevpn;
 		n_wctx.zvrf = zvrf;
-		hash_iterate(zevpn->neigh_table,
-			     zebra_evpn_clear_dup_neigh_hash, &n_wctx);
+		zebra_evpn_neigh_iterate(zevpn, zebra_evpn_clear_dup_neigh_hash,
+					 &n_wctx);
 	}
 
 	if (num_valid_macs(zevpn)) {
 		memset(&m_wctx, 0, sizeof(m_wctx));
 		m_wctx.zevpn = zevpn;
 		m_wctx.zvrf = zvrf;
-		hash_iterate(zevpn->mac_table, zevpn_clear_dup_mac_hash, &m_wctx);
+		zebra_evpn_mac_iterate(zevpn, zevpn_clear_dup_mac_hash,
+				       &m_wctx);
 	}
 
 }
@@ -3662,19 +3660,20 @@ int zebra_vxlan_clear_dup_detect_vni(struct zebra_vrf *zvrf, vni_t vni)
 		return CMD_WARNING;
 	}
 
-	if (hashcount(zevpn->neigh_table)) {
+	if (zebra_neigh_db_count(&zevpn->neigh_table)) {
 		memset(&n_wctx, 0, sizeof(n_wctx));
 		n_wctx.zevpn = zevpn;
 		n_wctx.zvrf = zvrf;
-		hash_iterate(zevpn->neigh_table,
-			     zebra_evpn_clear_dup_neigh_hash, &n_wctx);
+		zebra_evpn_neigh_iterate(zevpn, zebra_evpn_clear_dup_neigh_hash,
+					 &n_wctx);
 	}
 
 	if (num_valid_macs(zevpn)) {
 		memset(&m_wctx, 0, sizeof(m_wctx));
 		m_wctx.zevpn = zevpn;
 		m_wctx.zvrf = zvrf;
-		hash_iterate(zevpn->mac_table, zevpn_clear_dup_mac_hash, &m_wctx);
+		zebra_evpn_mac_iterate(zevpn, zevpn_clear_dup_mac_hash,
+				       &m_wctx);
 	}
 
 	return 0;
@@ -3718,7 +3717,7 @@ void zebra_vxlan_print_macs_vni_vtep(struct vty *vty, struct zebra_vrf *zvrf,
 	wctx.flags = SHOW_REMOTE_MAC_FROM_VTEP;
 	wctx.r_vtep_ip = vtep_ip;
 	wctx.json = json_mac;
-	hash_iterate(zevpn->mac_table, zebra_evpn_print_mac_hash, &wctx);
+	zebra_evpn_mac_iterate(zevpn, zebra_evpn_print_mac_hash, &wctx);
 
 	if (use_json) {
 		json_object_int_add(json, "numMacs", wctx.count);
@@ -4987,8 +4986,8 @@ int zebra_vxlan_svi_up(struct interface *ifp, struct interface *link_if)
 		/* Install any remote neighbors for this VNI. */
 		memset(&n_wctx, 0, sizeof(n_wctx));
 		n_wctx.zevpn = zevpn;
-		hash_iterate(zevpn->neigh_table, zebra_evpn_install_neigh_hash,
-			     &n_wctx);
+		zebra_evpn_neigh_iterate(zevpn, zebra_evpn_install_neigh_hash,
+					 &n_wctx);
 
 		/* Link the SVI from the access VLAN */
 		zebra_evpn_acc_bd_svi_set(ifp->info, link_if->info, true);
@@ -5710,7 +5709,7 @@ void zebra_vxlan_init(void)
 	zrouter.l3vni_table = hash_create(l3vni_hash_keymake, l3vni_hash_cmp,
 					  "Zebra VRF L3 VNI table");
 
-	svd_nh_table = zebra_neigh_db_create("Zebra SVD next-hop table");
+	svd_nh_table = zebra_neigh_hash_create("Zebra SVD next-hop table");
 
 	zrouter.evpn_vrf = NULL;
 	zebra_evpn_mh_init();
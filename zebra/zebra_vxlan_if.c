@@ -362,8 +362,9 @@ static int zebra_vxlan_if_update_vni(struct interface *ifp,
 
 			memset(&n_wctx, 0, sizeof(n_wctx));
 			n_wctx.zevpn = zevpn;
-			hash_iterate(zevpn->neigh_table,
-				     zebra_evpn_install_neigh_hash, &n_wctx);
+			zebra_evpn_neigh_iterate(zevpn,
+						 zebra_evpn_install_neigh_hash,
+						 &n_wctx);
 		}
 	}
 
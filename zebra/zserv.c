@@ -42,6 +42,7 @@
 #include "lib/frratomic.h"        /* for atomic_load_explicit, atomic_stor... */
 #include "lib/lib_errors.h"       /* for generic ferr ids */
 #include "lib/printfrr.h"         /* for string functions */
+#include "lib/shmring.h"          /* for shmring_remain, shmring_peek, ... */
 
 #include "zebra/debug.h"          /* for various debugging macros */
 #include "zebra/rib.h"            /* for rib_score_proto */
@@ -190,6 +191,7 @@ static void zserv_client_fail(struct zserv *client)
 
 	THREAD_OFF(client->t_read);
 	THREAD_OFF(client->t_write);
+	THREAD_OFF(client->t_ring);
 	zserv_event(client, ZSERV_HANDLE_CLIENT_FAIL);
 }
 
@@ -284,6 +286,144 @@ zwrite_fail:
 	zserv_client_fail(client);
 }
 
+static struct shmring *zserv_ring(struct zserv *client)
+{
+	return (struct shmring *)atomic_load_explicit(&client->ring,
+						      memory_order_acquire);
+}
+
+/*
+ * Read data from a client's shared memory ring.
+ *
+ * This task is scheduled by zserv_read() when the client rings the doorbell,
+ * after everything the client sent on the socket before. It works like
+ * zserv_read(), except that the ring only ever holds whole messages, which are
+ * copied straight into a stream of their own. The task reschedules itself
+ * until the ring is empty, and then asks the client to ring the doorbell for
+ * the next message.
+ *
+ * A malformed message means the client is broken and is handled by
+ * terminating the client.
+ */
+static void zserv_ring_read(struct thread *thread)
+{
+	struct zserv *client = THREAD_ARG(thread);
+	struct shmring *ring = zserv_ring(client);
+	struct stream_fifo *cache;
+	struct stream *msg;
+	struct zmsghdr hdr;
+	uint8_t buf[ZEBRA_HEADER_SIZE];
+	uint32_t p2p_orig, p2p;
+	size_t remain, length;
+
+	p2p_orig = atomic_load_explicit(&zrouter.packets_to_process,
+					memory_order_relaxed);
+	cache = stream_fifo_new();
+	p2p = p2p_orig;
+
+	while (p2p) {
+		remain = shmring_remain(ring);
+		if (!remain)
+			break;
+
+		if (remain < ZEBRA_HEADER_SIZE || remain > ring->size) {
+			flog_warn(EC_ZEBRA_CLIENT_IO_ERROR,
+				  "%s: ring %s of %s holds %zu bytes", __func__,
+				  ring->name, zebra_route_string(client->proto),
+				  remain);
+			goto zread_fail;
+		}
+
+		shmring_peek(ring, 0, buf, sizeof(buf));
+		length = (buf[0] << 8) | buf[1];
+		if (length < ZEBRA_HEADER_SIZE || length > ZEBRA_MAX_PACKET_SIZ
+		    || length > remain) {
+			flog_warn(EC_ZEBRA_CLIENT_IO_ERROR,
+				  "%s: ring %s of %s has message length %zu, %zu bytes left",
+				  __func__, ring->name,
+				  zebra_route_string(client->proto), length,
+				  remain);
+			goto zread_fail;
+		}
+
+		msg = stream_new(length);
+		shmring_peek(ring, 0, STREAM_DATA(msg), length);
+		stream_set_endp(msg, length);
+		shmring_consume(ring, length);
+
+		if (!zapi_parse_header(msg, &hdr)
+		    || hdr.marker != ZEBRA_HEADER_MARKER
+		    || hdr.version != ZSERV_VERSION) {
+			zserv_log_message("Message in ring has corrupt header",
+					  msg, NULL);
+			stream_free(msg);
+			goto zread_fail;
+		}
+
+		if (IS_ZEBRA_DEBUG_PACKET)
+			zlog_debug("zebra message[%s:%u:%u] comes from ring %s",
+				   zserv_command_string(hdr.command),
+				   hdr.vrf_id, hdr.length, ring->name);
+
+		stream_set_getp(msg, 0);
+		stream_fifo_push(cache, msg);
+		p2p--;
+	}
+
+	if (p2p < p2p_orig) {
+		uint64_t time_now = monotime(NULL);
+
+		/* update session statistics */
+		frr_with_mutex (&client->stats_mtx) {
+			client->last_read_time = time_now;
+			client->last_read_cmd = hdr.command;
+			client->ring_read_cnt += p2p_orig - p2p;
+		}
+
+		/* publish read packets on client's input queue */
+		frr_with_mutex (&client->ibuf_mtx) {
+			while (cache->head)
+				stream_fifo_push(client->ibuf_fifo,
+						 stream_fifo_pop(cache));
+		}
+
+		/* Schedule job to process those packets */
+		zserv_event(client, ZSERV_PROCESS_MESSAGES);
+	}
+
+	/* Out of budget, or more arrived before we went idle */
+	if (!p2p || !shmring_idle(ring))
+		thread_add_event(client->pthread->master, zserv_ring_read,
+				 client, 0, &client->t_ring);
+
+	stream_fifo_free(cache);
+	return;
+
+zread_fail:
+	stream_fifo_free(cache);
+	zserv_client_fail(client);
+}
+
+bool zserv_ring_attach(struct zserv *client, const char *name, size_t size)
+{
+	struct shmring *ring;
+
+	if (client->synchronous || zserv_ring(client))
+		return false;
+
+	ring = shmring_attach(name, size);
+	if (!ring)
+		return false;
+
+	if (IS_ZEBRA_DEBUG_EVENT)
+		zlog_debug("client %d sends through ring %s of %zu bytes",
+			   client->sock, name, size);
+
+	atomic_store_explicit(&client->ring, (uintptr_t)ring,
+			      memory_order_release);
+	return true;
+}
+
 /*
  * Read and process data from a client socket.
  *
@@ -405,6 +545,18 @@ static void zserv_read(struct thread *thread)
 			}
 		}
 
+		/* Only says there is something in the ring.  Everything the
+		 * client sent on the socket before has been read by now.
+		 */
+		if (hdr.command == ZEBRA_RING_DOORBELL) {
+			if (zserv_ring(client))
+				thread_add_event(client->pthread->master,
+						 zserv_ring_read, client, 0,
+						 &client->t_ring);
+			stream_reset(client->ibuf_work);
+			continue;
+		}
+
 		/* Debug packet information. */
 		if (IS_ZEBRA_DEBUG_PACKET)
 			zlog_debug("zebra message[%s:%u:%u] comes from socket [%d]",
@@ -619,6 +771,10 @@ static void zserv_client_free(struct zserv *client)
 		stream_fifo_free(client->obuf_fifo);
 	if (client->wb)
 		buffer_free(client->wb);
+	if (zserv_ring(client)) {
+		shmring_del(zserv_ring(client));
+		atomic_store_explicit(&client->ring, 0, memory_order_relaxed);
+	}
 
 	/* Free buffer mutexes */
 	pthread_mutex_destroy(&client->stats_mtx);
@@ -998,6 +1154,8 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 	char wbuf[ZEBRA_TIME_BUF], nhbuf[ZEBRA_TIME_BUF], mbuf[ZEBRA_TIME_BUF];
 	time_t connect_time, last_read_time, last_write_time;
 	uint32_t last_read_cmd, last_write_cmd;
+	uint64_t ring_read_cnt;
+	struct shmring *ring = zserv_ring(client);
 
 	vty_out(vty, "Client: %s", zebra_route_string(client->proto));
 	if (client->instance)
@@ -1016,6 +1174,7 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 
 		last_read_cmd = client->last_read_cmd;
 		last_write_cmd = client->last_write_cmd;
+		ring_read_cnt = client->ring_read_cnt;
 	}
 
 	vty_out(vty, "Connect Time: %s \n",
@@ -1047,6 +1206,10 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 	if (last_write_cmd)
 		vty_out(vty, "Last Sent Cmd: %s \n",
 			zserv_command_string(last_write_cmd));
+	if (ring)
+		vty_out(vty, "Ring: %zu bytes, %zu pending, %" PRIu64
+			" msgs read\n",
+			ring->size, shmring_remain(ring), ring_read_cnt);
 	vty_out(vty, "\n");
 
 	vty_out(vty, "Type        Add         Update      Del \n");
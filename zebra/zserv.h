@@ -23,6 +23,7 @@
 #include "lib/linklist.h"     /* for list */
 #include "lib/workqueue.h"    /* for work_queue */
 #include "lib/hook.h"         /* for DECLARE_HOOK, DECLARE_KOOH */
+#include "lib/frratomic.h"    /* for atomic_uintptr_t */
 /* clang-format on */
 
 #ifdef __cplusplus
@@ -108,6 +109,13 @@ struct zserv {
 	struct thread *t_read;
 	struct thread *t_write;
 
+	/* Shared memory ring the client sends through instead of the socket,
+	 * see zserv_ring_attach().  Set by the main pthread before the client
+	 * gets to use it, read from by the client pthread in t_ring.
+	 */
+	atomic_uintptr_t ring;
+	struct thread *t_ring;
+
 	/* Event for message processing, for the main pthread */
 	struct thread *t_process;
 
@@ -215,6 +223,8 @@ struct zserv {
 	uint64_t last_read_cmd;
 	/* command code of last message written */
 	uint64_t last_write_cmd;
+	/* number of messages read from the ring */
+	uint64_t ring_read_cnt;
 
 	/* END covered by stats_mtx */
 
@@ -291,6 +301,25 @@ extern int zserv_send_message(struct zserv *client, struct stream *msg);
  */
 extern int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo);
 
+/*
+ * Map the shared memory ring a client offered in its hello and start taking
+ * messages from it whenever the client rings the doorbell.
+ *
+ * Must be called from the main pthread, before the client is told the ring
+ * was accepted.
+ *
+ * client
+ *    the client offering the ring
+ *
+ * name, size
+ *    the ring's shared memory object and its data size
+ *
+ * Returns:
+ *    true if the client can send through the ring
+ */
+extern bool zserv_ring_attach(struct zserv *client, const char *name,
+			      size_t size);
+
 /*
  * Retrieve a client by its protocol and instance number.
  *